@@ -0,0 +1,156 @@
+/**
+******************************************************************************
+* @file    platform.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides all MICO Peripherals mapping table and platform specific functions.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#include "stdio.h"
+#include "string.h"
+
+#include "platform.h"
+#include "platform_config.h"
+#include "platform_peripheral.h"
+#include "PlatformLogging.h"
+#include "MicoPlatform.h"
+
+/******************************************************
+*               Variables Definitions
+******************************************************/
+
+const platform_gpio_t platform_gpio_pins[] =
+{
+  [MICO_SYS_LED]                      = { 0 },
+  [MICO_RF_LED]                       = { 1 },
+  [BOOT_SEL]                          = { 2 },
+  [MFG_SEL]                           = { 3 },
+  [EasyLink_BUTTON]                   = { 4 },
+  [MICO_GPIO_1]                       = { 5 },
+  [MICO_GPIO_2]                       = { 6 },
+  [MICO_GPIO_3]                       = { 7 },
+  [MICO_GPIO_4]                       = { 8 },
+};
+
+/* There is no ADC, PWM, SPI or I2C, the drivers return kUnsupportedErr */
+const platform_adc_t platform_adc_peripherals[1];
+const platform_pwm_t platform_pwm_peripherals[1];
+const platform_spi_t platform_spi_peripherals[1];
+const platform_i2c_t platform_i2c_peripherals[1];
+platform_spi_slave_driver_t platform_spi_slave_drivers[1];
+
+const platform_uart_t platform_uart_peripherals[] =
+{
+  [MICO_UART_1] =
+  {
+    .link_path                    = "/tmp/mico_uart1",
+  },
+  [MICO_UART_2] =
+  {
+    .link_path                    = "/tmp/mico_uart2",
+  },
+};
+platform_uart_driver_t platform_uart_drivers[MICO_UART_MAX];
+
+const platform_flash_t platform_flash_peripherals[] =
+{
+  [MICO_INTERNAL_FLASH] =
+  {
+    .flash_type                   = FLASH_TYPE_INTERNAL,
+    .flash_start_addr             = 0x08000000,
+    .flash_length                 = 0x100000,
+    .flash_sector_size            = 0x1000,
+    .image_path                   = "mico_flash.bin",
+  },
+};
+
+platform_flash_driver_t platform_flash_drivers[MICO_FLASH_MAX];
+
+/******************************************************
+*           Interrupt Handler Platform Mapping
+******************************************************/
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+void init_platform( void )
+{
+  MicoGpioInitialize( (mico_gpio_t)MICO_SYS_LED, OUTPUT_PUSH_PULL );
+  MicoGpioOutputLow( (mico_gpio_t)MICO_SYS_LED );
+  MicoGpioInitialize( (mico_gpio_t)MICO_RF_LED, OUTPUT_OPEN_DRAIN_NO_PULL );
+  MicoGpioOutputHigh( (mico_gpio_t)MICO_RF_LED );
+  MicoGpioInitialize( (mico_gpio_t)EasyLink_BUTTON, INPUT_PULL_UP );
+
+  /* The bootloader pulls these up on the target, no bootloader runs before the host process */
+  MicoGpioInitialize( (mico_gpio_t)BOOT_SEL, INPUT_PULL_UP );
+  MicoGpioInitialize( (mico_gpio_t)MFG_SEL, INPUT_PULL_UP );
+}
+
+void init_platform_bootloader( void )
+{
+  MicoGpioInitialize( (mico_gpio_t)MICO_SYS_LED, OUTPUT_PUSH_PULL );
+  MicoGpioOutputLow( (mico_gpio_t)MICO_SYS_LED );
+  MicoGpioInitialize( (mico_gpio_t)MICO_RF_LED, OUTPUT_OPEN_DRAIN_NO_PULL );
+  MicoGpioOutputHigh( (mico_gpio_t)MICO_RF_LED );
+  
+  MicoGpioInitialize((mico_gpio_t)BOOT_SEL, INPUT_PULL_UP);
+  MicoGpioInitialize((mico_gpio_t)MFG_SEL, INPUT_PULL_UP);
+}
+
+void MicoSysLed(bool onoff)
+{
+  if (onoff) {
+    MicoGpioOutputHigh( (mico_gpio_t)MICO_SYS_LED );
+  } else {
+    MicoGpioOutputLow( (mico_gpio_t)MICO_SYS_LED );
+  }
+}
+
+void MicoRfLed(bool onoff)
+{
+  if (onoff) {
+    MicoGpioOutputLow( (mico_gpio_t)MICO_RF_LED );
+  } else {
+    MicoGpioOutputHigh( (mico_gpio_t)MICO_RF_LED );
+  }
+}
+
+bool MicoShouldEnterMFGMode(void)
+{
+  if(MicoGpioInputGet((mico_gpio_t)BOOT_SEL)==false && MicoGpioInputGet((mico_gpio_t)MFG_SEL)==false)
+    return true;
+  else
+    return false;
+}
+
+bool MicoShouldEnterBootloader(void)
+{
+  if(MicoGpioInputGet((mico_gpio_t)BOOT_SEL)==false && MicoGpioInputGet((mico_gpio_t)MFG_SEL)==true)
+    return true;
+  else
+    return false;
+}
@@ -0,0 +1,100 @@
+/**
+******************************************************************************
+* @file    platform_config.h
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides common configuration for the Linux simulation board.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+#ifndef __PLATFORM_COMMON_CONFIG_H__
+#define __PLATFORM_COMMON_CONFIG_H__
+#pragma once
+
+/******************************************************
+*                      Macros
+******************************************************/
+
+/******************************************************
+*                    Constants
+******************************************************/
+
+#define HARDWARE_REVISION   "SIM"
+#define DEFAULT_NAME        "MICO Linux Simulator"
+#define MODEL               "Linux-Sim"
+#define Bootloader_REVISION "V 0.1"
+
+/* MICO RTOS tick rate in Hz */
+#define MICO_DEFAULT_TICK_RATE_HZ                   (1000) 
+
+/************************************************************************
+ * There is no watchdog on the host */
+#define MICO_DISABLE_WATCHDOG
+
+/************************************************************************
+ * Restore default and start easylink after press down EasyLink button for 3 seconds. */
+#define RestoreDefault_TimeOut                      (3000)
+
+/* Same partitions as the 1M byte STM32F2 boards, so images and parameters can be moved between them.
+   The last sector of the driver partition keeps the DNS cache */
+#define INTERNAL_FLASH_START_ADDRESS   (uint32_t)0x08000000
+#define INTERNAL_FLASH_END_ADDRESS     (uint32_t)0x080FFFFF
+#define INTERNAL_FLASH_SIZE            (INTERNAL_FLASH_END_ADDRESS - INTERNAL_FLASH_START_ADDRESS + 1)
+
+#define MICO_FLASH_FOR_APPLICATION  MICO_INTERNAL_FLASH
+#define APPLICATION_START_ADDRESS   (uint32_t)0x0800C000
+#define APPLICATION_END_ADDRESS     (uint32_t)0x0805FFFF
+#define APPLICATION_FLASH_SIZE      (APPLICATION_END_ADDRESS - APPLICATION_START_ADDRESS + 1)
+
+#define MICO_FLASH_FOR_UPDATE       MICO_INTERNAL_FLASH /* Optional */
+#define UPDATE_START_ADDRESS        (uint32_t)0x08060000  /* Optional */
+#define UPDATE_END_ADDRESS          (uint32_t)0x080BFFFF  /* Optional */
+#define UPDATE_FLASH_SIZE           (UPDATE_END_ADDRESS - UPDATE_START_ADDRESS + 1) /* 384k bytes, optional*/
+
+#define MICO_FLASH_FOR_BOOT         MICO_INTERNAL_FLASH
+#define BOOT_START_ADDRESS          (uint32_t)0x08000000 
+#define BOOT_END_ADDRESS            (uint32_t)0x08003FFF 
+#define BOOT_FLASH_SIZE             (BOOT_END_ADDRESS - BOOT_START_ADDRESS + 1)
+
+#define MICO_FLASH_FOR_DRIVER       MICO_INTERNAL_FLASH
+#define DRIVER_START_ADDRESS        (uint32_t)0x080C0000 
+#define DRIVER_END_ADDRESS          (uint32_t)0x080FEFFF 
+#define DRIVER_FLASH_SIZE           (DRIVER_END_ADDRESS - DRIVER_START_ADDRESS + 1)
+
+#define MICO_FLASH_FOR_PARA         MICO_INTERNAL_FLASH
+#define PARA_START_ADDRESS          (uint32_t)0x08004000 
+#define PARA_END_ADDRESS            (uint32_t)0x08007FFF
+#define PARA_FLASH_SIZE             (PARA_END_ADDRESS - PARA_START_ADDRESS + 1)  
+
+#define MICO_FLASH_FOR_EX_PARA      MICO_INTERNAL_FLASH
+#define EX_PARA_START_ADDRESS       (uint32_t)0x08008000 
+#define EX_PARA_END_ADDRESS         (uint32_t)0x0800BFFF
+#define EX_PARA_FLASH_SIZE          (EX_PARA_END_ADDRESS - EX_PARA_START_ADDRESS + 1)  
+
+#define MICO_FLASH_FOR_DNS_CACHE    MICO_INTERNAL_FLASH /* Optional */
+#define DNS_CACHE_START_ADDRESS     (uint32_t)0x080FF000  /* Optional */
+#define DNS_CACHE_END_ADDRESS       (uint32_t)0x080FFFFF  /* Optional */
+#define DNS_CACHE_FLASH_SIZE        (DNS_CACHE_END_ADDRESS - DNS_CACHE_START_ADDRESS + 1) /* 4k bytes, optional*/
+
+#endif
@@ -138,6 +138,11 @@ extern "C"
 #define EX_PARA_END_ADDRESS         (uint32_t)0x00001FFF
 #define EX_PARA_FLASH_SIZE          (EX_PARA_END_ADDRESS - EX_PARA_START_ADDRESS + 1)   /* 4k bytes*/
 
+#define MICO_FLASH_FOR_EX_PARA_BAK  MICO_SPI_FLASH  /* Optional */
+#define EX_PARA_BAK_START_ADDRESS   (uint32_t)0x000FF000 /* Optional */
+#define EX_PARA_BAK_END_ADDRESS     (uint32_t)0x000FFFFF /* Optional */
+#define EX_PARA_BAK_FLASH_SIZE      (EX_PARA_BAK_END_ADDRESS - EX_PARA_BAK_START_ADDRESS + 1) /* 4k bytes, optional*/
+
 /******************************************************
 *                   Enumerations
 ******************************************************/
@@ -46,11 +46,11 @@ extern OSStatus update(void);
 char menu[] =
 "\r\n"
 "MICO Bootloader for %s, HARDWARE_REVISION: %s\r\n"
-"0:BOOTUPDATE <-r>\r\n"
-"1:FWUPDATE <-r>\r\n"
-"2:DRIVERUPDATE <-r>\r\n"
-"3:PARAUPDATE <-r><-e>\r\n"
-"4:FLASHUPDATE  <-i><-s><-e><-r><-start><-end>\r\n"
+"0:BOOTUPDATE <-r><-g>\r\n"
+"1:FWUPDATE <-r><-g>\r\n"
+"2:DRIVERUPDATE <-r><-g>\r\n"
+"3:PARAUPDATE <-r><-e><-g>\r\n"
+"4:FLASHUPDATE  <-i><-s><-e><-r><-g><-start><-end>\r\n"
 "5:MEMORYMAP\r\n"
 "6:BOOT\r\n"
 "7:REBOOT\r\n";
@@ -59,11 +59,12 @@ char menu[] =
 "\r\n"
 "MICO Bootloader for %s, HARDWARE_REVISION: %s\r\n"
 "+ command -------------------------+ function ------------+\r\n"
-"| 0:BOOTUPDATE    <-r>             | Update bootloader    |\r\n"
-"| 1:FWUPDATE      <-r>             | Update application   |\r\n"
-"| 2:DRIVERUPDATE  <-r>             | Update RF driver     |\r\n"
-"| 3:PARAUPDATE    <-r><-e>         | Update MICO settings |\r\n"
+"| 0:BOOTUPDATE    <-r><-g>         | Update bootloader    |\r\n"
+"| 1:FWUPDATE      <-r><-g>         | Update application   |\r\n"
+"| 2:DRIVERUPDATE  <-r><-g>         | Update RF driver     |\r\n"
+"| 3:PARAUPDATE    <-r><-e><-g>     | Update MICO settings |\r\n"
 "| 4:FLASHUPDATE   <-i><-s><-e><-r> |                      |\r\n"
+"|    <-g>                          |                      |\r\n"
 "|    <-start address><-end address>| Update flash content |\r\n"
 "| 5:MEMORYMAP                      | List flash memory map|\r\n"
 "| 6:BOOT                           | Excute application   |\r\n"
@@ -72,6 +73,7 @@ char menu[] =
 "|    (C) COPYRIGHT 2014 MXCHIP Corporation  By William Xu |\r\n"
 " Notes:\r\n"
 " -e Erase only  -r Read from flash -i internal flash  -s SPI flash\r\n"
+" -g Receive with YMODEM-g, no ACKs, for links that never lose data\r\n"
 "  -start flash start address -end flash start address\r\n"
 " Example: Input \"4 -i -start 0x400 -end 0x800\": Update internal\r\n"
 "          flash from 0x400 to 0x800\r\n";
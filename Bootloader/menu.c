@@ -108,7 +108,7 @@ extern void getline (char *line, int n);          /* input line               */
 extern void startApplication(void);
 
 /* Private function prototypes -----------------------------------------------*/
-void SerialDownload(mico_flash_t flash, uint32_t flashdestination, int32_t maxRecvSize);
+void SerialDownload(mico_flash_t flash, uint32_t flashdestination, int32_t maxRecvSize, bool streaming);
 void SerialUpload(mico_flash_t flash, uint32_t flashdestination, char * fileName, int32_t maxRecvSize);
 
 /* Private functions ---------------------------------------------------------*/
@@ -166,16 +166,16 @@ exit:
 
 /**
   * @brief  Download a file via serial port
-  * @param  None
+  * @param  streaming: Use YMODEM-g
   * @retval None
   */
-void SerialDownload(mico_flash_t flash, uint32_t flashdestination, int32_t maxRecvSize)
+void SerialDownload(mico_flash_t flash, uint32_t flashdestination, int32_t maxRecvSize, bool streaming)
 {
   char Number[10] = "          ";
   int32_t Size = 0;
 
   printf("Waiting for the file to be sent ... (press 'a' to abort)\n\r");
-  Size = Ymodem_Receive(&tab_1024[0], flash, flashdestination, maxRecvSize);
+  Size = Ymodem_Receive(&tab_1024[0], flash, flashdestination, maxRecvSize, streaming);
   if (Size > 0)
   {
     printf("\n\n\r Programming Successfully!\n\r\r\n Name: ");
@@ -272,7 +272,7 @@ void Main_Menu(void)
         continue;
       }
       printf ("\n\rUpdating Bootloader...\n\r");
-      SerialDownload(MICO_FLASH_FOR_BOOT, BOOT_START_ADDRESS, BOOT_FLASH_SIZE);
+      SerialDownload(MICO_FLASH_FOR_BOOT, BOOT_START_ADDRESS, BOOT_FLASH_SIZE, findCommandPara(cmdbuf, "g", NULL, 0) != -1);
     }
 
     /***************** Command "1" or "FWUPDATE": Update the MICO application  *************************/
@@ -285,7 +285,7 @@ void Main_Menu(void)
         continue;
       }
       printf ("\n\rUpdating MICO application...\n\r");
-      SerialDownload(MICO_FLASH_FOR_APPLICATION, APPLICATION_START_ADDRESS, APPLICATION_FLASH_SIZE); 							   	
+      SerialDownload(MICO_FLASH_FOR_APPLICATION, APPLICATION_START_ADDRESS, APPLICATION_FLASH_SIZE, findCommandPara(cmdbuf, "g", NULL, 0) != -1); 							   	
     }
 
     /***************** Command "2" or "DRIVERUPDATE": Update the RF driver  *************************/
@@ -300,7 +300,7 @@ void Main_Menu(void)
         continue;
       }
       printf ("\n\rUpdating RF driver...\n\r");
-      SerialDownload(MICO_FLASH_FOR_DRIVER, DRIVER_START_ADDRESS, DRIVER_FLASH_SIZE);  
+      SerialDownload(MICO_FLASH_FOR_DRIVER, DRIVER_START_ADDRESS, DRIVER_FLASH_SIZE, findCommandPara(cmdbuf, "g", NULL, 0) != -1);  
 #else
       printf ("\n\rNo independ flash memory for RF driver, exiting...\n\r");
 #endif
@@ -323,7 +323,7 @@ void Main_Menu(void)
         continue;
       }
       printf ("\n\rUpdating MICO settings...\n\r");
-      SerialDownload(MICO_FLASH_FOR_PARA, PARA_START_ADDRESS, PARA_FLASH_SIZE);                        
+      SerialDownload(MICO_FLASH_FOR_PARA, PARA_START_ADDRESS, PARA_FLASH_SIZE, findCommandPara(cmdbuf, "g", NULL, 0) != -1);                        
     }
 
     /***************** Command "4" or "FLASHUPDATE": : Update the Flash  *************************/
@@ -396,7 +396,7 @@ void Main_Menu(void)
       }
 
       printf ("\n\rUpdating flash content From 0x%x to 0x%x\n\r", startAddress, endAddress);
-      SerialDownload((mico_flash_t)targetFlash, startAddress, endAddress-startAddress+1);                           
+      SerialDownload((mico_flash_t)targetFlash, startAddress, endAddress-startAddress+1, findCommandPara(cmdbuf, "g", NULL, 0) != -1);                           
     }
 
     /***************** Command: Reboot *************************/
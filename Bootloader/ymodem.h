@@ -59,6 +59,7 @@
 #define NAK                     (0x15)  /* negative acknowledge */
 #define CA                      (0x18)  /* two of these in succession aborts transfer */
 #define CRC16                   (0x43)  /* 'C' == 0x43, request 16-bit CRC */
+#define CRC16_G                 (0x47)  /* 'G' == 0x47, request 16-bit CRC and no ACKs (YMODEM-g) */
 
 #define ABORT1                  (0x41)  /* 'A' == 0x41, abort by user */
 #define ABORT2                  (0x61)  /* 'a' == 0x61, abort by user */
@@ -67,7 +68,7 @@
 #define MAX_ERRORS              (20)
 
 /* Exported functions ------------------------------------------------------- */
-int32_t Ymodem_Receive (uint8_t *buf, mico_flash_t flash, uint32_t flashdestination, int32_t maxRecvSize);
+int32_t Ymodem_Receive (uint8_t *buf, mico_flash_t flash, uint32_t flashdestination, int32_t maxRecvSize, bool streaming);
 uint8_t Ymodem_Transmit (mico_flash_t, uint32_t, const  uint8_t* , uint32_t );
 
 #endif  /* __YMODEM_H_ */
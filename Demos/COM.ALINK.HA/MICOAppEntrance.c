@@ -9,6 +9,7 @@
 #include "MicoPlatform.h"
 
 #include "haProtocol.h"
+#include "MICOConfigMenu.h"
 
 
 #define app_log(M, ...) custom_log("APP", M, ##__VA_ARGS__)
@@ -19,7 +20,7 @@ volatile uint8_t        rx_data[UART_BUFFER_LENGTH];
 
 extern bool             global_wifi_status;
 mico_semaphore_t        ota_sem;
-extern json_object* ConfigCreateReportJsonMessage( mico_Context_t * const inContext );
+extern OSStatus ConfigCreateReportJsonMessage( struct json_writer *writer, mico_Context_t * const inContext );
 extern void ota_thread(void *inContext);
 
 //static char hugebuf[128];
@@ -35,8 +36,8 @@ static void udpSearch_thread(void *inContext)
   struct sockaddr_t addr;
   socklen_t addrLen;
   //  Context = inContext;
-  json_object* report = NULL;
-  const char *  json_str;
+  struct json_writer writer;
+  int jSon_len = 0;
   char jSon_report[1024];
   
   udpSearch_fd = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
@@ -44,11 +45,10 @@ static void udpSearch_thread(void *inContext)
   addr.s_port = UDP_BROADCAST_PORT;
   bind(udpSearch_fd, &addr, sizeof(addr));
   
-  report = ConfigCreateReportJsonMessage( inContext );
-  json_str = json_object_to_json_string(report);
   memset(jSon_report, 0x00, 1024);
-  memcpy(jSon_report, json_str, strlen(json_str));
-  json_object_put(report);
+  json_writer_init(&writer, jSon_report, sizeof(jSon_report) - 1, MICOConfigReportLength, &jSon_len);
+  ConfigCreateReportJsonMessage( &writer, inContext );
+  json_writer_finish(&writer);
   
   while(1) {
     FD_ZERO(&readfds);
@@ -8,28 +8,30 @@
 #include "StringUtils.h"
 #include "HTTPUtils.h"
 #include "SocketUtils.h"
+#include "HTTPClientUtils.h"
+#include "SHAUtils.h"
 #include "alink_vendor_mico.h"
 
 #define ota_log(M, ...) custom_log("OTA", M, ##__VA_ARGS__)
 #define ota_log_trace() custom_log_trace("OTA")
 
 static uint8_t needOTA = 0;
-static char *httpRequest = NULL;
 static HTTPHeader_t *httpHeader = NULL;
-static int ota_fd = -1;
-char http_req[256], ota_file_name[64];
+static HTTPClient_t _otaClient;
+char ota_file_name[64];
 extern mico_semaphore_t      ota_sem;
 uint8_t md5_bin[16];
-static uint8_t bp_count = 0;
 
 #define OTA_SERVER "api.easylink.io"
 #define OTA_PORT 80
 
 #define kNoOTA                      -6774   //! Local firmware is newest, no need to OTA.
-#define kBreakPoint                 -6775   //! Need breakpoint resume
 
 #define OTA_MAX_RECONN_NUM       5
 
+#define OTA_VERSION_PATH         "/v1/rom/lastversion.json?product_id=%s"
+#define OTA_REQUEST_FIELDS       "Accept-Encoding: identity\r\n"
+
 //#define OTA_TEST
 
 #ifdef OTA_TEST
@@ -45,88 +47,6 @@ uint32_t get_writed_length(void)
   return flashStorageAddress-UPDATE_START_ADDRESS;
 }
 
-static int open_url(char *filename);
-
-const char http_head[]=
-{
-  "GET /v1/rom/lastversion.json?product_id=%s HTTP/1.1\r\n\
-Host: api.easylink.io\r\n\
-Connection: keep-alive\r\n\
-Accept-Encoding: identity\r\n\r\n"
-};
-
-const char http_head_bin[]=
-{
-  "GET %s HTTP/1.1\r\n\
-Host: api.easylink.io\r\n\
-Connection: keep-alive\r\n\
-Range: bytes=%d-\r\n\
-Accept-Encoding: identity\r\n\r\n"
-};
-
-OSStatus _connectOTAServer( mico_Context_t * const inContext, int *fd)
-{
-  ota_log_trace();
-  
-  OSStatus    err;
-  struct      sockaddr_t addr;
-  //  const char  *json_str;
-  //  char version[40];
-  char ipstr[16];
-  int recvtime = 1000;
-  //  json_object *j_get = json_object_new_object();
-  //  json_object *j_action = json_object_new_object();
-  //  json_object *j_data = json_object_new_object();
-  
-  //  size_t      httpRequestLen = 0;
-  err = gethostbyname(OTA_SERVER, (uint8_t *)ipstr, 16);
-  require_noerr(err, exit);
-  //  require_noerr(err, ReConnWithDelay);
-  //  mico_rtos_get_semaphore(&login_sem, MICO_WAIT_FOREVER);
-  *fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-  setsockopt(*fd, SOL_SOCKET, SO_RCVTIMEO, &recvtime, sizeof(recvtime));
-  addr.s_ip = inet_addr(ipstr);
-  addr.s_port = OTA_PORT;
-  err = connect(*fd, &addr, sizeof(addr));
-  require_noerr(err, exit);
-  
-  ota_log("Connect to OTA server success, fd: %d", *fd);
-  
-  //  snprintf(version, 40, "%s%03d", FIRMWARE_REVISION, FIRMWARE_REVISION_NUM);
-  //  json_object_object_add(j_data,"version",json_object_new_string(version));
-  //  json_object_object_add(j_data,"model",json_object_new_string(OTA_KEY));
-  //
-  //  json_object_object_add(j_get,"action",json_object_new_string("last_version"));
-  //  json_object_object_add(j_get,"data",j_data);
-  //
-  //  json_str = json_object_to_json_string(j_get);
-  //  require( json_str, exit );
-  //
-  //  ota_log("Send request object=%s", json_str);
-  //
-  //  err =  CreateHTTPMessage( "POST", "", kMIMEType_JSON, (uint8_t *)json_str, strlen(json_str), &httpRequest, &httpRequestLen );
-  //  require_noerr( err, exit );
-  //  require( httpRequest, exit );
-  //
-  //  json_object_put(j_get);
-  if(get_writed_length() > 0){
-    require_action(bp_count<10, exit, err = kTimeoutErr);
-    bp_count++;
-    open_url(ota_file_name);
-    SocketSend( *fd, (uint8_t *)http_req, strlen(http_req) );  
-  } else{
-    httpRequest = malloc(256);
-    sprintf(httpRequest, http_head, OTA_KEY);
-    err = SocketSend( *fd, (uint8_t *)httpRequest, strlen(httpRequest) );
-    ota_log("Request sent = %s", httpRequest);
-    free(httpRequest);
-    require_noerr( err, exit );
-  }
-  
-exit:
-  return err;
-}
-
 static int get_filename(char *url, int len)
 {
   unsigned char i;
@@ -187,14 +107,6 @@ static int get_filename(char *url, int len)
   return 1;
 }
 
-static int open_url(char *filename)
-{
-  memset(http_req, 0, sizeof(http_req));
-  snprintf(http_req, sizeof(http_req), http_head_bin, filename, get_writed_length());
-  ota_log("http req =%s", http_req);
-  return 1;
-}
-
 int hex2data(unsigned char *data, const unsigned char *hexstring, unsigned int len)
 {
   unsigned const char *pos = hexstring;
@@ -224,21 +136,21 @@ int hex2data(unsigned char *data, const unsigned char *hexstring, unsigned int l
 static int ota_finished(uint8_t *md5_recv, uint8_t *temp_buf, int temp_buf_len, void * inUserContext)
 {
     uint8_t md5_ret[16];
-    md5_context ctx;
+    HashContext ctx;
     int len;
     uint32_t offset = UPDATE_START_ADDRESS;
     mico_Context_t *context = (mico_Context_t *)inUserContext;
 
     ota_log("Receive OTA data done!");
-    InitMd5( &ctx );
+    Hash_Init( &ctx, kHashType_MD5 );
     while((len = flashStorageAddress - offset) > 0) {
         if (temp_buf_len < len) {
             len = temp_buf_len;
         }
         MicoFlashRead(MICO_FLASH_FOR_UPDATE, &offset, (uint8_t *)temp_buf, len);
-        Md5Update( &ctx, (uint8_t *)temp_buf, len);
+        Hash_Update( &ctx, temp_buf, len );
     }
-    Md5Final( &ctx, md5_ret );
+    Hash_Final( &ctx, md5_ret );
     
     if(memcmp(md5_ret, md5_recv, 16) != 0) {
         return kGeneralErr;
@@ -266,7 +178,7 @@ static OSStatus onReceivedData(struct _HTTPHeader_t * inHeader, uint32_t inPos,
   const char *    value;
   size_t          valueSize;
 
-  err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
+  err = HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueSize );
   if(err == kNoErr && strnicmpx( value, valueSize, kMIMEType_Stream ) == 0){
 #ifdef MICO_FLASH_FOR_UPDATE  
     err = MicoFlashWrite(MICO_FLASH_FOR_UPDATE, &flashStorageAddress, (uint8_t *)inData, inLen);
@@ -276,10 +188,8 @@ static OSStatus onReceivedData(struct _HTTPHeader_t * inHeader, uint32_t inPos,
     return kUnsupportedErr;
 #endif
   }
-  else if(inHeader->chunkedData == true){
-    ota_log("ChunkedData: %d, %d:", inPos, inLen);
-  }
   else{
+    // Anything else, the version json, is kept in extraDataPtr
     return kUnsupportedErr;
   }
 
@@ -320,27 +230,22 @@ OSStatus OTAIncommingJsonMessage( const char *input, mico_Context_t * const inCo
       strncpy(tempStr, json_object_get_string(val), 100);
       alink_string_to_standard(tempStr);
       get_filename(tempStr,strlen(json_object_get_string(val)));
-      open_url(ota_file_name);
     }else if(!strcmp(key, "error")){
       err = kGeneralErr;
       goto exit;
     }
   }
-  if(needOTA){
-    SocketSend( ota_fd, (uint8_t *)http_req, strlen(http_req) );
-  }
 exit:
   json_object_put(new_obj);
   return err;
 }
 
 
-OSStatus _OTARespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico_Context_t * const inContext)
+OSStatus _OTARespondInComingMessage(HTTPHeader_t* inHeader, mico_Context_t * const inContext)
 {
   OSStatus            err = kUnknownErr;
   const char *        value;
   size_t              valueSize;
-  char                *p_content;
   
   ota_log_trace();
   ota_log("Receive OTA statusCode %d\r\n", inHeader->statusCode);
@@ -352,47 +257,19 @@ OSStatus _OTARespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico_Context
 
   case kStatusOK:
     ota_log("OTA server respond status OK!");
-    err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
+    err = HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueSize );
     require_noerr(err, exit);
     if( strnicmpx( value, 16, kMIMEType_JSON ) == 0 ){
       ota_log("Receive JSON version data!");
-      p_content = strstr((char *)inHeader, "\r\n\r\n")+4;
-      require(p_content, exit);
-      p_content = strstr(p_content, "{");
-      require(p_content, exit);
-      err = OTAIncommingJsonMessage(p_content , inContext);
+      require_action(inHeader->extraDataPtr, exit, err = kMalformedErr);
+      err = OTAIncommingJsonMessage(inHeader->extraDataPtr, inContext);
       require_noerr(err, exit);
-    }else if(strnicmpx( value, 24, kMIMEType_Stream ) == 0){
-      err = ota_finished(md5_bin, (uint8_t*)inHeader->buf, sizeof(inHeader->buf), inContext);
-      if(err != kNoErr) {
-        ota_log("MD5 check error!");
-        MicoFlashFinalize(MICO_FLASH_FOR_UPDATE);
-        err = kGeneralErr;
-        goto exit;
-      }
     }else{
       return kUnsupportedDataErr;
     }
     err = kNoErr;
     goto exit;
     
-  case kStatusPartialContent:
-    ota_log("kStatusPartialContent!");
-    err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
-    require_noerr(err, exit);
-    if(strnicmpx( value, 24, kMIMEType_Stream ) == 0){
-      err = ota_finished(md5_bin, (uint8_t*)inHeader->buf, sizeof(inHeader->buf), inContext);
-      if(err != kNoErr) {
-        ota_log("MD5 check error!");
-        MicoFlashFinalize(MICO_FLASH_FOR_UPDATE);
-        err = kGeneralErr;
-        goto exit;
-      }
-    }
-    else{
-      return kUnsupportedDataErr;
-    }
-    break;
   case kStatusNotFound:
     err = kNoOTA;
     goto exit;
@@ -406,14 +283,33 @@ exit:
   
 }
 
+static OSStatus _OTADownloadFirmware(mico_Context_t * const inContext)
+{
+  OSStatus            err = kUnknownErr;
+
+  ota_log("Download %s from %d", ota_file_name, get_writed_length());
+  /* Resumes by itself from what is already written when the connection is lost */
+  err = HTTPClientDownload(&_otaClient, ota_file_name, get_writed_length(), 0, httpHeader);
+  require_noerr(err, exit);
+
+  err = ota_finished(md5_bin, (uint8_t*)httpHeader->buf, sizeof(httpHeader->buf), inContext);
+  if(err != kNoErr) {
+    ota_log("MD5 check error!");
+    MicoFlashFinalize(MICO_FLASH_FOR_UPDATE);
+    err = kGeneralErr;
+  }
+
+exit:
+  return err;
+}
+
 void ota_thread(void *inContext)
 {
   ota_log_trace();
   
   OSStatus err = kNoErr;
   mico_Context_t *context = inContext;
-  fd_set readfds;
-  struct timeval_t t;
+  char versionPath[80];
   int reConnCount = 0;
 
   flashStorageAddress = UPDATE_START_ADDRESS;
@@ -424,87 +320,37 @@ void ota_thread(void *inContext)
   require_action( httpHeader, threadexit, err = kNoMemoryErr );
   HTTPHeaderClear( httpHeader );
   
-  t.tv_sec = 100;
-  t.tv_usec = 0;
+  err = HTTPClientInit(&_otaClient, OTA_SERVER, OTA_PORT);
+  require_noerr(err, threadexit);
+  snprintf(versionPath, sizeof(versionPath), OTA_VERSION_PATH, OTA_KEY);
   
+  /* The version query and the firmware download share one keep-alive connection */
   while(1){
-    if(ota_fd == -1){
-      err = _connectOTAServer(inContext, &ota_fd);
-      if(err == kTimeoutErr)
-        goto threadexit;
-      else
-        require_noerr(err, Reconn);
-    }else{
-      FD_ZERO(&readfds);
-      FD_SET(ota_fd, &readfds);
-      
-      err = select(1, &readfds, NULL, NULL, &t);
-      
-      if(FD_ISSET(ota_fd, &readfds)){
-        err = SocketReadHTTPHeader( ota_fd, httpHeader );          
-        
-        switch ( err )
-        {
-        case kNoErr:
-          // Read the rest of the HTTP body if necessary
-          err = SocketReadHTTPBody( ota_fd, httpHeader );
-          if(err == kBreakPoint){
-            SocketClose(&ota_fd);
-            ota_fd = -1;
-            HTTPHeaderClear( httpHeader );
-            httpHeader = HTTPHeaderCreateWithCallback(onReceivedData, NULL, inContext);
-            require_action( httpHeader, threadexit, err = kNoMemoryErr );
-            msleep(500);
-            continue;
-          }else
-            require_noerr(err, Reconn);
-          PrintHTTPHeader(httpHeader);
-          // Call the HTTPServer owner back with the acquired HTTP header
-          err = _OTARespondInComingMessage( ota_fd, httpHeader, context );
-          require_noerr( err, threadexit );
-          // Reuse HTTPHeader
-          HTTPHeaderClear( httpHeader );
-          break;
-          
-        case EWOULDBLOCK:
-          // NO-OP, keep reading
-          break;
-          
-        case kNoSpaceErr:
-          ota_log("ERROR: Cannot fit HTTPHeader.");
-          goto threadexit;
-                    
-        case kConnectionErr:
-          // NOTE: kConnectionErr from SocketReadHTTPHeader means it's closed
-          ota_log("ERROR: Connection closed.");
-          goto threadexit;
-          
-        case kNoOTA:
-          goto threadexit;
-          
-        default:
-          ota_log("ERROR: HTTP Header parse internal error: %d", err);
-          goto threadexit;
-        }
-      }
-    }
-    continue;
-  Reconn:
-    HTTPHeaderClear( httpHeader );
-    SocketClose(&ota_fd);
+    err = HTTPClientSendRequest(&_otaClient, "GET", versionPath, OTA_REQUEST_FIELDS, NULL, 0);
+    if(err == kNoErr)
+      err = HTTPClientReadResponse(&_otaClient, httpHeader);
+    if(err == kNoErr)
+      break;
     require(reConnCount < OTA_MAX_RECONN_NUM, threadexit);
     reConnCount++;
-    sleep(3);
   }
   
-  /*Module is ignored by FTC server, */
+  PrintHTTPHeader(httpHeader);
+  err = _OTARespondInComingMessage( httpHeader, context );
+  require_noerr( err, threadexit );
+  require_quiet( needOTA, threadexit );
+  
+  err = _OTADownloadFirmware( context );
+  require_noerr( err, threadexit );
+  
 threadexit:
-  HTTPHeaderClear( httpHeader );
-  SocketClose(&ota_fd);
-  ota_fd = -1;
+  HTTPClientClose(&_otaClient);
+  if(httpHeader){
+    HTTPHeaderClear( httpHeader );
+    free(httpHeader);
+    httpHeader = NULL;
+  }
   mico_rtos_set_semaphore(&ota_sem);
   mico_rtos_delete_thread( NULL );
   return;
 }
-
-
@@ -48,138 +48,143 @@ security_session_t *HKSNewSecuritySession(void)
 {
   security_session_t *session;
   session = calloc(1, sizeof(security_session_t));
+  require(session, exit);
   session->established = false;
+  session->recvedDataLen = 0;
+  session->recvedDataBuffer = session->inputFrame + kHKFrameLengthSize;
+exit:
   return session;
 }
 
 int HKSecureSocketSend( int sockfd, void *buf, size_t len, security_session_t *session)
+{
+  hk_iovec_t iov;
+  iov.base = buf;
+  iov.len = len;
+  return HKSecureSocketSendv( sockfd, &iov, 1, session );
+}
+
+int HKSecureSocketSendv( int sockfd, const hk_iovec_t *iov, int iovcnt, security_session_t *session)
 {
   OSStatus       err = kNoErr;
-  uint8_t*       encryptedData = NULL;
+  uint8_t*       frameData = session->outputFrame + kHKFrameLengthSize;
+  size_t         frameDataLen = 0;
+  size_t         iovOffset = 0;
+  size_t         copyLen;
   uint64_t       encryptedDataLen;
 
-  if(session->established == false)
-    return SocketSend( sockfd, buf, len );
-
-  encryptedData = malloc(len + crypto_aead_chacha20poly1305_ABYTES + sizeof(uint16_t));
-  require_action(encryptedData, exit, err = kNoMemoryErr);
-  *(uint16_t *)encryptedData = len;
-  err =  crypto_aead_chacha20poly1305_encrypt(encryptedData + sizeof(uint16_t), &encryptedDataLen, (uint8_t *)buf, len,
-                                              (const uint8_t *)encryptedData, sizeof(uint16_t), 
-                                              NULL, (uint8_t *)(&session->outputSeqNo),
-                                              (const unsigned char *)session->OutputKey);
-  session->outputSeqNo++;
-  require_noerr_string(err, exit, "crypto_aead_chacha20poly1305_encrypt failed");
-  require_string(encryptedDataLen - crypto_aead_chacha20poly1305_ABYTES == len, exit, "encryptedDataLen is not properly set");
-
-  err = SocketSend( sockfd, encryptedData, encryptedDataLen + sizeof(uint16_t) );
-  require_noerr( err, exit );
+  if(session->established == false){
+    for(; iovcnt > 0; iov++, iovcnt--){
+      if(iov->len == 0) continue;
+      err = SocketSend( sockfd, iov->base, iov->len );
+      require_noerr( err, exit );
+    }
+    goto exit;
+  }
+
+  while(iovcnt > 0){
+    /* Gather plain text into the frame until it is full or nothing is left */
+    copyLen = min(iov->len - iovOffset, kHKFrameMaxPayloadLength - frameDataLen);
+    memcpy(frameData + frameDataLen, (const uint8_t *)iov->base + iovOffset, copyLen);
+    frameDataLen += copyLen;
+    iovOffset += copyLen;
+    if(iovOffset == iov->len){
+      iov++;
+      iovcnt--;
+      iovOffset = 0;
+    }
+
+    if(frameDataLen < kHKFrameMaxPayloadLength && iovcnt > 0)
+      continue;
+    if(frameDataLen == 0)
+      break;
+
+    /* Encrypt in place, the length field is the additional authenticated data */
+    *(uint16_t *)session->outputFrame = frameDataLen;
+    err =  crypto_aead_chacha20poly1305_encrypt(frameData, &encryptedDataLen, frameData, frameDataLen,
+                                                (const uint8_t *)session->outputFrame, kHKFrameLengthSize,
+                                                NULL, (uint8_t *)(&session->outputSeqNo),
+                                                (const unsigned char *)session->OutputKey);
+    session->outputSeqNo++;
+    require_noerr_string(err, exit, "crypto_aead_chacha20poly1305_encrypt failed");
+    require_action_string(encryptedDataLen - crypto_aead_chacha20poly1305_ABYTES == frameDataLen, exit, err = kSizeErr, "encryptedDataLen is not properly set");
+
+    err = SocketSend( sockfd, session->outputFrame, encryptedDataLen + kHKFrameLengthSize );
+    require_noerr( err, exit );
+    frameDataLen = 0;
+  }
 
-  exit:
-    if(encryptedData) free(encryptedData);
-    return err;
+exit:
+  return err;
 }
 
-int HKSecureRead(security_session_t *session, int sockfd, void *buf, size_t len)
+static OSStatus _HKSecureReadFull(int sockfd, uint8_t *buf, size_t len)
 {
   OSStatus    err = kNoErr;
-  uint16_t         packageLength;
-  ssize_t          length = 0;
-  size_t         recvLength = 0;
-  size_t         recvLengthTmp = 0;
-  uint8_t*       *encryptedData = NULL;
-
+  ssize_t     length;
+  size_t      recvLength = 0;
   fd_set      readfds;
-  int         returnLength = 0;
   int         selectResult;
   struct      timeval_t t;
-  t.tv_sec  =  20;
-  t.tv_usec =  0;
-
-  if(session->established == true){
-    if(session->recvedDataLen){
-      returnLength += min(len, session->recvedDataLen);
-      memcpy(buf, session->recvedDataBuffer, returnLength);
-      session->recvedDataLen -= returnLength;
-      if(session->recvedDataLen)
-        memmove(session->recvedDataBuffer, session->recvedDataBuffer+returnLength, session->recvedDataLen);
-      else{
-        free(session->recvedDataBuffer);
-        session->recvedDataBuffer = NULL;
-      }
-      goto exit;
-    }else{
-      while( recvLengthTmp < sizeof(uint16_t)){
-        FD_ZERO( &readfds );
-        FD_SET( sockfd, &readfds );
-        selectResult = select( sockfd + 1, &readfds, NULL, NULL, &t );
-        require(selectResult >= 1, exit);
-        length = read( sockfd, (uint8_t *)&packageLength + recvLengthTmp, sizeof(uint16_t) - recvLengthTmp);
-        if( length > 0 ) recvLengthTmp += length;
-        else { err = kConnectionErr; goto exit; }
-      }
-
-      recvLength = packageLength + crypto_aead_chacha20poly1305_ABYTES;
-      recvLengthTmp = 0;
-
-      encryptedData = malloc(recvLength);
-      require(encryptedData, exit);
-
-      while( recvLengthTmp < recvLength){
-        FD_ZERO( &readfds );
-        FD_SET( sockfd, &readfds );
-        selectResult = select( sockfd + 1, &readfds, NULL, NULL, &t );
-        require(selectResult >= 1, exit);
-
-        length = read( sockfd, encryptedData + recvLengthTmp, recvLength - recvLengthTmp );
-        if( length > 0 ) recvLengthTmp += length;
-        else { err = kConnectionErr; goto exit; }
-      }
-
-      session->recvedDataBuffer = malloc(packageLength);
-      require(session->recvedDataBuffer, exit);
 
+  while( recvLength < len ){
+    t.tv_sec  =  20;
+    t.tv_usec =  0;
+    FD_ZERO( &readfds );
+    FD_SET( sockfd, &readfds );
+    selectResult = select( sockfd + 1, &readfds, NULL, NULL, &t );
+    require_action( selectResult >= 1, exit, err = kTimeoutErr );
+    length = read( sockfd, buf + recvLength, len - recvLength );
+    require_action( length > 0, exit, err = kConnectionErr );
+    recvLength += length;
+  }
 
-      err =  crypto_aead_chacha20poly1305_decrypt(session->recvedDataBuffer, &session->recvedDataLen, NULL, 
-                                                     (const unsigned char *)encryptedData, recvLength, (uint8_t *)&packageLength, 2,  
-                                                     (uint8_t *)(&session->inputSeqNo), (const unsigned char *)session->InputKey);
+exit:
+  return err;
+}
 
-      session->inputSeqNo++;
+int HKSecureRead(security_session_t *session, int sockfd, void *buf, size_t len)
+{
+  OSStatus       err = kNoErr;
+  uint16_t       packageLength;
+  uint8_t*       frameData = session->inputFrame + kHKFrameLengthSize;
+  int            returnLength = 0;
 
-      require_noerr(err, exit);
-      require(session->recvedDataLen == recvLength - crypto_aead_chacha20poly1305_ABYTES, exit);
-
-      free(encryptedData);
-      encryptedData = NULL;
-
-      returnLength += min(len, session->recvedDataLen);
-      memcpy(buf, session->recvedDataBuffer, returnLength);
-      session->recvedDataLen -= returnLength;
-      if(session->recvedDataLen)
-        memmove(session->recvedDataBuffer, session->recvedDataBuffer+returnLength, session->recvedDataLen);
-      else{
-        free(session->recvedDataBuffer);
-        session->recvedDataBuffer = NULL;
-      }
+  if(session->established == false)
+    return read( sockfd, buf, len);
 
-      goto exit;
+  if(session->recvedDataLen == 0){
+    /* Receive and decrypt a whole frame in place, it is served from inputFrame until consumed */
+    err = _HKSecureReadFull( sockfd, session->inputFrame, kHKFrameLengthSize );
+    require_noerr( err, exit );
+    packageLength = *(uint16_t *)session->inputFrame;
+    require_action( packageLength <= kHKFrameMaxPayloadLength, exit, err = kMalformedErr );
+
+    err = _HKSecureReadFull( sockfd, frameData, packageLength + crypto_aead_chacha20poly1305_ABYTES );
+    require_noerr( err, exit );
+
+    err =  crypto_aead_chacha20poly1305_decrypt(frameData, &session->recvedDataLen, NULL,
+                                                (const unsigned char *)frameData, packageLength + crypto_aead_chacha20poly1305_ABYTES,
+                                                session->inputFrame, kHKFrameLengthSize,
+                                                (uint8_t *)(&session->inputSeqNo), (const unsigned char *)session->InputKey);
+    session->inputSeqNo++;
+    require_noerr( err, exit );
+    require_action( session->recvedDataLen == packageLength, exit, err = kSizeErr );
+    session->recvedDataBuffer = frameData;
+  }
 
-    }
+  returnLength = min(len, session->recvedDataLen);
+  memcpy(buf, session->recvedDataBuffer, returnLength);
+  session->recvedDataBuffer += returnLength;
+  session->recvedDataLen -= returnLength;
 
-    exit:
-      if(err == kNoErr)
-        return returnLength;
-      else{
-        if(encryptedData) free(encryptedData);
-        if(session->recvedDataBuffer) {
-          free(session->recvedDataBuffer);
-          session->recvedDataBuffer = NULL;
-        }
-        return 0;
-      }
+exit:
+  if(err != kNoErr){
+    session->recvedDataLen = 0;
+    session->recvedDataBuffer = frameData;
+    return 0;
   }
-  else
-    return read( sockfd, buf, len);
+  return returnLength;
 }
 
 
@@ -236,7 +241,7 @@ int HKSocketReadHTTPHeader( int inSock, HTTPHeader_t *inHeader, security_session
     inHeader->otaDataPtr = 0;
   }
   
-  err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
+  err = HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueSize );
   
   if(err == kNoErr && strnicmpx( value, valueSize, kMIMEType_MXCHIP_OTA ) == 0){
     hkhttp_utils_log("Receive OTA data!");        
@@ -280,7 +285,7 @@ int HKSocketReadHTTPBody  ( int inSock, HTTPHeader_t *inHeader, security_session
       require( selectResult >= 1, exit );      
     }
     
-    err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
+    err = HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueSize );
     require_noerr(err, exit);
     if( strnicmpx( value, valueSize, kMIMEType_MXCHIP_OTA ) == 0 ){
       inHeader->otaDataPtr = calloc(OTA_Data_Length_per_read, sizeof(uint8_t)); 
@@ -327,72 +332,66 @@ exit:
 OSStatus HKSendResponseMessage(int sockfd, int status, uint8_t *payload, int payloadLen, security_session_t *session )
 {
   OSStatus err;
-  uint8_t *httpResponse = NULL;
+  char httpResponse[kHTTPResponseHeaderMaxLen];
   size_t httpResponseLen = 0;
   const char *buffer = NULL;
   int bufferLen;
+  hk_iovec_t iov[2];
 
   buffer = (const char *)payload;
   bufferLen = payloadLen;
 
-  err = CreateHTTPRespondMessageNoCopy( status, kMIMEType_HAP_JSON, bufferLen, &httpResponse, &httpResponseLen );
+  httpResponseLen = HTTPResponseHeaderWrite( httpResponse, sizeof(httpResponse), status, bufferLen ? kMIMEType_HAP_JSON : NULL, bufferLen, false );
+  require_action( httpResponseLen, exit, err = kSizeErr );
 
+  iov[0].base = httpResponse;
+  iov[0].len = httpResponseLen;
+  iov[1].base = buffer;
+  iov[1].len = bufferLen;
+  err = HKSecureSocketSendv( sockfd, iov, 2, session );
   require_noerr( err, exit );
-  require( httpResponse, exit );
-
-  err = HKSecureSocketSend( sockfd, httpResponse, httpResponseLen, session );
-  require_noerr( err, exit );
-  if(bufferLen){
-    err = HKSecureSocketSend( sockfd, (uint8_t *)buffer, bufferLen, session );
-    require_noerr( err, exit ); 
-  }
 
 exit:
-  if(httpResponse) free(httpResponse);
   return err;
 }
 
 OSStatus HKSendNotifyMessage( int sockfd, uint8_t *payload, int payloadLen, security_session_t *session )
 {
   OSStatus err;
-  uint8_t *httpResponse = NULL;
+  char httpResponse[100];
   size_t httpResponseLen = 0;
   const char *buffer = NULL;
   int bufferLen;
+  hk_iovec_t iov[2];
   require_action( session->established == true, exit, err = kAuthenticationErr );
 
   buffer = (const char *)payload;
   bufferLen = payloadLen;
   
-  require( bufferLen >= 0, exit );
-  
-  err = kNoMemoryErr;
-  httpResponse = malloc( 200 );
-  require( httpResponse, exit );
+  require_action( bufferLen >= 0, exit, err = kParamErr );
   
   // Create HTTP Response
   if(bufferLen)
-    snprintf( (char *)httpResponse, 200, 
+    snprintf( httpResponse, sizeof(httpResponse), 
             "%s %d %s%s%s %s%s%s %d%s",
             "EVENT/1.0", 200, "OK", kCRLFNewLine, 
             "Content-Type:", kMIMEType_HAP_JSON, kCRLFNewLine,
             "Content-Length:", (int)payloadLen, kCRLFLineEnding );
   else
-    snprintf( (char *)httpResponse, 200, 
+    snprintf( httpResponse, sizeof(httpResponse), 
         "%s %d %s%s",
         "EVENT/1.0", 200, "OK", kCRLFLineEnding);
   
-  httpResponseLen = strlen( (char*)httpResponse );
+  httpResponseLen = strlen( httpResponse );
 
-  err = HKSecureSocketSend( sockfd, httpResponse, httpResponseLen, session );
+  iov[0].base = httpResponse;
+  iov[0].len = httpResponseLen;
+  iov[1].base = buffer;
+  iov[1].len = bufferLen;
+  err = HKSecureSocketSendv( sockfd, iov, 2, session );
   require_noerr( err, exit );
-  if(bufferLen){
-    err = HKSecureSocketSend( sockfd, (uint8_t *)buffer, bufferLen, session );
-    require_noerr( err, exit ); 
-  }
 
 exit:
-  if(httpResponse) free(httpResponse);
   return err;
 }
 
@@ -27,22 +27,39 @@
 #include "Common.h"
 
 #include "HTTPUtils.h"
+#include "MICOCrypto/crypto_aead_chacha20poly1305.h"
+
+/* A HAP secure frame: 2 bytes little-endian length (also the AAD), up to 1024
+   bytes of encrypted payload, and a 16 bytes Poly1305 tag. */
+#define kHKFrameLengthSize        sizeof(uint16_t)
+#define kHKFrameMaxPayloadLength  1024
+#define kHKFrameBufferLength      (kHKFrameLengthSize + kHKFrameMaxPayloadLength + crypto_aead_chacha20poly1305_ABYTES)
 
 typedef struct _security_session_t {
   bool          established;
   char          controllerIdentifier[64];
   uint8_t       OutputKey[32];
   uint8_t       InputKey[32];
-  uint64_t      recvedDataLen;
-  uint8_t*      recvedDataBuffer;
+  uint64_t      recvedDataLen;      //Decrypted bytes not read yet in inputFrame
+  uint8_t*      recvedDataBuffer;   //Read position in inputFrame
   uint64_t      outputSeqNo;
   uint64_t      inputSeqNo;
+  uint8_t       inputFrame[kHKFrameBufferLength];
+  uint8_t       outputFrame[kHKFrameBufferLength];
 } security_session_t;
 
+typedef struct _hk_iovec_t {
+  const void    *base;
+  size_t        len;
+} hk_iovec_t;
+
 security_session_t *HKSNewSecuritySession(void);
 
 int HKSecureSocketSend( int sockfd, void *buf, size_t len, security_session_t *session);
 
+/* Send several buffers as one stream, they are packed into as few secure frames as possible */
+int HKSecureSocketSendv( int sockfd, const hk_iovec_t *iov, int iovcnt, security_session_t *session);
+
 int HKSecureRead(security_session_t *session, int sockfd, void *buf, size_t len);
 
 int HKSocketReadHTTPHeader( int inSock, HTTPHeader_t *inHeader, security_session_t *session );
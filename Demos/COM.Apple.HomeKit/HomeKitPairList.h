@@ -23,7 +23,17 @@
 #include "platform_config.h"
 
 #define MaxControllerNameLen  64
-#define MAXPairNumber         (EX_PARA_FLASH_SIZE-64)/(MaxControllerNameLen+32+4)
+#define MAXLegacyPairNumber   (EX_PARA_FLASH_SIZE-64)/(MaxControllerNameLen+32+4)
+
+/*The pair list journal uses two flash areas in turn. The second one is the board's
+  EX_PARA_BAK partition, or the upper half of EX_PARA on boards without it*/
+#ifdef MICO_FLASH_FOR_EX_PARA_BAK
+#define PairListAreaSize      ((EX_PARA_FLASH_SIZE < EX_PARA_BAK_FLASH_SIZE)? EX_PARA_FLASH_SIZE : EX_PARA_BAK_FLASH_SIZE)
+#else
+#define PairListAreaSize      (EX_PARA_FLASH_SIZE/2)
+#endif
+/*An area holds a header (magic and generation) and one insert record per pair*/
+#define MAXPairNumber         ((PairListAreaSize-8)/(sizeof(uint32_t)+sizeof(_pair_t)))
 /*Pair Info flash content*/
 typedef struct _pair_t {
   char             controllerName[MaxControllerNameLen];
@@ -31,14 +41,20 @@ typedef struct _pair_t {
   int              permission;
 } _pair_t;
 
+/*Legacy pair list flash content, converted to the journal format on first boot*/
 typedef struct _pair_list_in_flash_t {
-  _pair_t          pairInfo[MAXPairNumber];
+  _pair_t          pairInfo[MAXLegacyPairNumber];
 } pair_list_in_flash_t;
 
+/*Pair list is cached in RAM, changes are written to a flash journal later*/
+#define PairListFlushDelay    1000   //ms, delay between an update and its flash write
+#define PairListFlushStackSize 0x400 //The flush thread writes the journal, the timer only wakes it
 
+OSStatus HMPairListInit(void);
 OSStatus HMClearPairList(void);
-OSStatus HMReadPairList(pair_list_in_flash_t *pPairList);
-OSStatus HMUpdatePairList(pair_list_in_flash_t *pPairList);
+OSStatus HMFlushPairList(void);
+uint32_t HMGetPairNumber(void);
+uint32_t HMCopyPairList(_pair_t *pPairs, uint32_t maxNumber);
 OSStatus HKInsertPairInfo(char controllerIdentifier[64], uint8_t controllerLTPK[32], bool admin);
 uint8_t * HMFindLTPK(char * name);
 bool HMFindAdmin(char * name);
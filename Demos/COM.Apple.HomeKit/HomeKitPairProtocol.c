@@ -18,6 +18,7 @@
 #include "SHAUtils/sha.h"
 #include "HomeKitPairProtocol.h"
 #include "SHAUtils.h"
+#include "MICOCryptoWorker.h"
 
 #define pair_log(M, ...) custom_log("HomeKitPair", M, ##__VA_ARGS__)
 #define pair_log_trace() custom_log_trace("HomeKitPair")
@@ -67,11 +68,20 @@ const char * hkdfC2AInfo =           "Control-Write-Encryption-Key";
 const char * hkdfA2CKeySalt =        "Control-Salt";
 const char * hkdfA2CInfo =           "Control-Read-Encryption-Key";
 
+const char * hkdfResumeIDSalt =      "Pair-Verify-ResumeSessionID-Salt";
+const char * hkdfResumeIDInfo =      "Pair-Verify-ResumeSessionID-Info";
+
+const char * hkdfResumeRequestInfo =  "Pair-Resume-Request-Info";
+const char * hkdfResumeRespondInfo =  "Pair-Resume-Response-Info";
+const char * hkdfResumeSecretInfo =   "Pair-Resume-Shared-Secret-Info";
+
 const char * AEAD_Nonce_Setup04 =   "PS-Msg04";
 const char * AEAD_Nonce_Setup05 =   "PS-Msg05";
 const char * AEAD_Nonce_Setup06 =   "PS-Msg06";
 const char * AEAD_Nonce_Verify02 =  "PV-Msg02";
 const char * AEAD_Nonce_Verify03 =  "PV-Msg03";
+const char * AEAD_Nonce_Resume01 =  "PR-Msg01";
+const char * AEAD_Nonce_Resume02 =  "PR-Msg02";
 
 const char *stateDescription[7] = {"", "kTLVType_State = M1", "kTLVType_State = M2", "kTLVType_State = M3",
                                    "kTLVType_State = M4", "kTLVType_State = M5", "kTLVType_State = M6"};
@@ -87,6 +97,27 @@ static size_t         _len_verifier = 0;
 static const uint8_t  *_salt = NULL;
 static size_t         _len_salt = 0;
 
+/* Verifier and salt were derived from _password by HKSetPassword and belong to us */
+static bool           _verifierAllocated = false;
+
+/* Held while the SRP setup job reads the password, verifier and salt, and while
+   HKSetPassword or HKSetVerifier swaps them. Created by the first of those two */
+static mico_mutex_t   _verifierMutex = NULL;
+
+#define kPairResumeSessionIDLen   8
+
+typedef struct _pair_resume_entry_t {
+  bool             used;
+  uint32_t         lastUsed;
+  uint8_t          sessionID[kPairResumeSessionIDLen];
+  uint8_t          sharedSecret[32];
+  char             controllerIdentifier[MaxControllerNameLen+1];
+} pair_resume_entry_t;
+
+static bool                 _pairResumeInited = false;
+static mico_mutex_t         _pairResumeMutex = NULL;
+static pair_resume_entry_t  _pairResumeCache[PairResumeCacheSize];
+
 static HAPairSetupState_t haPairSetupState = eState_M1_SRPStartRequest;
 const char* hkSRPUser = "Pair-Setup";
 
@@ -101,20 +132,166 @@ OSStatus _HandleState_WaitingForVerifyStartRequest( HTTPHeader_t* inHeader, pair
 OSStatus _HandleState_WaitingForVerifyStartRespond(int inFd, pairVerifyInfo_t* inInfo, mico_Context_t * const inContext);
 OSStatus _HandleState_WaitingForVerifyFinishRequest(HTTPHeader_t* inHeader, pairVerifyInfo_t* inInfo, mico_Context_t * const inContext );
 OSStatus _HandleState_WaitingForVerifyFinishRespond(int inFd, pairVerifyInfo_t* inInfo, mico_Context_t * const inContext);
+OSStatus _HandleState_HandleResumeRespond(int inFd, pairVerifyInfo_t* inInfo, mico_Context_t * const inContext);
+
+/* Handshake crypto runs on the crypto worker, below the priority of the threads
+   serving accessory data. Pair verify jobs go before pair setup jobs */
+typedef struct _curve25519_job_t {
+  unsigned char         *outKey;
+  const unsigned char   *inSecret;
+  const unsigned char   *inBasePoint;
+} curve25519_job_t;
+
+typedef struct _sign_job_t {
+  unsigned char         *sm;
+  unsigned long long    *smlen;
+  const unsigned char   *m;
+  unsigned long long    len;      //Length of m to sign, or of sm to open
+  const unsigned char   *key;
+} sign_job_t;
+
+static OSStatus _HKCurve25519Job( void* arg )
+{
+  curve25519_job_t *job = arg;
+  curve25519_donna( job->outKey, job->inSecret, job->inBasePoint );
+  return kNoErr;
+}
+
+static OSStatus _HKSignJob( void* arg )
+{
+  sign_job_t *job = arg;
+  return crypto_sign( job->sm, job->smlen, job->m, job->len, job->key );
+}
+
+static OSStatus _HKSignOpenJob( void* arg )
+{
+  sign_job_t *job = arg;
+  return crypto_sign_open( NULL, NULL, job->sm, job->len, job->key );
+}
+
+static OSStatus _HKSRPSetupJob( void* arg )
+{
+  pairInfo_t *info = arg;
+
+  if(_verifierMutex == NULL)
+    return kNotPreparedErr;
+
+  /* Only B is computed here when the verifier is ready. The server keeps copies */
+  mico_rtos_lock_mutex(&_verifierMutex);
+  info->SRPServer = srp_server_setup( SRP_SHA512, SRP_NG_3072, info->SRPUser, 
+                                      _verifier? NULL : _password, _verifier? 0 : _len_password, 
+                                      _verifier, _len_verifier,
+                                      _salt, _len_salt,
+                                      0, 0);
+  mico_rtos_unlock_mutex(&_verifierMutex);
+  return info->SRPServer? kNoErr : kNoMemoryErr;
+}
+
+static OSStatus _HKSRPSessionKeyJob( void* arg )
+{
+  pairInfo_t *info = arg;
+  return srp_server_generate_session_key( info->SRPServer, info->SRPControllerPublicKey, info->SRPControllerPublicKeyLen );
+}
 
+static void _HKCurve25519( unsigned char *outKey, const unsigned char *inSecret, const unsigned char *inBasePoint )
+{
+  curve25519_job_t job = { outKey, inSecret, inBasePoint };
+  MICORunCryptoJob( _HKCurve25519Job, &job, CryptoJobPriorityHigh );
+}
+
+static OSStatus _HKSign( unsigned char *sm, unsigned long long *smlen, const unsigned char *m, unsigned long long mlen,
+                         const unsigned char *sk, mico_crypto_job_priority_t priority )
+{
+  sign_job_t job = { sm, smlen, m, mlen, sk };
+  return MICORunCryptoJob( _HKSignJob, &job, priority );
+}
+
+static OSStatus _HKSignOpen( unsigned char *sm, unsigned long long smlen, const unsigned char *pk, mico_crypto_job_priority_t priority )
+{
+  sign_job_t job = { sm, NULL, NULL, smlen, pk };
+  return MICORunCryptoJob( _HKSignOpenJob, &job, priority );
+}
+
+
+static OSStatus _HKVerifierLock(void)
+{
+  OSStatus err = kNoErr;
+
+  if(_verifierMutex == NULL)
+    err = mico_rtos_init_mutex(&_verifierMutex);
+  if(err == kNoErr)
+    mico_rtos_lock_mutex(&_verifierMutex);
+  return err;
+}
+
+/* Called with _verifierMutex held */
+static void _HKFreeVerifier(void)
+{
+  if(_verifierAllocated == true){
+    free((void *)_verifier);
+    free((void *)_salt);
+    _verifierAllocated = false;
+  }
+  _verifier = NULL;
+  _len_verifier = 0;
+  _salt = NULL;
+  _len_salt = 0;
+}
 
 void HKSetPassword (const uint8_t * password, const size_t passwordLen)
 {
+  const unsigned char *bytes_s = NULL, *bytes_v = NULL, *bytes_B = NULL, *bytes_b = NULL;
+  int len_s = 0, len_v = 0, len_B = 0, len_b = 0;
+
+  /* The verifier only depends on the setup code and a random salt, derive it once
+     here instead of on every pair setup. If it fails, pair setup falls back to
+     deriving it from _password each time. It takes a while, so it is derived
+     before the lock and only the swap is done under it */
+  srp_create_salted_verification_key( SRP_SHA512, SRP_NG_3072, hkSRPUser,
+                                      password, passwordLen,
+                                      &bytes_s, &len_s, &bytes_v, &len_v,
+                                      &bytes_B, &len_B, &bytes_b, &len_b,
+                                      0, 0);
+  if(bytes_B) free((void *)bytes_B);
+  if(bytes_b) free((void *)bytes_b);
+  if(bytes_s == NULL || bytes_v == NULL){
+    pair_log("Create SRP verifier failed");
+    if(bytes_s) free((void *)bytes_s);
+    if(bytes_v) free((void *)bytes_v);
+    bytes_s = bytes_v = NULL;
+  }
+
+  if(_HKVerifierLock() != kNoErr){
+    pair_log("Create verifier mutex failed");
+    if(bytes_s) free((void *)bytes_s);
+    if(bytes_v) free((void *)bytes_v);
+    return;
+  }
+  _HKFreeVerifier();
   _password = password;
   _len_password = passwordLen;
+  if(bytes_v){
+    _verifier = bytes_v;
+    _len_verifier = len_v;
+    _salt = bytes_s;
+    _len_salt = len_s;
+    _verifierAllocated = true;
+  }
+  mico_rtos_unlock_mutex(&_verifierMutex);
 }
 
 void HKSetVerifier (const uint8_t * verifier, const size_t verifierLen, const uint8_t * salt, const size_t saltLen )
 {
+  if(_HKVerifierLock() != kNoErr){
+    pair_log("Create verifier mutex failed");
+    return;
+  }
+  _HKFreeVerifier();
   _verifier = verifier;
   _len_verifier = verifierLen;
   _salt = salt;
   _len_salt = saltLen;
+  mico_rtos_unlock_mutex(&_verifierMutex);
 }
 
 
@@ -161,6 +338,199 @@ void HKCleanPairVerifyInfo(pairVerifyInfo_t **verifyInfo){
   }
 }
 
+static uint32_t _HKPairResumeAge(const pair_resume_entry_t *entry, uint32_t now)
+{
+  /* Free and expired entries are older than any other */
+  if(entry->used == false || now - entry->lastUsed > PairResumeLifetime)
+    return 0xFFFFFFFF;
+  return now - entry->lastUsed;
+}
+
+/* One entry per controller, a new controller replaces the least recently used entry */
+static void _HKPairResumeStore(const uint8_t *sessionID, const uint8_t *sharedSecret, const char *controllerIdentifier)
+{
+  pair_resume_entry_t *entry = NULL;
+  uint32_t now = mico_get_time();
+  int i;
+
+  if(_pairResumeInited == false || controllerIdentifier == NULL)
+    return;
+
+  mico_rtos_lock_mutex(&_pairResumeMutex);
+  for(i = 0; i < PairResumeCacheSize; i++){
+    if(_pairResumeCache[i].used == true &&
+       strncmp(_pairResumeCache[i].controllerIdentifier, controllerIdentifier, MaxControllerNameLen) == 0){
+      entry = &_pairResumeCache[i];
+      break;
+    }
+    if(entry == NULL || _HKPairResumeAge(&_pairResumeCache[i], now) > _HKPairResumeAge(entry, now))
+      entry = &_pairResumeCache[i];
+  }
+  entry->used = true;
+  entry->lastUsed = now;
+  memcpy(entry->sessionID, sessionID, kPairResumeSessionIDLen);
+  memcpy(entry->sharedSecret, sharedSecret, 32);
+  strncpy(entry->controllerIdentifier, controllerIdentifier, MaxControllerNameLen);
+  entry->controllerIdentifier[MaxControllerNameLen] = 0x0;
+  mico_rtos_unlock_mutex(&_pairResumeMutex);
+}
+
+/* Called with the cache mutex held */
+static pair_resume_entry_t *_HKPairResumeLookup(const uint8_t *sessionID)
+{
+  uint32_t now = mico_get_time();
+  int i;
+
+  for(i = 0; i < PairResumeCacheSize; i++){
+    if(_HKPairResumeAge(&_pairResumeCache[i], now) != 0xFFFFFFFF &&
+       memcmp(_pairResumeCache[i].sessionID, sessionID, kPairResumeSessionIDLen) == 0)
+      return &_pairResumeCache[i];
+  }
+  return NULL;
+}
+
+/* Copy the cached session, it stays in the cache until the resume request is verified */
+static bool _HKPairResumeFind(const uint8_t *sessionID, uint8_t *sharedSecret, char *controllerIdentifier)
+{
+  pair_resume_entry_t *entry;
+
+  if(_pairResumeInited == false)
+    return false;
+
+  mico_rtos_lock_mutex(&_pairResumeMutex);
+  entry = _HKPairResumeLookup(sessionID);
+  if(entry){
+    memcpy(sharedSecret, entry->sharedSecret, 32);
+    strcpy(controllerIdentifier, entry->controllerIdentifier);
+  }
+  mico_rtos_unlock_mutex(&_pairResumeMutex);
+  return entry != NULL;
+}
+
+/* A session is resumed only once, the resumed session is stored again under a new ID.
+   Returns false if another request has resumed it in the meantime */
+static bool _HKPairResumeConsume(const uint8_t *sessionID)
+{
+  pair_resume_entry_t *entry;
+
+  if(_pairResumeInited == false)
+    return false;
+
+  mico_rtos_lock_mutex(&_pairResumeMutex);
+  entry = _HKPairResumeLookup(sessionID);
+  if(entry)
+    memset(entry, 0x0, sizeof(pair_resume_entry_t));
+  mico_rtos_unlock_mutex(&_pairResumeMutex);
+  return entry != NULL;
+}
+
+OSStatus HKPairResumeInit(void)
+{
+  OSStatus err = kNoErr;
+
+  if(_pairResumeInited == true)
+    return kNoErr;
+
+  err = mico_rtos_init_mutex(&_pairResumeMutex);
+  require_noerr(err, exit);
+  memset(_pairResumeCache, 0x0, sizeof(_pairResumeCache));
+  _pairResumeInited = true;
+
+exit:
+  return err;
+}
+
+void HKPairResumeRemove(char * controllerIdentifier)
+{
+  int i;
+
+  if(_pairResumeInited == false)
+    return;
+
+  mico_rtos_lock_mutex(&_pairResumeMutex);
+  for(i = 0; i < PairResumeCacheSize; i++){
+    if(_pairResumeCache[i].used == true &&
+       strncmp(_pairResumeCache[i].controllerIdentifier, controllerIdentifier, MaxControllerNameLen) == 0)
+      memset(&_pairResumeCache[i], 0x0, sizeof(pair_resume_entry_t));
+  }
+  mico_rtos_unlock_mutex(&_pairResumeMutex);
+}
+
+/* Check a resume request against the cache. On success the verify info holds the
+   cached secret and the controller, otherwise pair verify goes on with a new key exchange */
+static OSStatus _HKPairResumeCheck(pairVerifyInfo_t* inInfo, const uint8_t *sessionID, const uint8_t *authTag, size_t authTagLen)
+{
+  OSStatus            err = kNoErr;
+  uint8_t             sharedSecret[32];
+  char                controllerIdentifier[MaxControllerNameLen+1];
+  uint8_t             salt[32+kPairResumeSessionIDLen];
+  uint8_t             key[32];
+  uint8_t             plain[1];
+  unsigned long long  plainLen = 0;
+
+  require_action(inInfo->pControllerCurve25519PK, exit, err = kParamErr);
+  require_action(authTagLen == crypto_aead_chacha20poly1305_ABYTES, exit, err = kSizeErr);
+  require_action(_HKPairResumeFind(sessionID, sharedSecret, controllerIdentifier) == true, exit, err = kNotFoundErr);
+  /* The pairing may have been removed after the session was cached */
+  require_action(HMFindLTPK(controllerIdentifier), exit, err = kNotFoundErr);
+
+  memcpy(salt,    inInfo->pControllerCurve25519PK, 32);
+  memcpy(salt+32, sessionID,                       kPairResumeSessionIDLen);
+  err = hkdf(SHA512,  salt, sizeof(salt), sharedSecret, 32,
+                      (const unsigned char *)hkdfResumeRequestInfo, strlen(hkdfResumeRequestInfo), key, 32);
+  require_noerr(err, exit);
+
+  err =  crypto_aead_chacha20poly1305_decrypt(plain, &plainLen, NULL, authTag, authTagLen, NULL, 0,
+                                              (const unsigned char *)AEAD_Nonce_Resume01, key);
+  require_noerr(err, exit);
+  /* A forged request must not evict the session of the real controller */
+  require_action(_HKPairResumeConsume(sessionID) == true, exit, err = kNotFoundErr);
+
+  inInfo->pSharedSecret = malloc(32);
+  require_action(inInfo->pSharedSecret, exit, err = kNoMemoryErr);
+  memcpy(inInfo->pSharedSecret, sharedSecret, 32);
+  inInfo->pControllerIdentifier = malloc(strlen(controllerIdentifier)+1);
+  require_action(inInfo->pControllerIdentifier, exit, err = kNoMemoryErr);
+  strcpy(inInfo->pControllerIdentifier, controllerIdentifier);
+  inInfo->resumed = true;
+
+exit:
+  if(err != kNoErr){
+    pair_log("Pair resume failed, err = %d, start a new pair verify", err);
+    if(inInfo->pSharedSecret) free(inInfo->pSharedSecret);
+    inInfo->pSharedSecret = NULL;
+  }
+  memset(sharedSecret, 0x0, sizeof(sharedSecret));
+  memset(key, 0x0, sizeof(key));
+  return err;
+}
+
+/* Session keys for the controller, the session is cached to be resumed by sessionID */
+static OSStatus _HKPairVerifyEstablish(pairVerifyInfo_t* inInfo, const uint8_t *sessionID)
+{
+  OSStatus err = kNoErr;
+
+  inInfo->A2CKey = malloc(32);
+  require_action(inInfo->A2CKey, exit, err = kNoMemoryErr);
+  err = hkdf(SHA512,  (const unsigned char *) hkdfA2CKeySalt, strlen(hkdfA2CKeySalt),
+                            inInfo->pSharedSecret, 32,
+                            (const unsigned char *)hkdfA2CInfo, strlen(hkdfA2CInfo), inInfo->A2CKey, 32);
+  require_noerr(err, exit);
+
+  inInfo->C2AKey = malloc(32);
+  require_action(inInfo->C2AKey, exit, err = kNoMemoryErr);
+  err = hkdf(SHA512,  (const unsigned char *) hkdfC2AKeySalt, strlen(hkdfC2AKeySalt),
+                            inInfo->pSharedSecret, 32,
+                            (const unsigned char *)hkdfC2AInfo, strlen(hkdfC2AInfo), inInfo->C2AKey, 32);
+  require_noerr(err, exit);
+
+  _HKPairResumeStore(sessionID, inInfo->pSharedSecret, inInfo->pControllerIdentifier);
+  inInfo->verifySuccess = true;
+
+exit:
+  return err;
+}
+
 OSStatus HKPairSetupEngine( int inFd, HTTPHeader_t* inHeader, pairInfo_t** inInfo, mico_Context_t * const inContext )
 {
   OSStatus err = kNoErr;
@@ -169,8 +539,6 @@ OSStatus HKPairSetupEngine( int inFd, HTTPHeader_t* inHeader, pairInfo_t** inInf
   size_t outTLVResponseLen = 0;
   uint8_t *tlvPtr;
 
-  uint8_t *httpResponse = NULL;
-  size_t httpResponseLen = 0;
 
 
   if(pairErrorNum>=10){
@@ -195,11 +563,7 @@ OSStatus HKPairSetupEngine( int inFd, HTTPHeader_t* inHeader, pairInfo_t** inInf
 
     haPairSetupState = eState_M1_SRPStartRequest;
 
-    err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_Pairing_TLV8, outTLVResponseLen, &httpResponse, &httpResponseLen );
-    require_noerr( err, exit );
-    err = SocketSend( inFd, httpResponse, httpResponseLen );
-    require_noerr( err, exit );
-    err = SocketSend(inFd, outTLVResponse, outTLVResponseLen);
+    err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
     require_noerr( err, exit );
     goto exit;
   }
@@ -304,16 +668,10 @@ OSStatus _HandleState_HandleSRPStartRespond(int inFd, pairInfo_t* inInfo, mico_C
   size_t outTLVResponseLen = 0;
   uint8_t *tlvPtr;
   char *tempString = NULL;
-  uint8_t *httpResponse = NULL;
-  size_t httpResponseLen = 0;
 
   require_action(_verifier||_password, exit, err = kParamErr);
-  inInfo->SRPServer = srp_server_setup( SRP_SHA512, SRP_NG_3072, inInfo->SRPUser, 
-                                        _password, _len_password, 
-                                        _verifier, _len_verifier,
-                                        _salt, _len_salt,
-                                        0, 0);
-  require(inInfo->SRPServer, exit);
+  err = MICORunCryptoJob( _HKSRPSetupJob, inInfo, CryptoJobPriorityLow );
+  require_noerr(err, exit);
 
 #ifdef DEBUG
   tempString = DataToHexString( inInfo->SRPServer->bytes_v, inInfo->SRPServer->len_v );
@@ -362,18 +720,13 @@ OSStatus _HandleState_HandleSRPStartRespond(int inFd, pairInfo_t* inInfo, mico_C
   tlvPtr += inInfo->SRPServer->len_B%kHATLV_MaxStringSize;
   
   /* Send */
-  err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_Pairing_TLV8, outTLVResponseLen, &httpResponse, &httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, httpResponse, httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, outTLVResponse, outTLVResponseLen );
+  err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
   require_noerr( err, exit );
 
   haPairSetupState = eState_M3_SRPVerifyRequest;
 
 exit:
   if(outTLVResponse) free(outTLVResponse);
-  if(httpResponse) free(httpResponse);
   return err;
 }
 
@@ -450,7 +803,6 @@ OSStatus _HandleState_HandleSRPVerifyRespond(int inFd, pairInfo_t* inInfo, mico_
   uint8_t *tlvPtr;
   uint8_t signMFiChallenge[32];
   uint8_t signMFiChallengeSHA[20];
-  SHA_CTX ctx;
   uint8_t *MFiProof = NULL;
   size_t  MFiProofLen;
   uint8_t *outCertificatePtr = NULL;
@@ -459,13 +811,11 @@ OSStatus _HandleState_HandleSRPVerifyRespond(int inFd, pairInfo_t* inInfo, mico_
   unsigned long long encryptedDataLen;
   int i, j;
 
-  uint8_t *httpResponse = NULL;
-  size_t httpResponseLen = 0;
 
   const uint8_t * bytes_HAMK = 0;
 
   pair_log( "Checking password..." );
-  err = srp_server_generate_session_key( inInfo->SRPServer, inInfo->SRPControllerPublicKey, inInfo->SRPControllerPublicKeyLen );
+  err = MICORunCryptoJob( _HKSRPSessionKeyJob, inInfo, CryptoJobPriorityLow );
   require_noerr(err, exit);
 
   srp_server_verify_session( inInfo->SRPServer,  inInfo->SRPControllerProof,  &bytes_HAMK );
@@ -506,9 +856,8 @@ OSStatus _HandleState_HandleSRPVerifyRespond(int inFd, pairInfo_t* inInfo, mico_
                           inInfo->SRPServer->session_key, inInfo->SRPServer->len_session_key,
                           (const unsigned char *)hkdfMFiInfo, strlen(hkdfMFiInfo), signMFiChallenge, 32);
       require_noerr(err, exit);  
-      SHA1_Init( &ctx );
-      SHA1_Update( &ctx, signMFiChallenge, 32 );
-      SHA1_Final( (uint8_t *)&signMFiChallengeSHA, &ctx );
+      err = Hash_Data( kHashType_SHA1, signMFiChallenge, 32, signMFiChallengeSHA );
+      require_noerr(err, exit);
 
       err =  MicoMFiAuthCreateSignature( signMFiChallengeSHA, 20 , &MFiProof,  &MFiProofLen);
       require_noerr(err, exit);
@@ -599,17 +948,12 @@ OSStatus _HandleState_HandleSRPVerifyRespond(int inFd, pairInfo_t* inInfo, mico_
     haPairSetupState = eState_M5_ExchangeRequest;
   }
 
-  err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_Pairing_TLV8, outTLVResponseLen, &httpResponse, &httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, httpResponse, httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend(inFd, outTLVResponse, outTLVResponseLen);
+  err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
   require_noerr( err, exit );
 
 exit:
   if(outTLVResponse) free(outTLVResponse);
   if(encryptedData) free(encryptedData);
-  if(httpResponse) free(httpResponse);
   if(MFiProof) free(MFiProof);
   if(outCertificatePtr) free(outCertificatePtr);
 
@@ -720,7 +1064,7 @@ OSStatus _HandleState_WaitingForExchangeRequest( HTTPHeader_t* inHeader, pairInf
   memcpy(signature+64+32, controllerIdentifier, controllerIdentifierLen);
   memcpy(signature+64+32+controllerIdentifierLen, controllerLTPK, 32);
 
-  err = crypto_sign_open(NULL, NULL, signature, 64 + 32 + controllerIdentifierLen + 32, controllerLTPK);
+  err = _HKSignOpen(signature, 64 + 32 + controllerIdentifierLen + 32, controllerLTPK, CryptoJobPriorityLow);
   require_noerr_string(err, exit, "Signature verify failed");
 
   /* Insert pair info */
@@ -748,8 +1092,6 @@ OSStatus _HandleState_HandleExchangeRespond(int inFd, pairInfo_t** inInfo, mico_
   size_t outTLVResponseLen = 0;
   uint8_t *tlvPtr;
 
-  uint8_t *httpResponse = NULL;
-  size_t httpResponseLen = 0;
   uint8_t  signHKDF[32];
   uint8_t LTPK[32];
   unsigned char *       encryptedData = NULL;
@@ -801,7 +1143,7 @@ OSStatus _HandleState_HandleExchangeRespond(int inFd, pairInfo_t** inInfo, mico_
     memcpy(XYZ+32, accessoryName, strlen(accessoryName));
     memcpy(XYZ+32+strlen(accessoryName), LTPK, 32);
     
-    err = crypto_sign(signature,&signatureLen, XYZ, XYZLen, inContext->flashContentInRam.appConfig.LTSK );
+    err = _HKSign(signature,&signatureLen, XYZ, XYZLen, inContext->flashContentInRam.appConfig.LTSK, CryptoJobPriorityLow );
     require_noerr_string(err, exit, "crypto sign failed");
     require_string(signatureLen == 64+XYZLen, exit, "crypto sign failed");
 
@@ -862,11 +1204,7 @@ OSStatus _HandleState_HandleExchangeRespond(int inFd, pairInfo_t** inInfo, mico_
 
   haPairSetupState = eState_M1_SRPStartRequest;
 
-  err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_Pairing_TLV8, outTLVResponseLen, &httpResponse, &httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, httpResponse, httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend(inFd, outTLVResponse, outTLVResponseLen);
+  err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
   require_noerr( err, exit );
 
   /*Save accessory's LPSK*/
@@ -881,7 +1219,6 @@ OSStatus _HandleState_HandleExchangeRespond(int inFd, pairInfo_t** inInfo, mico_
 
 exit:
   if(outTLVResponse) free(outTLVResponse);
-  if(httpResponse) free(httpResponse);
   if(signature) free(signature);
   if(accessoryName) free(accessoryName);
   if(XYZ) free(XYZ);
@@ -900,7 +1237,10 @@ OSStatus HKPairVerifyEngine( int inFd, HTTPHeader_t* inHeader, pairVerifyInfo_t*
     case eState_M1_VerifyStartRequest:
       err = _HandleState_WaitingForVerifyStartRequest( inHeader, inInfo, inContext );
       require_noerr_action( err, exit, inInfo->haPairVerifyState = eState_M1_VerifyStartRequest);
-      err =  _HandleState_WaitingForVerifyStartRespond( inFd , inInfo, inContext );
+      if(inInfo->resumed == true)
+        err = _HandleState_HandleResumeRespond( inFd , inInfo, inContext );
+      else
+        err =  _HandleState_WaitingForVerifyStartRespond( inFd , inInfo, inContext );
       require_noerr_action( err, exit, inInfo->haPairVerifyState = eState_M1_VerifyStartRequest);
       break;
 
@@ -931,6 +1271,10 @@ OSStatus _HandleState_WaitingForVerifyStartRequest( HTTPHeader_t* inHeader, pair
   const uint8_t *             ptr;
   size_t                      len;
   char *                      tmp = NULL;
+  uint8_t                     method = 0;
+  uint8_t *                   sessionID = NULL;
+  uint8_t *                   authTag = NULL;
+  size_t                      authTagLen = 0;
 
   while( TLVGetNext( src, end, &eid, &ptr, &len, &src ) == kNoErr )
   {
@@ -945,16 +1289,40 @@ OSStatus _HandleState_WaitingForVerifyStartRequest( HTTPHeader_t* inHeader, pair
         free(tmp);
         break;
       case kTLVType_PublicKey:
+        if(inInfo->pControllerCurve25519PK) free(inInfo->pControllerCurve25519PK);
         inInfo->pControllerCurve25519PK = (uint8_t *)tmp;
+        require_action(len == 32, exit, err = kSizeErr);
+        break;
+      case kTLVType_Method:
+        free(tmp);
+        require_action(len >= 1, exit, err = kSizeErr);
+        method = ptr[0];
+        break;
+      case kTLVType_SessionID:
+        if(sessionID) free(sessionID);
+        sessionID = (uint8_t *)tmp;
+        require_action(len == kPairResumeSessionIDLen, exit, err = kSizeErr);
+        break;
+      case kTLVType_EncryptedData:
+        if(authTag) free(authTag);
+        authTag = (uint8_t *)tmp;
+        authTagLen = len;
         break;
       default:
         pair_log( "Warning: Ignoring unsupported pair setup EID 0x%02X", eid );
         break;
     }
   }
+
+  /* Resume a cached session, or fall back to a full pair verify */
+  if(method == kTLVMethod_PairResume && sessionID && authTag)
+    _HKPairResumeCheck(inInfo, sessionID, authTag, authTagLen);
+
   inInfo->haPairVerifyState = eState_M2_VerifyStartRespond;
 
 exit:
+  if(sessionID) free(sessionID);
+  if(authTag) free(authTag);
   return err;
 }
 
@@ -965,8 +1333,6 @@ OSStatus _HandleState_WaitingForVerifyStartRespond(int inFd, pairVerifyInfo_t* i
   uint8_t             *outTLVResponse = NULL;
   size_t              outTLVResponseLen = 0;
   uint8_t             *tlvPtr;
-  uint8_t             *httpResponse = NULL;
-  size_t              httpResponseLen = 0;
   uint8_t             *ABC = NULL;
   size_t              ABCLen = 0;
   uint8_t             *signature = NULL;
@@ -988,10 +1354,10 @@ OSStatus _HandleState_WaitingForVerifyStartRespond(int inFd, pairVerifyInfo_t* i
   /* Generate new, random Curve25519 key pair */
   err = PlatformRandomBytes( inInfo->pAccessoryCurve25519SK, 32 );
   require_noerr( err, exit );
-  curve25519_donna( inInfo->pAccessoryCurve25519PK, inInfo->pAccessoryCurve25519SK, NULL );
+  _HKCurve25519( inInfo->pAccessoryCurve25519PK, inInfo->pAccessoryCurve25519SK, NULL );
 
   /* Generate shared secret */
-  curve25519_donna( inInfo->pSharedSecret, inInfo->pAccessoryCurve25519SK, inInfo->pControllerCurve25519PK );
+  _HKCurve25519( inInfo->pSharedSecret, inInfo->pAccessoryCurve25519SK, inInfo->pControllerCurve25519PK );
 
   /* Generate signature of accessory's info  ABC: Accessory curve25519 pk/accessory identifier/Controller curve25519 pk */
   accessoryName = __strdup_trans_dot(inContext->micoStatus.mac);
@@ -1008,7 +1374,7 @@ OSStatus _HandleState_WaitingForVerifyStartRespond(int inFd, pairVerifyInfo_t* i
   memcpy(ABC+32,                        accessoryName,                    strlen(accessoryName));
   memcpy(ABC+32+strlen(accessoryName),  inInfo->pControllerCurve25519PK,  32);
 
-  err = crypto_sign(signature,&signatureLen, ABC, ABCLen, inContext->flashContentInRam.appConfig.LTSK );
+  err = _HKSign(signature,&signatureLen, ABC, ABCLen, inContext->flashContentInRam.appConfig.LTSK, CryptoJobPriorityHigh );
   require_noerr_string(err, exit, "crypto sign failed");
   free(ABC);
   ABC = NULL;
@@ -1077,11 +1443,7 @@ OSStatus _HandleState_WaitingForVerifyStartRespond(int inFd, pairVerifyInfo_t* i
   *tlvPtr++ = encryptedDataLen;
   memcpy( tlvPtr, encryptedData, encryptedDataLen );
 
-  err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_Pairing_TLV8, outTLVResponseLen, &httpResponse, &httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, httpResponse, httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend(inFd, outTLVResponse, outTLVResponseLen);
+  err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
   require_noerr( err, exit );
   inInfo->haPairVerifyState = eState_M3_VerifyFinishRequest;
 
@@ -1091,7 +1453,75 @@ exit:
   if(signature) free(signature);
   if(encryptedData) free(encryptedData);
   if(outTLVResponse) free(outTLVResponse);
-  if(httpResponse) free(httpResponse);
+  return err;
+}
+
+OSStatus _HandleState_HandleResumeRespond(int inFd, pairVerifyInfo_t* inInfo, mico_Context_t * const inContext)
+{
+  pair_log_trace();
+  OSStatus            err = kNoErr;
+  (void)              inContext;
+  uint8_t             *outTLVResponse = NULL;
+  size_t              outTLVResponseLen = 0;
+  uint8_t             *tlvPtr;
+  uint8_t             sessionID[kPairResumeSessionIDLen];
+  uint8_t             salt[32+kPairResumeSessionIDLen];
+  uint8_t             key[32];
+  uint8_t             authTag[crypto_aead_chacha20poly1305_ABYTES];
+  unsigned long long  authTagLen = 0;
+
+  /* New session ID, the controller resumes this session with it next time */
+  err = PlatformRandomBytes( sessionID, kPairResumeSessionIDLen );
+  require_noerr( err, exit );
+
+  memcpy(salt,    inInfo->pControllerCurve25519PK, 32);
+  memcpy(salt+32, sessionID,                       kPairResumeSessionIDLen);
+  err = hkdf(SHA512,  salt, sizeof(salt), inInfo->pSharedSecret, 32,
+                      (const unsigned char *)hkdfResumeRespondInfo, strlen(hkdfResumeRespondInfo), key, 32);
+  require_noerr_string(err, exit, "Generate HKDK key failed");
+
+  err =  crypto_aead_chacha20poly1305_encrypt(authTag, &authTagLen, (const unsigned char *)"", 0,
+                                              NULL, 0, NULL, (const unsigned char *)AEAD_Nonce_Resume02, key);
+  require_noerr_action(err, exit, pair_log("crypto_aead_chacha20poly1305_encrypt failed"));
+
+  /* The resumed session runs on a new secret derived from the cached one */
+  err = hkdf(SHA512,  salt, sizeof(salt), inInfo->pSharedSecret, 32,
+                      (const unsigned char *)hkdfResumeSecretInfo, strlen(hkdfResumeSecretInfo), key, 32);
+  require_noerr(err, exit);
+  memcpy(inInfo->pSharedSecret, key, 32);
+
+  /* Respond with TLV item */
+  outTLVResponseLen += sizeof(uint8_t) + kHATLV_TypeLengthSize;
+  outTLVResponseLen += kPairResumeSessionIDLen + kHATLV_TypeLengthSize;
+  outTLVResponseLen += authTagLen + kHATLV_TypeLengthSize;
+
+  outTLVResponse = calloc( outTLVResponseLen, sizeof( uint8_t ) );
+  require_action( outTLVResponse, exit, err = kNoMemoryErr );
+
+  tlvPtr = outTLVResponse;
+  *tlvPtr++ = kTLVType_State;
+  *tlvPtr++ = sizeof(uint8_t);
+  *tlvPtr++ = eState_M2_VerifyStartRespond;
+
+  *tlvPtr++ = kTLVType_SessionID;
+  *tlvPtr++ = kPairResumeSessionIDLen;
+  memcpy( tlvPtr, sessionID, kPairResumeSessionIDLen );
+  tlvPtr += kPairResumeSessionIDLen;
+
+  *tlvPtr++ = kTLVType_EncryptedData;
+  *tlvPtr++ = authTagLen;
+  memcpy( tlvPtr, authTag, authTagLen );
+
+  err = _HKPairVerifyEstablish(inInfo, sessionID);
+  require_noerr( err, exit );
+
+  err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
+  require_noerr( err, exit );
+  pair_log("Pair resume success");
+
+exit:
+  memset(key, 0x0, sizeof(key));
+  if(outTLVResponse) free(outTLVResponse);
   return err;
 }
 
@@ -1175,7 +1605,7 @@ OSStatus _HandleState_WaitingForVerifyFinishRequest(HTTPHeader_t* inHeader, pair
   memcpy(signature+64+32,                         controllerIdentifier,             controllerIdentifierLen);
   memcpy(signature+64+32+controllerIdentifierLen, inInfo->pAccessoryCurve25519PK,   32);
 
-  err = crypto_sign_open(NULL, NULL, signature, 64 + 32 + controllerIdentifierLen + 32, inInfo->pControllerLTPK);
+  err = _HKSignOpen(signature, 64 + 32 + controllerIdentifierLen + 32, inInfo->pControllerLTPK, CryptoJobPriorityHigh);
   require_noerr_string(err, exit, "Signature verify failed");
   pair_log("Signature verify success");
 
@@ -1196,8 +1626,7 @@ OSStatus _HandleState_WaitingForVerifyFinishRespond(int inFd, pairVerifyInfo_t*
   size_t outTLVResponseLen = 0;
   uint8_t *tlvPtr;
 
-  uint8_t *httpResponse = NULL;
-  size_t httpResponseLen = 0;
+  uint8_t sessionID[kPairResumeSessionIDLen];
 
   outTLVResponseLen += sizeof(uint8_t) + kHATLV_TypeLengthSize;
 
@@ -1209,59 +1638,46 @@ OSStatus _HandleState_WaitingForVerifyFinishRespond(int inFd, pairVerifyInfo_t*
   *tlvPtr++ = sizeof(uint8_t);
   *tlvPtr++ = eState_M4_SRPVerifyRespond;
 
-  inInfo->verifySuccess = true;
-  inInfo->A2CKey = malloc(32);
-  require_action(inInfo->A2CKey, exit, err = kNoMemoryErr);
-  err = hkdf(SHA512,  (const unsigned char *) hkdfA2CKeySalt, strlen(hkdfA2CKeySalt),
+  /* Both sides derive the same ID, the controller may resume this session with it */
+  err = hkdf(SHA512,  (const unsigned char *) hkdfResumeIDSalt, strlen(hkdfResumeIDSalt),
                             inInfo->pSharedSecret, 32,
-                            (const unsigned char *)hkdfA2CInfo, strlen(hkdfA2CInfo), inInfo->A2CKey, 32);
+                            (const unsigned char *)hkdfResumeIDInfo, strlen(hkdfResumeIDInfo), sessionID, kPairResumeSessionIDLen);
   require_noerr(err, exit);
 
-  inInfo->C2AKey = malloc(32);
-  require_action(inInfo->C2AKey, exit, err = kNoMemoryErr);
-  err = hkdf(SHA512,  (const unsigned char *) hkdfC2AKeySalt, strlen(hkdfC2AKeySalt),
-                            inInfo->pSharedSecret, 32,
-                            (const unsigned char *)hkdfC2AInfo, strlen(hkdfC2AInfo), inInfo->C2AKey, 32);
+  err = _HKPairVerifyEstablish(inInfo, sessionID);
   require_noerr(err, exit);
 
-  err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_Pairing_TLV8, outTLVResponseLen, &httpResponse, &httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, httpResponse, httpResponseLen );
-  require_noerr( err, exit );
-  err = SocketSend( inFd, outTLVResponse, outTLVResponseLen );
+  err = SocketSendHTTPResponse( inFd, kStatusOK, kMIMEType_Pairing_TLV8, outTLVResponse, outTLVResponseLen );
   require_noerr( err, exit );
 
 exit:
   if(outTLVResponse) free(outTLVResponse);
-  if(httpResponse) free(httpResponse);
   return err;
 }
 
 OSStatus HKSendPairResponseMessage(int sockfd, int status, uint8_t *payload, int payloadLen, security_session_t *session )
 {
   OSStatus err;
-  uint8_t *httpResponse = NULL;
+  char httpResponse[kHTTPResponseHeaderMaxLen];
   size_t httpResponseLen = 0;
   const char *buffer = NULL;
   int bufferLen;
+  hk_iovec_t iov[2];
 
   buffer = (const char *)payload;
   bufferLen = payloadLen;
 
-  err = CreateHTTPRespondMessageNoCopy( status, kMIMEType_Pairing_TLV8, bufferLen, &httpResponse, &httpResponseLen );
+  httpResponseLen = HTTPResponseHeaderWrite( httpResponse, sizeof(httpResponse), status, bufferLen ? kMIMEType_Pairing_TLV8 : NULL, bufferLen, false );
+  require_action( httpResponseLen, exit, err = kSizeErr );
 
+  iov[0].base = httpResponse;
+  iov[0].len = httpResponseLen;
+  iov[1].base = buffer;
+  iov[1].len = bufferLen;
+  err = HKSecureSocketSendv( sockfd, iov, 2, session );
   require_noerr( err, exit );
-  require( httpResponse, exit );
-
-  err = HKSecureSocketSend( sockfd, httpResponse, httpResponseLen, session );
-  require_noerr( err, exit );
-  if(bufferLen){
-    err = HKSecureSocketSend( sockfd, (uint8_t *)buffer, bufferLen, session );
-    require_noerr( err, exit ); 
-  }
 
 exit:
-  if(httpResponse) free(httpResponse);
   return err;
 }
 
@@ -1278,7 +1694,8 @@ OSStatus HKPairAddRemoveEngine( int inFd, HTTPHeader_t* inHeader, security_sessi
     uint8_t *outTLVResponse = NULL;
   size_t outTLVResponseLen = 0;
   uint8_t *tlvPtr;
-  pair_list_in_flash_t        *pairList = NULL;
+  _pair_t                     *pairList = NULL;
+  uint32_t                    pairNumber = 0;
   bool needSeparator = false;
 
   const uint8_t *             src = (const uint8_t *) inHeader->extraDataPtr;
@@ -1380,6 +1797,7 @@ OSStatus HKPairAddRemoveEngine( int inFd, HTTPHeader_t* inHeader, security_sessi
   }else if(methold == Pair_Remove){
     require_action(controllerIdentifier, exit, err = kParamErr);
 
+    HKPairResumeRemove(controllerIdentifier);
     if( HMRemoveLTPK(controllerIdentifier) != kNoErr ){ //Remove
       outTLVResponseLen += sizeof(uint8_t) + kHATLV_TypeLengthSize;
       outTLVResponseLen += sizeof(uint8_t) + kHATLV_TypeLengthSize;
@@ -1416,22 +1834,23 @@ OSStatus HKPairAddRemoveEngine( int inFd, HTTPHeader_t* inHeader, security_sessi
 
   }else if(methold == Pair_List){ //List
 
-    pairList = calloc(1, sizeof(pair_list_in_flash_t));
-    require_action(pairList, exit, err = kNoMemoryErr);
-
-    err = HMReadPairList(pairList);
-    require_noerr(err, exit);
+    pairNumber = HMGetPairNumber();
+    if(pairNumber){
+      pairList = calloc(pairNumber, sizeof(_pair_t));
+      require_action(pairList, exit, err = kNoMemoryErr);
+      pairNumber = HMCopyPairList(pairList, pairNumber);
+    }
 
     outTLVResponseLen += sizeof(uint8_t) + kHATLV_TypeLengthSize; //M2
 
     needSeparator = false;
-    for(i=0; i<MAXPairNumber; i++){
-      if(pairList->pairInfo[i].controllerName[0] != 0){
+    for(i=0; i<pairNumber; i++){
+      if(pairList[i].controllerName[0] != 0){
         if(needSeparator)
           outTLVResponseLen += kHATLV_TypeLengthSize; //Separates
         else
           needSeparator = true;
-        outTLVResponseLen += strlen(pairList->pairInfo[i].controllerName) + kHATLV_TypeLengthSize; //Identifier
+        outTLVResponseLen += strlen(pairList[i].controllerName) + kHATLV_TypeLengthSize; //Identifier
         outTLVResponseLen += 32 + kHATLV_TypeLengthSize;  //Public key
         outTLVResponseLen += sizeof(uint8_t) + kHATLV_TypeLengthSize;  //Permission
       }
@@ -1446,8 +1865,8 @@ OSStatus HKPairAddRemoveEngine( int inFd, HTTPHeader_t* inHeader, security_sessi
     *tlvPtr++ = eState_M2_PairingRespond;
 
     needSeparator = false;
-    for(i=0; i<MAXPairNumber; i++){
-      if(pairList->pairInfo[i].controllerName[0] != 0){
+    for(i=0; i<pairNumber; i++){
+      if(pairList[i].controllerName[0] != 0){
         if(needSeparator){
           *tlvPtr++ = kTLVType_Separator;
           *tlvPtr++ = 0x0;
@@ -1456,18 +1875,18 @@ OSStatus HKPairAddRemoveEngine( int inFd, HTTPHeader_t* inHeader, security_sessi
           needSeparator = true;
 
         *tlvPtr++ = kTLVType_Identifier;
-        *tlvPtr++ = strlen(pairList->pairInfo[i].controllerName);
-        strncpy((char *)tlvPtr, pairList->pairInfo[i].controllerName, 64);
-        tlvPtr+= strlen(pairList->pairInfo[i].controllerName);
+        *tlvPtr++ = strlen(pairList[i].controllerName);
+        strncpy((char *)tlvPtr, pairList[i].controllerName, 64);
+        tlvPtr+= strlen(pairList[i].controllerName);
 
         *tlvPtr++ = kTLVType_PublicKey;
         *tlvPtr++ = 32;
-        memcpy(tlvPtr, pairList->pairInfo[i].controllerLTPK, 32);
+        memcpy(tlvPtr, pairList[i].controllerLTPK, 32);
         tlvPtr+= 32;
 
         *tlvPtr++ = kTLVType_Permissions;
         *tlvPtr++ = sizeof(uint8_t);
-        *tlvPtr+= pairList->pairInfo[i].permission;
+        *tlvPtr+= pairList[i].permission;
       }
     }
 
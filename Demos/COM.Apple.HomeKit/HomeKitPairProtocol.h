@@ -35,8 +35,14 @@ typedef struct _pairVerifyInfo_t {
   uint8_t                   *pHKDFKey;
   uint8_t                   *A2CKey;
   uint8_t                   *C2AKey;
+  bool                      resumed;
 } pairVerifyInfo_t;
 
+/*Shared secrets of verified sessions are kept in RAM, a controller that comes back
+  within PairResumeLifetime resumes its session without Curve25519 and Ed25519*/
+#define PairResumeCacheSize   4
+#define PairResumeLifetime    (60*60*1000)   //ms, a cached session can be resumed in this time
+
 void HKSetPassword (const uint8_t * password, const size_t passwordLen);
 
 void HKSetVerifier (const uint8_t * verifier, const size_t verifierLen, const uint8_t * salt, const size_t saltLen );
@@ -53,6 +59,10 @@ OSStatus HKPairVerifyEngine( int inFd, HTTPHeader_t* inHeader, pairVerifyInfo_t*
 
 OSStatus HKPairAddRemoveEngine( int inFd, HTTPHeader_t* inHeader, security_session_t *session );
 
+OSStatus HKPairResumeInit(void);
+
+void HKPairResumeRemove(char * controllerIdentifier);
+
 
 #endif
 
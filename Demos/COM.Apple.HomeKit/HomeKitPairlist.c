@@ -19,176 +19,619 @@
   ******************************************************************************
   */ 
 
+
 #include "HomeKitPairlist.h"
 #include "Debug.h"
 #include "MicoPlatform.h"
 #include "platform_config.h"
+#include "MICORTOS.h"
 
-/* Update seed number every time*/
+#define pairlist_log(M, ...) custom_log("HKPairList", M, ##__VA_ARGS__)
 
-OSStatus HMClearPairList(void)
-{ 
+/* The pair list is a journal: a header followed by records appended in order.
+   Replaying the records at boot rebuilds the pair list. When the journal is
+   full, it is compacted into the other area (erase, one record per pair, then
+   the header), and only then is the old header cleared, so a power loss always
+   leaves one complete copy. This needs areas that are erased independently:
+   the EX_PARA halves do so only when EX_PARA spans two erase sectors. */
+#define kPairJournalMagic         0x31504B48 //"HKP1"
+#define kPairJournalOpInsert      0x00000001
+#define kPairJournalOpRemove      0x00000002
+#define kPairJournalOpErased      0xFFFFFFFF
+
+#define kPairJournalAreaNumber    2
+#define kPairCacheBucketNumber    16
+
+typedef struct _pair_journal_area_t {
+  mico_flash_t     partition;
+  uint32_t         start;
+} pair_journal_area_t;
+
+typedef struct _pair_journal_header_t {
+  uint32_t         magic;
+  uint32_t         generation;  //Larger in the newer area, the magic is written after it
+} pair_journal_header_t;
+
+typedef struct _pair_journal_record_t {
+  uint32_t         op;
+  _pair_t          pair;
+} pair_journal_record_t;
+
+typedef struct _pair_cache_entry_t {
+  struct _pair_cache_entry_t *next;
+  uint32_t         hash;
+  _pair_t          pair;
+} pair_cache_entry_t;
+
+typedef struct _pair_pending_t {
+  struct _pair_pending_t *next;
+  pair_journal_record_t record;
+} pair_pending_t;
+
+static bool                 _pairListInited = false;
+static mico_mutex_t         _cacheMutex = NULL;
+static mico_mutex_t         _flashMutex = NULL;
+static mico_timer_t         _flushTimer;
+static mico_semaphore_t     _flushSem = NULL;
+static pair_cache_entry_t * _pairCache[kPairCacheBucketNumber];
+static uint32_t             _pairNumber = 0;
+static pair_pending_t *     _pendingHead = NULL;
+static pair_pending_t *     _pendingTail = NULL;
+static uint32_t             _journalArea = 0;
+static uint32_t             _journalGeneration = 0;
+static uint32_t             _journalAddress = EX_PARA_START_ADDRESS + sizeof(pair_journal_header_t);
+static mico_mutex_t         _initMutex = NULL;
+
+static const pair_journal_area_t _journalAreas[kPairJournalAreaNumber] = {
+  { MICO_FLASH_FOR_EX_PARA, EX_PARA_START_ADDRESS },
+#ifdef MICO_FLASH_FOR_EX_PARA_BAK
+  { MICO_FLASH_FOR_EX_PARA_BAK, EX_PARA_BAK_START_ADDRESS },
+#else
+  { MICO_FLASH_FOR_EX_PARA, EX_PARA_START_ADDRESS + PairListAreaSize },
+#endif
+};
+
+uint8_t foundControllerLTPK[32];
+
+/* FNV-1a over the identifier, limited to MaxControllerNameLen like strncmp */
+static uint32_t _HMHashName(const char *name)
+{
+  uint32_t hash = 2166136261UL;
+  uint32_t i;
+
+  for(i = 0; i < MaxControllerNameLen && name[i] != 0x0; i++){
+    hash ^= (uint8_t)name[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+static pair_cache_entry_t *_HMCacheFind(const char *name, uint32_t hash)
+{
+  pair_cache_entry_t *entry = _pairCache[hash % kPairCacheBucketNumber];
+
+  for(; entry != NULL; entry = entry->next){
+    if(entry->hash == hash && strncmp(entry->pair.controllerName, name, MaxControllerNameLen) == 0)
+      return entry;
+  }
+  return NULL;
+}
+
+static OSStatus _HMCacheInsert(const _pair_t *pair)
+{
+  OSStatus err = kNoErr;
+  uint32_t hash = _HMHashName(pair->controllerName);
+  pair_cache_entry_t *entry = _HMCacheFind(pair->controllerName, hash);
+
+  if(entry == NULL){
+    require_action(_pairNumber < MAXPairNumber, exit, err = kNoSpaceErr);
+    entry = calloc(1, sizeof(pair_cache_entry_t));
+    require_action(entry, exit, err = kNoMemoryErr);
+    entry->hash = hash;
+    entry->next = _pairCache[hash % kPairCacheBucketNumber];
+    _pairCache[hash % kPairCacheBucketNumber] = entry;
+    _pairNumber++;
+  }
+  memcpy(&entry->pair, pair, sizeof(_pair_t));
+
+exit:
+  return err;
+}
+
+static bool _HMCacheRemove(const char *name)
+{
+  uint32_t hash = _HMHashName(name);
+  pair_cache_entry_t **link = &_pairCache[hash % kPairCacheBucketNumber];
+  pair_cache_entry_t *entry;
+
+  for(; *link != NULL; link = &(*link)->next){
+    entry = *link;
+    if(entry->hash == hash && strncmp(entry->pair.controllerName, name, MaxControllerNameLen) == 0){
+      *link = entry->next;
+      free(entry);
+      _pairNumber--;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint32_t _HMCacheCopy(_pair_t *pPairs, uint32_t maxNumber)
+{
+  pair_cache_entry_t *entry;
+  uint32_t i, number = 0;
+
+  for(i = 0; i < kPairCacheBucketNumber; i++){
+    for(entry = _pairCache[i]; entry != NULL && number < maxNumber; entry = entry->next)
+      memcpy(&pPairs[number++], &entry->pair, sizeof(_pair_t));
+  }
+  return number;
+}
+
+static void _HMCacheClear(void)
+{
+  pair_cache_entry_t *entry, *next;
+  pair_pending_t *pending, *nextPending;
+  uint32_t i;
+
+  for(i = 0; i < kPairCacheBucketNumber; i++){
+    for(entry = _pairCache[i]; entry != NULL; entry = next){
+      next = entry->next;
+      free(entry);
+    }
+    _pairCache[i] = NULL;
+  }
+  _pairNumber = 0;
+
+  for(pending = _pendingHead; pending != NULL; pending = nextPending){
+    nextPending = pending->next;
+    free(pending);
+  }
+  _pendingHead = _pendingTail = NULL;
+}
+
+/* Caller holds _cacheMutex, the record is written to flash by the flush thread */
+static OSStatus _HMQueueRecord(uint32_t op, const _pair_t *pair)
+{
+  OSStatus err = kNoErr;
+  pair_pending_t *pending = calloc(1, sizeof(pair_pending_t));
+  require_action(pending, exit, err = kNoMemoryErr);
+
+  pending->record.op = op;
+  memcpy(&pending->record.pair, pair, sizeof(_pair_t));
+  if(_pendingTail)
+    _pendingTail->next = pending;
+  else
+    _pendingHead = pending;
+  _pendingTail = pending;
+
+  mico_stop_timer(&_flushTimer);
+  mico_start_timer(&_flushTimer);
+
+exit:
+  return err;
+}
+
+/* Write the op word last, an interrupted write is then seen as the journal end */
+static OSStatus _HMJournalWrite(const pair_journal_area_t *area, uint32_t address, const pair_journal_record_t *record)
+{
   OSStatus err = kNoErr;
-  uint32_t exParaStartAddress, exParaEndAddress;
- 
-  exParaStartAddress = EX_PARA_START_ADDRESS;
-  exParaEndAddress = EX_PARA_END_ADDRESS;
-  pair_list_in_flash_t *pairList = NULL;
-  pairList = calloc(1, sizeof(pair_list_in_flash_t));
-  require_action(pairList, exit, err = kNoMemoryErr);
+  uint32_t opAddress = address;
 
-  err = MicoFlashInitialize(MICO_FLASH_FOR_EX_PARA);
+  address += sizeof(uint32_t);
+  err = MicoFlashInitialize(area->partition);
   require_noerr(err, exit);
-  err = MicoFlashErase(MICO_FLASH_FOR_EX_PARA, exParaStartAddress, exParaEndAddress);
+  err = MicoFlashWrite(area->partition, &address, (uint8_t *)&record->pair, sizeof(_pair_t));
   require_noerr(err, exit);
-  err = MicoFlashWrite(MICO_FLASH_FOR_EX_PARA, &exParaStartAddress, (uint8_t *)pairList, sizeof(pair_list_in_flash_t));
+  err = MicoFlashWrite(area->partition, &opAddress, (uint8_t *)&record->op, sizeof(uint32_t));
   require_noerr(err, exit);
-  err = MicoFlashFinalize(MICO_FLASH_FOR_EX_PARA);
+  err = MicoFlashFinalize(area->partition);
   require_noerr(err, exit);
 
 exit:
-  if(pairList) free(pairList);
   return err;
 }
 
-OSStatus HMReadPairList(pair_list_in_flash_t *pPairList)
+/* Caller holds _flashMutex */
+static OSStatus _HMJournalAppend(const pair_journal_record_t *record)
 {
-  uint32_t configInFlash;
   OSStatus err = kNoErr;
-  require(pPairList, exit);
+  const pair_journal_area_t *area = &_journalAreas[_journalArea];
 
-  configInFlash = EX_PARA_START_ADDRESS;
-  err = MicoFlashRead(MICO_FLASH_FOR_EX_PARA, &configInFlash, (uint8_t *)pPairList, sizeof(pair_list_in_flash_t));
-  //memcpy(pPairList, (void *)configInFlash, sizeof(pair_list_in_flash_t));
+  require_action(_journalAddress + sizeof(pair_journal_record_t) <= area->start + PairListAreaSize, exit, err = kNoSpaceErr);
 
-exit: 
+  err = _HMJournalWrite(area, _journalAddress, record);
+  require_noerr(err, exit);
+
+  _journalAddress += sizeof(pair_journal_record_t);
+
+exit:
   return err;
 }
 
-OSStatus HMUpdatePairList(pair_list_in_flash_t *pPairList)
+/* Caller holds _flashMutex, write one insert record per pair to the other area,
+   then switch to it. The old area stays valid until the new header is written */
+static OSStatus _HMJournalCompact(void)
 {
   OSStatus err = kNoErr;
-  uint32_t exParaStartAddress, exParaEndAddress;
- 
-  exParaStartAddress = EX_PARA_START_ADDRESS;
-  exParaEndAddress = EX_PARA_END_ADDRESS;
+  uint32_t next = (_journalArea + 1) % kPairJournalAreaNumber;
+  const pair_journal_area_t *area = &_journalAreas[next];
+  const pair_journal_area_t *old = &_journalAreas[_journalArea];
+  uint32_t address = area->start + sizeof(pair_journal_header_t);
+  uint32_t headerAddress;
+  pair_journal_header_t header;
+  uint32_t invalid = 0;
+  pair_journal_record_t record;
+  _pair_t *pairs = NULL;
+  uint32_t pairNumber = 0, i;
+
+  mico_rtos_lock_mutex(&_cacheMutex);
+  if(_pairNumber){
+    pairs = malloc(_pairNumber * sizeof(_pair_t));
+    if(pairs) pairNumber = _HMCacheCopy(pairs, _pairNumber);
+  }
+  mico_rtos_unlock_mutex(&_cacheMutex);
+  require_action(pairs || pairNumber == 0, exit, err = kNoMemoryErr);
 
-  err = MicoFlashInitialize(MICO_FLASH_FOR_EX_PARA);
+  err = MicoFlashInitialize(area->partition);
   require_noerr(err, exit);
-  err = MicoFlashErase(MICO_FLASH_FOR_EX_PARA, exParaStartAddress, exParaEndAddress);
+  err = MicoFlashErase(area->partition, area->start, area->start + PairListAreaSize - 1);
   require_noerr(err, exit);
-  err = MicoFlashWrite(MICO_FLASH_FOR_EX_PARA, &exParaStartAddress, (uint8_t *)pPairList, sizeof(pair_list_in_flash_t));
+  err = MicoFlashFinalize(area->partition);
   require_noerr(err, exit);
-  err = MicoFlashFinalize(MICO_FLASH_FOR_EX_PARA);
+
+  record.op = kPairJournalOpInsert;
+  for(i = 0; i < pairNumber; i++){
+    memcpy(&record.pair, &pairs[i], sizeof(_pair_t));
+    err = _HMJournalWrite(area, address, &record);
+    require_noerr(err, exit);
+    address += sizeof(pair_journal_record_t);
+  }
+
+  /* The magic commits the new area, clearing the old one's retires it */
+  header.magic = kPairJournalMagic;
+  header.generation = _journalGeneration + 1;
+  err = MicoFlashInitialize(area->partition);
+  require_noerr(err, exit);
+  headerAddress = area->start + sizeof(uint32_t);
+  err = MicoFlashWrite(area->partition, &headerAddress, (uint8_t *)&header.generation, sizeof(uint32_t));
+  require_noerr(err, exit);
+  headerAddress = area->start;
+  err = MicoFlashWrite(area->partition, &headerAddress, (uint8_t *)&header.magic, sizeof(uint32_t));
+  require_noerr(err, exit);
+  err = MicoFlashFinalize(area->partition);
+  require_noerr(err, exit);
+
+  _journalArea = next;
+  _journalGeneration = header.generation;
+  _journalAddress = address;
+
+  err = MicoFlashInitialize(old->partition);
+  require_noerr(err, exit);
+  headerAddress = old->start;
+  err = MicoFlashWrite(old->partition, &headerAddress, (uint8_t *)&invalid, sizeof(uint32_t));
+  require_noerr(err, exit);
+  err = MicoFlashFinalize(old->partition);
   require_noerr(err, exit);
 
 exit:
+  if(pairs) free(pairs);
   return err;
 }
 
-OSStatus HKInsertPairInfo(char controllerIdentifier[64], uint8_t controllerLTPK[32], bool admin)
+static bool _HMIsErased(const uint8_t *data, uint32_t len)
+{
+  while(len--)
+    if(*data++ != 0xFF) return false;
+  return true;
+}
+
+static OSStatus _HMJournalRead(const pair_journal_area_t *area, uint32_t address, uint8_t *data, uint32_t len)
 {
   OSStatus err = kNoErr;
-  pair_list_in_flash_t        *pairList = NULL;
-  uint32_t i;
 
-  /* Pair storage */
-  pairList = calloc(1, sizeof(pair_list_in_flash_t));
-  require_action(pairList, exit, err = kNoMemoryErr);
-  err = HMReadPairList(pairList);
+  err = MicoFlashInitialize(area->partition);
+  require_noerr(err, exit);
+  err = MicoFlashRead(area->partition, &address, data, len);
+  require_noerr(err, exit);
+  err = MicoFlashFinalize(area->partition);
   require_noerr(err, exit);
-  
-  /* Looking for controller pair record */
-  for(i=0; i<MAXPairNumber; i++){
-    if(strncmp(pairList->pairInfo[i].controllerName, controllerIdentifier, 64)==0)
-      break;
+
+exit:
+  return err;
+}
+
+/* Build the RAM cache from flash, convert a legacy pair list or a damaged journal */
+static OSStatus _HMPairListLoad(void)
+{
+  OSStatus err = kNoErr;
+  const pair_journal_area_t *area;
+  pair_journal_header_t header[kPairJournalAreaNumber];
+  pair_journal_record_t record;
+  uint32_t address, end;
+  bool valid[kPairJournalAreaNumber];
+  bool needCompact = false;
+  uint32_t i;
+
+  for(i = 0; i < kPairJournalAreaNumber; i++){
+    err = _HMJournalRead(&_journalAreas[i], _journalAreas[i].start, (uint8_t *)&header[i], sizeof(pair_journal_header_t));
+    require_noerr(err, exit);
+    valid[i] = (header[i].magic == kPairJournalMagic);
   }
 
-  /* This is a new record */
-  if(i == MAXPairNumber){
-    for(i=0; i<MAXPairNumber; i++){
-      if(pairList->pairInfo[i].controllerName[0] == 0x0)
-      break;
+  if(valid[0] || valid[1]){
+    /* Both are valid if power was lost before the old header was cleared */
+    if(valid[0] && valid[1])
+      _journalArea = ((int32_t)(header[1].generation - header[0].generation) > 0)? 1 : 0;
+    else
+      _journalArea = valid[1]? 1 : 0;
+    _journalGeneration = header[_journalArea].generation;
+    needCompact = (valid[0] && valid[1]);
+
+    area = &_journalAreas[_journalArea];
+    end = area->start + PairListAreaSize;
+    _journalAddress = area->start + sizeof(pair_journal_header_t);
+    while(_journalAddress + sizeof(pair_journal_record_t) <= end){
+      err = _HMJournalRead(area, _journalAddress, (uint8_t *)&record, sizeof(pair_journal_record_t));
+      require_noerr(err, exit);
+      if(record.op == kPairJournalOpErased){
+        if(!_HMIsErased((uint8_t *)&record.pair, sizeof(_pair_t)))
+          needCompact = true;  //Power lost during an append
+        break;
+      }
+      if(record.op == kPairJournalOpInsert)
+        _HMCacheInsert(&record.pair);
+      else if(record.op == kPairJournalOpRemove)
+        _HMCacheRemove(record.pair.controllerName);
+      else{
+        needCompact = true;
+        break;
+      }
+      _journalAddress += sizeof(pair_journal_record_t);
+    }
+  }else{
+    /* The legacy list is at the start of EX_PARA, compact it into the other area */
+    pairlist_log("Convert legacy pair list");
+    _journalArea = 0;
+    address = EX_PARA_START_ADDRESS;
+    for(i = 0; i < MAXLegacyPairNumber; i++){
+      err = _HMJournalRead(&_journalAreas[0], address, (uint8_t *)&record.pair, sizeof(_pair_t));
+      require_noerr(err, exit);
+      address += sizeof(_pair_t);
+      if(record.pair.controllerName[0] != 0x0 && (uint8_t)record.pair.controllerName[0] != 0xFF)
+        _HMCacheInsert(&record.pair);
     }
+    needCompact = true;
+  }
+
+  if(needCompact){
+    mico_rtos_lock_mutex(&_flashMutex);
+    err = _HMJournalCompact();
+    mico_rtos_unlock_mutex(&_flashMutex);
+  }
+
+exit:
+  return err;
+}
+
+/* Runs in the timer service, the flash is written by the flush thread so a
+   journal compaction erase does not hold up the other timers */
+static void _HMFlushTimerHandler(void *arg)
+{
+  (void)arg;
+  mico_stop_timer(&_flushTimer);
+  mico_rtos_set_semaphore(&_flushSem);
+}
+
+static void _HMFlushThread(void *arg)
+{
+  (void)arg;
+  while(1){
+    mico_rtos_get_semaphore(&_flushSem, MICO_WAIT_FOREVER);
+    HMFlushPairList();
+  }
+}
+
+OSStatus HMPairListInit(void)
+{
+  OSStatus err = kNoErr;
+
+  if(_pairListInited == true)
+    return kNoErr;
+
+  /* Early callers from different threads initialise it only once */
+  if(_initMutex == NULL){
+    mico_rtos_suspend_all_thread();
+    if(_initMutex == NULL)
+      mico_rtos_init_mutex(&_initMutex);
+    mico_rtos_resume_all_thread();
   }
-  
-  /* No space for new record */
-  require_action(i < MAXPairNumber, exit, err = kNoSpaceErr);
+  mico_rtos_lock_mutex(&_initMutex);
+  require_action_quiet(_pairListInited == false, exit, err = kNoErr);
 
-  /* Write pair info to flash */
-  strcpy(pairList->pairInfo[i].controllerName, controllerIdentifier);
-  memcpy(pairList->pairInfo[i].controllerLTPK, controllerLTPK, 32);
+  err = mico_rtos_init_mutex(&_cacheMutex);
+  require_noerr(err, exit);
+  err = mico_rtos_init_mutex(&_flashMutex);
+  require_noerr(err, exit);
+  err = mico_rtos_init_semaphore(&_flushSem, 1);
+  require_noerr(err, exit);
+  err = mico_init_timer(&_flushTimer, PairListFlushDelay, _HMFlushTimerHandler, NULL);
+  require_noerr(err, exit);
+  err = mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY + 1, "HK PairList", _HMFlushThread, PairListFlushStackSize, NULL);
+  require_noerr(err, exit);
+
+  /* Other callers wait on _initMutex until the cache is loaded */
+  err = _HMPairListLoad();
+  _pairListInited = true;
+  require_noerr_action(err, exit, pairlist_log("Load pair list failed, err = %d", err));
+  pairlist_log("%d pairs loaded", _pairNumber);
+
+exit:
+  mico_rtos_unlock_mutex(&_initMutex);
+  return err;
+}
+
+OSStatus HMClearPairList(void)
+{ 
+  OSStatus err = kNoErr;
+
+  HMPairListInit();
+  require_action(_pairListInited, exit, err = kNotInitializedErr);
+
+  mico_rtos_lock_mutex(&_cacheMutex);
+  _HMCacheClear();
+  mico_rtos_unlock_mutex(&_cacheMutex);
+
+  mico_rtos_lock_mutex(&_flashMutex);
+  err = _HMJournalCompact();
+  mico_rtos_unlock_mutex(&_flashMutex);
+
+exit:
+  return err;
+}
+
+OSStatus HMFlushPairList(void)
+{
+  OSStatus err = kNoErr;
+  pair_pending_t *pending, *next;
+  bool compacted = false;
+
+  require_action(_pairListInited, exit, err = kNotInitializedErr);
+
+  mico_rtos_lock_mutex(&_flashMutex);
+
+  mico_rtos_lock_mutex(&_cacheMutex);
+  pending = _pendingHead;
+  _pendingHead = _pendingTail = NULL;
+  mico_rtos_unlock_mutex(&_cacheMutex);
+
+  for(; pending != NULL; pending = next){
+    next = pending->next;
+    if(err == kNoErr && compacted == false){
+      err = _HMJournalAppend(&pending->record);
+      if(err == kNoSpaceErr){ //Journal is full, the compacted journal has every pending record
+        err = _HMJournalCompact();
+        compacted = true;
+      }
+    }
+    free(pending);
+  }
+
+  mico_rtos_unlock_mutex(&_flashMutex);
+
+exit:
+  return err;
+}
+
+uint32_t HMGetPairNumber(void)
+{
+  HMPairListInit();
+  return _pairNumber;
+}
+
+uint32_t HMCopyPairList(_pair_t *pPairs, uint32_t maxNumber)
+{
+  uint32_t number = 0;
+
+  HMPairListInit();
+  require(_pairListInited, exit);
+
+  mico_rtos_lock_mutex(&_cacheMutex);
+  number = _HMCacheCopy(pPairs, maxNumber);
+  mico_rtos_unlock_mutex(&_cacheMutex);
+
+exit:
+  return number;
+}
+
+OSStatus HKInsertPairInfo(char controllerIdentifier[64], uint8_t controllerLTPK[32], bool admin)
+{
+  OSStatus err = kNoErr;
+  pair_cache_entry_t *entry;
+  _pair_t pair;
+
+  err = HMPairListInit();
+  require(_pairListInited, exit);
+
+  mico_rtos_lock_mutex(&_cacheMutex);
+
+  memset(&pair, 0x0, sizeof(_pair_t));
+  entry = _HMCacheFind(controllerIdentifier, _HMHashName(controllerIdentifier));
+  if(entry)
+    pair.permission = entry->pair.permission;
+
+  strncpy(pair.controllerName, controllerIdentifier, MaxControllerNameLen);
+  memcpy(pair.controllerLTPK, controllerLTPK, 32);
   if(admin)
-    pairList->pairInfo[i].permission = pairList->pairInfo[i].permission|0x00000001;
+    pair.permission = pair.permission|0x00000001;
   else
-    pairList->pairInfo[i].permission = pairList->pairInfo[i].permission&0xFFFFFFFE;
-  err = HMUpdatePairList(pairList);
+    pair.permission = pair.permission&0xFFFFFFFE;
+
+  err = _HMCacheInsert(&pair);
+  if(err == kNoErr)
+    err = _HMQueueRecord(kPairJournalOpInsert, &pair);
+
+  mico_rtos_unlock_mutex(&_cacheMutex);
 
 exit: 
-  if(pairList) free(pairList);
   return err;
 }
 
-
-uint8_t foundControllerLTPK[32];
-
 uint8_t * HMFindLTPK(char * name)
 {
   uint8_t *controllerLTPK = NULL;
-  uint32_t i;
+  pair_cache_entry_t *entry;
 
-  pair_list_in_flash_t *pairList = malloc(sizeof(pair_list_in_flash_t));
-  HMReadPairList(pairList);
+  HMPairListInit();
+  require(_pairListInited, exit);
 
-  for(i=0; i<MAXPairNumber; i++){
-    if(strncmp(pairList->pairInfo[i].controllerName, name, 64) == 0){
-      memcpy(foundControllerLTPK, pairList->pairInfo[i].controllerLTPK, 32);
-      controllerLTPK = foundControllerLTPK;
-      break;
-    }
+  mico_rtos_lock_mutex(&_cacheMutex);
+  entry = _HMCacheFind(name, _HMHashName(name));
+  if(entry){
+    memcpy(foundControllerLTPK, entry->pair.controllerLTPK, 32);
+    controllerLTPK = foundControllerLTPK;
   }
-  
-  free(pairList);
+  mico_rtos_unlock_mutex(&_cacheMutex);
+
+exit:
   return controllerLTPK;
 }
 
 bool HMFindAdmin(char * name)
 {
-  uint32_t i;
   bool ret = false;
+  pair_cache_entry_t *entry;
 
-  pair_list_in_flash_t *pairList = malloc(sizeof(pair_list_in_flash_t));
-  HMReadPairList(pairList);
+  HMPairListInit();
+  require(_pairListInited, exit);
 
-  for(i=0; i<MAXPairNumber; i++){
-    if(strncmp(pairList->pairInfo[i].controllerName, name, 64) == 0){
-      ret = pairList->pairInfo[i].permission&0x1;
-      free(pairList);
-      return ret;
-    }
-  }
-  
-  free(pairList);
+  mico_rtos_lock_mutex(&_cacheMutex);
+  entry = _HMCacheFind(name, _HMHashName(name));
+  if(entry)
+    ret = entry->pair.permission&0x1;
+  mico_rtos_unlock_mutex(&_cacheMutex);
+
+exit:
   return ret;
 }
 
 OSStatus HMRemoveLTPK(char * name)
 {
-  uint32_t i;
   OSStatus err = kNoErr;
+  _pair_t pair;
 
-  pair_list_in_flash_t *pairList = malloc(sizeof(pair_list_in_flash_t));
-  HMReadPairList(pairList);
+  err = HMPairListInit();
+  require(_pairListInited, exit);
 
-  for(i=0; i<MAXPairNumber; i++){
-    if(strncmp(pairList->pairInfo[i].controllerName, name, 64) == 0){
-      pairList->pairInfo[i].controllerName[0] = 0x0; //Clear the controller name record
-      err = HMUpdatePairList(pairList);
-      break;
-    }
+  mico_rtos_lock_mutex(&_cacheMutex);
+  if(_HMCacheRemove(name)){
+    memset(&pair, 0x0, sizeof(_pair_t));
+    strncpy(pair.controllerName, name, MaxControllerNameLen);
+    err = _HMQueueRecord(kPairJournalOpRemove, &pair);
   }
-  
-  free(pairList);
+  mico_rtos_unlock_mutex(&_cacheMutex);
+
+exit:
   return err;  
 }
 
@@ -107,7 +107,7 @@ extern HkStatus HKExcuteUnpairedIdentityRoutine( mico_Context_t * const inContex
 static void homeKitClient_thread(void *inFd);
 static mico_Context_t *Context;
 static OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notify_t** notifyList, HK_Context_t *inHkContext, mico_Context_t * const inContext);
-static OSStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t *inHapObject,  HK_Notify_t* notifyList, json_object **OutHapObjectJson,  mico_Context_t * const inContext);
+static OSStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t *inHapObject,  HK_Notify_t* notifyList, json_object **OutHapObjectJson, json_arena_t *arena, mico_Context_t * const inContext);
 static OSStatus HKCreateHAPReadRespond( struct _hapAccessory_t inHapObject[],  json_object **OutHapObjectJson, 
                                                 int accessoryID, int serviceID, int characteristicID, mico_Context_t * const inContext);
 static OSStatus HKCreateHAPWriteRespond( struct _hapAccessory_t inHapObject[],  json_object *inputHapObjectJson, json_object **OutHapObjectJson,
@@ -132,6 +132,7 @@ void homeKitListener_thread(void *inContext)
   int homeKitlistener_fd = -1;
   //HKSetPassword (password, strlen(password));
   HKSetVerifier(verifier, sizeof(verifier), salt, sizeof(salt));
+  HKPairResumeInit();
 
   Context->appStatus.haPairSetupRunning = false;
   HKCharacteristicInit(inContext);
@@ -324,6 +325,7 @@ void homeKitClient_thread(void *inFd)
   value_union value, newValue;
   struct _hapCharacteristic_t pCharacteristic;
   json_object *outEventJsonObject = NULL, *outCharacteristics, *outCharacteristic;
+  json_arena_t *arena = NULL;
   const char *buffer = NULL;
 
   memset(&hkContext, 0x0, sizeof(HK_Context_t));
@@ -357,9 +359,12 @@ void homeKitClient_thread(void *inFd)
       if(hkContext.session->established == false) // No nofification in no paired session
         continue;
 
-      outEventJsonObject = json_object_new_object();
+      /* Everything made for this round goes back to the heap at once */
+      arena = json_arena_new(0);
+      require_action(arena, exit, err = kNoMemoryErr);
+      outEventJsonObject = json_object_new_object_arena(arena);
       require_action(outEventJsonObject, exit, err = kNoMemoryErr);
-      outCharacteristics = json_object_new_array();
+      outCharacteristics = json_object_new_array_arena(arena);
       require_action(outCharacteristics, exit, err = kNoMemoryErr);
       json_object_object_add( outEventJsonObject, "characteristics", outCharacteristics);
       temp = notifyList;
@@ -372,50 +377,50 @@ void homeKitClient_thread(void *inFd)
           switch(pCharacteristic.valueType){
             case ValueType_bool:
               if( value.boolValue != newValue.boolValue ){
-                outCharacteristic = json_object_new_object();
-                json_object_object_add( outCharacteristic, "aid", json_object_new_int(aid));
-                json_object_object_add( outCharacteristic, "iid", json_object_new_int(iid));
-                json_object_object_add( outCharacteristic, "value", json_object_new_boolean(newValue.boolValue));
+                outCharacteristic = json_object_new_object_arena(arena);
+                json_object_object_add( outCharacteristic, "aid", json_object_new_int_arena(arena, aid));
+                json_object_object_add( outCharacteristic, "iid", json_object_new_int_arena(arena, iid));
+                json_object_object_add( outCharacteristic, "value", json_object_new_boolean_arena(arena, newValue.boolValue));
                 json_object_array_add( outCharacteristics, outCharacteristic );
                 HKNotificationAdd( aid, iid, newValue, &notifyList );
               }
               break;
             case ValueType_int:
               if( value.intValue != newValue.intValue ){
-                outCharacteristic = json_object_new_object();
-                json_object_object_add( outCharacteristic, "aid", json_object_new_int(aid));
-                json_object_object_add( outCharacteristic, "iid", json_object_new_int(iid));
-                json_object_object_add( outCharacteristic, "value", json_object_new_int(newValue.intValue));
+                outCharacteristic = json_object_new_object_arena(arena);
+                json_object_object_add( outCharacteristic, "aid", json_object_new_int_arena(arena, aid));
+                json_object_object_add( outCharacteristic, "iid", json_object_new_int_arena(arena, iid));
+                json_object_object_add( outCharacteristic, "value", json_object_new_int_arena(arena, newValue.intValue));
                 json_object_array_add( outCharacteristics, outCharacteristic );
                 HKNotificationAdd( aid, iid, newValue, &notifyList );
               }
               break;
             case ValueType_float:
               if( value.floatValue != newValue.floatValue ){
-                outCharacteristic = json_object_new_object();
-                json_object_object_add( outCharacteristic, "aid", json_object_new_int(aid));
-                json_object_object_add( outCharacteristic, "iid", json_object_new_int(iid));
-                json_object_object_add( outCharacteristic, "value", json_object_new_double(newValue.floatValue));
+                outCharacteristic = json_object_new_object_arena(arena);
+                json_object_object_add( outCharacteristic, "aid", json_object_new_int_arena(arena, aid));
+                json_object_object_add( outCharacteristic, "iid", json_object_new_int_arena(arena, iid));
+                json_object_object_add( outCharacteristic, "value", json_object_new_double_arena(arena, newValue.floatValue));
                 json_object_array_add( outCharacteristics, outCharacteristic );
                 HKNotificationAdd( aid, iid, newValue, &notifyList );
               }
               break;
             case ValueType_string:
               if( !strcmp(value.stringValue, newValue.stringValue) ){
-                outCharacteristic = json_object_new_object();
-                json_object_object_add( outCharacteristic, "aid", json_object_new_int(aid));
-                json_object_object_add( outCharacteristic, "iid", json_object_new_int(iid));
-                json_object_object_add( outCharacteristic, "value", json_object_new_string(newValue.stringValue));
+                outCharacteristic = json_object_new_object_arena(arena);
+                json_object_object_add( outCharacteristic, "aid", json_object_new_int_arena(arena, aid));
+                json_object_object_add( outCharacteristic, "iid", json_object_new_int_arena(arena, iid));
+                json_object_object_add( outCharacteristic, "value", json_object_new_string_arena(arena, newValue.stringValue));
                 json_object_array_add( outCharacteristics, outCharacteristic );
                 HKNotificationAdd( aid, iid, newValue, &notifyList );
               }
               break;
             case ValueType_date:
               if( !strcmp(value.dateValue, newValue.dateValue) ){
-                outCharacteristic = json_object_new_object();
-                json_object_object_add( outCharacteristic, "aid", json_object_new_int(aid));
-                json_object_object_add( outCharacteristic, "iid", json_object_new_int(iid));
-                json_object_object_add( outCharacteristic, "value", json_object_new_string(newValue.dateValue));
+                outCharacteristic = json_object_new_object_arena(arena);
+                json_object_object_add( outCharacteristic, "aid", json_object_new_int_arena(arena, aid));
+                json_object_object_add( outCharacteristic, "iid", json_object_new_int_arena(arena, iid));
+                json_object_object_add( outCharacteristic, "value", json_object_new_string_arena(arena, newValue.dateValue));
                 json_object_array_add( outCharacteristics, outCharacteristic );
                 HKNotificationAdd( aid, iid, newValue, &notifyList );
               }
@@ -436,6 +441,8 @@ void homeKitClient_thread(void *inFd)
       
       json_object_put(outEventJsonObject);
       outEventJsonObject = NULL;
+      json_arena_free(arena);
+      arena = NULL;
           //err = HKSendResponseMessage(sockfd, status, (uint8_t *)buffer->buf, strlen(buffer->buf), inHkContext);
           //require_noerr(err, exit);
     }
@@ -447,6 +454,7 @@ exit:
   if(httpHeader)    free(httpHeader);
   HKNotificationClean( &notifyList );
   if(outEventJsonObject) json_object_put(outEventJsonObject);
+  json_arena_free(arena);
   HKCleanPairSetupInfo(&hkContext.pairInfo, Context);
   HKCleanPairVerifyInfo(&hkContext.pairVerifyInfo);
   free(hkContext.session);
@@ -459,7 +467,7 @@ exit:
 
 
 
-static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[], HK_Notify_t* notifyList, json_object **OutHapObjectJson, mico_Context_t * const inContext)
+static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[], HK_Notify_t* notifyList, json_object **OutHapObjectJson, json_arena_t *arena, mico_Context_t * const inContext)
 {
   HkStatus err = kNoErr;
   uint32_t accessoryIndex, serviceIndex, characteristicIndex;
@@ -473,41 +481,41 @@ static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[],
   json_object *hapJsonObject, *accessories, *accessory, *services, *service, *characteristics, *characteristic, *properties;
   json_object *constraints, *metaData;
 
-  hapJsonObject = json_object_new_object();
-  accessories = json_object_new_array();
+  hapJsonObject = json_object_new_object_arena(arena);
+  accessories = json_object_new_array_arena(arena);
   json_object_object_add( hapJsonObject, "accessories", accessories ); 
 
   for(accessoryIndex = 0; accessoryIndex < NumberofAccessories; accessoryIndex++){
 
-    accessory = json_object_new_object();
+    accessory = json_object_new_object_arena(arena);
     json_object_array_add (accessories, accessory);
 
-    json_object_object_add( accessory, "aid", json_object_new_int(aid++) );   
-    services = json_object_new_array();
+    json_object_object_add( accessory, "aid", json_object_new_int_arena(arena, aid++) );   
+    services = json_object_new_array_arena(arena);
     json_object_object_add( accessory, "services", services);
 
     for(serviceIndex = 0, iid = 1; serviceIndex < MAXServicePerAccessory; serviceIndex++){
       if(inHapObject[accessoryIndex].services[serviceIndex].type == 0)
         break;
-      service = json_object_new_object();
+      service = json_object_new_object_arena(arena);
 
-      json_object_object_add( service, "type", json_object_new_string(inHapObject[0].services[serviceIndex].type));
-      json_object_object_add( service, "iid",  json_object_new_int(iid++));
+      json_object_object_add( service, "type", json_object_new_string_arena(arena, inHapObject[0].services[serviceIndex].type));
+      json_object_object_add( service, "iid",  json_object_new_int_arena(arena, iid++));
 
-      characteristics = json_object_new_array();
+      characteristics = json_object_new_array_arena(arena);
 
       json_object_object_add( service, "characteristics",  characteristics);
 
       for(characteristicIndex = 0; characteristicIndex < MAXCharacteristicPerService; characteristicIndex++){
         pCharacteristic = inHapObject[accessoryIndex].services[serviceIndex].characteristic[characteristicIndex];
         if(pCharacteristic.type){
-          characteristic = json_object_new_object();
+          characteristic = json_object_new_object_arena(arena);
           json_object_array_add( characteristics, characteristic ); 
           /*Type*/
-          json_object_object_add( characteristic, "type", json_object_new_string(pCharacteristic.type));
+          json_object_object_add( characteristic, "type", json_object_new_string_arena(arena, pCharacteristic.type));
 
           /*Instance ID*/
-          json_object_object_add( characteristic, "iid", json_object_new_int(iid++));
+          json_object_object_add( characteristic, "iid", json_object_new_int_arena(arena, iid++));
 
           HKReadCharacteristicValue(accessoryIndex+1, serviceIndex+1, characteristicIndex+1, &value, inContext);
           /*Value*/
@@ -516,19 +524,19 @@ static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[],
 
           switch(pCharacteristic.valueType){
             case ValueType_bool:
-              json_object_object_add( characteristic, "value", json_object_new_boolean(value.boolValue));
+              json_object_object_add( characteristic, "value", json_object_new_boolean_arena(arena, value.boolValue));
               break;
             case ValueType_int:
-              json_object_object_add( characteristic, "value", json_object_new_int(value.intValue));
+              json_object_object_add( characteristic, "value", json_object_new_int_arena(arena, value.intValue));
               break;
             case ValueType_float:
-              json_object_object_add( characteristic, "value", json_object_new_double(value.floatValue));
+              json_object_object_add( characteristic, "value", json_object_new_double_arena(arena, value.floatValue));
               break;
             case ValueType_string:
-              json_object_object_add( characteristic, "value", json_object_new_string(value.stringValue));
+              json_object_object_add( characteristic, "value", json_object_new_string_arena(arena, value.stringValue));
               break;
             case ValueType_date:
-              json_object_object_add( characteristic, "value", json_object_new_string(value.dateValue));
+              json_object_object_add( characteristic, "value", json_object_new_string_arena(arena, value.dateValue));
               break;
             case ValueType_null:
               json_object_object_add( characteristic, "value", NULL);
@@ -537,27 +545,27 @@ static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[],
               break;
           }
 
-          properties = json_object_new_array();
+          properties = json_object_new_array_arena(arena);
           if(pCharacteristic.secureRead)
-            json_object_array_add( properties, json_object_new_string("pr") );
+            json_object_array_add( properties, json_object_new_string_arena(arena, "pr") );
           if(pCharacteristic.secureWrite)
-            json_object_array_add( properties, json_object_new_string("pw") );
+            json_object_array_add( properties, json_object_new_string_arena(arena, "pw") );
           json_object_object_add( characteristic, "perms", properties);
 
           if(pCharacteristic.hasEvents){
             if(HKNotificationFind(aid, iid, notifyList)==kNoErr)
-              json_object_object_add( characteristic, "ev", json_object_new_boolean(true));
+              json_object_object_add( characteristic, "ev", json_object_new_boolean_arena(arena, true));
             else
-              json_object_object_add( characteristic, "ev", json_object_new_boolean(false));
+              json_object_object_add( characteristic, "ev", json_object_new_boolean_arena(arena, false));
           }
 
           if(pCharacteristic.hasMinimumValue){
             switch(pCharacteristic.valueType){
               case ValueType_int:
-                json_object_object_add( characteristic, "minValue",  json_object_new_int(pCharacteristic.minimumValue.intValue) );
+                json_object_object_add( characteristic, "minValue",  json_object_new_int_arena(arena, pCharacteristic.minimumValue.intValue) );
                 break;
               case ValueType_float:
-                json_object_object_add( characteristic, "minValue",  json_object_new_double(pCharacteristic.minimumValue.floatValue) );
+                json_object_object_add( characteristic, "minValue",  json_object_new_double_arena(arena, pCharacteristic.minimumValue.floatValue) );
                 break;
               default:
                 break;
@@ -567,10 +575,10 @@ static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[],
           if(pCharacteristic.hasMaximumValue){
             switch(pCharacteristic.valueType){
               case ValueType_int:
-                json_object_object_add( characteristic, "maxValue",  json_object_new_int(pCharacteristic.maximumValue.intValue) );
+                json_object_object_add( characteristic, "maxValue",  json_object_new_int_arena(arena, pCharacteristic.maximumValue.intValue) );
                 break;
               case ValueType_float:
-                json_object_object_add( characteristic, "maxValue",  json_object_new_double(pCharacteristic.maximumValue.floatValue) );
+                json_object_object_add( characteristic, "maxValue",  json_object_new_double_arena(arena, pCharacteristic.maximumValue.floatValue) );
                 break;
               default:
                 break;
@@ -580,10 +588,10 @@ static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[],
           if(pCharacteristic.hasMinimumStep){
             switch(pCharacteristic.valueType){
               case ValueType_int:
-                json_object_object_add( characteristic, "minStep",  json_object_new_int(pCharacteristic.minimumStep.intValue) );
+                json_object_object_add( characteristic, "minStep",  json_object_new_int_arena(arena, pCharacteristic.minimumStep.intValue) );
                 break;
               case ValueType_float:
-                json_object_object_add( characteristic, "minStep",  json_object_new_double(pCharacteristic.minimumStep.floatValue) );
+                json_object_object_add( characteristic, "minStep",  json_object_new_double_arena(arena, pCharacteristic.minimumStep.floatValue) );
                 break;
               default:
                 break;
@@ -591,19 +599,19 @@ static HkStatus HKCreateHAPAttriDataBase( struct _hapAccessory_t inHapObject[],
           }
                
           if(pCharacteristic.hasMaxLength)
-            json_object_object_add( characteristic, "maxLen",     json_object_new_int(pCharacteristic.maxLength));
+            json_object_object_add( characteristic, "maxLen",     json_object_new_int_arena(arena, pCharacteristic.maxLength));
 
           if(pCharacteristic.hasMaxDataLength)
-            json_object_object_add( characteristic, "maxDataLen",     json_object_new_int(pCharacteristic.maxDataLength));
+            json_object_object_add( characteristic, "maxDataLen",     json_object_new_int_arena(arena, pCharacteristic.maxDataLength));
 
           if(pCharacteristic.description)
-            json_object_object_add( characteristic, "description", json_object_new_string(pCharacteristic.description));
+            json_object_object_add( characteristic, "description", json_object_new_string_arena(arena, pCharacteristic.description));
 
           if(pCharacteristic.format)
-            json_object_object_add( characteristic, "format", json_object_new_string(pCharacteristic.format));
+            json_object_object_add( characteristic, "format", json_object_new_string_arena(arena, pCharacteristic.format));
 
           if(pCharacteristic.unit)
-            json_object_object_add( characteristic, "unit", json_object_new_string(pCharacteristic.unit));
+            json_object_object_add( characteristic, "unit", json_object_new_string_arena(arena, pCharacteristic.unit));
         }
       }
       
@@ -649,11 +657,12 @@ HkStatus _HKCreateReadResponsePerCharacteristic(struct _hapAccessory_t inHapObje
   bool event;
   static json_object *characteristic;
   struct _hapCharacteristic_t pCharacteristic = ((inHapObject[id.aid-1]).services[id.serviceID-1]).characteristic[id.characteristicID-1];
+  json_arena_t *arena = json_object_get_arena(inHapReadRespondJson);
   
-  characteristic = json_object_new_object();
+  characteristic = json_object_new_object_arena(arena);
   json_object_array_add(inHapReadRespondJson, characteristic);
-  json_object_object_add( characteristic, "aid", json_object_new_int(id.aid));
-  json_object_object_add( characteristic, "iid", json_object_new_int(id.iid));
+  json_object_object_add( characteristic, "aid", json_object_new_int_arena(arena, id.aid));
+  json_object_object_add( characteristic, "iid", json_object_new_int_arena(arena, id.iid));
 
   if(pCharacteristic.secureRead == false){
     hkErr = kHKReadFromWOErr;
@@ -666,24 +675,24 @@ HkStatus _HKCreateReadResponsePerCharacteristic(struct _hapAccessory_t inHapObje
       hkErr = HKReadCharacteristicValue(id.aid, id.serviceID, id.characteristicID, &value, inContext);    
   }
 
-  json_object_object_add( characteristic, "status", json_object_new_int(hkErr)); //If no err occure, remove this key before send the respond
+  json_object_object_add( characteristic, "status", json_object_new_int_arena(arena, hkErr)); //If no err occure, remove this key before send the respond
 
   if(hkErr == kNoErr){
     switch(pCharacteristic.valueType ){
       case ValueType_bool:
-        json_object_object_add( characteristic, "value", json_object_new_boolean(value.boolValue));
+        json_object_object_add( characteristic, "value", json_object_new_boolean_arena(arena, value.boolValue));
         break;
       case ValueType_int:
-        json_object_object_add( characteristic, "value", json_object_new_int(value.intValue));
+        json_object_object_add( characteristic, "value", json_object_new_int_arena(arena, value.intValue));
         break;
       case ValueType_float:
-        json_object_object_add( characteristic, "value", json_object_new_double(value.floatValue));
+        json_object_object_add( characteristic, "value", json_object_new_double_arena(arena, value.floatValue));
         break;
       case ValueType_string:
-        json_object_object_add( characteristic, "value", json_object_new_string(value.stringValue));
+        json_object_object_add( characteristic, "value", json_object_new_string_arena(arena, value.stringValue));
         break;
       case ValueType_date:
-        json_object_object_add( characteristic, "value", json_object_new_string(value.stringValue));
+        json_object_object_add( characteristic, "value", json_object_new_string_arena(arena, value.stringValue));
         break;
       case ValueType_null:
         break;
@@ -696,10 +705,10 @@ HkStatus _HKCreateReadResponsePerCharacteristic(struct _hapAccessory_t inHapObje
      if(pCharacteristic.hasMinimumValue){
       switch(pCharacteristic.valueType){
         case ValueType_int:
-          json_object_object_add( characteristic, "minValue",  json_object_new_int(pCharacteristic.minimumValue.intValue) );
+          json_object_object_add( characteristic, "minValue",  json_object_new_int_arena(arena, pCharacteristic.minimumValue.intValue) );
           break;
         case ValueType_float:
-          json_object_object_add( characteristic, "minValue",  json_object_new_double(pCharacteristic.minimumValue.floatValue) );
+          json_object_object_add( characteristic, "minValue",  json_object_new_double_arena(arena, pCharacteristic.minimumValue.floatValue) );
           break;
         default:
           break;
@@ -709,10 +718,10 @@ HkStatus _HKCreateReadResponsePerCharacteristic(struct _hapAccessory_t inHapObje
     if(pCharacteristic.hasMaximumValue){
       switch(pCharacteristic.valueType){
         case ValueType_int:
-          json_object_object_add( characteristic, "maxValue",  json_object_new_int(pCharacteristic.maximumValue.intValue) );
+          json_object_object_add( characteristic, "maxValue",  json_object_new_int_arena(arena, pCharacteristic.maximumValue.intValue) );
           break;
         case ValueType_float:
-          json_object_object_add( characteristic, "maxValue",  json_object_new_double(pCharacteristic.maximumValue.floatValue) );
+          json_object_object_add( characteristic, "maxValue",  json_object_new_double_arena(arena, pCharacteristic.maximumValue.floatValue) );
           break;
         default:
           break;
@@ -722,10 +731,10 @@ HkStatus _HKCreateReadResponsePerCharacteristic(struct _hapAccessory_t inHapObje
     if(pCharacteristic.hasMinimumStep){
       switch(pCharacteristic.valueType){
         case ValueType_int:
-          json_object_object_add( characteristic, "minStep",  json_object_new_int(pCharacteristic.minimumStep.intValue) );
+          json_object_object_add( characteristic, "minStep",  json_object_new_int_arena(arena, pCharacteristic.minimumStep.intValue) );
           break;
         case ValueType_float:
-          json_object_object_add( characteristic, "minStep",  json_object_new_double(pCharacteristic.minimumStep.floatValue) );
+          json_object_object_add( characteristic, "minStep",  json_object_new_double_arena(arena, pCharacteristic.minimumStep.floatValue) );
           break;
         default:
           break;
@@ -733,40 +742,40 @@ HkStatus _HKCreateReadResponsePerCharacteristic(struct _hapAccessory_t inHapObje
     }
          
     if(pCharacteristic.hasMaxLength)
-      json_object_object_add( characteristic, "maxLen",     json_object_new_int(pCharacteristic.maxLength));
+      json_object_object_add( characteristic, "maxLen",     json_object_new_int_arena(arena, pCharacteristic.maxLength));
 
     if(pCharacteristic.hasMaxDataLength)
-      json_object_object_add( characteristic, "maxDataLen",     json_object_new_int(pCharacteristic.maxDataLength));
+      json_object_object_add( characteristic, "maxDataLen",     json_object_new_int_arena(arena, pCharacteristic.maxDataLength));
 
     if(pCharacteristic.description)
-      json_object_object_add( characteristic, "description", json_object_new_string(pCharacteristic.description));
+      json_object_object_add( characteristic, "description", json_object_new_string_arena(arena, pCharacteristic.description));
 
     if(pCharacteristic.format)
-      json_object_object_add( characteristic, "format", json_object_new_string(pCharacteristic.format));
+      json_object_object_add( characteristic, "format", json_object_new_string_arena(arena, pCharacteristic.format));
 
     if(pCharacteristic.unit)
-      json_object_object_add( characteristic, "unit", json_object_new_string(pCharacteristic.unit));   
+      json_object_object_add( characteristic, "unit", json_object_new_string_arena(arena, pCharacteristic.unit));   
   }
 
   if(needperms){
-    json_object *properties = json_object_new_array();
+    json_object *properties = json_object_new_array_arena(arena);
     if(pCharacteristic.secureRead)
-      json_object_array_add( properties, json_object_new_string("pr") );
+      json_object_array_add( properties, json_object_new_string_arena(arena, "pr") );
     if(pCharacteristic.secureWrite)
-      json_object_array_add( properties, json_object_new_string("pw") );
+      json_object_array_add( properties, json_object_new_string_arena(arena, "pw") );
     json_object_object_add( characteristic, "perms", properties);
   }
 
   if(needType){
-    json_object_object_add( characteristic, "type", json_object_new_string(pCharacteristic.type));
+    json_object_object_add( characteristic, "type", json_object_new_string_arena(arena, pCharacteristic.type));
   }
 
   if(needEv){
     if(pCharacteristic.hasEvents){
       if(HKNotificationFind(id.aid, id.iid, notifyList)==kNoErr)
-        json_object_object_add( characteristic, "ev", json_object_new_boolean(true));
+        json_object_object_add( characteristic, "ev", json_object_new_boolean_arena(arena, true));
       else
-        json_object_object_add( characteristic, "ev", json_object_new_boolean(false));
+        json_object_object_add( characteristic, "ev", json_object_new_boolean_arena(arena, false));
     }    
   }
 
@@ -840,11 +849,12 @@ HkStatus _HKCreateWriteResponsePerCharacteristic(struct _hapAccessory_t inHapObj
   int httpStatus = kStatusOK;
   static json_object *characteristic;
   struct _hapCharacteristic_t pCharacteristic = ((inHapObject[id.aid-1]).services[id.serviceID-1]).characteristic[id.characteristicID-1];
+  json_arena_t *arena = json_object_get_arena(inHapReadRespondJson);
   
-  characteristic = json_object_new_object();
+  characteristic = json_object_new_object_arena(arena);
   json_object_array_add(inHapReadRespondJson, characteristic);
-  json_object_object_add( characteristic, "aid", json_object_new_int(id.aid));
-  json_object_object_add( characteristic, "iid", json_object_new_int(id.iid));
+  json_object_object_add( characteristic, "aid", json_object_new_int_arena(arena, id.aid));
+  json_object_object_add( characteristic, "iid", json_object_new_int_arena(arena, id.iid));
 
   if(id.serviceID == 0 || id.characteristicID == 0)
     return kHKNotExistErr;
@@ -865,7 +875,7 @@ HkStatus _HKCreateWriteResponsePerCharacteristic(struct _hapAccessory_t inHapObj
 
 
 
-  json_object_object_add( characteristic, "status", json_object_new_int(hkErr)); 
+  json_object_object_add( characteristic, "status", json_object_new_int_arena(arena, hkErr)); 
 
   return hkErr;
 }
@@ -882,6 +892,8 @@ OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notif
   json_object *characteristics, *characteristic, *outCharacteristics, *outCharacteristic, *event_obj;
   json_object *value_obj = NULL;
   json_object *inhapJsonObject = NULL, *outhapJsonObject = NULL;
+  json_arena_t *arena = NULL;
+  unsigned long heapOps = json_c_heap_ops();
   value_union value;
   bool event, isFound;
   int status = kStatusOK;
@@ -950,7 +962,9 @@ OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notif
 
           require_action( inHkContext->session->established == true, exit, err = kAuthenticationErr; status = kStatusAuthenticationErr );
 
-          err = HKCreateHAPAttriDataBase(hapObjects, *notifyList, &outhapJsonObject, inContext);
+          arena = json_arena_new(0);
+          require_action( arena, exit, err = kNoMemoryErr );
+          err = HKCreateHAPAttriDataBase(hapObjects, *notifyList, &outhapJsonObject, arena, inContext);
           require_noerr( err, exit );
           buffer = json_object_to_json_string_ex(outhapJsonObject);
           ha_log("Json cstring generated, memory remains %d, %s", mico_memory_info()->free_memory, buffer->buf);
@@ -964,10 +978,14 @@ OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notif
 
           require_action( inHkContext->session->established == true, exit, err = kAuthenticationErr; status = kStatusAuthenticationErr );
 
+          /* The request, the respond and its json string share one arena */
+          arena = json_arena_new(0);
+          require_action( arena, exit, err = kNoMemoryErr );
+
           if(HTTPHeaderMatchMethod( httpHeader, "GET")!=kNotFoundErr){ //Read
             hkErr = kNoErr;
-            outhapJsonObject = json_object_new_object();
-            outCharacteristics = json_object_new_array();
+            outhapJsonObject = json_object_new_object_arena(arena);
+            outCharacteristics = json_object_new_array_arena(arena);
             json_object_object_add( outhapJsonObject, "characteristics", outCharacteristics);
 
             void *metaPtr = memmem((void *)httpHeader->url.queryPtr, httpHeader->url.queryLen, "meta=", strlen("meta="));
@@ -1030,7 +1048,7 @@ OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notif
           }
         /* Write characteristic */
         else if(HTTPHeaderMatchMethod( httpHeader, "PUT")!=kNotFoundErr){
-          inhapJsonObject = json_tokener_parse(httpHeader->extraDataPtr);
+          inhapJsonObject = json_tokener_parse_arena(httpHeader->extraDataPtr, arena);
           require_action(inhapJsonObject, exit, err = kMalformedErr);
           characteristics = json_object_object_get(inhapJsonObject, "characteristics");
           require_action(characteristics, exit, err = kMalformedErr);
@@ -1038,8 +1056,8 @@ OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notif
 
           hkErr = kNoErr;
           status = kStatusNoConetnt;
-          outhapJsonObject = json_object_new_object();
-          outCharacteristics = json_object_new_array();
+          outhapJsonObject = json_object_new_object_arena(arena);
+          outCharacteristics = json_object_new_array_arena(arena);
           json_object_object_add( outhapJsonObject, "characteristics", outCharacteristics);
 
           /* Parse every value and write*/
@@ -1131,8 +1149,8 @@ OSStatus HKhandleIncomeingMessage(int sockfd, HTTPHeader_t *httpHeader, HK_Notif
   }
 exit:
   if( err != kNoErr && status != kStatusOK ){
-    outhapJsonObject = json_object_new_object();
-    json_object_object_add( outhapJsonObject, "status", json_object_new_int(hkErr));
+    outhapJsonObject = json_object_new_object_arena(arena);
+    json_object_object_add( outhapJsonObject, "status", json_object_new_int_arena(arena, hkErr));
     buffer = json_object_to_json_string_ex(outhapJsonObject);
     ha_log("Json cstring generated, memory remains %d, %s", mico_memory_info()->free_memory, buffer->buf);
     HKSendResponseMessage(sockfd, status, (uint8_t *)buffer->buf, strlen(buffer->buf), inHkContext->session);
@@ -1143,6 +1161,11 @@ exit:
   if(outhapJsonObject) json_object_put(outhapJsonObject);
   if(inhapJsonObject) json_object_put(inhapJsonObject);
   if(buffer) printbuf_free(buffer);
+  if(arena){
+    ha_log("Json heap operations: %lu, arena %d bytes in %d blocks", json_c_heap_ops() - heapOps,
+           (int)json_arena_used(arena), json_arena_blocks(arena));
+    json_arena_free(arena);
+  }
   return err;
 
 }
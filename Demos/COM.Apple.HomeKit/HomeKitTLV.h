@@ -49,12 +49,18 @@
 // [bytes] Last fragment of data
 #define kTLVType_FragmentLast           0x0D
 
+// [bytes] 8 bytes identifier of a verified session, used to resume it.
+#define kTLVType_SessionID              0x0E
+
 // [null] Zero-length TLV that separates different TLVs in a list.
 #define kTLVType_Separator              0xFF
 
 #define kHATLV_MaxStringSize           	255
 #define kHATLV_TypeLengthSize          	2
 
+// Value of kTLVType_Method in a pair verify M1 that resumes a previous session
+#define kTLVMethod_PairResume           0x06
+
 
 // Success, This is not normally included in a message. Absence of a status item implies seccess
 #define kTLVError_NoErr   				0x00
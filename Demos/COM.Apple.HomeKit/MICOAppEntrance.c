@@ -23,6 +23,7 @@
 #include "MICODefine.h"
 #include "MICOAppDefine.h"
 #include "HomeKitPairList.h"
+#include "MICOCryptoWorker.h"
 
 #include "StringUtils.h"
 
@@ -62,6 +63,14 @@ OSStatus MICOStartApplication( mico_Context_t * const inContext )
 #endif
     inContext->appStatus.useMFiAuth = false;
 
+  /*Load pair list to RAM before any controller connects*/
+  err = HMPairListInit();
+  require_noerr_action( err, exit, app_log("ERROR: Unable to load the pair list.") );
+
+  /*Pairing crypto runs below the application threads*/
+  err = MICOStartCryptoWorker();
+  require_noerr_action( err, exit, app_log("ERROR: Unable to start the crypto worker.") );
+
   /*Bonjour for service searching*/
   if(inContext->flashContentInRam.micoSystemConfig.bonjourEnable == true)
     MICOStartBonjourService( Station, inContext );
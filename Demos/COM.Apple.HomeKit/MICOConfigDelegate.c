@@ -28,6 +28,7 @@
 
 #include "EasyLink/EasyLink.h"
 #include "JSON-C/json.h"
+#include "JSON-C/json_sax.h"
 #include "MICO.h"
 #include "MICODefine.h"
 #include "MICOAppDefine.h"
@@ -111,14 +112,15 @@ OSStatus ConfigELRecvAuthData(char * anthData, mico_Context_t * const inContext
   return kNoErr;
 }
 
-json_object* ConfigCreateReportJsonMessage( mico_Context_t * const inContext )
+static const int _baudrates[] = { 9600, 19200, 38400, 57600, 115200 };
+
+OSStatus ConfigCreateReportJsonMessage( struct json_writer *writer, mico_Context_t * const inContext )
 {
   OSStatus err = kNoErr;
   config_delegate_log_trace();
   char name[50], *tempString;
   OTA_Versions_t versions;
   char rfVersion[50];
-  json_object *sectors, *sector, *subMenuSectors, *subMenuSector, *mainObject = NULL;
 
   MicoGetRfVer( rfVersion, 50 );
 
@@ -137,96 +139,90 @@ json_object* ConfigCreateReportJsonMessage( mico_Context_t * const inContext )
   versions.protocol =  PROTOCOL;
   versions.rfVersion = NULL;
 
-  sectors = json_object_new_array();
-  require( sectors, exit );
-
-  err = MICOAddTopMenu(&mainObject, name, sectors, versions);
+  err = MICOStartTopMenu(writer, name);
   require_noerr(err, exit);
 
   /*Sector 1*/
-  sector = json_object_new_array();
-  require( sector, exit );
-  err = MICOAddSector(sectors, "MICO SYSTEM",    sector);
+  err = MICOStartSector(writer, "MICO SYSTEM");
   require_noerr(err, exit);
 
     /*name cell*/
-    err = MICOAddStringCellToSector(sector, "Device Name",    inContext->flashContentInRam.micoSystemConfig.name,               "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "Device Name",    inContext->flashContentInRam.micoSystemConfig.name,               "RW", NULL, 0);
     require_noerr(err, exit);
 
     //Bonjour switcher cell
-    err = MICOAddSwitchCellToSector(sector, "Bonjour",        inContext->flashContentInRam.micoSystemConfig.bonjourEnable,      "RW");
+    err = MICOAddSwitchCellToSector(writer, "Bonjour",        inContext->flashContentInRam.micoSystemConfig.bonjourEnable,      "RW");
     require_noerr(err, exit);
 
     //RF power save switcher cell
-    err = MICOAddSwitchCellToSector(sector, "RF power save",  inContext->flashContentInRam.micoSystemConfig.rfPowerSaveEnable,  "RW");
+    err = MICOAddSwitchCellToSector(writer, "RF power save",  inContext->flashContentInRam.micoSystemConfig.rfPowerSaveEnable,  "RW");
     require_noerr(err, exit);
 
     //MCU power save switcher cell
-    err = MICOAddSwitchCellToSector(sector, "MCU power save", inContext->flashContentInRam.micoSystemConfig.mcuPowerSaveEnable, "RW");
+    err = MICOAddSwitchCellToSector(writer, "MCU power save", inContext->flashContentInRam.micoSystemConfig.mcuPowerSaveEnable, "RW");
     require_noerr(err, exit);
 
     /*sub menu*/
-    subMenuSectors = json_object_new_array();
-    require( subMenuSectors, exit );
-    err = MICOAddMenuCellToSector(sector, "Detail", subMenuSectors);
+    err = MICOStartMenuCell(writer, "Detail");
     require_noerr(err, exit);
       
-      subMenuSector = json_object_new_array();
-      require( subMenuSector, exit );
-      err = MICOAddSector(subMenuSectors,  "",    subMenuSector);
+      err = MICOStartSector(writer, "");
       require_noerr(err, exit);
 
-        err = MICOAddStringCellToSector(subMenuSector, "Firmware Rev.",  FIRMWARE_REVISION, "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "Firmware Rev.",  FIRMWARE_REVISION, "RO", NULL, 0);
         require_noerr(err, exit);
-        err = MICOAddStringCellToSector(subMenuSector, "Hardware Rev.",  HARDWARE_REVISION, "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "Hardware Rev.",  HARDWARE_REVISION, "RO", NULL, 0);
         require_noerr(err, exit);
-        err = MICOAddStringCellToSector(subMenuSector, "MICO OS Rev.",   MicoGetVer(),      "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "MICO OS Rev.",   MicoGetVer(),      "RO", NULL, 0);
         require_noerr(err, exit);
-        err = MICOAddStringCellToSector(subMenuSector, "RF Driver Rev.", rfVersion,         "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "RF Driver Rev.", rfVersion,         "RO", NULL, 0);
         require_noerr(err, exit);
-        err = MICOAddStringCellToSector(subMenuSector, "Model",          MODEL,             "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "Model",          MODEL,             "RO", NULL, 0);
         require_noerr(err, exit);
-        err = MICOAddStringCellToSector(subMenuSector, "Manufacturer",   MANUFACTURER,      "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "Manufacturer",   MANUFACTURER,      "RO", NULL, 0);
         require_noerr(err, exit);
-        err = MICOAddStringCellToSector(subMenuSector, "Protocol",       PROTOCOL,          "RO", NULL);
+        err = MICOAddStringCellToSector(writer, "Protocol",       PROTOCOL,          "RO", NULL, 0);
         require_noerr(err, exit);
 
-      subMenuSector = json_object_new_array();
-      err = MICOAddSector(subMenuSectors,  "WLAN",    subMenuSector);
+      err = MICOEndSector(writer);
+      require_noerr(err, exit);
+
+      err = MICOStartSector(writer, "WLAN");
       require_noerr(err, exit);
       
         tempString = DataToHexStringWithColons( (uint8_t *)inContext->flashContentInRam.micoSystemConfig.bssid, 6 );
-        err = MICOAddStringCellToSector(subMenuSector, "BSSID",        tempString, "RO", NULL);
-        require_noerr(err, exit);
+        require_action(tempString, exit, err=kNoMemoryErr);
+        err = MICOAddStringCellToSector(writer, "BSSID",        tempString, "RO", NULL, 0);
         free(tempString);
+        require_noerr(err, exit);
 
-        err = MICOAddNumberCellToSector(subMenuSector, "Channel",      inContext->flashContentInRam.micoSystemConfig.channel, "RO", NULL);
+        err = MICOAddNumberCellToSector(writer, "Channel",      inContext->flashContentInRam.micoSystemConfig.channel, "RO", NULL, 0);
         require_noerr(err, exit);
 
         switch(inContext->flashContentInRam.micoSystemConfig.security){
           case SECURITY_TYPE_NONE:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "Open system", "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "Open system", "RO", NULL, 0); 
             break;
           case SECURITY_TYPE_WEP:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "WEP",         "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "WEP",         "RO", NULL, 0); 
             break;
           case SECURITY_TYPE_WPA_TKIP:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "WPA TKIP",    "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "WPA TKIP",    "RO", NULL, 0); 
             break;
           case SECURITY_TYPE_WPA_AES:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "WPA AES",     "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "WPA AES",     "RO", NULL, 0); 
             break;
           case SECURITY_TYPE_WPA2_TKIP:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "WPA2 TKIP",   "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "WPA2 TKIP",   "RO", NULL, 0); 
             break;
           case SECURITY_TYPE_WPA2_AES:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "WPA2 AES",    "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "WPA2 AES",    "RO", NULL, 0); 
             break;
           case SECURITY_TYPE_WPA2_MIXED:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "WPA2 MIXED",  "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "WPA2 MIXED",  "RO", NULL, 0); 
             break;
           default:
-            err = MICOAddStringCellToSector(subMenuSector, "Security",   "Auto",      "RO", NULL); 
+            err = MICOAddStringCellToSector(writer, "Security",   "Auto",      "RO", NULL, 0); 
             break;
         }
         require_noerr(err, exit); 
@@ -235,144 +231,217 @@ json_object* ConfigCreateReportJsonMessage( mico_Context_t * const inContext )
           tempString = calloc(maxKeyLen+1, 1);
           require_action(tempString, exit, err=kNoMemoryErr);
           memcpy(tempString, inContext->flashContentInRam.micoSystemConfig.key, maxKeyLen);
-          err = MICOAddStringCellToSector(subMenuSector, "PMK",          tempString, "RO", NULL);
-          require_noerr(err, exit);
+          err = MICOAddStringCellToSector(writer, "PMK",          tempString, "RO", NULL, 0);
           free(tempString);
+          require_noerr(err, exit);
         }
         else{
-          err = MICOAddStringCellToSector(subMenuSector, "KEY",          inContext->flashContentInRam.micoSystemConfig.user_key,  "RO", NULL);
+          err = MICOAddStringCellToSector(writer, "KEY",          inContext->flashContentInRam.micoSystemConfig.user_key,  "RO", NULL, 0);
           require_noerr(err, exit);
         }
 
+      err = MICOEndSector(writer);
+      require_noerr(err, exit);
+
+    err = MICOEndMenuCell(writer);
+    require_noerr(err, exit);
+
+  err = MICOEndSector(writer);
+  require_noerr(err, exit);
+
   /*Sector 3*/
-  sector = json_object_new_array();
-  require( sector, exit );
-  err = MICOAddSector(sectors, "WLAN",           sector);
+  err = MICOStartSector(writer, "WLAN");
   require_noerr(err, exit);
     /*SSID cell*/
-    err = MICOAddStringCellToSector(sector, "Wi-Fi",        inContext->flashContentInRam.micoSystemConfig.ssid,     "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "Wi-Fi",        inContext->flashContentInRam.micoSystemConfig.ssid,     "RW", NULL, 0);
     require_noerr(err, exit);
     /*PASSWORD cell*/
-    err = MICOAddStringCellToSector(sector, "Password",     inContext->flashContentInRam.micoSystemConfig.user_key, "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "Password",     inContext->flashContentInRam.micoSystemConfig.user_key, "RW", NULL, 0);
     require_noerr(err, exit);
     /*DHCP cell*/
-    err = MICOAddSwitchCellToSector(sector, "DHCP",        inContext->flashContentInRam.micoSystemConfig.dhcpEnable,   "RW");
+    err = MICOAddSwitchCellToSector(writer, "DHCP",        inContext->flashContentInRam.micoSystemConfig.dhcpEnable,   "RW");
     require_noerr(err, exit);
     /*Local cell*/
-    err = MICOAddStringCellToSector(sector, "IP address",  inContext->micoStatus.localIp,   "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "IP address",  inContext->micoStatus.localIp,   "RW", NULL, 0);
     require_noerr(err, exit);
     /*Netmask cell*/
-    err = MICOAddStringCellToSector(sector, "Net Mask",    inContext->micoStatus.netMask,   "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "Net Mask",    inContext->micoStatus.netMask,   "RW", NULL, 0);
     require_noerr(err, exit);
     /*Gateway cell*/
-    err = MICOAddStringCellToSector(sector, "Gateway",     inContext->micoStatus.gateWay,   "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "Gateway",     inContext->micoStatus.gateWay,   "RW", NULL, 0);
     require_noerr(err, exit);
     /*DNS server cell*/
-    err = MICOAddStringCellToSector(sector, "DNS Server",  inContext->micoStatus.dnsServer, "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "DNS Server",  inContext->micoStatus.dnsServer, "RW", NULL, 0);
     require_noerr(err, exit);
 
+  err = MICOEndSector(writer);
+  require_noerr(err, exit);
+
   /*Sector 4*/
-  sector = json_object_new_array();
-  require( sector, exit );
-  err = MICOAddSector(sectors, "SPP Remote Server",           sector);
+  err = MICOStartSector(writer, "SPP Remote Server");
   require_noerr(err, exit);
 
 
     // SPP protocol remote server connection enable
-    err = MICOAddSwitchCellToSector(sector, "Connect SPP Server",   inContext->flashContentInRam.appConfig.remoteServerEnable,   "RW");
+    err = MICOAddSwitchCellToSector(writer, "Connect SPP Server",   inContext->flashContentInRam.appConfig.remoteServerEnable,   "RW");
     require_noerr(err, exit);
 
     //Seerver address cell
-    err = MICOAddStringCellToSector(sector, "SPP Server",           inContext->flashContentInRam.appConfig.remoteServerDomain,   "RW", NULL);
+    err = MICOAddStringCellToSector(writer, "SPP Server",           inContext->flashContentInRam.appConfig.remoteServerDomain,   "RW", NULL, 0);
     require_noerr(err, exit);
 
     //Seerver port cell
-    err = MICOAddNumberCellToSector(sector, "SPP Server Port",      inContext->flashContentInRam.appConfig.remoteServerPort,   "RW", NULL);
+    err = MICOAddNumberCellToSector(writer, "SPP Server Port",      inContext->flashContentInRam.appConfig.remoteServerPort,   "RW", NULL, 0);
     require_noerr(err, exit);
 
+  err = MICOEndSector(writer);
+  require_noerr(err, exit);
+
   /*Sector 5*/
-  sector = json_object_new_array();
-  require( sector, exit );
-  err = MICOAddSector(sectors, "MCU IOs",            sector);
+  err = MICOStartSector(writer, "MCU IOs");
   require_noerr(err, exit);
 
     /*UART Baurdrate cell*/
-    json_object *selectArray;
-    selectArray = json_object_new_array();
-    require( selectArray, exit );
-    json_object_array_add(selectArray, json_object_new_int(9600));
-    json_object_array_add(selectArray, json_object_new_int(19200));
-    json_object_array_add(selectArray, json_object_new_int(38400));
-    json_object_array_add(selectArray, json_object_new_int(57600));
-    json_object_array_add(selectArray, json_object_new_int(115200));
-    err = MICOAddNumberCellToSector(sector, "Baurdrate", 115200, "RW", selectArray);
+    err = MICOAddNumberCellToSector(writer, "Baurdrate", 115200, "RW", _baudrates, sizeof(_baudrates)/sizeof(_baudrates[0]));
     require_noerr(err, exit);
 
-  mico_rtos_unlock_mutex(&inContext->flashContentInRam_mutex);
-  
+  err = MICOEndSector(writer);
+  require_noerr(err, exit);
+
+  err = MICOEndTopMenu(writer, versions);
+  require_noerr(err, exit);
+
 exit:
-  if(err != kNoErr && mainObject){
-    json_object_put(mainObject);
-    mainObject = NULL;
-  }
-  return mainObject;
+  mico_rtos_unlock_mutex(&inContext->flashContentInRam_mutex);
+  return err;
 }
 
-OSStatus ConfigIncommingJsonMessage( const char *input, mico_Context_t * const inContext )
+typedef enum {
+  CONFIG_KEY_DEVICE_NAME,
+  CONFIG_KEY_RF_POWER_SAVE,
+  CONFIG_KEY_MCU_POWER_SAVE,
+  CONFIG_KEY_BONJOUR,
+  CONFIG_KEY_WI_FI,
+  CONFIG_KEY_PASSWORD,
+  CONFIG_KEY_DHCP,
+  CONFIG_KEY_IP_ADDRESS,
+  CONFIG_KEY_NET_MASK,
+  CONFIG_KEY_GATEWAY,
+  CONFIG_KEY_DNS_SERVER,
+  CONFIG_KEY_CONNECT_SPP_SERVER,
+  CONFIG_KEY_SPP_SERVER,
+  CONFIG_KEY_SPP_SERVER_PORT,
+  CONFIG_KEY_BAURDRATE,
+  CONFIG_KEY_MAX
+} config_key_t;
+
+static const char * const config_key_names[CONFIG_KEY_MAX] = {
+  [CONFIG_KEY_DEVICE_NAME] = "Device Name",
+  [CONFIG_KEY_RF_POWER_SAVE] = "RF power save",
+  [CONFIG_KEY_MCU_POWER_SAVE] = "MCU power save",
+  [CONFIG_KEY_BONJOUR] = "Bonjour",
+  [CONFIG_KEY_WI_FI] = "Wi-Fi",
+  [CONFIG_KEY_PASSWORD] = "Password",
+  [CONFIG_KEY_DHCP] = "DHCP",
+  [CONFIG_KEY_IP_ADDRESS] = "IP address",
+  [CONFIG_KEY_NET_MASK] = "Net Mask",
+  [CONFIG_KEY_GATEWAY] = "Gateway",
+  [CONFIG_KEY_DNS_SERVER] = "DNS Server",
+  [CONFIG_KEY_CONNECT_SPP_SERVER] = "Connect SPP Server",
+  [CONFIG_KEY_SPP_SERVER] = "SPP Server",
+  [CONFIG_KEY_SPP_SERVER_PORT] = "SPP Server Port",
+  [CONFIG_KEY_BAURDRATE] = "Baurdrate",
+};
+
+static struct json_sax_keys config_keys;
+
+static void _ConfigIncommingJsonValue( void *userdata, const struct json_sax_value *value )
 {
-  OSStatus err = kNoErr;
-  json_object *new_obj;
-  config_delegate_log_trace();
-
-  new_obj = json_tokener_parse(input);
-  require_action(new_obj, exit, err = kUnknownErr);
-  config_delegate_log("Recv config object=%s", json_object_to_json_string(new_obj));
-  mico_rtos_lock_mutex(&inContext->flashContentInRam_mutex);
-  json_object_object_foreach(new_obj, key, val) {
-    if(!strcmp(key, "Device Name")){
-      strncpy(inContext->flashContentInRam.micoSystemConfig.name, json_object_get_string(val), maxNameLen);
-    }else if(!strcmp(key, "RF power save")){
-      inContext->flashContentInRam.micoSystemConfig.rfPowerSaveEnable = json_object_get_boolean(val);
-    }else if(!strcmp(key, "MCU power save")){
-      inContext->flashContentInRam.micoSystemConfig.mcuPowerSaveEnable = json_object_get_boolean(val);
-    }else if(!strcmp(key, "Bonjour")){
-      inContext->flashContentInRam.micoSystemConfig.bonjourEnable = json_object_get_boolean(val);
-    }else if(!strcmp(key, "Wi-Fi")){
-      strncpy(inContext->flashContentInRam.micoSystemConfig.ssid, json_object_get_string(val), maxSsidLen);
+  mico_Context_t * const inContext = userdata;
+
+  /* Only the members of the top level object are settings */
+  if( value->event != json_sax_event_value || value->depth != 1 )
+    return;
+
+  switch( json_sax_keys_find( &config_keys, value->key ) ){
+    case CONFIG_KEY_DEVICE_NAME:
+      strncpy(inContext->flashContentInRam.micoSystemConfig.name, json_sax_get_string(value), maxNameLen);
+      break;
+    case CONFIG_KEY_RF_POWER_SAVE:
+      inContext->flashContentInRam.micoSystemConfig.rfPowerSaveEnable = json_sax_get_boolean(value);
+      break;
+    case CONFIG_KEY_MCU_POWER_SAVE:
+      inContext->flashContentInRam.micoSystemConfig.mcuPowerSaveEnable = json_sax_get_boolean(value);
+      break;
+    case CONFIG_KEY_BONJOUR:
+      inContext->flashContentInRam.micoSystemConfig.bonjourEnable = json_sax_get_boolean(value);
+      break;
+    case CONFIG_KEY_WI_FI:
+      strncpy(inContext->flashContentInRam.micoSystemConfig.ssid, json_sax_get_string(value), maxSsidLen);
       inContext->flashContentInRam.micoSystemConfig.channel = 0;
       memset(inContext->flashContentInRam.micoSystemConfig.bssid, 0x0, 6);
       inContext->flashContentInRam.micoSystemConfig.security = SECURITY_TYPE_AUTO;
       memcpy(inContext->flashContentInRam.micoSystemConfig.key, inContext->flashContentInRam.micoSystemConfig.user_key, maxKeyLen);
       inContext->flashContentInRam.micoSystemConfig.keyLength = inContext->flashContentInRam.micoSystemConfig.user_keyLength;
-    }else if(!strcmp(key, "Password")){
+      break;
+    case CONFIG_KEY_PASSWORD:
       inContext->flashContentInRam.micoSystemConfig.security = SECURITY_TYPE_AUTO;
-      strncpy(inContext->flashContentInRam.micoSystemConfig.key, json_object_get_string(val), maxKeyLen);
-      strncpy(inContext->flashContentInRam.micoSystemConfig.user_key, json_object_get_string(val), maxKeyLen);
+      strncpy(inContext->flashContentInRam.micoSystemConfig.key, json_sax_get_string(value), maxKeyLen);
+      strncpy(inContext->flashContentInRam.micoSystemConfig.user_key, json_sax_get_string(value), maxKeyLen);
       inContext->flashContentInRam.micoSystemConfig.keyLength = strlen(inContext->flashContentInRam.micoSystemConfig.key);
       inContext->flashContentInRam.micoSystemConfig.user_keyLength = strlen(inContext->flashContentInRam.micoSystemConfig.key);
-    }else if(!strcmp(key, "DHCP")){
-      inContext->flashContentInRam.micoSystemConfig.dhcpEnable   = json_object_get_boolean(val);
-    }else if(!strcmp(key, "IP address")){
-      strncpy(inContext->flashContentInRam.micoSystemConfig.localIp, json_object_get_string(val), maxIpLen);
-    }else if(!strcmp(key, "Net Mask")){
-      strncpy(inContext->flashContentInRam.micoSystemConfig.netMask, json_object_get_string(val), maxIpLen);
-    }else if(!strcmp(key, "Gateway")){
-      strncpy(inContext->flashContentInRam.micoSystemConfig.gateWay, json_object_get_string(val), maxIpLen);
-    }else if(!strcmp(key, "DNS Server")){
-      strncpy(inContext->flashContentInRam.micoSystemConfig.dnsServer, json_object_get_string(val), maxIpLen);
-    }else if(!strcmp(key, "Connect SPP Server")){
-      inContext->flashContentInRam.appConfig.remoteServerEnable = json_object_get_boolean(val);
-    }else if(!strcmp(key, "SPP Server")){
-      strncpy(inContext->flashContentInRam.appConfig.remoteServerDomain, json_object_get_string(val), 64);
-    }else if(!strcmp(key, "SPP Server Port")){
-      inContext->flashContentInRam.appConfig.remoteServerPort = json_object_get_int(val);
-    }else if(!strcmp(key, "Baurdrate")){
-      inContext->flashContentInRam.appConfig.USART_BaudRate = json_object_get_int(val);
-    }
+      break;
+    case CONFIG_KEY_DHCP:
+      inContext->flashContentInRam.micoSystemConfig.dhcpEnable   = json_sax_get_boolean(value);
+      break;
+    case CONFIG_KEY_IP_ADDRESS:
+      strncpy(inContext->flashContentInRam.micoSystemConfig.localIp, json_sax_get_string(value), maxIpLen);
+      break;
+    case CONFIG_KEY_NET_MASK:
+      strncpy(inContext->flashContentInRam.micoSystemConfig.netMask, json_sax_get_string(value), maxIpLen);
+      break;
+    case CONFIG_KEY_GATEWAY:
+      strncpy(inContext->flashContentInRam.micoSystemConfig.gateWay, json_sax_get_string(value), maxIpLen);
+      break;
+    case CONFIG_KEY_DNS_SERVER:
+      strncpy(inContext->flashContentInRam.micoSystemConfig.dnsServer, json_sax_get_string(value), maxIpLen);
+      break;
+    case CONFIG_KEY_CONNECT_SPP_SERVER:
+      inContext->flashContentInRam.appConfig.remoteServerEnable = json_sax_get_boolean(value);
+      break;
+    case CONFIG_KEY_SPP_SERVER:
+      strncpy(inContext->flashContentInRam.appConfig.remoteServerDomain, json_sax_get_string(value), 64);
+      break;
+    case CONFIG_KEY_SPP_SERVER_PORT:
+      inContext->flashContentInRam.appConfig.remoteServerPort = json_sax_get_int(value);
+      break;
+    case CONFIG_KEY_BAURDRATE:
+      inContext->flashContentInRam.appConfig.USART_BaudRate = json_sax_get_int(value);
+      break;
+    default:
+      break;
   }
-  json_object_put(new_obj);
+}
+
+OSStatus ConfigIncommingJsonMessage( const char *input, mico_Context_t * const inContext )
+{
+  OSStatus err = kNoErr;
+  struct json_sax *sax = NULL;
+  config_delegate_log_trace();
+
+  if( config_keys.count == 0 )
+    json_sax_keys_init( &config_keys, config_key_names, CONFIG_KEY_MAX );
+  sax = malloc( sizeof(struct json_sax) );
+  require_action( sax, exit, err = kNoMemoryErr );
+
+  /* Check the whole message first, a broken one must not change anything */
+  require_action( json_sax_parse( sax, input, -1, NULL, NULL ) == json_tokener_success, exit, err = kUnknownErr );
+  config_delegate_log("Recv config object=%s", input);
+  mico_rtos_lock_mutex(&inContext->flashContentInRam_mutex);
+  json_sax_parse( sax, input, -1, _ConfigIncommingJsonValue, inContext );
   mico_rtos_unlock_mutex(&inContext->flashContentInRam_mutex);
 
 exit:
+  if( sax ) free( sax );
   return err; 
 }
\ No newline at end of file
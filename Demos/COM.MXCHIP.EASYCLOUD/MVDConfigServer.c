@@ -36,6 +36,7 @@
 
 #include "EasyCloudUtils.h"
 #include "MicoVirtualDevice.h"
+#include "MICOConfigMenu.h"
 
 
 #define config_log(M, ...) custom_log("CONFIG SERVER", M, ##__VA_ARGS__)
@@ -48,6 +49,9 @@
 #define kCONFIGURLWrite   "/config-write"
 #define kCONFIGURLOTA     "/OTA"
 
+/* The report is written to the socket in pieces of this size */
+#define kConfigReportChunkSize  512
+
 //for temp config by WES at 20141123
 #define kCONFIGURLDevState             "/dev-state"
 #define kCONFIGURLDevActivate          "/dev-activate"
@@ -56,7 +60,7 @@
 #define kCONFIGURLDevFWUpdate          "/dev-fw_update"
 
 extern OSStatus     ConfigIncommingJsonMessage( const char *input, mico_Context_t * const inContext );
-extern json_object* ConfigCreateReportJsonMessage( mico_Context_t * const inContext );
+extern OSStatus     ConfigCreateReportJsonMessage( struct json_writer *writer, mico_Context_t * const inContext );
 extern OSStatus getMVDActivateRequestData(const char *input, MVDActivateRequestData_t *activateData);
 extern OSStatus getMVDAuthorizeRequestData(const char *input, MVDAuthorizeRequestData_t *authorizeData);
 extern OSStatus getMVDResetRequestData(const char *input, MVDResetRequestData_t *devResetData);
@@ -67,6 +71,7 @@ static void localConfiglistener_thread(void *inContext);
 static void localConfig_thread(void *inFd);
 static mico_Context_t *Context;
 static OSStatus _LocalConfigRespondInComingMessage(int fd, ECS_HTTPHeader_t* inHeader, mico_Context_t * const inContext);
+static OSStatus _LocalConfigSendReport(int fd, mico_Context_t * const inContext);
 
 OSStatus MICOStartConfigServer ( mico_Context_t * const inContext )
 {
@@ -237,20 +242,11 @@ OSStatus _LocalConfigRespondInComingMessage(int fd, ECS_HTTPHeader_t* inHeader,
 
   //config_log("recv=%s", inHeader->buf);
   if(ECS_HTTPHeaderMatchURL( inHeader, kCONFIGURLRead ) == kNoErr){    
-    report = ConfigCreateReportJsonMessage( inContext );
-    require( report, exit );
-    json_str = json_object_to_json_string(report);
-    require_action( json_str, exit, err = kNoMemoryErr );
-    config_log("Send config object=%s", json_str);
-    err =  ECS_CreateSimpleHTTPMessageNoCopy( ECS_kMIMEType_JSON, strlen(json_str), &httpResponse, &httpResponseLen );
-    require_noerr( err, exit );
-    require( httpResponse, exit );
-    err = SocketSend( fd, httpResponse, httpResponseLen );
-    require_noerr( err, exit );
-    err = SocketSend( fd, (uint8_t *)json_str, strlen(json_str) );
+    err = _LocalConfigSendReport( fd, inContext );
+    /* Part of the report may be out already, no failed message can follow it */
+    SocketClose(&fd);
     require_noerr( err, exit );
     config_log("Current configuration sent");
-    SocketClose(&fd);
     err = kConnectionErr; //Return an err to close the current thread
     goto exit;
   }
@@ -463,3 +459,57 @@ exit:
 
   return err;
 }
+
+typedef struct _configReportSend_t{
+  int fd;
+  int len;
+} configReportSend_t;
+
+static int _ConfigReportSend(void *userdata, const char *buf, int len)
+{
+  configReportSend_t *send = (configReportSend_t *)userdata;
+
+  if( SocketSend( send->fd, (const uint8_t *)buf, len ) != kNoErr )
+    return -1;
+  send->len += len;
+  return 0;
+}
+
+static OSStatus _LocalConfigSendReport(int fd, mico_Context_t * const inContext)
+{
+  OSStatus err = kNoErr;
+  struct json_writer writer;
+  char *reportBuf = NULL;
+  int reportLen = 0;
+  configReportSend_t send = { fd, 0 };
+  uint8_t *httpResponse = NULL;
+  size_t httpResponseLen = 0;
+
+  reportBuf = malloc( kConfigReportChunkSize );
+  require_action( reportBuf, exit, err = kNoMemoryErr );
+
+  /* The first pass only measures the report for the Content-Length, the
+     second writes it to the socket while it is built */
+  json_writer_init( &writer, reportBuf, kConfigReportChunkSize, MICOConfigReportLength, &reportLen );
+  err = ConfigCreateReportJsonMessage( &writer, inContext );
+  require_noerr( err, exit );
+  require_action( json_writer_finish( &writer ) == 0, exit, err = kWriteErr );
+
+  err =  ECS_CreateSimpleHTTPMessageNoCopy( ECS_kMIMEType_JSON, reportLen, &httpResponse, &httpResponseLen );
+  require_noerr( err, exit );
+  require_action( httpResponse, exit, err = kNoMemoryErr );
+  err = SocketSend( fd, httpResponse, httpResponseLen );
+  require_noerr( err, exit );
+
+  json_writer_init( &writer, reportBuf, kConfigReportChunkSize, _ConfigReportSend, &send );
+  err = ConfigCreateReportJsonMessage( &writer, inContext );
+  require_noerr( err, exit );
+  require_action( json_writer_finish( &writer ) == 0, exit, err = kWriteErr );
+  /* The configuration changed between the passes */
+  require_action( send.len == reportLen, exit, err = kWriteErr );
+
+exit:
+  if(httpResponse) free(httpResponse);
+  if(reportBuf)    free(reportBuf);
+  return err;
+}
@@ -6,6 +6,7 @@
 #include "MicoPlatform.h"
 #include "platform_common_config.h"
 #include "MICONotificationCenter.h"
+#include "SHAUtils.h"
 #include <stdio.h>
 
 #define ha_log(M, ...) custom_log("HA Command", M, ##__VA_ARGS__)
@@ -205,7 +206,6 @@ OSStatus _ota_process(uint8_t *inBuf, int inBufLen, int *inSocketFd, mico_Contex
   mxchip_cmd_head_t cmd_ack;
   fd_set readfds;
   struct timeval_t t;
-  md5_context ctx;
 
   memset(&cmd_ack, 0, sizeof(cmd_ack));
   cmd_ack.cmd_status = CMD_FAIL;
@@ -243,11 +243,9 @@ OSStatus _ota_process(uint8_t *inBuf, int inBufLen, int *inSocketFd, mico_Contex
   }
 
 
-  InitMd5( &ctx );
-  Md5Update( &ctx, (uint8_t *)UPDATE_START_ADDRESS, flash_addr - UPDATE_START_ADDRESS);
-  Md5Final( &ctx, md5_ret );
+  err = Hash_Data( kHashType_MD5, (uint8_t *)UPDATE_START_ADDRESS, flash_addr - UPDATE_START_ADDRESS, md5_ret );
 
-  if(memcmp(md5_ret, p_upgrade->md5, 16) != 0) {
+  if(err != kNoErr || memcmp(md5_ret, p_upgrade->md5, 16) != 0) {
     MicoFlashFinalize(MICO_FLASH_FOR_UPDATE);
     goto CMD_REPLY;
   }
@@ -4,12 +4,11 @@
 #include "HaProtocol.h"
 #include "SocketUtils.h"
 #include "MICONotificationCenter.h"
+#include "MICOConnectionManager.h"
 
 #define client_log(M, ...) custom_log("TCP client", M, ##__VA_ARGS__)
 #define client_log_trace() custom_log_trace("TCP client")
 
-#define CLOUD_RETRY  1
-
 static bool _wifiConnected = false;
 static mico_semaphore_t  _wifiConnected_sem = NULL;
 
@@ -39,8 +38,8 @@ void remoteTcpClient_thread(void *inContext)
   mico_Context_t *Context = inContext;
   struct sockaddr_t addr;
   fd_set readfds;
-  char ipstr[16];
   struct timeval_t t;
+  mico_connection_t remoteConnection;
   int currentRecved = 0;
   int remoteTcpClient_loopBack_fd = -1;
   int remoteTcpClient_fd = -1;
@@ -66,6 +65,10 @@ void remoteTcpClient_thread(void *inContext)
   addr.s_port = REMOTE_TCP_CLIENT_LOOPBACK_PORT;
   err = bind( remoteTcpClient_loopBack_fd, &addr, sizeof(addr) );
   require_noerr( err, exit );
+
+  err = MICOConnectionInit(&remoteConnection, Context->flashContentInRam.appConfig.remoteServerDomain,
+                           Context->flashContentInRam.appConfig.remoteServerPort);
+  require_noerr( err, exit );
   
   t.tv_sec = 4;
   t.tv_usec = 0;
@@ -75,15 +78,9 @@ void remoteTcpClient_thread(void *inContext)
       if(_wifiConnected == false){
         require_action_quiet(mico_rtos_get_semaphore(&_wifiConnected_sem, 200000) == kNoErr, Continue, err = kTimeoutErr);
       }
-      err = gethostbyname((char *)Context->flashContentInRam.appConfig.remoteServerDomain, (uint8_t *)ipstr, 16);
-      require_noerr(err, ReConnWithDelay);
-      
-      remoteTcpClient_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-      addr.s_ip = inet_addr(ipstr); 
-      addr.s_port = Context->flashContentInRam.appConfig.remoteServerPort;
-      
-      err = connect(remoteTcpClient_fd, &addr, sizeof(addr));
-      require_noerr_quiet(err, ReConnWithDelay);
+      /* Backs off by itself after a failed connect */
+      remoteTcpClient_fd = MICOConnectionOpen(&remoteConnection);
+      require_action_quiet(remoteTcpClient_fd >= 0, Continue, err = kConnectionErr);
       
       set_network_state(REMOTE_CONNECT, 1);
       client_log("Remote server connected at port: %d, fd: %d",  Context->flashContentInRam.appConfig.remoteServerPort,
@@ -120,7 +117,7 @@ void remoteTcpClient_thread(void *inContext)
       if(remoteTcpClient_fd != -1){
         SocketClose(&remoteTcpClient_fd);
       }
-      sleep(CLOUD_RETRY);
+      MICOConnectionClosed(&remoteConnection, true);
     }
   }
 exit:
@@ -19,7 +19,7 @@
   ******************************************************************************
   */ 
 
-#include "MicoDefine.h"
+#include "MICODefine.h"
 #include "platform_config.h"
 #include "MICONotificationCenter.h"
 
@@ -24,12 +24,11 @@
 #include "SppProtocol.h"
 #include "SocketUtils.h"
 #include "MICONotificationCenter.h"
+#include "MICOConnectionManager.h"
 
 #define client_log(M, ...) custom_log("TCP client", M, ##__VA_ARGS__)
 #define client_log_trace() custom_log_trace("TCP client")
 
-#define CLOUD_RETRY  1
-
 static bool _wifiConnected = false;
 static mico_semaphore_t  _wifiConnected_sem = NULL;
 
@@ -57,11 +56,10 @@ void remoteTcpClient_thread(void *inContext)
   OSStatus err = kUnknownErr;
   int len;
   mico_Context_t *Context = inContext;
-  struct sockaddr_t addr;
   fd_set readfds;
   fd_set writeSet;
-  char ipstr[16];
   struct timeval_t t;
+  mico_connection_t remoteConnection;
   int remoteTcpClient_fd = -1;
   uint8_t *inDataBuffer = NULL;
   int eventFd = -1;
@@ -77,6 +75,10 @@ void remoteTcpClient_thread(void *inContext)
   
   inDataBuffer = malloc(wlanBufferLen);
   require_action(inDataBuffer, exit, err = kNoMemoryErr);
+
+  err = MICOConnectionInit(&remoteConnection, Context->flashContentInRam.appConfig.remoteServerDomain,
+                           Context->flashContentInRam.appConfig.remoteServerPort);
+  require_noerr( err, exit );
   
   
   while(1) {
@@ -84,15 +86,9 @@ void remoteTcpClient_thread(void *inContext)
       if(_wifiConnected == false){
         require_action_quiet(mico_rtos_get_semaphore(&_wifiConnected_sem, 200000) == kNoErr, Continue, err = kTimeoutErr);
       }
-      err = gethostbyname((char *)Context->flashContentInRam.appConfig.remoteServerDomain, (uint8_t *)ipstr, 16);
-      require_noerr(err, ReConnWithDelay);
-      
-      remoteTcpClient_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-      addr.s_ip = inet_addr(ipstr); 
-      addr.s_port = Context->flashContentInRam.appConfig.remoteServerPort;
-      
-      err = connect(remoteTcpClient_fd, &addr, sizeof(addr));
-      require_noerr_quiet(err, ReConnWithDelay);
+      /* Backs off by itself after a failed connect */
+      remoteTcpClient_fd = MICOConnectionOpen(&remoteConnection);
+      require_action_quiet(remoteTcpClient_fd >= 0, Continue, err = kConnectionErr);
       client_log("Remote server connected at port: %d, fd: %d",  Context->flashContentInRam.appConfig.remoteServerPort,
                  remoteTcpClient_fd);
       
@@ -153,7 +149,7 @@ void remoteTcpClient_thread(void *inContext)
         if(remoteTcpClient_fd != -1){
           SocketClose(&remoteTcpClient_fd);
         }
-        sleep(CLOUD_RETRY);
+        MICOConnectionClosed(&remoteConnection, true);
     }
   }
     
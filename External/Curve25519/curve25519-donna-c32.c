@@ -0,0 +1,454 @@
+/* Curve25519 field arithmetic for 32-bit CPUs.
+ *
+ * Included by curve25519-donna.c when CURVE25519_C32 is set, which it is by
+ * default on 32-bit targets. Same public function, same results.
+ *
+ * Field elements are ten signed 32-bit limbs, alternately 26 and 25 bits
+ * wide (radix 2^25.5), as in the ref10 code by Daniel J. Bernstein, Niels
+ * Duif, Tanja Lange, Peter Schwabe and Bo-Yin Yang (public domain):
+ *
+ *   x[0] + 2^26*x[1] + 2^51*x[2] + 2^77*x[3] + ... + 2^230*x[9]
+ *
+ * The portable donna code keeps the limbs in 64-bit variables and builds a
+ * 19 limb product before reducing it, with the temporaries on the heap. Here
+ * a product is 100 32x32->64 multiplies (55 for a square, which the
+ * Cortex-M3/M4 do in one SMULL/SMLAL each) with the factor of 19 folded into
+ * the operands up front, so the reduction is a single pass of carries and
+ * everything lives on the stack.
+ *
+ * There are no secret dependent branches or table lookups: the ladder swaps
+ * with masks and every step runs the same instructions for any scalar.
+ */
+
+#if( defined( _KERNEL ) || defined( __KERNEL__ ) )
+	#include <sys/systm.h>
+	#include <sys/types.h>
+#else
+	#include <stdint.h>
+	#include <string.h>
+#endif
+
+typedef uint8_t u8;
+typedef int32_t s32;
+
+typedef s32 fe[10];
+
+/* Bounds: the outputs of fe_mul, fe_sq, fe_mul121666 and fe_frombytes have
+ * |x[i]| <= 1.01 * 2^25 (even i) or 2^24 (odd i). fe_add and fe_sub don't
+ * carry, so their outputs are up to twice that, which is what fe_mul and
+ * fe_sq accept. Every fe_add/fe_sub output in the ladder goes straight into
+ * a multiply. */
+
+static void
+fe_0(fe h) {
+  memset(h, 0, sizeof(fe));
+}
+
+static void
+fe_1(fe h) {
+  memset(h, 0, sizeof(fe));
+  h[0] = 1;
+}
+
+static void
+fe_copy(fe h, const fe f) {
+  memcpy(h, f, sizeof(fe));
+}
+
+/* h = f + g */
+static void
+fe_add(fe h, const fe f, const fe g) {
+  unsigned i;
+  for (i = 0; i < 10; ++i) {
+    h[i] = f[i] + g[i];
+  }
+}
+
+/* h = f - g */
+static void
+fe_sub(fe h, const fe f, const fe g) {
+  unsigned i;
+  for (i = 0; i < 10; ++i) {
+    h[i] = f[i] - g[i];
+  }
+}
+
+/* Swap f and g if b is 1, leave them alone if b is 0, in constant time. */
+static void
+fe_cswap(fe f, fe g, s32 b) {
+  unsigned i;
+  const s32 mask = -b;
+  for (i = 0; i < 10; ++i) {
+    const s32 x = mask & (f[i] ^ g[i]);
+    f[i] ^= x;
+    g[i] ^= x;
+  }
+}
+
+/* h = f * g
+ *
+ * A limb product f[i] * g[j] lands at 2^(25.5 * (i + j)) rounded up to a
+ * limb boundary, so it needs an extra factor of 2 when both i and j are
+ * odd. Products at or past 2^255 wrap around multiplied by 19 since
+ * 2^255 = 19 mod p. Both factors are applied to the 32-bit operands before
+ * the multiply. h may alias f or g. */
+static void
+fe_mul(fe h, const fe f, const fe g) {
+  s32 f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  s32 f5 = f[5], f6 = f[6], f7 = f[7], f8 = f[8], f9 = f[9];
+  s32 g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  s32 g5 = g[5], g6 = g[6], g7 = g[7], g8 = g[8], g9 = g[9];
+  s32 g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4, g5_19 = 19 * g5;
+  s32 g6_19 = 19 * g6, g7_19 = 19 * g7, g8_19 = 19 * g8, g9_19 = 19 * g9;
+  s32 f1_2 = 2 * f1, f3_2 = 2 * f3, f5_2 = 2 * f5, f7_2 = 2 * f7, f9_2 = 2 * f9;
+  int64_t h0 = f0 * (int64_t) g0 + f1_2 * (int64_t) g9_19 + f2 * (int64_t) g8_19 + f3_2 * (int64_t) g7_19 +
+               f4 * (int64_t) g6_19 + f5_2 * (int64_t) g5_19 + f6 * (int64_t) g4_19 + f7_2 * (int64_t) g3_19 +
+               f8 * (int64_t) g2_19 + f9_2 * (int64_t) g1_19;
+  int64_t h1 = f0 * (int64_t) g1 + f1 * (int64_t) g0 + f2 * (int64_t) g9_19 + f3 * (int64_t) g8_19 +
+               f4 * (int64_t) g7_19 + f5 * (int64_t) g6_19 + f6 * (int64_t) g5_19 + f7 * (int64_t) g4_19 +
+               f8 * (int64_t) g3_19 + f9 * (int64_t) g2_19;
+  int64_t h2 = f0 * (int64_t) g2 + f1_2 * (int64_t) g1 + f2 * (int64_t) g0 + f3_2 * (int64_t) g9_19 +
+               f4 * (int64_t) g8_19 + f5_2 * (int64_t) g7_19 + f6 * (int64_t) g6_19 + f7_2 * (int64_t) g5_19 +
+               f8 * (int64_t) g4_19 + f9_2 * (int64_t) g3_19;
+  int64_t h3 = f0 * (int64_t) g3 + f1 * (int64_t) g2 + f2 * (int64_t) g1 + f3 * (int64_t) g0 +
+               f4 * (int64_t) g9_19 + f5 * (int64_t) g8_19 + f6 * (int64_t) g7_19 + f7 * (int64_t) g6_19 +
+               f8 * (int64_t) g5_19 + f9 * (int64_t) g4_19;
+  int64_t h4 = f0 * (int64_t) g4 + f1_2 * (int64_t) g3 + f2 * (int64_t) g2 + f3_2 * (int64_t) g1 +
+               f4 * (int64_t) g0 + f5_2 * (int64_t) g9_19 + f6 * (int64_t) g8_19 + f7_2 * (int64_t) g7_19 +
+               f8 * (int64_t) g6_19 + f9_2 * (int64_t) g5_19;
+  int64_t h5 = f0 * (int64_t) g5 + f1 * (int64_t) g4 + f2 * (int64_t) g3 + f3 * (int64_t) g2 +
+               f4 * (int64_t) g1 + f5 * (int64_t) g0 + f6 * (int64_t) g9_19 + f7 * (int64_t) g8_19 +
+               f8 * (int64_t) g7_19 + f9 * (int64_t) g6_19;
+  int64_t h6 = f0 * (int64_t) g6 + f1_2 * (int64_t) g5 + f2 * (int64_t) g4 + f3_2 * (int64_t) g3 +
+               f4 * (int64_t) g2 + f5_2 * (int64_t) g1 + f6 * (int64_t) g0 + f7_2 * (int64_t) g9_19 +
+               f8 * (int64_t) g8_19 + f9_2 * (int64_t) g7_19;
+  int64_t h7 = f0 * (int64_t) g7 + f1 * (int64_t) g6 + f2 * (int64_t) g5 + f3 * (int64_t) g4 +
+               f4 * (int64_t) g3 + f5 * (int64_t) g2 + f6 * (int64_t) g1 + f7 * (int64_t) g0 +
+               f8 * (int64_t) g9_19 + f9 * (int64_t) g8_19;
+  int64_t h8 = f0 * (int64_t) g8 + f1_2 * (int64_t) g7 + f2 * (int64_t) g6 + f3_2 * (int64_t) g5 +
+               f4 * (int64_t) g4 + f5_2 * (int64_t) g3 + f6 * (int64_t) g2 + f7_2 * (int64_t) g1 +
+               f8 * (int64_t) g0 + f9_2 * (int64_t) g9_19;
+  int64_t h9 = f0 * (int64_t) g9 + f1 * (int64_t) g8 + f2 * (int64_t) g7 + f3 * (int64_t) g6 +
+               f4 * (int64_t) g5 + f5 * (int64_t) g4 + f6 * (int64_t) g3 + f7 * (int64_t) g2 +
+               f8 * (int64_t) g1 + f9 * (int64_t) g0;
+  int64_t carry0, carry1, carry2, carry3, carry4, carry5, carry6, carry7, carry8, carry9;
+
+  /* Two carry chains, 0->1->2->3->4 and 4->5->...->9->0, interleaved so
+   * they can overlap. Afterwards |h[i]| is at most 2^25 (even i) or 2^24
+   * (odd i), plus a little slack in h[1] and h[5]. */
+  carry0 = (h0 + (int64_t) (1 << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+  carry4 = (h4 + (int64_t) (1 << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry1 = (h1 + (int64_t) (1 << 24)) >> 25; h2 += carry1; h1 -= carry1 << 25;
+  carry5 = (h5 + (int64_t) (1 << 24)) >> 25; h6 += carry5; h5 -= carry5 << 25;
+  carry2 = (h2 + (int64_t) (1 << 25)) >> 26; h3 += carry2; h2 -= carry2 << 26;
+  carry6 = (h6 + (int64_t) (1 << 25)) >> 26; h7 += carry6; h6 -= carry6 << 26;
+  carry3 = (h3 + (int64_t) (1 << 24)) >> 25; h4 += carry3; h3 -= carry3 << 25;
+  carry7 = (h7 + (int64_t) (1 << 24)) >> 25; h8 += carry7; h7 -= carry7 << 25;
+  carry4 = (h4 + (int64_t) (1 << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry8 = (h8 + (int64_t) (1 << 25)) >> 26; h9 += carry8; h8 -= carry8 << 26;
+  carry9 = (h9 + (int64_t) (1 << 24)) >> 25; h0 += carry9 * 19; h9 -= carry9 << 25;
+  carry0 = (h0 + (int64_t) (1 << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+
+  h[0] = (s32) h0; h[1] = (s32) h1; h[2] = (s32) h2; h[3] = (s32) h3; h[4] = (s32) h4;
+  h[5] = (s32) h5; h[6] = (s32) h6; h[7] = (s32) h7; h[8] = (s32) h8; h[9] = (s32) h9;
+}
+
+/* h = f * f, the same as fe_mul(h, f, f) with the symmetric products
+ * merged. h may alias f. */
+static void
+fe_sq(fe h, const fe f) {
+  s32 f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  s32 f5 = f[5], f6 = f[6], f7 = f[7], f8 = f[8], f9 = f[9];
+  s32 f0_2 = 2 * f0, f1_2 = 2 * f1, f2_2 = 2 * f2, f3_2 = 2 * f3, f4_2 = 2 * f4;
+  s32 f5_2 = 2 * f5, f6_2 = 2 * f6, f7_2 = 2 * f7, f8_2 = 2 * f8;
+  s32 f6_19 = 19 * f6, f7_19 = 19 * f7, f8_19 = 19 * f8, f9_19 = 19 * f9;
+  s32 f5_38 = 38 * f5, f7_38 = 38 * f7, f9_38 = 38 * f9;
+  int64_t h0 = f0 * (int64_t) f0 + f1_2 * (int64_t) f9_38 + f2_2 * (int64_t) f8_19 + f3_2 * (int64_t) f7_38 +
+               f4_2 * (int64_t) f6_19 + f5 * (int64_t) f5_38;
+  int64_t h1 = f0_2 * (int64_t) f1 + f2_2 * (int64_t) f9_19 + f3_2 * (int64_t) f8_19 + f4_2 * (int64_t) f7_19 +
+               f5_2 * (int64_t) f6_19;
+  int64_t h2 = f0_2 * (int64_t) f2 + f1 * (int64_t) f1_2 + f3_2 * (int64_t) f9_38 + f4_2 * (int64_t) f8_19 +
+               f5_2 * (int64_t) f7_38 + f6 * (int64_t) f6_19;
+  int64_t h3 = f0_2 * (int64_t) f3 + f1_2 * (int64_t) f2 + f4_2 * (int64_t) f9_19 + f5_2 * (int64_t) f8_19 +
+               f6_2 * (int64_t) f7_19;
+  int64_t h4 = f0_2 * (int64_t) f4 + f1_2 * (int64_t) f3_2 + f2 * (int64_t) f2 + f5_2 * (int64_t) f9_38 +
+               f6_2 * (int64_t) f8_19 + f7 * (int64_t) f7_38;
+  int64_t h5 = f0_2 * (int64_t) f5 + f1_2 * (int64_t) f4 + f2_2 * (int64_t) f3 + f6_2 * (int64_t) f9_19 +
+               f7_2 * (int64_t) f8_19;
+  int64_t h6 = f0_2 * (int64_t) f6 + f1_2 * (int64_t) f5_2 + f2_2 * (int64_t) f4 + f3 * (int64_t) f3_2 +
+               f7_2 * (int64_t) f9_38 + f8 * (int64_t) f8_19;
+  int64_t h7 = f0_2 * (int64_t) f7 + f1_2 * (int64_t) f6 + f2_2 * (int64_t) f5 + f3_2 * (int64_t) f4 +
+               f8_2 * (int64_t) f9_19;
+  int64_t h8 = f0_2 * (int64_t) f8 + f1_2 * (int64_t) f7_2 + f2_2 * (int64_t) f6 + f3_2 * (int64_t) f5_2 +
+               f4 * (int64_t) f4 + f9 * (int64_t) f9_38;
+  int64_t h9 = f0_2 * (int64_t) f9 + f1_2 * (int64_t) f8 + f2_2 * (int64_t) f7 + f3_2 * (int64_t) f6 +
+               f4_2 * (int64_t) f5;
+  int64_t carry0, carry1, carry2, carry3, carry4, carry5, carry6, carry7, carry8, carry9;
+
+  carry0 = (h0 + (int64_t) (1 << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+  carry4 = (h4 + (int64_t) (1 << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry1 = (h1 + (int64_t) (1 << 24)) >> 25; h2 += carry1; h1 -= carry1 << 25;
+  carry5 = (h5 + (int64_t) (1 << 24)) >> 25; h6 += carry5; h5 -= carry5 << 25;
+  carry2 = (h2 + (int64_t) (1 << 25)) >> 26; h3 += carry2; h2 -= carry2 << 26;
+  carry6 = (h6 + (int64_t) (1 << 25)) >> 26; h7 += carry6; h6 -= carry6 << 26;
+  carry3 = (h3 + (int64_t) (1 << 24)) >> 25; h4 += carry3; h3 -= carry3 << 25;
+  carry7 = (h7 + (int64_t) (1 << 24)) >> 25; h8 += carry7; h7 -= carry7 << 25;
+  carry4 = (h4 + (int64_t) (1 << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry8 = (h8 + (int64_t) (1 << 25)) >> 26; h9 += carry8; h8 -= carry8 << 26;
+  carry9 = (h9 + (int64_t) (1 << 24)) >> 25; h0 += carry9 * 19; h9 -= carry9 << 25;
+  carry0 = (h0 + (int64_t) (1 << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+
+  h[0] = (s32) h0; h[1] = (s32) h1; h[2] = (s32) h2; h[3] = (s32) h3; h[4] = (s32) h4;
+  h[5] = (s32) h5; h[6] = (s32) h6; h[7] = (s32) h7; h[8] = (s32) h8; h[9] = (s32) h9;
+}
+
+/* h = f * 121666, the (A + 2) / 4 constant of the curve. */
+static void
+fe_mul121666(fe h, const fe f) {
+  int64_t h0 = f[0] * (int64_t) 121666;
+  int64_t h1 = f[1] * (int64_t) 121666;
+  int64_t h2 = f[2] * (int64_t) 121666;
+  int64_t h3 = f[3] * (int64_t) 121666;
+  int64_t h4 = f[4] * (int64_t) 121666;
+  int64_t h5 = f[5] * (int64_t) 121666;
+  int64_t h6 = f[6] * (int64_t) 121666;
+  int64_t h7 = f[7] * (int64_t) 121666;
+  int64_t h8 = f[8] * (int64_t) 121666;
+  int64_t h9 = f[9] * (int64_t) 121666;
+  int64_t carry0, carry1, carry2, carry3, carry4, carry5, carry6, carry7, carry8, carry9;
+
+  carry9 = (h9 + (int64_t) (1 << 24)) >> 25; h0 += carry9 * 19; h9 -= carry9 << 25;
+  carry1 = (h1 + (int64_t) (1 << 24)) >> 25; h2 += carry1; h1 -= carry1 << 25;
+  carry3 = (h3 + (int64_t) (1 << 24)) >> 25; h4 += carry3; h3 -= carry3 << 25;
+  carry5 = (h5 + (int64_t) (1 << 24)) >> 25; h6 += carry5; h5 -= carry5 << 25;
+  carry7 = (h7 + (int64_t) (1 << 24)) >> 25; h8 += carry7; h7 -= carry7 << 25;
+  carry0 = (h0 + (int64_t) (1 << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+  carry2 = (h2 + (int64_t) (1 << 25)) >> 26; h3 += carry2; h2 -= carry2 << 26;
+  carry4 = (h4 + (int64_t) (1 << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry6 = (h6 + (int64_t) (1 << 25)) >> 26; h7 += carry6; h6 -= carry6 << 26;
+  carry8 = (h8 + (int64_t) (1 << 25)) >> 26; h9 += carry8; h8 -= carry8 << 26;
+
+  h[0] = (s32) h0; h[1] = (s32) h1; h[2] = (s32) h2; h[3] = (s32) h3; h[4] = (s32) h4;
+  h[5] = (s32) h5; h[6] = (s32) h6; h[7] = (s32) h7; h[8] = (s32) h8; h[9] = (s32) h9;
+}
+
+static int64_t
+load_3(const u8 *in) {
+  return (int64_t) in[0] | ((int64_t) in[1] << 8) | ((int64_t) in[2] << 16);
+}
+
+static int64_t
+load_4(const u8 *in) {
+  return (int64_t) in[0] | ((int64_t) in[1] << 8) | ((int64_t) in[2] << 16) | ((int64_t) in[3] << 24);
+}
+
+/* Take a little-endian, 32-byte number and expand it into limbs. The top
+ * bit is ignored. */
+static void
+fe_frombytes(fe h, const u8 *s) {
+  int64_t h0 = load_4(s);
+  int64_t h1 = load_3(s + 4) << 6;
+  int64_t h2 = load_3(s + 7) << 5;
+  int64_t h3 = load_3(s + 10) << 3;
+  int64_t h4 = load_3(s + 13) << 2;
+  int64_t h5 = load_4(s + 16);
+  int64_t h6 = load_3(s + 20) << 7;
+  int64_t h7 = load_3(s + 23) << 5;
+  int64_t h8 = load_3(s + 26) << 4;
+  int64_t h9 = (load_3(s + 29) & 0x7fffff) << 2;
+  int64_t carry0, carry1, carry2, carry3, carry4, carry5, carry6, carry7, carry8, carry9;
+
+  carry9 = (h9 + (int64_t) (1 << 24)) >> 25; h0 += carry9 * 19; h9 -= carry9 << 25;
+  carry1 = (h1 + (int64_t) (1 << 24)) >> 25; h2 += carry1; h1 -= carry1 << 25;
+  carry3 = (h3 + (int64_t) (1 << 24)) >> 25; h4 += carry3; h3 -= carry3 << 25;
+  carry5 = (h5 + (int64_t) (1 << 24)) >> 25; h6 += carry5; h5 -= carry5 << 25;
+  carry7 = (h7 + (int64_t) (1 << 24)) >> 25; h8 += carry7; h7 -= carry7 << 25;
+  carry0 = (h0 + (int64_t) (1 << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+  carry2 = (h2 + (int64_t) (1 << 25)) >> 26; h3 += carry2; h2 -= carry2 << 26;
+  carry4 = (h4 + (int64_t) (1 << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry6 = (h6 + (int64_t) (1 << 25)) >> 26; h7 += carry6; h6 -= carry6 << 26;
+  carry8 = (h8 + (int64_t) (1 << 25)) >> 26; h9 += carry8; h8 -= carry8 << 26;
+
+  h[0] = (s32) h0; h[1] = (s32) h1; h[2] = (s32) h2; h[3] = (s32) h3; h[4] = (s32) h4;
+  h[5] = (s32) h5; h[6] = (s32) h6; h[7] = (s32) h7; h[8] = (s32) h8; h[9] = (s32) h9;
+}
+
+/* Fully reduce h mod 2^255 - 19 and write it as a little-endian, 32-byte
+ * number.
+ *
+ * q below is floor(h / p), 0 or 1 for the limb bounds above: it is the
+ * carry out of the top limb of h + 19. Adding 19 * q and dropping bit 255
+ * then leaves h - q * p, which is canonical. */
+static void
+fe_tobytes(u8 *s, const fe h) {
+  s32 h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+  s32 h5 = h[5], h6 = h[6], h7 = h[7], h8 = h[8], h9 = h[9];
+  s32 q, carry0, carry1, carry2, carry3, carry4, carry5, carry6, carry7, carry8, carry9;
+
+  q = (19 * h9 + ((s32) 1 << 24)) >> 25;
+  q = (h0 + q) >> 26;
+  q = (h1 + q) >> 25;
+  q = (h2 + q) >> 26;
+  q = (h3 + q) >> 25;
+  q = (h4 + q) >> 26;
+  q = (h5 + q) >> 25;
+  q = (h6 + q) >> 26;
+  q = (h7 + q) >> 25;
+  q = (h8 + q) >> 26;
+  q = (h9 + q) >> 25;
+
+  h0 += 19 * q;
+
+  carry0 = h0 >> 26; h1 += carry0; h0 -= carry0 << 26;
+  carry1 = h1 >> 25; h2 += carry1; h1 -= carry1 << 25;
+  carry2 = h2 >> 26; h3 += carry2; h2 -= carry2 << 26;
+  carry3 = h3 >> 25; h4 += carry3; h3 -= carry3 << 25;
+  carry4 = h4 >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry5 = h5 >> 25; h6 += carry5; h5 -= carry5 << 25;
+  carry6 = h6 >> 26; h7 += carry6; h6 -= carry6 << 26;
+  carry7 = h7 >> 25; h8 += carry7; h7 -= carry7 << 25;
+  carry8 = h8 >> 26; h9 += carry8; h8 -= carry8 << 26;
+  carry9 = h9 >> 25;                h9 -= carry9 << 25;
+
+  s[0] = (u8) (h0 >> 0);
+  s[1] = (u8) (h0 >> 8);
+  s[2] = (u8) (h0 >> 16);
+  s[3] = (u8) ((h0 >> 24) | (h1 << 2));
+  s[4] = (u8) (h1 >> 6);
+  s[5] = (u8) (h1 >> 14);
+  s[6] = (u8) ((h1 >> 22) | (h2 << 3));
+  s[7] = (u8) (h2 >> 5);
+  s[8] = (u8) (h2 >> 13);
+  s[9] = (u8) ((h2 >> 21) | (h3 << 5));
+  s[10] = (u8) (h3 >> 3);
+  s[11] = (u8) (h3 >> 11);
+  s[12] = (u8) ((h3 >> 19) | (h4 << 6));
+  s[13] = (u8) (h4 >> 2);
+  s[14] = (u8) (h4 >> 10);
+  s[15] = (u8) (h4 >> 18);
+  s[16] = (u8) (h5 >> 0);
+  s[17] = (u8) (h5 >> 8);
+  s[18] = (u8) (h5 >> 16);
+  s[19] = (u8) ((h5 >> 24) | (h6 << 1));
+  s[20] = (u8) (h6 >> 7);
+  s[21] = (u8) (h6 >> 15);
+  s[22] = (u8) ((h6 >> 23) | (h7 << 3));
+  s[23] = (u8) (h7 >> 5);
+  s[24] = (u8) (h7 >> 13);
+  s[25] = (u8) ((h7 >> 21) | (h8 << 4));
+  s[26] = (u8) (h8 >> 4);
+  s[27] = (u8) (h8 >> 12);
+  s[28] = (u8) ((h8 >> 20) | (h9 << 6));
+  s[29] = (u8) (h9 >> 2);
+  s[30] = (u8) (h9 >> 10);
+  s[31] = (u8) (h9 >> 18);
+}
+
+/* out = z^(p - 2) = 1/z, the same addition chain as crecip in the other
+ * versions */
+static void
+fe_invert(fe out, const fe z) {
+  fe z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t0, t1;
+  int i;
+
+  /* 2 */ fe_sq(z2,z);
+  /* 4 */ fe_sq(t1,z2);
+  /* 8 */ fe_sq(t0,t1);
+  /* 9 */ fe_mul(z9,t0,z);
+  /* 11 */ fe_mul(z11,z9,z2);
+  /* 22 */ fe_sq(t0,z11);
+  /* 2^5 - 2^0 = 31 */ fe_mul(z2_5_0,t0,z9);
+
+  /* 2^6 - 2^1 */ fe_sq(t0,z2_5_0);
+  /* 2^10 - 2^5 */ for (i = 1;i < 5;++i) { fe_sq(t0,t0); }
+  /* 2^10 - 2^0 */ fe_mul(z2_10_0,t0,z2_5_0);
+
+  /* 2^11 - 2^1 */ fe_sq(t0,z2_10_0);
+  /* 2^20 - 2^10 */ for (i = 1;i < 10;++i) { fe_sq(t0,t0); }
+  /* 2^20 - 2^0 */ fe_mul(z2_20_0,t0,z2_10_0);
+
+  /* 2^21 - 2^1 */ fe_sq(t0,z2_20_0);
+  /* 2^40 - 2^20 */ for (i = 1;i < 20;++i) { fe_sq(t0,t0); }
+  /* 2^40 - 2^0 */ fe_mul(t0,t0,z2_20_0);
+
+  /* 2^41 - 2^1 */ fe_sq(t0,t0);
+  /* 2^50 - 2^10 */ for (i = 1;i < 10;++i) { fe_sq(t0,t0); }
+  /* 2^50 - 2^0 */ fe_mul(z2_50_0,t0,z2_10_0);
+
+  /* 2^51 - 2^1 */ fe_sq(t0,z2_50_0);
+  /* 2^100 - 2^50 */ for (i = 1;i < 50;++i) { fe_sq(t0,t0); }
+  /* 2^100 - 2^0 */ fe_mul(z2_100_0,t0,z2_50_0);
+
+  /* 2^101 - 2^1 */ fe_sq(t1,z2_100_0);
+  /* 2^200 - 2^100 */ for (i = 1;i < 100;++i) { fe_sq(t1,t1); }
+  /* 2^200 - 2^0 */ fe_mul(t1,t1,z2_100_0);
+
+  /* 2^201 - 2^1 */ fe_sq(t1,t1);
+  /* 2^250 - 2^50 */ for (i = 1;i < 50;++i) { fe_sq(t1,t1); }
+  /* 2^250 - 2^0 */ fe_mul(t1,t1,z2_50_0);
+
+  /* 2^255 - 2^5 */ for (i = 0;i < 5;++i) { fe_sq(t1,t1); }
+  /* 2^255 - 21 */ fe_mul(out,t1,z11);
+}
+
+static const unsigned char		kCurve25519BasePoint[ 32 ] = { 9 };
+
+/* Montgomery ladder over bits 254..0 of the clamped scalar (RFC 7748). The
+ * swap is deferred: x2/x3 are only swapped when the bit differs from the
+ * previous one. */
+void
+curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
+  fe x1, x2, z2, x3, z3, tmp0, tmp1;
+  u8 e[32];
+  s32 swap, b;
+  int pos;
+
+  if (basepoint == NULL) basepoint = kCurve25519BasePoint;
+
+  memcpy(e, secret, 32);
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+
+  fe_frombytes(x1, basepoint);
+  fe_1(x2);
+  fe_0(z2);
+  fe_copy(x3, x1);
+  fe_1(z3);
+
+  swap = 0;
+  for (pos = 254; pos >= 0; --pos) {
+    b = (e[pos / 8] >> (pos & 7)) & 1;
+    swap ^= b;
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+    swap = b;
+
+    fe_sub(tmp0, x3, z3);
+    fe_sub(tmp1, x2, z2);
+    fe_add(x2, x2, z2);
+    fe_add(z2, x3, z3);
+    fe_mul(z3, tmp0, x2);
+    fe_mul(z2, z2, tmp1);
+    fe_sq(tmp0, tmp1);
+    fe_sq(tmp1, x2);
+    fe_add(x3, z3, z2);
+    fe_sub(z2, z3, z2);
+    fe_mul(x2, tmp1, tmp0);
+    fe_sub(tmp1, tmp1, tmp0);
+    fe_sq(z2, z2);
+    fe_mul121666(z3, tmp1);
+    fe_sq(x3, x3);
+    fe_add(tmp0, tmp0, z3);
+    fe_mul(z3, x1, z2);
+    fe_mul(z2, tmp1, tmp0);
+  }
+  fe_cswap(x2, x3, swap);
+  fe_cswap(z2, z3, swap);
+
+  fe_invert(z2, z2);
+  fe_mul(x2, x2, z2);
+  fe_tobytes(mypublic, x2);
+
+  memset(e, 0, sizeof(e));
+}
@@ -80,10 +80,18 @@
 	#endif
 #endif
 
+// CURVE25519_C32: 1 to use the 32-bit limb version on 32-bit platforms, 0 for the portable version below.
+
+#if( !defined( CURVE25519_C32 ) )
+	#define	CURVE25519_C32			1
+#endif
+
 // Conditionally include the 64-bit version if we're building for a 64-bit platform.
 
 #if( CURVE25519_64_BIT )
 	#include "curve25519-donna-c64.c"
+#elif( CURVE25519_C32 )
+	#include "curve25519-donna-c32.c"
 #else
 
 // 32-bit/portable version...
@@ -827,6 +835,6 @@ curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
   fcontract(mypublic, z);
 }
 
-#endif // !CURVE25519_64_BIT
+#endif // !CURVE25519_64_BIT && !CURVE25519_C32
 
 
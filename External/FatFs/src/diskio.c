@@ -36,17 +36,188 @@
   */ 
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "diskio.h"
 #include "ff_gen_drv.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+#ifndef _DISK_CACHE_SECTORS
+#define _DISK_CACHE_SECTORS     0
+#endif
+
+#ifndef _DISK_CACHE_READAHEAD
+#define _DISK_CACHE_READAHEAD   1
+#endif
+
+#if _DISK_CACHE_SECTORS
+#if _DISK_CACHE_SECTORS < 2 || _DISK_CACHE_SECTORS > 128 || _MAX_SS != 512
+#error "_DISK_CACHE_SECTORS must be 2 to 128, with _MAX_SS 512"
+#endif
+
+/* Cache line of a sector, consecutive sectors sit in consecutive lines so
+   they are read and written back with one call to the driver */
+#define CACHE_LINE(sector)      ( (sector) % _DISK_CACHE_SECTORS )
+#define CACHE_SECTOR_SIZE       512
+
+typedef struct
+{
+  DWORD sector;
+  BYTE  pdrv;
+  BYTE  valid;
+  BYTE  dirty;
+} CacheLine_t;
+#endif /* _DISK_CACHE_SECTORS */
+
 /* Private variables ---------------------------------------------------------*/
 extern Disk_drvTypeDef  disk;
 
+#if _DISK_CACHE_SECTORS
+/* Shared by all the drives, FatFs locks each volume on its own so the drives
+   must not be used from several threads when _VOLUMES is more than 1 */
+static CacheLine_t CacheLines[_DISK_CACHE_SECTORS];
+static BYTE        CacheData[_DISK_CACHE_SECTORS][CACHE_SECTOR_SIZE];
+/* Sector count of each drive, 0 if unknown, and the sector after the last read */
+static DWORD       CacheDiskSize[_VOLUMES];
+static DWORD       CacheNextRead[_VOLUMES];
+#endif /* _DISK_CACHE_SECTORS */
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+#if _DISK_CACHE_SECTORS
+/**
+  * @brief  Gets the line holding a sector
+  * @param  pdrv: Physical drive number (0..)
+  * @param  sector: Sector address (LBA)
+  * @retval The cache line, or NULL when the sector is not cached
+  */
+static CacheLine_t *cache_find(BYTE pdrv, DWORD sector)
+{
+  CacheLine_t *line = &CacheLines[CACHE_LINE(sector)];
+
+  if (line->valid && line->pdrv == pdrv && line->sector == sector)
+    return line;
+  return NULL;
+}
+
+/**
+  * @brief  Writes a dirty line back, together with the dirty lines next to it
+  *         that hold the sectors just before and after it
+  * @param  index: Index of a dirty line
+  * @retval DRESULT: Operation result
+  */
+static DRESULT cache_flush_line(UINT index)
+{
+  CacheLine_t *line = &CacheLines[index];
+  UINT first = index, last = index, i;
+  DRESULT res;
+
+  while (first > 0 && CacheLines[first - 1].dirty && CacheLines[first - 1].pdrv == line->pdrv
+         && CacheLines[first - 1].sector + 1 == CacheLines[first].sector)
+    first--;
+  while (last + 1 < _DISK_CACHE_SECTORS && CacheLines[last + 1].dirty && CacheLines[last + 1].pdrv == line->pdrv
+         && CacheLines[last + 1].sector == CacheLines[last].sector + 1)
+    last++;
+
+  res = disk.drv[line->pdrv]->disk_write(CacheData[first], CacheLines[first].sector, last - first + 1);
+  if (res != RES_OK)
+    return res;
+
+  for (i = first; i <= last; i++)
+    CacheLines[i].dirty = 0;
+  return RES_OK;
+}
+
+/**
+  * @brief  Writes back every dirty line of a drive
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DRESULT: Operation result
+  */
+static DRESULT cache_flush(BYTE pdrv)
+{
+  DRESULT res;
+  UINT i;
+
+  for (i = 0; i < _DISK_CACHE_SECTORS; i++)
+  {
+    if (CacheLines[i].dirty && CacheLines[i].pdrv == pdrv)
+    {
+      res = cache_flush_line(i);
+      if (res != RES_OK)
+        return res;
+    }
+  }
+  return RES_OK;
+}
+
+/**
+  * @brief  Reads sectors from sector on into their lines, with one call to the
+  *         driver. The first line is written back first if it is dirty, the
+  *         read stops before a line that is dirty or holds one of the sectors.
+  *         The lines are dropped before the read, a failed read leaves them
+  *         empty rather than holding part of its data
+  * @param  pdrv: Physical drive number (0..)
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors wanted (1..)
+  * @retval DRESULT: Operation result
+  */
+static DRESULT cache_fill(BYTE pdrv, DWORD sector, UINT count)
+{
+  UINT first = CACHE_LINE(sector), n, i;
+  DRESULT res;
+
+  if (CacheLines[first].dirty)
+  {
+    res = cache_flush_line(first);
+    if (res != RES_OK)
+      return res;
+  }
+
+  if (count > _DISK_CACHE_SECTORS - first)
+    count = _DISK_CACHE_SECTORS - first;
+  for (n = 1; n < count; n++)
+  {
+    if (CacheLines[first + n].dirty || cache_find(pdrv, sector + n) != NULL)
+      break;
+  }
+
+  for (i = 0; i < n; i++)
+    CacheLines[first + i].valid = 0;
+  res = disk.drv[pdrv]->disk_read(CacheData[first], sector, n);
+  if (res != RES_OK)
+    return res;
+
+  for (i = 0; i < n; i++)
+  {
+    CacheLines[first + i].sector = sector + i;
+    CacheLines[first + i].pdrv = pdrv;
+    CacheLines[first + i].valid = 1;
+  }
+  return RES_OK;
+}
+
+/**
+  * @brief  Drops the lines of a range of sectors, dirty or not
+  * @param  pdrv: Physical drive number (0..)
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors
+  * @retval None
+  */
+static void cache_discard(BYTE pdrv, DWORD sector, UINT count)
+{
+  CacheLine_t *line;
+  UINT i;
+
+  for (i = 0; i < _DISK_CACHE_SECTORS; i++)
+  {
+    line = &CacheLines[i];
+    if (line->valid && line->pdrv == pdrv && line->sector - sector < count)
+      line->valid = line->dirty = 0;
+  }
+}
+#endif /* _DISK_CACHE_SECTORS */
+
 /**
   * @brief  Initializes a Drive
   * @param  pdrv: Physical drive number (0..)
@@ -57,6 +228,19 @@ DSTATUS disk_initialize(BYTE pdrv)
   DSTATUS stat;
   
   stat = disk.drv[pdrv]->disk_initialize();
+#if _DISK_CACHE_SECTORS
+  /* The medium may have been changed, nothing cached is kept */
+  cache_discard(pdrv, 0, 0xFFFFFFFF);
+  CacheDiskSize[pdrv] = 0;
+  CacheNextRead[pdrv] = 0xFFFFFFFF;
+#if _USE_IOCTL == 1
+  if (!(stat & STA_NOINIT))
+  {
+    if (disk.drv[pdrv]->disk_ioctl(GET_SECTOR_COUNT, &CacheDiskSize[pdrv]) != RES_OK)
+      CacheDiskSize[pdrv] = 0;
+  }
+#endif /* _USE_IOCTL == 1 */
+#endif /* _DISK_CACHE_SECTORS */
   return stat;
 }
 
@@ -84,8 +268,54 @@ DSTATUS disk_status(BYTE pdrv)
 DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, BYTE count)
 {
   DRESULT res;
- 
+#if _DISK_CACHE_SECTORS
+  CacheLine_t *line;
+  UINT i, want;
+  DWORD ahead;
+
+  /* Reads as large as the cache go straight to the driver, only the sectors
+     written to the cache and not to the disk yet are taken from it */
+  if (count >= _DISK_CACHE_SECTORS)
+  {
+    res = disk.drv[pdrv]->disk_read(buff, sector, count);
+    if (res != RES_OK)
+      return res;
+    for (i = 0; i < count; i++)
+    {
+      line = cache_find(pdrv, sector + i);
+      if (line != NULL && line->dirty)
+        memcpy(buff + i * CACHE_SECTOR_SIZE, CacheData[CACHE_LINE(sector + i)], CACHE_SECTOR_SIZE);
+    }
+    CacheNextRead[pdrv] = sector + count;
+    return RES_OK;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    if (cache_find(pdrv, sector + i) == NULL)
+    {
+      /* A read that goes on from the last one reads ahead, up to the end of
+         the disk, and not at all when the size of the disk is unknown */
+      want = count - i;
+      if (sector == CacheNextRead[pdrv] && want < _DISK_CACHE_READAHEAD)
+      {
+        ahead = (CacheDiskSize[pdrv] > sector + i) ? CacheDiskSize[pdrv] - (sector + i) : 0;
+        if (ahead > _DISK_CACHE_READAHEAD)
+          ahead = _DISK_CACHE_READAHEAD;
+        if (ahead > want)
+          want = (UINT)ahead;
+      }
+      res = cache_fill(pdrv, sector + i, want);
+      if (res != RES_OK)
+        return res;
+    }
+    memcpy(buff + i * CACHE_SECTOR_SIZE, CacheData[CACHE_LINE(sector + i)], CACHE_SECTOR_SIZE);
+  }
+  CacheNextRead[pdrv] = sector + count;
+  res = RES_OK;
+#else
   res = disk.drv[pdrv]->disk_read(buff, sector, count);
+#endif /* _DISK_CACHE_SECTORS */
   return res;
 }
 
@@ -101,8 +331,42 @@ DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, BYTE count)
 DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, BYTE count)
 {
   DRESULT res;
-  
+#if _DISK_CACHE_SECTORS
+  CacheLine_t *line;
+  UINT i;
+
+  /* Writes as large as the cache go straight to the driver, the cached copies
+     of those sectors are out of date then */
+  if (count >= _DISK_CACHE_SECTORS)
+  {
+    res = disk.drv[pdrv]->disk_write(buff, sector, count);
+    if (res == RES_OK)
+      cache_discard(pdrv, sector, count);
+    return res;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    line = &CacheLines[CACHE_LINE(sector + i)];
+    if (cache_find(pdrv, sector + i) == NULL)
+    {
+      if (line->dirty)
+      {
+        res = cache_flush_line(CACHE_LINE(sector + i));
+        if (res != RES_OK)
+          return res;
+      }
+      line->sector = sector + i;
+      line->pdrv = pdrv;
+      line->valid = 1;
+    }
+    memcpy(CacheData[CACHE_LINE(sector + i)], buff + i * CACHE_SECTOR_SIZE, CACHE_SECTOR_SIZE);
+    line->dirty = 1;
+  }
+  res = RES_OK;
+#else
   res = disk.drv[pdrv]->disk_write(buff, sector, count);
+#endif /* _DISK_CACHE_SECTORS */
   return res;
 }
 #endif /* _USE_WRITE == 1 */
@@ -119,6 +383,15 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
 {
   DRESULT res;
 
+#if _DISK_CACHE_SECTORS
+  /* f_sync() and f_close() end here, the cached writes go to the disk first */
+  if (cmd == CTRL_SYNC)
+  {
+    res = cache_flush(pdrv);
+    if (res != RES_OK)
+      return res;
+  }
+#endif /* _DISK_CACHE_SECTORS */
   res = disk.drv[pdrv]->disk_ioctl(cmd, buff);
   return res;
 }
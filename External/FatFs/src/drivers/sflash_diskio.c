@@ -0,0 +1,603 @@
+/**
+  ******************************************************************************
+  * @file    sflash_diskio.c
+  * @author  William Xu
+  * @version V1.0.0
+  * @date    18-Oct-2026
+  * @brief   SPI flash Disk I/O driver, with a flash translation layer that
+  *          packs 512 bytes sectors into the 4K bytes erase blocks
+  ******************************************************************************
+  * @attention
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, MXCHIP Inc. SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 MXCHIP Inc.</center></h2>
+  ******************************************************************************
+  */
+
+/* A sector is never written in place. Every write goes to the next free slot of
+   the current block, and the mapping table in RAM then points the sector at that
+   slot. The old copy becomes stale and its erase block is given back by the
+   garbage collector once most of its slots are stale, so a full erase happens
+   about once every 7 sector writes instead of once for every write.
+
+   Erase block layout, 4K bytes:
+     0    - 511  : BlockMeta_t, block header and the tags of the 7 slots
+     512  - 4095 : 7 slots of one sector each
+
+   Flash bits only go from 1 to 0 between erases, so every step below is one
+   program of words that were still erased:
+     - erase      : magic is cleared, the block is erased, magic is written back
+     - open block : the head it is opened for, seq and ~seq of the block
+     - write      : lsn, seq and their complements in the slot tag, then the
+                    data, then commit = 0
+   A word pair that is not the complement of each other, or a commit that is
+   not 0, was cut by a power loss and its slot is ignored, so a sector reads
+   either its old or its new data after a reset. The mapping table is built
+   again from the tags when the disk is initialized, the copy with the higher
+   seq is the newest. The newest block with free slots of each head is filled
+   on, so a power loss never costs a block. Unformatted or torn blocks are erased the
+   first time they are needed. */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ff_gen_drv.h"
+#include "spi_flash.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Area of the SPI flash used for the disk, both can be defined in ffconf.h. The
+   default is the free space above the OTA area of the 2M bytes SPI flash boards */
+#ifndef SFLASHDISK_START_ADDRESS
+#define SFLASHDISK_START_ADDRESS  0x000C0000
+#endif
+
+#ifndef SFLASHDISK_SIZE
+#define SFLASHDISK_SIZE           0x00100000
+#endif
+
+/* Block Size in Bytes */
+#define BLOCK_SIZE                512
+#define ERASE_BLOCK_SIZE          4096
+#define SLOTS_PER_BLOCK           ( ERASE_BLOCK_SIZE / BLOCK_SIZE - 1 )
+
+#define ERASE_BLOCKS              ( SFLASHDISK_SIZE / ERASE_BLOCK_SIZE )
+/* Blocks kept out of the disk so the garbage collector finds mostly stale ones.
+   More than GC_RESERVE_BLOCKS + 2 heads, so there is always a block that is not
+   full of valid sectors to collect */
+#define SPARE_BLOCKS              ( ERASE_BLOCKS / 16 + 5 )
+#define SECTOR_COUNT              ( ( ERASE_BLOCKS - SPARE_BLOCKS ) * SLOTS_PER_BLOCK )
+/* Free blocks below which garbage is collected before a new block is opened. A
+   collection opens at most one block before it erases one, so a free block is
+   still left to copy into after a power loss in the middle of it */
+#define GC_RESERVE_BLOCKS         2
+
+/* Sectors written by FatFs and sectors moved by the garbage collector fill
+   different blocks, so data that is often rewritten does not keep carrying the
+   data that is not along with it */
+#define HOST_HEAD                 0
+#define GC_HEAD                   1
+
+#define BLOCK_MAGIC               0x4C465453  /* "STFL" */
+#define ERASED_WORD               0xFFFFFFFF
+#define UNMAPPED                  0xFFFF
+
+#if ( ERASE_BLOCKS < 16 ) || ( ERASE_BLOCKS * SLOTS_PER_BLOCK >= UNMAPPED )
+#error "SFLASHDISK_SIZE must hold 16 to 9362 erase blocks"
+#endif
+
+#define BLOCK_ADDRESS(b)          ( SFLASHDISK_START_ADDRESS + (uint32_t)(b) * ERASE_BLOCK_SIZE )
+#define SLOT_ADDRESS(b, s)        ( BLOCK_ADDRESS(b) + ( (uint32_t)(s) + 1 ) * BLOCK_SIZE )
+#define META_ADDRESS(b, field)    ( BLOCK_ADDRESS(b) + offsetof( BlockMeta_t, field ) )
+#define TAG_ADDRESS(b, s)         ( META_ADDRESS(b, tag) + (uint32_t)(s) * sizeof( SlotTag_t ) )
+#define COMMIT_ADDRESS(b, s)      ( META_ADDRESS(b, commit) + (uint32_t)(s) * sizeof( uint32_t ) )
+
+typedef struct
+{
+  uint32_t lsn;
+  uint32_t lsn_inv;
+  uint32_t seq;
+  uint32_t seq_inv;
+} SlotTag_t;
+
+typedef struct
+{
+  uint32_t  magic;
+  uint32_t  head;     /* Programmed before seq */
+  uint32_t  seq;
+  uint32_t  seq_inv;
+  SlotTag_t tag[SLOTS_PER_BLOCK];
+  uint32_t  commit[SLOTS_PER_BLOCK];
+} BlockMeta_t;
+
+typedef enum
+{
+  BLOCK_FREE,       /* Erased, with the magic written */
+  BLOCK_USED,       /* Opened once, or to be erased before it is used */
+} BlockState_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* Disk status */
+static volatile DSTATUS Stat = STA_NOINIT;
+
+static sflash_handle_t sflash_handle;
+
+/* Slot of each sector, block * SLOTS_PER_BLOCK + slot, or UNMAPPED */
+static uint16_t SectorMap[SECTOR_COUNT];
+static uint32_t BlockSeq[ERASE_BLOCKS];
+static uint8_t  BlockValid[ERASE_BLOCKS];
+static uint8_t  BlockState[ERASE_BLOCKS];
+static uint16_t FreeBlocks;
+static uint16_t HeadBlock[2];
+static uint8_t  HeadNext[2];
+static uint32_t NextSeq;
+
+static uint8_t  CopyBuffer[BLOCK_SIZE];
+static const uint32_t CommitWords[SLOTS_PER_BLOCK] = { 0 };
+
+/* Private function prototypes -----------------------------------------------*/
+DSTATUS SFLASHDISK_initialize (void);
+DSTATUS SFLASHDISK_status (void);
+DRESULT SFLASHDISK_read (BYTE*, DWORD, BYTE);
+#if _USE_WRITE == 1
+  DRESULT SFLASHDISK_write (const BYTE*, DWORD, BYTE);
+#endif /* _USE_WRITE == 1 */
+#if _USE_IOCTL == 1
+  DRESULT SFLASHDISK_ioctl (BYTE, void*);
+#endif /* _USE_IOCTL == 1 */
+
+Diskio_drvTypeDef  SFLASHDISK_Driver =
+{
+  SFLASHDISK_initialize,
+  SFLASHDISK_status,
+  SFLASHDISK_read,
+#if  _USE_WRITE == 1
+  SFLASHDISK_write,
+#endif /* _USE_WRITE == 1 */
+#if  _USE_IOCTL == 1
+  SFLASHDISK_ioctl,
+#endif /* _USE_IOCTL == 1 */
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Rebuilds the mapping table and the block states from the flash
+  * @param  None
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FTL_Mount(void)
+{
+  BlockMeta_t meta;
+  SlotTag_t *tag;
+  uint32_t oldSeq, maxSeq = 0;
+  uint16_t b, slot, old;
+  uint8_t used;
+  DWORD lsn;
+
+  memset(SectorMap, 0xFF, sizeof(SectorMap));
+  memset(BlockValid, 0, sizeof(BlockValid));
+  FreeBlocks = 0;
+  HeadBlock[HOST_HEAD] = HeadBlock[GC_HEAD] = 0;
+  HeadNext[HOST_HEAD] = HeadNext[GC_HEAD] = SLOTS_PER_BLOCK;
+
+  for (b = 0; b < ERASE_BLOCKS; b++)
+  {
+    if (sflash_read(&sflash_handle, BLOCK_ADDRESS(b), &meta, sizeof(meta)) != 0)
+      return RES_ERROR;
+
+    BlockSeq[b] = 0;
+    BlockState[b] = BLOCK_USED;
+    if (meta.magic != BLOCK_MAGIC)
+      continue;
+
+    if (meta.head == ERASED_WORD && meta.seq == ERASED_WORD && meta.seq_inv == ERASED_WORD)
+    {
+      BlockState[b] = BLOCK_FREE;
+      FreeBlocks++;
+      continue;
+    }
+
+    if ((meta.seq ^ meta.seq_inv) != ERASED_WORD || meta.seq == 0)
+      continue;
+    BlockSeq[b] = meta.seq;
+    if (meta.seq > maxSeq)
+      maxSeq = meta.seq;
+
+    used = 0;
+    for (slot = 0; slot < SLOTS_PER_BLOCK; slot++)
+    {
+      tag = &meta.tag[slot];
+      if (tag->lsn != ERASED_WORD || tag->lsn_inv != ERASED_WORD || tag->seq != ERASED_WORD || tag->seq_inv != ERASED_WORD)
+        used = slot + 1;
+
+      lsn = tag->lsn;
+      if ((lsn ^ tag->lsn_inv) != ERASED_WORD || (tag->seq ^ tag->seq_inv) != ERASED_WORD
+          || meta.commit[slot] != 0 || lsn >= SECTOR_COUNT)
+        continue;
+      if (tag->seq > maxSeq)
+        maxSeq = tag->seq;
+
+      /* A stale copy in another block costs one more short read */
+      old = SectorMap[lsn];
+      if (old != UNMAPPED)
+      {
+        if (old / SLOTS_PER_BLOCK == b)
+          oldSeq = meta.tag[old % SLOTS_PER_BLOCK].seq;
+        else if (sflash_read(&sflash_handle, TAG_ADDRESS(old / SLOTS_PER_BLOCK, old % SLOTS_PER_BLOCK) + offsetof(SlotTag_t, seq),
+                             &oldSeq, sizeof(oldSeq)) != 0)
+          return RES_ERROR;
+        if (oldSeq > tag->seq)
+          continue;
+      }
+      SectorMap[lsn] = b * SLOTS_PER_BLOCK + slot;
+    }
+
+    /* Writes go on in the block a head was filling */
+    if (used < SLOTS_PER_BLOCK && meta.head <= GC_HEAD
+        && (HeadNext[meta.head] == SLOTS_PER_BLOCK || meta.seq > BlockSeq[HeadBlock[meta.head]]))
+    {
+      HeadBlock[meta.head] = b;
+      HeadNext[meta.head] = used;
+    }
+  }
+
+  for (lsn = 0; lsn < SECTOR_COUNT; lsn++)
+  {
+    if (SectorMap[lsn] != UNMAPPED)
+      BlockValid[SectorMap[lsn] / SLOTS_PER_BLOCK]++;
+  }
+
+  NextSeq = maxSeq + 1;
+  return RES_OK;
+}
+
+/**
+  * @brief  Erases a block that holds no valid sector
+  * @param  block: Erase block index
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FTL_EraseBlock(uint16_t block)
+{
+  const uint32_t magic = BLOCK_MAGIC;
+
+  /* A cut erase may leave old tags readable, they are not trusted without the magic */
+  if (sflash_write(&sflash_handle, META_ADDRESS(block, magic), &CommitWords[0], sizeof(uint32_t)) != 0)
+    return RES_ERROR;
+  if (sflash_sector_erase(&sflash_handle, BLOCK_ADDRESS(block)) != 0)
+    return RES_ERROR;
+  if (sflash_write(&sflash_handle, META_ADDRESS(block, magic), &magic, sizeof(magic)) != 0)
+    return RES_ERROR;
+
+  BlockState[block] = BLOCK_FREE;
+  BlockValid[block] = 0;
+  FreeBlocks++;
+  return RES_OK;
+}
+
+/**
+  * @brief  Makes the next free block, in address order, the one written to
+  * @param  head: HOST_HEAD or GC_HEAD
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FTL_OpenBlock(uint8_t head)
+{
+  uint32_t header[3];
+  uint16_t i, b = HeadBlock[head];
+
+  for (i = 0; i < ERASE_BLOCKS; i++)
+  {
+    b = (b + 1) % ERASE_BLOCKS;
+    if (BlockState[b] == BLOCK_FREE)
+      break;
+  }
+  if (i == ERASE_BLOCKS)
+    return RES_ERROR;
+
+  header[0] = head;
+  header[1] = NextSeq;
+  header[2] = ~NextSeq;
+  BlockState[b] = BLOCK_USED;
+  BlockSeq[b] = 0;
+  BlockValid[b] = 0;
+  FreeBlocks--;
+  HeadBlock[head] = b;
+  HeadNext[head] = SLOTS_PER_BLOCK;
+  if (sflash_write(&sflash_handle, META_ADDRESS(b, head), header, sizeof(header)) != 0)
+    return RES_ERROR;
+
+  BlockSeq[b] = NextSeq++;
+  HeadNext[head] = 0;
+  return RES_OK;
+}
+
+/**
+  * @brief  Writes count consecutive sectors to the next slots of a head block
+  * @param  head: HOST_HEAD or GC_HEAD
+  * @param  *buff: Data to be written
+  * @param  sector: First sector address (LBA)
+  * @param  count: Number of sectors, no more than the slots left in the block
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FTL_Program(uint8_t head, const BYTE *buff, DWORD sector, UINT count)
+{
+  SlotTag_t tags[SLOTS_PER_BLOCK];
+  uint16_t block = HeadBlock[head], old;
+  uint8_t slot = HeadNext[head];
+  UINT i;
+
+  for (i = 0; i < count; i++)
+  {
+    tags[i].lsn = sector + i;
+    tags[i].lsn_inv = ~(sector + i);
+    tags[i].seq = NextSeq;
+    tags[i].seq_inv = ~NextSeq;
+    NextSeq++;
+  }
+
+  /* The slots are spent even if a write below fails */
+  HeadNext[head] += count;
+  if (sflash_write(&sflash_handle, TAG_ADDRESS(block, slot), tags, count * sizeof(SlotTag_t)) != 0)
+    return RES_ERROR;
+  if (sflash_write(&sflash_handle, SLOT_ADDRESS(block, slot), buff, count * BLOCK_SIZE) != 0)
+    return RES_ERROR;
+  if (sflash_write(&sflash_handle, COMMIT_ADDRESS(block, slot), CommitWords, count * sizeof(uint32_t)) != 0)
+    return RES_ERROR;
+
+  for (i = 0; i < count; i++)
+  {
+    old = SectorMap[sector + i];
+    if (old != UNMAPPED)
+      BlockValid[old / SLOTS_PER_BLOCK]--;
+    SectorMap[sector + i] = block * SLOTS_PER_BLOCK + slot + i;
+  }
+  BlockValid[block] += count;
+  return RES_OK;
+}
+
+/**
+  * @brief  Moves the valid sectors out of the block with the fewest of them
+  *         and erases it
+  * @param  None
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FTL_Collect(void)
+{
+  BlockMeta_t meta;
+  uint16_t b, victim = UNMAPPED, phys;
+  uint8_t slot;
+  UINT room;
+  DRESULT res;
+
+  for (b = 0; b < ERASE_BLOCKS; b++)
+  {
+    if (BlockState[b] != BLOCK_USED
+        || (b == HeadBlock[HOST_HEAD] && HeadNext[HOST_HEAD] < SLOTS_PER_BLOCK)
+        || (b == HeadBlock[GC_HEAD] && HeadNext[GC_HEAD] < SLOTS_PER_BLOCK))
+      continue;
+    /* The older block of two equal ones, so the blocks are recycled in turn */
+    if (victim == UNMAPPED || BlockValid[b] < BlockValid[victim]
+        || (BlockValid[b] == BlockValid[victim] && BlockSeq[b] < BlockSeq[victim]))
+      victim = b;
+  }
+
+  room = FreeBlocks * SLOTS_PER_BLOCK + (SLOTS_PER_BLOCK - HeadNext[GC_HEAD]);
+  if (victim == UNMAPPED || BlockValid[victim] >= SLOTS_PER_BLOCK || BlockValid[victim] > room)
+    return RES_ERROR;
+
+  if (BlockValid[victim] != 0)
+  {
+    if (sflash_read(&sflash_handle, BLOCK_ADDRESS(victim), &meta, sizeof(meta)) != 0)
+      return RES_ERROR;
+
+    for (slot = 0; slot < SLOTS_PER_BLOCK && BlockValid[victim] != 0; slot++)
+    {
+      phys = victim * SLOTS_PER_BLOCK + slot;
+      if (meta.tag[slot].lsn >= SECTOR_COUNT || SectorMap[meta.tag[slot].lsn] != phys)
+        continue;
+
+      if (sflash_read(&sflash_handle, SLOT_ADDRESS(victim, slot), CopyBuffer, BLOCK_SIZE) != 0)
+        return RES_ERROR;
+      if (HeadNext[GC_HEAD] == SLOTS_PER_BLOCK)
+      {
+        res = FTL_OpenBlock(GC_HEAD);
+        if (res != RES_OK)
+          return res;
+      }
+      res = FTL_Program(GC_HEAD, CopyBuffer, meta.tag[slot].lsn, 1);
+      if (res != RES_OK)
+        return res;
+    }
+    if (BlockValid[victim] != 0)
+      return RES_ERROR;
+  }
+
+  return FTL_EraseBlock(victim);
+}
+
+/**
+  * @brief  Makes sure the host head block has a free slot, collects garbage first
+  *         when too few free blocks are left
+  * @param  None
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FTL_Prepare(void)
+{
+  DRESULT res;
+
+  if (HeadNext[HOST_HEAD] < SLOTS_PER_BLOCK)
+    return RES_OK;
+
+  while (FreeBlocks <= GC_RESERVE_BLOCKS)
+  {
+    res = FTL_Collect();
+    if (res != RES_OK)
+      return res;
+  }
+  return FTL_OpenBlock(HOST_HEAD);
+}
+
+/**
+  * @brief  Initializes a Drive
+  * @param  None
+  * @retval DSTATUS: Operation status
+  */
+DSTATUS SFLASHDISK_initialize(void)
+{
+  Stat = STA_NOINIT;
+
+  /* Configure the SPI flash device and rebuild the mapping table */
+  if (init_sflash(&sflash_handle, 0, SFLASH_WRITE_ALLOWED) != 0)
+    return Stat;
+
+  if (FTL_Mount() != RES_OK)
+    return Stat;
+
+  Stat &= ~STA_NOINIT;
+  return Stat;
+}
+
+/**
+  * @brief  Gets Disk Status
+  * @param  None
+  * @retval DSTATUS: Operation status
+  */
+DSTATUS SFLASHDISK_status(void)
+{
+  return Stat;
+}
+
+/**
+  * @brief  Reads Sector(s)
+  * @param  *buff: Data buffer to store read data
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to read (1..128)
+  * @retval DRESULT: Operation result
+  */
+DRESULT SFLASHDISK_read(BYTE *buff, DWORD sector, BYTE count)
+{
+  uint16_t phys;
+  UINT run;
+
+  if (Stat & STA_NOINIT) return RES_NOTRDY;
+  if (sector + count > SECTOR_COUNT) return RES_PARERR;
+
+  while (count)
+  {
+    phys = SectorMap[sector];
+    run = 1;
+    if (phys == UNMAPPED)
+    {
+      /* Never written, reads like erased flash */
+      memset(buff, 0xFF, BLOCK_SIZE);
+    }
+    else
+    {
+      /* Sectors written together sit in consecutive slots, read them at once */
+      while (run < count && (phys + run) % SLOTS_PER_BLOCK != 0 && SectorMap[sector + run] == phys + run)
+        run++;
+      if (sflash_read(&sflash_handle, SLOT_ADDRESS(phys / SLOTS_PER_BLOCK, phys % SLOTS_PER_BLOCK), buff, run * BLOCK_SIZE) != 0)
+        return RES_ERROR;
+    }
+    buff += run * BLOCK_SIZE;
+    sector += run;
+    count -= run;
+  }
+
+  return RES_OK;
+}
+
+/**
+  * @brief  Writes Sector(s)
+  * @param  *buff: Data to be written
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to write (1..128)
+  * @retval DRESULT: Operation result
+  */
+#if _USE_WRITE == 1
+DRESULT SFLASHDISK_write(const BYTE *buff, DWORD sector, BYTE count)
+{
+  DRESULT res;
+  UINT run;
+
+  if (Stat & STA_NOINIT) return RES_NOTRDY;
+  if (sector + count > SECTOR_COUNT) return RES_PARERR;
+
+  while (count)
+  {
+    res = FTL_Prepare();
+    if (res != RES_OK)
+      return res;
+
+    run = SLOTS_PER_BLOCK - HeadNext[HOST_HEAD];
+    if (run > count)
+      run = count;
+    res = FTL_Program(HOST_HEAD, buff, sector, run);
+    if (res != RES_OK)
+      return res;
+
+    buff += run * BLOCK_SIZE;
+    sector += run;
+    count -= run;
+  }
+
+  return RES_OK;
+}
+#endif /* _USE_WRITE == 1 */
+
+/**
+  * @brief  I/O control operation
+  * @param  cmd: Control code
+  * @param  *buff: Buffer to send/receive control data
+  * @retval DRESULT: Operation result
+  */
+#if _USE_IOCTL == 1
+DRESULT SFLASHDISK_ioctl(BYTE cmd, void *buff)
+{
+  DRESULT res = RES_ERROR;
+
+  if (Stat & STA_NOINIT) return RES_NOTRDY;
+
+  switch (cmd)
+  {
+  /* Every write is on the flash when it returns */
+  case CTRL_SYNC :
+    res = RES_OK;
+    break;
+
+  /* Get number of sectors on the disk (DWORD) */
+  case GET_SECTOR_COUNT :
+    *(DWORD*)buff = SECTOR_COUNT;
+    res = RES_OK;
+    break;
+
+  /* Get R/W sector size (WORD) */
+  case GET_SECTOR_SIZE :
+    *(WORD*)buff = BLOCK_SIZE;
+    res = RES_OK;
+    break;
+
+  /* Get erase block size in unit of sector (DWORD), any sector can be
+     written on its own */
+  case GET_BLOCK_SIZE :
+    *(DWORD*)buff = 1;
+    res = RES_OK;
+    break;
+
+  default:
+    res = RES_PARERR;
+  }
+
+  return res;
+}
+#endif /* _USE_IOCTL == 1 */
+
+/************************ (C) COPYRIGHT MXCHIP Inc. *****END OF FILE****/
+
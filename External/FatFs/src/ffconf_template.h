@@ -175,6 +175,16 @@
 /  should be added to the disk_ioctl() function. */
 
 
+#define _DISK_CACHE_SECTORS     8 /* 0:Disable or 2 to 128 */
+#define _DISK_CACHE_READAHEAD   4 /* 1 to _DISK_CACHE_SECTORS */
+/* Number of sectors kept by the cache of diskio.c, in RAM of _MAX_SS bytes
+/  each. Small reads and writes are served from it, a read that goes on from
+/  the end of the previous one reads _DISK_CACHE_READAHEAD sectors in advance
+/  and written sectors are kept until they have to make room, or until f_sync()
+/  and f_close(), then consecutive ones go to the disk in one write. Only a
+/  fixed sector size (_MAX_SS 512) is supported. */
+
+
 #define _FS_NOFSINFO    0 /* 0 or 1 */
 /* If you need to know the correct free space on the FAT32 volume, set this
 /  option to 1 and f_getfree() function at first time after volume mount will
@@ -25,16 +25,23 @@
 
 struct array_list*
 array_list_new(array_list_free_fn *free_fn)
+{
+  return array_list_new_arena(free_fn, NULL);
+}
+
+struct array_list*
+array_list_new_arena(array_list_free_fn *free_fn, json_arena_t *arena)
 {
   struct array_list *arr;
 
-  arr = (struct array_list*)calloc(1, sizeof(struct array_list));
+  arr = (struct array_list*)json_c_calloc(arena, 1, sizeof(struct array_list));
   if(!arr) return NULL;
   arr->size = ARRAY_LIST_DEFAULT_SIZE;
   arr->length = 0;
   arr->free_fn = free_fn;
-  if(!(arr->array = (void**)calloc(sizeof(void*), arr->size))) {
-    free(arr);
+  arr->arena = arena;
+  if(!(arr->array = (void**)json_c_calloc(arena, sizeof(void*), arr->size))) {
+    json_c_free(arena, arr);
     return NULL;
   }
   return arr;
@@ -46,8 +53,8 @@ array_list_free(struct array_list *arr)
   int i;
   for(i = 0; i < arr->length; i++)
     if(arr->array[i]) arr->free_fn(arr->array[i]);
-  free(arr->array);
-  free(arr);
+  json_c_free(arr->arena, arr->array);
+  json_c_free(arr->arena, arr);
 }
 
 void*
@@ -64,8 +71,10 @@ static int array_list_expand_internal(struct array_list *arr, int max)
 
   if(max < arr->size) return 0;
   //new_size = json_max(arr->size << 1, max);
-  new_size = json_max(arr->size + 1, max);
-  if(!(t = realloc(arr->array, new_size*sizeof(void*)))) return -1;
+  /* One slot at a time saves heap, an arena would only keep the old copies */
+  if(arr->arena) new_size = json_max(arr->size << 1, max);
+  else new_size = json_max(arr->size + 1, max);
+  if(!(t = json_c_realloc(arr->arena, arr->array, arr->size*sizeof(void*), new_size*sizeof(void*)))) return -1;
   arr->array = (void**)t;
   (void)memset(arr->array + arr->size, 0, (new_size-arr->size)*sizeof(void*));
   arr->size = new_size;
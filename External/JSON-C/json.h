@@ -21,6 +21,7 @@ extern "C" {
 #include "linkhash.h"
 #include "arraylist.h"
 #include "json_util.h"
+#include "json_arena.h"
 #include "json_object.h"
 #include "json_tokener.h"
 
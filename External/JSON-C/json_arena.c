@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2014 MXCHIP Inc.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See COPYING for details.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_arena.h"
+
+/* Enough for the doubles and 64 bit integers of json_object */
+#define JSON_ARENA_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+struct json_arena_block
+{
+  struct json_arena_block *next;
+  size_t size;
+  size_t used;
+};
+
+#define JSON_ARENA_BLOCK_HDR JSON_ARENA_ALIGN(sizeof(struct json_arena_block))
+#define JSON_ARENA_BLOCK_DATA(b) ((char*)(b) + JSON_ARENA_BLOCK_HDR)
+
+struct json_arena
+{
+  struct json_arena_block *head;
+  size_t block_size;
+  size_t used;
+  int blocks;
+  /* Last allocation, json_c_realloc() can grow it in place */
+  void *last;
+  struct json_arena_block first;
+};
+
+static unsigned long json_c_heap_op_count = 0;
+
+json_arena_t* json_arena_new(size_t block_size)
+{
+  json_arena_t *arena;
+
+  if(block_size == 0) block_size = JSON_ARENA_DEF_BLOCK_SIZE;
+  block_size = JSON_ARENA_ALIGN(block_size);
+
+  /* The first block lives in the same allocation as the arena */
+  arena = (json_arena_t*)json_c_malloc(NULL, JSON_ARENA_ALIGN(sizeof(json_arena_t)) + block_size);
+  if(!arena) return NULL;
+  arena->block_size = block_size;
+  arena->used = 0;
+  arena->blocks = 1;
+  arena->last = NULL;
+  arena->first.next = NULL;
+  arena->first.size = block_size;
+  arena->first.used = 0;
+  arena->head = &arena->first;
+  return arena;
+}
+
+static char* json_arena_data(json_arena_t *arena, struct json_arena_block *b)
+{
+  if(b == &arena->first)
+    return (char*)arena + JSON_ARENA_ALIGN(sizeof(json_arena_t));
+  return JSON_ARENA_BLOCK_DATA(b);
+}
+
+void json_arena_free(json_arena_t *arena)
+{
+  struct json_arena_block *b, *next;
+
+  if(!arena) return;
+  for(b = arena->head; b != NULL; b = next) {
+    next = b->next;
+    if(b != &arena->first) json_c_free(NULL, b);
+  }
+  json_c_free(NULL, arena);
+}
+
+static struct json_arena_block* json_arena_new_block(json_arena_t *arena, size_t size)
+{
+  struct json_arena_block *b;
+
+  b = (struct json_arena_block*)json_c_malloc(NULL, JSON_ARENA_BLOCK_HDR + size);
+  if(!b) return NULL;
+  b->size = size;
+  b->used = 0;
+  arena->blocks++;
+  return b;
+}
+
+void* json_arena_alloc(json_arena_t *arena, size_t size)
+{
+  struct json_arena_block *b = arena->head;
+  void *p;
+
+  size = JSON_ARENA_ALIGN(size ? size : 1);
+  if(size > arena->block_size / 2) {
+    /* Large allocations get a block of their own behind the current one,
+     * so the room left in the current block is not lost */
+    struct json_arena_block *nb = json_arena_new_block(arena, size);
+    if(!nb) return NULL;
+    nb->used = size;
+    nb->next = b->next;
+    b->next = nb;
+    arena->used += size;
+    arena->last = NULL;
+    return JSON_ARENA_BLOCK_DATA(nb);
+  }
+  if(b->size - b->used < size) {
+    b = json_arena_new_block(arena, arena->block_size);
+    if(!b) return NULL;
+    b->next = arena->head;
+    arena->head = b;
+  }
+  p = json_arena_data(arena, b) + b->used;
+  b->used += size;
+  arena->used += size;
+  arena->last = p;
+  return p;
+}
+
+size_t json_arena_used(json_arena_t *arena)
+{
+  return arena ? arena->used : 0;
+}
+
+int json_arena_blocks(json_arena_t *arena)
+{
+  return arena ? arena->blocks : 0;
+}
+
+void* json_c_malloc(json_arena_t *arena, size_t size)
+{
+  if(arena) return json_arena_alloc(arena, size);
+  json_c_heap_op_count++;
+  return malloc(size);
+}
+
+void* json_c_calloc(json_arena_t *arena, size_t nmemb, size_t size)
+{
+  void *p;
+
+  if(!arena) {
+    json_c_heap_op_count++;
+    return calloc(nmemb, size);
+  }
+  p = json_arena_alloc(arena, nmemb * size);
+  if(p) memset(p, 0, nmemb * size);
+  return p;
+}
+
+void* json_c_realloc(json_arena_t *arena, void *ptr, size_t old_size, size_t size)
+{
+  struct json_arena_block *b;
+  char *data;
+  void *p;
+
+  if(!arena) {
+    json_c_heap_op_count++;
+    return realloc(ptr, size);
+  }
+  if(ptr == NULL) return json_arena_alloc(arena, size);
+
+  b = arena->head;
+  data = json_arena_data(arena, b);
+  if(ptr == arena->last) {
+    size_t offset = (char*)ptr - data;
+    size_t old_aligned = b->used - offset;
+    size_t new_aligned = JSON_ARENA_ALIGN(size);
+    if(offset + new_aligned <= b->size) {
+      b->used = offset + new_aligned;
+      arena->used = arena->used - old_aligned + new_aligned;
+      return ptr;
+    }
+  }
+  p = json_arena_alloc(arena, size);
+  if(p) memcpy(p, ptr, old_size < size ? old_size : size);
+  return p;
+}
+
+char* json_c_strdup(json_arena_t *arena, const char *str)
+{
+  size_t len = strlen(str) + 1;
+  char *s = (char*)json_c_malloc(arena, len);
+
+  if(s) memcpy(s, str, len);
+  return s;
+}
+
+void json_c_free(json_arena_t *arena, void *ptr)
+{
+  if(arena || !ptr) return;
+  json_c_heap_op_count++;
+  free(ptr);
+}
+
+unsigned long json_c_heap_ops(void)
+{
+  return json_c_heap_op_count;
+}
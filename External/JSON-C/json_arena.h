@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2014 MXCHIP Inc.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See COPYING for details.
+ *
+ */
+
+#ifndef _json_arena_h_
+#define _json_arena_h_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per document arena. Objects, tables, arrays, strings and printbufs made
+ * with the *_arena() constructors, or by a tokener created on an arena,
+ * are carved out of a few large blocks instead of one heap allocation
+ * each. json_object_put() still works on them but returns nothing to the
+ * heap, all the memory goes back at once in json_arena_free(). Nothing
+ * made on an arena may be used after that.
+ *
+ * An arena is not locked, use it from one thread at a time.
+ */
+
+#define JSON_ARENA_DEF_BLOCK_SIZE 1024
+
+typedef struct json_arena json_arena_t;
+
+/* block_size is the size of every new block, 0 for the default. Larger
+ * allocations get a block of their own */
+extern json_arena_t* json_arena_new(size_t block_size);
+extern void json_arena_free(json_arena_t *arena);
+extern void* json_arena_alloc(json_arena_t *arena, size_t size);
+/* Bytes handed out so far, and the number of blocks behind them */
+extern size_t json_arena_used(json_arena_t *arena);
+extern int json_arena_blocks(json_arena_t *arena);
+
+/* Allocators used inside json-c, they go to the heap when arena is NULL.
+ * json_c_free() does nothing for arena memory, json_c_realloc() grows
+ * the last arena allocation in place when the block has room left */
+extern void* json_c_malloc(json_arena_t *arena, size_t size);
+extern void* json_c_calloc(json_arena_t *arena, size_t nmemb, size_t size);
+extern void* json_c_realloc(json_arena_t *arena, void *ptr, size_t old_size, size_t size);
+extern char* json_c_strdup(json_arena_t *arena, const char *str);
+extern void json_c_free(json_arena_t *arena, void *ptr);
+
+/* Heap calls made by json-c since start up, not locked so only a rough
+ * figure when several threads use json-c at the same time */
+extern unsigned long json_c_heap_ops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
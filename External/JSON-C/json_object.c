@@ -37,7 +37,7 @@ const char *json_number_chars = "0123456789.+-eE";
 const char *json_hex_chars = "0123456789abcdef";
 
 static void json_object_generic_delete(struct json_object* jso);
-static struct json_object* json_object_new(enum json_type o_type);
+static struct json_object* json_object_new(enum json_type o_type, json_arena_t *arena);
 
 
 /* ref count debugging */
@@ -144,16 +144,17 @@ static void json_object_generic_delete(struct json_object* jso)
   lh_table_delete(json_object_table, jso);
 #endif /* REFCOUNT_DEBUG */
   printbuf_free(jso->_pb);
-  free(jso);
+  json_c_free(jso->_arena, jso);
 }
 
-static struct json_object* json_object_new(enum json_type o_type)
+static struct json_object* json_object_new(enum json_type o_type, json_arena_t *arena)
 {
   struct json_object *jso;
 
-  jso = (struct json_object*)calloc(sizeof(struct json_object), 1);
+  jso = (struct json_object*)json_c_calloc(arena, sizeof(struct json_object), 1);
   if(!jso) return NULL;
   jso->o_type = o_type;
+  jso->_arena = arena;
   jso->_ref_count = 1;
   jso->_delete = &json_object_generic_delete;
 #ifdef REFCOUNT_DEBUG
@@ -176,13 +177,19 @@ enum json_type json_object_get_type(struct json_object *jso)
   return jso->o_type;
 }
 
+json_arena_t* json_object_get_arena(struct json_object *jso)
+{
+  if(!jso) return NULL;
+  return jso->_arena;
+}
+
 /* json_object_to_json_string */
 
 const char* json_object_to_json_string(struct json_object *jso)
 {
   if(!jso) return "null";
   if(!jso->_pb) {
-    if(!(jso->_pb = printbuf_new())) return NULL;
+    if(!(jso->_pb = printbuf_new_arena(jso->_arena))) return NULL;
   } else {
     printbuf_reset(jso->_pb);
   }
@@ -195,7 +202,7 @@ struct printbuf * json_object_to_json_string_ex(struct json_object *jso)
   struct printbuf *_pb;
   if(!jso) return NULL;
 
-  if(!(_pb = printbuf_new())) return NULL;
+  if(!(_pb = printbuf_new_arena(jso->_arena))) return NULL;
 
   if(jso->_to_json_string(jso, _pb) < 0) return NULL;
   return _pb;
@@ -232,6 +239,12 @@ static void json_object_lh_entry_free(struct lh_entry *ent)
   json_object_put((struct json_object*)ent->v);
 }
 
+/* Keys of an arena object are in the arena too */
+static void json_object_lh_arena_entry_free(struct lh_entry *ent)
+{
+  json_object_put((struct json_object*)ent->v);
+}
+
 static void json_object_object_delete(struct json_object* jso)
 {
   lh_table_free(jso->o.c_object);
@@ -240,12 +253,18 @@ static void json_object_object_delete(struct json_object* jso)
 
 struct json_object* json_object_new_object(void)
 {
-  struct json_object *jso = json_object_new(json_type_object);
+  return json_object_new_object_arena(NULL);
+}
+
+struct json_object* json_object_new_object_arena(json_arena_t *arena)
+{
+  struct json_object *jso = json_object_new(json_type_object, arena);
   if(!jso) return NULL;
   jso->_delete = &json_object_object_delete;
   jso->_to_json_string = &json_object_object_to_json_string;
-  jso->o.c_object = lh_kchar_table_new(JSON_OBJECT_DEF_HASH_ENTRIES,
-					NULL, &json_object_lh_entry_free);
+  jso->o.c_object = lh_table_new_arena(JSON_OBJECT_DEF_HASH_ENTRIES, NULL,
+					arena ? &json_object_lh_arena_entry_free : &json_object_lh_entry_free,
+					lh_char_hash, lh_char_equal, arena);
   return jso;
 }
 
@@ -264,7 +283,7 @@ void json_object_object_add(struct json_object* jso, const char *key,
 			    struct json_object *val)
 {
   lh_table_delete(jso->o.c_object, key);
-  lh_table_insert(jso->o.c_object, strdup(key), val);
+  lh_table_insert(jso->o.c_object, json_c_strdup(jso->_arena, key), val);
 }
 
 struct json_object* json_object_object_get(struct json_object* jso, const char *key)
@@ -290,7 +309,12 @@ static int json_object_boolean_to_json_string(struct json_object* jso,
 
 struct json_object* json_object_new_boolean(boolean b)
 {
-  struct json_object *jso = json_object_new(json_type_boolean);
+  return json_object_new_boolean_arena(NULL, b);
+}
+
+struct json_object* json_object_new_boolean_arena(json_arena_t *arena, boolean b)
+{
+  struct json_object *jso = json_object_new(json_type_boolean, arena);
   if(!jso) return NULL;
   jso->_to_json_string = &json_object_boolean_to_json_string;
   jso->o.c_boolean = b;
@@ -325,7 +349,12 @@ static int json_object_int_to_json_string(struct json_object* jso,
 
 struct json_object* json_object_new_int(int32_t i)
 {
-  struct json_object *jso = json_object_new(json_type_int);
+  return json_object_new_int_arena(NULL, i);
+}
+
+struct json_object* json_object_new_int_arena(json_arena_t *arena, int32_t i)
+{
+  struct json_object *jso = json_object_new(json_type_int, arena);
   if(!jso) return NULL;
   jso->_to_json_string = &json_object_int_to_json_string;
   jso->o.c_int64 = i;
@@ -370,7 +399,12 @@ int32_t json_object_get_int(struct json_object *jso)
 
 struct json_object* json_object_new_int64(int64_t i)
 {
-  struct json_object *jso = json_object_new(json_type_int);
+  return json_object_new_int64_arena(NULL, i);
+}
+
+struct json_object* json_object_new_int64_arena(json_arena_t *arena, int64_t i)
+{
+  struct json_object *jso = json_object_new(json_type_int, arena);
   if(!jso) return NULL;
   jso->_to_json_string = &json_object_int_to_json_string;
   jso->o.c_int64 = i;
@@ -407,7 +441,12 @@ static int json_object_double_to_json_string(struct json_object* jso,
 
 struct json_object* json_object_new_double(double d)
 {
-  struct json_object *jso = json_object_new(json_type_double);
+  return json_object_new_double_arena(NULL, d);
+}
+
+struct json_object* json_object_new_double_arena(json_arena_t *arena, double d)
+{
+  struct json_object *jso = json_object_new(json_type_double, arena);
   if(!jso) return NULL;
   jso->_to_json_string = &json_object_double_to_json_string;
   jso->o.c_double = d;
@@ -447,29 +486,40 @@ static int json_object_string_to_json_string(struct json_object* jso,
 
 static void json_object_string_delete(struct json_object* jso)
 {
-  free(jso->o.c_string.str);
+  json_c_free(jso->_arena, jso->o.c_string.str);
   json_object_generic_delete(jso);
 }
 
 struct json_object* json_object_new_string(const char *s)
 {
-  struct json_object *jso = json_object_new(json_type_string);
+  return json_object_new_string_arena(NULL, s);
+}
+
+struct json_object* json_object_new_string_arena(json_arena_t *arena, const char *s)
+{
+  struct json_object *jso = json_object_new(json_type_string, arena);
   if(!jso) return NULL;
   jso->_delete = &json_object_string_delete;
   jso->_to_json_string = &json_object_string_to_json_string;
-  jso->o.c_string.str = strdup(s);
+  jso->o.c_string.str = json_c_strdup(arena, s);
   jso->o.c_string.len = strlen(s);
   return jso;
 }
 
 struct json_object* json_object_new_string_len(const char *s, int len)
 {
-  struct json_object *jso = json_object_new(json_type_string);
+  return json_object_new_string_len_arena(NULL, s, len);
+}
+
+struct json_object* json_object_new_string_len_arena(json_arena_t *arena, const char *s, int len)
+{
+  struct json_object *jso = json_object_new(json_type_string, arena);
   if(!jso) return NULL;
   jso->_delete = &json_object_string_delete;
   jso->_to_json_string = &json_object_string_to_json_string;
-  jso->o.c_string.str = malloc(len);
+  jso->o.c_string.str = json_c_malloc(arena, len + 1);
   memcpy(jso->o.c_string.str, (void *)s, len);
+  jso->o.c_string.str[len] = '\0';
   jso->o.c_string.len = len;
   return jso;
 }
@@ -528,11 +578,16 @@ static void json_object_array_delete(struct json_object* jso)
 
 struct json_object* json_object_new_array(void)
 {
-  struct json_object *jso = json_object_new(json_type_array);
+  return json_object_new_array_arena(NULL);
+}
+
+struct json_object* json_object_new_array_arena(json_arena_t *arena)
+{
+  struct json_object *jso = json_object_new(json_type_array, arena);
   if(!jso) return NULL;
   jso->_delete = &json_object_array_delete;
   jso->_to_json_string = &json_object_array_to_json_string;
-  jso->o.c_array = array_list_new(&json_object_array_entry_free);
+  jso->o.c_array = array_list_new_arena(&json_object_array_entry_free, arena);
   return jso;
 }
 
@@ -107,6 +107,28 @@ extern int json_object_is_type(struct json_object *obj, enum json_type type);
  */
 extern enum json_type json_object_get_type(struct json_object *obj);
 
+/* arena methods */
+
+/** Get the arena a json_object was made on, see json_arena.h
+ * @param obj the json_object instance
+ * @returns the arena, or NULL for an object on the heap
+ */
+extern json_arena_t* json_object_get_arena(struct json_object *obj);
+
+/* The json_object_new_*() constructors below, taking their memory from
+ * an arena. Members and elements added later to an arena object or
+ * array, and the printbuf of json_object_to_json_string(), come from
+ * the same arena. A NULL arena gives the same result as the constructor
+ * without the suffix. */
+extern struct json_object* json_object_new_object_arena(json_arena_t *arena);
+extern struct json_object* json_object_new_array_arena(json_arena_t *arena);
+extern struct json_object* json_object_new_boolean_arena(json_arena_t *arena, boolean b);
+extern struct json_object* json_object_new_int_arena(json_arena_t *arena, int32_t i);
+extern struct json_object* json_object_new_int64_arena(json_arena_t *arena, int64_t i);
+extern struct json_object* json_object_new_double_arena(json_arena_t *arena, double d);
+extern struct json_object* json_object_new_string_arena(json_arena_t *arena, const char *s);
+extern struct json_object* json_object_new_string_len_arena(json_arena_t *arena, const char *s, int len);
+
 
 /** Stringify object to json format
  * @param obj the json_object instance
@@ -27,6 +27,7 @@ struct json_object
   json_object_to_json_string_fn *_to_json_string;
   int _ref_count;
   struct printbuf *_pb;
+  json_arena_t *_arena;
   union data {
     boolean c_boolean;
     double c_double;
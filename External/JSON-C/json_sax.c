@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2014 MXCHIP Inc.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See COPYING for details.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "bits.h"
+#include "debug.h"
+#include "json_inttypes.h"
+#include "json_util.h"
+#include "json_sax.h"
+
+static int json_sax_parse_value(struct json_sax *sax, const char *key);
+
+static void json_sax_null_callback(void *userdata, const struct json_sax_value *value)
+{
+  (void)userdata;
+  (void)value;
+}
+
+static void json_sax_eatws(struct json_sax *sax)
+{
+  const char *str = sax->str;
+
+  while(str < sax->end) {
+    if(*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n') {
+      str++;
+    } else if(*str == '/' && str + 1 < sax->end && str[1] == '*') {
+      for(str += 2; str + 1 < sax->end && !(str[0] == '*' && str[1] == '/'); str++);
+      str = (str + 1 < sax->end) ? str + 2 : sax->end;
+    } else if(*str == '/' && str + 1 < sax->end && str[1] == '/') {
+      for(str += 2; str < sax->end && *str != '\n'; str++);
+    } else {
+      break;
+    }
+  }
+  sax->str = str;
+}
+
+static int json_sax_fail(struct json_sax *sax, enum json_tokener_error err)
+{
+  if(sax->err == json_tokener_success)
+    sax->err = (sax->str >= sax->end) ? json_tokener_error_parse_eof : err;
+  return -1;
+}
+
+static int json_sax_put_utf8(char *out, int pos, int size, unsigned int uc)
+{
+  unsigned char utf8[4];
+  int len;
+
+  if(uc < 0x80) {
+    utf8[0] = uc;
+    len = 1;
+  } else if(uc < 0x800) {
+    utf8[0] = 0xc0 | (uc >> 6);
+    utf8[1] = 0x80 | (uc & 0x3f);
+    len = 2;
+  } else if(uc < 0x10000) {
+    utf8[0] = 0xe0 | (uc >> 12);
+    utf8[1] = 0x80 | ((uc >> 6) & 0x3f);
+    utf8[2] = 0x80 | (uc & 0x3f);
+    len = 3;
+  } else {
+    utf8[0] = 0xf0 | (uc >> 18);
+    utf8[1] = 0x80 | ((uc >> 12) & 0x3f);
+    utf8[2] = 0x80 | ((uc >> 6) & 0x3f);
+    utf8[3] = 0x80 | (uc & 0x3f);
+    len = 4;
+  }
+  if(pos + len >= size) return -1;
+  memcpy(out + pos, utf8, len);
+  return pos + len;
+}
+
+static int json_sax_hex4(struct json_sax *sax, unsigned int *uc)
+{
+  int i;
+  char c;
+
+  if(sax->end - sax->str < 4) return -1;
+  *uc = 0;
+  for(i = 0; i < 4; i++) {
+    c = *sax->str++;
+    *uc <<= 4;
+    if(c >= '0' && c <= '9') *uc |= c - '0';
+    else if(c >= 'a' && c <= 'f') *uc |= c - 'a' + 10;
+    else if(c >= 'A' && c <= 'F') *uc |= c - 'A' + 10;
+    else return -1;
+  }
+  return 0;
+}
+
+/* Unescape the string at sax->str into out, returns its length */
+static int json_sax_parse_string(struct json_sax *sax, char *out, int size)
+{
+  char quote_char = *sax->str++;
+  unsigned int uc, lo;
+  int len = 0;
+  char c;
+
+  while(sax->str < sax->end) {
+    c = *sax->str++;
+    if(c == quote_char) {
+      out[len] = '\0';
+      return len;
+    }
+    if(c == '\\') {
+      if(sax->str >= sax->end) break;
+      c = *sax->str++;
+      switch(c) {
+      case '"': case '\\': case '/': case '\'': break;
+      case 'b': c = '\b'; break;
+      case 'f': c = '\f'; break;
+      case 'n': c = '\n'; break;
+      case 'r': c = '\r'; break;
+      case 't': c = '\t'; break;
+      case 'u':
+        if(json_sax_hex4(sax, &uc) != 0) goto error;
+        if((uc & 0xFC00) == 0xD800 && sax->end - sax->str >= 6
+           && sax->str[0] == '\\' && sax->str[1] == 'u') {
+          sax->str += 2;
+          if(json_sax_hex4(sax, &lo) != 0) goto error;
+          if((lo & 0xFC00) == 0xDC00) uc = (((uc & 0x3FF) << 10) | (lo & 0x3FF)) + 0x10000;
+          else uc = 0xFFFD;
+        } else if((uc & 0xFC00) == 0xD800 || (uc & 0xFC00) == 0xDC00) {
+          uc = 0xFFFD;
+        }
+        len = json_sax_put_utf8(out, len, size, uc);
+        if(len < 0) goto error;
+        continue;
+      default:
+        goto error;
+      }
+    }
+    if(len + 1 >= size) goto error;
+    out[len++] = c;
+  }
+
+error:
+  return json_sax_fail(sax, json_tokener_error_parse_string);
+}
+
+static void json_sax_init_value(struct json_sax_value *value, enum json_sax_event event,
+                                enum json_type type, int depth, const char *key)
+{
+  memset(value, 0, sizeof(struct json_sax_value));
+  value->event = event;
+  value->type = type;
+  value->depth = depth;
+  value->key = key;
+}
+
+static int json_sax_parse_literal(struct json_sax *sax, const char *key, const char *literal,
+                                  enum json_type type, boolean c_boolean)
+{
+  struct json_sax_value value;
+  size_t len = strlen(literal);
+
+  if((size_t)(sax->end - sax->str) < len || strncmp(sax->str, literal, len) != 0)
+    return json_sax_fail(sax, type == json_type_null ? json_tokener_error_parse_null
+                                                     : json_tokener_error_parse_boolean);
+  sax->str += len;
+  json_sax_init_value(&value, json_sax_event_value, type, sax->depth, key);
+  value.str = literal;
+  value.str_len = len;
+  value.c_boolean = c_boolean;
+  value.c_int64 = c_boolean;
+  sax->callback(sax->userdata, &value);
+  return 0;
+}
+
+static int json_sax_parse_number(struct json_sax *sax, const char *key)
+{
+  struct json_sax_value value;
+  boolean is_double = FALSE;
+  int len = 0;
+  char c;
+
+  while(sax->str < sax->end) {
+    c = *sax->str;
+    if(c == '.' || c == 'e' || c == 'E') is_double = TRUE;
+    else if(!(c >= '0' && c <= '9') && c != '-' && c != '+') break;
+    if(len + 1 >= JSON_SAX_MAX_STRING) return json_sax_fail(sax, json_tokener_error_parse_number);
+    sax->buf[len++] = c;
+    sax->str++;
+  }
+  sax->buf[len] = '\0';
+
+  json_sax_init_value(&value, json_sax_event_value, is_double ? json_type_double : json_type_int, sax->depth, key);
+  value.str = sax->buf;
+  value.str_len = len;
+  if(is_double) {
+    char *num_end;
+    value.c_double = strtod(sax->buf, &num_end);
+    if(len == 0 || num_end != sax->buf + len) return json_sax_fail(sax, json_tokener_error_parse_number);
+  } else {
+    if(len == 0 || json_parse_int64(sax->buf, &value.c_int64) != 0) return json_sax_fail(sax, json_tokener_error_parse_number);
+  }
+  /* The text json_object_get_string() gives, json-c prints its int64 with %d */
+  if(is_double)
+    value.str_len = snprintf(sax->buf, JSON_SAX_MAX_STRING, "%g", value.c_double);
+  else
+    value.str_len = snprintf(sax->buf, JSON_SAX_MAX_STRING, "%d", (int)(int32_t)value.c_int64);
+  sax->callback(sax->userdata, &value);
+  return 0;
+}
+
+static int json_sax_parse_container(struct json_sax *sax, const char *key, boolean is_object)
+{
+  struct json_sax_value value;
+  char close_char = is_object ? '}' : ']';
+
+  if(sax->depth >= JSON_TOKENER_MAX_DEPTH) return json_sax_fail(sax, json_tokener_error_depth);
+
+  json_sax_init_value(&value, is_object ? json_sax_event_object_start : json_sax_event_array_start,
+                      is_object ? json_type_object : json_type_array, sax->depth, key);
+  sax->callback(sax->userdata, &value);
+  sax->str++;
+  sax->depth++;
+
+  json_sax_eatws(sax);
+  if(sax->str < sax->end && *sax->str == close_char) goto done;
+
+  while(1) {
+    json_sax_eatws(sax);
+    if(is_object) {
+      if(sax->str >= sax->end || (*sax->str != '"' && *sax->str != '\''))
+        return json_sax_fail(sax, json_tokener_error_parse_object_key_name);
+      if(json_sax_parse_string(sax, sax->key, JSON_SAX_MAX_KEY) < 0) return -1;
+      json_sax_eatws(sax);
+      if(sax->str >= sax->end || *sax->str != ':')
+        return json_sax_fail(sax, json_tokener_error_parse_object_key_sep);
+      sax->str++;
+      if(json_sax_parse_value(sax, sax->key) < 0) return -1;
+    } else {
+      if(json_sax_parse_value(sax, NULL) < 0) return -1;
+    }
+    json_sax_eatws(sax);
+    if(sax->str < sax->end && *sax->str == close_char) break;
+    if(sax->str >= sax->end || *sax->str != ',')
+      return json_sax_fail(sax, is_object ? json_tokener_error_parse_object_value_sep
+                                          : json_tokener_error_parse_array);
+    sax->str++;
+    /* json_tokener takes a trailing comma */
+    json_sax_eatws(sax);
+    if(sax->str < sax->end && *sax->str == close_char) break;
+  }
+
+done:
+  sax->str++;
+  sax->depth--;
+  json_sax_init_value(&value, is_object ? json_sax_event_object_end : json_sax_event_array_end,
+                      is_object ? json_type_object : json_type_array, sax->depth, NULL);
+  sax->callback(sax->userdata, &value);
+  return 0;
+}
+
+static int json_sax_parse_value(struct json_sax *sax, const char *key)
+{
+  struct json_sax_value value;
+  int len;
+
+  json_sax_eatws(sax);
+  if(sax->str >= sax->end) return json_sax_fail(sax, json_tokener_error_parse_eof);
+
+  switch(*sax->str) {
+  case '{':
+    return json_sax_parse_container(sax, key, TRUE);
+  case '[':
+    return json_sax_parse_container(sax, key, FALSE);
+  case '"':
+  case '\'':
+    len = json_sax_parse_string(sax, sax->buf, JSON_SAX_MAX_STRING);
+    if(len < 0) return -1;
+    json_sax_init_value(&value, json_sax_event_value, json_type_string, sax->depth, key);
+    value.str = sax->buf;
+    value.str_len = len;
+    sax->callback(sax->userdata, &value);
+    return 0;
+  case 'n':
+    return json_sax_parse_literal(sax, key, "null", json_type_null, FALSE);
+  case 't':
+    return json_sax_parse_literal(sax, key, "true", json_type_boolean, TRUE);
+  case 'f':
+    return json_sax_parse_literal(sax, key, "false", json_type_boolean, FALSE);
+  default:
+    if((*sax->str >= '0' && *sax->str <= '9') || *sax->str == '-')
+      return json_sax_parse_number(sax, key);
+    return json_sax_fail(sax, json_tokener_error_parse_unexpected);
+  }
+}
+
+enum json_tokener_error json_sax_parse(struct json_sax *sax, const char *str, int len,
+                                       json_sax_callback *callback, void *userdata)
+{
+  if(len < 0) len = strlen(str);
+  sax->str = str;
+  sax->end = str + len;
+  sax->depth = 0;
+  sax->err = json_tokener_success;
+  sax->callback = callback ? callback : json_sax_null_callback;
+  sax->userdata = userdata;
+
+  /* Same as json_tokener_parse(), the document ends with its first value
+   * and whatever follows is not looked at */
+  json_sax_parse_value(sax, NULL);
+  if(sax->err != json_tokener_success)
+    MC_DEBUG("json_sax_parse: %s at offset %d\n", json_tokener_errors[sax->err], (int)(sax->str - str));
+  return sax->err;
+}
+
+boolean json_sax_get_boolean(const struct json_sax_value *value)
+{
+  switch(value->type) {
+  case json_type_boolean:
+    return value->c_boolean;
+  case json_type_int:
+    return (value->c_int64 != 0);
+  case json_type_double:
+    return (value->c_double != 0);
+  case json_type_string:
+    return (value->str_len != 0);
+  default:
+    return FALSE;
+  }
+}
+
+int32_t json_sax_get_int(const struct json_sax_value *value)
+{
+  int64_t cint64 = value->c_int64;
+
+  switch(value->type) {
+  case json_type_string:
+    if(json_parse_int64(value->str, &cint64) != 0)
+      return 0;
+    /* fall through */
+  case json_type_int:
+    if(cint64 <= INT32_MIN)
+      return INT32_MIN;
+    else if(cint64 >= INT32_MAX)
+      return INT32_MAX;
+    else
+      return (int32_t)cint64;
+  case json_type_double:
+    return (int32_t)value->c_double;
+  case json_type_boolean:
+    return value->c_boolean;
+  default:
+    return 0;
+  }
+}
+
+const char* json_sax_get_string(const struct json_sax_value *value)
+{
+  if(value->event != json_sax_event_value) return NULL;
+  return value->str;
+}
+
+static uint32_t json_sax_hash(uint32_t seed, const char *key)
+{
+  uint32_t h = 2166136261U ^ seed;
+
+  while(*key) {
+    h ^= (unsigned char)*key++;
+    h *= 16777619U;
+  }
+  return h ^ (h >> 15);
+}
+
+int json_sax_keys_init(struct json_sax_keys *keys, const char * const *names, int count)
+{
+  uint32_t seed;
+  int i, slot;
+
+  if(count <= 0 || count > JSON_SAX_KEY_SLOTS / 2) return -1;
+  keys->names = names;
+  keys->count = count;
+
+  for(seed = 0; seed < 1024; seed++) {
+    memset(keys->slot, 0, sizeof(keys->slot));
+    for(i = 0; i < count; i++) {
+      slot = json_sax_hash(seed, names[i]) & (JSON_SAX_KEY_SLOTS - 1);
+      if(keys->slot[slot]) break;
+      keys->slot[slot] = i + 1;
+    }
+    if(i == count) {
+      keys->seed = seed;
+      return 0;
+    }
+  }
+  keys->count = 0;
+  return -1;
+}
+
+int json_sax_keys_find(const struct json_sax_keys *keys, const char *key)
+{
+  int i;
+
+  if(keys->count == 0 || key == NULL) return -1;
+  i = keys->slot[json_sax_hash(keys->seed, key) & (JSON_SAX_KEY_SLOTS - 1)];
+  if(i == 0 || strcmp(keys->names[i - 1], key) != 0) return -1;
+  return i - 1;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014 MXCHIP Inc.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See COPYING for details.
+ *
+ */
+
+#ifndef _json_sax_h_
+#define _json_sax_h_
+
+#include <stddef.h>
+#include "json_inttypes.h"
+#include "json_object.h"
+#include "json_tokener.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Callback parser: every value is reported as it is parsed and no
+ * json_object tree is built. Keys and strings are unescaped into fixed
+ * buffers inside struct json_sax, nothing is allocated.
+ */
+
+#define JSON_SAX_MAX_KEY     64
+#define JSON_SAX_MAX_STRING  256
+
+enum json_sax_event {
+  json_sax_event_value,
+  json_sax_event_object_start,
+  json_sax_event_object_end,
+  json_sax_event_array_start,
+  json_sax_event_array_end
+};
+
+struct json_sax_value
+{
+  enum json_sax_event event;
+  enum json_type type;
+  /* 1 for the members of the top level object */
+  int depth;
+  /* Member name, NULL for array elements, the top level value and *_end events */
+  const char *key;
+  /* Unescaped string, the text of a number as json_object_get_string()
+   * gives it, or true, false or null */
+  const char *str;
+  int str_len;
+  boolean c_boolean;
+  int64_t c_int64;
+  double c_double;
+};
+
+typedef void (json_sax_callback)(void *userdata, const struct json_sax_value *value);
+
+struct json_sax
+{
+  const char *str, *end;
+  int depth;
+  enum json_tokener_error err;
+  json_sax_callback *callback;
+  void *userdata;
+  char key[JSON_SAX_MAX_KEY];
+  char buf[JSON_SAX_MAX_STRING];
+};
+
+/* Parse len bytes of str (up to the terminating NUL when len < 0), a NULL
+ * callback only checks the document */
+extern enum json_tokener_error json_sax_parse(struct json_sax *sax, const char *str, int len,
+                                              json_sax_callback *callback, void *userdata);
+
+/* Same conversions as json_object_get_boolean(), _int() and _string() */
+extern boolean json_sax_get_boolean(const struct json_sax_value *value);
+extern int32_t json_sax_get_int(const struct json_sax_value *value);
+extern const char* json_sax_get_string(const struct json_sax_value *value);
+
+/*
+ * Perfect hash of a fixed set of member names. json_sax_keys_init() looks
+ * for a seed that gives every name its own slot, so json_sax_keys_find()
+ * costs one hash and one strcmp whatever the number of names.
+ */
+
+#define JSON_SAX_KEY_SLOTS   64
+
+struct json_sax_keys
+{
+  const char * const *names;
+  int count;
+  uint32_t seed;
+  /* Index of the name plus one, 0 for an empty slot */
+  unsigned char slot[JSON_SAX_KEY_SLOTS];
+};
+
+extern int json_sax_keys_init(struct json_sax_keys *keys, const char * const *names, int count);
+/* Returns the index of key in names, -1 when it is not one of them */
+extern int json_sax_keys_find(const struct json_sax_keys *keys, const char *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -70,12 +70,18 @@ static unsigned char utf8_replacement_char[3] = { 0xEF, 0xBF, 0xBD };
 
 
 struct json_tokener* json_tokener_new(void)
+{
+  return json_tokener_new_arena(NULL);
+}
+
+struct json_tokener* json_tokener_new_arena(json_arena_t *arena)
 {
   struct json_tokener *tok;
 
-  tok = (struct json_tokener*)calloc(1, sizeof(struct json_tokener));
+  tok = (struct json_tokener*)json_c_calloc(arena, 1, sizeof(struct json_tokener));
   if (!tok) return NULL;
-  tok->pb = printbuf_new();
+  tok->arena = arena;
+  tok->pb = printbuf_new_arena(arena);
   json_tokener_reset(tok);
   return tok;
 }
@@ -83,8 +89,10 @@ struct json_tokener* json_tokener_new(void)
 void json_tokener_free(struct json_tokener *tok)
 {
   json_tokener_reset(tok);
-  if(tok) printbuf_free(tok->pb);
-  free(tok);
+  if(tok) {
+    printbuf_free(tok->pb);
+    json_c_free(tok->arena, tok);
+  }
 }
 
 static void json_tokener_reset_level(struct json_tokener *tok, int depth)
@@ -93,7 +101,7 @@ static void json_tokener_reset_level(struct json_tokener *tok, int depth)
   tok->stack[depth].saved_state = json_tokener_state_start;
   json_object_put(tok->stack[depth].current);
   tok->stack[depth].current = NULL;
-  free(tok->stack[depth].obj_field_name);
+  json_c_free(tok->arena, tok->stack[depth].obj_field_name);
   tok->stack[depth].obj_field_name = NULL;
 }
 
@@ -110,11 +118,17 @@ void json_tokener_reset(struct json_tokener *tok)
 }
 
 struct json_object* json_tokener_parse(const char *str)
+{
+  return json_tokener_parse_arena(str, NULL);
+}
+
+struct json_object* json_tokener_parse_arena(const char *str, json_arena_t *arena)
 {
   struct json_tokener* tok;
   struct json_object* obj;
 
-  tok = json_tokener_new();
+  tok = json_tokener_new_arena(arena);
+  if(!tok) return NULL;
   obj = json_tokener_parse_ex(tok, str, -1);
   if(tok->err != json_tokener_success)
     obj = NULL;
@@ -241,12 +255,12 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
       case '{':
 	state = json_tokener_state_eatws;
 	saved_state = json_tokener_state_object_field_start;
-	current = json_object_new_object();
+	current = json_object_new_object_arena(tok->arena);
 	break;
       case '[':
 	state = json_tokener_state_eatws;
 	saved_state = json_tokener_state_array;
-	current = json_object_new_array();
+	current = json_object_new_array_arena(tok->arena);
 	break;
       case 'N':
       case 'n':
@@ -377,7 +391,7 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 	while(1) {
 	  if(c == tok->quote_char) {
 	    printbuf_memappend_fast(tok->pb, case_start, str-case_start);
-	    current = json_object_new_string(tok->pb->buf);
+	    current = json_object_new_string_arena(tok->arena, tok->pb->buf);
 	    saved_state = json_tokener_state_finish;
 	    state = json_tokener_state_eatws;
 	    break;
@@ -525,7 +539,7 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
       if(strncasecmp(json_true_str, tok->pb->buf,
 		     json_min(tok->st_pos+1, strlen(json_true_str))) == 0) {
 	if(tok->st_pos == strlen(json_true_str)) {
-	  current = json_object_new_boolean(1);
+	  current = json_object_new_boolean_arena(tok->arena, 1);
 	  saved_state = json_tokener_state_finish;
 	  state = json_tokener_state_eatws;
 	  goto redo_char;
@@ -533,7 +547,7 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
       } else if(strncasecmp(json_false_str, tok->pb->buf,
 			    json_min(tok->st_pos+1, strlen(json_false_str))) == 0) {
 	if(tok->st_pos == strlen(json_false_str)) {
-	  current = json_object_new_boolean(0);
+	  current = json_object_new_boolean_arena(tok->arena, 0);
 	  saved_state = json_tokener_state_finish;
 	  state = json_tokener_state_eatws;
 	  goto redo_char;
@@ -565,9 +579,9 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 	int64_t num64;
 	double  numd;
 	if (!tok->is_double && json_parse_int64(tok->pb->buf, &num64) == 0) {
-		current = json_object_new_int64(num64);
+		current = json_object_new_int64_arena(tok->arena, num64);
 	} else if(tok->is_double && sscanf(tok->pb->buf, "%lf", &numd) == 1) {
-          current = json_object_new_double(numd);
+          current = json_object_new_double_arena(tok->arena, numd);
         } else {
           tok->err = json_tokener_error_parse_number;
           goto out;
@@ -633,7 +647,7 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 	while(1) {
 	  if(c == tok->quote_char) {
 	    printbuf_memappend_fast(tok->pb, case_start, str-case_start);
-	    obj_field_name = strdup(tok->pb->buf);
+	    obj_field_name = json_c_strdup(tok->arena, tok->pb->buf);
 	    saved_state = json_tokener_state_object_field_end;
 	    state = json_tokener_state_eatws;
 	    break;
@@ -673,7 +687,7 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 
     case json_tokener_state_object_value_add:
       json_object_object_add(current, obj_field_name, obj);
-      free(obj_field_name);
+      json_c_free(tok->arena, obj_field_name);
       obj_field_name = NULL;
       saved_state = json_tokener_state_object_sep;
       state = json_tokener_state_eatws;
@@ -80,14 +80,18 @@ struct json_tokener
   unsigned int ucs_char;
   char quote_char;
   struct json_tokener_srec stack[JSON_TOKENER_MAX_DEPTH];
+  json_arena_t *arena;
 };
 
 extern const char* json_tokener_errors[];
 
 extern struct json_tokener* json_tokener_new(void);
+/* The tokener, and every object it parses, come from the arena */
+extern struct json_tokener* json_tokener_new_arena(json_arena_t *arena);
 extern void json_tokener_free(struct json_tokener *tok);
 extern void json_tokener_reset(struct json_tokener *tok);
 extern struct json_object* json_tokener_parse(const char *str);
+extern struct json_object* json_tokener_parse_arena(const char *str, json_arena_t *arena);
 extern struct json_object* json_tokener_parse_verbose(const char *str, enum json_tokener_error *error);
 extern struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 						 const char *str, int len);
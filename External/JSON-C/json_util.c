@@ -134,6 +134,8 @@
 int json_parse_int64(const char *buf, int64_t *retval)
 {
 	int32_t num64;
+	/* errno is only looked at below, an ERANGE left by an earlier call would stick */
+	errno = 0;
 	if (sscanf(buf, "%d", &num64) != 1)
 	{
 		MC_DEBUG("Failed to parse, sscanf != 1\n");
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2014 MXCHIP Inc.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See COPYING for details.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bits.h"
+#include "debug.h"
+#include "linkhash.h"
+#include "arraylist.h"
+#include "json_inttypes.h"
+#include "json_object.h"
+#include "json_object_private.h"
+#include "json_writer.h"
+
+static const char json_writer_hex_chars[] = "0123456789abcdef";
+
+void json_writer_init(struct json_writer *writer, char *buf, int size,
+                      json_writer_flush_fn *flush, void *userdata)
+{
+  memset(writer, 0, sizeof(struct json_writer));
+  writer->buf = buf;
+  writer->size = size;
+  writer->flush = flush;
+  writer->userdata = userdata;
+}
+
+static int json_writer_flush(struct json_writer *writer)
+{
+  if(writer->err) return -1;
+  if(writer->len > 0 && writer->flush(writer->userdata, writer->buf, writer->len) != 0)
+    writer->err = -1;
+  writer->len = 0;
+  return writer->err;
+}
+
+static int json_writer_append(struct json_writer *writer, const char *data, int len)
+{
+  int n;
+
+  while(len > 0) {
+    if(writer->err) return -1;
+    if(writer->len == writer->size && json_writer_flush(writer) != 0) return -1;
+    n = writer->size - writer->len;
+    if(n > len) n = len;
+    memcpy(writer->buf + writer->len, data, n);
+    writer->len += n;
+    data += n;
+    len -= n;
+  }
+  return writer->err;
+}
+
+/* Comma before every value but the first of a container, none after a key */
+static int json_writer_separate(struct json_writer *writer)
+{
+  uint32_t bit = 1u << writer->depth;
+
+  if(writer->err) return -1;
+  if(writer->after_key) {
+    writer->after_key = FALSE;
+    return 0;
+  }
+  if(writer->not_empty & bit)
+    return json_writer_append(writer, ",", 1);
+  writer->not_empty |= bit;
+  return 0;
+}
+
+static int json_writer_open(struct json_writer *writer, char c)
+{
+  if(json_writer_separate(writer) != 0) return -1;
+  if(writer->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+    writer->err = -1;
+    return -1;
+  }
+  writer->depth++;
+  writer->not_empty &= ~(1u << writer->depth);
+  return json_writer_append(writer, &c, 1);
+}
+
+static int json_writer_close(struct json_writer *writer, char c)
+{
+  if(writer->err) return -1;
+  if(writer->depth == 0) {
+    writer->err = -1;
+    return -1;
+  }
+  writer->depth--;
+  return json_writer_append(writer, &c, 1);
+}
+
+static int json_writer_escape_str(struct json_writer *writer, const char *str, int len)
+{
+  int pos = 0, start_offset = 0;
+  unsigned char c;
+  char esc[6];
+
+  json_writer_append(writer, "\"", 1);
+  while(pos < len) {
+    c = str[pos];
+    if(c >= ' ' && c != '"' && c != '\\' && c != '/') {
+      pos++;
+      continue;
+    }
+    if(pos - start_offset > 0)
+      json_writer_append(writer, str + start_offset, pos - start_offset);
+    esc[0] = '\\';
+    switch(c) {
+    case '\b': esc[1] = 'b'; break;
+    case '\n': esc[1] = 'n'; break;
+    case '\r': esc[1] = 'r'; break;
+    case '\t': esc[1] = 't'; break;
+    case '"':
+    case '\\':
+    case '/': esc[1] = c; break;
+    default:
+      esc[1] = 'u';
+      esc[2] = '0';
+      esc[3] = '0';
+      esc[4] = json_writer_hex_chars[c >> 4];
+      esc[5] = json_writer_hex_chars[c & 0xf];
+      break;
+    }
+    json_writer_append(writer, esc, esc[1] == 'u' ? 6 : 2);
+    start_offset = ++pos;
+  }
+  if(pos - start_offset > 0)
+    json_writer_append(writer, str + start_offset, pos - start_offset);
+  return json_writer_append(writer, "\"", 1);
+}
+
+int json_writer_object_start(struct json_writer *writer)
+{
+  return json_writer_open(writer, '{');
+}
+
+int json_writer_object_end(struct json_writer *writer)
+{
+  return json_writer_close(writer, '}');
+}
+
+int json_writer_array_start(struct json_writer *writer)
+{
+  return json_writer_open(writer, '[');
+}
+
+int json_writer_array_end(struct json_writer *writer)
+{
+  return json_writer_close(writer, ']');
+}
+
+int json_writer_key(struct json_writer *writer, const char *key)
+{
+  if(json_writer_separate(writer) != 0) return -1;
+  json_writer_escape_str(writer, key, strlen(key));
+  writer->after_key = TRUE;
+  return json_writer_append(writer, ":", 1);
+}
+
+int json_writer_string(struct json_writer *writer, const char *str)
+{
+  if(str == NULL) return json_writer_null(writer);
+  if(json_writer_separate(writer) != 0) return -1;
+  return json_writer_escape_str(writer, str, strlen(str));
+}
+
+int json_writer_int(struct json_writer *writer, int64_t i)
+{
+  /* By hand, not every printf on the targets knows about 64 bit integers */
+  char digits[21];
+  int pos = sizeof(digits);
+  uint64_t u = (i < 0) ? (uint64_t)0 - (uint64_t)i : (uint64_t)i;
+
+  if(json_writer_separate(writer) != 0) return -1;
+  do {
+    digits[--pos] = '0' + (u % 10);
+    u /= 10;
+  } while(u);
+  if(i < 0) digits[--pos] = '-';
+  return json_writer_append(writer, digits + pos, sizeof(digits) - pos);
+}
+
+int json_writer_double(struct json_writer *writer, double d)
+{
+  char str[32];
+
+  if(json_writer_separate(writer) != 0) return -1;
+  snprintf(str, sizeof(str), "%g", d);
+  return json_writer_append(writer, str, strlen(str));
+}
+
+int json_writer_boolean(struct json_writer *writer, boolean b)
+{
+  if(json_writer_separate(writer) != 0) return -1;
+  return b ? json_writer_append(writer, "true", 4) : json_writer_append(writer, "false", 5);
+}
+
+int json_writer_null(struct json_writer *writer)
+{
+  if(json_writer_separate(writer) != 0) return -1;
+  return json_writer_append(writer, "null", 4);
+}
+
+int json_writer_object(struct json_writer *writer, struct json_object *obj)
+{
+  struct json_object_iter iter;
+  int i;
+
+  if(obj == NULL) return json_writer_null(writer);
+
+  switch(obj->o_type) {
+  case json_type_object:
+    json_writer_object_start(writer);
+    json_object_object_foreachC(obj, iter) {
+      json_writer_key(writer, iter.key);
+      json_writer_object(writer, iter.val);
+    }
+    return json_writer_object_end(writer);
+  case json_type_array:
+    json_writer_array_start(writer);
+    for(i = 0; i < json_object_array_length(obj); i++)
+      json_writer_object(writer, json_object_array_get_idx(obj, i));
+    return json_writer_array_end(writer);
+  case json_type_boolean:
+    return json_writer_boolean(writer, obj->o.c_boolean);
+  case json_type_int:
+    return json_writer_int(writer, obj->o.c_int64);
+  case json_type_double:
+    return json_writer_double(writer, obj->o.c_double);
+  case json_type_string:
+    if(json_writer_separate(writer) != 0) return -1;
+    return json_writer_escape_str(writer, obj->o.c_string.str, obj->o.c_string.len);
+  default:
+    return json_writer_null(writer);
+  }
+}
+
+int json_writer_finish(struct json_writer *writer)
+{
+  return json_writer_flush(writer);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2014 MXCHIP Inc.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See COPYING for details.
+ *
+ */
+
+#ifndef _json_writer_h_
+#define _json_writer_h_
+
+#include "json_inttypes.h"
+#include "json_object.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming writer: the document is written into a caller supplied buffer
+ * and handed to the flush callback every time the buffer is full, so the
+ * memory used does not depend on the size of the document. The output is
+ * compact, without the spaces json_object_to_json_string() puts in.
+ */
+
+#define JSON_WRITER_MAX_DEPTH 32
+
+/* Returns 0, or -1 to stop the writer */
+typedef int (json_writer_flush_fn)(void *userdata, const char *buf, int len);
+
+struct json_writer
+{
+  char *buf;
+  int size;
+  int len;
+  /* 0, -1 once a flush failed or the document is too deep, nothing is
+   * written after that */
+  int err;
+  int depth;
+  /* Bit n is set once the container at depth n holds a value */
+  uint32_t not_empty;
+  boolean after_key;
+  json_writer_flush_fn *flush;
+  void *userdata;
+};
+
+extern void json_writer_init(struct json_writer *writer, char *buf, int size,
+                             json_writer_flush_fn *flush, void *userdata);
+
+/* Every call returns 0, or -1 when the writer has failed */
+extern int json_writer_object_start(struct json_writer *writer);
+extern int json_writer_object_end(struct json_writer *writer);
+extern int json_writer_array_start(struct json_writer *writer);
+extern int json_writer_array_end(struct json_writer *writer);
+extern int json_writer_key(struct json_writer *writer, const char *key);
+extern int json_writer_string(struct json_writer *writer, const char *str);
+extern int json_writer_int(struct json_writer *writer, int64_t i);
+extern int json_writer_double(struct json_writer *writer, double d);
+extern int json_writer_boolean(struct json_writer *writer, boolean b);
+extern int json_writer_null(struct json_writer *writer);
+
+/* Write a whole json_object tree, without the printbuf
+ * json_object_to_json_string() would allocate for it */
+extern int json_writer_object(struct json_writer *writer, struct json_object *obj);
+
+/* Hand what is left in the buffer to the flush callback */
+extern int json_writer_finish(struct json_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
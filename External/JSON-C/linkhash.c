@@ -57,15 +57,25 @@ struct lh_table* lh_table_new(int size, const char *name,
 			      lh_entry_free_fn *free_fn,
 			      lh_hash_fn *hash_fn,
 			      lh_equal_fn *equal_fn)
+{
+	return lh_table_new_arena(size, name, free_fn, hash_fn, equal_fn, NULL);
+}
+
+struct lh_table* lh_table_new_arena(int size, const char *name,
+				    lh_entry_free_fn *free_fn,
+				    lh_hash_fn *hash_fn,
+				    lh_equal_fn *equal_fn,
+				    json_arena_t *arena)
 {
 	int i;
 	struct lh_table *t;
 
-	t = (struct lh_table*)calloc(1, sizeof(struct lh_table));
+	t = (struct lh_table*)json_c_calloc(arena, 1, sizeof(struct lh_table));
 	if(!t) lh_abort("lh_table_new: calloc failed 1, size = %d\n", sizeof(struct lh_table));
 	t->count = 0;
 	t->size = size;
-	t->table = (struct lh_entry*)calloc(size, sizeof(struct lh_entry));
+	t->arena = arena;
+	t->table = (struct lh_entry*)json_c_calloc(arena, size, sizeof(struct lh_entry));
 	if(!t->table) lh_abort("lh_table_new: calloc failed 2, size = %d\n", sizeof(struct lh_table));
 	t->free_fn = free_fn;
 	t->hash_fn = hash_fn;
@@ -88,21 +98,29 @@ struct lh_table* lh_kptr_table_new(int size, const char *name,
 
 void lh_table_resize(struct lh_table *t, int new_size)
 {
-	struct lh_table *new_t;
+	struct lh_table new_t;
 	struct lh_entry *ent;
+	int i;
 
-	new_t = lh_table_new(new_size, NULL, NULL, t->hash_fn, t->equal_fn);
+	/* Only the entry array is replaced, the table header is reused */
+	memset(&new_t, 0, sizeof(struct lh_table));
+	new_t.size = new_size;
+	new_t.hash_fn = t->hash_fn;
+	new_t.equal_fn = t->equal_fn;
+	new_t.arena = t->arena;
+	new_t.table = (struct lh_entry*)json_c_calloc(t->arena, new_size, sizeof(struct lh_entry));
+	if(!new_t.table) lh_abort("lh_table_resize: calloc failed, size = %d\n", new_size);
+	for(i = 0; i < new_size; i++) new_t.table[i].k = LH_EMPTY;
 	ent = t->head;
 	while(ent) {
-		lh_table_insert(new_t, ent->k, ent->v);
+		lh_table_insert(&new_t, ent->k, ent->v);
 		ent = ent->next;
 	}
-	free(t->table);
-	t->table = new_t->table;
+	json_c_free(t->arena, t->table);
+	t->table = new_t.table;
 	t->size = new_size;
-	t->head = new_t->head;
-	t->tail = new_t->tail;
-	free(new_t);
+	t->head = new_t.head;
+	t->tail = new_t.tail;
 }
 
 void lh_table_free(struct lh_table *t)
@@ -113,8 +131,8 @@ void lh_table_free(struct lh_table *t)
 			t->free_fn(c);
 		}
 	}
-	free(t->table);
-	free(t);
+	json_c_free(t->arena, t->table);
+	json_c_free(t->arena, t);
 }
 
 
@@ -123,7 +141,7 @@ int lh_table_insert(struct lh_table *t, void *k, const void *v)
 	unsigned long h, n;
 
 	//if(t->count > t->size * 0.66) lh_table_resize(t, t->size * 2); 
-	if(t->count >= t->size) lh_table_resize(t, t->size + 1); 
+	if(t->count >= t->size) lh_table_resize(t, (t->arena && t->size < 128) ? t->size * 2 : t->size + 1); 
 
 	h = t->hash_fn(k);
 	n = h % t->size;
@@ -12,6 +12,8 @@
 #ifndef _linkhash_h_
 #define _linkhash_h_
 
+#include "json_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -100,6 +102,11 @@ struct lh_table {
 	lh_entry_free_fn *free_fn;
 	lh_hash_fn *hash_fn;
 	lh_equal_fn *equal_fn;
+
+	/**
+	 * Arena the table and its entries come from, NULL for the heap.
+	 */
+	json_arena_t *arena;
 };
 
 
@@ -160,6 +167,17 @@ extern struct lh_table* lh_table_new(int size, const char *name,
 extern struct lh_table* lh_kchar_table_new(int size, const char *name,
 					   lh_entry_free_fn *free_fn);
 
+/**
+ * lh_table_new() taking its memory from an arena, the table then grows
+ * by doubling instead of one entry at a time.
+ * @param arena the arena, NULL for the heap.
+ */
+extern struct lh_table* lh_table_new_arena(int size, const char *name,
+					   lh_entry_free_fn *free_fn,
+					   lh_hash_fn *hash_fn,
+					   lh_equal_fn *equal_fn,
+					   json_arena_t *arena);
+
 
 /**
  * Convenience function to create a new linkhash
@@ -16,6 +16,8 @@
 #ifndef _printbuf_h_
 #define _printbuf_h_
 
+#include "json_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -26,11 +28,16 @@ struct printbuf {
   char *buf;
   int bpos;
   int size;
+  json_arena_t *arena;
 };
 
 extern struct printbuf*
 printbuf_new(void);
 
+/* printbuf_new() on an arena, NULL for the heap */
+extern struct printbuf*
+printbuf_new_arena(json_arena_t *arena);
+
 /* As an optimization, printbuf_memappend_fast is defined as a macro
  * that handles copying data if the buffer is large enough; otherwise
  * it invokes printbuf_memappend_real() which performs the heavy
@@ -37,13 +37,17 @@
 #include "StringUtils.h"
 #include "HTTPUtils.h"
 #include "SocketUtils.h"
+#include "MICOConfigMenu.h"
 
 #include "EasyLink.h"
-#include "SoftAp/EasyLinkSoftAP.h"
+#include "SoftAP/EasyLinkSoftAP.h"
   
 // EasyLink HTTP messages
 #define kEasyLinkURLAuth          "/auth-setup"
 
+/* Writer buffer of the pass that only sizes the report */
+#define kEasyLinkReportCountSize  64
+
 #define easylink_log(M, ...) custom_log("EasyLink", M, ##__VA_ARGS__)
 #define easylink_log_trace() custom_log_trace("EasyLink")
 
@@ -61,7 +65,7 @@ static HTTPHeader_t *httpHeader = NULL;
 static bool EasylinkFailed = false;
 
 extern OSStatus     ConfigIncommingJsonMessage    ( const char *input, mico_Context_t * const inContext );
-extern json_object* ConfigCreateReportJsonMessage ( mico_Context_t * const inContext );
+extern OSStatus     ConfigCreateReportJsonMessage ( struct json_writer *writer, mico_Context_t * const inContext );
 extern void         ConfigWillStart               ( mico_Context_t * const inContext );
 extern void         ConfigWillStop                ( mico_Context_t * const inContext );
 extern void         ConfigEasyLinkIsSuccess       ( mico_Context_t * const inContext );
@@ -320,8 +324,10 @@ OSStatus _connectFTCServer( mico_Context_t * const inContext, int *fd)
 {
   OSStatus    err;
   struct      sockaddr_t addr;
-  json_object *easylink_report = NULL;
-  const char  *json_str;
+  struct      json_writer writer;
+  char        countBuf[kEasyLinkReportCountSize];
+  char        *json_str = NULL;
+  int         json_len = 0, json_written = 0;
   
   size_t      httpResponseLen = 0;
 
@@ -333,25 +339,35 @@ OSStatus _connectFTCServer( mico_Context_t * const inContext, int *fd)
 
   easylink_log("Connect to FTC server success, fd: %d", *fd);
 
-  easylink_report = ConfigCreateReportJsonMessage( inContext );
-  require( easylink_report, exit );
+  /* CreateHTTPMessage wants the body in one piece: the first pass only sizes
+     the report, the second writes it straight into a buffer of that size */
+  json_writer_init( &writer, countBuf, sizeof(countBuf), MICOConfigReportLength, &json_len );
+  err = ConfigCreateReportJsonMessage( &writer, inContext );
+  require_noerr( err, exit );
+  require_action( json_writer_finish( &writer ) == 0, exit, err = kWriteErr );
 
-  json_str = json_object_to_json_string(easylink_report);
-  require( json_str, exit );
+  json_str = malloc( json_len + 1 );
+  require_action( json_str, exit, err = kNoMemoryErr );
+  json_writer_init( &writer, json_str, json_len, MICOConfigReportLength, &json_written );
+  err = ConfigCreateReportJsonMessage( &writer, inContext );
+  require_noerr( err, exit );
+  require_action( json_writer_finish( &writer ) == 0, exit, err = kWriteErr );
+  /* A longer report wrapped around the buffer, the configuration changed in between */
+  require_action( json_written == json_len, exit, err = kWriteErr );
+  json_str[json_len] = 0x0;
 
   easylink_log("Send config object=%s", json_str);
-  err =  CreateHTTPMessage( "POST", kEasyLinkURLAuth, kMIMEType_JSON, (uint8_t *)json_str, strlen(json_str), &httpResponse, &httpResponseLen );
+  err =  CreateHTTPMessage( "POST", kEasyLinkURLAuth, kMIMEType_JSON, (uint8_t *)json_str, json_len, &httpResponse, &httpResponseLen );
   require_noerr( err, exit );
   require( httpResponse, exit );
 
-  json_object_put(easylink_report);
-
   err = SocketSend( *fd, httpResponse, httpResponseLen );
   free(httpResponse);
   require_noerr( err, exit );
   easylink_log("Current configuration sent");
 
 exit:
+  if(json_str) free(json_str);
   return err;
 }
 
@@ -533,7 +549,7 @@ OSStatus _FTCRespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico_Context
 
       case kStatusOK:
         easylink_log("Easylink server respond status OK!");
-        err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
+        err = HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueSize );
         require_noerr(err, exit);
         if( strnicmpx( value, valueSize, kMIMEType_JSON ) == 0 ){
           easylink_log("Receive JSON config data!");
@@ -5,8 +5,6 @@
 #include "platform_config.h"
 
 #ifdef MICO_CLI_ENABLE
-int cli_printf(const char *msg, ...);
-int cli_putstr(const char *msg);
 int cli_getchar(char *inbuf);
 
 /// CLI ///
@@ -16,20 +14,26 @@ int cli_getchar(char *inbuf);
 #define END_CHAR		'\r'
 #define PROMPT			"\r\n# "
 #define EXIT_MSG		"exit"
+#define BATCH_END_MSG		"end"
 #define NUM_BUFFERS		1
-#define MAX_COMMANDS	50
-#define INBUF_SIZE      80
-#define OUTBUF_SIZE     1024
+#ifndef CLI_RX_BUFFER_SIZE
+#define CLI_RX_BUFFER_SIZE	512	/* UART ring, holds the next lines of a script while one runs */
+#endif
+#define CLI_RX_CHUNK		64	/* Bytes taken out of the UART ring at once */
 
 struct cli_st {
   int initialized;
   
   unsigned int bp;	/* buffer pointer */
-  char inbuf[INBUF_SIZE];
-  char outbuf[OUTBUF_SIZE];
-  const struct cli_command *commands[MAX_COMMANDS];
-  unsigned int num_commands;
+  char inbuf[CLI_INBUF_SIZE];
+  char rxbuf[CLI_RX_CHUNK];	/* Read from the UART, not parsed yet */
+  unsigned int rx_start;
+  unsigned int rx_end;
+  int last_cr;		/* The last line ended with '\r', a '\n' next is part of it */
+  int overflow;		/* Line too long, drop it up to its end */
   int echo_disabled;
+  int batch;		/* Lines are run as a script up to BATCH_END_MSG */
+  struct cli_script_stat batch_stat;
   
 } ;
 
@@ -46,177 +50,38 @@ static const mico_uart_config_t cli_uart_config =
   .flags        = UART_WAKEUP_DISABLE,
 };
 
-/* Find the command 'name' in the cli commands table.
-* If len is 0 then full match will be performed else upto len bytes.
-* Returns: a pointer to the corresponding cli_command struct or NULL.
-*/
-static const struct cli_command *lookup_command(char *name, int len)
-{
-  int i = 0;
-  int n = 0;
-  
-  while (i < MAX_COMMANDS && n < pCli->num_commands) {
-    if (pCli->commands[i]->name == NULL) {
-      i++;
-      continue;
-    }
-    /* See if partial or full match is expected */
-    if (len != 0) {
-      if (!strncmp(pCli->commands[i]->name, name, len))
-        return pCli->commands[i];
-    } else {
-      if (!strcmp(pCli->commands[i]->name, name))
-        return pCli->commands[i];
-    }
-    
-    i++;
-    n++;
-  }
-  
-  return NULL;
-}
-
-/* Parse input line and locate arguments (if any), keeping count of the number
-* of arguments and their locations.  Look up and call the corresponding cli
-* function if one is found and pass it the argv array.
-*
-* Returns: 0 on success: the input line contained at least a function name and
-*          that function exists and was called.
-*          1 on lookup failure: there is no corresponding function for the
-*          input line.
-*          2 on invalid syntax: the arguments list couldn't be parsed
-*/
-static int handle_input(char *inbuf)
-{
-  struct {
-    unsigned inArg:1;
-    unsigned inQuote:1;
-    unsigned done:1;
-  } stat;
-  static char *argv[16];
-  int argc = 0;
-  int i = 0;
-  const struct cli_command *command = NULL;
-  const char *p;
-  
-  
-  memset((void *)&argv, 0, sizeof(argv));
-  memset(&stat, 0, sizeof(stat));
-  
-  do {
-    switch (inbuf[i]) {
-    case '\0':
-      if (stat.inQuote)
-        return 2;
-      stat.done = 1;
-      break;
-      
-    case '"':
-      if (i > 0 && inbuf[i - 1] == '\\' && stat.inArg) {
-        memcpy(&inbuf[i - 1], &inbuf[i],
-               strlen(&inbuf[i]) + 1);
-        --i;
-        break;
-      }
-      if (!stat.inQuote && stat.inArg)
-        break;
-      if (stat.inQuote && !stat.inArg)
-        return 2;
-      
-      if (!stat.inQuote && !stat.inArg) {
-        stat.inArg = 1;
-        stat.inQuote = 1;
-        argc++;
-        argv[argc - 1] = &inbuf[i + 1];
-      } else if (stat.inQuote && stat.inArg) {
-        stat.inArg = 0;
-        stat.inQuote = 0;
-        inbuf[i] = '\0';
-      }
-      break;
-      
-    case ' ':
-      if (i > 0 && inbuf[i - 1] == '\\' && stat.inArg) {
-        memcpy(&inbuf[i - 1], &inbuf[i],
-               strlen(&inbuf[i]) + 1);
-        --i;
-        break;
-      }
-      if (!stat.inQuote && stat.inArg) {
-        stat.inArg = 0;
-        inbuf[i] = '\0';
-      }
-      break;
-      
-    default:
-      if (!stat.inArg) {
-        stat.inArg = 1;
-        argc++;
-        argv[argc - 1] = &inbuf[i];
-      }
-      break;
-    }
-  } while (!stat.done && ++i < INBUF_SIZE);
-  
-  if (stat.inQuote)
-    return 2;
-  
-  if (argc < 1)
-    return 0;
-  
-  if (!pCli->echo_disabled)
-    cli_printf("\r\n");
-  
-  /*
-  * Some comamands can allow extensions like foo.a, foo.b and hence
-  * compare commands before first dot.
-  */
-  i = ((p = strchr(argv[0], '.')) == NULL) ? 0 :
-    (p - argv[0]);
-    command = lookup_command(argv[0], i);
-    if (command == NULL)
-      return 1;
-    
-    memset(pCli->outbuf, 0, OUTBUF_SIZE);
-    cli_putstr("\r\n");
-    command->function(pCli->outbuf, OUTBUF_SIZE, argc, argv);
-    cli_putstr(pCli->outbuf);
-    return 0;
-}
-
 /* Perform basic tab-completion on the input buffer by string-matching the
 * current input line against the cli functions table.  The current input line
 * is assumed to be NULL-terminated. */
 static void tab_complete(char *inbuf, unsigned int *bp)
 {
-  int i, n, m;
+  int n, m;
   const char *fm = NULL;
+  const struct cli_command *command;
+  void *iter = NULL;
   
   cli_printf("\r\n");
   
   /* show matching commands */
-  for (i = 0, n = 0, m = 0; i < MAX_COMMANDS && n < pCli->num_commands;
-  i++) {
-    if (pCli->commands[i]->name != NULL) {
-      if (!strncmp(inbuf, pCli->commands[i]->name, *bp)) {
-        m++;
-        if (m == 1)
-          fm = pCli->commands[i]->name;
-        else if (m == 2)
-          cli_printf("%s %s ", fm,
-                     pCli->commands[i]->name);
-        else
-          cli_printf("%s ",
-                     pCli->commands[i]->name);
-      }
-      n++;
+  m = 0;
+  while ((command = cli_next_command(&iter)) != NULL) {
+    if (!strncmp(inbuf, command->name, *bp)) {
+      m++;
+      if (m == 1)
+        fm = command->name;
+      else if (m == 2)
+        cli_printf("%s %s ", fm,
+                   command->name);
+      else
+        cli_printf("%s ",
+                   command->name);
     }
   }
   
   /* there's only one match, so complete the line */
   if (m == 1 && fm) {
     n = strlen(fm) - *bp;
-    if (*bp + n < INBUF_SIZE) {
+    if (*bp + n < CLI_INBUF_SIZE) {
       memcpy(inbuf + *bp, fm + *bp, n);
       *bp += n;
       inbuf[(*bp)++] = ' ';
@@ -228,51 +93,101 @@ static void tab_complete(char *inbuf, unsigned int *bp)
   cli_printf("%s%s", PROMPT, inbuf);
 }
 
+/* Send the input typed since from back, unless echo is off */
+static void echo_input(const char *from, unsigned int len)
+{
+  if (len > 0 && !pCli->echo_disabled && !pCli->batch)
+    MicoUartSend( CLI_UART, from, len );
+}
+
 /* Get an input line.
 *
+* All the bytes waiting in the UART ring are taken at once, the ones after the
+* end of line are kept for the next line. A line ends with '\r', '\n' or
+* "\r\n". The echo is sent once for a chunk rather than byte by byte.
+*
 * Returns: 1 if there is input, 0 if the line should be ignored. */
 static int get_input(char *inbuf, unsigned int *bp)
 {
+  unsigned int echo;
+  uint32_t len;
+  char c;
   
   if (inbuf == NULL) {
     return 0;
   }
-  while (cli_getchar(&inbuf[*bp]) == 1) {
-    if (inbuf[*bp] == END_CHAR) {	/* end of input line */
+  
+  if (pCli->rx_start == pCli->rx_end) {
+    len = MicoUartGetLengthInBuffer( CLI_UART );
+    if (len == 0)
+      len = 1;	/* wait for the next byte */
+    else if (len > CLI_RX_CHUNK)
+      len = CLI_RX_CHUNK;
+    if (MicoUartRecv( CLI_UART, pCli->rxbuf, len, 1000 ) != kNoErr)
+      return 0;
+    pCli->rx_start = 0;
+    pCli->rx_end = len;
+  }
+  
+  echo = *bp;
+  while (pCli->rx_start < pCli->rx_end) {
+    c = pCli->rxbuf[pCli->rx_start++];
+    
+    if (c == '\n' && pCli->last_cr) {
+      pCli->last_cr = 0;
+      continue;
+    }
+    pCli->last_cr = (c == END_CHAR);
+    
+    if (c == END_CHAR || c == '\n') {	/* end of input line */
+      echo_input(&inbuf[echo], *bp - echo);
       inbuf[*bp] = '\0';
       *bp = 0;
+      if (pCli->overflow) {
+        pCli->overflow = 0;
+        return 0;
+      }
       return 1;
     }
     
-    if ((inbuf[*bp] == 0x08) ||	/* backspace */
-        (inbuf[*bp] == 0x7f)) {	/* DEL */
+    if (pCli->overflow)
+      continue;
+    
+    if ((c == 0x08) ||	/* backspace */
+        (c == 0x7f)) {	/* DEL */
+          echo_input(&inbuf[echo], *bp - echo);
           if (*bp > 0) {
             (*bp)--;
-            if (!pCli->echo_disabled)
+            if (!pCli->echo_disabled && !pCli->batch)
               cli_printf("%c %c", 0x08, 0x08);
           }
+          echo = *bp;
           continue;
         }
     
-    if (inbuf[*bp] == '\t') {
+    if (c == '\t' && !pCli->batch) {
+      echo_input(&inbuf[echo], *bp - echo);
       inbuf[*bp] = '\0';
       tab_complete(inbuf, bp);
+      echo = *bp;
       continue;
     }
     
-    if (!pCli->echo_disabled)
-      cli_printf("%c", inbuf[*bp]);
-    
-    (*bp)++;
-    if (*bp >= INBUF_SIZE) {
-      cli_printf("Error: input buffer overflow\r\n");
-      cli_printf(PROMPT);
+    inbuf[(*bp)++] = c;
+    if (*bp >= CLI_INBUF_SIZE) {
       *bp = 0;
-      return 0;
+      echo = 0;
+      pCli->overflow = 1;
+      if (pCli->batch) {
+        cli_script_error(&pCli->batch_stat, "line too long");
+        continue;
+      }
+      cli_printf("\r\nError: input buffer overflow\r\n");
+      cli_printf(PROMPT);
     }
-    
   }
   
+  echo_input(&inbuf[echo], *bp - echo);
   return 0;
 }
 
@@ -315,10 +230,21 @@ static void cli_main(void *data)
       continue;
     msg = pCli->inbuf;
     
+    if (pCli->batch) {
+      if (strcmp(msg, BATCH_END_MSG) == 0) {
+        pCli->batch = 0;
+        cli_script_end(&pCli->batch_stat);
+        cli_printf(PROMPT);
+      } else {
+        cli_script_line(&pCli->batch_stat, msg);
+      }
+      continue;
+    }
+    
     if (msg != NULL) {
       if (strcmp(msg, EXIT_MSG) == 0)
         break;
-      ret = handle_input(msg);
+      ret = cli_handle_input(msg, !pCli->echo_disabled);
       if (ret == 1)
         print_bad_command(msg);
       else if (ret == 2)
@@ -341,16 +267,14 @@ static void cli_main(void *data)
 * text string, if any. */
 static void help_command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
 {
-  int i, n;
+  const struct cli_command *command;
+  void *iter = NULL;
   
   cmd_printf("\r\n");
-  for (i = 0, n = 0; i < MAX_COMMANDS && n < pCli->num_commands; i++) {
-    if (pCli->commands[i]->name) {
-      cmd_printf("%s: %s\r\n", pCli->commands[i]->name,
-                 pCli->commands[i]->help ?
-                   pCli->commands[i]->help : "");
-      n++;
-    }
+  while ((command = cli_next_command(&iter)) != NULL) {
+    cmd_printf("%s: %s\r\n", command->name,
+               command->help ?
+                 command->help : "");
   }
 }
 
@@ -397,6 +321,16 @@ static void echo_cmd_handler(char *pcWriteBuffer, int xWriteBufferLen,int argc,
   }
 }
 
+/* Built-in "batch" command: the next lines are run without echo or prompt, each
+* one followed by its status and run time, up to a line "end" that prints how
+* many commands ran and failed. */
+static void batch_command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
+{
+  cmd_printf("Batch mode, end with '%s'", BATCH_END_MSG);
+  cli_script_begin(&pCli->batch_stat);
+  pCli->batch = 1;
+}
+
 static void cli_exit_handler(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
 {
   // exit command not excuted
@@ -408,6 +342,7 @@ static const struct cli_command built_ins[] = {
   {"version", NULL, get_version},
   {"echo", NULL, echo_cmd_handler},
   {"exit", "CLI exit", cli_exit_handler}, 
+  {"batch", "Run the next lines as a script up to 'end'", batch_command},
   
   /// WIFI
   {"scan", "scan ap", wifiscan_Command}, 
@@ -432,69 +367,6 @@ static const struct cli_command built_ins[] = {
   {"reboot", "reboot MiCO system", reboot},
 };
 
-int cli_register_command(const struct cli_command *command)
-{
-  int i;
-  if (!command->name || !command->function)
-    return 1;
-  
-  if (pCli->num_commands < MAX_COMMANDS) {
-    /* Check if the command has already been registered.
-    * Return 0, if it has been registered.
-    */
-    for (i = 0; i < pCli->num_commands; i++) {
-      if (pCli->commands[i] == command)
-        return 0;
-    }
-    pCli->commands[pCli->num_commands++] = command;
-    return 0;
-  }
-  
-  return 1;
-}
-
-int cli_unregister_command(const struct cli_command *command)
-{
-  int i;
-  if (!command->name || !command->function)
-    return 1;
-  
-  for (i = 0; i < pCli->num_commands; i++) {
-    if (pCli->commands[i] == command) {
-      pCli->num_commands--;
-      int remaining_cmds = pCli->num_commands - i;
-      if (remaining_cmds > 0) {
-        memmove(&pCli->commands[i], &pCli->commands[i + 1],
-                (remaining_cmds *
-                 sizeof(struct cli_command *)));
-      }
-      pCli->commands[pCli->num_commands] = NULL;
-      return 0;
-    }
-  }
-  
-  return 1;
-}
-
-int cli_register_commands(const struct cli_command *commands, int num_commands)
-{
-  int i;
-  for (i = 0; i < num_commands; i++)
-    if (cli_register_command(commands++))
-      return 1;
-  return 0;
-}
-
-int cli_unregister_commands(const struct cli_command *commands,
-			    int num_commands)
-{
-  int i;
-  for (i = 0; i < num_commands; i++)
-    if (cli_unregister_command(commands++))
-      return 1;
-  
-  return 0;
-}
 #if (DEBUG)
 extern int mico_debug_enabled;
 static void micodebug_Command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
@@ -527,7 +399,7 @@ int MicoCliInit(void)
   if (pCli == NULL)
     return kNoMemoryErr;
   
-  cli_rx_data = (uint8_t*)malloc(INBUF_SIZE);
+  cli_rx_data = (uint8_t*)malloc(CLI_RX_BUFFER_SIZE);
   if (cli_rx_data == NULL) {
     free(pCli);
     pCli = NULL;
@@ -535,7 +407,7 @@ int MicoCliInit(void)
   }
   memset((void *)pCli, 0, sizeof(struct cli_st));
   
-  ring_buffer_init  ( (ring_buffer_t*)&cli_rx_buffer, (uint8_t*)cli_rx_data, INBUF_SIZE );
+  ring_buffer_init  ( (ring_buffer_t*)&cli_rx_buffer, (uint8_t*)cli_rx_data, CLI_RX_BUFFER_SIZE );
   MicoUartInitialize( CLI_UART, &cli_uart_config, (ring_buffer_t*)&cli_rx_buffer );
   
   /* add our built-in commands */
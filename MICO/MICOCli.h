@@ -1,5 +1,16 @@
 #ifndef __MICO_CLI_H__
 #define __MICO_CLI_H__
+
+#ifndef CLI_INBUF_SIZE
+#define CLI_INBUF_SIZE      256     /**< Longest command line, the ending '\0' included */
+#endif
+#ifndef CLI_OUTBUF_SIZE
+#define CLI_OUTBUF_SIZE     1024    /**< Output of one command */
+#endif
+#ifndef CLI_MAX_ARGS
+#define CLI_MAX_ARGS        32      /**< Arguments of one command, its name included */
+#endif
+
 /** Structure for registering CLI commands */
 struct cli_command {
 	/** The name of the CLI command */
@@ -19,6 +30,23 @@ struct cli_command {
 
 #define CLI_ARGS char *pcWriteBuffer, int xWriteBufferLen, int argc, char **argv
 
+/** Progress of a script, see cli_script_begin() */
+struct cli_script_stat {
+	int lines;		/**< Lines read, empty and comment lines included */
+	int commands;		/**< Commands run */
+	int failed;		/**< Commands not found, with a syntax error or too long */
+	uint32_t start;		/**< mico_get_time() when the script began */
+};
+
+/** Read more of a script
+ *
+ * \param[in] ctx The ctx given to cli_run_script_reader()
+ * \param[out] buf Where to put the bytes read
+ * \param[in] len Room in buf
+ * \return number of bytes read, 0 at the end of the script, < 0 on error
+ */
+typedef int (*cli_script_read_t)(void *ctx, char *buf, int len);
+
 /** Register a CLI command
  *
  * This function registers a command with the command-line interface.
@@ -39,6 +67,85 @@ int cli_register_command(const struct cli_command *command);
  */
 int cli_unregister_command(const struct cli_command *command);
 
+/** Walk the registered commands in the order they were registered
+ *
+ * \param[in,out] iter Set to NULL before the first call, updated by every call.
+ * \return the next command, NULL after the last one
+ */
+const struct cli_command *cli_next_command(void **iter);
+
+/** Parse a command line and run the command
+ *
+ * Arguments are split on spaces, "" quotes an argument and \ escapes a space
+ * or a quote. The line is modified. The output of the command is sent with
+ * cli_putstr().
+ *
+ * \param[in] inbuf The command line, '\0' terminated
+ * \param[in] echo Send an end of line before the output, as the echoed
+ * input line has not ended yet
+ * \return 0 on success or an empty line
+ * \return 1 if the command is not found
+ * \return 2 on a syntax error
+ */
+int cli_handle_input(char *inbuf, int echo);
+
+/** Start a script
+ *
+ * A script is a list of command lines. Every command is run like it was typed
+ * and followed by a status line with its number, result and run time, so a
+ * host pushing many commands can check them without parsing their output.
+ *
+ * \param[out] stat Progress of the script
+ */
+void cli_script_begin(struct cli_script_stat *stat);
+
+/** Run one line of a script
+ *
+ * Empty lines and lines starting with '#' are skipped. A '\r' at the end and
+ * tabs are taken as spaces.
+ *
+ * \param[in,out] stat Progress of the script
+ * \param[in] line The line, without its '\n'. It is modified.
+ * \return 0 on success or a skipped line, else as cli_handle_input()
+ */
+int cli_script_line(struct cli_script_stat *stat, char *line);
+
+/** Count a line of a script that can not be run, and report why
+ *
+ * \param[in,out] stat Progress of the script
+ * \param[in] reason Shown in the status line
+ */
+void cli_script_error(struct cli_script_stat *stat, const char *reason);
+
+/** End a script and print the number of commands, failures and the total time
+ *
+ * \param[in] stat Progress of the script
+ */
+void cli_script_end(struct cli_script_stat *stat);
+
+/** Run a script held in memory
+ *
+ * \param[in] script Lines separated by '\n', not modified
+ * \param[in] len Length of the script
+ * \param[in] stop_on_error Stop at the first command that fails
+ * \return number of commands that failed, -1 when out of memory
+ */
+int cli_run_script(const char *script, int len, int stop_on_error);
+
+/** Run a script read piece by piece, from a file for instance
+ *
+ * Only one line is held in memory at a time, lines longer than
+ * CLI_INBUF_SIZE are reported and skipped. A command may run a script, the
+ * commands of the script get an output buffer of their own.
+ *
+ * \param[in] read Called to get more of the script
+ * \param[in] ctx Given to read
+ * \param[in] stop_on_error Stop at the first command that fails
+ * \return number of commands that failed, a read error counts as one, -1
+ * when out of memory
+ */
+int cli_run_script_reader(cli_script_read_t read, void *ctx, int stop_on_error);
+
 /** Initialize the CLI module
  *
  * \return kNoErr on success
@@ -99,6 +206,13 @@ int cli_getchar(char *inbuf);
  */
 int cli_printf(const char *buff, ...);
 
+/* Send a string to the CLI output as it is
+ *
+ * \param msg '\0' terminated string.
+ * \return 0
+ */
+int cli_putstr(const char *msg);
+
 
 
 // library CLI APIs
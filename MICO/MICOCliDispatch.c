@@ -0,0 +1,497 @@
+/**
+******************************************************************************
+* @file    MICOCliDispatch.c
+* @brief   CLI command table, command line parser and script runner. Has no
+*          UART or thread of its own, MICOCli.c feeds it the lines it reads.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "MICODefine.h"
+#include "MICOCli.h"
+
+#ifdef MICO_CLI_ENABLE
+
+/* Private define ------------------------------------------------------------*/
+#ifndef CLI_HASH_MIN_BUCKETS
+#define CLI_HASH_MIN_BUCKETS    16      /* Power of 2, doubled when there are more than 2 commands a bucket */
+#endif
+
+#define CLI_SCRIPT_COMMENT      '#'
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct _cli_entry_t {
+  const struct cli_command  *command;
+  uint32_t                  hash;       /* Of the name up to its first '.' */
+  struct _cli_entry_t       *chain;     /* Next one in the same bucket */
+  struct _cli_entry_t       *prev;      /* Registration order */
+  struct _cli_entry_t       *next;
+} cli_entry_t;
+
+typedef struct {
+  const char  *data;
+  int         len;
+} cli_mem_script_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* Commands can be registered before MicoCliInit, the table does not depend on it */
+static cli_entry_t **cli_buckets = NULL;
+static uint32_t cli_bucket_num = 0;
+static uint32_t cli_command_num = 0;
+static cli_entry_t *cli_first = NULL;
+static cli_entry_t *cli_last = NULL;
+
+static char cli_outbuf[CLI_OUTBUF_SIZE];
+/* Where the command being run writes, a script gives its commands a buffer of
+* their own so the output of the command running the script is kept. */
+static char *cli_out = cli_outbuf;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* FNV-1a of the first len bytes of name */
+static uint32_t cli_hash(const char *name, int len)
+{
+  uint32_t hash = 2166136261UL;
+
+  while (len-- > 0) {
+    hash ^= (uint8_t)*name++;
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+/* Length of the part of a command name that is hashed, extensions like foo.a
+* and foo.b share the entry of foo. */
+static int cli_key_len(const char *name)
+{
+  return (int)strcspn(name, ".");
+}
+
+/* Move all entries to a table of num buckets, keeping their order in every
+* bucket so the first command registered with a name is still found first. */
+static void cli_rehash(uint32_t num)
+{
+  cli_entry_t **buckets, **tail;
+  cli_entry_t *entry;
+
+  buckets = (cli_entry_t **)malloc(num * sizeof(cli_entry_t *));
+  if (buckets == NULL)
+    return; /* Keep the old table, only longer chains */
+  memset(buckets, 0, num * sizeof(cli_entry_t *));
+
+  for (entry = cli_first; entry != NULL; entry = entry->next) {
+    tail = &buckets[entry->hash & (num - 1)];
+    while (*tail != NULL)
+      tail = &(*tail)->chain;
+    entry->chain = NULL;
+    *tail = entry;
+  }
+
+  if (cli_buckets != NULL)
+    free(cli_buckets);
+  cli_buckets = buckets;
+  cli_bucket_num = num;
+}
+
+/* Find the command 'name' in the cli commands table.
+* If len is 0 then full match will be performed else name is an extended
+* command and the command named as its first len bytes is looked for.
+* Returns: a pointer to the corresponding cli_command struct or NULL.
+*/
+static const struct cli_command *lookup_command(const char *name, int len)
+{
+  cli_entry_t *entry;
+  uint32_t hash;
+
+  if (cli_buckets == NULL)
+    return NULL;
+
+  hash = cli_hash(name, len ? len : (int)strlen(name));
+  for (entry = cli_buckets[hash & (cli_bucket_num - 1)]; entry != NULL; entry = entry->chain) {
+    if (entry->hash != hash)
+      continue;
+    /* See if partial or full match is expected */
+    if (len != 0) {
+      if (cli_key_len(entry->command->name) == len && !strncmp(entry->command->name, name, len))
+        return entry->command;
+    } else {
+      if (!strcmp(entry->command->name, name))
+        return entry->command;
+    }
+  }
+
+  return NULL;
+}
+
+static void cli_script_status(struct cli_script_stat *stat, const char *status, uint32_t time)
+{
+  cli_printf("\r\n[%d] %s, %lu ms", stat->lines, status, (unsigned long)time);
+}
+
+static int cli_mem_read(void *ctx, char *buf, int len)
+{
+  cli_mem_script_t *script = (cli_mem_script_t *)ctx;
+
+  if (len > script->len)
+    len = script->len;
+  memcpy(buf, script->data, len);
+  script->data += len;
+  script->len -= len;
+  return len;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+int cli_register_command(const struct cli_command *command)
+{
+  cli_entry_t *entry, **tail;
+  uint32_t hash;
+
+  if (!command->name || !command->function)
+    return 1;
+
+  if (cli_buckets == NULL) {
+    cli_rehash(CLI_HASH_MIN_BUCKETS);
+    if (cli_buckets == NULL)
+      return 1;
+  }
+
+  /* Check if the command has already been registered.
+  * Return 0, if it has been registered.
+  */
+  hash = cli_hash(command->name, cli_key_len(command->name));
+  for (tail = &cli_buckets[hash & (cli_bucket_num - 1)]; *tail != NULL; tail = &(*tail)->chain) {
+    if ((*tail)->command == command)
+      return 0;
+  }
+
+  entry = (cli_entry_t *)malloc(sizeof(cli_entry_t));
+  if (entry == NULL)
+    return 1;
+  entry->command = command;
+  entry->hash = hash;
+  entry->chain = NULL;
+  entry->prev = cli_last;
+  entry->next = NULL;
+  if (cli_last != NULL)
+    cli_last->next = entry;
+  else
+    cli_first = entry;
+  cli_last = entry;
+  *tail = entry;
+  cli_command_num++;
+
+  if (cli_command_num > 2 * cli_bucket_num)
+    cli_rehash(2 * cli_bucket_num);
+
+  return 0;
+}
+
+int cli_unregister_command(const struct cli_command *command)
+{
+  cli_entry_t *entry, **link;
+  uint32_t hash;
+
+  if (!command->name || !command->function || cli_buckets == NULL)
+    return 1;
+
+  hash = cli_hash(command->name, cli_key_len(command->name));
+  for (link = &cli_buckets[hash & (cli_bucket_num - 1)]; *link != NULL; link = &(*link)->chain) {
+    if ((*link)->command == command) {
+      entry = *link;
+      *link = entry->chain;
+      if (entry->prev != NULL)
+        entry->prev->next = entry->next;
+      else
+        cli_first = entry->next;
+      if (entry->next != NULL)
+        entry->next->prev = entry->prev;
+      else
+        cli_last = entry->prev;
+      free(entry);
+      cli_command_num--;
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int cli_register_commands(const struct cli_command *commands, int num_commands)
+{
+  int i;
+  for (i = 0; i < num_commands; i++)
+    if (cli_register_command(commands++))
+      return 1;
+  return 0;
+}
+
+int cli_unregister_commands(const struct cli_command *commands,
+			    int num_commands)
+{
+  int i;
+  for (i = 0; i < num_commands; i++)
+    if (cli_unregister_command(commands++))
+      return 1;
+
+  return 0;
+}
+
+const struct cli_command *cli_next_command(void **iter)
+{
+  cli_entry_t *entry = (*iter == NULL) ? cli_first : ((cli_entry_t *)*iter)->next;
+
+  *iter = entry;
+  return (entry != NULL) ? entry->command : NULL;
+}
+
+/* Parse input line and locate arguments (if any), keeping count of the number
+* of arguments and their locations.  Look up and call the corresponding cli
+* function if one is found and pass it the argv array.
+*
+* Returns: 0 on success: the input line contained at least a function name and
+*          that function exists and was called.
+*          1 on lookup failure: there is no corresponding function for the
+*          input line.
+*          2 on invalid syntax: the arguments list couldn't be parsed
+*/
+int cli_handle_input(char *inbuf, int echo)
+{
+  struct {
+    unsigned inArg:1;
+    unsigned inQuote:1;
+    unsigned done:1;
+  } stat;
+  char *argv[CLI_MAX_ARGS];
+  int argc = 0;
+  int i = 0;
+  const struct cli_command *command = NULL;
+  const char *p;
+
+
+  memset((void *)&argv, 0, sizeof(argv));
+  memset(&stat, 0, sizeof(stat));
+
+  while (!stat.done) {
+    switch (inbuf[i]) {
+    case '\0':
+      if (stat.inQuote)
+        return 2;
+      stat.done = 1;
+      break;
+
+    case '"':
+      if (i > 0 && inbuf[i - 1] == '\\' && stat.inArg) {
+        memcpy(&inbuf[i - 1], &inbuf[i],
+               strlen(&inbuf[i]) + 1);
+        --i;
+        break;
+      }
+      if (!stat.inQuote && stat.inArg)
+        break;
+      if (stat.inQuote && !stat.inArg)
+        return 2;
+
+      if (!stat.inQuote && !stat.inArg) {
+        if (argc == CLI_MAX_ARGS)
+          return 2;
+        stat.inArg = 1;
+        stat.inQuote = 1;
+        argc++;
+        argv[argc - 1] = &inbuf[i + 1];
+      } else if (stat.inQuote && stat.inArg) {
+        stat.inArg = 0;
+        stat.inQuote = 0;
+        inbuf[i] = '\0';
+      }
+      break;
+
+    case ' ':
+      if (i > 0 && inbuf[i - 1] == '\\' && stat.inArg) {
+        memcpy(&inbuf[i - 1], &inbuf[i],
+               strlen(&inbuf[i]) + 1);
+        --i;
+        break;
+      }
+      if (!stat.inQuote && stat.inArg) {
+        stat.inArg = 0;
+        inbuf[i] = '\0';
+      }
+      break;
+
+    default:
+      if (!stat.inArg) {
+        if (argc == CLI_MAX_ARGS)
+          return 2;
+        stat.inArg = 1;
+        argc++;
+        argv[argc - 1] = &inbuf[i];
+      }
+      break;
+    }
+    i++;
+  }
+
+  if (argc < 1)
+    return 0;
+
+  if (echo)
+    cli_printf("\r\n");
+
+  /*
+  * Some comamands can allow extensions like foo.a, foo.b and hence
+  * compare commands before first dot.
+  */
+  i = ((p = strchr(argv[0], '.')) == NULL) ? 0 :
+    (p - argv[0]);
+  command = lookup_command(argv[0], i);
+  if (command == NULL)
+    return 1;
+
+  memset(cli_out, 0, CLI_OUTBUF_SIZE);
+  cli_putstr("\r\n");
+  command->function(cli_out, CLI_OUTBUF_SIZE, argc, argv);
+  cli_putstr(cli_out);
+  return 0;
+}
+
+void cli_script_begin(struct cli_script_stat *stat)
+{
+  memset(stat, 0, sizeof(struct cli_script_stat));
+  stat->start = mico_get_time();
+}
+
+int cli_script_line(struct cli_script_stat *stat, char *line)
+{
+  static const char *status[] = {"ok", "not found", "syntax error"};
+  uint32_t start;
+  char *c;
+  int ret;
+
+  stat->lines++;
+
+  for (c = line; *c != '\0'; c++) {
+    if (*c == '\t' || *c == '\r')
+      *c = ' ';
+  }
+  while (*line == ' ')
+    line++;
+  if (*line == '\0' || *line == CLI_SCRIPT_COMMENT)
+    return 0;
+
+  stat->commands++;
+  start = mico_get_time();
+  ret = cli_handle_input(line, 0);
+  if (ret != 0)
+    stat->failed++;
+  cli_script_status(stat, status[ret], mico_get_time() - start);
+  return ret;
+}
+
+void cli_script_error(struct cli_script_stat *stat, const char *reason)
+{
+  stat->lines++;
+  stat->commands++;
+  stat->failed++;
+  cli_script_status(stat, reason, 0);
+}
+
+void cli_script_end(struct cli_script_stat *stat)
+{
+  cli_printf("\r\nscript: %d commands, %d failed, %lu ms\r\n", stat->commands, stat->failed,
+             (unsigned long)(mico_get_time() - stat->start));
+}
+
+int cli_run_script(const char *script, int len, int stop_on_error)
+{
+  cli_mem_script_t mem;
+
+  mem.data = script;
+  mem.len = len;
+  return cli_run_script_reader(cli_mem_read, &mem, stop_on_error);
+}
+
+int cli_run_script_reader(cli_script_read_t read, void *ctx, int stop_on_error)
+{
+  struct cli_script_stat stat;
+  char *buf, *line, *eol;
+  char *outer_out = cli_out;
+  int used = 0;
+  int skip = 0;   /* Dropping the rest of a line too long */
+  int len;
+
+  /* The line read, then the output of its command */
+  buf = (char *)malloc(CLI_INBUF_SIZE + 1 + CLI_OUTBUF_SIZE);
+  if (buf == NULL)
+    return -1;
+  cli_out = buf + CLI_INBUF_SIZE + 1;
+
+  cli_script_begin(&stat);
+  while (1) {
+    len = read(ctx, buf + used, CLI_INBUF_SIZE - used);
+    if (len < 0) {
+      cli_script_error(&stat, "read error");
+      break;
+    }
+    if (len == 0) {
+      /* Last line without a '\n' */
+      if (used > 0 && !skip) {
+        buf[used] = '\0';
+        cli_script_line(&stat, buf);
+      }
+      break;
+    }
+    used += len;
+
+    line = buf;
+    while ((eol = (char *)memchr(line, '\n', buf + used - line)) != NULL) {
+      *eol = '\0';
+      if (skip)
+        skip = 0;
+      else if (cli_script_line(&stat, line) != 0 && stop_on_error)
+        goto exit;
+      line = eol + 1;
+    }
+    used -= line - buf;
+    memmove(buf, line, used);
+
+    if (used == CLI_INBUF_SIZE) {
+      if (!skip) {
+        cli_script_error(&stat, "line too long");
+        if (stop_on_error)
+          goto exit;
+        skip = 1;
+      }
+      used = 0;
+    }
+  }
+
+exit:
+  cli_script_end(&stat);
+  cli_out = outer_out;
+  free(buf);
+  return stat.failed;
+}
+
+#endif
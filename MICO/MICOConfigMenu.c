@@ -34,145 +34,165 @@
 #include "JSON-C/json.h"
 #include "MICOConfigMenu.h"
 
-OSStatus MICOAddSector(json_object* sectors, char* const name,  json_object *menus)
+/* Sectors and menu cells are both {"N":name,"C":[...]}, the cells of a sector
+ * or the sectors of a menu go between the start and the end */
+static OSStatus _MICOStartList(struct json_writer *writer, char* const name)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
-
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "N", json_object_new_string(name));      
-  json_object_object_add(object, "C", menus);
-  json_object_array_add(sectors, object);
-
-exit:
-  return err;
+  json_writer_object_start(writer);
+  json_writer_key(writer, "N");
+  json_writer_string(writer, name);
+  json_writer_key(writer, "C");
+  json_writer_array_start(writer);
+  return writer->err ? kWriteErr : kNoErr;
 }
 
-OSStatus MICOAddStringCellToSector(json_object* menus, char* const name,  char* const content, char* const privilege, json_object* secectionArray)
+static OSStatus _MICOEndList(struct json_writer *writer)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
-
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "N", json_object_new_string(name));      
-  json_object_object_add(object, "C", json_object_new_string(content));
-  json_object_object_add(object, "P", json_object_new_string(privilege)); 
-
-  if(secectionArray)
-    json_object_object_add(object, "S", secectionArray); 
-
-  json_object_array_add(menus, object);
-
-
-exit:
-  return err;
+  json_writer_array_end(writer);
+  json_writer_object_end(writer);
+  return writer->err ? kWriteErr : kNoErr;
 }
 
-OSStatus MICOAddNumberCellToSector(json_object* menus, char* const name,  int content, char* const privilege, json_object* secectionArray)
+/* A cell is {"N":name,"C":content,"P":privilege[,"S":[selection]]} */
+static void _MICOStartCell(struct json_writer *writer, char* const name)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
-
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "N", json_object_new_string(name));      
-
-  json_object_object_add(object, "C", json_object_new_int(content));
-  json_object_object_add(object, "P", json_object_new_string(privilege)); 
-
-  if(secectionArray)
-    json_object_object_add(object, "S", secectionArray); 
-
-  json_object_array_add(menus, object);
-
-exit:
-  return err;
+  json_writer_object_start(writer);
+  json_writer_key(writer, "N");
+  json_writer_string(writer, name);
+  json_writer_key(writer, "C");
 }
 
-OSStatus MICOAddFloatCellToSector(json_object* menus, char* const name,  float content, char* const privilege, json_object* secectionArray)
+static void _MICOCellPrivilege(struct json_writer *writer, char* const privilege)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
-
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "N", json_object_new_string(name));      
-
-  json_object_object_add(object, "C", json_object_new_double(content));
-  json_object_object_add(object, "P", json_object_new_string(privilege)); 
+  json_writer_key(writer, "P");
+  json_writer_string(writer, privilege);
+}
 
-  if(secectionArray)
-    json_object_object_add(object, "S", secectionArray); 
+static OSStatus _MICOEndCell(struct json_writer *writer)
+{
+  json_writer_object_end(writer);
+  return writer->err ? kWriteErr : kNoErr;
+}
 
-  json_object_array_add(menus, object);
+OSStatus MICOStartSector(struct json_writer *writer, char* const name)
+{
+  return _MICOStartList(writer, name);
+}
 
-exit:
-  return err;  
+OSStatus MICOEndSector(struct json_writer *writer)
+{
+  return _MICOEndList(writer);
 }
 
+OSStatus MICOAddStringCellToSector(struct json_writer *writer, char* const name,  char* const content, char* const privilege, const char * const *selection, int selectionCount)
+{
+  int i;
+
+  _MICOStartCell(writer, name);
+  json_writer_string(writer, content);
+  _MICOCellPrivilege(writer, privilege);
+  if(selection){
+    json_writer_key(writer, "S");
+    json_writer_array_start(writer);
+    for(i = 0; i < selectionCount; i++)
+      json_writer_string(writer, selection[i]);
+    json_writer_array_end(writer);
+  }
+  return _MICOEndCell(writer);
+}
 
-OSStatus MICOAddSwitchCellToSector(json_object* menus, char* const name,  boolean switcher, char* const privilege)
+OSStatus MICOAddNumberCellToSector(struct json_writer *writer, char* const name,  int content, char* const privilege, const int *selection, int selectionCount)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
+  int i;
+
+  _MICOStartCell(writer, name);
+  json_writer_int(writer, content);
+  _MICOCellPrivilege(writer, privilege);
+  if(selection){
+    json_writer_key(writer, "S");
+    json_writer_array_start(writer);
+    for(i = 0; i < selectionCount; i++)
+      json_writer_int(writer, selection[i]);
+    json_writer_array_end(writer);
+  }
+  return _MICOEndCell(writer);
+}
 
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "N", json_object_new_string(name));      
-  json_object_object_add(object, "C", json_object_new_boolean(switcher));
-  json_object_object_add(object, "P", json_object_new_string(privilege)); 
-  json_object_array_add(menus, object);
+OSStatus MICOAddFloatCellToSector(struct json_writer *writer, char* const name,  float content, char* const privilege, const float *selection, int selectionCount)
+{
+  int i;
+
+  _MICOStartCell(writer, name);
+  json_writer_double(writer, content);
+  _MICOCellPrivilege(writer, privilege);
+  if(selection){
+    json_writer_key(writer, "S");
+    json_writer_array_start(writer);
+    for(i = 0; i < selectionCount; i++)
+      json_writer_double(writer, selection[i]);
+    json_writer_array_end(writer);
+  }
+  return _MICOEndCell(writer);
+}
 
-exit:
-  return err;
+OSStatus MICOAddSwitchCellToSector(struct json_writer *writer, char* const name,  boolean switcher, char* const privilege)
+{
+  _MICOStartCell(writer, name);
+  json_writer_boolean(writer, switcher);
+  _MICOCellPrivilege(writer, privilege);
+  return _MICOEndCell(writer);
 }
 
-OSStatus MICOAddMenuCellToSector(json_object* menus, char* const name, json_object* lowerSectors)
+OSStatus MICOStartMenuCell(struct json_writer *writer, char* const name)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
+  return _MICOStartList(writer, name);
+}
 
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "N", json_object_new_string(name));
-  json_object_object_add(object, "C", lowerSectors);
-  json_object_array_add(menus, object);
+OSStatus MICOEndMenuCell(struct json_writer *writer)
+{
+  return _MICOEndList(writer);
+}
 
-exit:
-  return err;
+OSStatus MICOStartTopMenu(struct json_writer *writer, char* const inName)
+{
+  json_writer_object_start(writer);
+  json_writer_key(writer, "T");
+  json_writer_string(writer, "Current Configuration");
+  json_writer_key(writer, "N");
+  json_writer_string(writer, inName);
+  json_writer_key(writer, "C");
+  json_writer_array_start(writer);
+  return writer->err ? kWriteErr : kNoErr;
 }
 
-OSStatus MICOAddTopMenu(json_object **outTopMenu, char* const inName, json_object* sectors, OTA_Versions_t inVersions)
+OSStatus MICOEndTopMenu(struct json_writer *writer, OTA_Versions_t inVersions)
 {
-  OSStatus err;
-  json_object *object;
-  err = kNoErr;
+  OSStatus err = kNoErr;
   require_action(inVersions.protocol, exit, err = kParamErr);
   require_action(inVersions.hdVersion, exit, err = kParamErr);
   require_action(inVersions.fwVersion, exit, err = kParamErr);
 
-  object = json_object_new_object();
-  require_action(object, exit, err = kNoMemoryErr);
-  json_object_object_add(object, "T", json_object_new_string("Current Configuration"));
-  json_object_object_add(object, "N", json_object_new_string(inName));
-  json_object_object_add(object, "C", sectors);
-
-  json_object_object_add(object, "PO", json_object_new_string(inVersions.protocol));
-  json_object_object_add(object, "HD", json_object_new_string(inVersions.hdVersion));
-  json_object_object_add(object, "FW", json_object_new_string(inVersions.fwVersion));
-  if(inVersions.rfVersion)
-    json_object_object_add(object, "RF", json_object_new_string(inVersions.rfVersion));
- 
-  *outTopMenu = object;
+  json_writer_array_end(writer);
+  json_writer_key(writer, "PO");
+  json_writer_string(writer, inVersions.protocol);
+  json_writer_key(writer, "HD");
+  json_writer_string(writer, inVersions.hdVersion);
+  json_writer_key(writer, "FW");
+  json_writer_string(writer, inVersions.fwVersion);
+  if(inVersions.rfVersion){
+    json_writer_key(writer, "RF");
+    json_writer_string(writer, inVersions.rfVersion);
+  }
+  json_writer_object_end(writer);
+  require_action(writer->err == 0, exit, err = kWriteErr);
+
 exit:
   return err;
 }
 
+int MICOConfigReportLength(void *userdata, const char *buf, int len)
+{
+  UNUSED_PARAMETER(buf);
+  *(int *)userdata += len;
+  return 0;
+}
@@ -35,6 +35,7 @@
 
 #include "Common.h"
 #include "JSON-C/json.h"
+#include "JSON-C/json_writer.h"
 
 typedef struct {
   char*  protocol;
@@ -44,18 +45,43 @@ typedef struct {
 } OTA_Versions_t;
 
 
-OSStatus MICOAddSector(json_object* sectors, char* const name,  json_object *menus);
+/* The report is written into the json_writer as it is built, nothing of it is
+ * held in RAM but the writer buffer. Every Start is closed by its End, cells go
+ * into the innermost open sector and sectors into the innermost open menu:
+ *
+ *   MICOStartTopMenu
+ *     MICOStartSector
+ *       MICOAdd...CellToSector
+ *       MICOStartMenuCell
+ *         MICOStartSector ... MICOEndSector
+ *       MICOEndMenuCell
+ *     MICOEndSector
+ *   MICOEndTopMenu
+ *
+ * A selection is optional, pass NULL and 0 for none. All return kWriteErr once
+ * the writer has failed, the rest of the report is then dropped. */
+OSStatus MICOStartTopMenu(struct json_writer *writer, char* const name);
 
-OSStatus MICOAddStringCellToSector(json_object* menus, char* const name,  char* const content, char* const privilege, json_object* secectionArray);
+OSStatus MICOEndTopMenu(struct json_writer *writer, OTA_Versions_t versions);
 
-OSStatus MICOAddNumberCellToSector(json_object* menus, char* const name,  int content, char* const privilege, json_object* secectionArray);
+OSStatus MICOStartSector(struct json_writer *writer, char* const name);
 
-OSStatus MICOAddFloatCellToSector(json_object* menus, char* const name,  float content, char* const privilege, json_object* secectionArray);
+OSStatus MICOEndSector(struct json_writer *writer);
 
-OSStatus MICOAddSwitchCellToSector(json_object* menus, char* const name,  boolean content, char* const privilege);
+OSStatus MICOAddStringCellToSector(struct json_writer *writer, char* const name,  char* const content, char* const privilege, const char * const *selection, int selectionCount);
 
-OSStatus MICOAddMenuCellToSector(json_object* menus, char* const name, json_object* lowerSectors);
+OSStatus MICOAddNumberCellToSector(struct json_writer *writer, char* const name,  int content, char* const privilege, const int *selection, int selectionCount);
 
-OSStatus MICOAddTopMenu(json_object **deviceInfo, char* const name, json_object* sectors, OTA_Versions_t versions);
+OSStatus MICOAddFloatCellToSector(struct json_writer *writer, char* const name,  float content, char* const privilege, const float *selection, int selectionCount);
+
+OSStatus MICOAddSwitchCellToSector(struct json_writer *writer, char* const name,  boolean content, char* const privilege);
+
+OSStatus MICOStartMenuCell(struct json_writer *writer, char* const name);
+
+OSStatus MICOEndMenuCell(struct json_writer *writer);
+
+/* A json_writer flush that only counts, for a Content-Length or a buffer size
+ * ahead of the real pass. userdata is an int, zeroed by the caller */
+int MICOConfigReportLength(void *userdata, const char *buf, int len);
 
 #endif
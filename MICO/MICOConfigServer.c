@@ -33,10 +33,11 @@
 #include "platform_config.h"
 #include "MICODefine.h"
 #include "SocketUtils.h"
-#include "Platform.h"
+#include "platform.h"
 #include "HTTPUtils.h"
 #include "MICONotificationCenter.h"
 #include "StringUtils.h"
+#include "JSON-C/json_writer.h"
 
 #define config_log(M, ...) custom_log("CONFIG SERVER", M, ##__VA_ARGS__)
 #define config_log_trace() custom_log_trace("CONFIG SERVER")
@@ -48,6 +49,9 @@
 
 #define kMIMEType_MXCHIP_OTA    "application/ota-stream"
 
+/* The report is streamed to the client in chunks of this size */
+#define kConfigReportChunkSize  512
+
 typedef struct _configContext_t{
   uint32_t flashStorageAddress;
   bool     isFlashLocked;
@@ -55,7 +59,7 @@ typedef struct _configContext_t{
 
 extern OSStatus     ConfigIncommingJsonMessage( const char *input, mico_Context_t * const inContext );
 extern OSStatus     ConfigIncommingJsonMessageUAP( const char *input, mico_Context_t * const inContext );
-extern json_object* ConfigCreateReportJsonMessage( mico_Context_t * const inContext );
+extern OSStatus     ConfigCreateReportJsonMessage( struct json_writer *writer, mico_Context_t * const inContext );
 
 static void localConfiglistener_thread(void *inContext);
 static void localConfig_thread(void *inFd);
@@ -64,6 +68,7 @@ static OSStatus _LocalConfigRespondInComingMessage(int fd, HTTPHeader_t* inHeade
 static void _easylinkConnectWiFi( mico_Context_t * const inContext);
 static OSStatus onReceivedData(struct _HTTPHeader_t * httpHeader, uint32_t pos, uint8_t * data, size_t len, void * userContext );
 static void onClearHTTPHeader(struct _HTTPHeader_t * httpHeader, void * userContext );
+static int _ConfigReportFlush(void *userdata, const char *buf, int len);
 
 OSStatus MICOStartConfigServer ( mico_Context_t * const inContext )
 {
@@ -223,7 +228,7 @@ static OSStatus onReceivedData(struct _HTTPHeader_t * inHeader, uint32_t inPos,
   size_t          valueSize;
   configContext_t *context = (configContext_t *)inUserContext;
 
-  err = HTTPGetHeaderField( inHeader->buf, inHeader->len, "Content-Type", NULL, NULL, &value, &valueSize, NULL );
+  err = HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueSize );
   if(err == kNoErr && strnicmpx( value, valueSize, kMIMEType_MXCHIP_OTA ) == 0){
     config_log("OTA data %d, %d to: %x", inPos, inLen, context->flashStorageAddress);
 #ifdef MICO_FLASH_FOR_UPDATE  
@@ -283,26 +288,30 @@ static void onClearHTTPHeader(struct _HTTPHeader_t * inHeader, void * inUserCont
 OSStatus _LocalConfigRespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico_Context_t * const inContext)
 {
   OSStatus err = kUnknownErr;
-  const char *  json_str;
-  uint8_t *httpResponse = NULL;
+  char httpResponse[kHTTPResponseHeaderMaxLen];
   size_t httpResponseLen = 0;
-  json_object* report = NULL;
+  unsigned long heapOps = json_c_heap_ops();
+  char *reportBuf = NULL;
+  struct json_writer writer;
   config_log_trace();
 
   if(HTTPHeaderMatchURL( inHeader, kCONFIGURLRead ) == kNoErr){    
-    report = ConfigCreateReportJsonMessage( inContext );
-    require( report, exit );
-    json_str = json_object_to_json_string(report);
-    require_action( json_str, exit, err = kNoMemoryErr );
-    config_log("Send config object=%s", json_str);
-    err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_JSON, strlen(json_str), &httpResponse, &httpResponseLen );
+    reportBuf = malloc( kConfigReportChunkSize );
+    require_action( reportBuf, exit, err = kNoMemoryErr );
+    httpResponseLen = HTTPResponseHeaderWrite( httpResponse, sizeof(httpResponse), kStatusOK, kMIMEType_JSON, 0, true );
+    require_action( httpResponseLen, exit, err = kSizeErr );
+    err = SocketSend( fd, (uint8_t *)httpResponse, httpResponseLen );
     require_noerr( err, exit );
-    require( httpResponse, exit );
-    err = SocketSend( fd, httpResponse, httpResponseLen );
+
+    /* The report is written to the socket while it is built, neither a tree
+       nor a string of it is ever held */
+    json_writer_init( &writer, reportBuf, kConfigReportChunkSize, _ConfigReportFlush, &fd );
+    err = ConfigCreateReportJsonMessage( &writer, inContext );
     require_noerr( err, exit );
-    err = SocketSend( fd, (uint8_t *)json_str, strlen(json_str) );
+    require_action( json_writer_finish( &writer ) == 0, exit, err = kWriteErr );
+    err = SocketSendHTTPChunk( fd, NULL, 0 );
     require_noerr( err, exit );
-    config_log("Current configuration sent");
+    config_log("Current configuration sent, %lu heap operations", json_c_heap_ops() - heapOps);
     goto exit;
   }
   else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLWrite ) == kNoErr){
@@ -313,10 +322,7 @@ OSStatus _LocalConfigRespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico
       inContext->flashContentInRam.micoSystemConfig.configured = allConfigured;
       MICOUpdateConfiguration(inContext);
 
-      err =  CreateSimpleHTTPOKMessage( &httpResponse, &httpResponseLen );
-      require_noerr( err, exit );
-      require( httpResponse, exit );
-      err = SocketSend( fd, httpResponse, httpResponseLen );
+      err = SocketSendHTTPResponse( fd, kStatusOK, NULL, NULL, 0 );
       SocketClose(&fd);
       inContext->micoStatus.sys_state = eState_Software_Reset;
       if(inContext->micoStatus.sys_state_change_sem != NULL );
@@ -332,11 +338,7 @@ else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLWriteByUAP ) == kNoErr){
       require_noerr( err, exit );
       MICOUpdateConfiguration(inContext);
 
-      err =  CreateSimpleHTTPOKMessage( &httpResponse, &httpResponseLen );
-      require_noerr( err, exit );
-      require( httpResponse, exit );
-
-      err = SocketSend( fd, httpResponse, httpResponseLen );
+      err = SocketSendHTTPResponse( fd, kStatusOK, NULL, NULL, 0 );
       require_noerr( err, exit );
       sleep(1);
 
@@ -375,13 +377,21 @@ else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLWriteByUAP ) == kNoErr){
  exit:
   if(inHeader->persistent == false)  //Return an err to close socket and exit the current thread
     err = kConnectionErr;
-  if(httpResponse)  free(httpResponse);
-  if(report)        json_object_put(report);
+  if(reportBuf)     free(reportBuf);
 
   return err;
 
 }
 
+static int _ConfigReportFlush(void *userdata, const char *buf, int len)
+{
+  int fd = *(int *)userdata;
+
+  if( SocketSendHTTPChunk( fd, (const uint8_t *)buf, len ) != kNoErr )
+    return -1;
+  return 0;
+}
+
 static void _easylinkConnectWiFi( mico_Context_t * const inContext)
 {
   config_log_trace();
@@ -0,0 +1,257 @@
+/**
+******************************************************************************
+* @file    MICOConnectionManager.c 
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   Connection manager, connect to remote servers with timeouts and
+*          back off between failed attempts.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "MICODefine.h"
+#include "MICODNSCache.h"
+#include "MICOConnectionManager.h"
+#include "SocketUtils.h"
+
+#define conn_log(M, ...) custom_log("Connection", M, ##__VA_ARGS__)
+
+static const uint32_t       _histogramLimits[MICO_CONN_HISTOGRAM_BINS] = MICO_CONN_HISTOGRAM_LIMITS;
+static mico_conn_stats_t    _connStats;
+/* Connections run on threads of their own, they all count into _connStats.
+   Created by the first MICOConnectionInit() */
+static mico_mutex_t         _connStatsMutex = NULL;
+
+static void _MICOConnectionRecord( mico_connection_t *conn, int fd, uint32_t time, bool timeout )
+{
+  int i;
+
+  mico_rtos_lock_mutex(&_connStatsMutex);
+  if(fd >= 0){
+    conn->stats.connected++;
+    conn->stats.lastConnectTime = time;
+    _connStats.connected++;
+    _connStats.lastConnectTime = time;
+    for(i = 0; i < MICO_CONN_HISTOGRAM_BINS - 1 && time >= _histogramLimits[i]; i++);
+    conn->stats.histogram[i]++;
+    _connStats.histogram[i]++;
+  }else if(timeout == true){
+    conn->stats.timeouts++;
+    _connStats.timeouts++;
+  }else{
+    conn->stats.failed++;
+    _connStats.failed++;
+  }
+  mico_rtos_unlock_mutex(&_connStatsMutex);
+}
+
+static void _MICOConnectionBackoff( mico_connection_t *conn )
+{
+  if(conn->backoff == 0)
+    conn->backoff = conn->backoffMin;
+  else if(conn->backoff < conn->backoffMax/2)
+    conn->backoff *= 2;
+  else
+    conn->backoff = conn->backoffMax;
+}
+
+/* Start a non-blocking connect, returns the socket or -1 */
+static int _MICOConnectionStart( uint32_t addr, uint16_t port )
+{
+  struct sockaddr_t sockaddr;
+  int fd, nonblock = 1;
+
+  fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if(fd < 0)
+    return -1;
+  if(setsockopt(fd, SOL_SOCKET, SO_BLOCKMODE, &nonblock, sizeof(nonblock)) < 0){
+    SocketClose(&fd);
+    return -1;
+  }
+  sockaddr.s_ip = addr;
+  sockaddr.s_port = port;
+  connect(fd, &sockaddr, sizeof(sockaddr));
+  return fd;
+}
+
+/* Start a connect to every address, MICO_CONN_ATTEMPT_DELAY apart, and keep the
+   first one that succeeds */
+static int _MICOConnectionRace( mico_connection_t *conn, const uint32_t *addrs, int count, bool *timeout )
+{
+  int fds[MICO_CONN_MAX_ADDRS];
+  int started = 0, alive = 0, winner = -1;
+  int i, maxFd, err, block = 0;
+  socklen_t len;
+  uint32_t begin = mico_get_time(), lastStart = 0, now, wait;
+  fd_set writefds;
+  struct timeval_t t;
+
+  *timeout = false;
+  while(winner < 0){
+    now = mico_get_time();
+    if(started < count && (alive == 0 || now - lastStart >= MICO_CONN_ATTEMPT_DELAY)){
+      fds[started] = _MICOConnectionStart(addrs[started], conn->port);
+      if(fds[started] >= 0) alive++;
+      started++;
+      lastStart = now;
+      conn->stats.attempts++;
+      mico_rtos_lock_mutex(&_connStatsMutex);
+      _connStats.attempts++;
+      mico_rtos_unlock_mutex(&_connStatsMutex);
+    }
+    if(alive == 0){
+      if(started == count) break;
+      continue;
+    }
+    if(now - begin >= conn->timeout){
+      *timeout = true;
+      break;
+    }
+
+    wait = conn->timeout - (now - begin);
+    if(started < count && wait > MICO_CONN_ATTEMPT_DELAY - (now - lastStart))
+      wait = MICO_CONN_ATTEMPT_DELAY - (now - lastStart);
+    t.tv_sec = wait/1000;
+    t.tv_usec = (wait%1000)*1000;
+
+    FD_ZERO(&writefds);
+    for(i = 0, maxFd = 0; i < started; i++){
+      if(fds[i] < 0) continue;
+      FD_SET(fds[i], &writefds);
+      if(fds[i] > maxFd) maxFd = fds[i];
+    }
+    /* An error would come back at once every time round, give up on the race */
+    err = select(maxFd + 1, NULL, &writefds, NULL, &t);
+    if(err < 0){
+      conn_log("Select error %d while connecting to %s", err, conn->host);
+      break;
+    }
+    if(err == 0)
+      continue;
+
+    for(i = 0; i < started; i++){
+      if(fds[i] < 0 || !FD_ISSET(fds[i], &writefds)) continue;
+      len = sizeof(err);
+      getsockopt(fds[i], SOL_SOCKET, SO_ERROR, &err, &len);
+      if(err == 0 && winner < 0){
+        winner = i;
+      }else{
+        SocketClose(&fds[i]);
+        alive--;
+      }
+    }
+  }
+
+  for(i = 0; i < started; i++){
+    if(i != winner) SocketClose(&fds[i]);
+  }
+  if(winner < 0)
+    return -1;
+
+  conn->lastAddr = addrs[winner];
+  setsockopt(fds[winner], SOL_SOCKET, SO_BLOCKMODE, &block, sizeof(block));
+  return fds[winner];
+}
+
+OSStatus MICOConnectionInit( mico_connection_t *conn, const char *host, uint16_t port )
+{
+  OSStatus err = kNoErr;
+
+  require_action(conn && host && strlen(host) < DNS_CACHE_NAME_LEN, exit, err = kParamErr);
+  if(_connStatsMutex == NULL){
+    err = mico_rtos_init_mutex(&_connStatsMutex);
+    require_noerr(err, exit);
+  }
+
+  memset(conn, 0x0, sizeof(mico_connection_t));
+  strncpy(conn->host, host, DNS_CACHE_NAME_LEN-1);
+  conn->port = port;
+  conn->timeout = MICO_CONN_TIMEOUT;
+  conn->backoffMin = MICO_CONN_BACKOFF_MIN;
+  conn->backoffMax = MICO_CONN_BACKOFF_MAX;
+
+exit:
+  return err;
+}
+
+int MICOConnectionOpen( mico_connection_t *conn )
+{
+  uint32_t addrs[MICO_CONN_MAX_ADDRS];
+  uint32_t random, begin;
+  int count = 0, fd = -1;
+  bool timeout = false;
+  char ipstr[16];
+
+  if(conn->backoff){
+    MicoRandomNumberRead(&random, sizeof(random));
+    mico_thread_msleep(conn->backoff/2 + random%(conn->backoff/2 + 1));
+  }
+
+  begin = mico_get_time();
+  if(MICOGetHostByName(conn->host, ipstr, 16) == kNoErr)
+    addrs[count++] = inet_addr(ipstr);
+  if(conn->lastAddr != 0 && (count == 0 || addrs[0] != conn->lastAddr))
+    addrs[count++] = conn->lastAddr;
+
+  if(count)
+    fd = _MICOConnectionRace(conn, addrs, count, &timeout);
+  _MICOConnectionRecord(conn, fd, mico_get_time() - begin, timeout);
+
+  if(fd < 0){
+    MICOExpireHostByName(conn->host);
+    _MICOConnectionBackoff(conn);
+    conn_log("Connect to %s:%d failed, retry in %d ms", conn->host, conn->port, conn->backoff);
+  }else{
+    conn->connected = true;
+    conn->connectedTime = mico_get_time();
+  }
+  return fd;
+}
+
+void MICOConnectionClosed( mico_connection_t *conn, bool failed )
+{
+  /* Not connected, MICOConnectionOpen() has backed off already */
+  if(conn->connected == false)
+    return;
+
+  if(failed == false || mico_get_time() - conn->connectedTime >= MICO_CONN_STABLE_TIME)
+    conn->backoff = 0;
+  else
+    _MICOConnectionBackoff(conn);
+  conn->connected = false;
+}
+
+void MICOConnectionGetStatistics( mico_conn_stats_t *stats )
+{
+  /* No connection yet, nothing counted */
+  if(_connStatsMutex == NULL){
+    memset(stats, 0x0, sizeof(mico_conn_stats_t));
+    return;
+  }
+  mico_rtos_lock_mutex(&_connStatsMutex);
+  memcpy(stats, &_connStats, sizeof(mico_conn_stats_t));
+  mico_rtos_unlock_mutex(&_connStatsMutex);
+}
+
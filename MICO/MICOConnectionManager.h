@@ -0,0 +1,97 @@
+/**
+******************************************************************************
+* @file    MICOConnectionManager.h 
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   Connection manager, connect to remote servers with timeouts and
+*          back off between failed attempts.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#ifndef __MICOCONNECTIONMANAGER_H__
+#define __MICOCONNECTIONMANAGER_H__
+
+#include "Common.h"
+#include "MICODefine.h"
+
+/* A connection tries the address resolved for host and the last address it
+   connected to, the second one MICO_CONN_ATTEMPT_DELAY after the first, and keeps
+   the socket that connects first. After a failure the next attempt waits a random
+   time between half and all of the back off delay, which doubles from
+   MICO_CONN_BACKOFF_MIN up to MICO_CONN_BACKOFF_MAX. */
+
+#define MICO_CONN_TIMEOUT           (10*1000)    //ms
+#define MICO_CONN_ATTEMPT_DELAY     (250)        //ms
+#define MICO_CONN_BACKOFF_MIN       (1000)       //ms
+#define MICO_CONN_BACKOFF_MAX       (5*60*1000)  //ms
+#define MICO_CONN_STABLE_TIME       (30*1000)    //ms, a link up this long resets the back off
+#define MICO_CONN_MAX_ADDRS         (2)
+
+/* Connect time histogram, bin n counts the connects faster than
+   MICO_CONN_HISTOGRAM_LIMITS[n] ms, the last bin all slower ones */
+#define MICO_CONN_HISTOGRAM_BINS    (7)
+#define MICO_CONN_HISTOGRAM_LIMITS  { 100, 250, 500, 1000, 2000, 5000, 0xFFFFFFFF }
+
+typedef struct _mico_conn_stats_t {
+  uint32_t          attempts;
+  uint32_t          connected;
+  uint32_t          failed;
+  uint32_t          timeouts;
+  uint32_t          lastConnectTime;   //ms
+  uint32_t          histogram[MICO_CONN_HISTOGRAM_BINS];
+} mico_conn_stats_t;
+
+typedef struct _mico_connection_t {
+  char              host[DNS_CACHE_NAME_LEN];
+  uint16_t          port;
+  uint32_t          timeout;           //ms, for one connect
+  uint32_t          backoffMin;
+  uint32_t          backoffMax;
+  /* State */
+  uint32_t          backoff;           //Delay before the next connect, 0 for none
+  uint32_t          lastAddr;          //Last address connected to, 0 for none
+  bool              connected;
+  uint32_t          connectedTime;
+  mico_conn_stats_t stats;
+} mico_connection_t;
+
+
+/* Default timeout and back off for host:port, change them in conn before the first
+   MICOConnectionOpen() */
+OSStatus MICOConnectionInit( mico_connection_t *conn, const char *host, uint16_t port );
+
+/* Wait out the back off delay, then connect. Returns a socket in block mode, or -1
+   with the back off delay increased */
+int MICOConnectionOpen( mico_connection_t *conn );
+
+/* The socket from MICOConnectionOpen() is closed, because of an error when failed
+   is true. A link that failed before MICO_CONN_STABLE_TIME keeps the back off */
+void MICOConnectionClosed( mico_connection_t *conn, bool failed );
+
+/* Totals of all connections since start up */
+void MICOConnectionGetStatistics( mico_conn_stats_t *stats );
+
+#endif //__MICOCONNECTIONMANAGER_H__
+
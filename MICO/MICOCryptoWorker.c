@@ -0,0 +1,178 @@
+/**
+******************************************************************************
+* @file    MICOCryptoWorker.c 
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   Crypto worker, run expensive handshake crypto on a thread below
+*          the application priority.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "MICODefine.h"
+#include "MICOCryptoWorker.h"
+
+#define crypto_worker_log(M, ...) custom_log("Crypto worker", M, ##__VA_ARGS__)
+
+static bool                 _cryptoWorkerStarted = false;
+static mico_thread_t        _cryptoWorkerThread = NULL;
+static mico_mutex_t         _cryptoJobMutex = NULL;
+static mico_semaphore_t     _cryptoJobSem = NULL;
+static mico_crypto_job_t*   _cryptoJobHead[CryptoJobPriorityMax];
+static mico_crypto_job_t*   _cryptoJobTail[CryptoJobPriorityMax];
+static uint32_t             _cryptoJobNumber = 0;
+
+void mico_crypto_worker_thread_main( void* arg );
+
+OSStatus MICOStartCryptoWorker( void )
+{
+  OSStatus err = kNoErr;
+
+  if(_cryptoWorkerStarted == true)
+    return kNoErr;
+
+  memset(_cryptoJobHead, 0, sizeof(_cryptoJobHead));
+  memset(_cryptoJobTail, 0, sizeof(_cryptoJobTail));
+  err = mico_rtos_init_mutex(&_cryptoJobMutex);
+  require_noerr(err, exit);
+  err = mico_rtos_init_semaphore(&_cryptoJobSem, MICO_CRYPTO_JOB_MAX);
+  require_noerr(err, exit);
+
+  err = mico_rtos_create_thread(&_cryptoWorkerThread, MICO_CRYPTO_WORKER_PRIORITY, "Crypto worker", mico_crypto_worker_thread_main, STACK_SIZE_MICO_CRYPTO_WORKER_THREAD, NULL );
+  require_noerr(err, exit);
+  _cryptoWorkerStarted = true;
+
+exit:
+  return err;
+}
+
+static mico_crypto_job_t* _MICOCryptoJobPop( void )
+{
+  mico_crypto_job_t* job = NULL;
+  int i;
+
+  mico_rtos_lock_mutex(&_cryptoJobMutex);
+  for(i = 0; i < CryptoJobPriorityMax; i++){
+    job = _cryptoJobHead[i];
+    if(job != NULL){
+      _cryptoJobHead[i] = job->next;
+      if(_cryptoJobHead[i] == NULL)
+        _cryptoJobTail[i] = NULL;
+      _cryptoJobNumber--;
+      break;
+    }
+  }
+  mico_rtos_unlock_mutex(&_cryptoJobMutex);
+  return job;
+}
+
+void mico_crypto_worker_thread_main( void* arg )
+{
+  (void)arg;
+  mico_crypto_job_t* job;
+
+  while(1)
+  {
+    mico_rtos_get_semaphore(&_cryptoJobSem, MICO_WAIT_FOREVER);
+    job = _MICOCryptoJobPop();
+    if(job == NULL)
+      continue;
+
+    job->err = job->function(job->arg);
+    if(job->done != NULL)
+      job->done(job);
+  }
+}
+
+OSStatus MICOSubmitCryptoJob( mico_crypto_job_t* job )
+{
+  OSStatus err = kNoErr;
+
+  require_action(job && job->function && job->priority < CryptoJobPriorityMax, exit, err = kParamErr);
+  require_action(_cryptoWorkerStarted == true, exit, err = kNotInitializedErr);
+
+  mico_rtos_lock_mutex(&_cryptoJobMutex);
+  if(_cryptoJobNumber >= MICO_CRYPTO_JOB_MAX){
+    mico_rtos_unlock_mutex(&_cryptoJobMutex);
+    err = kNoResourcesErr;
+    goto exit;
+  }
+  job->next = NULL;
+  if(_cryptoJobTail[job->priority] != NULL)
+    _cryptoJobTail[job->priority]->next = job;
+  else
+    _cryptoJobHead[job->priority] = job;
+  _cryptoJobTail[job->priority] = job;
+  _cryptoJobNumber++;
+  mico_rtos_unlock_mutex(&_cryptoJobMutex);
+
+  mico_rtos_set_semaphore(&_cryptoJobSem);
+
+exit:
+  return err;
+}
+
+static void _MICOCryptoJobWake( mico_crypto_job_t* job )
+{
+  mico_rtos_set_semaphore((mico_semaphore_t *)job->context);
+}
+
+OSStatus MICORunCryptoJob( mico_crypto_job_function_t function, void* arg, mico_crypto_job_priority_t priority )
+{
+  OSStatus err = kNoErr;
+  mico_crypto_job_t job;
+  mico_semaphore_t finished = NULL;
+
+  require_action(function, exit, err = kParamErr);
+
+  /* A job that runs another one, or no worker to run it */
+  if(_cryptoWorkerStarted == false || mico_rtos_is_current_thread(&_cryptoWorkerThread) == true)
+    return function(arg);
+
+  err = mico_rtos_init_semaphore(&finished, 1);
+  require_noerr(err, exit);
+
+  memset(&job, 0, sizeof(mico_crypto_job_t));
+  job.function = function;
+  job.arg = arg;
+  job.priority = priority;
+  job.done = _MICOCryptoJobWake;
+  job.context = &finished;
+
+  err = MICOSubmitCryptoJob(&job);
+  if(err != kNoErr){
+    crypto_worker_log("Worker busy, err = %d, run in place", err);
+    err = function(arg);
+    goto exit;
+  }
+
+  mico_rtos_get_semaphore(&finished, MICO_WAIT_FOREVER);
+  err = job.err;
+
+exit:
+  if(finished) mico_rtos_deinit_semaphore(&finished);
+  return err;
+}
+
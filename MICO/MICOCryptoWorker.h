@@ -0,0 +1,87 @@
+/**
+******************************************************************************
+* @file    MICOCryptoWorker.h 
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   Crypto worker, run expensive handshake crypto on a thread below
+*          the application priority.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#ifndef __MICOCRYPTOWORKER_H__
+#define __MICOCRYPTOWORKER_H__
+
+#include "Common.h"
+#include "MICORTOS.h"
+
+/* SRP, Curve25519 and Ed25519 take hundreds of milliseconds. Run as jobs on the
+   crypto worker they are preempted by every application thread, so the threads
+   moving data are not held up by a handshake. Jobs of a higher priority run first,
+   jobs of the same priority in the order they were submitted. */
+
+#define MICO_CRYPTO_WORKER_PRIORITY   (MICO_APPLICATION_PRIORITY + 1)
+
+#ifndef MICO_CRYPTO_JOB_MAX
+#define MICO_CRYPTO_JOB_MAX           (8)
+#endif
+
+typedef enum
+{
+  CryptoJobPriorityHigh = 0,  /**< Handshakes of known peers, e.g. session verify */
+  CryptoJobPriorityLow,       /**< One time handshakes, e.g. pairing */
+  CryptoJobPriorityMax,
+} mico_crypto_job_priority_t;
+
+typedef struct _mico_crypto_job_t mico_crypto_job_t;
+
+typedef OSStatus (*mico_crypto_job_function_t)( void* arg );
+typedef void (*mico_crypto_job_done_t)( mico_crypto_job_t* job );
+
+/** Structure to hold a crypto job, it belongs to the worker until done is called */
+struct _mico_crypto_job_t
+{
+  mico_crypto_job_function_t  function;  /**< Runs on the worker thread */
+  void*                       arg;       /**< Argument of function */
+  mico_crypto_job_priority_t  priority;
+  mico_crypto_job_done_t      done;      /**< Called on the worker thread after function, can be NULL */
+  void*                       context;   /**< Free for the caller, e.g. for done */
+  OSStatus                    err;       /**< Return value of function */
+  mico_crypto_job_t*          next;
+};
+
+
+OSStatus MICOStartCryptoWorker( void );
+
+/* Queue a job and return, job->done tells when it is finished. Returns
+   kNoResourcesErr when MICO_CRYPTO_JOB_MAX jobs are already waiting */
+OSStatus MICOSubmitCryptoJob( mico_crypto_job_t* job );
+
+/* Run function on the worker and wait for it, the calling thread sleeps in the
+   meantime. function runs in place when the worker is not started or is busy */
+OSStatus MICORunCryptoJob( mico_crypto_job_function_t function, void* arg, mico_crypto_job_priority_t priority );
+
+
+#endif //__MICOCRYPTOWORKER_H__
+
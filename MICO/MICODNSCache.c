@@ -0,0 +1,468 @@
+/**
+******************************************************************************
+* @file    MICODNSCache.c 
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   Host name cache, resolve names on a thread of its own and keep the
+*          addresses for reconnects and the next boot.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "MICODefine.h"
+#include "MICODNSCache.h"
+#include "platform_config.h"
+#include "MicoPlatform.h"
+
+#define dns_log(M, ...) custom_log("DNS cache", M, ##__VA_ARGS__)
+
+#define kDNSCacheFlashMagic         0x32534E44 //"DNS2"
+#define kDNSCacheQueueLength        8
+
+/*Last known addresses, in a flash partition of their own so that writing them never
+  erases the system configuration*/
+typedef struct _dns_cache_in_flash_t {
+  uint32_t        magic;
+  struct {
+    char          name[DNS_CACHE_NAME_LEN];
+    char          addr[maxIpLen];
+  } host[DNS_CACHE_SAVED_NUM];
+} dns_cache_in_flash_t;
+
+typedef enum {
+  DNSCacheMiss,
+  DNSCacheFresh,     //Within DNS_CACHE_TTL
+  DNSCacheStale,     //Expired, but within DNS_CACHE_STALE_TIME
+  DNSCacheOld,       //Only good when the name cannot be resolved
+  DNSCacheFailed,    //No address, failed within DNS_CACHE_NEGATIVE_TTL
+} dns_cache_state_t;
+
+typedef struct _dns_cache_entry_t {
+  bool        used;
+  bool        valid;       //addr holds an address
+  bool        expired;     //Loaded from flash, or expired by MICOExpireHostByName
+  bool        pending;     //A background resolution is queued
+  bool        stored;      //name has a slot in flash
+  bool        broken;      //Connecting to addr failed, MICOExpireHostByName
+  bool        dirty;       //addr should be written to flash
+  uint32_t    resolvedTime;
+  uint32_t    failedTime;
+  uint32_t    lastUsed;
+  char        name[DNS_CACHE_NAME_LEN];
+  char        addr[maxIpLen];
+} dns_cache_entry_t;
+
+typedef struct _dns_request_t {
+  mico_dns_callback_t callback;
+  void*               arg;
+  char                name[DNS_CACHE_NAME_LEN];
+} dns_request_t;
+
+typedef struct _dns_wait_t {
+  mico_semaphore_t    done;
+  OSStatus            err;
+  char                addr[maxIpLen];
+} dns_wait_t;
+
+static bool                 _dnsCacheStarted = false;
+static mico_mutex_t         _dnsCacheMutex = NULL;
+static mico_queue_t         _dnsRequestQueue = NULL;
+static dns_cache_entry_t    _dnsCache[DNS_CACHE_SIZE];
+#ifdef MICO_FLASH_FOR_DNS_CACHE
+static dns_cache_in_flash_t _dnsSavedHosts;
+static uint32_t             _dnsLastSaveTime = 0;
+static bool                 _dnsSaved = false;
+#endif
+
+void dnsResolver_thread( void *inContext );
+
+static dns_cache_entry_t* _DNSCacheFind( const char* name )
+{
+  int i;
+
+  for(i = 0; i < DNS_CACHE_SIZE; i++){
+    if(_dnsCache[i].used == true && strncmp(_dnsCache[i].name, name, DNS_CACHE_NAME_LEN) == 0)
+      return &_dnsCache[i];
+  }
+  return NULL;
+}
+
+/* A free entry, or the least recently used one */
+static dns_cache_entry_t* _DNSCacheAlloc( const char* name, uint32_t now )
+{
+  dns_cache_entry_t* entry = NULL;
+  int i;
+
+  for(i = 0; i < DNS_CACHE_SIZE; i++){
+    if(_dnsCache[i].used == false){
+      entry = &_dnsCache[i];
+      break;
+    }
+    if(entry == NULL || now - _dnsCache[i].lastUsed > now - entry->lastUsed)
+      entry = &_dnsCache[i];
+  }
+  memset(entry, 0x0, sizeof(dns_cache_entry_t));
+  entry->used = true;
+  entry->lastUsed = now;
+  strncpy(entry->name, name, DNS_CACHE_NAME_LEN-1);
+  return entry;
+}
+
+static dns_cache_state_t _DNSCacheState( const dns_cache_entry_t* entry, uint32_t now )
+{
+  if(entry == NULL)
+    return DNSCacheMiss;
+  if(entry->valid == false)
+    return (now - entry->failedTime < DNS_CACHE_NEGATIVE_TTL)? DNSCacheFailed : DNSCacheMiss;
+  if(entry->expired == false && now - entry->resolvedTime < DNS_CACHE_TTL)
+    return DNSCacheFresh;
+  if(now - entry->resolvedTime < DNS_CACHE_TTL + DNS_CACHE_STALE_TIME)
+    return DNSCacheStale;
+  return DNSCacheOld;
+}
+
+/* Copy the cached address of name to addr, and mark the entry pending when the
+   caller should queue a background resolution */
+static dns_cache_state_t _DNSCacheLookup( const char* name, char* addr, uint8_t addrLen, bool *refresh )
+{
+  dns_cache_entry_t* entry;
+  dns_cache_state_t state;
+  uint32_t now = mico_get_time();
+
+  mico_rtos_lock_mutex(&_dnsCacheMutex);
+  entry = _DNSCacheFind(name);
+  state = _DNSCacheState(entry, now);
+  if(entry != NULL && entry->valid == true){
+    entry->lastUsed = now;
+    strncpy(addr, entry->addr, addrLen);
+    addr[addrLen-1] = 0x0;
+  }
+  if(refresh != NULL){
+    *refresh = (state == DNSCacheStale && entry->pending == false);
+    if(*refresh == true)
+      entry->pending = true;
+  }
+  mico_rtos_unlock_mutex(&_dnsCacheMutex);
+  return state;
+}
+
+/* Round-robin and CDN names resolve to a new address almost every time, so a stored
+   address is only replaced once it stopped working, and flash is written at most once
+   per DNS_CACHE_SAVE_INTERVAL. Names beyond DNS_CACHE_SAVED_NUM are not stored */
+static void _DNSCacheSave( void )
+{
+#ifdef MICO_FLASH_FOR_DNS_CACHE
+  OSStatus err = kNoErr;
+  dns_cache_in_flash_t saved;
+  dns_cache_entry_t *entry;
+  bool changed = false;
+  uint32_t now = mico_get_time();
+  uint32_t address = DNS_CACHE_START_ADDRESS;
+  int i, j;
+
+  if(_dnsSaved == true && now - _dnsLastSaveTime < DNS_CACHE_SAVE_INTERVAL)
+    return;
+
+  mico_rtos_lock_mutex(&_dnsCacheMutex);
+  for(i = 0; i < DNS_CACHE_SIZE; i++){
+    entry = &_dnsCache[i];
+    if(entry->used == false || entry->valid == false || entry->dirty == false)
+      continue;
+    entry->dirty = false;
+    for(j = 0; j < DNS_CACHE_SAVED_NUM; j++){
+      if(strncmp(_dnsSavedHosts.host[j].name, entry->name, DNS_CACHE_NAME_LEN) == 0 || _dnsSavedHosts.host[j].name[0] == 0x0)
+        break;
+    }
+    if(j == DNS_CACHE_SAVED_NUM)
+      continue;
+    entry->stored = true;
+    if(strncmp(_dnsSavedHosts.host[j].name, entry->name, DNS_CACHE_NAME_LEN) != 0 ||
+       strncmp(_dnsSavedHosts.host[j].addr, entry->addr, maxIpLen) != 0){
+      strncpy(_dnsSavedHosts.host[j].name, entry->name, DNS_CACHE_NAME_LEN);
+      strncpy(_dnsSavedHosts.host[j].addr, entry->addr, maxIpLen);
+      changed = true;
+    }
+  }
+  memcpy(&saved, &_dnsSavedHosts, sizeof(dns_cache_in_flash_t));
+  mico_rtos_unlock_mutex(&_dnsCacheMutex);
+
+  if(changed == false)
+    return;
+
+  dns_log("Save host addresses");
+  _dnsLastSaveTime = now;
+  _dnsSaved = true;
+  err = MicoFlashInitialize(MICO_FLASH_FOR_DNS_CACHE);
+  require_noerr(err, exit);
+  err = MicoFlashErase(MICO_FLASH_FOR_DNS_CACHE, DNS_CACHE_START_ADDRESS, DNS_CACHE_END_ADDRESS);
+  require_noerr(err, exit);
+  err = MicoFlashWrite(MICO_FLASH_FOR_DNS_CACHE, &address, (uint8_t *)&saved, sizeof(dns_cache_in_flash_t));
+  require_noerr(err, exit);
+
+exit:
+  MicoFlashFinalize(MICO_FLASH_FOR_DNS_CACHE);
+  if(err != kNoErr)
+    dns_log("Save host addresses failed, err = %d", err);
+#endif
+}
+
+static void _DNSCacheUpdate( const char* name, OSStatus err, const char* addr )
+{
+  dns_cache_entry_t* entry;
+  uint32_t now = mico_get_time();
+
+  mico_rtos_lock_mutex(&_dnsCacheMutex);
+  entry = _DNSCacheFind(name);
+  if(entry == NULL)
+    entry = _DNSCacheAlloc(name, now);
+  entry->pending = false;
+  if(err == kNoErr){
+    /* A new name, or a stored one whose address stopped working */
+    if(entry->stored == false || entry->broken == true)
+      entry->dirty = true;
+    entry->broken = false;
+    strncpy(entry->addr, addr, maxIpLen-1);
+    entry->valid = true;
+    entry->expired = false;
+    entry->resolvedTime = now;
+  }else{
+    entry->failedTime = now;
+  }
+  mico_rtos_unlock_mutex(&_dnsCacheMutex);
+}
+
+static void _DNSCacheLoad( void )
+{
+#ifdef MICO_FLASH_FOR_DNS_CACHE
+  dns_cache_entry_t* entry;
+  uint32_t now = mico_get_time();
+  uint32_t address = DNS_CACHE_START_ADDRESS;
+  int i;
+
+  if(MicoFlashInitialize(MICO_FLASH_FOR_DNS_CACHE) != kNoErr ||
+     MicoFlashRead(MICO_FLASH_FOR_DNS_CACHE, &address, (uint8_t *)&_dnsSavedHosts, sizeof(dns_cache_in_flash_t)) != kNoErr)
+    _dnsSavedHosts.magic = 0;
+  MicoFlashFinalize(MICO_FLASH_FOR_DNS_CACHE);
+
+  if(_dnsSavedHosts.magic != kDNSCacheFlashMagic){
+    memset(&_dnsSavedHosts, 0x0, sizeof(dns_cache_in_flash_t));
+    _dnsSavedHosts.magic = kDNSCacheFlashMagic;
+    return;
+  }
+
+  for(i = 0; i < DNS_CACHE_SAVED_NUM && i < DNS_CACHE_SIZE; i++){
+    _dnsSavedHosts.host[i].name[DNS_CACHE_NAME_LEN-1] = 0x0;
+    _dnsSavedHosts.host[i].addr[maxIpLen-1] = 0x0;
+    if(_dnsSavedHosts.host[i].name[0] == 0x0)
+      continue;
+    entry = _DNSCacheAlloc(_dnsSavedHosts.host[i].name, now);
+    strncpy(entry->addr, _dnsSavedHosts.host[i].addr, maxIpLen-1);
+    entry->valid = true;
+    entry->expired = true;
+    entry->stored = true;
+    entry->resolvedTime = now;
+  }
+#endif
+}
+
+/* broken: the address did not work, so a new one may replace it in flash */
+static void _DNSCacheExpire( const char* name, bool broken )
+{
+  dns_cache_entry_t* entry;
+
+  mico_rtos_lock_mutex(&_dnsCacheMutex);
+  entry = _DNSCacheFind(name);
+  if(entry != NULL){
+    /* Older than the stale time, the next lookup waits for a new address and
+       only falls back to this one if resolving fails */
+    entry->expired = true;
+    entry->pending = false;
+    entry->broken |= broken;
+    entry->resolvedTime = mico_get_time() - DNS_CACHE_TTL - DNS_CACHE_STALE_TIME;
+  }
+  mico_rtos_unlock_mutex(&_dnsCacheMutex);
+}
+
+static OSStatus _DNSCacheQueue( const char* name, mico_dns_callback_t callback, void* arg )
+{
+  dns_request_t request;
+
+  request.callback = callback;
+  request.arg = arg;
+  strncpy(request.name, name, DNS_CACHE_NAME_LEN-1);
+  request.name[DNS_CACHE_NAME_LEN-1] = 0x0;
+  return mico_rtos_push_to_queue(&_dnsRequestQueue, &request, 0);
+}
+
+void dnsResolver_thread( void *inContext )
+{
+  (void)inContext;
+  OSStatus err;
+  dns_request_t request;
+  dns_cache_state_t state;
+  char addr[maxIpLen];
+
+  while(1){
+    if(mico_rtos_pop_from_queue(&_dnsRequestQueue, &request, MICO_WAIT_FOREVER) != kNoErr)
+      continue;
+
+    /* Answered by an earlier request for the same name */
+    state = _DNSCacheLookup(request.name, addr, maxIpLen, NULL);
+    if(state == DNSCacheFresh){
+      err = kNoErr;
+    }else if(state == DNSCacheFailed){
+      err = kNotFoundErr;
+    }else{
+      err = gethostbyname(request.name, (uint8_t *)addr, maxIpLen);
+      _DNSCacheUpdate(request.name, err, addr);
+      if(err == kNoErr){
+        _DNSCacheSave();
+      }else{
+        state = _DNSCacheLookup(request.name, addr, maxIpLen, NULL);
+        if(state != DNSCacheMiss && state != DNSCacheFailed){
+          dns_log("Resolve %s failed, use the last address %s", request.name, addr);
+          err = kNoErr;
+        }
+      }
+    }
+    if(err != kNoErr)
+      addr[0] = 0x0;
+
+    if(request.callback != NULL)
+      request.callback(err, request.name, addr, request.arg);
+  }
+}
+
+OSStatus MICOStartDNSCache( mico_Context_t * const inContext )
+{
+  OSStatus err = kNoErr;
+
+  if(_dnsCacheStarted == true)
+    return kNoErr;
+
+  memset(_dnsCache, 0x0, sizeof(_dnsCache));
+  err = mico_rtos_init_mutex(&_dnsCacheMutex);
+  require_noerr(err, exit);
+  err = mico_rtos_init_queue(&_dnsRequestQueue, "DNS requests", sizeof(dns_request_t), kDNSCacheQueueLength);
+  require_noerr(err, exit);
+  _DNSCacheLoad();
+
+  err = mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "DNS resolver", dnsResolver_thread, STACK_SIZE_DNS_RESOLVER_THREAD, (void*)inContext );
+  require_noerr(err, exit);
+  _dnsCacheStarted = true;
+
+exit:
+  return err;
+}
+
+OSStatus MICOResolveHostByName( const char* name, mico_dns_callback_t callback, void* arg )
+{
+  OSStatus err = kNoErr;
+  dns_cache_state_t state;
+  bool refresh = false;
+  char addr[maxIpLen];
+
+  require_action(name && name[0] != 0x0 && strlen(name) < DNS_CACHE_NAME_LEN, exit, err = kParamErr);
+  require_action(_dnsCacheStarted == true, exit, err = kNotInitializedErr);
+
+  state = _DNSCacheLookup(name, addr, maxIpLen, &refresh);
+  if(refresh == true && _DNSCacheQueue(name, NULL, NULL) != kNoErr)
+    _DNSCacheExpire(name, false);
+
+  switch(state){
+    case DNSCacheFresh:
+    case DNSCacheStale:
+      if(callback != NULL)
+        callback(kNoErr, name, addr, arg);
+      break;
+    case DNSCacheFailed:
+      if(callback != NULL)
+        callback(kNotFoundErr, name, "", arg);
+      break;
+    default:
+      err = _DNSCacheQueue(name, callback, arg);
+      require_noerr_action(err, exit, err = kNoResourcesErr);
+      break;
+  }
+
+exit:
+  return err;
+}
+
+static void _DNSWaitCallback( OSStatus err, const char* name, const char* addr, void* arg )
+{
+  dns_wait_t *wait = arg;
+  (void)name;
+
+  wait->err = err;
+  strncpy(wait->addr, addr, maxIpLen-1);
+  wait->addr[maxIpLen-1] = 0x0;
+  mico_rtos_set_semaphore(&wait->done);
+}
+
+OSStatus MICOGetHostByName( const char* name, char* addr, uint8_t addrLen )
+{
+  OSStatus err = kNoErr;
+  dns_wait_t wait;
+
+  memset(&wait, 0x0, sizeof(dns_wait_t));
+  require_action(name && addr && addrLen, exit, err = kParamErr);
+
+  /* Not started, or a name too long for the cache */
+  if(_dnsCacheStarted == false || strlen(name) >= DNS_CACHE_NAME_LEN)
+    return gethostbyname(name, (uint8_t *)addr, addrLen);
+
+  err = mico_rtos_init_semaphore(&wait.done, 1);
+  require_noerr(err, exit);
+
+  err = MICOResolveHostByName(name, _DNSWaitCallback, &wait);
+  if(err == kNoResourcesErr){
+    /* Too many requests, resolve here */
+    err = gethostbyname(name, (uint8_t *)wait.addr, maxIpLen);
+    _DNSCacheUpdate(name, err, wait.addr);
+    wait.err = err;
+  }else if(err == kNoErr){
+    mico_rtos_get_semaphore(&wait.done, MICO_WAIT_FOREVER);
+  }
+  require_noerr(err, exit);
+
+  err = wait.err;
+  require_noerr_quiet(err, exit);
+  strncpy(addr, wait.addr, addrLen);
+  addr[addrLen-1] = 0x0;
+
+exit:
+  if(wait.done) mico_rtos_deinit_semaphore(&wait.done);
+  return err;
+}
+
+void MICOExpireHostByName( const char* name )
+{
+  if(_dnsCacheStarted == false || name == NULL)
+    return;
+
+  _DNSCacheExpire(name, true);
+}
+
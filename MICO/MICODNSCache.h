@@ -0,0 +1,77 @@
+/**
+******************************************************************************
+* @file    MICODNSCache.h 
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   Host name cache, resolve names on a thread of its own and keep the
+*          addresses for reconnects and the next boot.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#ifndef __MICODNSCACHE_H__
+#define __MICODNSCACHE_H__
+
+#include "Common.h"
+#include "MICODefine.h"
+
+/* gethostbyname() does not report the TTL of an answer, addresses are kept for
+   DNS_CACHE_TTL. An expired address is still returned for DNS_CACHE_STALE_TIME while
+   a new one is resolved in the background, and when resolving fails. Addresses saved
+   in flash by the last boot start out expired, so the first connect needs no lookup.
+   They are kept in the MICO_FLASH_FOR_DNS_CACHE partition, on boards that define one. */
+
+#ifndef DNS_CACHE_SIZE
+#define DNS_CACHE_SIZE              (8)
+#endif
+#ifndef DNS_CACHE_SAVED_NUM
+#define DNS_CACHE_SAVED_NUM         (4)              //Names kept in flash
+#endif
+#define DNS_CACHE_TTL               (5*60*1000)      //ms
+#define DNS_CACHE_STALE_TIME        (60*60*1000)     //ms, after DNS_CACHE_TTL
+#define DNS_CACHE_NEGATIVE_TTL      (10*1000)        //ms, a failed name is not resolved again in this time
+#define DNS_CACHE_SAVE_INTERVAL     (24*60*60*1000)  //ms, least time between two flash writes
+
+/* err is kNoErr and addr holds the IPv4 address in dotted-decimal, or err tells why
+   the name has no address and addr is an empty string */
+typedef void (*mico_dns_callback_t)( OSStatus err, const char* name, const char* addr, void* arg );
+
+
+OSStatus MICOStartDNSCache( mico_Context_t * const inContext );
+
+/* Same as gethostbyname(), served from the cache when possible. Blocks only when
+   there is no usable address for name */
+OSStatus MICOGetHostByName( const char* name, char* addr, uint8_t addrLen );
+
+/* Resolve without blocking. callback is called at once from the calling thread on a
+   cache hit, otherwise from the resolver thread */
+OSStatus MICOResolveHostByName( const char* name, mico_dns_callback_t callback, void* arg );
+
+/* The address of name did not work, resolve it again on the next lookup. Only then
+   is the address saved in flash replaced */
+void MICOExpireHostByName( const char* name );
+
+
+#endif //__MICODNSCACHE_H__
+
@@ -58,13 +58,17 @@
 #ifdef DEBUG
   #define STACK_SIZE_LOCAL_CONFIG_SERVER_THREAD   0x300
   #define STACK_SIZE_LOCAL_CONFIG_CLIENT_THREAD   0x420
-  #define STACK_SIZE_NTP_CLIENT_THREAD            0x400
+  #define STACK_SIZE_NTP_CLIENT_THREAD            0x500
   #define STACK_SIZE_MICO_SYSTEM_MONITOR_THREAD   0x300
+  #define STACK_SIZE_MICO_CRYPTO_WORKER_THREAD    0x1000
+  #define STACK_SIZE_DNS_RESOLVER_THREAD          0x400
 #else
   #define STACK_SIZE_LOCAL_CONFIG_SERVER_THREAD   0x180
   #define STACK_SIZE_LOCAL_CONFIG_CLIENT_THREAD   0x3C0
-  #define STACK_SIZE_NTP_CLIENT_THREAD            0x3A0
+  #define STACK_SIZE_NTP_CLIENT_THREAD            0x440
   #define STACK_SIZE_MICO_SYSTEM_MONITOR_THREAD   0x120
+  #define STACK_SIZE_MICO_CRYPTO_WORKER_THREAD    0x1000
+  #define STACK_SIZE_DNS_RESOLVER_THREAD          0x300
 #endif
 
 #define CONFIG_SERVICE_PORT     8000
@@ -154,6 +158,8 @@ typedef struct _mico_sys_config_t
   int32_t         seed;
 } mico_sys_config_t;
 
+#define DNS_CACHE_NAME_LEN  64
+
 typedef struct _flash_configuration_t {
 
   /*OTA options*/
@@ -192,6 +198,8 @@ typedef struct _mico_Context_t
 OSStatus MICOStartBonjourService        ( WiFi_Interface interface, mico_Context_t * const inContext );
 OSStatus MICOStartConfigServer          ( mico_Context_t * const inContext );
 OSStatus MICOStartNTPClient             ( mico_Context_t * const inContext );
+OSStatus MICOGetNTPTime                 ( struct timeval_t *utc ); //UTC kept by the NTP client, kNotPreparedErr before its first poll
+OSStatus MICOStartDNSCache              ( mico_Context_t * const inContext );
 OSStatus MICOStartApplication           ( mico_Context_t * const inContext );
 
 OSStatus MICORestoreDefault             ( mico_Context_t * const inContext );
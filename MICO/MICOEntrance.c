@@ -37,7 +37,7 @@
 
 #include "MICONotificationCenter.h"
 #include "MICOSystemMonitor.h"
-#include "MicoCli.h"
+#include "MICOCli.h"
 #include "EasyLink/EasyLink.h"
 #include "SoftAP/EasyLinkSoftAP.h"
 #include "WPS/WPS.h"
@@ -430,6 +430,9 @@ int application_start(void)
       require_noerr_action( err, exit, mico_log("ERROR: Unable to start the local server thread.") );
     }
 
+    err =  MICOStartDNSCache(context);
+    require_noerr_action( err, exit, mico_log("ERROR: Unable to start the DNS cache.") );
+
     err =  MICOStartNTPClient(context);
     require_noerr_action( err, exit, mico_log("ERROR: Unable to start the NTP client thread.") );
 
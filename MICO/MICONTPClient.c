@@ -1,18 +1,19 @@
 /**
 ******************************************************************************
-* @file    MICONTPClient.c 
+* @file    MICONTPClient.c
 * @author  William Xu
 * @version V1.0.0
 * @date    05-May-2014
-* @brief   Create a NTP client thread, and synchronize RTC with NTP server.
+* @brief   Create a SNTPv4 client thread, keep a clock disciplined to a NTP
+*          server and synchronize RTC with it.
 ******************************************************************************
 *
 *  The MIT License
 *  Copyright (c) 2014 MXCHIP Inc.
 *
-*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
 *  of this software and associated documentation files (the "Software"), to deal
-*  in the Software without restriction, including without limitation the rights 
+*  in the Software without restriction, including without limitation the rights
 *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
 *  copies of the Software, and to permit persons to whom the Software is furnished
 *  to do so, subject to the following conditions:
@@ -20,11 +21,11 @@
 *  The above copyright notice and this permission notice shall be included in
 *  all copies or substantial portions of the Software.
 *
-*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
-*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
-*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
 *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
-*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
 *  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 ******************************************************************************
 */
@@ -33,45 +34,110 @@
 #include "MICODefine.h"
 #include "SocketUtils.h"
 #include "MICONotificationCenter.h"
-#include "time.h"
+#include "MICODNSCache.h"
 #include "MicoPlatform.h"
+#include "math.h"
 
 #define ntp_log(M, ...) custom_log("NTP client", M, ##__VA_ARGS__)
 #define ntp_log_trace() custom_log_trace("NTP client")
 
+/* The clock is kept in milliseconds since 1970 in UTC. Every poll sends a burst
+   of requests and keeps the answer with the shortest round trip, the one least
+   hurt by queuing in the network. Its offset corrects the clock, and the offset
+   divided by the time since the last poll is the frequency error of the tick
+   left over, which is averaged by a Kalman filter: short polls with a lot of
+   jitter move the estimate little, long ones more. The poll interval doubles
+   while the offsets stay well within NTP_ACCURACY, so a settled device polls a
+   few times a day. The RTC is measured against the clock, set when it is too
+   far off and trimmed with the drift it shows over several hours. */
 
-#define UNIX_OFFSET 		         2208960000U
+#define UNIX_OFFSET              2208988800U  //NTP seconds at 1970
 #define NTP_Server               "time.asia.apple.com"
 #define NTP_Port                 123
-#define NTP_Flags                0xdb 
-#define NTP_Stratum              0x0
-#define NTP_Poll                 0x0a
-#define NTP_Precision            0xfa
-#define NTP_Root_Delay           0x8000
-#define NTP_Root_Dispersion      0xa00b0000
+#define NTP_LocalPort            45000
+#define NTP_VersionMode          0x23         //LI 0, version 4, client
+#define NTP_ModeServer           4
+#define NTP_LeapAlarm            3
+
+#ifndef NTP_RTC_TIMEZONE
+#define NTP_RTC_TIMEZONE         (8*3600)     //The RTC keeps local time, UTC+8
+#endif
+
+#ifndef NTP_MIN_POLL
+#define NTP_MIN_POLL             6            //log2 seconds, 64s
+#endif
+#ifndef NTP_MAX_POLL
+#define NTP_MAX_POLL             17           //log2 seconds, 36.4h
+#endif
+#define NTP_STABLE_POLLS         2            //Polls within NTP_ACCURACY/4 before the interval doubles
+#ifndef NTP_ACCURACY
+#define NTP_ACCURACY             100          //ms, the clock is allowed to be this far off between polls
+#endif
+#define NTP_BURST                4            //Requests a poll
+#define NTP_BURST_SPACING        2000         //ms
+#define NTP_REQUEST_TIMEOUT      1000         //ms
+#define NTP_RETRY_DELAY          16           //seconds after a failed poll, doubled up to the poll interval
+#define NTP_MIN_JITTER           2            //ms, below the resolution of the tick
+
+#define NTP_MAX_DRIFT            500000       //ppb, the crystals are not worse than this
+#define NTP_INITIAL_DRIFT_SD     50000.0f     //ppb, uncertainty of the frequency before any poll
+#define NTP_DRIFT_WANDER         4.0f         //ppb^2 a second, how fast the frequency may change
+#define NTP_OUTLIER_SD           5.0f         //An offset further than this many sd from the prediction is a spike
+#define NTP_MAX_OUTLIERS         2            //In a row, then the frequency estimate is started again
+
+#define NTP_RTC_MAX_ERROR        500          //ms, the RTC is set again when it is further off
+#define NTP_RTC_MIN_SPAN         (4*3600)     //seconds of RTC error needed to trim its drift
+#define NTP_RTC_EDGE_STEP        5            //ms, resolution of the search for the RTC second
+
+typedef struct _ntp_packet_t {
+  uint8_t   li_vn_mode;
+  uint8_t   stratum;
+  uint8_t   poll;
+  int8_t    precision;
+  uint32_t  root_delay;
+  uint32_t  root_dispersion;
+  uint32_t  reference_id;
+  uint32_t  reference_ts[2];
+  uint32_t  origin_ts[2];
+  uint32_t  receive_ts[2];
+  uint32_t  transmit_ts[2];
+} ntp_packet_t;   //48 bytes, big endian on the wire
+
+typedef struct _ntp_sample_t {
+  int64_t   offset;         //ms, server time minus clock
+  int32_t   delay;          //ms, round trip without the time spent in the server
+} ntp_sample_t;
+
+typedef struct _ntp_clock_t {
+  bool      valid;          //Set by the first poll
+  int64_t   base;           //ms since 1970 at baseTick
+  uint32_t  baseTick;       //mico_get_time()
+  int32_t   freq;           //ppb added to the tick, positive when the tick runs slow
+  float     freqVar;        //ppb^2, variance of freq
+  uint32_t  lastUpdate;     //mico_get_time() of the last poll that corrected the clock
+  int32_t   jitter;         //ms
+  uint8_t   poll;           //log2 seconds
+  uint8_t   stable;
+  uint8_t   outliers;
+} ntp_clock_t;
+
+typedef struct _ntp_rtc_t {
+  bool      noRtc;          //MicoRtcSetTime is not supported
+  bool      noRead;         //MicoRtcGetTime failed, the RTC can only be set
+  bool      noTrim;         //MicoRtcSetDrift failed
+  bool      anchored;
+  int64_t   anchorTime;     //Clock time of the RTC error the drift is measured from
+  int32_t   anchorError;    //ms, RTC minus clock
+  int32_t   drift;          //ppb, trim given to MicoRtcSetDrift
+} ntp_rtc_t;
 
 static volatile bool _wifiConnected = false;
 static mico_semaphore_t  _wifiConnected_sem = NULL;
+static mico_mutex_t _clock_mutex = NULL;
+static ntp_clock_t _clock;
+static ntp_rtc_t _rtc;
 
-
-struct NtpPacket
-{
-	uint8_t flags;
-	uint8_t stratum;
-	uint8_t poll;
-	uint8_t precision;
-	uint32_t root_delay;
-	uint32_t root_dispersion;
-	uint8_t referenceID;
-	uint32_t ref_ts_sec;
-	uint32_t ref_ts_frac;
-	uint32_t origin_ts_sec;
-	uint32_t origin_ts_frac;
-	uint32_t recv_ts_sec;
-	uint32_t recv_ts_frac;
-	uint32_t trans_ts_sec;
-	uint32_t trans_ts_frac;
-};
+static const uint8_t _daysInMonth[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
 void ntpNotify_WifiStatusHandler(int event, mico_Context_t * const inContext)
 {
@@ -84,6 +150,7 @@ void ntpNotify_WifiStatusHandler(int event, mico_Context_t * const inContext)
       mico_rtos_set_semaphore(&_wifiConnected_sem);
     break;
   case NOTIFY_STATION_DOWN:
+    _wifiConnected = false;
     break;
   default:
     break;
@@ -91,95 +158,428 @@ void ntpNotify_WifiStatusHandler(int event, mico_Context_t * const inContext)
   return;
 }
 
+/* Clock time of tick, _clock_mutex held */
+static int64_t ntp_clock_at(uint32_t tick)
+{
+  uint32_t elapsed = tick - _clock.baseTick;
+  return _clock.base + elapsed + (int64_t)elapsed * _clock.freq / 1000000000;
+}
+
+static int64_t ntp_clock_now(void)
+{
+  int64_t now;
+  mico_rtos_lock_mutex(&_clock_mutex);
+  now = ntp_clock_at(mico_get_time());
+  mico_rtos_unlock_mutex(&_clock_mutex);
+  return now;
+}
+
+/* Moves the base to now, so the tick never wraps past it, and adds offset */
+static void ntp_clock_adjust(int64_t offset)
+{
+  uint32_t tick;
+  mico_rtos_lock_mutex(&_clock_mutex);
+  tick = mico_get_time();
+  _clock.base = ntp_clock_at(tick) + offset;
+  _clock.baseTick = tick;
+  mico_rtos_unlock_mutex(&_clock_mutex);
+}
+
+static int64_t ntp_ts_to_ms(const uint32_t ts[2])
+{
+  uint32_t sec = ntohl(ts[0]);
+  int64_t s = (int64_t)sec - UNIX_OFFSET;
+  if (!(sec & 0x80000000))
+    s += 0x100000000LL;   //Era 1, after 2036
+  return s * 1000 + (((uint64_t)ntohl(ts[1]) * 1000) >> 32);
+}
+
+static void ntp_ms_to_ts(int64_t ms, uint32_t ts[2])
+{
+  ts[0] = htonl((uint32_t)(ms / 1000 + UNIX_OFFSET));
+  ts[1] = htonl((uint32_t)(((uint64_t)(ms % 1000) << 32) / 1000));
+}
+
+/* Seconds since 1970 to the RTC calendar, years 2000 to 2099 */
+static void ntp_seconds_to_rtc(uint32_t seconds, mico_rtc_time_t *time)
+{
+  uint32_t days = seconds / 86400;
+  uint32_t year = 1970, month = 0, len;
+
+  time->sec = seconds % 60;
+  time->min = (seconds / 60) % 60;
+  time->hr = (seconds / 3600) % 24;
+  time->weekday = (days + 3) % 7 + 1;   //1970-01-01 is a Thursday, Monday is 1
+  while (days >= (len = (year % 4) ? 365 : 366)) {
+    days -= len;
+    year++;
+  }
+  while (days >= (len = _daysInMonth[month] + ((month == 1 && !(year % 4)) ? 1 : 0))) {
+    days -= len;
+    month++;
+  }
+  time->date = days + 1;
+  time->month = month + 1;
+  time->year = year % 100;
+}
+
+static uint32_t ntp_rtc_to_seconds(const mico_rtc_time_t *time)
+{
+  uint32_t year = 2000 + time->year;
+  uint32_t days = (year - 1970) * 365 + (year - 1969) / 4;
+  uint32_t month;
+
+  for (month = 1; month < time->month; month++)
+    days += _daysInMonth[month - 1] + ((month == 2 && !(year % 4)) ? 1 : 0);
+  days += time->date - 1;
+  return ((days * 24 + time->hr) * 60 + time->min) * 60 + time->sec;
+}
+
+/* Sends one request and waits for its answer. Answers to earlier requests, or
+   from another host, are skipped. */
+static OSStatus ntp_query(int fd, struct sockaddr_t *server, ntp_sample_t *sample)
+{
+  OSStatus err = kNoErr;
+  ntp_packet_t packet;
+  uint32_t xmit[2];
+  uint32_t sent, waited;
+  int64_t t1, t2, t3, t4;
+  fd_set readfds;
+  struct timeval_t t;
+  struct sockaddr_t from;
+  socklen_t fromLen;
+  int len;
+
+  memset(&packet, 0x0, sizeof(packet));
+  packet.li_vn_mode = NTP_VersionMode;
+  packet.poll = _clock.poll;
+
+  mico_rtos_lock_mutex(&_clock_mutex);
+  sent = mico_get_time();
+  t1 = ntp_clock_at(sent);
+  mico_rtos_unlock_mutex(&_clock_mutex);
+  ntp_ms_to_ts(t1, xmit);
+  xmit[1] ^= htonl(sent & 0xFFF);   //Below the ms, tells this request from the last one
+  packet.transmit_ts[0] = xmit[0];
+  packet.transmit_ts[1] = xmit[1];
+
+  require_action(sendto(fd, &packet, sizeof(packet), 0, server, sizeof(struct sockaddr_t)) == sizeof(packet), exit, err = kNotWritableErr);
+
+  while (1) {
+    waited = mico_get_time() - sent;
+    require_action_quiet(waited < NTP_REQUEST_TIMEOUT, exit, err = kTimeoutErr);
+    t.tv_sec = (NTP_REQUEST_TIMEOUT - waited) / 1000;
+    t.tv_usec = ((NTP_REQUEST_TIMEOUT - waited) % 1000) * 1000;
+
+    FD_ZERO(&readfds);
+    FD_SET(fd, &readfds);
+    select(fd + 1, &readfds, NULL, NULL, &t);
+    if (!FD_ISSET(fd, &readfds))
+      continue;
+
+    fromLen = sizeof(from);
+    len = recvfrom(fd, &packet, sizeof(packet), 0, &from, &fromLen);
+    t4 = ntp_clock_now();
+    require_action(len >= 0, exit, err = kNotReadableErr);
+    if ((size_t)len < sizeof(packet) || from.s_ip != server->s_ip)
+      continue;
+    if (packet.origin_ts[0] != xmit[0] || packet.origin_ts[1] != xmit[1])
+      continue;
+    break;
+  }
+
+  if (packet.stratum == 0) {
+    /* Kiss-o'-death, the code is in reference_id */
+    ntp_log("Kiss code %.4s", (char *)&packet.reference_id);
+    if (!memcmp(&packet.reference_id, "RATE", 4) && _clock.poll < NTP_MAX_POLL)
+      _clock.poll++;
+    err = kResponseErr;
+    goto exit;
+  }
+  require_action((packet.li_vn_mode & 0x7) == NTP_ModeServer && (packet.li_vn_mode >> 6) != NTP_LeapAlarm
+                 && packet.stratum < 16 && (packet.transmit_ts[0] || packet.transmit_ts[1]), exit, err = kResponseErr);
+
+  t2 = ntp_ts_to_ms(packet.receive_ts);
+  t3 = ntp_ts_to_ms(packet.transmit_ts);
+  sample->offset = ((t2 - t1) + (t3 - t4)) / 2;
+  sample->delay = (int32_t)((t4 - t1) - (t3 - t2));
+  if (sample->delay < 0)
+    sample->delay = 0;
+
+exit:
+  return err;
+}
+
+/* Queries the server NTP_BURST times and keeps the sample with the shortest
+   round trip. jitter is the rms distance of the other offsets to it. */
+static OSStatus ntp_burst(int fd, struct sockaddr_t *server, ntp_sample_t *best, int32_t *jitter)
+{
+  ntp_sample_t samples[NTP_BURST];
+  int64_t diff;
+  uint32_t sum = 0;
+  int i, num = 0, bestIdx = 0;
+
+  for (i = 0; i < NTP_BURST; i++) {
+    if (i > 0)
+      mico_thread_msleep(NTP_BURST_SPACING);
+    if (ntp_query(fd, server, &samples[num]) != kNoErr)
+      continue;
+    if (samples[num].delay < samples[bestIdx].delay)
+      bestIdx = num;
+    num++;
+  }
+  if (num == 0)
+    return kTimeoutErr;
+
+  *best = samples[bestIdx];
+  *jitter = _clock.jitter;
+  if (num > 1) {
+    for (i = 0; i < num; i++) {
+      diff = samples[i].offset - best->offset;
+      if (diff > 10000 || diff < -10000)
+        diff = 10000;
+      sum += (uint32_t)(diff * diff);
+    }
+    *jitter = (int32_t)sqrtf((float)sum / (num - 1));
+  }
+  if (*jitter < NTP_MIN_JITTER)
+    *jitter = NTP_MIN_JITTER;
+  return kNoErr;
+}
+
+/* Corrects the clock with the offset of a poll, estimates the frequency error
+   left and picks the next poll interval */
+static void ntp_clock_update(const ntp_sample_t *sample, int32_t jitter)
+{
+  uint32_t tick = mico_get_time();
+  float interval, residual, residualVar, innovation, gain;
+  int32_t offset;
+
+  if (!_clock.valid || sample->offset > 3600*1000 || sample->offset < -3600*1000) {
+    /* First poll, or a clock far off: set it */
+    ntp_clock_adjust(sample->offset);
+    _clock.valid = true;
+    _clock.lastUpdate = tick;
+    _clock.jitter = jitter;
+    _clock.stable = 0;
+    _clock.outliers = 0;
+    _clock.poll = NTP_MIN_POLL;
+    ntp_log("Time synchronized, stepped by %d s", (int)(sample->offset / 1000));
+    return;
+  }
+
+  offset = (int32_t)sample->offset;
+  interval = (float)(tick - _clock.lastUpdate);   //ms
+
+  /* Frequency error left since the last update, in ppb, with the variance the
+     jitter at both ends gives it. The frequency estimate is predicted to have
+     wandered during the interval. */
+  residual = (float)offset * 1e9f / interval;
+  residualVar = 2.0f * (float)_clock.jitter * (float)_clock.jitter * 1e18f / (interval * interval);
+  _clock.freqVar += NTP_DRIFT_WANDER * interval / 1000.0f;
+  innovation = residual * residual / (_clock.freqVar + residualVar);
+
+  if (innovation > NTP_OUTLIER_SD * NTP_OUTLIER_SD) {
+    if (++_clock.outliers <= NTP_MAX_OUTLIERS) {
+      /* A spike, or the frequency has changed. The clock is left alone and
+         polled again after NTP_MIN_POLL to tell. */
+      ntp_log("Spike, offset %d ms", offset);
+      return;
+    }
+    /* Not a spike, the frequency has changed: estimate it again */
+    _clock.freqVar = NTP_INITIAL_DRIFT_SD * NTP_INITIAL_DRIFT_SD;
+  }
+  _clock.outliers = 0;
+  _clock.jitter = (jitter + 3 * _clock.jitter) / 4;
+
+  gain = _clock.freqVar / (_clock.freqVar + residualVar);
+  _clock.freqVar *= 1.0f - gain;
+
+  mico_rtos_lock_mutex(&_clock_mutex);
+  _clock.base = ntp_clock_at(tick) + offset;
+  _clock.baseTick = tick;
+  _clock.freq += (int32_t)(gain * residual);
+  if (_clock.freq > NTP_MAX_DRIFT)
+    _clock.freq = NTP_MAX_DRIFT;
+  else if (_clock.freq < -NTP_MAX_DRIFT)
+    _clock.freq = -NTP_MAX_DRIFT;
+  mico_rtos_unlock_mutex(&_clock_mutex);
+  _clock.lastUpdate = tick;
+
+  /* Poll less often while the offsets are small and the frequency, with the
+     wander expected meanwhile, is known well enough to stay within
+     NTP_ACCURACY/4 over twice the interval */
+  if (offset > NTP_ACCURACY / 2 || offset < -NTP_ACCURACY / 2) {
+    _clock.stable = 0;
+    if (_clock.poll > NTP_MIN_POLL)
+      _clock.poll--;
+  } else if (offset < NTP_ACCURACY / 4 && offset > -NTP_ACCURACY / 4
+             && sqrtf(_clock.freqVar + NTP_DRIFT_WANDER * (float)(2UL << _clock.poll)) * (float)(2UL << _clock.poll) / 1e6f < NTP_ACCURACY / 4) {
+    if (++_clock.stable >= NTP_STABLE_POLLS && _clock.poll < NTP_MAX_POLL) {
+      _clock.poll++;
+      _clock.stable = 0;
+    }
+  }
+
+  ntp_log("Offset %d ms, delay %d ms, jitter %d ms, freq %d ppb (sd %d), poll %lu s", offset, (int)sample->delay,
+          (int)_clock.jitter, (int)_clock.freq, (int)sqrtf(_clock.freqVar), 1UL << _clock.poll);
+}
+
+/* Error of the RTC against the clock in ms. The RTC only counts seconds, so it
+   is read until its second changes: the clock is then at the start of it. */
+static OSStatus ntp_rtc_error(int32_t *error, int64_t *when)
+{
+  OSStatus err;
+  mico_rtc_time_t time;
+  uint32_t first, seconds, waited;
+
+  err = MicoRtcGetTime(&time);
+  require_noerr_quiet(err, exit);
+  first = ntp_rtc_to_seconds(&time);
+
+  for (waited = 0; waited <= 1000 + NTP_RTC_EDGE_STEP; waited += NTP_RTC_EDGE_STEP) {
+    mico_thread_msleep(NTP_RTC_EDGE_STEP);
+    err = MicoRtcGetTime(&time);
+    require_noerr_quiet(err, exit);
+    seconds = ntp_rtc_to_seconds(&time);
+    if (seconds != first) {
+      /* The second changed in the last NTP_RTC_EDGE_STEP */
+      *when = ntp_clock_now() - NTP_RTC_EDGE_STEP / 2;
+      *error = (int32_t)((int64_t)seconds * 1000 - (*when + NTP_RTC_TIMEZONE * 1000LL));
+      return kNoErr;
+    }
+  }
+  err = kTimeoutErr;
+
+exit:
+  return err;
+}
+
+/* Sets the RTC when the clock starts a new second */
+static void ntp_rtc_set(void)
+{
+  mico_rtc_time_t time;
+  int64_t now = ntp_clock_now();
+
+  mico_thread_msleep(1000 - (uint32_t)(now % 1000));
+  ntp_seconds_to_rtc((uint32_t)((now / 1000) + 1 + NTP_RTC_TIMEZONE), &time);
+  if (MicoRtcSetTime(&time) == kUnsupportedErr)
+    _rtc.noRtc = true;
+  _rtc.anchored = false;
+}
+
+/* Keeps the RTC within NTP_RTC_MAX_ERROR of the clock and trims the drift it
+   shows over NTP_RTC_MIN_SPAN or more */
+static void ntp_rtc_update(void)
+{
+  OSStatus err;
+  int32_t error, drift;
+  int64_t now;
+
+  if (_rtc.noRtc)
+    return;
+  err = _rtc.noRead ? kUnsupportedErr : ntp_rtc_error(&error, &now);
+  if (err != kNoErr) {
+    /* A RTC that does not count is set again, and measured next time */
+    if (err != kTimeoutErr)
+      _rtc.noRead = true;
+    ntp_rtc_set();
+    return;
+  }
+
+  if (error > NTP_RTC_MAX_ERROR || error < -NTP_RTC_MAX_ERROR) {
+    ntp_log("RTC off by %d ms, set", (int)error);
+    ntp_rtc_set();
+    return;
+  }
+
+  if (!_rtc.anchored) {
+    _rtc.anchored = true;
+    _rtc.anchorTime = now;
+    _rtc.anchorError = error;
+    return;
+  }
+  if (_rtc.noTrim || now - _rtc.anchorTime < NTP_RTC_MIN_SPAN * 1000LL)
+    return;
+
+  drift = _rtc.drift + (int32_t)((int64_t)(error - _rtc.anchorError) * 1000000000 / (now - _rtc.anchorTime));
+  if (drift > NTP_MAX_DRIFT)
+    drift = NTP_MAX_DRIFT;
+  else if (drift < -NTP_MAX_DRIFT)
+    drift = -NTP_MAX_DRIFT;
+  if (MicoRtcSetDrift(drift) != kNoErr) {
+    _rtc.noTrim = true;
+    return;
+  }
+  ntp_log("RTC drift %d ppb", (int)drift);
+  _rtc.drift = drift;
+  _rtc.anchorTime = now;
+  _rtc.anchorError = error;
+}
+
 void NTPClient_thread(void *inContext)
 {
   ntp_log_trace();
   OSStatus err = kUnknownErr;
   (void)inContext;
-  
+
   int  Ntp_fd = -1;
-  fd_set readfds;
-  struct timeval_t t ;
   struct sockaddr_t addr;
-  socklen_t addrLen;	
   char ipstr[16];
-  unsigned int trans_sec, current;
-  struct NtpPacket outpacket ,inpacket;
-  struct tm *currentTime;
-  mico_rtc_time_t time;
-  
+  ntp_sample_t sample;
+  int32_t jitter;
+  uint32_t delay;
+  uint32_t failures = 0;
+
   /* Regisist notifications */
   err = MICOAddNotification( mico_notify_WIFI_STATUS_CHANGED, (void *)ntpNotify_WifiStatusHandler );
-  require_noerr( err, exit ); 
- 
-  memset(&outpacket,0x0,sizeof(outpacket));
-  memset(&inpacket,0x0,sizeof(inpacket));
-
-  outpacket.flags = NTP_Flags;
-  outpacket.stratum = NTP_Stratum;
-  outpacket.poll = NTP_Poll;
-  outpacket.precision = NTP_Precision;
-  outpacket.root_delay = NTP_Root_Delay;
-  outpacket.root_dispersion = NTP_Root_Dispersion;
-
-  if(_wifiConnected == false)
-    mico_rtos_get_semaphore(&_wifiConnected_sem, MICO_WAIT_FOREVER);
-  
+  require_noerr( err, exit );
+
+  memset(&_clock, 0x0, sizeof(_clock));
+  memset(&_rtc, 0x0, sizeof(_rtc));
+  _clock.freqVar = NTP_INITIAL_DRIFT_SD * NTP_INITIAL_DRIFT_SD;
+  _clock.jitter = NTP_MIN_JITTER;
+  _clock.poll = NTP_MIN_POLL;
+  _clock.baseTick = mico_get_time();
+
   Ntp_fd = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
   require_action(IsValidSocket( Ntp_fd ), exit, err = kNoResourcesErr );
-  addr.s_ip = INADDR_ANY; 
-  addr.s_port = 45000;
-  err = bind(Ntp_fd, &addr, sizeof(addr));
-  err = kNoErr;
-  require_noerr(err, exit);
-
-   while(1) {
-     err = gethostbyname(NTP_Server, (uint8_t *)ipstr, 16);
-     require_noerr(err, ReConnWithDelay);
-     ntp_log("NTP server address: %s",ipstr);
-     break;
-
-   ReConnWithDelay:
-     mico_thread_sleep(5);
-   }
-
-  addr.s_ip = inet_addr(ipstr);
-  addr.s_port = NTP_Port;
-
-  t.tv_sec = 5;
-  t.tv_usec = 0;
-  
+  addr.s_ip = INADDR_ANY;
+  addr.s_port = NTP_LocalPort;
+  bind(Ntp_fd, &addr, sizeof(addr));
+
   while(1) {
-    require_action(sendto(Ntp_fd, &outpacket,sizeof(outpacket), 0, &addr, sizeof(addr)), exit, err = kNotWritableErr);
+    /* Waits at most the longest poll, the clock base has to move before the tick wraps */
+    if(_wifiConnected == false) {
+      mico_rtos_get_semaphore(&_wifiConnected_sem, (1UL << NTP_MAX_POLL) * 1000);
+      ntp_clock_adjust(0);
+      continue;
+    }
 
-    FD_ZERO(&readfds);
-    FD_SET(Ntp_fd, &readfds);
-
-    select(1, &readfds, NULL, NULL, &t);
-    
-    if(FD_ISSET(Ntp_fd, &readfds))
-    {
-      require_action(recvfrom(Ntp_fd, &inpacket, sizeof(struct NtpPacket), 0, &addr, &addrLen)>=0, exit, err = kNotReadableErr);
-
-      trans_sec = inpacket.trans_ts_sec;
-      trans_sec = ntohl(trans_sec);
-      current = trans_sec - UNIX_OFFSET;
-      ntp_log("Time Synchronoused, %s",asctime(localtime(&current)));
-
-      currentTime = localtime(&current);
-      time.sec = currentTime->tm_sec;
-      time.min = currentTime->tm_min ;
-      time.hr = currentTime->tm_hour;
-
-      time.date = currentTime->tm_mday;
-      time.weekday = currentTime->tm_wday;
-      time.month = currentTime->tm_mon + 1;
-      time.year = (currentTime->tm_year + 1900)%100;
-
-      MicoRtcSetTime( &time );
-      goto exit;
+    err = MICOGetHostByName(NTP_Server, ipstr, 16);
+    if (err == kNoErr) {
+      addr.s_ip = inet_addr(ipstr);
+      addr.s_port = NTP_Port;
+      err = ntp_burst(Ntp_fd, &addr, &sample, &jitter);
+    }
+
+    if (err == kNoErr) {
+      failures = 0;
+      ntp_clock_update(&sample, jitter);
+      ntp_rtc_update();
+      delay = 1UL << (_clock.outliers ? NTP_MIN_POLL : _clock.poll);
+    } else {
+      ntp_log("Poll failed, err = %d", err);
+      failures++;
+      delay = NTP_RETRY_DELAY << ((failures < 8) ? failures - 1 : 7);
+      if (delay > (1UL << _clock.poll))
+        delay = 1UL << _clock.poll;
     }
+
+    mico_thread_sleep(delay);
+    ntp_clock_adjust(0);
   }
+
 exit:
     if( err!=kNoErr )ntp_log("Exit: NTP client exit with err = %d", err);
     MICORemoveNotification( mico_notify_WIFI_STATUS_CHANGED, (void *)ntpNotify_WifiStatusHandler );
@@ -189,9 +589,21 @@ exit:
     return;
 }
 
+OSStatus MICOGetNTPTime( struct timeval_t *utc )
+{
+  int64_t now;
+
+  if (_clock_mutex == NULL || !_clock.valid)
+    return kNotPreparedErr;
+  now = ntp_clock_now();
+  utc->tv_sec = (unsigned long)(now / 1000);
+  utc->tv_usec = (unsigned long)(now % 1000) * 1000;
+  return kNoErr;
+}
+
 OSStatus MICOStartNTPClient ( mico_Context_t * const inContext )
 {
   mico_rtos_init_semaphore(&_wifiConnected_sem, 1);
+  mico_rtos_init_mutex(&_clock_mutex);
   return mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "NTP Client", NTPClient_thread, STACK_SIZE_NTP_CLIENT_THREAD, (void*)inContext );
 }
-
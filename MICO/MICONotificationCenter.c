@@ -33,7 +33,7 @@
 
 #include "MICONotificationCenter.h"
 #include "Common.h"
-#include "Mico.h"
+#include "MICO.h"
 
 typedef struct _Notify_list{
   void  *function;
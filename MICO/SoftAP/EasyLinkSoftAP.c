@@ -39,6 +39,7 @@
 #include "HTTPUtils.h"
 #include "SocketUtils.h"
 #include "MDNSUtils.h"
+#include "JSON-C/json_writer.h"
 
 #include "EasyLinkSoftAP.h"
   
@@ -57,7 +58,7 @@
 static int _bonjourStarted = false;
 
 extern OSStatus     ConfigIncommingJsonMessage    ( const char *input, mico_Context_t * const inContext );
-extern json_object* ConfigCreateReportJsonMessage ( mico_Context_t * const inContext );
+extern OSStatus     ConfigCreateReportJsonMessage ( struct json_writer *writer, mico_Context_t * const inContext );
 extern void         ConfigWillStart               ( mico_Context_t * const inContext );
 extern void         ConfigWillStop                ( mico_Context_t * const inContext );
 extern void         ConfigEasyLinkIsSuccess       ( mico_Context_t * const inContext );
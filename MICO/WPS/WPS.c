@@ -38,7 +38,7 @@
 #include "HTTPUtils.h"
 
 #include "WPS.h"
-#include "SoftAp/EasyLinkSoftAP.h"
+#include "SoftAP/EasyLinkSoftAP.h"
 
 #define wps_log(M, ...) custom_log("WPS", M, ##__VA_ARGS__)
 #define wps_log_trace() custom_log_trace("WPS")
@@ -107,6 +107,12 @@ OSStatus platform_rtc_set_time( const mico_rtc_time_t* time )
   return kUnsupportedErr;
 }
 
+OSStatus platform_rtc_set_drift( int32_t drift_ppb )
+{
+  UNUSED_PARAMETER(drift_ppb);
+  return kUnsupportedErr;
+}
+
 
 
 
@@ -0,0 +1,774 @@
+/**
+******************************************************************************
+* @file    mico_rtos_linux.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides the MICO RTOS API on POSIX threads.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include "Common.h"
+#include "Debug.h"
+#include "MICORTOS.h"
+#include "platform_peripheral.h"
+#include "platform_host.h"
+
+#define rtos_log(M, ...) custom_log("RTOS", M, ##__VA_ARGS__)
+
+/******************************************************
+*                    Constants
+******************************************************/
+
+/* MICO stack sizes are sized for Cortex-M code, host libc calls need much more */
+#define RTOS_MIN_STACK_SIZE     (256*1024)
+
+/******************************************************
+*                   Enumerations
+******************************************************/
+
+typedef enum
+{
+  RTOS_OBJECT_SEMAPHORE = 1,
+  RTOS_OBJECT_MUTEX,
+  RTOS_OBJECT_QUEUE,
+} rtos_object_type_t;
+
+/******************************************************
+*                    Structures
+******************************************************/
+
+/* Common part of the objects that can be waited on with mico_create_event_fd() */
+typedef struct
+{
+  rtos_object_type_t type;
+  pthread_mutex_t    lock;
+  pthread_cond_t     changed;
+  int                event_fd;         /* Host event fd, -1 if none is attached */
+  bool               event_signalled;
+} rtos_object_t;
+
+typedef struct
+{
+  rtos_object_t      obj;
+  int                count;
+  int                max_count;
+} rtos_semaphore_t;
+
+typedef struct
+{
+  rtos_object_t      obj;
+  pthread_mutex_t    mutex;
+} rtos_mutex_t;
+
+typedef struct
+{
+  rtos_object_t      obj;
+  pthread_cond_t     not_full;
+  uint8_t*           buffer;
+  uint32_t           message_size;
+  uint32_t           number_of_messages;
+  uint32_t           head;
+  uint32_t           count;
+} rtos_queue_t;
+
+typedef struct
+{
+  pthread_t              tid;
+  mico_thread_function_t function;
+  void*                  arg;
+  char                   name[16];
+  pthread_mutex_t        lock;
+  pthread_cond_t         exited;
+  bool                   done;
+  int                    refs;   /* The running thread, and the handle returned to the creator */
+} rtos_thread_t;
+
+typedef struct rtos_timer
+{
+  struct rtos_timer* next;
+  timer_handler_t    function;
+  void*              arg;
+  uint32_t           period_ms;
+  uint64_t           expiry;
+  bool               active;
+  bool               deleted;
+} rtos_timer_t;
+
+/******************************************************
+*               Variables Definitions
+******************************************************/
+
+static uint64_t _boot_time_ms;
+static __thread rtos_thread_t* _current_thread = NULL;
+static pthread_mutex_t _suspend_all_mutex;
+
+static pthread_once_t  _timer_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t _timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  _timer_changed;
+static rtos_timer_t*   _timer_list = NULL;
+static rtos_timer_t*   _timer_running = NULL;
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+static uint64_t _monotonic_ms( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void _deadline( struct timespec* ts, uint64_t expiry_ms )
+{
+  ts->tv_sec = expiry_ms / 1000;
+  ts->tv_nsec = ( expiry_ms % 1000 ) * 1000000;
+}
+
+/* Runs ahead of the platform start up in platform_init.c */
+__attribute__((constructor(101))) static void _rtos_init( void )
+{
+  pthread_mutexattr_t attr;
+
+  _boot_time_ms = _monotonic_ms( );
+  pthread_mutexattr_init( &attr );
+  pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+  pthread_mutex_init( &_suspend_all_mutex, &attr );
+  pthread_mutexattr_destroy( &attr );
+}
+
+static void _object_init( rtos_object_t* obj, rtos_object_type_t type )
+{
+  pthread_condattr_t attr;
+
+  obj->type = type;
+  obj->event_fd = -1;
+  obj->event_signalled = false;
+  pthread_mutex_init( &obj->lock, NULL );
+  pthread_condattr_init( &attr );
+  pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+  pthread_cond_init( &obj->changed, &attr );
+  pthread_condattr_destroy( &attr );
+}
+
+static void _object_deinit( rtos_object_t* obj )
+{
+  pthread_cond_destroy( &obj->changed );
+  pthread_mutex_destroy( &obj->lock );
+}
+
+/* Keep the attached event fd readable exactly while the object can be taken, called with obj->lock held */
+static void _object_update_event( rtos_object_t* obj, bool ready )
+{
+  if ( obj->event_fd < 0 || obj->event_signalled == ready )
+    return;
+  if ( ready )
+    host_event_signal( obj->event_fd );
+  else
+    host_event_clear( obj->event_fd );
+  obj->event_signalled = ready;
+}
+
+static bool _object_ready( rtos_object_t* obj )
+{
+  if ( obj->type == RTOS_OBJECT_SEMAPHORE )
+    return ((rtos_semaphore_t*) obj)->count > 0;
+  if ( obj->type == RTOS_OBJECT_QUEUE )
+    return ((rtos_queue_t*) obj)->count > 0;
+  return false;
+}
+
+/* Wait on cond until it is signalled or the timeout expires, returns ETIMEDOUT on timeout */
+static int _object_wait( rtos_object_t* obj, pthread_cond_t* cond, uint32_t timeout_ms, uint64_t expiry )
+{
+  struct timespec ts;
+
+  if ( timeout_ms == MICO_NEVER_TIMEOUT )
+    return pthread_cond_wait( cond, &obj->lock );
+  if ( timeout_ms == MICO_NO_WAIT )
+    return ETIMEDOUT;
+  _deadline( &ts, expiry );
+  return pthread_cond_timedwait( cond, &obj->lock, &ts );
+}
+
+OSStatus platform_rtos_event_attach( mico_event handle, int event_fd )
+{
+  rtos_object_t* obj = (rtos_object_t*) handle;
+
+  if ( obj == NULL || ( obj->type != RTOS_OBJECT_SEMAPHORE && obj->type != RTOS_OBJECT_QUEUE ) )
+    return kUnsupportedErr;
+
+  pthread_mutex_lock( &obj->lock );
+  if ( obj->event_fd >= 0 ) {
+    pthread_mutex_unlock( &obj->lock );
+    return kAlreadyInUseErr;
+  }
+  obj->event_fd = event_fd;
+  obj->event_signalled = false;
+  _object_update_event( obj, _object_ready( obj ) );
+  pthread_mutex_unlock( &obj->lock );
+  return kNoErr;
+}
+
+void platform_rtos_event_detach( mico_event handle )
+{
+  rtos_object_t* obj = (rtos_object_t*) handle;
+
+  pthread_mutex_lock( &obj->lock );
+  obj->event_fd = -1;
+  pthread_mutex_unlock( &obj->lock );
+}
+
+/*********************** Threads ***********************/
+
+static void _thread_release( rtos_thread_t* t )
+{
+  bool last;
+
+  pthread_mutex_lock( &t->lock );
+  last = ( --t->refs == 0 );
+  pthread_mutex_unlock( &t->lock );
+  if ( last ) {
+    pthread_cond_destroy( &t->exited );
+    pthread_mutex_destroy( &t->lock );
+    free( t );
+  }
+}
+
+static void _thread_cleanup( void* arg )
+{
+  rtos_thread_t* t = arg;
+
+  pthread_mutex_lock( &t->lock );
+  t->done = true;
+  pthread_cond_broadcast( &t->exited );
+  pthread_mutex_unlock( &t->lock );
+  _thread_release( t );
+}
+
+static void* _thread_main( void* arg )
+{
+  rtos_thread_t* t = arg;
+
+  _current_thread = t;
+  pthread_setname_np( pthread_self( ), t->name );
+  pthread_cleanup_push( _thread_cleanup, t );
+  t->function( t->arg );
+  pthread_cleanup_pop( 1 );
+  return NULL;
+}
+
+/* Priorities are not mapped, every thread runs with the default host policy */
+OSStatus mico_rtos_create_thread( mico_thread_t* thread, uint8_t priority, const char* name, mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  rtos_thread_t* t;
+  pthread_attr_t attr;
+  OSStatus err = kNoErr;
+  (void)priority;
+
+  t = calloc( 1, sizeof(rtos_thread_t) );
+  require_action( t, exit, err = kNoMemoryErr );
+
+  t->function = function;
+  t->arg = arg;
+  t->refs = ( thread != NULL ) ? 2 : 1;
+  strncpy( t->name, name ? name : "MICO", sizeof(t->name) - 1 );
+  pthread_mutex_init( &t->lock, NULL );
+  pthread_cond_init( &t->exited, NULL );
+
+  pthread_attr_init( &attr );
+  pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+  pthread_attr_setstacksize( &attr, stack_size > RTOS_MIN_STACK_SIZE ? stack_size : RTOS_MIN_STACK_SIZE );
+  if ( thread != NULL )
+    *thread = t;
+  if ( pthread_create( &t->tid, &attr, _thread_main, t ) != 0 ) {
+    if ( thread != NULL )
+      *thread = NULL;
+    pthread_cond_destroy( &t->exited );
+    pthread_mutex_destroy( &t->lock );
+    free( t );
+    err = kNoResourcesErr;
+  }
+  pthread_attr_destroy( &attr );
+
+exit:
+  return err;
+}
+
+OSStatus mico_rtos_delete_thread( mico_thread_t* thread )
+{
+  rtos_thread_t* t = ( thread != NULL ) ? *thread : NULL;
+
+  if ( t == NULL || t == _current_thread )
+    pthread_exit( NULL );
+
+  pthread_cancel( t->tid );
+  return kNoErr;
+}
+
+void mico_rtos_suspend_thread( mico_thread_t* thread )
+{
+  (void)thread;
+  rtos_log( "Thread suspension is not supported" );
+}
+
+void vTaskSuspendAll( void )
+{
+  pthread_mutex_lock( &_suspend_all_mutex );
+}
+
+long xTaskResumeAll( void )
+{
+  pthread_mutex_unlock( &_suspend_all_mutex );
+  return 0;
+}
+
+OSStatus mico_rtos_thread_join( mico_thread_t* thread )
+{
+  rtos_thread_t* t;
+  OSStatus err = kNoErr;
+
+  require_action( thread && *thread, exit, err = kParamErr );
+  t = *thread;
+
+  pthread_mutex_lock( &t->lock );
+  while ( t->done == false )
+    pthread_cond_wait( &t->exited, &t->lock );
+  pthread_mutex_unlock( &t->lock );
+
+  *thread = NULL;
+  _thread_release( t );
+exit:
+  return err;
+}
+
+OSStatus mico_rtos_thread_force_awake( mico_thread_t* thread )
+{
+  (void)thread;
+  return kUnsupportedErr;
+}
+
+bool mico_rtos_is_current_thread( mico_thread_t* thread )
+{
+  return ( thread != NULL && *thread != NULL && *thread == _current_thread );
+}
+
+void mico_thread_sleep( uint32_t seconds )
+{
+  mico_thread_msleep( seconds * 1000 );
+}
+
+void mico_thread_msleep( uint32_t milliseconds )
+{
+  struct timespec ts;
+
+  ts.tv_sec = milliseconds / 1000;
+  ts.tv_nsec = ( milliseconds % 1000 ) * 1000000;
+  while ( nanosleep( &ts, &ts ) < 0 && errno == EINTR );
+}
+
+/********************* Semaphores **********************/
+
+/* Same as the Cortex-M builds: count is the maximum count and the semaphore starts empty */
+OSStatus mico_rtos_init_semaphore( mico_semaphore_t* semaphore, int count )
+{
+  rtos_semaphore_t* sem = malloc( sizeof(rtos_semaphore_t) );
+  OSStatus err = kNoErr;
+
+  require_action( sem, exit, err = kNoMemoryErr );
+  _object_init( &sem->obj, RTOS_OBJECT_SEMAPHORE );
+  sem->count = 0;
+  sem->max_count = count;
+  *semaphore = sem;
+exit:
+  return err;
+}
+
+OSStatus mico_rtos_set_semaphore( mico_semaphore_t* semaphore )
+{
+  rtos_semaphore_t* sem = *semaphore;
+
+  pthread_mutex_lock( &sem->obj.lock );
+  if ( sem->count < sem->max_count ) {
+    sem->count++;
+    pthread_cond_signal( &sem->obj.changed );
+  }
+  _object_update_event( &sem->obj, true );
+  pthread_mutex_unlock( &sem->obj.lock );
+  return kNoErr;
+}
+
+OSStatus mico_rtos_get_semaphore( mico_semaphore_t* semaphore, uint32_t timeout_ms )
+{
+  rtos_semaphore_t* sem = *semaphore;
+  uint64_t expiry = _monotonic_ms( ) + timeout_ms;
+  OSStatus err = kNoErr;
+
+  pthread_mutex_lock( &sem->obj.lock );
+  while ( sem->count == 0 ) {
+    if ( _object_wait( &sem->obj, &sem->obj.changed, timeout_ms, expiry ) == ETIMEDOUT && sem->count == 0 ) {
+      err = kTimeoutErr;
+      goto exit;
+    }
+  }
+  sem->count--;
+  _object_update_event( &sem->obj, sem->count > 0 );
+
+exit:
+  pthread_mutex_unlock( &sem->obj.lock );
+  return err;
+}
+
+OSStatus mico_rtos_deinit_semaphore( mico_semaphore_t* semaphore )
+{
+  rtos_semaphore_t* sem = *semaphore;
+
+  require( sem, exit );
+  _object_deinit( &sem->obj );
+  free( sem );
+  *semaphore = NULL;
+exit:
+  return kNoErr;
+}
+
+/*********************** Mutexes ***********************/
+
+OSStatus mico_rtos_init_mutex( mico_mutex_t* mutex )
+{
+  rtos_mutex_t* m = malloc( sizeof(rtos_mutex_t) );
+  OSStatus err = kNoErr;
+
+  require_action( m, exit, err = kNoMemoryErr );
+  _object_init( &m->obj, RTOS_OBJECT_MUTEX );
+  pthread_mutex_init( &m->mutex, NULL );
+  *mutex = m;
+exit:
+  return err;
+}
+
+OSStatus mico_rtos_lock_mutex( mico_mutex_t* mutex )
+{
+  rtos_mutex_t* m = *mutex;
+  return pthread_mutex_lock( &m->mutex ) == 0 ? kNoErr : kGeneralErr;
+}
+
+OSStatus mico_rtos_unlock_mutex( mico_mutex_t* mutex )
+{
+  rtos_mutex_t* m = *mutex;
+  return pthread_mutex_unlock( &m->mutex ) == 0 ? kNoErr : kGeneralErr;
+}
+
+OSStatus mico_rtos_deinit_mutex( mico_mutex_t* mutex )
+{
+  rtos_mutex_t* m = *mutex;
+
+  require( m, exit );
+  pthread_mutex_destroy( &m->mutex );
+  _object_deinit( &m->obj );
+  free( m );
+  *mutex = NULL;
+exit:
+  return kNoErr;
+}
+
+/*********************** Queues ************************/
+
+OSStatus mico_rtos_init_queue( mico_queue_t* queue, const char* name, uint32_t message_size, uint32_t number_of_messages )
+{
+  rtos_queue_t* q;
+  pthread_condattr_t attr;
+  OSStatus err = kNoErr;
+  (void)name;
+
+  q = malloc( sizeof(rtos_queue_t) + message_size * number_of_messages );
+  require_action( q, exit, err = kNoMemoryErr );
+
+  _object_init( &q->obj, RTOS_OBJECT_QUEUE );
+  pthread_condattr_init( &attr );
+  pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+  pthread_cond_init( &q->not_full, &attr );
+  pthread_condattr_destroy( &attr );
+  q->buffer = (uint8_t*)( q + 1 );
+  q->message_size = message_size;
+  q->number_of_messages = number_of_messages;
+  q->head = 0;
+  q->count = 0;
+  *queue = q;
+exit:
+  return err;
+}
+
+OSStatus mico_rtos_push_to_queue( mico_queue_t* queue, void* message, uint32_t timeout_ms )
+{
+  rtos_queue_t* q = *queue;
+  uint64_t expiry = _monotonic_ms( ) + timeout_ms;
+  uint32_t tail;
+  OSStatus err = kNoErr;
+
+  pthread_mutex_lock( &q->obj.lock );
+  while ( q->count == q->number_of_messages ) {
+    if ( _object_wait( &q->obj, &q->not_full, timeout_ms, expiry ) == ETIMEDOUT && q->count == q->number_of_messages ) {
+      err = kTimeoutErr;
+      goto exit;
+    }
+  }
+  tail = ( q->head + q->count ) % q->number_of_messages;
+  memcpy( q->buffer + tail * q->message_size, message, q->message_size );
+  q->count++;
+  pthread_cond_signal( &q->obj.changed );
+  _object_update_event( &q->obj, true );
+
+exit:
+  pthread_mutex_unlock( &q->obj.lock );
+  return err;
+}
+
+OSStatus mico_rtos_pop_from_queue( mico_queue_t* queue, void* message, uint32_t timeout_ms )
+{
+  rtos_queue_t* q = *queue;
+  uint64_t expiry = _monotonic_ms( ) + timeout_ms;
+  OSStatus err = kNoErr;
+
+  pthread_mutex_lock( &q->obj.lock );
+  while ( q->count == 0 ) {
+    if ( _object_wait( &q->obj, &q->obj.changed, timeout_ms, expiry ) == ETIMEDOUT && q->count == 0 ) {
+      err = kTimeoutErr;
+      goto exit;
+    }
+  }
+  memcpy( message, q->buffer + q->head * q->message_size, q->message_size );
+  q->head = ( q->head + 1 ) % q->number_of_messages;
+  q->count--;
+  pthread_cond_signal( &q->not_full );
+  _object_update_event( &q->obj, q->count > 0 );
+
+exit:
+  pthread_mutex_unlock( &q->obj.lock );
+  return err;
+}
+
+OSStatus mico_rtos_deinit_queue( mico_queue_t* queue )
+{
+  rtos_queue_t* q = *queue;
+
+  require( q, exit );
+  pthread_cond_destroy( &q->not_full );
+  _object_deinit( &q->obj );
+  free( q );
+  *queue = NULL;
+exit:
+  return kNoErr;
+}
+
+bool mico_rtos_is_queue_empty( mico_queue_t* queue )
+{
+  rtos_queue_t* q = *queue;
+  bool empty;
+
+  pthread_mutex_lock( &q->obj.lock );
+  empty = ( q->count == 0 );
+  pthread_mutex_unlock( &q->obj.lock );
+  return empty;
+}
+
+OSStatus mico_rtos_is_queue_full( mico_queue_t* queue )
+{
+  rtos_queue_t* q = *queue;
+  bool full;
+
+  pthread_mutex_lock( &q->obj.lock );
+  full = ( q->count == q->number_of_messages );
+  pthread_mutex_unlock( &q->obj.lock );
+  return full;
+}
+
+/************************ Time *************************/
+
+uint32_t mico_get_time( void )
+{
+  return (uint32_t)( _monotonic_ms( ) - _boot_time_ms );
+}
+
+uint32_t mico_get_time_no_os( void )
+{
+  return mico_get_time( );
+}
+
+/*********************** Timers ************************/
+
+/* Timer callbacks run one at a time on a single timer thread, like the RTOS timer task */
+static void _timer_thread( void* arg )
+{
+  rtos_timer_t* t;
+  rtos_timer_t* next;
+  struct timespec ts;
+  uint64_t now;
+  (void)arg;
+
+  pthread_mutex_lock( &_timer_lock );
+  while ( 1 ) {
+    next = NULL;
+    for ( t = _timer_list; t != NULL; t = t->next ) {
+      if ( t->active && ( next == NULL || t->expiry < next->expiry ) )
+        next = t;
+    }
+
+    if ( next == NULL ) {
+      pthread_cond_wait( &_timer_changed, &_timer_lock );
+      continue;
+    }
+    now = _monotonic_ms( );
+    if ( next->expiry > now ) {
+      _deadline( &ts, next->expiry );
+      pthread_cond_timedwait( &_timer_changed, &_timer_lock, &ts );
+      continue;
+    }
+
+    /* MICO timers reload until they are stopped */
+    next->expiry += next->period_ms;
+    if ( next->expiry <= now )
+      next->expiry = now + next->period_ms;
+    _timer_running = next;
+    pthread_mutex_unlock( &_timer_lock );
+    next->function( next->arg );
+    pthread_mutex_lock( &_timer_lock );
+    _timer_running = NULL;
+    if ( next->deleted )
+      free( next );
+  }
+}
+
+static void _timer_start_thread( void )
+{
+  pthread_condattr_t attr;
+
+  pthread_condattr_init( &attr );
+  pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+  pthread_cond_init( &_timer_changed, &attr );
+  pthread_condattr_destroy( &attr );
+  mico_rtos_create_thread( NULL, MICO_NETWORK_WORKER_PRIORITY, "Timer", _timer_thread, 0, NULL );
+}
+
+OSStatus mico_init_timer( mico_timer_t* timer, uint32_t time_ms, timer_handler_t function, void* arg )
+{
+  rtos_timer_t* t;
+  OSStatus err = kNoErr;
+
+  pthread_once( &_timer_once, _timer_start_thread );
+
+  t = calloc( 1, sizeof(rtos_timer_t) );
+  require_action( t, exit, err = kNoMemoryErr );
+  t->function = function;
+  t->arg = arg;
+  t->period_ms = time_ms ? time_ms : 1;
+
+  timer->handle = t;
+  timer->function = function;
+  timer->arg = arg;
+
+  pthread_mutex_lock( &_timer_lock );
+  t->next = _timer_list;
+  _timer_list = t;
+  pthread_mutex_unlock( &_timer_lock );
+exit:
+  return err;
+}
+
+OSStatus mico_start_timer( mico_timer_t* timer )
+{
+  rtos_timer_t* t = timer->handle;
+  OSStatus err = kNoErr;
+
+  require_action( t, exit, err = kNotInitializedErr );
+  pthread_mutex_lock( &_timer_lock );
+  t->expiry = _monotonic_ms( ) + t->period_ms;
+  t->active = true;
+  pthread_cond_signal( &_timer_changed );
+  pthread_mutex_unlock( &_timer_lock );
+exit:
+  return err;
+}
+
+OSStatus mico_stop_timer( mico_timer_t* timer )
+{
+  rtos_timer_t* t = timer->handle;
+  OSStatus err = kNoErr;
+
+  require_action( t, exit, err = kNotInitializedErr );
+  pthread_mutex_lock( &_timer_lock );
+  t->active = false;
+  pthread_mutex_unlock( &_timer_lock );
+exit:
+  return err;
+}
+
+OSStatus mico_reload_timer( mico_timer_t* timer )
+{
+  return mico_start_timer( timer );
+}
+
+OSStatus mico_deinit_timer( mico_timer_t* timer )
+{
+  rtos_timer_t* t = timer->handle;
+  rtos_timer_t** link;
+
+  require( t, exit );
+  pthread_mutex_lock( &_timer_lock );
+  for ( link = &_timer_list; *link != NULL; link = &(*link)->next ) {
+    if ( *link == t ) {
+      *link = t->next;
+      break;
+    }
+  }
+  /* A timer deleted from its own callback is freed by the timer thread */
+  if ( t == _timer_running ) {
+    t->active = false;
+    t->deleted = true;
+  } else {
+    free( t );
+  }
+  pthread_mutex_unlock( &_timer_lock );
+  timer->handle = NULL;
+exit:
+  return kNoErr;
+}
+
+bool mico_is_timer_running( mico_timer_t* timer )
+{
+  rtos_timer_t* t = timer->handle;
+  bool running;
+
+  if ( t == NULL )
+    return false;
+  pthread_mutex_lock( &_timer_lock );
+  running = t->active;
+  pthread_mutex_unlock( &_timer_lock );
+  return running;
+}
@@ -0,0 +1,489 @@
+/**
+******************************************************************************
+* @file    mico_socket_linux.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides the MICO socket API on host sockets.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+/* Keeps <stdlib.h> from pulling in the host fd_set and select(), MicoSocket.h defines its own */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "Common.h"
+#include "Debug.h"
+#include "MICORTOS.h"
+#include "MicoSocket.h"
+#include "platform_peripheral.h"
+#include "platform_host.h"
+
+#define socket_log(M, ...) custom_log("Socket", M, ##__VA_ARGS__)
+
+/******************************************************
+*                    Constants
+******************************************************/
+
+/******************************************************
+*                   Enumerations
+******************************************************/
+
+typedef enum
+{
+  FD_TYPE_FREE = 0,
+  FD_TYPE_TCP,
+  FD_TYPE_UDP,
+  FD_TYPE_EVENT,
+} fd_type_t;
+
+/******************************************************
+*                    Structures
+******************************************************/
+
+/* MICO fds are small indexes (select() takes a FD_SETSIZE of 24), they are mapped onto host fds */
+typedef struct
+{
+  fd_type_t   type;
+  int         host_fd;
+  mico_event  event;      /* RTOS object behind an event fd */
+} mico_fd_t;
+
+/******************************************************
+*               Variables Definitions
+******************************************************/
+
+static mico_fd_t       _fds[FD_SETSIZE];
+static mico_mutex_t    _fds_mutex = NULL;
+static int             _keepalive_max_error = 0;
+static int             _keepalive_seconds = 0;
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+static void _fds_lock( void )
+{
+  /* The first socket is created long after the RTOS is up, but two threads may race for it */
+  if ( _fds_mutex == NULL ) {
+    mico_rtos_suspend_all_thread( );
+    if ( _fds_mutex == NULL )
+      mico_rtos_init_mutex( &_fds_mutex );
+    mico_rtos_resume_all_thread( );
+  }
+  mico_rtos_lock_mutex( &_fds_mutex );
+}
+
+static void _fds_unlock( void )
+{
+  mico_rtos_unlock_mutex( &_fds_mutex );
+}
+
+static int _fd_alloc( fd_type_t type, int host_fd )
+{
+  int fd;
+
+  _fds_lock( );
+  for ( fd = 0; fd < FD_SETSIZE; ++fd ) {
+    if ( _fds[fd].type == FD_TYPE_FREE ) {
+      _fds[fd].type = type;
+      _fds[fd].host_fd = host_fd;
+      _fds[fd].event = NULL;
+      break;
+    }
+  }
+  _fds_unlock( );
+
+  if ( fd == FD_SETSIZE ) {
+    socket_log( "No free socket, max is %d", FD_SETSIZE );
+    return -1;
+  }
+  return fd;
+}
+
+static int _host_fd( int fd )
+{
+  if ( fd < 0 || fd >= FD_SETSIZE || _fds[fd].type == FD_TYPE_FREE )
+    return -1;
+  return _fds[fd].host_fd;
+}
+
+static bool _is_socket( int fd )
+{
+  return ( fd >= 0 && fd < FD_SETSIZE && ( _fds[fd].type == FD_TYPE_TCP || _fds[fd].type == FD_TYPE_UDP ) );
+}
+
+int socket( int domain, int type, int protocol )
+{
+  int host_fd, fd;
+  (void)domain;
+  (void)protocol;
+
+  host_fd = host_socket( type == SOCK_DGRM );
+  require( host_fd >= 0, exit );
+
+  fd = _fd_alloc( type == SOCK_DGRM ? FD_TYPE_UDP : FD_TYPE_TCP, host_fd );
+  if ( fd < 0 ) {
+    host_close( host_fd );
+    return -1;
+  }
+  if ( type != SOCK_DGRM && _keepalive_seconds > 0 )
+    host_set_keepalive( host_fd, _keepalive_max_error, _keepalive_seconds );
+  return fd;
+
+exit:
+  return -1;
+}
+
+int setsockopt( int sockfd, int level, int optname, const void *optval, socklen_t optlen )
+{
+  int host_fd = _host_fd( sockfd );
+  int value = 0;
+  (void)level;
+
+  require( _is_socket( sockfd ), exit );
+  if ( optval != NULL && optlen >= (socklen_t) sizeof(int) )
+    memcpy( &value, optval, sizeof(int) );
+
+  switch ( optname ) {
+    case SO_REUSEADDR:
+      return host_set_reuseaddr( host_fd, 1 );
+    case SO_BROADCAST:
+      return host_set_broadcast( host_fd, 1 );
+    case IP_ADD_MEMBERSHIP:
+      return host_set_multicast( host_fd, (uint32_t) value, 1 );
+    case IP_DROP_MEMBERSHIP:
+      return host_set_multicast( host_fd, (uint32_t) value, 0 );
+    case SO_BLOCKMODE:
+      return host_set_nonblock( host_fd, value );
+    case SO_SNDTIMEO:
+      return host_set_timeout( host_fd, 1, (uint32_t) value );
+    case SO_RCVTIMEO:
+      return host_set_timeout( host_fd, 0, (uint32_t) value );
+    case TCP_MAX_CONN_NUM:
+    case SO_NO_CHECK:
+      return 0;
+    default:
+      socket_log( "Unsupported socket option 0x%x", optname );
+      return -1;
+  }
+
+exit:
+  return -1;
+}
+
+int getsockopt( int sockfd, int level, int optname, const void *optval, socklen_t *optlen )
+{
+  int value;
+  (void)level;
+
+  require( _is_socket( sockfd ) && optval != NULL, exit );
+
+  switch ( optname ) {
+    case SO_ERROR:
+      value = host_get_error( _host_fd( sockfd ) );
+      break;
+    case SO_TYPE:
+      value = ( _fds[sockfd].type == FD_TYPE_UDP ) ? SOCK_DGRM : SOCK_STREAM;
+      break;
+    default:
+      socket_log( "Unsupported socket option 0x%x", optname );
+      goto exit;
+  }
+  memcpy( (void*) optval, &value, sizeof(int) );
+  if ( optlen != NULL )
+    *optlen = sizeof(int);
+  return 0;
+
+exit:
+  return -1;
+}
+
+int bind( int sockfd, const struct sockaddr_t *addr, socklen_t addrlen )
+{
+  (void)addrlen;
+  require( _is_socket( sockfd ) && addr != NULL, exit );
+  /* Listeners come back quickly after a restart of the simulation */
+  host_set_reuseaddr( _host_fd( sockfd ), 1 );
+  return host_bind( _host_fd( sockfd ), addr->s_ip, addr->s_port );
+exit:
+  return -1;
+}
+
+int connect( int sockfd, const struct sockaddr_t *addr, socklen_t addrlen )
+{
+  (void)addrlen;
+  require( _is_socket( sockfd ) && addr != NULL, exit );
+  return host_connect( _host_fd( sockfd ), addr->s_ip, addr->s_port );
+exit:
+  return -1;
+}
+
+int listen( int sockfd, int backlog )
+{
+  require( _is_socket( sockfd ), exit );
+  return host_listen( _host_fd( sockfd ), backlog );
+exit:
+  return -1;
+}
+
+int accept( int sockfd, struct sockaddr_t *addr, socklen_t *addrlen )
+{
+  uint32_t ip;
+  uint16_t port;
+  int host_fd, fd;
+
+  require( _is_socket( sockfd ), exit );
+  host_fd = host_accept( _host_fd( sockfd ), &ip, &port );
+  require( host_fd >= 0, exit );
+
+  fd = _fd_alloc( FD_TYPE_TCP, host_fd );
+  if ( fd < 0 ) {
+    host_close( host_fd );
+    return -1;
+  }
+  if ( _keepalive_seconds > 0 )
+    host_set_keepalive( host_fd, _keepalive_max_error, _keepalive_seconds );
+  if ( addr != NULL ) {
+    memset( addr, 0x0, sizeof(struct sockaddr_t) );
+    addr->s_ip = ip;
+    addr->s_port = port;
+  }
+  if ( addrlen != NULL )
+    *addrlen = sizeof(struct sockaddr_t);
+  return fd;
+
+exit:
+  return -1;
+}
+
+int select( int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval_t *timeout )
+{
+  host_pollfd_t pfds[FD_SETSIZE];
+  int map[FD_SETSIZE];
+  int count = 0, ready = 0, timeout_ms = -1;
+  int fd, a;
+
+  /* The target library looks at every fd in the sets, MICO code often passes 1 for nfds */
+  UNUSED_PARAMETER( nfds );
+
+  for ( fd = 0; fd < FD_SETSIZE; ++fd ) {
+    int events = 0;
+    if ( readfds && FD_ISSET( fd, readfds ) )     events |= HOST_POLL_IN;
+    if ( writefds && FD_ISSET( fd, writefds ) )   events |= HOST_POLL_OUT;
+    if ( exceptfds && FD_ISSET( fd, exceptfds ) ) events |= HOST_POLL_ERR;
+    if ( events == 0 || _host_fd( fd ) < 0 )
+      continue;
+    pfds[count].fd = _host_fd( fd );
+    pfds[count].events = events;
+    map[count++] = fd;
+  }
+
+  if ( timeout != NULL )
+    timeout_ms = (int)( timeout->tv_sec * 1000 + timeout->tv_usec / 1000 );
+
+  if ( host_poll( pfds, count, timeout_ms ) < 0 )
+    return -1;
+
+  if ( readfds )   FD_ZERO( readfds );
+  if ( writefds )  FD_ZERO( writefds );
+  if ( exceptfds ) FD_ZERO( exceptfds );
+
+  for ( a = 0; a < count; ++a ) {
+    if ( pfds[a].revents == 0 )
+      continue;
+    if ( readfds && ( pfds[a].events & HOST_POLL_IN ) && ( pfds[a].revents & ( HOST_POLL_IN | HOST_POLL_ERR ) ) )
+      FD_SET( map[a], readfds );
+    if ( writefds && ( pfds[a].events & HOST_POLL_OUT ) && ( pfds[a].revents & ( HOST_POLL_OUT | HOST_POLL_ERR ) ) )
+      FD_SET( map[a], writefds );
+    if ( exceptfds && ( pfds[a].events & HOST_POLL_ERR ) && ( pfds[a].revents & HOST_POLL_ERR ) )
+      FD_SET( map[a], exceptfds );
+    ready++;
+  }
+  return ready;
+}
+
+ssize_t send( int sockfd, const void *buf, size_t len, int flags )
+{
+  (void)flags;
+  require( _is_socket( sockfd ), exit );
+  return host_send( _host_fd( sockfd ), buf, len );
+exit:
+  return -1;
+}
+
+int write( int sockfd, void *buf, size_t len )
+{
+  return send( sockfd, buf, len, 0 );
+}
+
+ssize_t sendto( int sockfd, const void *buf, size_t len, int flags, const struct sockaddr_t *dest_addr, socklen_t addrlen )
+{
+  (void)flags;
+  (void)addrlen;
+  require( _is_socket( sockfd ), exit );
+  if ( dest_addr == NULL )
+    return host_send( _host_fd( sockfd ), buf, len );
+  return host_sendto( _host_fd( sockfd ), buf, len, dest_addr->s_ip, dest_addr->s_port );
+exit:
+  return -1;
+}
+
+ssize_t recv( int sockfd, void *buf, size_t len, int flags )
+{
+  (void)flags;
+  require( _is_socket( sockfd ), exit );
+  return host_recv( _host_fd( sockfd ), buf, len );
+exit:
+  return -1;
+}
+
+int read( int sockfd, void *buf, size_t len )
+{
+  return recv( sockfd, buf, len, 0 );
+}
+
+ssize_t recvfrom( int sockfd, void *buf, size_t len, int flags, struct sockaddr_t *src_addr, socklen_t *addrlen )
+{
+  uint32_t ip;
+  uint16_t port;
+  int ret;
+  (void)flags;
+
+  require( _is_socket( sockfd ), exit );
+  ret = host_recvfrom( _host_fd( sockfd ), buf, len, &ip, &port );
+  if ( ret >= 0 && src_addr != NULL ) {
+    memset( src_addr, 0x0, sizeof(struct sockaddr_t) );
+    src_addr->s_ip = ip;
+    src_addr->s_port = port;
+  }
+  if ( addrlen != NULL )
+    *addrlen = sizeof(struct sockaddr_t);
+  return ret;
+
+exit:
+  return -1;
+}
+
+int close( int fd )
+{
+  int host_fd;
+
+  require( _is_socket( fd ), exit );
+  _fds_lock( );
+  host_fd = _fds[fd].host_fd;
+  _fds[fd].type = FD_TYPE_FREE;
+  _fds_unlock( );
+  return host_close( host_fd );
+exit:
+  return -1;
+}
+
+int mico_create_event_fd( mico_event handle )
+{
+  int host_fd, fd;
+
+  host_fd = host_event_open( );
+  require( host_fd >= 0, exit );
+
+  fd = _fd_alloc( FD_TYPE_EVENT, host_fd );
+  require( fd >= 0, exit_with_host_fd );
+  _fds[fd].event = handle;
+  require_noerr( platform_rtos_event_attach( handle, host_fd ), exit_with_fd );
+  return fd;
+
+exit_with_fd:
+  _fds[fd].type = FD_TYPE_FREE;
+exit_with_host_fd:
+  host_close( host_fd );
+exit:
+  return -1;
+}
+
+int mico_delete_event_fd( int fd )
+{
+  int host_fd;
+
+  require( fd >= 0 && fd < FD_SETSIZE && _fds[fd].type == FD_TYPE_EVENT, exit );
+  platform_rtos_event_detach( _fds[fd].event );
+  _fds_lock( );
+  host_fd = _fds[fd].host_fd;
+  _fds[fd].type = FD_TYPE_FREE;
+  _fds_unlock( );
+  return host_close( host_fd );
+exit:
+  return -1;
+}
+
+uint32_t inet_addr( char *s )
+{
+  uint32_t value = 0, part;
+  int a;
+
+  for ( a = 0; a < 4; ++a ) {
+    if ( !isdigit( (unsigned char) *s ) )
+      return 0;
+    part = strtoul( s, &s, 10 );
+    if ( part > 255 || ( a < 3 && *s++ != '.' ) )
+      return 0;
+    value = ( value << 8 ) | part;
+  }
+  return value;
+}
+
+char *inet_ntoa( char *s, uint32_t x )
+{
+  sprintf( s, "%u.%u.%u.%u", (unsigned int)( x >> 24 ) & 0xFF, (unsigned int)( x >> 16 ) & 0xFF,
+          (unsigned int)( x >> 8 ) & 0xFF, (unsigned int) x & 0xFF );
+  return s;
+}
+
+int gethostbyname( const char * name, uint8_t * addr, uint8_t addrLen )
+{
+  uint32_t ip;
+  char ipstr[16];
+
+  require( name != NULL && addr != NULL, exit );
+  require( host_resolve( name, &ip ) == 0, exit );
+  inet_ntoa( ipstr, ip );
+  require( strlen( ipstr ) < addrLen, exit );
+  strcpy( (char*) addr, ipstr );
+  return kNoErr;
+
+exit:
+  return -1;
+}
+
+void set_tcp_keepalive( int inMaxErrNum, int inSeconds )
+{
+  _keepalive_max_error = inMaxErrNum;
+  _keepalive_seconds = inSeconds;
+}
+
+void get_tcp_keepalive( int *outMaxErrNum, int *outSeconds )
+{
+  *outMaxErrNum = _keepalive_max_error;
+  *outSeconds = _keepalive_seconds;
+}
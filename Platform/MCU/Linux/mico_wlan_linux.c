@@ -0,0 +1,282 @@
+/**
+******************************************************************************
+* @file    mico_wlan_linux.c
+* @author  William Xu
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   This file provides the MICO core and Wi-Fi APIs on the host network.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/* Keeps <stdlib.h> from pulling in the host fd_set and select(), MicoSocket.h defines its own */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "MICO.h"
+#include "MICODefine.h"
+#include "MICOCli.h"
+#include "MICONotificationCenter.h"
+#include "StringUtils.h"
+#include "platform_host.h"
+
+#define wlan_log(M, ...) custom_log("WLAN", M, ##__VA_ARGS__)
+
+/* The prebuilt core library and Wi-Fi driver do not exist for the host. The
+ * host network stands in for the wlan: the station and the soft AP are both
+ * "up" on the first host interface as soon as they are started, and EasyLink
+ * fails at once since there is no radio to sniff, so applications fall back to
+ * their soft AP configuration and serve it on the host address. Events are
+ * reported from a thread of their own, as the driver does on the target. */
+
+/******************************************************
+*                    Constants
+******************************************************/
+
+#define WLAN_EVENT_STACK_SIZE   ( 0x1000 )
+
+/******************************************************
+*                   Enumerations
+******************************************************/
+
+typedef enum
+{
+  WLAN_EVENT_STATION_UP,
+  WLAN_EVENT_AP_UP,
+  WLAN_EVENT_EASYLINK_TIMEOUT,
+} wlan_event_t;
+
+/******************************************************
+*               Function Declarations
+******************************************************/
+
+/* Reported to MICONotificationCenter.c */
+extern void WifiStatusHandler( WiFiEvent status );
+extern void NetCallback( IPStatusTypedef *pnet );
+extern void RptConfigmodeRslt( network_InitTypeDef_st *nwkpara );
+
+extern int application_start( void );
+
+/******************************************************
+*               Variables Definitions
+******************************************************/
+
+static micoMemInfo_t _memInfo;
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+static void _ip_to_str( uint32_t ip, char* str )
+{
+  sprintf( str, "%u.%u.%u.%u", (unsigned int)( ( ip >> 24 ) & 0xFF ), (unsigned int)( ( ip >> 16 ) & 0xFF ),
+           (unsigned int)( ( ip >> 8 ) & 0xFF ), (unsigned int)( ip & 0xFF ) );
+}
+
+static void _wlan_event_thread( void* arg )
+{
+  IPStatusTypedef para;
+
+  switch ( (wlan_event_t)(intptr_t) arg ) {
+    case WLAN_EVENT_STATION_UP:
+      WifiStatusHandler( NOTIFY_STATION_UP );
+      if ( micoWlanGetIPStatus( &para, Station ) == kNoErr )
+        NetCallback( &para );
+      break;
+    case WLAN_EVENT_AP_UP:
+      WifiStatusHandler( NOTIFY_AP_UP );
+      break;
+    case WLAN_EVENT_EASYLINK_TIMEOUT:
+      RptConfigmodeRslt( NULL );
+      break;
+  }
+  mico_rtos_delete_thread( NULL );
+}
+
+static OSStatus _wlan_report( wlan_event_t event )
+{
+  return mico_rtos_create_thread( NULL, MICO_NETWORK_WORKER_PRIORITY, "WLAN event", _wlan_event_thread,
+                                  WLAN_EVENT_STACK_SIZE, (void*)(intptr_t) event );
+}
+
+/******************************************************
+*                      Core
+******************************************************/
+
+/* The platform is up before main(), see platform_init.c */
+void MicoInit( void )
+{
+  wlan_log( "Host network in place of the wlan driver" );
+}
+
+char* MicoGetVer( void )
+{
+  return "Linux-Sim";
+}
+
+int MicoGetRfVer( char* outVersion, uint8_t inLength )
+{
+  return snprintf( outVersion, inLength, "host network" );
+}
+
+micoMemInfo_t* MicoGetMemoryInfo( void )
+{
+  size_t total, allocated, available, chunks;
+
+  host_memory_info( &total, &allocated, &available, &chunks );
+  _memInfo.total_memory = (int) total;
+  _memInfo.allocted_memory = (int) allocated;
+  _memInfo.free_memory = (int) available;
+  _memInfo.num_of_chunks = (int) chunks;
+  return &_memInfo;
+}
+
+void mico_mfg_test( mico_Context_t * const inContext )
+{
+  UNUSED_PARAMETER( inContext );
+  wlan_log( "MFG test needs the wlan driver, not available on the host" );
+  mico_thread_sleep( MICO_NEVER_TIMEOUT );
+}
+
+/* The target library runs application_start() on a thread of its own, the
+ * host keeps main() for it and leaves the process to the other threads after */
+int main( void )
+{
+  application_start( );
+  mico_rtos_delete_thread( NULL );
+  return 0;
+}
+
+/******************************************************
+*                      Wlan
+******************************************************/
+
+OSStatus micoWlanStart( network_InitTypeDef_st* inNetworkInitPara )
+{
+  if ( inNetworkInitPara->wifi_mode == Soft_AP ) {
+    wlan_log( "Soft AP %s on the host network", inNetworkInitPara->wifi_ssid );
+    return _wlan_report( WLAN_EVENT_AP_UP );
+  }
+  wlan_log( "Station %s on the host network", inNetworkInitPara->wifi_ssid );
+  return _wlan_report( WLAN_EVENT_STATION_UP );
+}
+
+OSStatus micoWlanStartAdv( network_InitTypeDef_adv_st* inNetworkInitParaAdv )
+{
+  wlan_log( "Station %s on the host network", inNetworkInitParaAdv->ap_info.ssid );
+  return _wlan_report( WLAN_EVENT_STATION_UP );
+}
+
+OSStatus micoWlanGetIPStatus( IPStatusTypedef *outNetpara, WiFi_Interface inInterface )
+{
+  uint32_t ip, mask, broadcast, dns;
+  uint8_t mac[6];
+  UNUSED_PARAMETER( inInterface );
+
+  memset( outNetpara, 0x0, sizeof(IPStatusTypedef) );
+  if ( host_get_interface( &ip, &mask, &broadcast, mac ) != 0 )
+    return kNotFoundErr;
+
+  outNetpara->dhcp = DHCP_Client;
+  _ip_to_str( ip, outNetpara->ip );
+  _ip_to_str( mask, outNetpara->mask );
+  /* The host route table is not looked up, the first address of the subnet is a usual router */
+  _ip_to_str( ( ip & mask ) | 1, outNetpara->gate );
+  _ip_to_str( host_get_nameserver( &dns ) == 0 ? dns : ( ip & mask ) | 1, outNetpara->dns );
+  _ip_to_str( broadcast, outNetpara->broadcastip );
+  sprintf( outNetpara->mac, "%02X%02X%02X%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5] );
+  return kNoErr;
+}
+
+OSStatus micoWlanPowerOff( void )
+{
+  return kNoErr;
+}
+
+OSStatus micoWlanSuspendSoftAP( void )
+{
+  return kNoErr;
+}
+
+void micoWlanEnablePowerSave( void )
+{
+}
+
+OSStatus micoWlanStartEasyLink( int inTimeout )
+{
+  wlan_log( "EasyLink needs the radio, reported as timed out after 0 of %d seconds", inTimeout );
+  return _wlan_report( WLAN_EVENT_EASYLINK_TIMEOUT );
+}
+
+OSStatus micoWlanStopEasyLink( void )
+{
+  return kNoErr;
+}
+
+/******************************************************
+*                   CLI commands
+******************************************************/
+
+void ifconfig_Command( CLI_ARGS )
+{
+  IPStatusTypedef para;
+  UNUSED_PARAMETER( argc );
+  UNUSED_PARAMETER( argv );
+
+  if ( micoWlanGetIPStatus( &para, Station ) != kNoErr ) {
+    cmd_printf( "No host interface is up\r\n" );
+    return;
+  }
+  cmd_printf( "IP: %s\r\nMask: %s\r\nGateway: %s\r\nDNS: %s\r\nMAC: %s\r\n",
+              para.ip, para.mask, para.gate, para.dns, para.mac );
+}
+
+static void _unsupported_Command( CLI_ARGS )
+{
+  UNUSED_PARAMETER( argc );
+  cmd_printf( "%s is not available on the host\r\n", argv[0] );
+}
+
+void wifistate_Command( CLI_ARGS )    { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void wifidebug_Command( CLI_ARGS )    { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void wifiscan_Command( CLI_ARGS )     { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void arp_Command( CLI_ARGS )          { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void ping_Command( CLI_ARGS )         { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void dns_Command( CLI_ARGS )          { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void task_Command( CLI_ARGS )         { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void socket_show_Command( CLI_ARGS )  { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void memory_dump_Command( CLI_ARGS )  { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void memory_set_Command( CLI_ARGS )   { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void memp_dump_Command( CLI_ARGS )    { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+void driver_state_Command( CLI_ARGS ) { _unsupported_Command( pcWriteBuffer, xWriteBufferLen, argc, argv ); }
+
+void memory_show_Command( CLI_ARGS )
+{
+  micoMemInfo_t* info = MicoGetMemoryInfo( );
+  UNUSED_PARAMETER( argc );
+  UNUSED_PARAMETER( argv );
+
+  cmd_printf( "total memory %d, allocated %d, free %d, chunks %d\r\n",
+              info->total_memory, info->allocted_memory, info->free_memory, info->num_of_chunks );
+}
@@ -0,0 +1,147 @@
+/**
+******************************************************************************
+* @file    platform_flash.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides flash functions on a host image file.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#include "MICORTOS.h"
+#include "MicoPlatform.h"
+#include "platform.h"
+#include "platform_peripheral.h"
+#include "platform_host.h"
+#include "Debug.h"
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+OSStatus platform_flash_init( platform_flash_driver_t *driver, const platform_flash_t *peripheral )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( driver != NULL && peripheral != NULL, exit, err = kParamErr);
+  require_action_quiet( driver->initialized == false, exit, err = kNoErr);
+
+  driver->peripheral = (platform_flash_t *)peripheral;
+
+  /* A missing image reads back as freshly erased flash */
+  driver->image = host_map_file( peripheral->image_path, peripheral->flash_length, 0xFF );
+  require_action( driver->image != NULL, exit, err = kOpenErr );
+
+  err = mico_rtos_init_mutex( &driver->flash_mutex );
+  require_noerr(err, exit);
+  driver->initialized = true;
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_erase( platform_flash_driver_t *driver, uint32_t StartAddress, uint32_t EndAddress  )
+{
+  uint32_t sector_size;
+  uint32_t offset, end;
+  OSStatus err = kNoErr;
+
+  require_action_quiet( driver != NULL, exit, err = kParamErr);
+  require_action_quiet( driver->initialized != false, exit, err = kNotInitializedErr);
+  require_action( StartAddress >= driver->peripheral->flash_start_addr 
+               && EndAddress   <= driver->peripheral->flash_start_addr + driver->peripheral->flash_length - 1, exit, err = kParamErr);
+
+  /* Whole sectors are erased, like on the real part */
+  sector_size = driver->peripheral->flash_sector_size;
+  offset = StartAddress - driver->peripheral->flash_start_addr;
+  end = EndAddress - driver->peripheral->flash_start_addr + 1;
+  offset -= offset % sector_size;
+  end = MIN( ( end + sector_size - 1 ) / sector_size * sector_size, driver->peripheral->flash_length );
+
+  mico_rtos_lock_mutex( &driver->flash_mutex );
+  memset( driver->image + offset, 0xFF, end - offset );
+  host_sync_file( driver->image, driver->peripheral->flash_length );
+  mico_rtos_unlock_mutex( &driver->flash_mutex );
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_write( platform_flash_driver_t *driver, volatile uint32_t* FlashAddress, uint8_t* Data ,uint32_t DataLength  )
+{
+  uint8_t* image;
+  uint32_t i;
+  OSStatus err = kNoErr;
+
+  require_action_quiet( driver != NULL && FlashAddress != NULL && Data != NULL, exit, err = kParamErr);
+  require_action_quiet( driver->initialized != false, exit, err = kNotInitializedErr);
+  require_action( *FlashAddress >= driver->peripheral->flash_start_addr 
+               && *FlashAddress + DataLength <= driver->peripheral->flash_start_addr + driver->peripheral->flash_length, exit, err = kParamErr);
+
+  mico_rtos_lock_mutex( &driver->flash_mutex );
+  /* Programming only clears bits, a write over unerased data leaves the same garbage a NOR part would */
+  image = driver->image + ( *FlashAddress - driver->peripheral->flash_start_addr );
+  for ( i = 0; i < DataLength; i++ )
+    image[i] &= Data[i];
+  *FlashAddress += DataLength;
+  host_sync_file( driver->image, driver->peripheral->flash_length );
+  mico_rtos_unlock_mutex( &driver->flash_mutex );
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_read( platform_flash_driver_t *driver, volatile uint32_t* FlashAddress, uint8_t* Data ,uint32_t DataLength  )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( driver != NULL && FlashAddress != NULL && Data != NULL, exit, err = kParamErr);
+  require_action_quiet( driver->initialized != false, exit, err = kNotInitializedErr);
+  require_action( *FlashAddress >= driver->peripheral->flash_start_addr 
+               && *FlashAddress + DataLength <= driver->peripheral->flash_start_addr + driver->peripheral->flash_length, exit, err = kParamErr);
+
+  mico_rtos_lock_mutex( &driver->flash_mutex );
+  memcpy( Data, driver->image + ( *FlashAddress - driver->peripheral->flash_start_addr ), DataLength );
+  *FlashAddress += DataLength;
+  mico_rtos_unlock_mutex( &driver->flash_mutex );
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_deinit( platform_flash_driver_t *driver)
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( driver != NULL, exit, err = kParamErr);
+  require_action_quiet( driver->initialized != false, exit, err = kNoErr);
+
+  host_unmap_file( driver->image, driver->peripheral->flash_length );
+  driver->image = NULL;
+  mico_rtos_deinit_mutex( &driver->flash_mutex );
+  driver->initialized = false;
+
+exit:
+  return err;
+}
@@ -0,0 +1,176 @@
+/**
+******************************************************************************
+* @file    platform_gpio.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides simulated GPIO functions.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#include "MICORTOS.h"
+#include "MicoPlatform.h"
+#include "platform.h"
+#include "platform_peripheral.h"
+#include "Debug.h"
+
+/******************************************************
+*                    Structures
+******************************************************/
+
+typedef struct
+{
+  bool                           level;
+  platform_gpio_irq_trigger_t    trigger;
+  platform_gpio_irq_callback_t   handler;
+  void*                          arg;
+} gpio_state_t;
+
+/******************************************************
+*               Variables Definitions
+******************************************************/
+
+/* Pins only hold a level, an interrupt fires when the level is changed through an output call */
+static gpio_state_t gpio_states[NUMBER_OF_GPIO_PINS];
+
+/******************************************************
+*        Static Function Declarations
+******************************************************/
+
+static OSStatus gpio_set_level( const platform_gpio_t* gpio, bool level );
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+OSStatus platform_gpio_init( const platform_gpio_t* gpio, platform_pin_config_t config )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( gpio != NULL && gpio->pin_number < NUMBER_OF_GPIO_PINS, exit, err = kParamErr);
+
+  mico_rtos_suspend_all_thread();
+  /* Pulled inputs and open drain outputs idle at their pull level */
+  gpio_states[gpio->pin_number].level = ( config == INPUT_PULL_UP || config == OUTPUT_OPEN_DRAIN_PULL_UP || config == OUTPUT_OPEN_DRAIN_NO_PULL );
+  mico_rtos_resume_all_thread();
+
+exit:
+  return err;
+}
+
+OSStatus platform_gpio_deinit( const platform_gpio_t* gpio )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( gpio != NULL && gpio->pin_number < NUMBER_OF_GPIO_PINS, exit, err = kParamErr);
+
+  mico_rtos_suspend_all_thread();
+  memset( &gpio_states[gpio->pin_number], 0x0, sizeof(gpio_state_t) );
+  mico_rtos_resume_all_thread();
+
+exit:
+  return err;
+}
+
+OSStatus platform_gpio_output_high( const platform_gpio_t* gpio )
+{
+  return gpio_set_level( gpio, true );
+}
+
+OSStatus platform_gpio_output_low( const platform_gpio_t* gpio )
+{
+  return gpio_set_level( gpio, false );
+}
+
+OSStatus platform_gpio_output_trigger( const platform_gpio_t* gpio )
+{
+  if ( gpio == NULL || gpio->pin_number >= NUMBER_OF_GPIO_PINS )
+    return kParamErr;
+  return gpio_set_level( gpio, !gpio_states[gpio->pin_number].level );
+}
+
+bool platform_gpio_input_get( const platform_gpio_t* gpio )
+{
+  if ( gpio == NULL || gpio->pin_number >= NUMBER_OF_GPIO_PINS )
+    return false;
+  return gpio_states[gpio->pin_number].level;
+}
+
+OSStatus platform_gpio_irq_enable( const platform_gpio_t* gpio, platform_gpio_irq_trigger_t trigger, platform_gpio_irq_callback_t handler, void* arg )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( gpio != NULL && gpio->pin_number < NUMBER_OF_GPIO_PINS && handler != NULL, exit, err = kParamErr);
+
+  mico_rtos_suspend_all_thread();
+  gpio_states[gpio->pin_number].trigger = trigger;
+  gpio_states[gpio->pin_number].handler = handler;
+  gpio_states[gpio->pin_number].arg     = arg;
+  mico_rtos_resume_all_thread();
+
+exit:
+  return err;
+}
+
+OSStatus platform_gpio_irq_disable( const platform_gpio_t* gpio )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( gpio != NULL && gpio->pin_number < NUMBER_OF_GPIO_PINS, exit, err = kParamErr);
+
+  mico_rtos_suspend_all_thread();
+  gpio_states[gpio->pin_number].handler = NULL;
+  gpio_states[gpio->pin_number].arg     = NULL;
+  mico_rtos_resume_all_thread();
+
+exit:
+  return err;
+}
+
+static OSStatus gpio_set_level( const platform_gpio_t* gpio, bool level )
+{
+  platform_gpio_irq_callback_t handler = NULL;
+  gpio_state_t* state;
+  void* arg = NULL;
+  OSStatus err = kNoErr;
+
+  require_action_quiet( gpio != NULL && gpio->pin_number < NUMBER_OF_GPIO_PINS, exit, err = kParamErr);
+
+  mico_rtos_suspend_all_thread();
+  state = &gpio_states[gpio->pin_number];
+  if ( state->level != level && state->handler != NULL
+    && ( state->trigger & ( level ? IRQ_TRIGGER_RISING_EDGE : IRQ_TRIGGER_FALLING_EDGE ) ) ) {
+    handler = state->handler;
+    arg = state->arg;
+  }
+  state->level = level;
+  mico_rtos_resume_all_thread();
+
+  /* Called outside of the lock, the handler may drive other pins */
+  if ( handler != NULL )
+    handler( arg );
+
+exit:
+  return err;
+}
@@ -0,0 +1,152 @@
+/**
+******************************************************************************
+* @file    platform_mcu_peripheral.h
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides the peripheral types of the Linux simulation port.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#pragma once
+
+#include "Common.h"
+#include "MICORTOS.h"
+#include "RingBufferUtils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+/* Simulated GPIO pins */
+#define NUMBER_OF_GPIO_PINS       (64)
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+    FLASH_TYPE_INTERNAL,
+    FLASH_TYPE_SPI,
+} platform_flash_type_t;
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/* Pins only hold a level in memory */
+typedef struct
+{
+    uint8_t                pin_number;
+} platform_gpio_t;
+
+typedef struct
+{
+    uint8_t                unimplemented;
+} platform_adc_t;
+
+typedef struct
+{
+    uint8_t                unimplemented;
+} platform_pwm_t;
+
+typedef struct
+{
+    uint8_t                unimplemented;
+} platform_spi_t;
+
+typedef struct
+{
+    uint8_t                unimplemented;
+} platform_spi_slave_driver_t;
+
+typedef struct
+{
+    uint8_t                unimplemented;
+} platform_i2c_t;
+
+/* A UART is a pseudo terminal, the slave side is linked to link_path, e.g. "screen /tmp/mico_uart1" */
+typedef struct
+{
+    const char*            link_path;
+} platform_uart_t;
+
+typedef struct
+{
+    platform_uart_t*           peripheral;
+    ring_buffer_t*             rx_buffer;
+    int                        pty_fd;
+    mico_mutex_t               tx_mutex;
+    mico_mutex_t               rx_mutex;
+    volatile OSStatus          last_receive_result;
+    volatile OSStatus          last_transmit_result;
+} platform_uart_driver_t;
+
+/* A flash is a file mapped in memory at flash_start_addr, it is created erased when missing */
+typedef struct
+{
+    platform_flash_type_t      flash_type;
+    uint32_t                   flash_start_addr;
+    uint32_t                   flash_length;
+    uint32_t                   flash_sector_size;
+    const char*                image_path;
+} platform_flash_t;
+
+typedef struct
+{
+    platform_flash_t*          peripheral;
+    bool                       initialized;
+    uint8_t*                   image;
+    mico_mutex_t               flash_mutex;
+} platform_flash_driver_t;
+
+/******************************************************
+ *                 Global Variables
+ ******************************************************/
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+/* RTOS objects behind mico_create_event_fd() */
+OSStatus platform_rtos_event_attach          ( mico_event handle, int event_fd );
+void     platform_rtos_event_detach          ( mico_event handle );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
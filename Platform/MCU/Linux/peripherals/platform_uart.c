@@ -0,0 +1,219 @@
+/**
+******************************************************************************
+* @file    platform_uart.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides UART functions on host pseudo terminals.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#include "MICORTOS.h"
+#include "MicoPlatform.h"
+#include "platform.h"
+#include "platform_peripheral.h"
+#include "platform_host.h"
+#include "PlatformLogging.h"
+#include "Debug.h"
+
+/******************************************************
+*                    Constants
+******************************************************/
+
+/* Data is dropped when nothing reads the other side of the terminal for this long */
+#define UART_TX_TIMEOUT_MS   (100)
+
+/******************************************************
+*        Static Function Declarations
+******************************************************/
+
+static void     pull_to_ring_buffer( platform_uart_driver_t* driver );
+static OSStatus wait_readable       ( platform_uart_driver_t* driver, uint32_t timeout_ms, uint32_t start_time );
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+OSStatus platform_uart_init( platform_uart_driver_t* driver, const platform_uart_t* peripheral, const platform_uart_config_t* config, ring_buffer_t* optional_ring_buffer )
+{
+  char slave_name[64];
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( driver != NULL ) && ( peripheral != NULL ) && ( config != NULL ), exit, err = kParamErr);
+  require_action_quiet( (optional_ring_buffer == NULL) || ((optional_ring_buffer->buffer != NULL ) && (optional_ring_buffer->size != 0)), exit, err = kParamErr);
+
+  driver->peripheral           = (platform_uart_t*)peripheral;
+  driver->rx_buffer            = optional_ring_buffer;
+  driver->last_transmit_result = kNoErr;
+  driver->last_receive_result  = kNoErr;
+
+  /* Baud rate, parity and flow control have no meaning on a pseudo terminal */
+  driver->pty_fd = host_pty_open( peripheral->link_path, slave_name, sizeof(slave_name) );
+  require_action( driver->pty_fd >= 0, exit, err = kOpenErr );
+  platform_log( "UART on %s%s%s", slave_name, peripheral->link_path ? ", linked to " : "", peripheral->link_path ? peripheral->link_path : "" );
+
+  mico_rtos_init_mutex( &driver->tx_mutex );
+  mico_rtos_init_mutex( &driver->rx_mutex );
+
+exit:
+  return err;
+}
+
+OSStatus platform_uart_deinit( platform_uart_driver_t* driver )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( driver != NULL ) && ( driver->pty_fd >= 0 ), exit, err = kParamErr);
+
+  host_pty_close( driver->pty_fd, driver->peripheral->link_path );
+  driver->pty_fd = -1;
+  mico_rtos_deinit_mutex( &driver->tx_mutex );
+  mico_rtos_deinit_mutex( &driver->rx_mutex );
+
+exit:
+  return err;
+}
+
+OSStatus platform_uart_transmit_bytes( platform_uart_driver_t* driver, const uint8_t* data_out, uint32_t size )
+{
+  host_pollfd_t pfd;
+  int sent;
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( driver != NULL ) && ( data_out != NULL ) && ( size != 0 ), exit, err = kParamErr);
+
+  mico_rtos_lock_mutex( &driver->tx_mutex );
+  while ( size > 0 ) {
+    sent = host_write( driver->pty_fd, data_out, size );
+    if ( sent > 0 ) {
+      data_out += sent;
+      size -= sent;
+      continue;
+    }
+    pfd.fd = driver->pty_fd;
+    pfd.events = HOST_POLL_OUT;
+    if ( host_poll( &pfd, 1, UART_TX_TIMEOUT_MS ) <= 0 ) {
+      err = kTimeoutErr;
+      break;
+    }
+  }
+  driver->last_transmit_result = err;
+  mico_rtos_unlock_mutex( &driver->tx_mutex );
+
+exit:
+  return err;
+}
+
+OSStatus platform_uart_receive_bytes( platform_uart_driver_t* driver, uint8_t* data_in, uint32_t expected_data_size, uint32_t timeout_ms )
+{
+  uint32_t start_time = mico_get_time( );
+  uint32_t contiguous;
+  uint8_t* data;
+  int received;
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( driver != NULL ) && ( data_in != NULL ) && ( expected_data_size != 0 ), exit, err = kParamErr);
+
+  mico_rtos_lock_mutex( &driver->rx_mutex );
+  while ( expected_data_size > 0 ) {
+    if ( driver->rx_buffer != NULL ) {
+      pull_to_ring_buffer( driver );
+      /* Like the DMA driver, only return once the whole request is buffered */
+      if ( ring_buffer_used_space( driver->rx_buffer ) >= expected_data_size ) {
+        while ( expected_data_size > 0 ) {
+          ring_buffer_get_data( driver->rx_buffer, &data, &contiguous );
+          contiguous = MIN( contiguous, expected_data_size );
+          memcpy( data_in, data, contiguous );
+          ring_buffer_consume( driver->rx_buffer, contiguous );
+          data_in += contiguous;
+          expected_data_size -= contiguous;
+        }
+        break;
+      }
+    } else {
+      received = host_read( driver->pty_fd, data_in, expected_data_size );
+      if ( received > 0 ) {
+        data_in += received;
+        expected_data_size -= received;
+        continue;
+      }
+    }
+    err = wait_readable( driver, timeout_ms, start_time );
+    require_noerr_quiet( err, exit_with_mutex );
+  }
+
+exit_with_mutex:
+  driver->last_receive_result = err;
+  mico_rtos_unlock_mutex( &driver->rx_mutex );
+exit:
+  return err;
+}
+
+OSStatus platform_uart_get_length_in_buffer( platform_uart_driver_t* driver )
+{
+  uint32_t length;
+
+  if ( driver->rx_buffer == NULL )
+    return 0;
+  mico_rtos_lock_mutex( &driver->rx_mutex );
+  pull_to_ring_buffer( driver );
+  length = ring_buffer_used_space( driver->rx_buffer );
+  mico_rtos_unlock_mutex( &driver->rx_mutex );
+  return length;
+}
+
+/* Move what the terminal has received into the ring buffer, one slot is kept free to tell full from empty */
+static void pull_to_ring_buffer( platform_uart_driver_t* driver )
+{
+  uint8_t buf[256];
+  uint32_t space;
+  int received;
+
+  while ( 1 ) {
+    space = driver->rx_buffer->size - 1 - ring_buffer_used_space( driver->rx_buffer );
+    if ( space == 0 )
+      break;
+    received = host_read( driver->pty_fd, buf, MIN( space, sizeof(buf) ) );
+    if ( received <= 0 )
+      break;
+    ring_buffer_write( driver->rx_buffer, buf, received );
+  }
+}
+
+static OSStatus wait_readable( platform_uart_driver_t* driver, uint32_t timeout_ms, uint32_t start_time )
+{
+  host_pollfd_t pfd;
+  int wait_ms = -1;
+
+  if ( timeout_ms != MICO_NEVER_TIMEOUT ) {
+    wait_ms = (int)( timeout_ms - ( mico_get_time( ) - start_time ) );
+    if ( wait_ms <= 0 )
+      return kTimeoutErr;
+  }
+  pfd.fd = driver->pty_fd;
+  pfd.events = HOST_POLL_IN;
+  if ( host_poll( &pfd, 1, wait_ms ) <= 0 )
+    return kTimeoutErr;
+  return kNoErr;
+}
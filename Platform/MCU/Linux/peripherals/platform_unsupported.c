@@ -0,0 +1,249 @@
+/**
+******************************************************************************
+* @file    platform_unsupported.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides the peripherals the Linux simulation port does not have.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#include "MicoPlatform.h"
+#include "platform.h"
+#include "platform_peripheral.h"
+
+/* ADC, PWM, SPI, I2C and RTC have nothing to talk to on the host */
+
+/******************************************************
+*                      ADC
+******************************************************/
+
+OSStatus platform_adc_init( const platform_adc_t* adc, uint32_t sample_cycle )
+{
+  UNUSED_PARAMETER( adc );
+  UNUSED_PARAMETER( sample_cycle );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_adc_deinit( const platform_adc_t* adc )
+{
+  UNUSED_PARAMETER( adc );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_adc_take_sample( const platform_adc_t* adc, uint16_t* output )
+{
+  UNUSED_PARAMETER( adc );
+  UNUSED_PARAMETER( output );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_adc_take_sample_stream( const platform_adc_t* adc, void* buffer, uint16_t buffer_length )
+{
+  UNUSED_PARAMETER( adc );
+  UNUSED_PARAMETER( buffer );
+  UNUSED_PARAMETER( buffer_length );
+  return kUnsupportedErr;
+}
+
+/******************************************************
+*                      PWM
+******************************************************/
+
+OSStatus platform_pwm_init( const platform_pwm_t* pwm, uint32_t frequency, float duty_cycle )
+{
+  UNUSED_PARAMETER( pwm );
+  UNUSED_PARAMETER( frequency );
+  UNUSED_PARAMETER( duty_cycle );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_pwm_start( const platform_pwm_t* pwm )
+{
+  UNUSED_PARAMETER( pwm );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_pwm_stop( const platform_pwm_t* pwm )
+{
+  UNUSED_PARAMETER( pwm );
+  return kUnsupportedErr;
+}
+
+/******************************************************
+*                      SPI
+******************************************************/
+
+OSStatus platform_spi_init( const platform_spi_t* spi, const platform_spi_config_t* config )
+{
+  UNUSED_PARAMETER( spi );
+  UNUSED_PARAMETER( config );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_deinit( const platform_spi_t* spi )
+{
+  UNUSED_PARAMETER( spi );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_transfer( const platform_spi_t* spi, const platform_spi_config_t* config, const platform_spi_message_segment_t* segments, uint16_t number_of_segments )
+{
+  UNUSED_PARAMETER( spi );
+  UNUSED_PARAMETER( config );
+  UNUSED_PARAMETER( segments );
+  UNUSED_PARAMETER( number_of_segments );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_slave_init( platform_spi_slave_driver_t* driver, const platform_spi_t* peripheral, const platform_spi_slave_config_t* config )
+{
+  UNUSED_PARAMETER( driver );
+  UNUSED_PARAMETER( peripheral );
+  UNUSED_PARAMETER( config );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_slave_deinit( platform_spi_slave_driver_t* driver )
+{
+  UNUSED_PARAMETER( driver );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_slave_receive_command( platform_spi_slave_driver_t* driver, platform_spi_slave_command_t* command, uint32_t timeout_ms )
+{
+  UNUSED_PARAMETER( driver );
+  UNUSED_PARAMETER( command );
+  UNUSED_PARAMETER( timeout_ms );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_slave_transfer_data( platform_spi_slave_driver_t* driver, platform_spi_slave_transfer_direction_t direction, platform_spi_slave_data_buffer_t* buffer, uint32_t timeout_ms )
+{
+  UNUSED_PARAMETER( driver );
+  UNUSED_PARAMETER( direction );
+  UNUSED_PARAMETER( buffer );
+  UNUSED_PARAMETER( timeout_ms );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_slave_send_error_status( platform_spi_slave_driver_t* driver, platform_spi_slave_transfer_status_t error_status )
+{
+  UNUSED_PARAMETER( driver );
+  UNUSED_PARAMETER( error_status );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_spi_slave_generate_interrupt( platform_spi_slave_driver_t* driver, uint32_t pulse_duration_ms )
+{
+  UNUSED_PARAMETER( driver );
+  UNUSED_PARAMETER( pulse_duration_ms );
+  return kUnsupportedErr;
+}
+
+/******************************************************
+*                      I2C
+******************************************************/
+
+OSStatus platform_i2c_init( const platform_i2c_t* i2c, const platform_i2c_config_t* config )
+{
+  UNUSED_PARAMETER( i2c );
+  UNUSED_PARAMETER( config );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_i2c_deinit( const platform_i2c_t* i2c, const platform_i2c_config_t* config )
+{
+  UNUSED_PARAMETER( i2c );
+  UNUSED_PARAMETER( config );
+  return kUnsupportedErr;
+}
+
+bool platform_i2c_probe_device( const platform_i2c_t* i2c, const platform_i2c_config_t* config, int retries )
+{
+  UNUSED_PARAMETER( i2c );
+  UNUSED_PARAMETER( config );
+  UNUSED_PARAMETER( retries );
+  return false;
+}
+
+OSStatus platform_i2c_init_tx_message( platform_i2c_message_t* message, const void* tx_buffer, uint16_t tx_buffer_length, uint16_t retries )
+{
+  UNUSED_PARAMETER( message );
+  UNUSED_PARAMETER( tx_buffer );
+  UNUSED_PARAMETER( tx_buffer_length );
+  UNUSED_PARAMETER( retries );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_i2c_init_rx_message( platform_i2c_message_t* message, void* rx_buffer, uint16_t rx_buffer_length, uint16_t retries )
+{
+  UNUSED_PARAMETER( message );
+  UNUSED_PARAMETER( rx_buffer );
+  UNUSED_PARAMETER( rx_buffer_length );
+  UNUSED_PARAMETER( retries );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_i2c_init_combined_message( platform_i2c_message_t* message, const void* tx_buffer, void* rx_buffer, uint16_t tx_buffer_length, uint16_t rx_buffer_length, uint16_t retries )
+{
+  UNUSED_PARAMETER( message );
+  UNUSED_PARAMETER( tx_buffer );
+  UNUSED_PARAMETER( rx_buffer );
+  UNUSED_PARAMETER( tx_buffer_length );
+  UNUSED_PARAMETER( rx_buffer_length );
+  UNUSED_PARAMETER( retries );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_i2c_transfer( const platform_i2c_t* i2c, const platform_i2c_config_t* config, platform_i2c_message_t* messages, uint16_t number_of_messages )
+{
+  UNUSED_PARAMETER( i2c );
+  UNUSED_PARAMETER( config );
+  UNUSED_PARAMETER( messages );
+  UNUSED_PARAMETER( number_of_messages );
+  return kUnsupportedErr;
+}
+
+/******************************************************
+*                      RTC
+******************************************************/
+
+OSStatus platform_rtc_get_time( platform_rtc_time_t* time )
+{
+  UNUSED_PARAMETER( time );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_rtc_set_time( const platform_rtc_time_t* time )
+{
+  UNUSED_PARAMETER( time );
+  return kUnsupportedErr;
+}
+
+OSStatus platform_rtc_set_drift( int32_t drift_ppb )
+{
+  UNUSED_PARAMETER( drift_ppb );
+  return kUnsupportedErr;
+}
@@ -0,0 +1,447 @@
+/**
+******************************************************************************
+* @file    platform_host.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides the host services used by the Linux simulation port.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+/* Only system headers here, see platform_host.h */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <malloc.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <arpa/inet.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+#include "platform_host.h"
+
+/* These names are taken by the MICO socket API in this port, so the kernel is
+ * called directly instead of through the C library wrappers. */
+#define _sys_socket( d, t, p )         syscall( SYS_socket, d, t, p )
+#define _sys_bind( fd, a, l )          syscall( SYS_bind, fd, a, l )
+#define _sys_connect( fd, a, l )       syscall( SYS_connect, fd, a, l )
+#define _sys_listen( fd, b )           syscall( SYS_listen, fd, b )
+#define _sys_accept( fd, a, l )        syscall( SYS_accept4, fd, a, l, SOCK_CLOEXEC )
+#define _sys_sendto( fd, b, n, f, a, l ) syscall( SYS_sendto, fd, b, n, f, a, l )
+#define _sys_recvfrom( fd, b, n, f, a, l ) syscall( SYS_recvfrom, fd, b, n, f, a, l )
+#define _sys_setsockopt( fd, lv, o, v, l ) syscall( SYS_setsockopt, fd, lv, o, v, l )
+#define _sys_getsockopt( fd, lv, o, v, l ) syscall( SYS_getsockopt, fd, lv, o, v, l )
+#define _sys_read( fd, b, n )          syscall( SYS_read, fd, b, n )
+#define _sys_write( fd, b, n )         syscall( SYS_write, fd, b, n )
+#define _sys_close( fd )               syscall( SYS_close, fd )
+
+static void _fill_addr( struct sockaddr_in* addr, uint32_t ip, uint16_t port )
+{
+  memset( addr, 0x0, sizeof(struct sockaddr_in) );
+  addr->sin_family = AF_INET;
+  addr->sin_port = htons( port );
+  addr->sin_addr.s_addr = htonl( ip );
+}
+
+int host_socket( int udp )
+{
+  return (int)_sys_socket( AF_INET, ( udp ? SOCK_DGRAM : SOCK_STREAM ) | SOCK_CLOEXEC, udp ? IPPROTO_UDP : IPPROTO_TCP );
+}
+
+int host_bind( int fd, uint32_t ip, uint16_t port )
+{
+  struct sockaddr_in addr;
+  _fill_addr( &addr, ip, port );
+  return (int)_sys_bind( fd, &addr, sizeof(addr) );
+}
+
+int host_connect( int fd, uint32_t ip, uint16_t port )
+{
+  struct sockaddr_in addr;
+  _fill_addr( &addr, ip, port );
+  return (int)_sys_connect( fd, &addr, sizeof(addr) );
+}
+
+int host_listen( int fd, int backlog )
+{
+  return (int)_sys_listen( fd, backlog );
+}
+
+int host_accept( int fd, uint32_t* ip, uint16_t* port )
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  int client = (int)_sys_accept( fd, &addr, &len );
+
+  if ( client >= 0 ) {
+    if ( ip )   *ip = ntohl( addr.sin_addr.s_addr );
+    if ( port ) *port = ntohs( addr.sin_port );
+  }
+  return client;
+}
+
+int host_send( int fd, const void* buf, size_t len )
+{
+  return (int)_sys_sendto( fd, buf, len, MSG_NOSIGNAL, NULL, 0 );
+}
+
+int host_sendto( int fd, const void* buf, size_t len, uint32_t ip, uint16_t port )
+{
+  struct sockaddr_in addr;
+  _fill_addr( &addr, ip, port );
+  return (int)_sys_sendto( fd, buf, len, MSG_NOSIGNAL, &addr, sizeof(addr) );
+}
+
+int host_recv( int fd, void* buf, size_t len )
+{
+  return (int)_sys_recvfrom( fd, buf, len, 0, NULL, NULL );
+}
+
+int host_recvfrom( int fd, void* buf, size_t len, uint32_t* ip, uint16_t* port )
+{
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof(addr);
+  int ret = (int)_sys_recvfrom( fd, buf, len, 0, &addr, &addr_len );
+
+  if ( ret >= 0 ) {
+    if ( ip )   *ip = ntohl( addr.sin_addr.s_addr );
+    if ( port ) *port = ntohs( addr.sin_port );
+  }
+  return ret;
+}
+
+int host_set_reuseaddr( int fd, int enable )
+{
+  return (int)_sys_setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable) );
+}
+
+int host_set_broadcast( int fd, int enable )
+{
+  return (int)_sys_setsockopt( fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable) );
+}
+
+int host_set_multicast( int fd, uint32_t group, int join )
+{
+  struct ip_mreq mreq;
+  unsigned char loop = 1;
+
+  mreq.imr_multiaddr.s_addr = htonl( group );
+  mreq.imr_interface.s_addr = htonl( INADDR_ANY );
+  _sys_setsockopt( fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop) );
+  return (int)_sys_setsockopt( fd, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq) );
+}
+
+int host_set_nonblock( int fd, int enable )
+{
+  int flags = fcntl( fd, F_GETFL, 0 );
+  if ( flags < 0 )
+    return -1;
+  flags = enable ? ( flags | O_NONBLOCK ) : ( flags & ~O_NONBLOCK );
+  return fcntl( fd, F_SETFL, flags );
+}
+
+int host_set_timeout( int fd, int send, uint32_t timeout_ms )
+{
+  struct timeval tv;
+  tv.tv_sec = timeout_ms / 1000;
+  tv.tv_usec = ( timeout_ms % 1000 ) * 1000;
+  return (int)_sys_setsockopt( fd, SOL_SOCKET, send ? SO_SNDTIMEO : SO_RCVTIMEO, &tv, sizeof(tv) );
+}
+
+int host_set_keepalive( int fd, int max_error_count, int interval_seconds )
+{
+  int enable = 1;
+
+  if ( _sys_setsockopt( fd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable) ) < 0 )
+    return -1;
+  _sys_setsockopt( fd, IPPROTO_TCP, TCP_KEEPIDLE, &interval_seconds, sizeof(interval_seconds) );
+  _sys_setsockopt( fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval_seconds, sizeof(interval_seconds) );
+  return (int)_sys_setsockopt( fd, IPPROTO_TCP, TCP_KEEPCNT, &max_error_count, sizeof(max_error_count) );
+}
+
+int host_get_error( int fd )
+{
+  int err = 0;
+  socklen_t len = sizeof(err);
+
+  if ( _sys_getsockopt( fd, SOL_SOCKET, SO_ERROR, &err, &len ) < 0 )
+    return errno;
+  return err;
+}
+
+int host_resolve( const char* name, uint32_t* ip )
+{
+  struct addrinfo hints, *result = NULL;
+  int err;
+
+  memset( &hints, 0x0, sizeof(hints) );
+  hints.ai_family = AF_INET;
+  err = getaddrinfo( name, NULL, &hints, &result );
+  if ( err != 0 || result == NULL )
+    return -1;
+
+  *ip = ntohl( ((struct sockaddr_in*) result->ai_addr)->sin_addr.s_addr );
+  freeaddrinfo( result );
+  return 0;
+}
+
+int host_poll( host_pollfd_t* fds, int count, int timeout_ms )
+{
+  struct pollfd pfds[count > 0 ? count : 1];
+  int a, ret;
+
+  for ( a = 0; a < count; ++a ) {
+    pfds[a].fd = fds[a].fd;
+    pfds[a].events = ( ( fds[a].events & HOST_POLL_IN ) ? POLLIN : 0 ) | ( ( fds[a].events & HOST_POLL_OUT ) ? POLLOUT : 0 );
+    pfds[a].revents = 0;
+  }
+
+  do {
+    ret = poll( pfds, count, timeout_ms );
+  } while ( ret < 0 && errno == EINTR );
+
+  for ( a = 0; a < count; ++a ) {
+    fds[a].revents = 0;
+    if ( pfds[a].revents & ( POLLIN | POLLHUP ) )   fds[a].revents |= HOST_POLL_IN;
+    if ( pfds[a].revents & POLLOUT )                fds[a].revents |= HOST_POLL_OUT;
+    if ( pfds[a].revents & ( POLLERR | POLLNVAL ) ) fds[a].revents |= HOST_POLL_ERR;
+  }
+  return ret;
+}
+
+int host_errno( void )
+{
+  return errno;
+}
+
+int host_read( int fd, void* buf, size_t len )
+{
+  return (int)_sys_read( fd, buf, len );
+}
+
+int host_write( int fd, const void* buf, size_t len )
+{
+  return (int)_sys_write( fd, buf, len );
+}
+
+int host_close( int fd )
+{
+  return (int)_sys_close( fd );
+}
+
+int host_event_open( void )
+{
+  return eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+}
+
+void host_event_signal( int fd )
+{
+  eventfd_write( fd, 1 );
+}
+
+void host_event_clear( int fd )
+{
+  eventfd_t value;
+  eventfd_read( fd, &value );
+}
+
+int host_pty_open( const char* link_path, char* slave_name, size_t slave_name_len )
+{
+  struct termios tio;
+  int master, slave;
+
+  master = posix_openpt( O_RDWR | O_NOCTTY | O_CLOEXEC );
+  if ( master < 0 )
+    return -1;
+  if ( grantpt( master ) < 0 || unlockpt( master ) < 0 || ptsname_r( master, slave_name, slave_name_len ) != 0 )
+    goto error;
+  if ( host_set_nonblock( master, 1 ) < 0 )
+    goto error;
+
+  /* Raw mode, set through the slave and keep it open so the master never sees EIO when no terminal is attached */
+  slave = open( slave_name, O_RDWR | O_NOCTTY | O_CLOEXEC );
+  if ( slave < 0 )
+    goto error;
+  if ( tcgetattr( slave, &tio ) == 0 ) {
+    cfmakeraw( &tio );
+    tcsetattr( slave, TCSANOW, &tio );
+  }
+
+  if ( link_path != NULL ) {
+    unlink( link_path );
+    if ( symlink( slave_name, link_path ) < 0 )
+      fprintf( stderr, "Cannot link %s to %s: %s\r\n", link_path, slave_name, strerror( errno ) );
+  }
+  return master;
+
+error:
+  _sys_close( master );
+  return -1;
+}
+
+void host_pty_close( int fd, const char* link_path )
+{
+  _sys_close( fd );
+  if ( link_path != NULL )
+    unlink( link_path );
+}
+
+void* host_map_file( const char* path, size_t size, uint8_t fill )
+{
+  struct stat st;
+  uint8_t* image;
+  size_t old_size;
+  int fd;
+
+  fd = open( path, O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+  if ( fd < 0 )
+    return NULL;
+  if ( fstat( fd, &st ) < 0 || ( (size_t) st.st_size < size && ftruncate( fd, size ) < 0 ) ) {
+    _sys_close( fd );
+    return NULL;
+  }
+  old_size = (size_t) st.st_size < size ? (size_t) st.st_size : size;
+
+  image = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  _sys_close( fd );
+  if ( image == MAP_FAILED )
+    return NULL;
+
+  memset( image + old_size, fill, size - old_size );
+  return image;
+}
+
+void host_sync_file( void* image, size_t size )
+{
+  msync( image, size, MS_SYNC );
+}
+
+void host_unmap_file( void* image, size_t size )
+{
+  msync( image, size, MS_SYNC );
+  munmap( image, size );
+}
+
+int host_get_interface( uint32_t* ip, uint32_t* mask, uint32_t* broadcast, uint8_t mac[6] )
+{
+  struct ifaddrs *list, *ifa, *link;
+  int ret = -1;
+
+  if ( getifaddrs( &list ) != 0 )
+    return -1;
+
+  for ( ifa = list; ifa != NULL; ifa = ifa->ifa_next ) {
+    if ( ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET )
+      continue;
+    if ( ( ifa->ifa_flags & IFF_UP ) == 0 || ( ifa->ifa_flags & IFF_LOOPBACK ) )
+      continue;
+
+    *ip = ntohl( ((struct sockaddr_in*) ifa->ifa_addr)->sin_addr.s_addr );
+    *mask = ifa->ifa_netmask ? ntohl( ((struct sockaddr_in*) ifa->ifa_netmask)->sin_addr.s_addr ) : 0;
+    *broadcast = ( *ip & *mask ) | ~*mask;
+    memset( mac, 0x0, 6 );
+    for ( link = list; link != NULL; link = link->ifa_next ) {
+      if ( link->ifa_addr != NULL && link->ifa_addr->sa_family == AF_PACKET && strcmp( link->ifa_name, ifa->ifa_name ) == 0 ) {
+        memcpy( mac, ((struct sockaddr_ll*) link->ifa_addr)->sll_addr, 6 );
+        break;
+      }
+    }
+    ret = 0;
+    break;
+  }
+
+  freeifaddrs( list );
+  return ret;
+}
+
+int host_get_nameserver( uint32_t* ip )
+{
+  char line[128], addr[64];
+  struct in_addr in;
+  FILE* conf;
+  int ret = -1;
+
+  conf = fopen( "/etc/resolv.conf", "r" );
+  if ( conf == NULL )
+    return -1;
+
+  while ( fgets( line, sizeof(line), conf ) != NULL ) {
+    if ( sscanf( line, "nameserver %63s", addr ) == 1 && inet_pton( AF_INET, addr, &in ) == 1 ) {
+      *ip = ntohl( in.s_addr );
+      ret = 0;
+      break;
+    }
+  }
+
+  fclose( conf );
+  return ret;
+}
+
+void host_memory_info( size_t* total, size_t* allocated, size_t* available, size_t* chunks )
+{
+  struct mallinfo2 info = mallinfo2( );
+
+  *total = info.arena + info.hblkhd;
+  *allocated = info.uordblks + info.hblkhd;
+  *available = info.fordblks;
+  *chunks = info.ordblks;
+}
+
+int host_random( void* buf, size_t len )
+{
+  uint8_t* p = buf;
+  long ret;
+
+  while ( len > 0 ) {
+    ret = syscall( SYS_getrandom, p, len, 0 );
+    if ( ret < 0 ) {
+      if ( errno == EINTR )
+        continue;
+      return -1;
+    }
+    p += ret;
+    len -= ret;
+  }
+  return 0;
+}
+
+void host_exit( int status )
+{
+  fflush( stdout );
+  exit( status );
+}
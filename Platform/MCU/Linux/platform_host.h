@@ -0,0 +1,123 @@
+/**
+******************************************************************************
+* @file    platform_host.h
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides the host services used by the Linux simulation port.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The Linux port defines the MICO socket API (socket, read, write, close,
+ * select...) under the same names as the C library, so the host side lives
+ * in platform_host.c which only includes system headers and never calls those
+ * names directly. Everything here uses plain C types, addresses and ports are
+ * in host byte order like struct sockaddr_t. */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define HOST_POLL_IN      (0x1)
+#define HOST_POLL_OUT     (0x2)
+#define HOST_POLL_ERR     (0x4)
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+typedef struct
+{
+  int fd;
+  int events;
+  int revents;
+} host_pollfd_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+/* Sockets, return -1 and set the error returned by host_errno() on failure */
+int  host_socket          ( int udp );
+int  host_bind            ( int fd, uint32_t ip, uint16_t port );
+int  host_connect         ( int fd, uint32_t ip, uint16_t port );
+int  host_listen          ( int fd, int backlog );
+int  host_accept          ( int fd, uint32_t* ip, uint16_t* port );
+int  host_send            ( int fd, const void* buf, size_t len );
+int  host_sendto          ( int fd, const void* buf, size_t len, uint32_t ip, uint16_t port );
+int  host_recv            ( int fd, void* buf, size_t len );
+int  host_recvfrom        ( int fd, void* buf, size_t len, uint32_t* ip, uint16_t* port );
+int  host_set_reuseaddr   ( int fd, int enable );
+int  host_set_broadcast   ( int fd, int enable );
+int  host_set_multicast   ( int fd, uint32_t group, int join );
+int  host_set_nonblock    ( int fd, int enable );
+int  host_set_timeout     ( int fd, int send, uint32_t timeout_ms );
+int  host_set_keepalive   ( int fd, int max_error_count, int interval_seconds );
+int  host_get_error       ( int fd );
+int  host_resolve         ( const char* name, uint32_t* ip );
+int  host_poll            ( host_pollfd_t* fds, int count, int timeout_ms );
+int  host_errno           ( void );
+
+/* File descriptors */
+int  host_read            ( int fd, void* buf, size_t len );
+int  host_write           ( int fd, const void* buf, size_t len );
+int  host_close           ( int fd );
+
+/* Readable while signalled, used to select() on MICO RTOS objects */
+int  host_event_open      ( void );
+void host_event_signal    ( int fd );
+void host_event_clear     ( int fd );
+
+/* Pseudo terminal in raw mode, the slave path is linked to link_path when given */
+int  host_pty_open        ( const char* link_path, char* slave_name, size_t slave_name_len );
+void host_pty_close       ( int fd, const char* link_path );
+
+/* Shared mapping of a file of the given size, new space reads as erased flash */
+void* host_map_file       ( const char* path, size_t size, uint8_t fill );
+void  host_sync_file      ( void* image, size_t size );
+void  host_unmap_file     ( void* image, size_t size );
+
+/* The first IPv4 interface that is up and not a loopback, addresses in host byte order */
+int  host_get_interface   ( uint32_t* ip, uint32_t* mask, uint32_t* broadcast, uint8_t mac[6] );
+/* The first nameserver of the host resolver */
+int  host_get_nameserver  ( uint32_t* ip );
+/* Heap statistics of the C library allocator */
+void host_memory_info     ( size_t* total, size_t* allocated, size_t* available, size_t* chunks );
+
+int  host_random          ( void* buf, size_t len );
+void host_exit            ( int status );
+
+#ifdef __cplusplus
+} /*extern "C" */
+#endif
@@ -0,0 +1,159 @@
+/**
+******************************************************************************
+* @file    platform_init.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   This file provides start up, reset, watchdog and powersave functions for the Linux simulation port.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/ 
+
+#include "platform_peripheral.h"
+#include "platform.h"
+#include "platform_config.h"
+#include "MicoPlatform.h"
+#include "PlatformLogging.h"
+#include "MicoDefaults.h"
+#include "MICORTOS.h"
+#include "platform_host.h"
+
+/******************************************************
+*                    Constants
+******************************************************/
+
+#ifndef STDIO_BUFFER_SIZE
+#define STDIO_BUFFER_SIZE   64
+#endif
+
+/******************************************************
+*               Function Declarations
+******************************************************/
+
+extern void init_platform( void );
+
+/******************************************************
+*               Variables Definitions
+******************************************************/
+
+extern const platform_uart_t platform_uart_peripherals[];
+extern platform_uart_driver_t platform_uart_drivers[];
+
+/* mico_cpu_clock_hz is used by MICO RTOS, it has no meaning on the host */
+const uint32_t  mico_cpu_clock_hz = 1000000000;
+
+/* printf() goes to the host stdout, STDIO_UART is still opened for the CLI and MFG test */
+static const platform_uart_config_t stdio_uart_config =
+{
+  .baud_rate    = STDIO_UART_BAUDRATE,
+  .data_width   = DATA_WIDTH_8BIT,
+  .parity       = NO_PARITY,
+  .stop_bits    = STOP_BITS_1,
+  .flow_control = FLOW_CONTROL_DISABLED,
+  .flags        = 0,
+};
+
+static ring_buffer_t stdio_rx_buffer;
+static uint8_t       stdio_rx_data[STDIO_BUFFER_SIZE];
+mico_mutex_t        stdio_rx_mutex;
+mico_mutex_t        stdio_tx_mutex;
+
+/******************************************************
+*               Function Definitions
+******************************************************/
+
+void platform_mcu_reset( void )
+{
+  platform_log( "MCU reset" );
+  host_exit( 0 );
+}
+
+void init_clocks( void )
+{
+}
+
+WEAK void init_memory( void )
+{
+}
+
+void init_architecture( void )
+{
+  mico_rtos_init_mutex( &stdio_tx_mutex );
+  mico_rtos_init_mutex( &stdio_rx_mutex );
+
+  ring_buffer_init( &stdio_rx_buffer, stdio_rx_data, STDIO_BUFFER_SIZE );
+  platform_uart_init( &platform_uart_drivers[STDIO_UART], &platform_uart_peripherals[STDIO_UART], &stdio_uart_config, &stdio_rx_buffer );
+}
+
+/* There is no reset handler on the host, run the same sequence as crt0 before main() */
+__attribute__((constructor)) static void platform_start( void )
+{
+  init_clocks( );
+  init_memory( );
+  init_architecture( );
+  init_platform( );
+}
+
+/******************************************************
+*            Watchdog and powersave
+******************************************************/
+
+OSStatus platform_watchdog_init( uint32_t timeout_ms )
+{
+  UNUSED_PARAMETER( timeout_ms );
+  return kNoErr;
+}
+
+OSStatus platform_watchdog_kick( void )
+{
+  return kNoErr;
+}
+
+bool platform_watchdog_check_last_reset( void )
+{
+  return false;
+}
+
+OSStatus platform_mcu_powersave_enable( void )
+{
+  return kNoErr;
+}
+
+OSStatus platform_mcu_powersave_disable( void )
+{
+  return kNoErr;
+}
+
+void platform_mcu_powersave_exit_notify( void )
+{
+}
+
+/* Waking up from standby is a reset on the target */
+void platform_mcu_enter_standby( uint32_t secondsToWakeup )
+{
+  platform_log( "Standby for %u seconds", (unsigned int)secondsToWakeup );
+  if ( secondsToWakeup == MICO_WAIT_FOREVER )
+    host_exit( 0 );
+  mico_thread_sleep( secondsToWakeup );
+  platform_mcu_reset( );
+}
@@ -106,6 +106,13 @@ OSStatus platform_rtc_set_time( const platform_rtc_time_t* time )
   return kUnsupportedErr;
 }
 
+OSStatus platform_rtc_set_drift( int32_t drift_ppb )
+{
+  UNUSED_PARAMETER(drift_ppb);
+  platform_log("unimplemented");
+  return kUnsupportedErr;
+}
+
 
 
 
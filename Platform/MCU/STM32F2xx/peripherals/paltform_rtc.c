@@ -63,6 +63,9 @@ else \
 #define NUM_SECONDS_IN_MINUTE       ( 60 )
 #define NUM_SECONDS_IN_HOUR         ( 3600 )
 #define NUM_1P25MS_IN_SEC           ( 800 )
+#define COARSE_CALIB_STEPS          ( 31 )
+#define COARSE_CALIB_NEG_STEP_PPB   ( 2035 )  /* Calendar slowed down by 2.035ppm a step */
+#define COARSE_CALIB_POS_STEP_PPB   ( 4069 )  /* Calendar sped up by 4.069ppm a step */
 
 /******************************************************
 *                   Enumerations
@@ -271,6 +274,50 @@ OSStatus platform_rtc_set_time( const mico_rtc_time_t* time )
 #endif /* #ifdef MICO_ENABLE_MCU_RTC */
 }
 
+/**
+* This function will trim the RTC with its coarse digital calibration, from
+* -63ppm to +126ppm in steps of about 2ppm and 4ppm
+*
+* @return    kNoErr        : on success.
+* @return    kGeneralErr   : if the RTC could not enter its initialisation mode
+*/
+OSStatus platform_rtc_set_drift( int32_t drift_ppb )
+{
+#ifdef MICO_ENABLE_MCU_RTC
+  uint32_t sign;
+  uint32_t value;
+
+  if( drift_ppb >= 0 )
+  {
+    /* Runs fast, slow the calendar down */
+    sign  = RTC_CalibSign_Negative;
+    value = ( (uint32_t)drift_ppb + COARSE_CALIB_NEG_STEP_PPB / 2 ) / COARSE_CALIB_NEG_STEP_PPB;
+  }
+  else
+  {
+    sign  = RTC_CalibSign_Positive;
+    value = ( (uint32_t)( -drift_ppb ) + COARSE_CALIB_POS_STEP_PPB / 2 ) / COARSE_CALIB_POS_STEP_PPB;
+  }
+  if( value > COARSE_CALIB_STEPS )
+  {
+    value = COARSE_CALIB_STEPS;
+  }
+
+  if( value == 0 )
+  {
+    return ( RTC_CoarseCalibCmd( DISABLE ) == SUCCESS ) ? kNoErr : kGeneralErr;
+  }
+  if( RTC_CoarseCalibConfig( sign, value ) != SUCCESS )
+  {
+    return kGeneralErr;
+  }
+  return ( RTC_CoarseCalibCmd( ENABLE ) == SUCCESS ) ? kNoErr : kGeneralErr;
+#else /* #ifdef MICO_ENABLE_MCU_RTC */
+  UNUSED_PARAMETER(drift_ppb);
+  return kUnsupportedErr;
+#endif /* #ifdef MICO_ENABLE_MCU_RTC */
+}
+
 OSStatus platform_rtc_enter_powersave ( void )
 {
 
@@ -62,6 +62,9 @@ else \
 #define NUM_SECONDS_IN_MINUTE       ( 60 )
 #define NUM_SECONDS_IN_HOUR         ( 3600 )
 #define NUM_1P25MS_IN_SEC           ( 800 )
+#define SMOOTH_CALIB_MAX_PULSES     ( 511 )
+#define SMOOTH_CALIB_PLUS_PULSES    ( 512 )
+#define SMOOTH_CALIB_MAX_PPB        ( 488000 )
 
 /******************************************************
 *                   Enumerations
@@ -270,6 +273,54 @@ OSStatus platform_rtc_set_time( const platform_rtc_time_t* time )
 #endif /* #ifdef MICO_ENABLE_MCU_RTC */
 }
 
+/**
+* This function will trim the RTC with its smooth digital calibration. Every
+* pulse masked out of the 2^20 of a 32s cycle slows the RTC down by 0.954ppm,
+* from -487ppm to +488ppm.
+*
+* @return    kNoErr        : on success.
+* @return    kGeneralErr   : if a previous calibration is still pending
+*/
+OSStatus platform_rtc_set_drift( int32_t drift_ppb )
+{
+#ifdef MICO_ENABLE_MCU_RTC
+  uint32_t plus;
+  uint32_t pulses;
+
+  if( drift_ppb > SMOOTH_CALIB_MAX_PPB )
+  {
+    drift_ppb = SMOOTH_CALIB_MAX_PPB;
+  }
+  else if( drift_ppb < -SMOOTH_CALIB_MAX_PPB )
+  {
+    drift_ppb = -SMOOTH_CALIB_MAX_PPB;
+  }
+
+  /* ppb * 2^20 / 10^9 */
+  if( drift_ppb >= 0 )
+  {
+    plus   = RTC_SmoothCalibPlusPulses_Reset;
+    pulses = ( (uint32_t)drift_ppb * 128 + 61035 ) / 122070;
+  }
+  else
+  {
+    /* Runs slow, add 512 pulses and mask out the ones too many */
+    plus   = RTC_SmoothCalibPlusPulses_Set;
+    pulses = ( (uint32_t)( -drift_ppb ) * 128 + 61035 ) / 122070;
+    pulses = ( pulses < SMOOTH_CALIB_PLUS_PULSES ) ? SMOOTH_CALIB_PLUS_PULSES - pulses : 0;
+  }
+  if( pulses > SMOOTH_CALIB_MAX_PULSES )
+  {
+    pulses = SMOOTH_CALIB_MAX_PULSES;
+  }
+
+  return ( RTC_SmoothCalibConfig( RTC_SmoothCalibPeriod_32sec, plus, pulses ) == SUCCESS ) ? kNoErr : kGeneralErr;
+#else /* #ifdef MICO_ENABLE_MCU_RTC */
+  UNUSED_PARAMETER(drift_ppb);
+  return kUnsupportedErr;
+#endif /* #ifdef MICO_ENABLE_MCU_RTC */
+}
+
 OSStatus platform_rtc_enter_powersave ( void )
 {
 
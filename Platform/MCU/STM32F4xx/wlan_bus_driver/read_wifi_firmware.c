@@ -55,32 +55,165 @@ uint32_t platform_get_wifi_image(unsigned char* buffer, uint32_t size, uint32_t
 
 #else
 
-static uint32_t image_size = DRIVER_FLASH_SIZE;
+#include "PlatformLogging.h"
+
+#define WIFI_IMAGE_HEADER_MAGIC     0x46574D58  /* "XMWF" */
+#define WIFI_IMAGE_HEADER_VERSION   1
+#define WIFI_IMAGE_READ_AHEAD       2048
+#define WIFI_IMAGE_SCAN_SIZE        256
+
+/* Optional header at the start of the DRIVER partition, the image follows it.
+ * Projects/Linux/tools/wifi_image_header.c puts it in front of an RF driver .bin.
+ * Images written without one are measured by scanning back from the end of the
+ * partition for the last word that is not erased. */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;   /* The image starts this far into the partition */
+    uint32_t length;
+    uint16_t crc;           /* CRC16-CCITT of the image, initial value 0 */
+    uint16_t reserved;
+} wifi_image_header_t;
+
+static uint32_t image_start = DRIVER_START_ADDRESS;
+static uint32_t image_size = 0;
+static bool     image_has_crc = false;
+static uint16_t image_crc;
+static uint16_t image_crc_running;
+static uint32_t image_crc_offset;
+
+/* The driver reads the image in small pieces, front to back */
+static uint8_t* read_ahead = NULL;
+static uint32_t read_ahead_offset;
+static uint32_t read_ahead_length = 0;
+
+static const uint16_t crc16_nibble_table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static uint16_t wifi_image_crc16( uint16_t crc, const uint8_t* data, uint32_t length )
+{
+    while ( length-- )
+    {
+        crc = (uint16_t) ( ( crc << 4 ) ^ crc16_nibble_table[ ( crc >> 12 ) ^ ( *data >> 4 ) ] );
+        crc = (uint16_t) ( ( crc << 4 ) ^ crc16_nibble_table[ ( crc >> 12 ) ^ ( *data & 0x0F ) ] );
+        data++;
+    }
+    return crc;
+}
+
+static uint32_t wifi_image_scan_size( void )
+{
+    uint32_t FlashAddress;
+    uint32_t end = DRIVER_FLASH_SIZE;
+    uint32_t chunk, i;
+    uint32_t words[WIFI_IMAGE_SCAN_SIZE/4];
+
+    while ( end > 0 )
+    {
+        chunk = MIN( end, sizeof(words) );
+        FlashAddress = DRIVER_START_ADDRESS + end - chunk;
+        MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, (uint8_t *)words, chunk);
+        for ( i = chunk/4; i > 0; i-- )
+        {
+            if ( words[i - 1] != 0xFFFFFFFF )
+                return end - chunk + i*4;
+        }
+        end -= chunk;
+    }
+    return 0;
+}
 
 uint32_t platform_get_wifi_image_size(void)
 {
-    uint32_t FlashAddress = DRIVER_START_ADDRESS + DRIVER_FLASH_SIZE - 0x4;
-    uint32_t imageTail;
-
-    MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, (uint8_t *)&imageTail, 4);
-    while(imageTail == 0xFFFFFFFF) {
-        image_size-= 4;
-        FlashAddress -=8;
-        MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, (uint8_t *)&imageTail, 4);
+    uint32_t FlashAddress = DRIVER_START_ADDRESS;
+    wifi_image_header_t header;
+
+    if ( image_size != 0 )
+        return image_size;
+
+    MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, (uint8_t *)&header, sizeof(header));
+    if ( header.magic == WIFI_IMAGE_HEADER_MAGIC && header.version >= WIFI_IMAGE_HEADER_VERSION &&
+         header.header_size >= sizeof(header) && header.length <= DRIVER_FLASH_SIZE - header.header_size )
+    {
+        image_start   = DRIVER_START_ADDRESS + header.header_size;
+        image_size    = header.length;
+        image_crc     = header.crc;
+        image_has_crc = true;
+    }
+    else
+    {
+        image_start   = DRIVER_START_ADDRESS;
+        image_size    = wifi_image_scan_size( );
+        image_has_crc = false;
     }
-    
+
     return image_size;
 }
 
 uint32_t platform_get_wifi_image(unsigned char* buffer, uint32_t size, uint32_t offset)
 {
     uint32_t buffer_size;
-    uint32_t FlashAddress = DRIVER_START_ADDRESS;
-    
+    uint32_t FlashAddress;
+
+    if ( image_size == 0 )
+        platform_get_wifi_image_size( );
+    if ( offset >= image_size )
+        return 0;
     buffer_size = MIN(size, (image_size - offset));
-    FlashAddress += offset;
 
-    MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, buffer, buffer_size);
+    if ( offset >= read_ahead_offset && offset + buffer_size <= read_ahead_offset + read_ahead_length )
+    {
+        memcpy( buffer, &read_ahead[offset - read_ahead_offset], buffer_size );
+    }
+    else if ( buffer_size < WIFI_IMAGE_READ_AHEAD && ( read_ahead != NULL || ( read_ahead = malloc( WIFI_IMAGE_READ_AHEAD ) ) != NULL ) )
+    {
+        read_ahead_offset = offset;
+        read_ahead_length = MIN( WIFI_IMAGE_READ_AHEAD, image_size - offset );
+        FlashAddress = image_start + offset;
+        MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, read_ahead, read_ahead_length);
+        memcpy( buffer, read_ahead, buffer_size );
+    }
+    else
+    {
+        FlashAddress = image_start + offset;
+        MicoFlashRead(MICO_FLASH_FOR_DRIVER, &FlashAddress, buffer, buffer_size);
+    }
+
+    /* Check the CRC on the way through, a download restarts from offset 0. On a
+       mismatch the last piece is not handed out: the download comes up short and
+       the Wi-Fi driver fails to start the radio instead of booting a corrupt image.
+       The header is read again on the next attempt */
+    if ( image_has_crc == true )
+    {
+        if ( offset == 0 )
+        {
+            image_crc_running = 0;
+            image_crc_offset = 0;
+        }
+        if ( offset == image_crc_offset )
+        {
+            image_crc_running = wifi_image_crc16( image_crc_running, buffer, buffer_size );
+            image_crc_offset += buffer_size;
+            if ( image_crc_offset == image_size && image_crc_running != image_crc )
+            {
+                platform_log("Wi-Fi firmware image CRC error");
+                image_size = 0;
+                buffer_size = 0;
+            }
+        }
+    }
+
+    if ( ( buffer_size == 0 || offset + buffer_size == image_size ) && read_ahead != NULL )
+    {
+        free( read_ahead );
+        read_ahead = NULL;
+        read_ahead_length = 0;
+    }
+
     return buffer_size;
 }
 #endif
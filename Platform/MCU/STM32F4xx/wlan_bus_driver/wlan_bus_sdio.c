@@ -37,6 +37,7 @@
 #include "platform_peripheral.h"
 #include "PlatformLogging.h"
 #include "wlan_platform_common.h"
+#include "wlan_bus_sdio_dma.h"
 
 /******************************************************
  *             Constants
@@ -150,7 +151,6 @@ static uint32_t                     current_command;
  ******************************************************/
 
 static uint32_t          sdio_get_blocksize_dctrl   ( sdio_block_size_t block_size );
-static sdio_block_size_t find_optimal_block_size    ( uint32_t data_size );
 static void              sdio_prepare_data_transfer ( bus_transfer_direction_t direction, sdio_block_size_t block_size, /*@unique@*/ uint8_t* data, uint16_t data_size ) /*@modifies dma_data_source, user_data, user_data_size, dma_transfer_size@*/;
 
 void dma_irq ( void );
@@ -477,7 +477,7 @@ restart:
         /* Dodgy STM32 hack to set the CMD53 byte mode size to be the same as the block size */
         if ( mode == SDIO_BYTE_MODE )
         {
-            block_size = find_optimal_block_size( data_size );
+            block_size = (sdio_block_size_t) sdio_byte_mode_block_size( data_size );
             if ( block_size < SDIO_512B_BLOCK )
             {
                 argument = ( argument & (uint32_t) ( ~0x1FF ) ) | block_size;
@@ -523,7 +523,7 @@ restart:
             }
         } while ( ( SDIO->STA & ( SDIO_STA_TXACT | SDIO_STA_RXACT ) ) != 0 );
 
-        if ( direction == BUS_READ )
+        if ( ( direction == BUS_READ ) && ( dma_data_source != user_data ) )
         {
             memcpy( user_data, dma_data_source, (size_t) user_data_size );
         }
@@ -565,17 +565,22 @@ exit:
 
 static void sdio_prepare_data_transfer( bus_transfer_direction_t direction, sdio_block_size_t block_size, /*@unique@*/ uint8_t* data, uint16_t data_size ) /*@modifies dma_data_source, user_data, user_data_size, dma_transfer_size@*/
 {
-    /* Setup a single transfer using the temp buffer */
+    /* Setup a single transfer, reads go through the temp buffer unless they can land in place */
     user_data         = data;
     user_data_size    = data_size;
-    dma_transfer_size = (uint32_t) ( ( ( data_size + (uint16_t) block_size - 1 ) / (uint16_t) block_size ) * (uint16_t) block_size );
+    dma_transfer_size = sdio_dma_transfer_size( data_size, (uint32_t) block_size );
 
     if ( direction == BUS_WRITE )
     {
         dma_data_source = data;
     }
+    else if ( sdio_dma_read_in_place( data, data_size, (uint32_t) block_size ) )
+    {
+        dma_data_source = data;
+    }
     else
     {
+        check_string( dma_transfer_size <= sizeof( temp_dma_buffer ), "SDIO read too large for the temp buffer" );
         dma_data_source = temp_dma_buffer;
     }
 
@@ -616,28 +621,6 @@ void host_platform_enable_high_speed_sdio( void )
     sdio_enable_bus_irq( );
 }
 
-static sdio_block_size_t find_optimal_block_size( uint32_t data_size )
-{
-    if ( data_size > (uint32_t) 256 )
-        return SDIO_512B_BLOCK;
-    if ( data_size > (uint32_t) 128 )
-        return SDIO_256B_BLOCK;
-    if ( data_size > (uint32_t) 64 )
-        return SDIO_128B_BLOCK;
-    if ( data_size > (uint32_t) 32 )
-        return SDIO_64B_BLOCK;
-    if ( data_size > (uint32_t) 16 )
-        return SDIO_32B_BLOCK;
-    if ( data_size > (uint32_t) 8 )
-        return SDIO_16B_BLOCK;
-    if ( data_size > (uint32_t) 4 )
-        return SDIO_8B_BLOCK;
-    if ( data_size > (uint32_t) 2 )
-        return SDIO_4B_BLOCK;
-
-    return SDIO_4B_BLOCK;
-}
-
 static uint32_t sdio_get_blocksize_dctrl(sdio_block_size_t block_size)
 {
     switch (block_size)
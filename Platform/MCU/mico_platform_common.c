@@ -35,7 +35,7 @@
 #include "platform_peripheral.h"
 #include "MicoPlatform.h"
 #include "platform_config.h"
-#include "platformLogging.h"
+#include "PlatformLogging.h"
 
 /******************************************************
 *                      Macros
@@ -331,6 +331,11 @@ OSStatus MicoRtcSetTime(mico_rtc_time_t* time)
   return (OSStatus) platform_rtc_set_time( time );
 }
 
+OSStatus MicoRtcSetDrift(int32_t drift_ppb)
+{
+  return (OSStatus) platform_rtc_set_drift( drift_ppb );
+}
+
 OSStatus MicoSpiInitialize( const mico_spi_device_t* spi )
 {
   platform_spi_config_t config;
@@ -758,6 +758,18 @@ OSStatus platform_rtc_get_time( platform_rtc_time_t* time );
 OSStatus platform_rtc_set_time( const platform_rtc_time_t* time );
 
 
+/**
+ * Trim the real-time clock for the error of its oscillator
+ *
+ * @param[in] drift_ppb : how much faster than real time the RTC runs, in parts
+ *                        per billion, negative when it runs slower. 0 removes the
+ *                        trim. The closest trim the hardware has is used.
+ *
+ * @return @ref OSStatus, kUnsupportedErr when the RTC can not be trimmed
+ */
+OSStatus platform_rtc_set_drift( int32_t drift_ppb );
+
+
 /**
  * Initialise UART standard I/O
  *
@@ -0,0 +1,47 @@
+/**
+******************************************************************************
+* @file    wlan_bus_sdio_dma.h
+* @brief   CMD53 transfer sizing shared by the STM32 SDIO bus drivers. No
+*          register access here, so the Linux-Sim host tests check it too.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The STM32 DPSM only moves whole blocks. A byte mode CMD53 uses the smallest
+   block that holds data_size, up to 512 bytes */
+static inline uint32_t sdio_byte_mode_block_size( uint32_t data_size )
+{
+    uint32_t block_size = 4;
+
+    while ( ( block_size < 512 ) && ( block_size < data_size ) )
+    {
+        block_size <<= 1;
+    }
+    return block_size;
+}
+
+/* Bytes the DPSM and the DMA move for data_size */
+static inline uint32_t sdio_dma_transfer_size( uint32_t data_size, uint32_t block_size )
+{
+    return ( ( data_size + block_size - 1 ) / block_size ) * block_size;
+}
+
+/* A read is DMA'd straight into the caller's buffer when the buffer is word aligned
+   and the transfer covers it exactly, so nothing lands past its end. Other reads
+   go through a bounce buffer */
+static inline bool sdio_dma_read_in_place( const void* data, uint32_t data_size, uint32_t block_size )
+{
+    return ( ( (uintptr_t) data & 0x3 ) == 0 ) && ( sdio_dma_transfer_size( data_size, block_size ) == data_size );
+}
+
+#ifdef __cplusplus
+} /*extern "C" */
+#endif
@@ -0,0 +1,74 @@
+/**
+******************************************************************************
+* @file    CommonServices.h
+* @brief   The parts of Apple's CommonServices.h and DebugServices.h that
+*          External/Curve25519/curve25519-donna-test.c uses, on top of the
+*          MICO Common.h and Debug.h, so test_curve25519 can build it as it is.
+******************************************************************************
+*/
+
+#ifndef __COMMON_SERVICES_H__
+#define __COMMON_SERVICES_H__
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "Common.h"
+#include "Debug.h"
+#include "host_test.h"
+
+#define countof( X )            ( sizeof( X ) / sizeof( X[ 0 ] ) )
+#define __ROUTINE__             __func__
+
+#define kHexToData_NoFlags      0
+
+typedef double CFAbsoluteTime;
+
+static inline CFAbsoluteTime CFAbsoluteTimeGetCurrent( void )
+{
+  return test_time_ns( ) / 1e9;
+}
+
+/* Hex digits to bytes, up to inMaxBytes of them. Only what the test vectors need:
+   no flags, no separators, inSize of kSizeCString for a C string. */
+static inline OSStatus HexToData( const char *inStr, size_t inSize, int inFlags, uint8_t *inBuf, size_t inMaxBytes,
+                                  size_t *outWrittenBytes, size_t *outTotalBytes, const char **outNext )
+{
+  size_t i, n = 0;
+  unsigned int byte;
+
+  (void) inFlags;
+  if( inSize == (size_t) -1 ) inSize = strlen( inStr );
+  for( i = 0; i + 1 < inSize && n < inMaxBytes; i += 2 )
+  {
+    if( sscanf( &inStr[ i ], "%2x", &byte ) != 1 ) return( kMalformedErr );
+    inBuf[ n++ ] = (uint8_t) byte;
+  }
+  if( outWrittenBytes ) *outWrittenBytes = n;
+  if( outTotalBytes ) *outTotalBytes = n;
+  if( outNext ) *outNext = &inStr[ i ];
+  return( kNoErr );
+}
+
+/* fprintf() with the "%###s" of a routine name taken as a plain "%s" */
+static inline int FPrintF( FILE *inFile, const char *inFormat, ... )
+{
+  char format[ 128 ];
+  const char *src;
+  char *dst;
+  va_list args;
+  int n;
+
+  for( src = inFormat, dst = format; *src && dst < &format[ sizeof( format ) - 1 ]; )
+  {
+    if( strncmp( src, "%###", 4 ) == 0 ) { *dst++ = '%'; src += 4; }
+    else *dst++ = *src++;
+  }
+  *dst = '\0';
+  va_start( args, inFormat );
+  n = vfprintf( inFile, format, args );
+  va_end( args );
+  return( n );
+}
+
+#endif
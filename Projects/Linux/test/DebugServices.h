@@ -0,0 +1,8 @@
+/**
+******************************************************************************
+* @file    DebugServices.h
+* @brief   Everything is in the CommonServices.h of this directory.
+******************************************************************************
+*/
+
+#include "CommonServices.h"
@@ -0,0 +1,18 @@
+/**
+******************************************************************************
+* @file    host_test.c
+* @brief   Symbols the MICO core library provides on a device.
+******************************************************************************
+*/
+
+#include <time.h>
+#include "host_test.h"
+
+int mico_debug_enabled = 0;
+
+unsigned long long test_time_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
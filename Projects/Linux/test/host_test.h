@@ -0,0 +1,22 @@
+/**
+******************************************************************************
+* @file    host_test.h
+* @brief   Checks shared by the host tests of the Linux-Sim port.
+******************************************************************************
+*/
+
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Stops the test with the failed condition and its line */
+#define test_check(cond) do { if (!(cond)) { \
+    printf("%s:%d: check failed: %s\r\n", __FILE__, __LINE__, #cond); \
+    exit(1); } } while (0)
+
+/* Time in ns from a monotonic clock, for the tests that measure */
+unsigned long long test_time_ns(void);
+
+#endif
@@ -0,0 +1,235 @@
+/**
+******************************************************************************
+* @file    test_aes_ctr.c
+* @brief   AES_CTR_Update against a block at a time, byte at a time CTR over
+*          random chunkings, misaligned and in-place buffers, counter wrap and
+*          legacy mode, and the throughput of each. AESUtils.c is built on the
+*          Gladman backend here, the MICO AES library only exists for the
+*          target.
+******************************************************************************
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "AESUtils.h"
+#include "host_test.h"
+
+#define MAX_LEN  4096
+
+/* CTR as AES_CTR_Update did it before the keystream was batched: one AES call
+ * per block, XOR a byte at a time. A legacy context throws away the rest of the
+ * last block at the end of every call, as AES_CTR_Update does. */
+typedef struct {
+  aes_encrypt_ctx ctx;
+  uint8_t ctr[16];
+  uint8_t buf[16];
+  size_t used;
+  int legacy;
+} ref_ctr_t;
+
+static void ref_init(ref_ctr_t *ref, const uint8_t *key, const uint8_t *nonce, int legacy)
+{
+  aes_init();
+  aes_encrypt_key128(key, &ref->ctx);
+  memcpy(ref->ctr, nonce, 16);
+  ref->used = 0;
+  ref->legacy = legacy;
+}
+
+static void ref_update(ref_ctr_t *ref, const uint8_t *src, size_t len, uint8_t *dst)
+{
+  size_t i;
+  int j;
+
+  for (i = 0; i < len; ++i) {
+    if (ref->used == 0) {
+      aes_encrypt(ref->ctr, ref->buf, &ref->ctx);
+      for (j = 15; j >= 0 && ++ref->ctr[j] == 0; --j)
+        ;
+    }
+    dst[i] = src[i] ^ ref->buf[ref->used];
+    ref->used = (ref->used + 1) % 16;
+  }
+  if (ref->legacy)
+    ref->used = 0;
+}
+
+static uint32_t seed = 0x1234567;
+
+static uint32_t rnd(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static const uint8_t key[16] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+/* NIST SP 800-38A F.5.1 CTR-AES128.Encrypt, its counter carries out of the low bytes */
+static void test_vector(void)
+{
+  static const uint8_t nonce[16] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+  };
+  static const uint8_t plain[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+  };
+  static const uint8_t cipher[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+  };
+  AES_CTR_Context ctx;
+  uint8_t out[64];
+
+  test_check(AES_CTR_Init(&ctx, key, nonce) == kNoErr);
+  test_check(AES_CTR_Update(&ctx, plain, 64, out) == kNoErr);
+  AES_CTR_Final(&ctx);
+  test_check(memcmp(out, cipher, 64) == 0);
+
+  /* And back, in place */
+  test_check(AES_CTR_Init(&ctx, key, nonce) == kNoErr);
+  test_check(AES_CTR_Update(&ctx, out, 64, out) == kNoErr);
+  AES_CTR_Final(&ctx);
+  test_check(memcmp(out, plain, 64) == 0);
+}
+
+/* One stream of len bytes cut into random chunks, each chunk at its own offsets
+ * from word alignment, against the reference */
+static void run(const uint8_t *nonce, size_t len, int max_chunk, int in_place, int legacy)
+{
+  static uint32_t src_words[MAX_LEN / 4 + 1], dst_words[MAX_LEN / 4 + 1];
+  static uint8_t plain[MAX_LEN], expect[MAX_LEN], out[MAX_LEN];
+  uint8_t *src = (uint8_t *)src_words, *dst = (uint8_t *)dst_words;
+  AES_CTR_Context ctx;
+  ref_ctr_t ref;
+  size_t pos, n, src_off, dst_off;
+
+  for (pos = 0; pos < len; ++pos)
+    plain[pos] = (uint8_t)rnd();
+  ref_init(&ref, key, nonce, legacy);
+  test_check(AES_CTR_Init(&ctx, key, nonce) == kNoErr);
+  ctx.legacy = legacy;
+
+  for (pos = 0; pos < len; pos += n) {
+    n = rnd() % (max_chunk + 1);
+    if (n > len - pos)
+      n = len - pos;
+    src_off = rnd() % 4;
+    dst_off = in_place ? src_off : rnd() % 4;
+    memcpy(src + src_off, plain + pos, n);
+    memset(dst, 0xA5, sizeof(dst_words));
+    test_check(AES_CTR_Update(&ctx, src + src_off, n, in_place ? src + src_off : dst + dst_off) == kNoErr);
+    memcpy(out + pos, in_place ? src + src_off : dst + dst_off, n);
+    /* Nothing written outside the chunk */
+    if (!in_place)
+      test_check(dst_off == 0 || dst[dst_off - 1] == 0xA5);
+    if (!in_place)
+      test_check(dst[dst_off + n] == 0xA5);
+    ref_update(&ref, plain + pos, n, expect + pos);
+  }
+  AES_CTR_Final(&ctx);
+  test_check(memcmp(out, expect, len) == 0);
+}
+
+static void test_chunks(void)
+{
+  uint8_t nonce[16];
+  int i, j, max_chunks[] = { 1, 15, 17, 64, 100, 1000 };
+
+  for (i = 0; i < 200; ++i) {
+    for (j = 0; j < 16; ++j)
+      nonce[j] = (uint8_t)rnd();
+    run(nonce, rnd() % MAX_LEN, max_chunks[i % 6], i & 1, 0);
+  }
+}
+
+/* Counters that carry through a byte, a word, and wrap all 128 bits to zero,
+ * reached in the middle of a keystream batch */
+static void test_wrap(void)
+{
+  uint8_t nonce[16];
+  int i, ones, legacy;
+
+  for (ones = 1; ones <= 16; ++ones) {
+    for (i = 0; i < 16; ++i)
+      nonce[i] = i < 16 - ones ? (uint8_t)(0x10 + i) : 0xFF;
+    /* The last counter before the carry, two blocks into a batch */
+    nonce[15] = 0xFD;
+    for (legacy = 0; legacy <= 1; ++legacy) {
+      run(nonce, 16 * 9, 16 * 9, 0, legacy);
+      run(nonce, 16 * 9 + 5, 7, 0, legacy);
+      run(nonce, 16 * 9 + 5, 40, 1, legacy);
+    }
+  }
+
+  /* All ones wraps to all zeros */
+  memset(nonce, 0xFF, 16);
+  for (i = 0; i < 20; ++i)
+    run(nonce, 100, 33, i & 1, 0);
+}
+
+static void test_legacy(void)
+{
+  uint8_t nonce[16];
+  int i, j;
+
+  for (i = 0; i < 50; ++i) {
+    for (j = 0; j < 16; ++j)
+      nonce[j] = (uint8_t)rnd();
+    run(nonce, rnd() % MAX_LEN, i % 2 ? 37 : 300, i & 1, 1);
+  }
+}
+
+/* MB/s of a 16 KB stream sent in chunks of the given size */
+static void bench(size_t chunk)
+{
+  static uint8_t buf[16384];
+  static const uint8_t nonce[16] = { 0 };
+  AES_CTR_Context ctx;
+  ref_ctr_t ref;
+  unsigned long long start, ctr_ns, ref_ns;
+  size_t pos;
+  int i, rounds = 100;
+
+  test_check(AES_CTR_Init(&ctx, key, nonce) == kNoErr);
+  start = test_time_ns();
+  for (i = 0; i < rounds; ++i)
+    for (pos = 0; pos < sizeof(buf); pos += chunk)
+      AES_CTR_Update(&ctx, buf + pos, chunk, buf + pos);
+  ctr_ns = test_time_ns() - start;
+  AES_CTR_Final(&ctx);
+
+  ref_init(&ref, key, nonce, 0);
+  start = test_time_ns();
+  for (i = 0; i < rounds; ++i)
+    for (pos = 0; pos < sizeof(buf); pos += chunk)
+      ref_update(&ref, buf + pos, chunk, buf + pos);
+  ref_ns = test_time_ns() - start;
+
+  printf("%5u byte chunks: AES_CTR_Update %6.1f MB/s, block at a time %6.1f MB/s\r\n", (unsigned)chunk,
+         rounds * sizeof(buf) * 1e3 / ctr_ns, rounds * sizeof(buf) * 1e3 / ref_ns);
+}
+
+static void test_bench(void)
+{
+  bench(16);
+  bench(64);
+  bench(1024);
+  bench(16384);
+}
+
+int main(void)
+{
+  test_vector();
+  test_chunks();
+  test_wrap();
+  test_legacy();
+  test_bench();
+  return 0;
+}
@@ -0,0 +1,412 @@
+/**
+******************************************************************************
+* @file    test_cli.c
+* @brief   CLI command table, line parser and script runner, and the CLI
+*          thread reading lines from a UART model in virtual time. Covers
+*          hundreds of commands registered and removed, extended names,
+*          quoting, argument overflow, scripts from memory and from a reader,
+*          a command that runs a script, and batch mode. Prints the cost of a
+*          line against the linear lookup it replaced.
+******************************************************************************
+*/
+
+#include <strings.h>
+
+/* The UART, the thread and the clock of the CLI are the models below */
+#define MicoUartSend                wire_send
+#define MicoUartRecv                wire_recv
+#define MicoUartGetLengthInBuffer   wire_length
+#define MicoUartInitialize          wire_initialize
+#define ring_buffer_init            wire_ring_init
+#define mico_rtos_create_thread     cli_thread_create
+#define mico_rtos_delete_thread     cli_thread_delete
+#define mico_get_time               virtual_time
+
+#include "../../../MICO/MICOCli.c"
+#include "../../../MICO/MICOCliDispatch.c"
+#include "host_test.h"
+
+#define COMMANDS    600
+
+static char wire[8192];             /* Typed by the user */
+static int wire_len, wire_pos;
+static char out[1 << 16];           /* Sent to the user */
+static int out_len;
+static uint32_t now;
+static mico_thread_function_t cli_thread;
+
+OSStatus wire_send( mico_uart_t uart, const void* data, uint32_t size )
+{
+  test_check( out_len + (int)size < (int)sizeof(out) );
+  memcpy( out + out_len, data, size );
+  out_len += (int)size;
+  out[out_len] = '\0';
+  return kNoErr;
+}
+
+/* The ring holds 512 bytes at most, like the one of MicoCliInit */
+uint32_t wire_length( mico_uart_t uart )
+{
+  int n = wire_len - wire_pos;
+  return n > 512 ? 512 : (uint32_t)n;
+}
+
+OSStatus wire_recv( mico_uart_t uart, void* data, uint32_t size, uint32_t timeout )
+{
+  if( wire_len - wire_pos < (int)size )
+    return kTimeoutErr;
+  memcpy( data, wire + wire_pos, size );
+  wire_pos += (int)size;
+  return kNoErr;
+}
+
+OSStatus wire_initialize( mico_uart_t uart, const mico_uart_config_t* config, ring_buffer_t* buffer ) { return kNoErr; }
+OSStatus wire_ring_init( ring_buffer_t* ring_buffer, uint8_t* buffer, uint32_t size ) { return kNoErr; }
+
+OSStatus cli_thread_create( mico_thread_t* thread, uint8_t priority, const char* name,
+                            mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  cli_thread = function;
+  return kNoErr;
+}
+
+OSStatus cli_thread_delete( mico_thread_t* thread ) { return kNoErr; }
+
+uint32_t virtual_time( void ) { return now; }
+
+/* Commands of the built-in table that live in the MICO core library */
+void wifistate_Command( CLI_ARGS ) { }
+void wifidebug_Command( CLI_ARGS ) { }
+void wifiscan_Command( CLI_ARGS ) { }
+void ifconfig_Command( CLI_ARGS ) { }
+void arp_Command( CLI_ARGS ) { }
+void ping_Command( CLI_ARGS ) { }
+void dns_Command( CLI_ARGS ) { }
+void task_Command( CLI_ARGS ) { }
+void socket_show_Command( CLI_ARGS ) { }
+void memory_show_Command( CLI_ARGS ) { }
+void memory_dump_Command( CLI_ARGS ) { }
+void memory_set_Command( CLI_ARGS ) { }
+void memp_dump_Command( CLI_ARGS ) { }
+void driver_state_Command( CLI_ARGS ) { }
+char* MicoGetVer( void ) { return "host"; }
+char* mico_get_bootloader_ver( void ) { return "host"; }
+OSStatus MicoGetRfVer( char* outVersion, uint8_t inLength ) { return kUnsupportedErr; }
+void MicoSystemReboot( void ) { }
+
+/* Test commands ------------------------------------------------------------*/
+
+static char names[COMMANDS][16];
+static struct cli_command commands[COMMANDS];
+static int calls, last_argc;
+static char last_args[512];
+
+/* Records its arguments, takes 3 ms */
+static void record_command( CLI_ARGS )
+{
+  int i;
+
+  calls++;
+  last_argc = argc;
+  last_args[0] = '\0';
+  for( i = 0; i < argc; i++ ){
+    strcat( last_args, argv[i] );
+    strcat( last_args, "|" );
+  }
+  now += 3;
+  cmd_printf( "out:%s", argv[0] );
+}
+
+static void other_command( CLI_ARGS )
+{
+  calls += 100;
+}
+
+/* Writes, runs a script of commands that write too, and writes again */
+static void script_command( CLI_ARGS )
+{
+  static const char script[] = "cmd1\ncmd2\n";
+
+  cmd_printf( "before " );
+  test_check( cli_run_script( script, (int)strlen( script ), 0 ) == 0 );
+  cmd_printf( "after" );
+}
+
+static const struct cli_command nested_commands[] = {
+  { "runscript", NULL, script_command },
+};
+
+typedef struct {
+  const char  *data;
+  int         len;
+  int         chunk;
+} chunk_reader_t;
+
+/* Gives the script at most chunk bytes a call */
+static int chunk_read( void *ctx, char *buf, int len )
+{
+  chunk_reader_t *reader = (chunk_reader_t *)ctx;
+
+  if( len > reader->chunk ) len = reader->chunk;
+  if( len > reader->len ) len = reader->len;
+  memcpy( buf, reader->data, (size_t)len );
+  reader->data += len;
+  reader->len -= len;
+  return len;
+}
+
+static void clear_output( void )
+{
+  out_len = 0;
+  out[0] = '\0';
+}
+
+static int count_commands( void )
+{
+  void *iter = NULL;
+  int n = 0;
+
+  while( cli_next_command( &iter ) != NULL )
+    n++;
+  return n;
+}
+
+static int run_line( const char *text )
+{
+  static char line[1024];
+
+  strcpy( line, text );
+  return cli_handle_input( line, 0 );
+}
+
+/* Types text and runs the CLI thread until it takes the "exit" at its end */
+static void type( const char *text )
+{
+  size_t len = strlen( text );
+
+  test_check( wire_len + len + 6 <= sizeof(wire) );
+  memcpy( wire + wire_len, text, len );
+  memcpy( wire + wire_len + len, "exit\r\n", 6 );
+  wire_len += (int)len + 6;
+  test_check( MicoCliInit( ) == kNoErr && cli_thread != NULL );
+  cli_thread( NULL );
+  test_check( pCli == NULL && wire_pos == wire_len );
+}
+
+/* Table and parser ---------------------------------------------------------*/
+
+static void check_table( void )
+{
+  static struct cli_command duplicate = { "cmd3", NULL, other_command };
+  static struct cli_command dotted = { "zz.b", NULL, other_command };
+  char line[CLI_INBUF_SIZE];
+  void *iter = NULL;
+  int i;
+
+  for( i = 0; i < COMMANDS; i++ ){
+    snprintf( names[i], sizeof(names[i]), "cmd%d", i );
+    commands[i].name = names[i];
+    commands[i].help = NULL;
+    commands[i].function = record_command;
+  }
+  test_check( cli_register_commands( commands, COMMANDS ) == 0 );
+  test_check( count_commands( ) == COMMANDS );
+  test_check( cli_register_command( &commands[5] ) == 0 && count_commands( ) == COMMANDS );
+  for( i = 0; i < COMMANDS; i++ )
+    test_check( cli_next_command( &iter ) == &commands[i] );
+  test_check( cli_next_command( &iter ) == NULL );
+
+  /* Quotes and escapes */
+  for( i = 0; i < COMMANDS; i += 7 ){
+    snprintf( line, sizeof(line), "cmd%d a \"b c\" d\\ e \"f\\\"g\"", i );
+    calls = 0;
+    test_check( cli_handle_input( line, 0 ) == 0 && calls == 1 && last_argc == 5 );
+    snprintf( line, sizeof(line), "cmd%d|a|b c|d e|f\"g|", i );
+    test_check( strcmp( last_args, line ) == 0 );
+  }
+  test_check( run_line( "nosuch x" ) == 1 );
+  test_check( run_line( "cmd1 \"open" ) == 2 );
+  test_check( run_line( "" ) == 0 && run_line( "   " ) == 0 );
+
+  /* An extension finds the command before the dot, not one it begins */
+  calls = 0;
+  test_check( run_line( "cmd12.x y" ) == 0 && calls == 1 && strcmp( last_args, "cmd12.x|y|" ) == 0 );
+  test_check( run_line( "cmd1234.x" ) == 1 );
+
+  /* The first registered wins, a dotted name is found by its prefix */
+  test_check( cli_register_command( &duplicate ) == 0 );
+  calls = 0;
+  test_check( run_line( "cmd3" ) == 0 && calls == 1 );
+  test_check( cli_unregister_command( &commands[3] ) == 0 );
+  calls = 0;
+  test_check( run_line( "cmd3" ) == 0 && calls == 100 );
+  test_check( cli_unregister_command( &commands[3] ) == 1 );
+  test_check( cli_register_command( &dotted ) == 0 );
+  calls = 0;
+  test_check( run_line( "zz.q" ) == 0 && calls == 100 );
+  test_check( run_line( "zz" ) == 1 );
+  test_check( cli_unregister_command( &duplicate ) == 0 && cli_unregister_command( &dotted ) == 0 );
+  test_check( cli_register_command( &commands[3] ) == 0 );
+
+  /* Half of them removed */
+  for( i = 1; i < COMMANDS; i += 2 )
+    test_check( cli_unregister_command( &commands[i] ) == 0 );
+  test_check( count_commands( ) == COMMANDS / 2 );
+  for( i = 0; i < COMMANDS; i++ ){
+    snprintf( line, sizeof(line), "cmd%d", i );
+    test_check( cli_handle_input( line, 0 ) == ( i & 1 ) );
+  }
+  for( i = 1; i < COMMANDS; i += 2 )
+    test_check( cli_register_command( &commands[i] ) == 0 );
+
+  /* CLI_MAX_ARGS arguments at most */
+  strcpy( line, "cmd0" );
+  for( i = 1; i < CLI_MAX_ARGS; i++ )
+    strcat( line, " a" );
+  test_check( cli_handle_input( line, 0 ) == 0 && last_argc == CLI_MAX_ARGS );
+  strcpy( line, "cmd0" );
+  for( i = 1; i <= CLI_MAX_ARGS; i++ )
+    strcat( line, " a" );
+  test_check( cli_handle_input( line, 0 ) == 2 );
+  strcpy( line, "cmd0" );
+  for( i = 1; i < CLI_MAX_ARGS; i++ )
+    strcat( line, " a" );
+  strcat( line, " \"b\"" );
+  test_check( cli_handle_input( line, 0 ) == 2 );
+}
+
+/* Scripts ------------------------------------------------------------------*/
+
+static void check_scripts( void )
+{
+  static const char script[] = "# comment\r\ncmd1 a\r\n\r\n  cmd2\tb\nbad\ncmd4 \"x\ncmd5";
+  static char big[4000];
+  chunk_reader_t reader;
+  char *p = big;
+  int chunk;
+
+  clear_output( );
+  now = 0;
+  test_check( cli_run_script( script, (int)strlen( script ), 0 ) == 2 );
+  test_check( strstr( out, "out:cmd1" ) != NULL && strstr( out, "[2] ok, 3 ms" ) != NULL );
+  test_check( strstr( out, "[4] ok" ) != NULL && strstr( out, "[5] not found" ) != NULL );
+  test_check( strstr( out, "[6] syntax error" ) != NULL && strstr( out, "[7] ok" ) != NULL );
+  test_check( strstr( out, "5 commands, 2 failed, 9 ms" ) != NULL );
+
+  clear_output( );
+  test_check( cli_run_script( script, (int)strlen( script ), 1 ) == 1 );
+  test_check( strstr( out, "3 commands, 1 failed" ) != NULL && strstr( out, "[6]" ) == NULL );
+
+  /* A line too long between two good ones, read a few bytes at a time */
+  p += sprintf( p, "cmd1\n" );
+  memset( p, 'x', 600 );
+  p += 600;
+  sprintf( p, "\ncmd2 y\n" );
+  for( chunk = 1; chunk < 20; chunk += 6 ){
+    reader.data = big;
+    reader.len = (int)strlen( big );
+    reader.chunk = chunk;
+    clear_output( );
+    test_check( cli_run_script_reader( chunk_read, &reader, 0 ) == 1 );
+    test_check( strstr( out, "[1] ok" ) != NULL && strstr( out, "[2] line too long" ) != NULL );
+    test_check( strstr( out, "[3] ok" ) != NULL && strstr( out, "3 commands, 1 failed" ) != NULL );
+  }
+
+  /* A command running a script keeps its own output */
+  test_check( cli_register_commands( nested_commands, 1 ) == 0 );
+  clear_output( );
+  test_check( run_line( "runscript" ) == 0 );
+  p = strstr( out, "out:cmd1" );
+  test_check( p != NULL && strstr( p, "out:cmd2" ) != NULL );
+  test_check( strstr( p, "before after" ) != NULL );
+  clear_output( );
+  test_check( cli_run_script( "runscript\nrunscript\n", 20, 0 ) == 0 );
+  test_check( strstr( out, "2 commands, 0 failed" ) != NULL );
+  test_check( strstr( strstr( out, "before after" ) + 1, "before after" ) != NULL );
+  test_check( cli_unregister_commands( nested_commands, 1 ) == 0 );
+}
+
+/* The CLI thread -----------------------------------------------------------*/
+
+static void check_thread( void )
+{
+  static char text[400];
+  char *p;
+
+  /* CR, LF, CRLF and backspace */
+  clear_output( );
+  type( "cmd1 ax\b\bb\r\ncmd2\ncmd3\r\r\n" );
+  test_check( strstr( out, "cmd1 ax\b \b\b \bb" ) != NULL && strstr( out, "out:cmd1" ) != NULL );
+  test_check( strstr( out, "out:cmd2" ) != NULL && strcmp( last_args, "cmd3|" ) == 0 );
+
+  /* A line too long is dropped up to its end, the next one runs */
+  memset( text, 'x', 300 );
+  strcpy( text + 300, "\r\ncmd4\r\n" );
+  clear_output( );
+  type( text );
+  test_check( strstr( out, "input buffer overflow" ) != NULL && strstr( out, "not found" ) == NULL );
+  test_check( strstr( out, "out:cmd4" ) != NULL );
+
+  /* Batch mode up to "end", no echo */
+  clear_output( );
+  now = 0;
+  type( "batch\r\ncmd5 q\r\nnope\r\nversion\r\nend\r\n" );
+  p = strstr( out, "Batch mode" );
+  test_check( p != NULL && strstr( p, "cmd5 q" ) == NULL );
+  test_check( strstr( p, "[1] ok, 3 ms" ) != NULL && strstr( p, "[2] not found" ) != NULL );
+  test_check( strstr( p, "Product module" ) != NULL && strstr( p, "3 commands, 1 failed" ) != NULL );
+}
+
+/* Cost of a line -----------------------------------------------------------*/
+
+static void measure( void )
+{
+  static const struct cli_command *table[COMMANDS];
+  char line[CLI_INBUF_SIZE];
+  unsigned long long start, linear_ns, hashed_ns;
+  volatile long sink = 0;
+  int n, i, j, k;
+  const int iterations = 1000000;
+
+  for( n = 50; n <= COMMANDS; n += COMMANDS - 50 ){
+    for( i = 0; i < n; i++ )
+      table[i] = &commands[i];
+    for( i = 0; i < COMMANDS; i++ )
+      cli_unregister_command( &commands[i] );
+    for( i = 0; i < n; i++ )
+      cli_register_command( &commands[i] );
+
+    /* The lookup alone, as the command array did it */
+    start = test_time_ns( );
+    for( k = 0; k < iterations; k++ ){
+      const char *name = names[( k % n ) * 7919 % n];
+      for( j = 0; j < n; j++ )
+        if( strcmp( table[j]->name, name ) == 0 )
+          break;
+      sink += j;
+    }
+    linear_ns = test_time_ns( ) - start;
+
+    /* Parse, lookup and run */
+    start = test_time_ns( );
+    for( k = 0; k < iterations; k++ ){
+      strcpy( line, names[( k % n ) * 7919 % n] );
+      out_len = 0;
+      sink += cli_handle_input( line, 0 );
+    }
+    hashed_ns = test_time_ns( ) - start;
+
+    printf( "%3d commands: linear lookup %4llu ns, hashed lookup and run %4llu ns a line\r\n",
+            n, linear_ns / iterations, hashed_ns / iterations );
+  }
+  (void)sink;
+}
+
+int main( void )
+{
+  check_table( );
+  check_scripts( );
+  check_thread( );
+  measure( );
+  return 0;
+}
@@ -0,0 +1,237 @@
+/**
+******************************************************************************
+* @file    test_disk_cache.c
+* @brief   Sector cache of the FatFs disk I/O, built with the
+*          _DISK_CACHE_SECTORS and _DISK_CACHE_READAHEAD of the test target:
+*          random reads, writes and syncs match a model of the disk, the
+*          driver is never asked for a sector past the end, and a failed
+*          read leaves nothing wrong in the cache. Prints the driver calls
+*          of a few FatFs workloads.
+******************************************************************************
+*/
+
+#include <string.h>
+#include "ff_gen_drv.h"
+#include "host_test.h"
+
+#define DISK_SECTORS    8192
+#define MODEL_SECTORS   300
+
+/* RAM disk that counts the calls made to it -------------------------------*/
+
+static BYTE store[DISK_SECTORS][512];
+static DWORD disk_sectors = DISK_SECTORS;
+static int size_unknown, fail_next_read;
+static long reads, writes, sectors_read, sectors_written;
+
+static DSTATUS RAM_initialize( void ) { return 0; }
+static DSTATUS RAM_status( void ) { return 0; }
+
+static DRESULT RAM_read( BYTE* buff, DWORD sector, BYTE count )
+{
+  test_check( count > 0 && sector < disk_sectors && count <= disk_sectors - sector );
+  if ( fail_next_read ){
+    /* Part of the data is in the buffer when the transfer fails */
+    fail_next_read = 0;
+    memset( buff, 0xA5, count * 512u );
+    return RES_ERROR;
+  }
+  memcpy( buff, store[sector], count * 512u );
+  reads++;
+  sectors_read += count;
+  return RES_OK;
+}
+
+static DRESULT RAM_write( const BYTE* buff, DWORD sector, BYTE count )
+{
+  test_check( count > 0 && sector < disk_sectors && count <= disk_sectors - sector );
+  memcpy( store[sector], buff, count * 512u );
+  writes++;
+  sectors_written += count;
+  return RES_OK;
+}
+
+static DRESULT RAM_ioctl( BYTE cmd, void* buff )
+{
+  switch ( cmd ){
+    case GET_SECTOR_COUNT:
+      if ( size_unknown )
+        return RES_ERROR;
+      *(DWORD*) buff = disk_sectors;
+      return RES_OK;
+    case GET_SECTOR_SIZE:  *(WORD*) buff = 512; return RES_OK;
+    case GET_BLOCK_SIZE:   *(DWORD*) buff = 1; return RES_OK;
+    case CTRL_SYNC:        return RES_OK;
+    default:               return RES_PARERR;
+  }
+}
+
+static Diskio_drvTypeDef RAM_Driver = { RAM_initialize, RAM_status, RAM_read, RAM_write, RAM_ioctl };
+
+/* -------------------------------------------------------------------------*/
+
+static void report( const char* workload )
+{
+  printf( "  %-40s %5ld reads (%5ld sectors) %5ld writes (%5ld sectors)\r\n",
+          workload, reads, sectors_read, writes, sectors_written );
+  reads = writes = sectors_read = sectors_written = 0;
+}
+
+static void fat_workloads( const char* path )
+{
+  static BYTE buff[4096];
+  FATFS fs;
+  FIL file;
+  DIR dir;
+  FILINFO info;
+  char name[16];
+  UINT done;
+  int i, k, found;
+
+  test_check( f_mount( &fs, path, 0 ) == FR_OK && f_mkfs( path, 0, 0 ) == FR_OK );
+  test_check( f_mount( &fs, path, 1 ) == FR_OK );
+  report( "mkfs + mount" );
+
+  test_check( f_open( &file, "data.bin", FA_CREATE_ALWAYS | FA_WRITE ) == FR_OK );
+  for ( i = 0; i < 655; i++ ){
+    for ( k = 0; k < 100; k++ )
+      buff[k] = (BYTE)( i * 7 + k );
+    test_check( f_write( &file, buff, 100, &done ) == FR_OK && done == 100 );
+  }
+  test_check( f_close( &file ) == FR_OK );
+  report( "64K file in 100 byte f_write" );
+
+  test_check( f_open( &file, "data.bin", FA_READ ) == FR_OK );
+  for ( i = 0; i < 655; i++ ){
+    test_check( f_read( &file, buff, 100, &done ) == FR_OK && done == 100 );
+    for ( k = 0; k < 100; k++ )
+      test_check( buff[k] == (BYTE)( i * 7 + k ) );
+  }
+  test_check( f_close( &file ) == FR_OK );
+  report( "64K file in 100 byte f_read" );
+
+  for ( i = 0; i < 200; i++ ){
+    test_check( f_open( &file, "log.txt", FA_OPEN_ALWAYS | FA_WRITE ) == FR_OK );
+    test_check( f_lseek( &file, f_size( &file ) ) == FR_OK );
+    snprintf( (char*) buff, sizeof(buff), "%05d temperature 23.5 humidity 41\r\n", i );
+    test_check( f_write( &file, buff, strlen( (char*) buff ), &done ) == FR_OK );
+    test_check( f_close( &file ) == FR_OK );
+  }
+  report( "200 log lines, open/append/close each" );
+
+  test_check( f_mkdir( "cfg" ) == FR_OK );
+  for ( i = 0; i < 40; i++ ){
+    snprintf( name, sizeof(name), "cfg/f%02d.txt", i );
+    test_check( f_open( &file, name, FA_CREATE_ALWAYS | FA_WRITE ) == FR_OK );
+    test_check( f_write( &file, name, 10, &done ) == FR_OK && f_close( &file ) == FR_OK );
+  }
+  report( "40 small files in a directory" );
+
+  for ( k = 0; k < 10; k++ ){
+    test_check( f_opendir( &dir, "cfg" ) == FR_OK );
+    for ( found = 0; f_readdir( &dir, &info ) == FR_OK && info.fname[0]; found++ );
+    test_check( found == 40 );
+  }
+  for ( i = 0; i < 40; i++ ){
+    snprintf( name, sizeof(name), "cfg/f%02d.txt", i );
+    test_check( f_stat( name, &info ) == FR_OK );
+  }
+  report( "10 directory listings + 40 f_stat" );
+
+  f_mount( NULL, path, 0 );
+}
+
+/* Random reads, writes and syncs on a small disk, against a model of it */
+static void random_operations( long count )
+{
+  static BYTE model[MODEL_SECTORS][512], buff[130 * 512];
+  DWORD sector, last = 0;
+  long n;
+  int op, c, i;
+
+  disk_sectors = MODEL_SECTORS;
+  test_check( disk_initialize( 0 ) == 0 );
+  memcpy( model, store, sizeof(model) );
+  srand( 1 );
+  for ( n = 0; n < count; n++ ){
+    op = rand( ) % 10;
+    sector = (DWORD) rand( ) % MODEL_SECTORS;
+    c = 1 + ( rand( ) % 4 ? rand( ) % 4 : rand( ) % 40 );
+    if ( rand( ) % 3 == 0 )
+      sector = last < MODEL_SECTORS ? last : 0;
+    if ( sector + c > MODEL_SECTORS )
+      c = (int)( MODEL_SECTORS - sector );
+    last = sector + c;
+
+    if ( op < 5 ){
+      test_check( disk_read( 0, buff, sector, (BYTE) c ) == RES_OK );
+      test_check( memcmp( buff, model[sector], c * 512u ) == 0 );
+    }else if ( op < 9 ){
+      for ( i = 0; i < c * 512; i++ )
+        buff[i] = (BYTE) rand( );
+      test_check( disk_write( 0, buff, sector, (BYTE) c ) == RES_OK );
+      memcpy( model[sector], buff, c * 512u );
+    }else{
+      test_check( disk_ioctl( 0, CTRL_SYNC, NULL ) == RES_OK );
+      test_check( memcmp( store, model, sizeof(model) ) == 0 );
+    }
+  }
+  test_check( disk_ioctl( 0, CTRL_SYNC, NULL ) == RES_OK );
+  test_check( memcmp( store, model, sizeof(model) ) == 0 );
+}
+
+/* Every sector of the small disk read one by one, as FatFs reads a file */
+static void read_all( void )
+{
+  BYTE buff[512];
+  DWORD sector;
+
+  for ( sector = 0; sector < MODEL_SECTORS; sector++ ){
+    test_check( disk_read( 0, buff, sector, 1 ) == RES_OK );
+    test_check( memcmp( buff, store[sector], 512 ) == 0 );
+  }
+}
+
+int main( void )
+{
+  BYTE buff[512];
+  char path[4];
+  DWORD sector;
+
+  test_check( FATFS_LinkDriver( &RAM_Driver, path ) == 0 );
+  printf( "%d cache lines, %d read ahead\r\n", _DISK_CACHE_SECTORS, _DISK_CACHE_READAHEAD );
+  fat_workloads( path );
+
+  random_operations( 30000 );
+
+  /* Read-ahead stops at the end of the disk, RAM_read checks it */
+  test_check( disk_initialize( 0 ) == 0 );
+  reads = sectors_read = 0;
+  read_all( );
+  test_check( sectors_read == MODEL_SECTORS );
+
+  /* No read-ahead on a disk of unknown size */
+  size_unknown = 1;
+  test_check( disk_initialize( 0 ) == 0 );
+  reads = sectors_read = 0;
+  read_all( );
+  test_check( reads == MODEL_SECTORS && sectors_read == MODEL_SECTORS );
+  size_unknown = 0;
+
+  /* A read that fails while lines of other sectors are filled, every one of
+     them reads back from the disk afterwards. Last first, before a read-ahead
+     replaces them */
+  test_check( disk_initialize( 0 ) == 0 );
+  for ( sector = 0; sector < 16; sector++ )
+    test_check( disk_read( 0, buff, sector, 1 ) == RES_OK );
+  test_check( disk_read( 0, buff, 100, 1 ) == RES_OK );
+  fail_next_read = 1;
+  test_check( disk_read( 0, buff, 101, 1 ) != RES_OK );
+  for ( sector = 16; sector-- > 0; ){
+    test_check( disk_read( 0, buff, sector, 1 ) == RES_OK );
+    test_check( memcmp( buff, store[sector], 512 ) == 0 );
+  }
+  test_check( disk_read( 0, buff, 101, 1 ) == RES_OK && memcmp( buff, store[101], 512 ) == 0 );
+
+  return 0;
+}
@@ -0,0 +1,101 @@
+/**
+******************************************************************************
+* @file    test_dnscache.c
+* @brief   DNS cache: the saved addresses live in their own flash partition,
+*          a stored address is only replaced once it stopped working, and
+*          flash is not written again within DNS_CACHE_SAVE_INTERVAL.
+******************************************************************************
+*/
+
+#define gethostbyname fake_gethostbyname
+#include "../../../MICO/MICODNSCache.c"
+#undef gethostbyname
+#include "host_test.h"
+
+static const char *fake_addr = "10.0.0.1";
+static int resolves;
+
+int fake_gethostbyname( const char * name, uint8_t * addr, uint8_t addrLen )
+{
+  (void)name;
+  resolves++;
+  strncpy( (char *)addr, fake_addr, addrLen );
+  return kNoErr;
+}
+
+static const char *flash_addr( void )
+{
+  static dns_cache_in_flash_t saved;
+  uint32_t address = DNS_CACHE_START_ADDRESS;
+
+  MicoFlashInitialize( MICO_FLASH_FOR_DNS_CACHE );
+  MicoFlashRead( MICO_FLASH_FOR_DNS_CACHE, &address, (uint8_t *)&saved, sizeof(saved) );
+  MicoFlashFinalize( MICO_FLASH_FOR_DNS_CACHE );
+  if ( saved.magic != kDNSCacheFlashMagic || strcmp( saved.host[0].name, "cloud.example.com" ) != 0 )
+    return "";
+  return saved.host[0].addr;
+}
+
+static const char *lookup( void )
+{
+  static char addr[16];
+
+  test_check( MICOGetHostByName( "cloud.example.com", addr, sizeof(addr) ) == kNoErr );
+  return addr;
+}
+
+int main( void )
+{
+  mico_Context_t context;
+  char addr[16];
+
+  test_check( MicoFlashInitialize( MICO_FLASH_FOR_PARA ) == kNoErr );
+  test_check( MicoFlashErase( MICO_FLASH_FOR_PARA, PARA_START_ADDRESS, PARA_END_ADDRESS ) == kNoErr );
+  test_check( MicoFlashErase( MICO_FLASH_FOR_DNS_CACHE, DNS_CACHE_START_ADDRESS, DNS_CACHE_END_ADDRESS ) == kNoErr );
+  MicoFlashFinalize( MICO_FLASH_FOR_PARA );
+
+  /* Bad parameters fail before anything is set up */
+  test_check( MICOGetHostByName( NULL, addr, sizeof(addr) ) == kParamErr );
+  test_check( MICOStartDNSCache( &context ) == kNoErr );
+
+  /* A new name is saved right away */
+  test_check( strcmp( lookup(), "10.0.0.1" ) == 0 );
+  test_check( strcmp( flash_addr(), "10.0.0.1" ) == 0 );
+  test_check( strcmp( lookup(), "10.0.0.1" ) == 0 && resolves == 1 );
+
+  /* A new address for a stored name that still works does not touch flash */
+  _dnsSaved = false;
+  fake_addr = "10.0.0.2";
+  _DNSCacheExpire( "cloud.example.com", false );
+  test_check( strcmp( lookup(), "10.0.0.2" ) == 0 && resolves == 2 );
+  test_check( strcmp( flash_addr(), "10.0.0.1" ) == 0 );
+
+  /* Once connecting fails it is replaced, but not twice within the save interval */
+  fake_addr = "10.0.0.3";
+  MICOExpireHostByName( "cloud.example.com" );
+  test_check( strcmp( lookup(), "10.0.0.3" ) == 0 );
+  test_check( strcmp( flash_addr(), "10.0.0.3" ) == 0 );
+  fake_addr = "10.0.0.4";
+  MICOExpireHostByName( "cloud.example.com" );
+  test_check( strcmp( lookup(), "10.0.0.4" ) == 0 );
+  test_check( strcmp( flash_addr(), "10.0.0.3" ) == 0 );
+
+  /* The system configuration is never written */
+  test_check( MicoFlashInitialize( MICO_FLASH_FOR_PARA ) == kNoErr );
+  {
+    uint32_t address = PARA_START_ADDRESS, word = 0;
+    MicoFlashRead( MICO_FLASH_FOR_PARA, &address, (uint8_t *)&word, sizeof(word) );
+    test_check( word == 0xFFFFFFFF );
+  }
+  MicoFlashFinalize( MICO_FLASH_FOR_PARA );
+
+  /* The next boot starts from the saved address */
+  mico_rtos_lock_mutex( &_dnsCacheMutex );
+  memset( _dnsCache, 0x0, sizeof(_dnsCache) );
+  _DNSCacheLoad();
+  mico_rtos_unlock_mutex( &_dnsCacheMutex );
+  test_check( _DNSCacheLookup( "cloud.example.com", addr, sizeof(addr), NULL ) == DNSCacheStale );
+  test_check( strcmp( addr, "10.0.0.3" ) == 0 );
+
+  return 0;
+}
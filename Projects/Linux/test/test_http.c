@@ -0,0 +1,73 @@
+/**
+******************************************************************************
+* @file    test_http.c
+* @brief   HTTP header parsing: indexed field lookups and Content-Length
+*          checks. Prints the parse and lookup rate.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "HTTPUtils.h"
+#include "host_test.h"
+
+static HTTPHeader_t *header;
+
+static OSStatus parse( const char *request )
+{
+  strcpy( header->buf, request );
+  header->len = strlen( request );
+  return HTTPHeaderParse( header );
+}
+
+static OSStatus parse_length( const char *contentLength )
+{
+  char request[256];
+
+  snprintf( request, sizeof(request), "POST /config-write HTTP/1.1\r\nHost: 10.10.10.1\r\nContent-Length:%s\r\n\r\n", contentLength );
+  return parse( request );
+}
+
+int main( void )
+{
+  const char *request = "POST /config-write HTTP/1.1\r\nHost: 10.10.10.1\r\ncontent-type: application/json\r\n"
+                        "X-Long: a\r\n  b\r\nConnection: close\r\nContent-Length: 42\r\n\r\n";
+  unsigned long long start, spent;
+  const char *value;
+  size_t valueSize;
+  int i;
+
+  header = HTTPHeaderCreate( );
+  test_check( header != NULL );
+
+  /* Fields are found whatever their case, folded lines included */
+  test_check( parse( request ) == kNoErr );
+  test_check( header->contentLength == 42 && header->persistent == false );
+  test_check( HTTPHeaderGetField( header, "Content-Type", &value, &valueSize ) == kNoErr );
+  test_check( valueSize == 16 && strncmp( value, "application/json", valueSize ) == 0 );
+  test_check( HTTPHeaderGetField( header, "x-long", &value, &valueSize ) == kNoErr );
+  test_check( HTTPHeaderGetField( header, "Accept", &value, &valueSize ) != kNoErr );
+
+  /* Content-Length is digits only and fits in 64 bits */
+  test_check( parse_length( " 0" ) == kNoErr && header->contentLength == 0 );
+  test_check( parse_length( " 12  " ) == kNoErr && header->contentLength == 12 );
+  test_check( parse_length( " 18446744073709551615" ) == kNoErr && header->contentLength == UINT64_MAX );
+  test_check( parse_length( " 18446744073709551616" ) == kMalformedErr );
+  test_check( parse_length( " 99999999999999999999999" ) == kMalformedErr );
+  test_check( parse_length( "" ) == kMalformedErr );
+  test_check( parse_length( " abc" ) == kMalformedErr );
+  test_check( parse_length( " -1" ) == kMalformedErr );
+  test_check( parse_length( " 12x" ) == kMalformedErr );
+  test_check( parse( "GET / HTTP/1.1\r\nHost: a\r\n\r\n" ) == kNoErr && header->contentLength == 0 );
+
+  start = test_time_ns( );
+  for ( i = 0; i < 100000; i++ ){
+    parse( request );
+    HTTPHeaderGetField( header, "Content-Type", &value, &valueSize );
+  }
+  spent = test_time_ns( ) - start;
+  printf( "%.0f parses and lookups/s\r\n", 100000 / ( spent / 1e9 ) );
+
+  HTTPHeaderClear( header );
+  free( header );
+  return 0;
+}
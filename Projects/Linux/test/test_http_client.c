@@ -0,0 +1,265 @@
+/**
+******************************************************************************
+* @file    test_http_client.c
+* @brief   Keep-alive HTTP client against a loopback server: pipelined
+*          requests, the three body framings, Range downloads resumed after
+*          the server drops or closes the connection, and bodies too long to
+*          be kept in RAM.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "HTTPUtils.h"
+#include "HTTPClientUtils.h"
+#include "StringUtils.h"
+#include "host_test.h"
+
+#define TEST_PORT   40125
+#define FILE_LEN    50000
+
+static uint8_t file[FILE_LEN];
+static uint8_t got[FILE_LEN];
+static uint32_t gotEnd;
+static int listener;
+static volatile int connections, requests;
+
+/* Server side ---------------------------------------------------------------*/
+
+static char rx[2048];
+static size_t rxLen;
+
+static int send_all( int fd, const void *data, size_t len )
+{
+  const uint8_t *p = data;
+  ssize_t sent;
+
+  while( len > 0 ){
+    sent = send( fd, p, len, 0 );
+    if( sent <= 0 ) return -1;
+    p += sent;
+    len -= (size_t)sent;
+  }
+  return 0;
+}
+
+static int send_text( int fd, const char *text )
+{
+  return send_all( fd, text, strlen( text ) );
+}
+
+/* One request header into head, its body skipped. 0 when the client has closed */
+static int read_request( int fd, char *head, size_t headSize )
+{
+  char *end, *field;
+  size_t len, skip = 0;
+  ssize_t got;
+
+  while( ( end = strstr( rx, "\r\n\r\n" ) ) == NULL ){
+    got = recv( fd, rx + rxLen, sizeof(rx) - 1 - rxLen, 0 );
+    if( got <= 0 ) return 0;
+    rxLen += (size_t)got;
+    rx[rxLen] = 0;
+  }
+  len = (size_t)( end + 4 - rx );
+  test_check( len < headSize );
+  memcpy( head, rx, len );
+  head[len] = 0;
+  if( ( field = strstr( head, "Content-Length: " ) ) != NULL )
+    skip = (size_t)atoi( field + 16 );
+  test_check( len + skip < sizeof(rx) );
+  while( rxLen < len + skip ){
+    got = recv( fd, rx + rxLen, sizeof(rx) - 1 - rxLen, 0 );
+    if( got <= 0 ) return 0;
+    rxLen += (size_t)got;
+  }
+  rxLen -= len + skip;
+  memmove( rx, rx + len + skip, rxLen + 1 );
+  return 1;
+}
+
+/* "bytes=a-b" of the Range field */
+static void get_range( const char *head, uint32_t *first, uint32_t *last )
+{
+  const char *range = strstr( head, "Range: bytes=" );
+
+  test_check( range != NULL );
+  test_check( sscanf( range + 13, "%u-%u", (unsigned *)first, (unsigned *)last ) == 2 );
+  if( *last >= FILE_LEN ) *last = FILE_LEN - 1;
+}
+
+/* Answers one request, 0 once the connection is closed */
+static int serve( int fd, const char *head, int n )
+{
+  char path[64], method[8], line[256];
+  uint32_t first, last, i;
+  size_t len;
+
+  test_check( sscanf( head, "%7s %63s", method, path ) == 2 );
+  requests++;
+
+  if( strcmp( path, "/chunked" ) == 0 ){
+    return send_text( fd, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                          "Transfer-Encoding: chunked\r\n\r\n5\r\n{\"a\":\r\n3;x=y\r\n123\r\n1\r\n}\r\n0\r\nX-T: 1\r\n\r\n" ) == 0;
+  }else if( strcmp( path, "/close" ) == 0 ){
+    send_text( fd, "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok" );
+    return 0;
+  }else if( strcmp( path, "/eof" ) == 0 ){
+    send_text( fd, "HTTP/1.0 200 OK\r\n\r\nuntil close" );
+    return 0;
+  }else if( strcmp( method, "HEAD" ) == 0 ){
+    return send_text( fd, "HTTP/1.1 200 OK\r\nContent-Length: 50000\r\n\r\n" ) == 0;
+  }else if( strncmp( path, "/fw", 3 ) == 0 ){
+    get_range( head, &first, &last );
+    len = (size_t)snprintf( line, sizeof(line), "HTTP/1.1 206 Partial Content\r\n%sContent-Type: application/octet-stream\r\n"
+                            "Content-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\n\r\n",
+                            ( strcmp( path, "/fwclose" ) == 0 && n == 2 ) ? "Connection: close\r\n" : "",
+                            (unsigned)first, (unsigned)last, FILE_LEN, (unsigned)( last - first + 1 ) );
+    send_all( fd, line, len );
+    if( strcmp( path, "/fwdrop" ) == 0 && n == 3 ){
+      send_all( fd, &file[first], ( last - first + 1 ) / 2 );
+      return 0;
+    }
+    if( send_all( fd, &file[first], last - first + 1 ) != 0 ) return 0;
+    return !( strcmp( path, "/fwclose" ) == 0 && n == 2 );
+  }else if( strcmp( path, "/full" ) == 0 ){
+    send_text( fd, "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: 50000\r\n\r\n" );
+    return send_all( fd, file, FILE_LEN ) == 0;
+  }else if( strcmp( path, "/huge" ) == 0 ){
+    send_text( fd, "HTTP/1.1 200 OK\r\nContent-Length: 1099511627776\r\n\r\n" );
+    return send_all( fd, file, 1000 ) == 0;
+  }else if( strcmp( path, "/long" ) == 0 || strcmp( path, "/fits" ) == 0 ){
+    len = kHTTPClientMaxBodyLen + ( path[1] == 'l' ? 1 : 0 );
+    snprintf( line, sizeof(line), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n", (unsigned)len );
+    send_text( fd, line );
+    for( i = 0; i < len; i += 1000 )
+      if( send_all( fd, file, len - i < 1000 ? len - i : 1000 ) != 0 ) return 0;
+    return 1;
+  }else if( strcmp( path, "/stream" ) == 0 ){
+    send_text( fd, "HTTP/1.0 200 OK\r\n\r\n" );
+    for( i = 0; i < kHTTPClientMaxBodyLen + 1000; i += 1000 )
+      if( send_all( fd, file, 1000 ) != 0 ) break;
+    return 0;
+  }
+  return send_text( fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n" ) == 0;
+}
+
+static void server( void *arg )
+{
+  char head[1024];
+  int fd, n;
+
+  (void)arg;
+  for( ;; ){
+    fd = accept( listener, NULL, NULL );
+    if( fd < 0 ) continue;
+    connections++;
+    rxLen = 0;
+    rx[0] = 0;
+    for( n = 1; read_request( fd, head, sizeof(head) ) && serve( fd, head, n ); n++ );
+    close( fd );
+  }
+}
+
+/* Client side ---------------------------------------------------------------*/
+
+/* Takes application/octet-stream only, the rest is kept in extraDataPtr */
+static OSStatus on_data( struct _HTTPHeader_t *inHeader, uint32_t inPos, uint8_t *inData, size_t inLen, void *inUserContext )
+{
+  const char *value;
+  size_t valueLen;
+
+  (void)inUserContext;
+  if( HTTPHeaderGetField( inHeader, "Content-Type", &value, &valueLen ) != kNoErr ||
+      strnicmpx( value, valueLen, "application/octet-stream" ) != 0 )
+    return kUnsupportedErr;
+  test_check( inPos + inLen <= FILE_LEN );
+  memcpy( &got[inPos], inData, inLen );
+  if( inPos + inLen > gotEnd ) gotEnd = inPos + inLen;
+  return kNoErr;
+}
+
+static bool got_file( uint32_t from, uint32_t to )
+{
+  return gotEnd == to && memcmp( &got[from], &file[from], to - from ) == 0 && ( from == 0 || got[from - 1] == 0 );
+}
+
+static OSStatus download( HTTPClient_t *client, HTTPHeader_t *header, const char *path, uint32_t offset, uint32_t length )
+{
+  memset( got, 0, sizeof(got) );
+  gotEnd = 0;
+  return HTTPClientDownload( client, path, offset, length, header );
+}
+
+static OSStatus get( HTTPClient_t *client, HTTPHeader_t *header, const char *path )
+{
+  test_check( HTTPClientSendRequest( client, "GET", path, NULL, NULL, 0 ) == kNoErr );
+  return HTTPClientReadResponse( client, header );
+}
+
+int main( void )
+{
+  static HTTPClient_t client;
+  HTTPHeader_t *header;
+  struct sockaddr_t a;
+  uint32_t i;
+
+  for( i = 0; i < FILE_LEN; i++ )
+    file[i] = (uint8_t)( i * 7 + 3 );
+
+  listener = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+  test_check( listener >= 0 );
+  memset( &a, 0, sizeof(a) );
+  a.s_port = TEST_PORT;
+  a.s_ip = INADDR_ANY;
+  test_check( bind( listener, &a, sizeof(a) ) == 0 && listen( listener, 4 ) == 0 );
+  test_check( mico_rtos_create_thread( NULL, MICO_APPLICATION_PRIORITY, "server", server, 2048, NULL ) == kNoErr );
+
+  header = HTTPHeaderCreateWithCallback( on_data, NULL, NULL );
+  test_check( header != NULL );
+  test_check( HTTPClientInit( &client, "127.0.0.1", TEST_PORT ) == kNoErr );
+  client.conn.backoffMin = 10;
+
+  /* Pipelined on one connection: chunked after a 100 Continue, HEAD, POST */
+  test_check( HTTPClientSendRequest( &client, "GET", "/chunked", NULL, NULL, 0 ) == kNoErr );
+  test_check( HTTPClientSendRequest( &client, "HEAD", "/x", NULL, NULL, 0 ) == kNoErr );
+  test_check( HTTPClientSendRequest( &client, "POST", "/nothere", "Content-Type: text/plain\r\n", (const uint8_t *)"hello", 5 ) == kNoErr );
+  test_check( HTTPClientPending( &client ) == 3 );
+  test_check( HTTPClientReadResponse( &client, header ) == kNoErr );
+  test_check( header->statusCode == 200 && header->contentLength == 9 && strcmp( header->extraDataPtr, "{\"a\":123}" ) == 0 );
+  test_check( HTTPClientReadResponse( &client, header ) == kNoErr );
+  test_check( header->statusCode == 200 && header->contentLength == 50000 && header->extraDataPtr == NULL );
+  test_check( HTTPClientReadResponse( &client, header ) == kNoErr );
+  test_check( header->statusCode == 404 );
+  test_check( connections == 1 && requests == 3 );
+
+  /* Connection: close drops the requests behind it, a close-delimited body ends with the connection */
+  test_check( HTTPClientSendRequest( &client, "GET", "/close", NULL, NULL, 0 ) == kNoErr );
+  test_check( HTTPClientSendRequest( &client, "GET", "/x", NULL, NULL, 0 ) == kNoErr );
+  test_check( HTTPClientReadResponse( &client, header ) == kNoErr );
+  test_check( strcmp( header->extraDataPtr, "ok" ) == 0 && header->persistent == false && client.fd < 0 );
+  test_check( HTTPClientReadResponse( &client, header ) == kConnectionErr );
+  test_check( get( &client, header, "/eof" ) == kNoErr && strcmp( header->extraDataPtr, "until close" ) == 0 );
+
+  /* Downloads: whole, a range, resumed after a cut body or a close, and without Range support */
+  connections = requests = 0;
+  test_check( download( &client, header, "/fw", 0, 0 ) == kNoErr && got_file( 0, FILE_LEN ) );
+  test_check( connections == 1 && requests == ( FILE_LEN + kHTTPClientRangeLen - 1 ) / kHTTPClientRangeLen );
+  test_check( download( &client, header, "/fw", 12345, 20000 ) == kNoErr && got_file( 12345, 32345 ) );
+  test_check( download( &client, header, "/fwdrop", 0, 0 ) == kNoErr && got_file( 0, FILE_LEN ) );
+  test_check( download( &client, header, "/fwclose", 100, 0 ) == kNoErr && got_file( 100, FILE_LEN ) );
+  test_check( download( &client, header, "/full", 0, 0 ) == kNoErr && got_file( 0, FILE_LEN ) );
+  test_check( download( &client, header, "/missing", 0, 0 ) == kNotFoundErr );
+
+  /* A body kept in RAM is refused past kHTTPClientMaxBodyLen, whatever its framing */
+  test_check( get( &client, header, "/fits" ) == kNoErr );
+  test_check( header->contentLength == kHTTPClientMaxBodyLen && memcmp( header->extraDataPtr, file, 1000 ) == 0 );
+  test_check( get( &client, header, "/huge" ) == kSizeErr && client.fd < 0 );
+  test_check( get( &client, header, "/long" ) == kSizeErr && client.fd < 0 );
+  test_check( get( &client, header, "/stream" ) == kSizeErr && client.fd < 0 );
+  test_check( get( &client, header, "/chunked" ) == kNoErr && strcmp( header->extraDataPtr, "{\"a\":123}" ) == 0 );
+
+  HTTPClientClose( &client );
+  HTTPHeaderClear( header );
+  free( header );
+  return 0;
+}
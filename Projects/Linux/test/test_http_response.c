@@ -0,0 +1,113 @@
+/**
+******************************************************************************
+* @file    test_http_response.c
+* @brief   HTTP response builder: the header matches what the snprintf based
+*          builder it replaced produced, and SocketSendHTTPResponse() sends
+*          header and body over TCP. Prints both builders' rate.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "HTTPUtils.h"
+#include "host_test.h"
+
+#define TEST_PORT  40124
+
+/* The header as the former CreateHTTPRespondMessageNoCopy() wrote it */
+static const char *reference_status_string( int status )
+{
+  switch( status ){
+    case kStatusNoConetnt:          return "No Content";
+    case kStatusPartialContent:     return "Multi0Status";
+    case kStatusBadRequest:         return "Bad Request";
+    case kStatusNotFound:           return "Not Found";
+    case kStatusMethodNotAllowed:   return "Not Allowed";
+    case kStatusForbidden:          return "Forbidden";
+    case kStatusAuthenticationErr:  return "Authentication Error";
+    case kStatusInternalServerErr:  return "Internal Server Error";
+    default:                        return "OK";
+  }
+}
+
+static size_t reference_header( char *buf, int status, const char *contentType, size_t inDataLen )
+{
+  char *message = malloc( 200 );
+  size_t len;
+
+  if( inDataLen )
+    snprintf( message, 200, "%s %d %s%s%s %s%s%s %d%s", "HTTP/1.1", status, reference_status_string( status ), "\r\n",
+              "Content-Type:", contentType, "\r\n", "Content-Length:", (int)inDataLen, "\r\n\r\n" );
+  else
+    snprintf( message, 200, "%s %d %s%s", "HTTP/1.1", status, reference_status_string( status ), "\r\n\r\n" );
+  len = strlen( message );
+  memcpy( buf, message, len );
+  free( message );
+  return len;
+}
+
+int main( void )
+{
+  static const int statuses[] = { 200, 201, 204, 206, 400, 403, 404, 405, 470, 500 };
+  static const size_t lengths[] = { 0, 1, 9, 10, 99, 100, 1234, 65535, 2147483647 };
+  char expected[200], built[kHTTPResponseHeaderMaxLen], received[256];
+  unsigned long long start, reference_ns, builder_ns;
+  struct sockaddr_t a;
+  volatile size_t sink = 0;
+  size_t n, m;
+  unsigned i, j;
+  int s, c, peer, got;
+
+  /* Byte for byte what the old builder wrote, for lengths it could print */
+  for( i = 0; i < sizeof(statuses)/sizeof(statuses[0]); i++ ){
+    for( j = 0; j < sizeof(lengths)/sizeof(lengths[0]); j++ ){
+      n = reference_header( expected, statuses[i], kMIMEType_JSON, lengths[j] );
+      m = HTTPResponseHeaderWrite( built, sizeof(built), statuses[i], lengths[j] ? kMIMEType_JSON : NULL, lengths[j], false );
+      test_check( m == n && memcmp( built, expected, n ) == 0 );
+    }
+  }
+  /* Too small a buffer writes nothing */
+  test_check( HTTPResponseHeaderWrite( built, 16, 200, kMIMEType_JSON, 100, false ) == 0 );
+
+  /* Header and body go out back to back */
+  s = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+  c = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+  test_check( s >= 0 && c >= 0 );
+  memset( &a, 0, sizeof(a) );
+  a.s_port = TEST_PORT;
+  a.s_ip = INADDR_ANY;
+  test_check( bind( s, &a, sizeof(a) ) == 0 && listen( s, 1 ) == 0 );
+  a.s_ip = inet_addr( "127.0.0.1" );
+  test_check( connect( c, &a, sizeof(a) ) == 0 );
+  peer = accept( s, NULL, NULL );
+  test_check( peer >= 0 );
+  test_check( SocketSendHTTPResponse( peer, kStatusOK, kMIMEType_JSON, (const uint8_t *)"{\"a\":1}", 7 ) == kNoErr );
+  n = reference_header( expected, kStatusOK, kMIMEType_JSON, 7 );
+  memcpy( expected + n, "{\"a\":1}", 7 );
+  n += 7;
+  for( m = 0; m < n; m += (size_t)got ){
+    got = recv( c, received + m, sizeof(received) - m, 0 );
+    test_check( got > 0 );
+  }
+  test_check( m == n && memcmp( received, expected, n ) == 0 );
+  close( peer );
+  close( c );
+  close( s );
+
+  start = test_time_ns( );
+  for( i = 0; i < 1000000; i++ ){
+    n = reference_header( expected, kStatusOK, kMIMEType_JSON, 100 + i % 1000 );
+    sink += (size_t)expected[n - 1];
+  }
+  reference_ns = test_time_ns( ) - start;
+  start = test_time_ns( );
+  for( i = 0; i < 1000000; i++ ){
+    n = HTTPResponseHeaderWrite( built, sizeof(built), kStatusOK, kMIMEType_JSON, 100 + i % 1000, false );
+    sink += (size_t)built[n - 1];
+  }
+  builder_ns = test_time_ns( ) - start;
+  printf( "snprintf + malloc %.2fM headers/s, builder %.2fM headers/s\r\n",
+          1e3 / ( reference_ns / 1e6 ), 1e3 / ( builder_ns / 1e6 ) );
+  (void)sink;
+
+  return 0;
+}
@@ -0,0 +1,262 @@
+/**
+******************************************************************************
+* @file    test_json_arena.c
+* @brief   json-c on a json_arena against json-c on the heap: the same text
+*          for documents built and parsed both ways, the heap calls of each as
+*          counted by json_c_heap_ops(), the block rules of the arena itself,
+*          and the time of each.
+******************************************************************************
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "json.h"
+#include "host_test.h"
+
+/* A HomeKit accessory database, the largest document the demos build */
+#define ACCESSORIES      4
+#define SERVICES         3
+#define CHARACTERISTICS  4
+
+static json_object *build(json_arena_t *arena)
+{
+  json_object *root, *accessories, *accessory, *services, *service, *characteristics, *characteristic, *perms;
+  char type[40];
+  int a, s, c, iid;
+
+  root = json_object_new_object_arena(arena);
+  accessories = json_object_new_array_arena(arena);
+  json_object_object_add(root, "accessories", accessories);
+  for (a = 0; a < ACCESSORIES; ++a) {
+    accessory = json_object_new_object_arena(arena);
+    json_object_array_add(accessories, accessory);
+    json_object_object_add(accessory, "aid", json_object_new_int_arena(arena, a + 1));
+    services = json_object_new_array_arena(arena);
+    json_object_object_add(accessory, "services", services);
+    iid = 1;
+    for (s = 0; s < SERVICES; ++s) {
+      service = json_object_new_object_arena(arena);
+      json_object_array_add(services, service);
+      sprintf(type, "%08X-0000-1000-8000-0026BB765291", 0x3E + s);
+      json_object_object_add(service, "type", json_object_new_string_arena(arena, type));
+      json_object_object_add(service, "iid", json_object_new_int_arena(arena, iid++));
+      characteristics = json_object_new_array_arena(arena);
+      json_object_object_add(service, "characteristics", characteristics);
+      for (c = 0; c < CHARACTERISTICS; ++c) {
+        characteristic = json_object_new_object_arena(arena);
+        json_object_array_add(characteristics, characteristic);
+        sprintf(type, "%08X-0000-1000-8000-0026BB765291", 0x20 + c);
+        json_object_object_add(characteristic, "type", json_object_new_string_arena(arena, type));
+        json_object_object_add(characteristic, "iid", json_object_new_int_arena(arena, iid++));
+        perms = json_object_new_array_arena(arena);
+        json_object_array_add(perms, json_object_new_string_arena(arena, "pr"));
+        json_object_array_add(perms, json_object_new_string_arena(arena, "pw"));
+        json_object_array_add(perms, json_object_new_string_arena(arena, "ev"));
+        json_object_object_add(characteristic, "perms", perms);
+        json_object_object_add(characteristic, "format", json_object_new_string_arena(arena, "float"));
+        json_object_object_add(characteristic, "value", json_object_new_double_arena(arena, 21.5 + c));
+        json_object_object_add(characteristic, "minValue", json_object_new_int64_arena(arena, -40));
+        json_object_object_add(characteristic, "ev", json_object_new_boolean_arena(arena, c & 1));
+        json_object_object_add(characteristic, "description",
+                               json_object_new_string_len_arena(arena, "Current \"Temperature\"\n", 22));
+      }
+    }
+  }
+  return root;
+}
+
+/* Text of a document, copied out since it lives in the printbuf of the root */
+static char *text(json_object *obj)
+{
+  const char *str = json_object_to_json_string(obj);
+  char *copy;
+
+  test_check(str != NULL);
+  copy = malloc(strlen(str) + 1);
+  test_check(copy != NULL);
+  strcpy(copy, str);
+  return copy;
+}
+
+static void test_build(void)
+{
+  json_object *heap_doc, *arena_doc;
+  json_arena_t *arena;
+  char *heap_text, *arena_text;
+  unsigned long ops;
+
+  ops = json_c_heap_ops();
+  heap_doc = build(NULL);
+  heap_text = text(heap_doc);
+  json_object_put(heap_doc);
+  ops = json_c_heap_ops() - ops;
+  test_check(ops > 200);
+
+  ops = json_c_heap_ops();
+  arena = json_arena_new(0);
+  test_check(arena != NULL);
+  arena_doc = build(arena);
+  test_check(json_object_get_arena(arena_doc) == arena);
+  arena_text = text(arena_doc);
+  /* Putting an arena document gives nothing back, the blocks go in one call */
+  json_object_put(arena_doc);
+  test_check(json_c_heap_ops() - ops == (unsigned long)json_arena_blocks(arena));
+  json_arena_free(arena);
+  test_check(strcmp(heap_text, arena_text) == 0);
+  free(heap_text);
+  free(arena_text);
+}
+
+static void test_parse(void)
+{
+  json_object *doc, *heap_doc, *arena_doc;
+  json_arena_t *arena;
+  char *source, *heap_text, *arena_text;
+  unsigned long heap_ops, arena_ops;
+  int blocks;
+
+  doc = build(NULL);
+  source = text(doc);
+  json_object_put(doc);
+
+  heap_ops = json_c_heap_ops();
+  heap_doc = json_tokener_parse(source);
+  test_check(heap_doc != NULL);
+  heap_text = text(heap_doc);
+  json_object_put(heap_doc);
+  heap_ops = json_c_heap_ops() - heap_ops;
+
+  arena_ops = json_c_heap_ops();
+  arena = json_arena_new(0);
+  test_check(arena != NULL);
+  arena_doc = json_tokener_parse_arena(source, arena);
+  test_check(arena_doc != NULL);
+  test_check(json_object_get_arena(arena_doc) == arena);
+  arena_text = text(arena_doc);
+  blocks = json_arena_blocks(arena);
+  json_arena_free(arena);
+  arena_ops = json_c_heap_ops() - arena_ops;
+
+  /* A malloc and a free for every block, nothing else */
+  test_check(arena_ops == 2 * (unsigned long)blocks);
+  test_check(arena_ops * 10 < heap_ops);
+  test_check(strcmp(source, heap_text) == 0);
+  test_check(strcmp(source, arena_text) == 0);
+
+  /* A document the tokener refuses leaves nothing behind but the arena */
+  arena = json_arena_new(0);
+  test_check(json_tokener_parse_arena("{\"a\":[1,2,", arena) == NULL);
+  json_arena_free(arena);
+
+  free(source);
+  free(heap_text);
+  free(arena_text);
+}
+
+static void test_blocks(void)
+{
+  json_arena_t *arena;
+  char *a, *b, *big, *c, *grown;
+  unsigned long ops;
+  int i, blocks;
+
+  arena = json_arena_new(256);
+  test_check(arena != NULL);
+  test_check(json_arena_blocks(arena) == 1);
+  test_check(json_arena_used(arena) == 0);
+
+  /* Every allocation is aligned for a double, sizes are rounded up to 8 */
+  a = json_arena_alloc(arena, 3);
+  b = json_arena_alloc(arena, 1);
+  test_check(((uintptr_t)a & 7) == 0 && ((uintptr_t)b & 7) == 0);
+  test_check(b == a + 8);
+  test_check(json_arena_used(arena) == 16);
+
+  /* Over half a block gets a block of its own, the current one keeps its room */
+  big = json_arena_alloc(arena, 200);
+  test_check(big != NULL && ((uintptr_t)big & 7) == 0);
+  test_check(json_arena_blocks(arena) == 2);
+  c = json_arena_alloc(arena, 8);
+  test_check(c == b + 8);
+  memset(big, 0x5A, 200);
+
+  /* The last allocation grows in place, anything else is copied */
+  strcpy(c, "1234567");
+  grown = json_c_realloc(arena, c, 8, 64);
+  test_check(grown == c);
+  test_check(json_arena_used(arena) == 16 + 200 + 64);
+  grown = json_c_realloc(arena, a, 8, 16);
+  test_check(grown != a);
+  grown = json_c_realloc(arena, c, 64, 128);
+  test_check(grown != c && strcmp(grown, "1234567") == 0);
+
+  /* A full block starts the next one, the blocks are the only heap calls */
+  ops = json_c_heap_ops();
+  blocks = json_arena_blocks(arena);
+  for (i = 0; i < 64; ++i)
+    test_check(json_arena_alloc(arena, 16) != NULL);
+  test_check(json_arena_blocks(arena) == blocks + 4);
+  test_check(json_c_heap_ops() - ops == 4);
+
+  /* Zeroed by calloc, freed by nothing */
+  a = json_c_calloc(arena, 4, 8);
+  for (i = 0; i < 32; ++i)
+    test_check(a[i] == 0);
+  ops = json_c_heap_ops();
+  json_c_free(arena, a);
+  test_check(json_c_heap_ops() == ops);
+  test_check(strcmp(json_c_strdup(arena, "arena"), "arena") == 0);
+
+  for (i = 0; i < 200; ++i)
+    test_check((unsigned char)big[i] == 0x5A);
+  json_arena_free(arena);
+  json_arena_free(NULL);
+}
+
+/* Heap calls and time of one build and text of the accessory database */
+static void bench(const char *name, int on_arena, unsigned long *calls)
+{
+  json_arena_t *arena = NULL;
+  json_object *doc;
+  unsigned long long start = 0, ns;
+  unsigned long ops;
+  int i, rounds = 2000;
+
+  for (i = 0; i <= rounds; ++i) {
+    if (i == 1)
+      start = test_time_ns();
+    ops = json_c_heap_ops();
+    if (on_arena)
+      arena = json_arena_new(0);
+    doc = build(arena);
+    json_object_to_json_string(doc);
+    if (on_arena)
+      json_arena_free(arena);
+    else
+      json_object_put(doc);
+    if (i == 0)
+      *calls = json_c_heap_ops() - ops;
+  }
+  ns = (test_time_ns() - start) / rounds;
+  printf("%-6s %5lu heap calls, %7llu ns per document\r\n", name, *calls, ns);
+}
+
+static void test_bench(void)
+{
+  unsigned long heap_calls, arena_calls;
+
+  printf("Accessory database of %d accessories, %d services, %d characteristics each\r\n",
+         ACCESSORIES, SERVICES, CHARACTERISTICS);
+  bench("heap", 0, &heap_calls);
+  bench("arena", 1, &arena_calls);
+  test_check(arena_calls * 10 < heap_calls);
+}
+
+int main(void)
+{
+  test_build();
+  test_parse();
+  test_blocks();
+  test_bench();
+  return 0;
+}
@@ -0,0 +1,352 @@
+/**
+******************************************************************************
+* @file    test_json_sax.c
+* @brief   Config writes through json_sax and json_sax_keys against the
+*          json_tokener_parse() tree and strcmp chain they replace: the same
+*          settings for every document, the same documents refused, and the
+*          peak heap, heap calls and time of each.
+******************************************************************************
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "json.h"
+#include "json_sax.h"
+#include "host_test.h"
+
+/* The heap seen by the process, the test links with --wrap for these */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+#define HEAP_HDR 16
+
+static size_t heap_now, heap_peak;
+static unsigned long heap_calls;
+
+static void *heap_track(size_t *p, size_t size)
+{
+  if (p == NULL)
+    return NULL;
+  p[0] = size;
+  heap_now += size;
+  if (heap_now > heap_peak)
+    heap_peak = heap_now;
+  heap_calls++;
+  return (char *)p + HEAP_HDR;
+}
+
+void *__wrap_malloc(size_t size)
+{
+  return heap_track(__real_malloc(size + HEAP_HDR), size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+  return heap_track(__real_calloc(1, nmemb * size + HEAP_HDR), nmemb * size);
+}
+
+void __wrap_free(void *ptr)
+{
+  size_t *p;
+
+  if (ptr == NULL)
+    return;
+  p = (size_t *)((char *)ptr - HEAP_HDR);
+  heap_now -= p[0];
+  heap_calls++;
+  __real_free(p);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  size_t *p;
+
+  if (ptr == NULL)
+    return __wrap_malloc(size);
+  p = (size_t *)((char *)ptr - HEAP_HDR);
+  heap_now -= p[0];
+  heap_calls--;
+  return heap_track(__real_realloc(p, size + HEAP_HDR), size);
+}
+
+static void heap_reset(void)
+{
+  heap_peak = heap_now;
+  heap_calls = 0;
+}
+
+/* The settings of the SPP demo a config write reaches, sized as in mico_Context_t */
+typedef struct {
+  char name[64];
+  int rf_power_save, mcu_power_save, bonjour, dhcp, remote_enable;
+  char ssid[33], key[65], ip[16], mask[16], gate[16], dns[16], server[64];
+  int port, baudrate;
+} settings_t;
+
+enum {
+  KEY_DEVICE_NAME, KEY_RF_POWER_SAVE, KEY_MCU_POWER_SAVE, KEY_BONJOUR, KEY_WI_FI,
+  KEY_PASSWORD, KEY_DHCP, KEY_IP_ADDRESS, KEY_NET_MASK, KEY_GATEWAY, KEY_DNS_SERVER,
+  KEY_CONNECT_SPP_SERVER, KEY_SPP_SERVER, KEY_SPP_SERVER_PORT, KEY_BAURDRATE, KEY_MAX
+};
+
+static const char * const key_names[KEY_MAX] = {
+  "Device Name", "RF power save", "MCU power save", "Bonjour", "Wi-Fi",
+  "Password", "DHCP", "IP address", "Net Mask", "Gateway", "DNS Server",
+  "Connect SPP Server", "SPP Server", "SPP Server Port", "Baurdrate",
+};
+
+static struct json_sax_keys keys;
+
+/* ConfigIncommingJsonMessage() before json_sax */
+static int tree_write(const char *input, settings_t *s)
+{
+  json_object *new_obj = json_tokener_parse(input);
+
+  if (new_obj == NULL)
+    return -1;
+  json_object_object_foreach(new_obj, key, val) {
+    if (!strcmp(key, "Device Name")) {
+      strncpy(s->name, json_object_get_string(val), sizeof(s->name) - 1);
+    } else if (!strcmp(key, "RF power save")) {
+      s->rf_power_save = json_object_get_boolean(val);
+    } else if (!strcmp(key, "MCU power save")) {
+      s->mcu_power_save = json_object_get_boolean(val);
+    } else if (!strcmp(key, "Bonjour")) {
+      s->bonjour = json_object_get_boolean(val);
+    } else if (!strcmp(key, "Wi-Fi")) {
+      strncpy(s->ssid, json_object_get_string(val), sizeof(s->ssid) - 1);
+    } else if (!strcmp(key, "Password")) {
+      strncpy(s->key, json_object_get_string(val), sizeof(s->key) - 1);
+    } else if (!strcmp(key, "DHCP")) {
+      s->dhcp = json_object_get_boolean(val);
+    } else if (!strcmp(key, "IP address")) {
+      strncpy(s->ip, json_object_get_string(val), sizeof(s->ip) - 1);
+    } else if (!strcmp(key, "Net Mask")) {
+      strncpy(s->mask, json_object_get_string(val), sizeof(s->mask) - 1);
+    } else if (!strcmp(key, "Gateway")) {
+      strncpy(s->gate, json_object_get_string(val), sizeof(s->gate) - 1);
+    } else if (!strcmp(key, "DNS Server")) {
+      strncpy(s->dns, json_object_get_string(val), sizeof(s->dns) - 1);
+    } else if (!strcmp(key, "Connect SPP Server")) {
+      s->remote_enable = json_object_get_boolean(val);
+    } else if (!strcmp(key, "SPP Server")) {
+      strncpy(s->server, json_object_get_string(val), sizeof(s->server) - 1);
+    } else if (!strcmp(key, "SPP Server Port")) {
+      s->port = json_object_get_int(val);
+    } else if (!strcmp(key, "Baurdrate")) {
+      s->baudrate = json_object_get_int(val);
+    }
+  }
+  json_object_put(new_obj);
+  return 0;
+}
+
+static void sax_value(void *userdata, const struct json_sax_value *value)
+{
+  settings_t *s = userdata;
+
+  if (value->event != json_sax_event_value || value->depth != 1)
+    return;
+
+  switch (json_sax_keys_find(&keys, value->key)) {
+    case KEY_DEVICE_NAME:        strncpy(s->name, json_sax_get_string(value), sizeof(s->name) - 1); break;
+    case KEY_RF_POWER_SAVE:      s->rf_power_save = json_sax_get_boolean(value); break;
+    case KEY_MCU_POWER_SAVE:     s->mcu_power_save = json_sax_get_boolean(value); break;
+    case KEY_BONJOUR:            s->bonjour = json_sax_get_boolean(value); break;
+    case KEY_WI_FI:              strncpy(s->ssid, json_sax_get_string(value), sizeof(s->ssid) - 1); break;
+    case KEY_PASSWORD:           strncpy(s->key, json_sax_get_string(value), sizeof(s->key) - 1); break;
+    case KEY_DHCP:               s->dhcp = json_sax_get_boolean(value); break;
+    case KEY_IP_ADDRESS:         strncpy(s->ip, json_sax_get_string(value), sizeof(s->ip) - 1); break;
+    case KEY_NET_MASK:           strncpy(s->mask, json_sax_get_string(value), sizeof(s->mask) - 1); break;
+    case KEY_GATEWAY:            strncpy(s->gate, json_sax_get_string(value), sizeof(s->gate) - 1); break;
+    case KEY_DNS_SERVER:         strncpy(s->dns, json_sax_get_string(value), sizeof(s->dns) - 1); break;
+    case KEY_CONNECT_SPP_SERVER: s->remote_enable = json_sax_get_boolean(value); break;
+    case KEY_SPP_SERVER:         strncpy(s->server, json_sax_get_string(value), sizeof(s->server) - 1); break;
+    case KEY_SPP_SERVER_PORT:    s->port = json_sax_get_int(value); break;
+    case KEY_BAURDRATE:          s->baudrate = json_sax_get_int(value); break;
+    default: break;
+  }
+}
+
+/* ConfigIncommingJsonMessage() now: checked first, then applied */
+static int sax_write(const char *input, settings_t *s)
+{
+  struct json_sax *sax = malloc(sizeof(struct json_sax));
+  int err = -1;
+
+  test_check(sax != NULL);
+  if (json_sax_parse(sax, input, -1, NULL, NULL) == json_tokener_success) {
+    json_sax_parse(sax, input, -1, sax_value, s);
+    err = 0;
+  }
+  free(sax);
+  return err;
+}
+
+static void check_same(const char *input, int expect_err)
+{
+  settings_t tree, sax;
+
+  memset(&tree, 0x5A, sizeof(tree));
+  memset(&sax, 0x5A, sizeof(sax));
+  tree.name[sizeof(tree.name) - 1] = sax.name[sizeof(sax.name) - 1] = 0;
+
+  test_check(tree_write(input, &tree) == expect_err);
+  test_check(sax_write(input, &sax) == expect_err);
+  if (memcmp(&tree, &sax, sizeof(tree)) != 0)
+    printf("settings differ for %s\r\n", input);
+  test_check(memcmp(&tree, &sax, sizeof(tree)) == 0);
+}
+
+static const char *full_write =
+  "{\"Device Name\":\"MiCOKit \\u00e9 \\\"3165\\\"\",\"RF power save\":false,\"MCU power save\":true,"
+  "\"Bonjour\":true,\"Wi-Fi\":\"Office 2.4G\",\"Password\":\"p@ss\\/word\\t1\",\"DHCP\":false,"
+  "\"IP address\":\"192.168.1.20\",\"Net Mask\":\"255.255.255.0\",\"Gateway\":\"192.168.1.1\","
+  "\"DNS Server\":\"192.168.1.1\",\"Connect SPP Server\":true,\"SPP Server\":\"spp.example.com\","
+  "\"SPP Server Port\":8080,\"Baurdrate\":115200}";
+
+static void test_documents(void)
+{
+  settings_t s;
+
+  check_same(full_write, 0);
+  check_same("{}", 0);
+  check_same(" { \"Wi-Fi\" : \"home\" , \"DHCP\" : true } ", 0);
+  /* Conversions: numbers and strings for booleans, strings and doubles for ints */
+  check_same("{\"DHCP\":1,\"Bonjour\":0,\"RF power save\":\"\",\"MCU power save\":\"no\",\"Connect SPP Server\":0.5}", 0);
+  check_same("{\"Baurdrate\":\"9600\",\"SPP Server Port\":80.9,\"DHCP\":null}", 0);
+  check_same("{\"Baurdrate\":99999999999,\"SPP Server Port\":-99999999999}", 0);
+  check_same("{\"Baurdrate\":\"fast\",\"SPP Server Port\":true}", 0);
+  /* An out of range number does not clamp the ones after it */
+  test_check(sax_write("{\"Baurdrate\":4294967296,\"SPP Server Port\":-7}", &s) == 0);
+  test_check(s.baudrate == INT32_MAX && s.port == -7);
+  test_check(tree_write("{\"SPP Server Port\":-7}", &s) == 0 && s.port == -7);
+  check_same("{\"Device Name\":12,\"Wi-Fi\":false,\"Password\":1.5e3}", 0);
+  /* Long values are cut to the setting, nested members are not settings */
+  check_same("{\"Password\":\"0123456789012345678901234567890123456789012345678901234567890123456789\"}", 0);
+  check_same("{\"Extra\":{\"Wi-Fi\":\"nested\",\"List\":[1,{\"DHCP\":true}]},\"Wi-Fi\":\"top\"}", 0);
+  check_same("{\"wi-fi\":\"case\",\"Wi-Fi \":\"space\",\"Wi\":\"prefix\",\"Wi-Fi\":\"last\"}", 0);
+  /* A repeated member keeps its last value */
+  check_same("{\"Wi-Fi\":\"first\",\"DHCP\":true,\"Wi-Fi\":\"second\"}", 0);
+  /* json_tokener_parse() takes a trailing comma and stops after the first value */
+  check_same("{\"Wi-Fi\":\"home\",\"Extra\":[1,2,],}", 0);
+  check_same("{\"Wi-Fi\":\"home\"} trailing", 0);
+
+  /* Refused by both, nothing changes */
+  check_same("", -1);
+  check_same("{", -1);
+  check_same("{\"Wi-Fi\":\"home\"", -1);
+  check_same("{\"Wi-Fi\" \"home\"}", -1);
+  check_same("{\"Wi-Fi\":\"home\",,}", -1);
+  check_same("{,}", -1);
+  check_same("{\"Wi-Fi\":tru}", -1);
+}
+
+static uint32_t rnd_state = 2463534242U;
+
+static uint32_t rnd(void)
+{
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+/* Random writes over the keys of the demo and a few others */
+static void test_random(void)
+{
+  static const char * const values[] = {
+    "true", "false", "0", "1", "-7", "115200", "4294967296", "2.5", "-0.0", "1e2",
+    "\"\"", "\"9600\"", "\"abc\"", "\"a\\\"b\\\\c\"", "\"\\u0041\\u00df\"", "\"10.0.0.1\"",
+    "[]", "[1,\"x\"]", "{\"Wi-Fi\":\"in\"}",
+  };
+  static const char * const others[] = { "Unknown", "DHCP2", "", "Bonjour\\u0020" };
+  char doc[1024];
+  int i, n, members, len;
+
+  for (i = 0; i < 5000; ++i) {
+    len = sprintf(doc, "{");
+    members = rnd() % 12;
+    for (n = 0; n < members; ++n) {
+      const char *key = (rnd() % 5) ? key_names[rnd() % KEY_MAX] : others[rnd() % 4];
+      const char *value = values[rnd() % (sizeof(values) / sizeof(values[0]))];
+      /* A setting takes the text or value of an array or object from the tree, nothing from json_sax */
+      if (json_sax_keys_find(&keys, key) >= 0 && (value[0] == '[' || value[0] == '{'))
+        value = "\"x\"";
+      len += sprintf(doc + len, "%s\"%s\":%s", n ? "," : "", key, value);
+    }
+    sprintf(doc + len, "}");
+    check_same(doc, 0);
+    /* Cut anywhere inside, refused by both */
+    if (len > 1) {
+      doc[1 + rnd() % (len - 1)] = '\0';
+      check_same(doc, -1);
+    }
+  }
+}
+
+static void test_keys(void)
+{
+  struct json_sax_keys k;
+  int i;
+
+  for (i = 0; i < KEY_MAX; ++i)
+    test_check(json_sax_keys_find(&keys, key_names[i]) == i);
+  test_check(json_sax_keys_find(&keys, "") == -1);
+  test_check(json_sax_keys_find(&keys, "Wi-F") == -1);
+  test_check(json_sax_keys_find(&keys, "Wi-Fi ") == -1);
+  test_check(json_sax_keys_find(&keys, "dhcp") == -1);
+  test_check(json_sax_keys_find(&keys, NULL) == -1);
+
+  /* No names, or more than half the slots, are refused */
+  test_check(json_sax_keys_init(&k, key_names, 0) == -1);
+  test_check(json_sax_keys_find(&k, "DHCP") == -1);
+  test_check(json_sax_keys_init(&k, key_names, JSON_SAX_KEY_SLOTS / 2 + 1) == -1);
+}
+
+/* Peak heap, heap calls and time of one write */
+static void bench(const char *name, int (*write)(const char *, settings_t *), size_t *peak, unsigned long *calls)
+{
+  settings_t s;
+  unsigned long long start, ns;
+  int i, rounds = 20000;
+
+  heap_reset();
+  test_check(write(full_write, &s) == 0);
+  *peak = heap_peak - heap_now;
+  *calls = heap_calls;
+
+  start = test_time_ns();
+  for (i = 0; i < rounds; ++i)
+    write(full_write, &s);
+  ns = (test_time_ns() - start) / rounds;
+  printf("%-22s %6u bytes peak heap, %4lu heap calls, %6llu ns per write\r\n",
+         name, (unsigned int)*peak, *calls, ns);
+}
+
+static void test_bench(void)
+{
+  size_t tree_peak, sax_peak;
+  unsigned long tree_calls, sax_calls;
+
+  printf("Config write of %u bytes, %d settings\r\n", (unsigned int)strlen(full_write), KEY_MAX);
+  bench("json_tokener_parse", tree_write, &tree_peak, &tree_calls);
+  bench("json_sax", sax_write, &sax_peak, &sax_calls);
+
+  /* json_sax takes its own state and nothing else */
+  test_check(sax_peak == sizeof(struct json_sax));
+  test_check(sax_calls == 2);
+  test_check(tree_calls > 2 * KEY_MAX);
+}
+
+int main(void)
+{
+  test_check(json_sax_keys_init(&keys, key_names, KEY_MAX) == 0);
+  test_keys();
+  test_documents();
+  test_random();
+  test_bench();
+  return 0;
+}
@@ -0,0 +1,469 @@
+/**
+******************************************************************************
+* @file    test_mdns.c
+* @brief   Known-answer suppression of the mDNS responder: the records of the
+*          prebuilt service response are sent back as known answers, a record
+*          is only suppressed while its type, class and rdata still match.
+*          Then, on a clock and a random source driven by the test: the
+*          20-120 ms delay of shared answers and their aggregation, the
+*          400-500 ms delay after a truncated query, the 1 s limit between
+*          two multicasts of a record, and a replay of query traffic.
+******************************************************************************
+*/
+
+/* The clock, the random delays and the socket of the responder are the models below */
+#define mico_get_time               clock_now
+#define MicoRandomNumberRead        random_read
+#define sendto                      net_sendto
+
+#include "../../../Support/MDNSUtils.c"
+#include "host_test.h"
+
+#define ALL_SERVICE_RECORDS  ( MDNS_SERVICE_RECORDS(0) )
+#define SERVICES_RECORD      MDNS_RECORD_BIT(MDNS_RECORD_SERVICES)
+#define PTR_RECORD           MDNS_RECORD_BIT(MDNS_RECORD_PTR(0))
+#define A_RECORD             MDNS_RECORD_BIT(MDNS_RECORD_HOST_A)
+#define MAX_SENT             16
+
+static uint8_t packet[MDNS_PACKET_SIZE];
+
+/* A multicast of the responder: when, and the records of its answer section and of the whole message */
+typedef struct {
+  uint32_t at;
+  uint32_t answers;
+  uint32_t records;
+} sent_t;
+
+static uint32_t now = 5000;
+static uint32_t random_value;
+static sent_t sent[MAX_SENT];
+static int sent_count;
+
+uint32_t clock_now( void )
+{
+  return now;
+}
+
+OSStatus random_read( void *inBuffer, int inByteCount )
+{
+  test_check( inByteCount == sizeof(uint32_t) );
+  memcpy( inBuffer, &random_value, sizeof(uint32_t) );
+  return kNoErr;
+}
+
+static uint32_t records_in( uint8_t* message, uint16_t count );
+
+ssize_t net_sendto( int sockfd, const void *buf, size_t len, int flags, const struct sockaddr_t *dest_addr, socklen_t addrlen )
+{
+  static uint8_t message[MDNS_PACKET_SIZE];
+  dns_message_header_t* header = (dns_message_header_t*) message;
+  (void)sockfd; (void)flags; (void)addrlen;
+
+  test_check( len <= sizeof(message) && sent_count < MAX_SENT );
+  test_check( dest_addr->s_ip == inet_addr("224.0.0.251") && dest_addr->s_port == 5353 );
+  memcpy( message, buf, len );
+  sent[sent_count].at = now;
+  sent[sent_count].answers = records_in( message, ntohs(header->answer_count) );
+  sent[sent_count].records = records_in( message, ntohs(header->answer_count) + ntohs(header->additional_record_count) );
+  sent_count++;
+  return (ssize_t)len;
+}
+
+/* The port has no Wi-Fi driver, the responder runs on a fixed station address */
+OSStatus micoWlanGetIPStatus( IPStatusTypedef *outNetpara, WiFi_Interface inInterface )
+{
+  (void)inInterface;
+  memset( outNetpara, 0, sizeof(IPStatusTypedef) );
+  strcpy( outNetpara->ip, "192.168.1.10" );
+  return kNoErr;
+}
+
+/* Copy the service response as a query whose answer section holds the records the querier knows */
+static uint16_t known_answers_packet( void )
+{
+  dns_sd_service_record_t* service = available_services;
+
+  memcpy( packet, service->response, service->response_length );
+  ((dns_message_header_t*) packet)->flags = 0;
+  return service->response_length;
+}
+
+static uint32_t known_answers( uint16_t length )
+{
+  dns_message_iterator_t iter;
+
+  iter.header = (dns_message_header_t*) packet;
+  iter.iter   = packet + sizeof(dns_message_header_t);
+  iter.end    = packet + length;
+  return mdns_process_known_answers( &iter );
+}
+
+/* Our records among the first count records of a message, read back as if they were known answers */
+static uint32_t records_in( uint8_t* message, uint16_t count )
+{
+  dns_message_header_t* header = (dns_message_header_t*) message;
+  dns_message_iterator_t iter;
+  uint16_t answer_count = header->answer_count;
+  uint32_t records;
+
+  header->answer_count = htons( count );
+  iter.header = header;
+  iter.iter   = message + sizeof(dns_message_header_t);
+  iter.end    = message + MDNS_PACKET_SIZE;
+  records = mdns_process_known_answers( &iter );
+  header->answer_count = answer_count;
+  return records;
+}
+
+/* A query with one question, and a PTR known answer for the service instance when instance is set */
+static uint16_t query( uint16_t flags, const char* question, uint16_t type, const char* instance )
+{
+  dns_message_iterator_t iter;
+  uint8_t* rd_length;
+
+  iter.header = (dns_message_header_t*) packet;
+  iter.iter   = packet + sizeof(dns_message_header_t);
+  iter.end    = packet + sizeof(packet);
+  dns_write_header( &iter, 0x1234, flags, question ? 1 : 0, instance ? 1 : 0, 0 );
+  if ( question ) {
+    dns_write_string( &iter, question );
+    dns_write_uint16( &iter, type );
+    dns_write_uint16( &iter, RR_CLASS_IN );
+  }
+  if ( instance ) {
+    dns_write_string( &iter, "_hap._tcp.local." );
+    rd_length = dns_write_record_fields( &iter, RR_CLASS_IN, RR_TYPE_PTR, MDNS_SERVICE_TTL, NULL );
+    dns_write_string( &iter, instance );
+    dns_end_record( &iter, rd_length );
+  }
+  return iter.iter - packet;
+}
+
+static void receive( uint8_t* message, uint16_t length )
+{
+  mfi_mdns_handler( 0, message, length );
+}
+
+/* Runs the responder loop until the given time, the pending answers are sent when they are due */
+static void run_until( uint32_t until )
+{
+  uint32_t wait;
+
+  while ( 1 ) {
+    wait = mdns_send_pending_answers( 0 );
+    if ( wait == 0xFFFFFFFF || now + wait > until )
+      break;
+    test_check( wait > 0 );
+    now += wait;
+  }
+  now = until;
+}
+
+/* Starts from a quiet responder: nothing pending, no record sent recently */
+static void quiet( void )
+{
+  now += 10000;
+  run_until( now );
+  sent_count = 0;
+}
+
+/* random_value giving the wanted delay from the random range */
+static void random_delay( uint32_t offset )
+{
+  random_value = offset;
+}
+
+/* Random values giving the shortest and the longest delay, then one past the range, and those delays */
+static const uint32_t random_bounds[3] = { 0, 99, 100 };
+static const uint32_t shared_delays[3] = { 20, 119, 20 };
+static const uint32_t truncated_delays[3] = { 400, 499, 400 };
+
+static void test_shared_delay( void )
+{
+  uint16_t length;
+  uint32_t start;
+  int i;
+
+  /* The shared PTR answer waits 20 ms at least and 119 ms at most */
+  for ( i = 0; i < 3; i++ ) {
+    quiet();
+    random_delay( random_bounds[i] );
+    start = now;
+    length = query( 0, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+    receive( packet, length );
+    test_check( sent_count == 0 );
+    run_until( start + shared_delays[i] - 1 );
+    test_check( sent_count == 0 );
+    run_until( start + shared_delays[i] );
+    test_check( sent_count == 1 && sent[0].at == start + shared_delays[i] );
+    test_check( ( sent[0].answers & PTR_RECORD ) && sent[0].records == ALL_SERVICE_RECORDS );
+  }
+
+  /* A unique record is not delayed */
+  quiet();
+  length = query( 0, "MiCOKit-1234.local.", RR_TYPE_A, NULL );
+  receive( packet, length );
+  test_check( sent_count == 1 && sent[0].at == now && sent[0].answers == A_RECORD );
+}
+
+static void test_truncated_delay( void )
+{
+  uint16_t length;
+  uint32_t start;
+  int i;
+
+  /* More known answers follow a truncated query, the answer waits 400 ms at least and 499 ms at most */
+  for ( i = 0; i < 3; i++ ) {
+    quiet();
+    random_delay( random_bounds[i] );
+    start = now;
+    length = query( DNS_MESSAGE_TRUNCATION, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+    receive( packet, length );
+    run_until( start + truncated_delays[i] - 1 );
+    test_check( sent_count == 0 );
+    run_until( start + truncated_delays[i] );
+    test_check( sent_count == 1 && ( sent[0].answers & PTR_RECORD ) );
+  }
+
+  /* Even a unique record waits for the rest of a truncated query */
+  quiet();
+  random_delay( 0 );
+  start = now;
+  length = query( DNS_MESSAGE_TRUNCATION, "MiCOKit-1234.local.", RR_TYPE_A, NULL );
+  receive( packet, length );
+  test_check( sent_count == 0 );
+  run_until( start + truncated_delays[0] );
+  test_check( sent_count == 1 && sent[0].at == start + truncated_delays[0] && sent[0].answers == A_RECORD );
+
+  /* The PTR known answer in the next packet suppresses the waiting answer */
+  quiet();
+  start = now;
+  length = query( DNS_MESSAGE_TRUNCATION, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  now += 5;
+  length = query( 0, NULL, 0, "Kit 1234._hap._tcp.local." );
+  receive( packet, length );
+  run_until( start + truncated_delays[1] + 1 );
+  test_check( sent_count == 0 );
+}
+
+static void test_aggregation( void )
+{
+  uint16_t length;
+  uint32_t start;
+
+  /* Two queriers ask for shared records within the delay, both are answered in one message */
+  quiet();
+  random_delay( 50 );
+  start = now;
+  length = query( 0, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  now += 10;
+  random_delay( 0 );
+  length = query( 0, MFi_SERVICE_QUERY_NAME, RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  run_until( start + 1000 );
+  test_check( sent_count == 1 && sent[0].at == start + 70 );
+  test_check( sent[0].answers == ( SERVICES_RECORD | PTR_RECORD ) && sent[0].records == ( ALL_SERVICE_RECORDS | SERVICES_RECORD ) );
+
+  /* The later deadline of the two is kept */
+  quiet();
+  random_delay( 0 );
+  start = now;
+  length = query( 0, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  now += 10;
+  random_delay( 90 );
+  length = query( 0, MFi_SERVICE_QUERY_NAME, RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  run_until( start + 1000 );
+  test_check( sent_count == 1 && sent[0].at == start + 10 + 110 );
+  test_check( sent[0].answers == ( SERVICES_RECORD | PTR_RECORD ) );
+}
+
+static void test_rate_limit( void )
+{
+  uint16_t length;
+  uint32_t start;
+
+  /* A record is multicast again 1 s after it was, not earlier */
+  quiet();
+  start = now;
+  length = query( 0, "MiCOKit-1234.local.", RR_TYPE_A, NULL );
+  receive( packet, length );
+  now = start + 999;
+  receive( packet, length );
+  test_check( sent_count == 1 );
+  now = start + 1000;
+  receive( packet, length );
+  test_check( sent_count == 2 && sent[1].at == start + 1000 );
+
+  /* The records just sent are left out of a merged answer, the others still go */
+  quiet();
+  random_delay( 50 );
+  start = now;
+  length = query( 0, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  now += 10;
+  length = query( 0, "MiCOKit-1234.local.", RR_TYPE_A, NULL );
+  receive( packet, length );
+  test_check( sent_count == 1 && sent[0].answers == A_RECORD );
+  run_until( start + 1000 );
+  test_check( sent_count == 2 && ( sent[1].answers & PTR_RECORD ) );
+  test_check( sent[1].records == ( ALL_SERVICE_RECORDS & ~A_RECORD ) );
+
+  /* The announcement counts as a multicast of every record */
+  quiet();
+  start = now;
+  mfi_bonjour_send( 0 );
+  test_check( sent_count == 2 );
+  length = query( 0, "MiCOKit-1234.local.", RR_TYPE_A, NULL );
+  receive( packet, length );
+  random_delay( 0 );
+  length = query( 0, "_hap._tcp.local.", RR_TYPE_PTR, NULL );
+  receive( packet, length );
+  run_until( start + 999 );
+  test_check( sent_count == 2 );
+}
+
+/* Query traffic of a controller browsing for accessories, replayed with its timing. The
+   first browse is truncated and its second packet holds our PTR, so it is not answered.
+   The controller asks again without known answers, a second querier asks for the host
+   address and a third enumerates the services while the answer waits */
+static const uint8_t browse_truncated[] = {
+  0x00, 0x00, 0x02, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+  0x04, '_', 'h', 'a', 'p', 0x04, '_', 't', 'c', 'p', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+  0x00, 0x0C, 0x00, 0x01,
+  0xC0, 0x0C, 0x00, 0x0C, 0x00, 0x01, 0x00, 0x00, 0x11, 0x94, 0x00, 0x07,
+  0x04, 'L', 'a', 'm', 'p', 0xC0, 0x0C,
+};
+static const uint8_t browse_known_answers[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+  0x04, '_', 'h', 'a', 'p', 0x04, '_', 't', 'c', 'p', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+  0x00, 0x0C, 0x00, 0x01, 0x00, 0x00, 0x11, 0x94, 0x00, 0x0B,
+  0x08, 'K', 'i', 't', ' ', '1', '2', '3', '4', 0xC0, 0x0C,
+};
+static const uint8_t browse[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x04, '_', 'h', 'a', 'p', 0x04, '_', 't', 'c', 'p', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+  0x00, 0x0C, 0x00, 0x01,
+};
+static const uint8_t host_query[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x0C, 'M', 'i', 'C', 'O', 'K', 'i', 't', '-', '1', '2', '3', '4', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+  0x00, 0x01, 0x00, 0x01,
+};
+static const uint8_t services_query[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x09, '_', 's', 'e', 'r', 'v', 'i', 'c', 'e', 's', 0x07, '_', 'd', 'n', 's', '-', 's', 'd',
+  0x04, '_', 'u', 'd', 'p', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+  0x00, 0x0C, 0x00, 0x01,
+};
+
+typedef struct {
+  uint32_t       at;
+  uint32_t       random;
+  const uint8_t* message;
+  uint16_t       length;
+} traffic_t;
+
+static const traffic_t traffic[] = {
+  {    0,  30, browse_truncated,     sizeof(browse_truncated) },
+  {    4,   0, browse_known_answers, sizeof(browse_known_answers) },
+  { 1200,  60, browse,               sizeof(browse) },
+  { 1230,   0, host_query,           sizeof(host_query) },
+  { 1250,  20, services_query,       sizeof(services_query) },
+};
+
+static void test_traffic( void )
+{
+  uint32_t start;
+  size_t i;
+
+  quiet();
+  start = now;
+  for ( i = 0; i < sizeof(traffic)/sizeof(traffic[0]); i++ ) {
+    run_until( start + traffic[i].at );
+    random_delay( traffic[i].random );
+    memcpy( packet, traffic[i].message, traffic[i].length );
+    receive( packet, traffic[i].length );
+  }
+  run_until( start + 3000 );
+
+  /* The host address at once, then one message for the browse and the enumeration, without it */
+  test_check( sent_count == 2 );
+  test_check( sent[0].at == start + 1230 && sent[0].answers == A_RECORD );
+  test_check( sent[1].at == start + 1250 + 40 );
+  test_check( sent[1].answers == ( SERVICES_RECORD | PTR_RECORD ) );
+  test_check( sent[1].records == ( ( ALL_SERVICE_RECORDS | SERVICES_RECORD ) & ~A_RECORD ) );
+}
+
+/* Offset of the rdata of the n-th answer in the packet */
+static uint8_t* record_rdata( int n, dns_record_t* record )
+{
+  dns_message_iterator_t iter;
+  dns_name_t name;
+
+  iter.header = (dns_message_header_t*) packet;
+  iter.iter   = packet + sizeof(dns_message_header_t);
+  iter.end    = packet + sizeof(packet);
+  do {
+    dns_get_next_record( &iter, record, &name );
+  } while ( n-- );
+  return record->rdata.iter;
+}
+
+int main( void )
+{
+  bonjour_init_t init;
+  dns_record_t record;
+  uint16_t length;
+  uint8_t* rdata;
+
+  memset( &init, 0, sizeof(init) );
+  init.service_name  = "_hap._tcp.local.";
+  init.host_name     = "MiCOKit-1234.local.";
+  init.instance_name = "Kit 1234";
+  init.txt_record    = "c#=1.id=aa:bb";
+  init.service_port  = 80;
+  bonjour_service_init( init );
+  test_check( available_services != NULL && available_services->response != NULL );
+
+  /* Records as this responder sends them are all known */
+  length = known_answers_packet();
+  test_check( known_answers( length ) == ALL_SERVICE_RECORDS );
+
+  /* Answer order in the prebuilt response is PTR, SRV, A, TXT */
+  length = known_answers_packet();
+  rdata = record_rdata( 1, &record );
+  test_check( record.record_type == RR_TYPE_SRV );
+  rdata[5] ^= 1;
+  test_check( known_answers( length ) == ( ALL_SERVICE_RECORDS & ~MDNS_RECORD_BIT(MDNS_RECORD_SRV(0)) ) );
+
+  length = known_answers_packet();
+  rdata = record_rdata( 3, &record );
+  test_check( record.record_type == RR_TYPE_TXT );
+  rdata[record.rd_length - 1] ^= 1;
+  test_check( known_answers( length ) == ( ALL_SERVICE_RECORDS & ~MDNS_RECORD_BIT(MDNS_RECORD_TXT(0)) ) );
+
+  /* A record of another class is not the same record */
+  length = known_answers_packet();
+  rdata = record_rdata( 3, &record );
+  rdata[-7] = 3;
+  test_check( known_answers( length ) == ( ALL_SERVICE_RECORDS & ~MDNS_RECORD_BIT(MDNS_RECORD_TXT(0)) ) );
+
+  /* A querier holding the TXT record from before an update does not suppress the new one */
+  length = known_answers_packet();
+  bonjour_update_txt_record( "c#=2.id=aa:bb" );
+  test_check( known_answers( length ) == ( ALL_SERVICE_RECORDS & ~MDNS_RECORD_BIT(MDNS_RECORD_TXT(0)) ) );
+  length = known_answers_packet();
+  test_check( known_answers( length ) == ALL_SERVICE_RECORDS );
+
+  test_shared_delay();
+  test_truncated_delay();
+  test_aggregation();
+  test_rate_limit();
+  test_traffic();
+
+  return 0;
+}
@@ -0,0 +1,326 @@
+/**
+******************************************************************************
+* @file    test_ntp.c
+* @brief   NTP client in virtual time against a server in the test, with a
+*          tick and a 1 s RTC that both drift. The network is given as the
+*          argument: steady (asymmetric delay, jitter, spikes and drops),
+*          tick_step (the tick frequency steps by 8 ppm), outage (Wi-Fi down
+*          for 10 h), lossy (more jitter, drops, short and foreign datagrams)
+*          and long (60 days, across the tick wrap). Checks the clock error,
+*          the packets sent and the RTC trim. Prints them.
+******************************************************************************
+*/
+
+#include <setjmp.h>
+#include <math.h>
+
+/* The sockets, the RTOS, the RTC and the clock of the client are the models below */
+#define socket                      net_socket
+#define bind                        net_bind
+#define sendto                      net_sendto
+#define select                      net_select
+#define recvfrom                    net_recvfrom
+#define inet_addr                   net_inet_addr
+#define SocketClose                 net_close
+#define MICOGetHostByName           net_gethostbyname
+#define MICOAddNotification         notify_add
+#define MICORemoveNotification      notify_remove
+#define MicoRtcGetTime              rtc_get_time
+#define MicoRtcSetTime              rtc_set_time
+#define MicoRtcSetDrift             rtc_set_drift
+#define mico_get_time               tick_time
+#define msleep                      tick_msleep
+#define sleep                       tick_sleep
+#define mico_rtos_create_thread     os_create_thread
+#define mico_rtos_delete_thread     os_delete_thread
+#define mico_rtos_init_mutex        os_init_mutex
+#define mico_rtos_lock_mutex        os_lock_mutex
+#define mico_rtos_unlock_mutex      os_unlock_mutex
+#define mico_rtos_init_semaphore    os_init_semaphore
+#define mico_rtos_set_semaphore     os_set_semaphore
+#define mico_rtos_get_semaphore     os_get_semaphore
+#define mico_rtos_deinit_semaphore  os_deinit_semaphore
+
+#include "../../../MICO/MICONTPClient.c"
+#include "host_test.h"
+
+#define SERVER_IP       0x0A000001
+#define START_TIME      1792368000000.0     /* ms since 1970, 2026-10-19 UTC */
+#define SETTLE_TIME     ( 6 * 3600e3 )      /* ms before the clock error is counted */
+
+mico_mutex_t stdio_tx_mutex;
+
+/* The network */
+static double tick_ppm = 35.0;              /* The tick runs fast */
+static double jitter_mean = 10, spike_p = 0.03, drop_p = 0.05;
+static double short_p, foreign_p;
+static double tick_step_at = -1, tick_step_ppm;
+static double outage_from = -1, outage_to = -1;
+
+static double now;                          /* True time, ms since 1970 */
+static double origin;                       /* True time of tick 0 */
+static double horizon;
+static jmp_buf done;
+static unsigned long packets;
+
+/* Clock error after SETTLE_TIME */
+static double error_max, error_sum2, rtc_error_max;
+static unsigned long error_n;
+
+static double rtc_true_error( void );
+
+static double urand( void ) { return ( rand( ) + 0.5 ) / ( (double)RAND_MAX + 1 ); }
+static double expo( double mean ) { return -mean * log( urand( ) ); }
+
+/* Starts 1 M ticks before the wrap */
+uint32_t tick_time( void )
+{
+  return (uint32_t)(int64_t)floor( ( now - origin ) * ( 1 + tick_ppm * 1e-6 ) ) + 0xFFF00000u;
+}
+
+static void sample_error( void )
+{
+  double e;
+
+  if( !_clock.valid || now - origin < SETTLE_TIME )
+    return;
+  e = (double)ntp_clock_at( tick_time( ) ) - now;
+  if( fabs( e ) > error_max ) error_max = fabs( e );
+  error_sum2 += e * e;
+  error_n++;
+  if( !_rtc.noRtc && fabs( rtc_true_error( ) ) > rtc_error_max )
+    rtc_error_max = fabs( rtc_true_error( ) );
+}
+
+/* Runs the world for a number of ticks, up to the end of the test */
+static void advance( double ticks )
+{
+  double end = now + ticks / ( 1 + tick_ppm * 1e-6 );
+  double step, tick;
+
+  while( now < end ){
+    step = end - now < 60000 ? end - now : 60000;
+    if( tick_step_at >= 0 && now < origin + tick_step_at && now + step >= origin + tick_step_at ){
+      /* The tick count goes on from where it was at the new rate */
+      tick = ( now + step - origin ) * ( 1 + tick_ppm * 1e-6 );
+      now += step;
+      tick_ppm += tick_step_ppm;
+      origin = now - tick / ( 1 + tick_ppm * 1e-6 );
+    }else
+      now += step;
+    if( outage_from >= 0 && now >= origin + outage_from && now < origin + outage_to && _wifiConnected )
+      ntpNotify_WifiStatusHandler( NOTIFY_STATION_DOWN, NULL );
+    sample_error( );
+    if( now - origin > horizon )
+      longjmp( done, 1 );
+  }
+}
+
+void tick_msleep( uint32_t ms ) { advance( ms ); }
+void tick_sleep( uint32_t seconds ) { advance( seconds * 1000.0 ); }
+
+OSStatus os_create_thread( mico_thread_t* thread, uint8_t priority, const char* name,
+                           mico_thread_function_t function, uint32_t stack_size, void* arg ) { return kNoErr; }
+OSStatus os_delete_thread( mico_thread_t* thread )
+{
+  test_check( "the client thread does not end" == NULL );
+  return kNoErr;
+}
+OSStatus os_init_mutex( mico_mutex_t* mutex ) { *mutex = (mico_mutex_t)1; return kNoErr; }
+OSStatus os_lock_mutex( mico_mutex_t* mutex ) { return kNoErr; }
+OSStatus os_unlock_mutex( mico_mutex_t* mutex ) { return kNoErr; }
+OSStatus os_init_semaphore( mico_semaphore_t* semaphore, int count ) { *semaphore = (mico_semaphore_t)1; return kNoErr; }
+OSStatus os_set_semaphore( mico_semaphore_t* semaphore ) { return kNoErr; }
+OSStatus os_deinit_semaphore( mico_semaphore_t* semaphore ) { return kNoErr; }
+
+/* Waiting for the Wi-Fi, which comes back at the end of the outage */
+OSStatus os_get_semaphore( mico_semaphore_t* semaphore, uint32_t timeout_ms )
+{
+  double up = origin + outage_to;
+
+  if( outage_to >= 0 && up - now < timeout_ms ){
+    advance( up - now + 1 );
+    ntpNotify_WifiStatusHandler( NOTIFY_STATION_UP, NULL );
+    return kNoErr;
+  }
+  advance( timeout_ms );
+  return kTimeoutErr;
+}
+
+OSStatus notify_add( mico_notify_types_t type, void *functionAddress ) { return kNoErr; }
+OSStatus notify_remove( mico_notify_types_t type, void *functionAddress ) { return kNoErr; }
+
+/* The server ---------------------------------------------------------------*/
+
+static ntp_packet_t reply;
+static double reply_at = -1;                /* True time the reply arrives, -1 for none */
+
+static void put_ts( uint32_t ts[2], double ms )
+{
+  double s = floor( ms / 1000 );
+
+  ts[0] = htonl( (uint32_t)( (uint64_t)s + UNIX_OFFSET ) );
+  ts[1] = htonl( (uint32_t)( ( ms - s * 1000 ) / 1000 * 4294967296.0 ) );
+}
+
+int net_socket( int domain, int type, int protocol ) { return 3; }
+int net_bind( int sockfd, const struct sockaddr_t *addr, socklen_t addrlen ) { return 0; }
+void net_close( int* fd ) { *fd = -1; }
+uint32_t net_inet_addr( char *s ) { return SERVER_IP; }
+
+OSStatus net_gethostbyname( const char * name, char * addr, uint8_t addrLen )
+{
+  strncpy( addr, "10.0.0.1", addrLen );
+  return kNoErr;
+}
+
+/* Answers after a delay each way made of a minimum, jitter and a few spikes */
+ssize_t net_sendto( int sockfd, const void *buf, size_t len, int flags, const struct sockaddr_t *dest_addr, socklen_t addrlen )
+{
+  const ntp_packet_t *request = buf;
+  double to_server, from_server;
+
+  packets++;
+  test_check( len == sizeof(ntp_packet_t) && dest_addr->s_ip == SERVER_IP && dest_addr->s_port == NTP_Port );
+  if( !_wifiConnected )
+    return (ssize_t)len;
+  if( urand( ) < drop_p ){
+    reply_at = -1;
+    return (ssize_t)len;
+  }
+  to_server = 12 + expo( jitter_mean ) + ( urand( ) < spike_p ? 150 + expo( 150 ) : 0 );
+  from_server = 4 + expo( jitter_mean ) + ( urand( ) < spike_p ? 150 + expo( 150 ) : 0 );
+  memset( &reply, 0, sizeof(reply) );
+  reply.li_vn_mode = 0x24;
+  reply.stratum = 2;
+  reply.poll = request->poll;
+  put_ts( reply.receive_ts, now + to_server );
+  put_ts( reply.transmit_ts, now + to_server + 0.3 );
+  reply.origin_ts[0] = request->transmit_ts[0];
+  reply.origin_ts[1] = request->transmit_ts[1];
+  reply_at = now + to_server + 0.3 + from_server;
+  return (ssize_t)len;
+}
+
+int net_select( int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval_t *timeout )
+{
+  double timeout_ticks = timeout->tv_sec * 1000.0 + timeout->tv_usec / 1000.0;
+  double wait_ticks = ( reply_at - now ) * ( 1 + tick_ppm * 1e-6 );
+
+  if( reply_at >= 0 && wait_ticks <= timeout_ticks ){
+    advance( wait_ticks > 0 ? wait_ticks : 0 );
+    return 1;
+  }
+  advance( timeout_ticks );
+  FD_ZERO( readfds );
+  return 0;
+}
+
+/* A short datagram or one from another address may come just before the
+   reply. It answers the request too, but an hour off. */
+ssize_t net_recvfrom( int sockfd, void *buf, size_t len, int flags, struct sockaddr_t *src_addr, socklen_t *addrlen )
+{
+  ntp_packet_t *packet = buf;
+  int bogus_short = short_p > 0 && urand( ) < short_p;
+  int bogus_foreign = !bogus_short && foreign_p > 0 && urand( ) < foreign_p;
+
+  test_check( len == sizeof(reply) );
+  memcpy( buf, &reply, sizeof(reply) );
+  src_addr->s_ip = SERVER_IP;
+  if( bogus_short || bogus_foreign ){
+    packet->receive_ts[0] = htonl( ntohl( reply.receive_ts[0] ) + 3600 );
+    packet->transmit_ts[0] = htonl( ntohl( reply.transmit_ts[0] ) + 3600 );
+    if( bogus_foreign )
+      src_addr->s_ip = SERVER_IP + 1;
+    return bogus_short ? (ssize_t)sizeof(reply) - 1 : (ssize_t)sizeof(reply);
+  }
+  reply_at = -1;
+  return (ssize_t)sizeof(reply);
+}
+
+/* The RTC: whole seconds of local time, counted at its own rate less the trim */
+static double rtc_seconds, rtc_seconds_at;
+static double rtc_ppm = -23.4;
+static int32_t rtc_trim;
+static int rtc_sets, rtc_trims;
+
+static double rtc_rate( void ) { return 1 + ( rtc_ppm - rtc_trim * 1e-3 ) * 1e-6; }
+static double rtc_now( void ) { return rtc_seconds + ( now - rtc_seconds_at ) / 1000 * rtc_rate( ); }
+static double rtc_true_error( void ) { return ( rtc_now( ) - NTP_RTC_TIMEZONE - now / 1000 ) * 1000; }
+
+OSStatus rtc_get_time( mico_rtc_time_t* time )
+{
+  ntp_seconds_to_rtc( (uint32_t)floor( rtc_now( ) ), time );
+  return kNoErr;
+}
+
+OSStatus rtc_set_time( mico_rtc_time_t* time )
+{
+  rtc_seconds = ntp_rtc_to_seconds( time );
+  rtc_seconds_at = now;
+  rtc_sets++;
+  return kNoErr;
+}
+
+/* In the 0.954 ppm steps of the STM32F4 smooth calibration */
+OSStatus rtc_set_drift( int32_t ppb )
+{
+  rtc_seconds = rtc_now( );
+  rtc_seconds_at = now;
+  rtc_trim = (int32_t)( round( ppb / 953.7 ) * 953.7 );
+  rtc_trims++;
+  return kNoErr;
+}
+
+int main( int argc, char **argv )
+{
+  const char *run = argc > 1 ? argv[1] : "steady";
+  double days = 7, max_error = 20, max_packets = 40, tick_ppm_end, rms;
+
+  if( !strcmp( run, "tick_step" ) ){
+    tick_step_at = 3 * 86400e3;
+    tick_step_ppm = 8;
+    max_error = 400;
+  }else if( !strcmp( run, "outage" ) ){
+    outage_from = 2 * 86400e3;
+    outage_to = outage_from + 10 * 3600e3;
+  }else if( !strcmp( run, "lossy" ) ){
+    jitter_mean = 40;
+    spike_p = 0.10;
+    drop_p = 0.2;
+    short_p = foreign_p = 0.05;
+    max_error = 400;
+    max_packets = 200;
+  }else if( !strcmp( run, "long" ) ){
+    days = 60;
+    max_error = 200;
+    max_packets = 20;
+  }else
+    test_check( !strcmp( run, "steady" ) );
+  srand( 1 );
+  origin = now = START_TIME;
+  rtc_seconds = 946684800.0;                /* The RTC starts at 2000-01-01 */
+  rtc_seconds_at = now;
+  horizon = days * 86400e3;
+  tick_ppm_end = tick_ppm + tick_step_ppm;
+
+  MICOStartNTPClient( NULL );
+  ntpNotify_WifiStatusHandler( NOTIFY_STATION_UP, NULL );
+  if( !setjmp( done ) )
+    NTPClient_thread( NULL );
+
+  rms = sqrt( error_sum2 / error_n );
+  printf( "%s, %.0f days: %lu packets (%.0f a day), final poll %lu s\r\n",
+          run, days, packets, packets / days, 1UL << _clock.poll );
+  printf( "  clock error after 6 h: rms %.1f ms, max %.1f ms; freq %d ppb (tick %+.1f ppm)\r\n",
+          rms, error_max, (int)_clock.freq, tick_ppm_end );
+  printf( "  rtc: error max %.0f ms after 6 h, sets %d, trims %d, trim %d ppb (native %+.1f ppm)\r\n",
+          rtc_error_max, rtc_sets, rtc_trims, (int)rtc_trim, rtc_ppm );
+
+  test_check( error_n > 0 && error_max < max_error && rms < max_error / 4 );
+  test_check( packets / days < max_packets );
+  test_check( fabs( _clock.freq + tick_ppm_end * 1000 ) < 1000 );
+  test_check( rtc_error_max < 500 && rtc_trims > 0 );
+  test_check( fabs( rtc_trim - rtc_ppm * 1000 ) < 5000 );
+  return 0;
+}
@@ -0,0 +1,108 @@
+/**
+******************************************************************************
+* @file    test_port.c
+* @brief   Smoke test of the Linux-Sim port: threads, semaphores, timers,
+*          flash, UDP sockets and event fds.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "MicoPlatform.h"
+#include "platform_config.h"
+#include "host_test.h"
+
+static mico_semaphore_t sem;
+static volatile int ticks;
+
+static void timer_handler(void *arg)
+{
+  (void)arg;
+  ticks++;
+}
+
+static void worker(void *arg)
+{
+  (void)arg;
+  mico_thread_msleep(50);
+  mico_rtos_set_semaphore(&sem);
+  mico_rtos_delete_thread(NULL);
+}
+
+int main(void)
+{
+  mico_timer_t timer;
+  uint32_t addr, start;
+  uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8}, read[8];
+  struct sockaddr_t a;
+  struct timeval_t t;
+  fd_set readfds;
+  socklen_t len;
+  char buf[8];
+  int s, c, ev;
+
+  /* Threads and semaphores */
+  test_check(mico_rtos_init_semaphore(&sem, 1) == kNoErr);
+  test_check(mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "worker", worker, 1024, NULL) == kNoErr);
+  start = mico_get_time();
+  test_check(mico_rtos_get_semaphore(&sem, 1000) == kNoErr);
+  test_check(mico_get_time() - start >= 40);
+  test_check(mico_rtos_get_semaphore(&sem, 100) != kNoErr);
+
+  /* Timers: a loaded host may run the handler late, never earlier than its period */
+  test_check(mico_init_timer(&timer, 20, timer_handler, NULL) == kNoErr);
+  start = mico_get_time();
+  test_check(mico_start_timer(&timer) == kNoErr);
+  mico_thread_msleep(210);
+  mico_stop_timer(&timer);
+  test_check(ticks >= 1 && ticks <= (int)(mico_get_time() - start) / 20 + 1);
+
+  /* Flash: erased to 0xFF, writes only clear bits */
+  test_check(MicoFlashInitialize(MICO_INTERNAL_FLASH) == kNoErr);
+  test_check(MicoFlashErase(MICO_INTERNAL_FLASH, PARA_START_ADDRESS, PARA_END_ADDRESS) == kNoErr);
+  addr = PARA_START_ADDRESS;
+  test_check(MicoFlashRead(MICO_INTERNAL_FLASH, &addr, read, sizeof(read)) == kNoErr);
+  test_check(read[0] == 0xFF && read[7] == 0xFF);
+  addr = PARA_START_ADDRESS;
+  test_check(MicoFlashWrite(MICO_INTERNAL_FLASH, &addr, data, sizeof(data)) == kNoErr);
+  addr = PARA_START_ADDRESS;
+  test_check(MicoFlashRead(MICO_INTERNAL_FLASH, &addr, read, sizeof(read)) == kNoErr);
+  test_check(memcmp(read, data, sizeof(data)) == 0);
+
+  /* UDP on the loopback */
+  s = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
+  c = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
+  test_check(s >= 0 && c >= 0);
+  memset(&a, 0, sizeof(a));
+  a.s_port = 40123;
+  a.s_ip = INADDR_ANY;
+  test_check(bind(s, &a, sizeof(a)) == 0);
+  a.s_ip = inet_addr("127.0.0.1");
+  test_check(sendto(c, "hi", 2, 0, &a, sizeof(a)) == 2);
+  FD_ZERO(&readfds);
+  FD_SET(s, &readfds);
+  t.tv_sec = 1;
+  t.tv_usec = 0;
+  test_check(select(s + 1, &readfds, NULL, NULL, &t) == 1);
+  len = sizeof(a);
+  test_check(recvfrom(s, buf, sizeof(buf), 0, &a, &len) == 2 && !memcmp(buf, "hi", 2));
+  close(s);
+  close(c);
+
+  /* An event fd is readable while its semaphore is set */
+  ev = mico_create_event_fd(sem);
+  test_check(ev >= 0);
+  FD_ZERO(&readfds);
+  FD_SET(ev, &readfds);
+  t.tv_sec = 0;
+  t.tv_usec = 50000;
+  test_check(select(ev + 1, &readfds, NULL, NULL, &t) == 0);
+  mico_rtos_set_semaphore(&sem);
+  FD_ZERO(&readfds);
+  FD_SET(ev, &readfds);
+  t.tv_usec = 100000;
+  test_check(select(ev + 1, &readfds, NULL, NULL, &t) == 1 && FD_ISSET(ev, &readfds));
+  mico_delete_event_fd(ev);
+
+  printf("port ok\r\n");
+  return 0;
+}
@@ -0,0 +1,82 @@
+/**
+******************************************************************************
+* @file    test_sdio.c
+* @brief   CMD53 transfer sizing of the STM32 SDIO bus drivers: block size in
+*          byte mode, DMA length, and which reads skip the bounce buffer.
+*          Prints the bytes copied per received frame with and without
+*          block padded receive buffers.
+******************************************************************************
+*/
+
+#include <string.h>
+#include "wlan_bus_sdio_dma.h"
+#include "host_test.h"
+
+#define BLOCK_MODE_SIZE   64   /* Block size the Wi-Fi driver uses for frame reads */
+
+static uint32_t frame_buffer[2048/4];
+static uint8_t  bounce_buffer[2048];
+
+/* Bytes memcpy'd out of the bounce buffer for one read, as the driver does it */
+static uint32_t read_copies( const void* data, uint32_t data_size, uint32_t block_size )
+{
+    if ( sdio_dma_read_in_place( data, data_size, block_size ) )
+        return 0;
+    memcpy( (void*) data, bounce_buffer, data_size );
+    return data_size;
+}
+
+int main( void )
+{
+    static const uint32_t frames[] = { 64, 128, 590, 1024, 1514, 1600 };
+    uint8_t* buffer = (uint8_t*) frame_buffer;
+    unsigned long long start, spent;
+    uint32_t size, padded, copied, unpadded_copied;
+    unsigned i, n;
+
+    /* Byte mode: the smallest block holding the data, 4 to 512 bytes */
+    test_check( sdio_byte_mode_block_size( 0 ) == 4 );
+    test_check( sdio_byte_mode_block_size( 1 ) == 4 );
+    test_check( sdio_byte_mode_block_size( 4 ) == 4 );
+    test_check( sdio_byte_mode_block_size( 5 ) == 8 );
+    test_check( sdio_byte_mode_block_size( 64 ) == 64 );
+    test_check( sdio_byte_mode_block_size( 65 ) == 128 );
+    test_check( sdio_byte_mode_block_size( 256 ) == 256 );
+    test_check( sdio_byte_mode_block_size( 257 ) == 512 );
+    test_check( sdio_byte_mode_block_size( 2048 ) == 512 );
+
+    /* The DPSM rounds up to whole blocks */
+    test_check( sdio_dma_transfer_size( 1, 4 ) == 4 );
+    test_check( sdio_dma_transfer_size( 64, 64 ) == 64 );
+    test_check( sdio_dma_transfer_size( 65, 64 ) == 128 );
+    test_check( sdio_dma_transfer_size( 1514, 64 ) == 1536 );
+
+    /* Byte mode reads land in place only for sizes that are a power of two */
+    for ( size = 1; size <= 512; size++ )
+        test_check( sdio_dma_read_in_place( buffer, size, sdio_byte_mode_block_size( size ) ) ==
+                    ( size >= 4 && ( size & ( size - 1 ) ) == 0 ) );
+
+    /* Block mode: whole blocks into a word aligned buffer */
+    test_check( sdio_dma_read_in_place( buffer, 1536, BLOCK_MODE_SIZE ) );
+    test_check( !sdio_dma_read_in_place( buffer, 1514, BLOCK_MODE_SIZE ) );
+    test_check( !sdio_dma_read_in_place( buffer + 2, 1536, BLOCK_MODE_SIZE ) );
+    test_check( !sdio_dma_read_in_place( buffer + 1, 64, 64 ) );
+
+    /* Bytes copied per received frame, receive buffers padded to a block or not */
+    printf( "frame  padded  copied  unpadded-copied  ns/frame(unpadded)\r\n" );
+    for ( i = 0; i < sizeof(frames)/sizeof(frames[0]); i++ ){
+        padded = sdio_dma_transfer_size( frames[i], BLOCK_MODE_SIZE );
+        copied = read_copies( buffer, padded, BLOCK_MODE_SIZE );
+        test_check( copied == 0 );
+
+        start = test_time_ns();
+        for ( n = 0; n < 1000; n++ )
+            unpadded_copied = read_copies( buffer, frames[i], BLOCK_MODE_SIZE );
+        spent = test_time_ns() - start;
+        test_check( unpadded_copied == ( frames[i] == padded ? 0 : frames[i] ) );
+        printf( "%5u  %6u  %6u  %15u  %18llu\r\n", (unsigned) frames[i], (unsigned) padded,
+                (unsigned) copied, (unsigned) unpadded_copied, spent / 1000 );
+    }
+
+    return 0;
+}
@@ -0,0 +1,376 @@
+/**
+******************************************************************************
+* @file    test_sflash_disk.c
+* @brief   FatFs disk on the SPI flash, over a RAM NOR flash that only clears
+*          bits when programming and can lose power inside any program or
+*          erase: sectors read back what was written, a write cut short
+*          leaves each sector old or new, and the disk mounts from blank or
+*          random flash. Prints the erases against a driver that rewrites
+*          the whole erase block.
+******************************************************************************
+*/
+
+#include <string.h>
+#include "ff_gen_drv.h"
+#include "sflash_diskio.h"
+#include "spi_flash.h"
+#include "host_test.h"
+
+#define FLASH_SIZE      ( 2*1024*1024 )
+#define ERASE_SIZE      4096
+#define DISK_START      0xC0000     /* SFLASHDISK_START_ADDRESS */
+#define DISK_SIZE       0x100000    /* SFLASHDISK_SIZE */
+#define MAX_SECTORS     ( DISK_SIZE / 512 )
+
+/* NOR flash in RAM --------------------------------------------------------*/
+
+static uint8_t flash[FLASH_SIZE];
+static unsigned erase_count[FLASH_SIZE / ERASE_SIZE];
+static long erases, reads, operations, overwritten_bits;
+static long cut_at = -1;            /* Power is lost at this program or erase */
+static int powered_off;
+
+int init_sflash( sflash_handle_t* const handle, void* peripheral_id, sflash_write_allowed_t write_allowed_in )
+{
+  (void)peripheral_id;
+  handle->write_allowed = write_allowed_in;
+  return powered_off ? -1 : 0;
+}
+
+int sflash_read( const sflash_handle_t* const handle, unsigned long device_address, void* const data_addr, unsigned int size )
+{
+  (void)handle;
+  if ( powered_off || device_address + size > FLASH_SIZE )
+    return -1;
+  memcpy( data_addr, &flash[device_address], size );
+  reads++;
+  return 0;
+}
+
+static int power_cut( void )
+{
+  if ( cut_at >= 0 && operations == cut_at ){
+    powered_off = 1;
+    return 1;
+  }
+  operations++;
+  return 0;
+}
+
+/* A cut program writes some of the bytes, the last one maybe in part */
+int sflash_write( const sflash_handle_t* const handle, unsigned long device_address, const void* const data_addr, unsigned int size )
+{
+  const uint8_t* data = data_addr;
+  unsigned int i, done = size;
+
+  (void)handle;
+  if ( powered_off || device_address + size > FLASH_SIZE )
+    return -1;
+  if ( power_cut( ) )
+    done = (unsigned int) rand( ) % ( size + 1 );
+  for ( i = 0; i < done; i++ ){
+    if ( (uint8_t) ~flash[device_address + i] & data[i] )
+      overwritten_bits++;
+    flash[device_address + i] &= data[i];
+  }
+  if ( powered_off ){
+    if ( done < size )
+      flash[device_address + done] &= (uint8_t)( data[done] | rand( ) );
+    return -1;
+  }
+  return 0;
+}
+
+/* A cut erase leaves the rest of the block random */
+int sflash_sector_erase( const sflash_handle_t* const handle, unsigned long device_address )
+{
+  unsigned int i, done = ERASE_SIZE;
+
+  (void)handle;
+  device_address &= ~(unsigned long)( ERASE_SIZE - 1 );
+  if ( powered_off || device_address >= FLASH_SIZE )
+    return -1;
+  if ( power_cut( ) ){
+    done = (unsigned int) rand( ) % ERASE_SIZE;
+    for ( i = done; i < ERASE_SIZE; i++ )
+      flash[device_address + i] |= (uint8_t) rand( );
+  }
+  memset( &flash[device_address], 0xFF, done );
+  if ( powered_off )
+    return -1;
+  erases++;
+  erase_count[device_address / ERASE_SIZE]++;
+  return 0;
+}
+
+int sflash_get_size( const sflash_handle_t* const handle, unsigned long* size )
+{
+  (void)handle;
+  *size = FLASH_SIZE;
+  return 0;
+}
+
+int sflash_chip_erase( const sflash_handle_t* const handle )
+{
+  (void)handle;
+  memset( flash, 0xFF, sizeof(flash) );
+  return 0;
+}
+
+/* Read, erase and program the whole erase block for every write -----------*/
+
+static sflash_handle_t naive_handle;
+static DWORD sector_count;
+
+static DSTATUS NAIVE_initialize( void ) { return 0; }
+static DSTATUS NAIVE_status( void ) { return 0; }
+
+static DRESULT NAIVE_read( BYTE* buff, DWORD sector, BYTE count )
+{
+  return sflash_read( &naive_handle, DISK_START + sector * 512, buff, count * 512u ) ? RES_ERROR : RES_OK;
+}
+
+static DRESULT NAIVE_write( const BYTE* buff, DWORD sector, BYTE count )
+{
+  static BYTE block[ERASE_SIZE];
+  DWORD base;
+
+  while ( count ){
+    base = ( sector * 512 ) & ~(DWORD)( ERASE_SIZE - 1 );
+    sflash_read( &naive_handle, DISK_START + base, block, ERASE_SIZE );
+    for ( ; count && ( ( sector * 512 ) & ~(DWORD)( ERASE_SIZE - 1 ) ) == base; sector++, count--, buff += 512 )
+      memcpy( &block[sector * 512 - base], buff, 512 );
+    sflash_sector_erase( &naive_handle, DISK_START + base );
+    sflash_write( &naive_handle, DISK_START + base, block, ERASE_SIZE );
+  }
+  return RES_OK;
+}
+
+static DRESULT NAIVE_ioctl( BYTE cmd, void* buff )
+{
+  switch ( cmd ){
+    case GET_SECTOR_COUNT: *(DWORD*) buff = sector_count; break;
+    case GET_SECTOR_SIZE:  *(WORD*) buff = 512; break;
+    case GET_BLOCK_SIZE:   *(DWORD*) buff = ERASE_SIZE / 512; break;
+    default: break;
+  }
+  return RES_OK;
+}
+
+static Diskio_drvTypeDef NAIVE_Driver = { NAIVE_initialize, NAIVE_status, NAIVE_read, NAIVE_write, NAIVE_ioctl };
+
+/* Checks against a model of the disk --------------------------------------*/
+
+static Diskio_drvTypeDef* disk = &SFLASHDISK_Driver;
+static uint8_t model[MAX_SECTORS][512];
+static uint8_t written[MAX_SECTORS];
+static unsigned long long random_state = 1;
+
+static unsigned random32( void )
+{
+  random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (unsigned)( random_state >> 33 );
+}
+
+/* 80% of the writes go to 10% of the disk */
+static DWORD pick_sector( void )
+{
+  return ( random32( ) % 10 < 8 ) ? random32( ) % ( sector_count / 10 ) : random32( ) % sector_count;
+}
+
+static void fill( BYTE* buff, DWORD sector, unsigned tag )
+{
+  unsigned i, word;
+
+  for ( i = 0; i < 512; i += 4 ){
+    word = sector * 2654435761u ^ tag ^ ( i * 40503u );
+    memcpy( &buff[i], &word, 4 );
+  }
+}
+
+static void check_disk( void )
+{
+  static BYTE buff[512];
+  DWORD s;
+
+  for ( s = 0; s < sector_count; s++ ){
+    test_check( disk->disk_read( buff, s, 1 ) == RES_OK );
+    if ( written[s] )
+      test_check( memcmp( buff, model[s], 512 ) == 0 );
+    else
+      test_check( buff[0] == 0xFF && buff[511] == 0xFF );
+  }
+}
+
+static void remount( void )
+{
+  powered_off = 0;
+  cut_at = -1;
+  test_check( ( disk->disk_initialize( ) & STA_NOINIT ) == 0 );
+}
+
+/* Writes of 1 to 8 sectors, returns the erases per sector written */
+static double random_writes( long count )
+{
+  static BYTE buff[8 * 512];
+  long i, sectors = 0, start = erases;
+  DWORD s;
+  BYTE c, k;
+
+  for ( i = 0; i < count; i++ ){
+    s = pick_sector( );
+    c = (BYTE)( 1 + ( random32( ) % 4 == 0 ? random32( ) % 8 : 0 ) );
+    if ( s + c > sector_count )
+      c = (BYTE)( sector_count - s );
+    for ( k = 0; k < c; k++ ){
+      fill( &buff[k * 512], s + k, (unsigned) i );
+      memcpy( model[s + k], &buff[k * 512], 512 );
+      written[s + k] = 1;
+    }
+    test_check( disk->disk_write( buff, s, c ) == RES_OK );
+    sectors += c;
+  }
+  check_disk( );
+  return (double)( erases - start ) / sectors;
+}
+
+/* Power lost inside writes: after a remount each sector is either old or new */
+static long power_cuts( long rounds )
+{
+  static BYTE buff[8 * 512], readback[8 * 512];
+  long r, cuts = 0;
+  DWORD s;
+  BYTE c, k;
+
+  for ( r = 0; r < rounds; r++ ){
+    s = pick_sector( );
+    c = (BYTE)( 1 + random32( ) % 8 );
+    if ( s + c > sector_count )
+      c = (BYTE)( sector_count - s );
+    for ( k = 0; k < c; k++ )
+      fill( &buff[k * 512], s + k, 0x80000000u + (unsigned) r );
+
+    cut_at = operations + random32( ) % ( random32( ) % 2 ? 12 : 400 );
+    if ( disk->disk_write( buff, s, c ) != RES_OK ){
+      cuts++;
+      remount( );
+      test_check( disk->disk_read( readback, s, c ) == RES_OK );
+    }else{
+      memcpy( readback, buff, c * 512u );
+    }
+    cut_at = -1;
+
+    for ( k = 0; k < c; k++ ){
+      if ( memcmp( &readback[k * 512], &buff[k * 512], 512 ) == 0 ){
+        memcpy( model[s + k], &buff[k * 512], 512 );
+        written[s + k] = 1;
+      }else if ( written[s + k] ){
+        test_check( memcmp( &readback[k * 512], model[s + k], 512 ) == 0 );
+      }else{
+        test_check( readback[k * 512] == 0xFF );
+      }
+    }
+    if ( r % 1000 == 0 )
+      check_disk( );
+  }
+  remount( );
+  check_disk( );
+  return cuts;
+}
+
+/* A log appended line by line, a config file rewritten and a few larger files */
+static void fat_workload( Diskio_drvTypeDef* driver, long* outErases, unsigned* outMostWorn )
+{
+  static BYTE big[6000];
+  FATFS fs;
+  FIL file;
+  char path[4], line[64];
+  UINT done;
+  long start;
+  int i;
+
+  memset( flash, 0xFF, sizeof(flash) );
+  memset( erase_count, 0, sizeof(erase_count) );
+  disk = driver;
+  test_check( FATFS_LinkDriver( driver, path ) == 0 );
+  test_check( f_mount( &fs, path, 0 ) == FR_OK && f_mkfs( path, 0, 0 ) == FR_OK );
+  start = erases;
+  for ( i = 0; i < 200; i++ ){
+    test_check( f_open( &file, "0:/log.txt", FA_OPEN_ALWAYS | FA_WRITE ) == FR_OK );
+    test_check( f_lseek( &file, f_size( &file ) ) == FR_OK );
+    snprintf( line, sizeof(line), "%05d temperature 23.5 humidity 41 rssi -57\r\n", i );
+    test_check( f_write( &file, line, strlen( line ), &done ) == FR_OK );
+    test_check( f_close( &file ) == FR_OK );
+    if ( i % 5 == 0 ){
+      memset( big, 'a' + i % 26, 300 );
+      test_check( f_open( &file, "0:/config.txt", FA_CREATE_ALWAYS | FA_WRITE ) == FR_OK );
+      test_check( f_write( &file, big, 300, &done ) == FR_OK && f_close( &file ) == FR_OK );
+    }
+  }
+  for ( i = 0; i < 20; i++ ){
+    memset( big, i, sizeof(big) );
+    snprintf( line, sizeof(line), "0:/img%d.bin", i % 4 );
+    test_check( f_open( &file, line, FA_CREATE_ALWAYS | FA_WRITE ) == FR_OK );
+    test_check( f_write( &file, big, sizeof(big), &done ) == FR_OK && f_close( &file ) == FR_OK );
+  }
+  test_check( f_open( &file, "0:/log.txt", FA_READ ) == FR_OK );
+  test_check( f_read( &file, line, 48, &done ) == FR_OK && memcmp( line, "00000 temp", 10 ) == 0 );
+  test_check( f_close( &file ) == FR_OK );
+
+  *outErases = erases - start;
+  *outMostWorn = 0;
+  for ( i = DISK_START / ERASE_SIZE; i < ( DISK_START + DISK_SIZE ) / ERASE_SIZE; i++ )
+    if ( erase_count[i] > *outMostWorn )
+      *outMostWorn = erase_count[i];
+  f_mount( NULL, path, 0 );
+  FATFS_UnLinkDriver( path );
+}
+
+int main( void )
+{
+  double ftl, naive;
+  long start, cuts, ftl_erases, naive_erases;
+  unsigned ftl_worn, naive_worn;
+  long i;
+
+  /* Blank flash is an empty disk */
+  memset( flash, 0xFF, sizeof(flash) );
+  remount( );
+  test_check( disk->disk_ioctl( GET_SECTOR_COUNT, &sector_count ) == RES_OK );
+  test_check( sector_count > 0 && sector_count <= MAX_SECTORS );
+  check_disk( );
+
+  ftl = random_writes( 50000 );
+  start = reads;
+  remount( );
+  printf( "remount of a full disk: %ld flash reads\r\n", reads - start );
+  check_disk( );
+
+  cuts = power_cuts( 40000 );
+  test_check( cuts > 0 );
+  test_check( overwritten_bits == 0 );
+  printf( "%ld power cuts, every sector read back old or new\r\n", cuts );
+
+  /* Random flash mounts as an empty disk that works */
+  for ( i = 0; i < FLASH_SIZE; i++ )
+    flash[i] = (uint8_t) random32( );
+  remount( );
+  memset( written, 0, sizeof(written) );
+  check_disk( );
+  random_writes( 5000 );
+
+  disk = &NAIVE_Driver;
+  memset( written, 0, sizeof(written) );
+  memset( flash, 0xFF, sizeof(flash) );
+  naive = random_writes( 50000 );
+  test_check( ftl < naive );
+  printf( "random writes: %.3f erases per sector written, %.3f rewriting whole blocks\r\n", ftl, naive );
+
+  fat_workload( &SFLASHDISK_Driver, &ftl_erases, &ftl_worn );
+  fat_workload( &NAIVE_Driver, &naive_erases, &naive_worn );
+  test_check( ftl_erases < naive_erases && ftl_worn < naive_worn );
+  printf( "FatFs workload: %ld erases, most worn block %u; rewriting whole blocks %ld, %u\r\n",
+          ftl_erases, ftl_worn, naive_erases, naive_worn );
+
+  return 0;
+}
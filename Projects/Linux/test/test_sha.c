@@ -0,0 +1,154 @@
+/**
+******************************************************************************
+* @file    test_sha.c
+* @brief   SHA-1, SHA-256 and SHA-512 of the Hash API in SHAUtils against the
+*          RFC 6234 code in External/SHAUtils: the same digests for every
+*          length up to 1000 bytes, in one piece and streamed, the FIPS 180
+*          "abc" digests, and the throughput of each.
+******************************************************************************
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "SHAUtils.h"
+#include "sha.h"
+#include "host_test.h"
+
+#define MAX_LEN  1000
+
+/* MD5 of the Hash API comes from the MICO library, which is only built for the
+ * target. These take its place so SHAUtils links, the test never hashes MD5. */
+void InitMd5(md5_context *ctx)                                   { (void)ctx; test_check(0); }
+void Md5Update(md5_context *ctx, unsigned char *input, int ilen) { (void)ctx; (void)input; (void)ilen; test_check(0); }
+void Md5Final(md5_context *ctx, unsigned char output[16])        { (void)ctx; (void)output; test_check(0); }
+
+static const struct {
+  HashType type;
+  SHAversion rfc;
+  const char *name;
+  const char *abc;
+} digests[] = {
+  { kHashType_SHA1, SHA1, "SHA-1",
+    "a9993e364706816aba3e25717850c26c9cd0d89d" },
+  { kHashType_SHA256, SHA256, "SHA-256",
+    "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+  { kHashType_SHA512, SHA512, "SHA-512",
+    "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+    "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f" },
+};
+
+#define DIGESTS  (int)(sizeof(digests) / sizeof(digests[0]))
+
+static void rfc_digest(SHAversion which, const uint8_t *data, size_t len, uint8_t *out)
+{
+  USHAContext ctx;
+
+  test_check(USHAReset(&ctx, which) == shaSuccess);
+  test_check(USHAInput(&ctx, data, (unsigned int)len) == shaSuccess);
+  test_check(USHAResult(&ctx, out) == shaSuccess);
+}
+
+static void hex(const uint8_t *digest, size_t len, char *out)
+{
+  size_t i;
+
+  for (i = 0; i < len; ++i)
+    sprintf(out + 2 * i, "%02x", digest[i]);
+}
+
+static void test_abc(void)
+{
+  uint8_t digest[kHashMaxDigestLength];
+  char text[2 * kHashMaxDigestLength + 1];
+  int d;
+
+  for (d = 0; d < DIGESTS; ++d) {
+    test_check(Hash_Data(digests[d].type, "abc", 3, digest) == kNoErr);
+    hex(digest, Hash_DigestLength(digests[d].type), text);
+    test_check(strcmp(text, digests[d].abc) == 0);
+  }
+  test_check(Hash_Data((HashType)99, "abc", 3, digest) == kParamErr);
+  test_check(Hash_DigestLength((HashType)99) == 0);
+}
+
+/* Every length across the block boundaries of both block sizes, fed whole, in
+ * 13 byte pieces that straddle them, and a byte at a time */
+static void test_lengths(void)
+{
+  static uint8_t data[MAX_LEN];
+  uint8_t digest[kHashMaxDigestLength], expect[kHashMaxDigestLength];
+  HashContext ctx;
+  size_t len, pos, n, size;
+  int d;
+
+  for (pos = 0; pos < MAX_LEN; ++pos)
+    data[pos] = (uint8_t)(pos * 131 + (pos >> 3));
+
+  for (d = 0; d < DIGESTS; ++d) {
+    size = Hash_DigestLength(digests[d].type);
+    test_check(size == (size_t)USHAHashSize(digests[d].rfc));
+    for (len = 0; len <= MAX_LEN; ++len) {
+      rfc_digest(digests[d].rfc, data, len, expect);
+
+      test_check(Hash_Data(digests[d].type, data, len, digest) == kNoErr);
+      test_check(memcmp(digest, expect, size) == 0);
+
+      test_check(Hash_Init(&ctx, digests[d].type) == kNoErr);
+      for (pos = 0; pos < len; pos += n) {
+        n = len - pos < 13 ? len - pos : 13;
+        test_check(Hash_Update(&ctx, data + pos, n) == kNoErr);
+      }
+      test_check(Hash_Final(&ctx, digest) == kNoErr);
+      test_check(memcmp(digest, expect, size) == 0);
+
+      if (len % 97 == 0) {
+        test_check(Hash_Init(&ctx, digests[d].type) == kNoErr);
+        for (pos = 0; pos < len; ++pos)
+          test_check(Hash_Update(&ctx, data + pos, 1) == kNoErr);
+        test_check(Hash_Final(&ctx, digest) == kNoErr);
+        test_check(memcmp(digest, expect, size) == 0);
+      }
+    }
+  }
+}
+
+/* MB/s of each over 1 MB, hashed in 4 KB updates */
+static void test_bench(void)
+{
+  static uint8_t data[1024 * 1024];
+  uint8_t digest[kHashMaxDigestLength], expect[kHashMaxDigestLength];
+  unsigned long long start, ns, rfc_ns;
+  HashContext ctx;
+  USHAContext rfc;
+  size_t pos;
+  int d;
+
+  memset(data, 0x5C, sizeof(data));
+  for (d = 0; d < DIGESTS; ++d) {
+    start = test_time_ns();
+    Hash_Init(&ctx, digests[d].type);
+    for (pos = 0; pos < sizeof(data); pos += 4096)
+      Hash_Update(&ctx, data + pos, 4096);
+    Hash_Final(&ctx, digest);
+    ns = test_time_ns() - start;
+
+    start = test_time_ns();
+    USHAReset(&rfc, digests[d].rfc);
+    for (pos = 0; pos < sizeof(data); pos += 4096)
+      USHAInput(&rfc, data + pos, 4096);
+    USHAResult(&rfc, expect);
+    rfc_ns = test_time_ns() - start;
+
+    test_check(memcmp(digest, expect, Hash_DigestLength(digests[d].type)) == 0);
+    printf("%-8s Hash API %6.1f MB/s, RFC 6234 %6.1f MB/s\r\n", digests[d].name,
+           sizeof(data) * 1e3 / ns, sizeof(data) * 1e3 / rfc_ns);
+  }
+}
+
+int main(void)
+{
+  test_abc();
+  test_lengths();
+  test_bench();
+  return 0;
+}
@@ -0,0 +1,90 @@
+/**
+******************************************************************************
+* @file    test_wifi_image.c
+* @brief   Wi-Fi firmware loader: an image made by wifi_image_header is read
+*          back through read_wifi_firmware.c, a corrupt one is cut short, and
+*          one without a header is measured by scanning the partition.
+*
+*          Usage: test_wifi_image <path of wifi_image_header>
+******************************************************************************
+*/
+
+#include "../../../Platform/MCU/STM32F2xx/wlan_bus_driver/read_wifi_firmware.c"
+#include "host_test.h"
+
+#define IMAGE_LENGTH  100001
+#define PIECE         64
+
+static uint8_t image[IMAGE_LENGTH];
+static uint8_t headered[IMAGE_LENGTH + 16];
+
+static void write_driver_partition( const uint8_t* data, uint32_t length )
+{
+  uint32_t address = DRIVER_START_ADDRESS;
+
+  test_check( MicoFlashInitialize( MICO_FLASH_FOR_DRIVER ) == kNoErr );
+  test_check( MicoFlashErase( MICO_FLASH_FOR_DRIVER, DRIVER_START_ADDRESS, DRIVER_END_ADDRESS ) == kNoErr );
+  test_check( MicoFlashWrite( MICO_FLASH_FOR_DRIVER, &address, (uint8_t *)data, length ) == kNoErr );
+  image_size = 0;
+}
+
+/* Download the image the way the Wi-Fi driver does, returns the bytes handed out */
+static uint32_t download( void )
+{
+  uint8_t buffer[PIECE];
+  uint32_t offset = 0, size, got;
+
+  size = platform_get_wifi_image_size( );
+  while ( offset < size ){
+    got = platform_get_wifi_image( buffer, PIECE, offset );
+    if ( got == 0 )
+      break;
+    test_check( memcmp( buffer, &image[offset], got ) == 0 );
+    offset += got;
+  }
+  return offset;
+}
+
+int main( int argc, char** argv )
+{
+  char command[512];
+  FILE* file;
+  uint32_t i;
+
+  test_check( argc == 2 );
+  srand( 1 );
+  for ( i = 0; i < IMAGE_LENGTH; i++ )
+    image[i] = (uint8_t) rand( );
+
+  /* Build the image with the tool */
+  file = fopen( "rf_driver_test.bin", "wb" );
+  test_check( file && fwrite( image, 1, IMAGE_LENGTH, file ) == IMAGE_LENGTH );
+  fclose( file );
+  snprintf( command, sizeof(command), "\"%s\" rf_driver_test.bin rf_driver_test.img", argv[1] );
+  test_check( system( command ) == 0 );
+  file = fopen( "rf_driver_test.img", "rb" );
+  test_check( file && fread( headered, 1, sizeof(headered), file ) == sizeof(headered) );
+  fclose( file );
+  test_check( memcmp( &headered[16], image, IMAGE_LENGTH ) == 0 );
+
+  /* Length from the header and the whole image, CRC included, goes through */
+  write_driver_partition( headered, sizeof(headered) );
+  test_check( platform_get_wifi_image_size( ) == IMAGE_LENGTH );
+  test_check( image_has_crc == true );
+  test_check( download( ) == IMAGE_LENGTH );
+  test_check( download( ) == IMAGE_LENGTH );
+
+  /* A corrupt image is cut short, every time it is downloaded */
+  headered[16 + 5000] ^= 0x01;
+  image[5000] ^= 0x01;
+  write_driver_partition( headered, sizeof(headered) );
+  test_check( download( ) < IMAGE_LENGTH );
+  test_check( download( ) < IMAGE_LENGTH );
+
+  /* No header: the length comes from the last word that is not erased, a whole number of words here */
+  write_driver_partition( image, IMAGE_LENGTH - 1 );
+  test_check( platform_get_wifi_image_size( ) == IMAGE_LENGTH - 1 );
+  test_check( image_has_crc == false );
+
+  return 0;
+}
@@ -0,0 +1,458 @@
+/**
+******************************************************************************
+* @file    test_ymodem.c
+* @brief   Bootloader YMODEM receiver against a batch sender that behaves
+*          like lrzsz "sb -k", in virtual time. The STDIO UART is a 64 byte
+*          ring filled at the line rate that drops what does not fit, the
+*          flash an image that takes some time per byte programmed. Images
+*          come through whole with ACKs and YMODEM-g, with bytes lost or
+*          corrupted on the line and ACKs lost. Prints the transfer rate for
+*          a few line rates and flash speeds.
+******************************************************************************
+*/
+
+/* The UART, the flash and putchar of the receiver are the models below */
+#define MicoUartRecv                wire_recv
+#define MicoUartGetLengthInBuffer   wire_length
+#define MicoFlashInitialize         image_initialize
+#define MicoFlashFinalize           image_finalize
+#define MicoFlashErase              image_erase
+#define MicoFlashWrite              image_write
+#define MicoFlashRead               image_read
+#define putchar                     wire_putchar
+
+#include "../../../Bootloader/ymodem.c"
+#include "host_test.h"
+
+#define IMAGE_SIZE      200000
+#define FLASH_SIZE      ( 1024 * 1024 )
+#define WIRE_SIZE       ( 1 << 20 )
+
+uint8_t FileName[FILE_NAME_LENGTH];
+
+static uint8_t file[IMAGE_SIZE];
+
+/* Test settings */
+static double byte_ns;              /* Line time of a byte */
+static double flash_ns;             /* Programming time of a byte */
+static double latency_ns;           /* Before the sender sees what we send */
+static long drop_every, corrupt_every, ack_lost_every;
+static long fail_write_at;
+static int short_every;             /* Every n-th data packet is a 128 byte one */
+
+/* Virtual time and the line to the receiver */
+static double now;
+static uint8_t wire[WIRE_SIZE];
+static double arrival[WIRE_SIZE];
+static long wire_head, wire_tail, wire_bytes;
+static double line_free;
+static uint8_t ring[64];
+static int ring_head, ring_count;
+static long overruns, acks;
+
+/* Flash */
+static uint8_t image[FLASH_SIZE];
+static long written;
+
+/* Sender --------------------------------------------------------------------*/
+
+typedef enum { WAIT_START, WAIT_HEADER_ACK, WAIT_DATA_START, WAIT_ACK, WAIT_EOT_ACK, WAIT_END_START, WAIT_END_ACK,
+               SENDER_DONE, SENDER_CANCELLED } sender_state_t;
+
+static sender_state_t state;
+static bool streaming;
+static uint32_t offset, block_offset, block_size;
+static uint8_t block_number;
+static bool last_was_ca;
+
+static uint16_t reference_crc16( const uint8_t* data, uint32_t size )
+{
+  uint16_t crc = 0;
+  int bit;
+
+  while ( size-- ){
+    crc ^= (uint16_t)( *data++ << 8 );
+    for ( bit = 0; bit < 8; bit++ )
+      crc = (uint16_t)( ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1 );
+  }
+  return crc;
+}
+
+/* Bytes leave the sender at the line rate once it has seen what we sent */
+static void line_send( const uint8_t* data, uint32_t size )
+{
+  double start = now + latency_ns;
+
+  if ( line_free < start )
+    line_free = start;
+  while ( size-- ){
+    test_check( wire_tail - wire_head < WIRE_SIZE );
+    line_free += byte_ns;
+    wire[wire_tail % WIRE_SIZE] = *data++;
+    arrival[wire_tail % WIRE_SIZE] = line_free;
+    wire_tail++;
+  }
+}
+
+static void send_block( uint8_t number, const uint8_t* data, uint32_t length, uint32_t size, uint8_t pad )
+{
+  uint8_t packet[PACKET_1K_SIZE + PACKET_OVERHEAD];
+  uint16_t crc;
+
+  packet[0] = ( size == PACKET_1K_SIZE ) ? STX : SOH;
+  packet[1] = number;
+  packet[2] = (uint8_t) ~number;
+  memcpy( &packet[PACKET_HEADER], data, length );
+  memset( &packet[PACKET_HEADER + length], pad, size - length );
+  crc = reference_crc16( &packet[PACKET_HEADER], size );
+  packet[PACKET_HEADER + size] = (uint8_t)( crc >> 8 );
+  packet[PACKET_HEADER + size + 1] = (uint8_t) crc;
+  line_send( packet, size + PACKET_OVERHEAD );
+}
+
+/* 1K blocks, a 128 byte one for a short tail and every short_every-th block */
+static void send_next_block( void )
+{
+  uint32_t left = IMAGE_SIZE - offset;
+
+  block_offset = offset;
+  block_size = ( left > PACKET_1K_SIZE - PACKET_SIZE && !( short_every && block_number % short_every == 0 ) )
+               ? PACKET_1K_SIZE : PACKET_SIZE;
+  send_block( block_number, &file[offset], left < block_size ? left : block_size, block_size, 0x1A );
+  offset += block_size;
+  if ( offset > IMAGE_SIZE )
+    offset = IMAGE_SIZE;
+}
+
+static void resend_block( void )
+{
+  uint32_t left = IMAGE_SIZE - block_offset;
+
+  send_block( block_number, &file[block_offset], left < block_size ? left : block_size, block_size, 0x1A );
+}
+
+static void send_header( void )
+{
+  char header[PACKET_SIZE];
+  int length = snprintf( header, sizeof(header), "image.bin%c%d 0 100644", 0, IMAGE_SIZE );
+
+  send_block( 0, (uint8_t*) header, (uint32_t) length, PACKET_SIZE, 0 );
+}
+
+static void send_eot( void )
+{
+  uint8_t eot = EOT;
+
+  line_send( &eot, 1 );
+}
+
+/* What the sender does with a byte from the receiver */
+static void sender_receive( uint8_t c )
+{
+  if ( c == CA && last_was_ca )
+    state = SENDER_CANCELLED;
+  last_was_ca = ( c == CA );
+
+  switch ( state ){
+    case WAIT_START:
+      if ( c == CRC16 || c == CRC16_G ){
+        send_header( );
+        state = WAIT_HEADER_ACK;
+      }
+      break;
+    case WAIT_HEADER_ACK:
+      if ( c == ACK )
+        state = WAIT_DATA_START;
+      else if ( c == CRC16 || c == NAK )
+        send_header( );
+      break;
+    case WAIT_DATA_START:
+      if ( c != CRC16 && c != CRC16_G )
+        break;
+      streaming = ( c == CRC16_G );
+      offset = 0;
+      block_number = 1;
+      send_next_block( );
+      if ( streaming ){
+        /* No ACKs, the whole file goes out back to back */
+        while ( offset < IMAGE_SIZE ){
+          block_number++;
+          send_next_block( );
+        }
+        send_eot( );
+        state = WAIT_EOT_ACK;
+      }else{
+        state = WAIT_ACK;
+      }
+      break;
+    case WAIT_ACK:
+      if ( c == ACK ){
+        if ( offset < IMAGE_SIZE ){
+          block_number++;
+          send_next_block( );
+        }else{
+          send_eot( );
+          state = WAIT_EOT_ACK;
+        }
+      }else if ( c == NAK || c == CRC16 ){
+        resend_block( );
+      }
+      break;
+    case WAIT_EOT_ACK:
+      if ( c == ACK )
+        state = WAIT_END_START;
+      else if ( c == NAK || c == CRC16 )
+        send_eot( );
+      break;
+    case WAIT_END_START:
+      if ( c == CRC16 || c == CRC16_G ){
+        send_block( 0, NULL, 0, PACKET_SIZE, 0 );
+        state = WAIT_END_ACK;
+      }
+      break;
+    case WAIT_END_ACK:
+      if ( c == ACK )
+        state = SENDER_DONE;
+      else if ( c == CRC16 || c == NAK )
+        send_block( 0, NULL, 0, PACKET_SIZE, 0 );
+      break;
+    default:
+      break;
+  }
+}
+
+/* UART of the receiver ------------------------------------------------------*/
+
+/* Bytes that arrived by then go into the ring, or are lost when it is full */
+static void advance( double to )
+{
+  uint8_t c;
+
+  while ( wire_head < wire_tail && arrival[wire_head % WIRE_SIZE] <= to ){
+    c = wire[wire_head % WIRE_SIZE];
+    wire_head++;
+    wire_bytes++;
+    if ( drop_every && wire_bytes % drop_every == 0 )
+      continue;
+    if ( corrupt_every && wire_bytes % corrupt_every == 0 )
+      c ^= 0x10;
+    if ( ring_count == (int) sizeof(ring) ){
+      overruns++;
+      continue;
+    }
+    ring[( ring_head + ring_count ) % sizeof(ring)] = c;
+    ring_count++;
+  }
+  if ( to > now )
+    now = to;
+}
+
+OSStatus wire_recv( mico_uart_t uart, void* data, uint32_t size, uint32_t timeout )
+{
+  uint8_t* p = data;
+  double deadline = now + timeout * 1e6;
+
+  (void) uart;
+  while ( size ){
+    advance( now );
+    if ( ring_count ){
+      *p++ = ring[ring_head];
+      ring_head = ( ring_head + 1 ) % (int) sizeof(ring);
+      ring_count--;
+      size--;
+      deadline = now + timeout * 1e6;
+    }else if ( wire_head < wire_tail && arrival[wire_head % WIRE_SIZE] <= deadline ){
+      advance( arrival[wire_head % WIRE_SIZE] );
+    }else{
+      /* The sender only talks when it hears from us */
+      advance( deadline );
+      return kTimeoutErr;
+    }
+  }
+  return kNoErr;
+}
+
+uint32_t wire_length( mico_uart_t uart )
+{
+  (void) uart;
+  advance( now );
+  return (uint32_t) ring_count;
+}
+
+int wire_putchar( int c )
+{
+  advance( now + byte_ns );
+  if ( c == ACK && ack_lost_every && ++acks % ack_lost_every == 0 )
+    return c;
+  sender_receive( (uint8_t) c );
+  return c;
+}
+
+/* Flash ---------------------------------------------------------------------*/
+
+OSStatus image_initialize( mico_flash_t flash )
+{
+  (void) flash;
+  return kNoErr;
+}
+
+OSStatus image_finalize( mico_flash_t flash )
+{
+  (void) flash;
+  return kNoErr;
+}
+
+OSStatus image_erase( mico_flash_t flash, uint32_t start, uint32_t end )
+{
+  (void) flash;
+  test_check( start <= end && end < FLASH_SIZE );
+  memset( &image[start], 0xFF, end - start + 1 );
+  return kNoErr;
+}
+
+OSStatus image_write( mico_flash_t flash, volatile uint32_t* address, uint8_t* data, uint32_t length )
+{
+  uint32_t i;
+
+  (void) flash;
+  advance( now + flash_ns * length );
+  if ( fail_write_at >= 0 && written + length > fail_write_at )
+    return kWriteErr;
+  test_check( *address + length <= FLASH_SIZE );
+  for ( i = 0; i < length; i++ ){
+    /* Programming only clears bits, each byte is programmed once */
+    test_check( ( image[*address + i] & data[i] ) == data[i] && image[*address + i] == 0xFF );
+    image[*address + i] = data[i];
+  }
+  *address += length;
+  written += length;
+  return kNoErr;
+}
+
+OSStatus image_read( mico_flash_t flash, volatile uint32_t* address, uint8_t* data, uint32_t length )
+{
+  (void) flash;
+  memcpy( data, &image[*address], length );
+  *address += length;
+  return kNoErr;
+}
+
+/* ---------------------------------------------------------------------------*/
+
+typedef struct
+{
+  int32_t result;
+  double  seconds;
+} transfer_t;
+
+static transfer_t transfer( long baud, double flash_ns_per_byte, double latency_us, bool g )
+{
+  static uint8_t buf[PACKET_1K_SIZE];
+  transfer_t t;
+  double start;
+
+  byte_ns = 1e10 / baud;
+  flash_ns = flash_ns_per_byte;
+  latency_ns = latency_us * 1e3;
+  now = line_free = 0;
+  wire_head = wire_tail = wire_bytes = 0;
+  ring_head = ring_count = 0;
+  overruns = acks = written = 0;
+  state = WAIT_START;
+  last_was_ca = false;
+  memset( image, 0x00, sizeof(image) );
+
+  start = now;
+  t.result = Ymodem_Receive( buf, MICO_INTERNAL_FLASH, 0, FLASH_SIZE, g );
+  t.seconds = ( now - start ) / 1e9;
+  return t;
+}
+
+/* The whole image came through and the sender saw the end of the session */
+static bool received( transfer_t t )
+{
+  return t.result == IMAGE_SIZE && memcmp( image, file, IMAGE_SIZE ) == 0 && state == SENDER_DONE
+         && strcmp( (char*) FileName, "image.bin" ) == 0;
+}
+
+static void reset_faults( void )
+{
+  drop_every = corrupt_every = ack_lost_every = 0;
+  fail_write_at = -1;
+  short_every = 0;
+}
+
+int main( void )
+{
+  static const long bauds[] = { 115200, 921600 };
+  static const double flash_speeds[] = { 4000, 16000 };   /* ns per byte, 4000 is an STM32F2 word program */
+  static const double latencies[] = { 0, 2000 };           /* us, 2000 for a USB serial adapter */
+  static uint8_t buffer[1100];
+  transfer_t ack, g;
+  unsigned i, j, k, n;
+
+  srand( 1 );
+  for ( i = 0; i < IMAGE_SIZE; i++ )
+    file[i] = (uint8_t) rand( );
+  reset_faults( );
+
+  /* The table CRC is the bit serial one */
+  for ( n = 0; n < 1000; n++ ){
+    k = (unsigned) rand( ) % sizeof(buffer);
+    for ( i = 0; i < k; i++ )
+      buffer[i] = (uint8_t) rand( );
+    test_check( Cal_CRC16( buffer, k ) == reference_crc16( buffer, k ) );
+  }
+
+  printf( "   baud  flash ns/B  latency us  ACKed B/s  YMODEM-g B/s\r\n" );
+  for ( i = 0; i < 2; i++ ){
+    for ( j = 0; j < 2; j++ ){
+      for ( k = 0; k < 2; k++ ){
+        ack = transfer( bauds[i], flash_speeds[j], latencies[k], false );
+        test_check( received( ack ) && overruns == 0 );
+        g = transfer( bauds[i], flash_speeds[j], latencies[k], true );
+        if ( flash_speeds[j] * PACKET_1K_SIZE > byte_ns * ( PACKET_1K_SIZE + PACKET_OVERHEAD ) ){
+          /* Flash slower than the line: YMODEM-g has no flow control, it must end with CA CA */
+          test_check( g.result == 0 && state == SENDER_CANCELLED );
+          printf( "%7ld  %10.0f  %10.0f  %9.0f  %12s\r\n", bauds[i], flash_speeds[j], latencies[k],
+                  IMAGE_SIZE / ack.seconds, "overruns" );
+        }else{
+          test_check( received( g ) && overruns == 0 );
+          printf( "%7ld  %10.0f  %10.0f  %9.0f  %12.0f\r\n", bauds[i], flash_speeds[j], latencies[k],
+                  IMAGE_SIZE / ack.seconds, IMAGE_SIZE / g.seconds );
+        }
+      }
+    }
+  }
+
+  /* 128 byte packets between 1K ones */
+  short_every = 3;
+  test_check( received( transfer( 115200, 4000, 0, false ) ) );
+  test_check( received( transfer( 115200, 4000, 0, true ) ) );
+  reset_faults( );
+
+  /* Faults on the line are recovered with ACKs */
+  drop_every = 5003;
+  test_check( received( transfer( 115200, 4000, 0, false ) ) );
+  reset_faults( );
+  corrupt_every = 4001;
+  test_check( received( transfer( 115200, 4000, 0, false ) ) );
+  reset_faults( );
+  ack_lost_every = 7;
+  test_check( received( transfer( 115200, 4000, 0, false ) ) );
+  reset_faults( );
+
+  /* YMODEM-g cannot recover, it cancels */
+  drop_every = 5003;
+  g = transfer( 115200, 4000, 0, true );
+  test_check( g.result == 0 && state == SENDER_CANCELLED );
+  reset_faults( );
+
+  /* A flash error cancels the session */
+  fail_write_at = 100000;
+  test_check( transfer( 115200, 4000, 0, false ).result == -2 && state == SENDER_CANCELLED );
+  test_check( transfer( 115200, 4000, 0, true ).result == -2 && state == SENDER_CANCELLED );
+  reset_faults( );
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+/**
+******************************************************************************
+* @file    wifi_image_header.c
+* @brief   Put the 16-byte image header read by read_wifi_firmware.c in front
+*          of an RF driver .bin, so the loader knows its length and CRC.
+*
+*          Usage: wifi_image_header <driver.bin> <output.bin>
+*          The output is what goes into the DRIVER partition, e.g. with the
+*          bootloader's DRIVERUPDATE command.
+******************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define WIFI_IMAGE_HEADER_MAGIC     0x46574D58  /* "XMWF" */
+#define WIFI_IMAGE_HEADER_VERSION   1
+#define WIFI_IMAGE_HEADER_SIZE      16
+
+/* CRC16-CCITT, polynomial 0x1021, initial value 0 */
+static uint16_t crc16( uint16_t crc, const uint8_t* data, long length )
+{
+  int i;
+
+  while ( length-- > 0 ){
+    crc ^= (uint16_t)( *data++ << 8 );
+    for ( i = 0; i < 8; i++ )
+      crc = (uint16_t)( ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1 );
+  }
+  return crc;
+}
+
+/* The targets are little endian, the header is written byte by byte so the host does not matter */
+static void put_le( uint8_t* p, uint32_t value, int bytes )
+{
+  while ( bytes-- > 0 ){
+    *p++ = (uint8_t) value;
+    value >>= 8;
+  }
+}
+
+int main( int argc, char** argv )
+{
+  uint8_t header[WIFI_IMAGE_HEADER_SIZE] = { 0 };
+  uint8_t* image = NULL;
+  FILE* in = NULL;
+  FILE* out = NULL;
+  long length;
+  int err = 1;
+
+  if ( argc != 3 ){
+    fprintf( stderr, "Usage: %s <driver.bin> <output.bin>\n", argv[0] );
+    return 1;
+  }
+
+  in = fopen( argv[1], "rb" );
+  if ( in == NULL || fseek( in, 0, SEEK_END ) != 0 || ( length = ftell( in ) ) <= 0 || fseek( in, 0, SEEK_SET ) != 0 ){
+    fprintf( stderr, "Cannot read %s\n", argv[1] );
+    goto exit;
+  }
+  image = malloc( (size_t) length );
+  if ( image == NULL || fread( image, 1, (size_t) length, in ) != (size_t) length ){
+    fprintf( stderr, "Cannot read %s\n", argv[1] );
+    goto exit;
+  }
+
+  put_le( &header[0],  WIFI_IMAGE_HEADER_MAGIC, 4 );
+  put_le( &header[4],  WIFI_IMAGE_HEADER_VERSION, 2 );
+  put_le( &header[6],  WIFI_IMAGE_HEADER_SIZE, 2 );
+  put_le( &header[8],  (uint32_t) length, 4 );
+  put_le( &header[12], crc16( 0, image, length ), 2 );
+
+  out = fopen( argv[2], "wb" );
+  if ( out == NULL || fwrite( header, 1, sizeof(header), out ) != sizeof(header) ||
+       fwrite( image, 1, (size_t) length, out ) != (size_t) length ){
+    fprintf( stderr, "Cannot write %s\n", argv[2] );
+    goto exit;
+  }
+  err = 0;
+
+exit:
+  if ( out != NULL && fclose( out ) != 0 )
+    err = 1;
+  if ( in != NULL )
+    fclose( in );
+  free( image );
+  return err;
+}
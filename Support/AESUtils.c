@@ -38,6 +38,10 @@ void AES_cbc_encrypt(const unsigned char *in, unsigned char *out,
 
 #define aes_log(M, ...) custom_log("AES", M, ##__VA_ARGS__)
 
+// Number of counter blocks turned into keystream per AES call batch in AES_CTR_Update.
+
+#define kAES_CTR_BatchBlocks        4
+
 //===========================================================================================================================
 //  AES_CTR_Init
 //===========================================================================================================================
@@ -91,6 +95,93 @@ static inline void AES_CTR_Increment( uint8_t *inCounter )
     }
 }
 
+//===========================================================================================================================
+//  AES_CTR_Keystream
+//===========================================================================================================================
+
+static OSStatus AES_CTR_Keystream( AES_CTR_Context *inContext, uint8_t *outBuf, size_t inBlocks )
+{
+    OSStatus        err;
+    size_t          len;
+    size_t          i;
+    
+    // Lay out the counter blocks first so the backend can encrypt them all in one call where it supports it.
+    
+    len = inBlocks * kAES_CTR_Size;
+    for( i = 0; i < len; i += kAES_CTR_Size )
+    {
+        memcpy( &outBuf[ i ], inContext->ctr, kAES_CTR_Size );
+        AES_CTR_Increment( inContext->ctr );
+    }
+    
+    #if( AES_UTILS_USE_COMMON_CRYPTO )
+        err = CCCryptorUpdate( inContext->cryptor, outBuf, len, outBuf, len, &i );
+        require_noerr( err, exit );
+        require_action( i == len, exit, err = kSizeErr );
+    #elif( AES_UTILS_USE_GLADMAN_AES )
+        aes_ecb_encrypt( outBuf, outBuf, (int) len, &inContext->ctx );
+    #else
+        for( i = 0; i < len; i += kAES_CTR_Size )
+        {
+            #if( AES_UTILS_USE_MICO_AES )
+                AesEncryptDirect( &inContext->ctx, &outBuf[ i ], &outBuf[ i ] );
+            #elif( AES_UTILS_USE_USSL )
+                aes_crypt_ecb( &inContext->ctx, AES_ENCRYPT, &outBuf[ i ], &outBuf[ i ] );
+            #else
+                AES_encrypt( &outBuf[ i ], &outBuf[ i ], &inContext->key );
+            #endif
+        }
+    #endif
+    err = kNoErr;
+    
+#if( AES_UTILS_USE_COMMON_CRYPTO )
+exit:
+#endif
+    return( err );
+}
+
+//===========================================================================================================================
+//  AES_CTR_Xor
+//===========================================================================================================================
+
+static void AES_CTR_Xor( uint8_t *inDst, const uint8_t *inSrc, const uint8_t *inKeystream, size_t inLen )
+{
+    size_t      i;
+    
+    // inKeystream is always word aligned. Go a word at a time when the data is too.
+    
+    if( ( ( (uintptr_t) inDst | (uintptr_t) inSrc ) & 3 ) == 0 )
+    {
+        uint32_t *              dst32 = (uint32_t *) inDst;
+        const uint32_t *        src32 = (const uint32_t *) inSrc;
+        const uint32_t *        key32 = (const uint32_t *) inKeystream;
+        
+        for( i = inLen / 4; i >= 4; i -= 4 )
+        {
+            dst32[ 0 ] = src32[ 0 ] ^ key32[ 0 ];
+            dst32[ 1 ] = src32[ 1 ] ^ key32[ 1 ];
+            dst32[ 2 ] = src32[ 2 ] ^ key32[ 2 ];
+            dst32[ 3 ] = src32[ 3 ] ^ key32[ 3 ];
+            dst32 += 4;
+            src32 += 4;
+            key32 += 4;
+        }
+        for( ; i > 0; --i )
+        {
+            *dst32++ = *src32++ ^ *key32++;
+        }
+        i = inLen & ~( (size_t) 3 );
+    }
+    else
+    {
+        i = 0;
+    }
+    for( ; i < inLen; ++i )
+    {
+        inDst[ i ] = inSrc[ i ] ^ inKeystream[ i ];
+    }
+}
+
 //===========================================================================================================================
 //  AES_CTR_Update
 //===========================================================================================================================
@@ -102,7 +193,9 @@ OSStatus    AES_CTR_Update( AES_CTR_Context *inContext, const void *inSrc, size_
     uint8_t *           dst;
     uint8_t *           buf;
     size_t              used;
+    size_t              len;
     size_t              i;
+    uint32_t            keystream[ ( kAES_CTR_BatchBlocks * kAES_CTR_Size ) / 4 ];
     
     // inSrc and inDst may be the same, but otherwise, the buffers must not overlap.
     
@@ -125,52 +218,28 @@ OSStatus    AES_CTR_Update( AES_CTR_Context *inContext, const void *inSrc, size_
     }
     inContext->used = used;
     
-    // Process whole blocks.
+    // Process whole blocks, up to kAES_CTR_BatchBlocks of keystream at a time.
     
     while( inLen >= kAES_CTR_Size )
     {
-        #if( AES_UTILS_USE_COMMON_CRYPTO )
-            err = CCCryptorUpdate( inContext->cryptor, inContext->ctr, kAES_CTR_Size, buf, kAES_CTR_Size, &i );
-            require_noerr( err, exit );
-            require_action( i == kAES_CTR_Size, exit, err = kSizeErr );
-        #elif( AES_UTILS_USE_GLADMAN_AES )
-            aes_ecb_encrypt( inContext->ctr, buf, kAES_CTR_Size, &inContext->ctx );
-        #elif( AES_UTILS_USE_MICO_AES )
-            AesEncryptDirect( &inContext->ctx, buf, inContext->ctr );
-        #elif( AES_UTILS_USE_USSL )
-            aes_crypt_ecb( &inContext->ctx, AES_ENCRYPT, inContext->ctr, buf );
-        #else
-            AES_encrypt( inContext->ctr, buf, &inContext->key );
-        #endif
-        AES_CTR_Increment( inContext->ctr );
+        len = inLen / kAES_CTR_Size;
+        if( len > kAES_CTR_BatchBlocks ) len = kAES_CTR_BatchBlocks;
+        err = AES_CTR_Keystream( inContext, (uint8_t *) keystream, len );
+        require_noerr( err, exit );
         
-        for( i = 0; i < kAES_CTR_Size; ++i )
-        {
-            dst[ i ] = src[ i ] ^ buf[ i ];
-        }
-        src   += kAES_CTR_Size;
-        dst   += kAES_CTR_Size;
-        inLen -= kAES_CTR_Size;
+        len *= kAES_CTR_Size;
+        AES_CTR_Xor( dst, src, (const uint8_t *) keystream, len );
+        src   += len;
+        dst   += len;
+        inLen -= len;
     }
     
     // Process any trailing sub-block bytes. Extra key material is buffered for next time.
     
     if( inLen > 0 )
     {
-        #if( AES_UTILS_USE_COMMON_CRYPTO )
-            err = CCCryptorUpdate( inContext->cryptor, inContext->ctr, kAES_CTR_Size, buf, kAES_CTR_Size, &i );
-            require_noerr( err, exit );
-            require_action( i == kAES_CTR_Size, exit, err = kSizeErr );
-        #elif( AES_UTILS_USE_GLADMAN_AES )
-            aes_ecb_encrypt( inContext->ctr, buf, kAES_CTR_Size, &inContext->ctx );
-        #elif( AES_UTILS_USE_MICO_AES )
-            AesEncryptDirect( &inContext->ctx, buf, inContext->ctr );
-        #elif( AES_UTILS_USE_USSL )
-            aes_crypt_ecb( &inContext->ctx, AES_ENCRYPT, inContext->ctr, buf );
-        #else
-            AES_encrypt( inContext->ctr, buf, &inContext->key );
-        #endif
-        AES_CTR_Increment( inContext->ctr );
+        err = AES_CTR_Keystream( inContext, buf, 1 );
+        require_noerr( err, exit );
         
         for( i = 0; i < inLen; ++i )
         {
@@ -186,9 +255,8 @@ OSStatus    AES_CTR_Update( AES_CTR_Context *inContext, const void *inSrc, size_
     }
     err = kNoErr;
     
-#if( AES_UTILS_USE_COMMON_CRYPTO )
 exit:
-#endif
+    memset( keystream, 0, sizeof( keystream ) ); // Clear sensitive data.
     return( err );
 }
 
@@ -0,0 +1,528 @@
+/**
+******************************************************************************
+* @file    HTTPClientUtils.c
+* @author  William Xu
+* @version V1.0.0
+* @date    18-Oct-2026
+* @brief   A HTTP/1.1 client that keeps its connection between requests and
+*          pipelines them.
+******************************************************************************
+* @attention
+*
+* THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+* WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+* TIME. AS A RESULT, MXCHIP Inc. SHALL NOT BE HELD LIABLE FOR ANY
+* DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+* FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+* CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+*
+* <h2><center>&copy; COPYRIGHT 2014 MXCHIP Inc.</center></h2>
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "StringUtils.h"
+#include "HTTPUtils.h"
+#include "HTTPClientUtils.h"
+#include "SocketUtils.h"
+
+#define http_client_log(M, ...) custom_log("HTTPClient", M, ##__VA_ARGS__)
+
+OSStatus HTTPClientInit( HTTPClient_t *client, const char *host, uint16_t port )
+{
+  OSStatus err = kParamErr;
+
+  require( client, exit );
+  memset( client, 0x0, sizeof(HTTPClient_t) );
+  client->fd = -1;
+  err = MICOConnectionInit( &client->conn, host, port );
+
+exit:
+  return err;
+}
+
+static void _HTTPClientDisconnect( HTTPClient_t *client, bool failed )
+{
+  if( client->fd < 0 ) return;
+  SocketClose( &client->fd );
+  MICOConnectionClosed( &client->conn, failed );
+  client->inFlight = 0;
+  client->headMask = 0;
+  client->bufStart = client->bufEnd = 0;
+}
+
+void HTTPClientClose( HTTPClient_t *client )
+{
+  _HTTPClientDisconnect( client, false );
+}
+
+int HTTPClientPending( HTTPClient_t *client )
+{
+  return client->inFlight;
+}
+
+// Nothing is expected on an idle connection, if it is readable the server has closed it
+static bool _HTTPClientIdleAlive( HTTPClient_t *client )
+{
+  fd_set readSet;
+  struct timeval_t t;
+
+  if( mico_get_time() - client->lastActive > kHTTPClientIdleTimeout ) return false;
+  if( client->bufStart != client->bufEnd ) return false;
+
+  FD_ZERO( &readSet );
+  FD_SET( client->fd, &readSet );
+  t.tv_sec = 0;
+  t.tv_usec = 0;
+  return select( client->fd + 1, &readSet, NULL, NULL, &t ) == 0;
+}
+
+static OSStatus _HTTPClientConnect( HTTPClient_t *client )
+{
+  OSStatus err = kNoErr;
+
+  require_quiet( client->fd < 0, exit );
+  client->fd = MICOConnectionOpen( &client->conn );
+  require_action( client->fd >= 0, exit, err = kConnectionErr );
+  client->lastActive = mico_get_time();
+
+exit:
+  return err;
+}
+
+OSStatus HTTPClientSendRequest( HTTPClient_t *client, const char *method, const char *path,
+                                const char *extraFields, const uint8_t *body, size_t bodyLen )
+{
+  OSStatus err = kParamErr;
+  char request[ kHTTPClientRequestMaxLen ];
+  char hostPort[ 8 ] = "";
+  char lengthField[ 32 ] = "";
+  socket_iovec_t iov[2];
+  int requestLen;
+  bool reused;
+
+  require( client, exit );
+  require( method, exit );
+  require( path, exit );
+  require( body || bodyLen == 0, exit );
+  require_action( client->inFlight < kHTTPClientMaxPipeline, exit, err = kNoResourcesErr );
+
+  if( client->conn.port != 80 )
+    snprintf( hostPort, sizeof(hostPort), ":%u", (unsigned int)client->conn.port );
+  if( bodyLen )
+    snprintf( lengthField, sizeof(lengthField), "Content-Length: %u\r\n", (unsigned int)bodyLen );
+  requestLen = snprintf( request, sizeof(request), "%s %s HTTP/1.1\r\nHost: %s%s\r\nConnection: keep-alive\r\n%s%s\r\n",
+                         method, path, client->conn.host, hostPort, extraFields ? extraFields : "", lengthField );
+  require_action( requestLen > 0 && requestLen < (int)sizeof(request), exit, err = kSizeErr );
+
+  iov[0].base = request;
+  iov[0].len = requestLen;
+  iov[1].base = body;
+  iov[1].len = bodyLen;
+
+  if( client->fd >= 0 && client->inFlight == 0 && !_HTTPClientIdleAlive( client ) )
+    _HTTPClientDisconnect( client, false );
+  reused = ( client->fd >= 0 );
+  err = _HTTPClientConnect( client );
+  require_noerr( err, exit );
+
+  err = SocketSendv( client->fd, iov, 2 );
+  if( err != kNoErr && reused && client->inFlight == 0 ){
+    // Closed by the server just before we sent, once more on a new connection
+    _HTTPClientDisconnect( client, false );
+    err = _HTTPClientConnect( client );
+    require_noerr( err, exit );
+    err = SocketSendv( client->fd, iov, 2 );
+  }
+  require_noerr_action( err, exit, _HTTPClientDisconnect( client, true ); err = kConnectionErr );
+
+  if( strcmp( method, "HEAD" ) == 0 )
+    client->headMask |= 1 << client->inFlight;
+  client->inFlight++;
+
+exit:
+  return err;
+}
+
+// Reads more of the stream into buf, behind what is not consumed yet
+static OSStatus _HTTPClientFill( HTTPClient_t *client )
+{
+  OSStatus err = kNoSpaceErr;
+  fd_set readSet;
+  struct timeval_t t;
+  ssize_t readResult;
+
+  if( client->bufStart == client->bufEnd ){
+    client->bufStart = client->bufEnd = 0;
+  }else if( client->bufStart > 0 && client->bufEnd == sizeof(client->buf) ){
+    memmove( client->buf, client->buf + client->bufStart, client->bufEnd - client->bufStart );
+    client->bufEnd -= client->bufStart;
+    client->bufStart = 0;
+  }
+  require( client->bufEnd < sizeof(client->buf), exit );
+
+  FD_ZERO( &readSet );
+  FD_SET( client->fd, &readSet );
+  t.tv_sec = kHTTPClientReadTimeout / 1000;
+  t.tv_usec = 0;
+  err = kTimeoutErr;
+  require( select( client->fd + 1, &readSet, NULL, NULL, &t ) >= 1, exit );
+
+  readResult = read( client->fd, client->buf + client->bufEnd, sizeof(client->buf) - client->bufEnd );
+  require_action_quiet( readResult > 0, exit, err = kConnectionErr );
+  client->bufEnd += readResult;
+  err = kNoErr;
+
+exit:
+  return err;
+}
+
+// One line consumed from buf, outLineLen does not count the line ending
+static OSStatus _HTTPClientReadLine( HTTPClient_t *client, const char **outLine, size_t *outLineLen )
+{
+  OSStatus err = kNoErr;
+  uint8_t *lf;
+
+  while( ( lf = memchr( client->buf + client->bufStart, '\n', client->bufEnd - client->bufStart ) ) == NULL ){
+    err = _HTTPClientFill( client );
+    require_noerr_quiet( err, exit );
+  }
+
+  *outLine = (const char *)client->buf + client->bufStart;
+  *outLineLen = (size_t)( (const char *)lf - *outLine );
+  if( *outLineLen > 0 && (*outLine)[ *outLineLen - 1 ] == '\r' ) (*outLineLen)--;
+  client->bufStart = lf + 1 - client->buf;
+
+exit:
+  return err;
+}
+
+static OSStatus _HTTPClientReadHeader( HTTPClient_t *client, HTTPHeader_t *ioHeader )
+{
+  OSStatus err = kNoErr;
+  size_t copied = 0;
+  size_t copyLen;
+  char *end;
+
+  for( ;; ){
+    // The header may be followed by the body and even by the next response
+    copyLen = client->bufEnd - client->bufStart;
+    if( copyLen > sizeof(ioHeader->buf) ) copyLen = sizeof(ioHeader->buf);
+    memcpy( ioHeader->buf + copied, client->buf + client->bufStart + copied, copyLen - copied );
+    copied = copyLen;
+    ioHeader->len = copied;
+    if( findHeader( ioHeader, &end ) ) break;
+
+    require_action( copied < sizeof(ioHeader->buf), exit, err = kNoSpaceErr );
+    err = _HTTPClientFill( client );
+    require_noerr_quiet( err, exit );
+  }
+
+  ioHeader->len = (size_t)( end - ioHeader->buf );
+  client->bufStart += ioHeader->len;
+  err = HTTPHeaderParse( ioHeader );
+  require_noerr( err, exit );
+
+exit:
+  return err;
+}
+
+// The first piece of a body decides, like in SocketReadHTTPHeader, whether the
+// callback takes it or it is kept in extraDataPtr
+static OSStatus _HTTPClientDeliver( HTTPHeader_t *ioHeader, uint32_t inBasePos, uint32_t inPos, uint8_t *inData, size_t inLen, bool inFallback )
+{
+  OSStatus err = kNoErr;
+  char *data;
+  size_t size;
+
+  if( inPos == 0 ){
+    if( inFallback == false ){
+      ioHeader->isCallbackSupported = true;
+    }else{
+      ioHeader->isCallbackSupported = ioHeader->onReceivedDataCallback &&
+        (ioHeader->onReceivedDataCallback)( ioHeader, inBasePos, inData, inLen, ioHeader->userContext ) == kNoErr;
+      if( ioHeader->isCallbackSupported ) goto exit;
+    }
+  }
+
+  if( ioHeader->isCallbackSupported ){
+    err = (ioHeader->onReceivedDataCallback)( ioHeader, inBasePos + inPos, inData, inLen, ioHeader->userContext );
+    require_noerr_quiet( err, exit );
+    goto exit;
+  }
+
+  // The body is kept in RAM, refuse it before sizing the buffer when it cannot fit
+  require_action( ioHeader->contentLength <= kHTTPClientMaxBodyLen, exit, err = kSizeErr );
+  require_action( inLen <= kHTTPClientMaxBodyLen - ioHeader->extraDataLen, exit, err = kSizeErr );
+
+  // Room for the whole body at once when its length is known, grown piece by piece otherwise.
+  // The buffer holds at least contentLength bytes and the terminating 0
+  size = (size_t)ioHeader->contentLength;
+  if( ioHeader->extraDataPtr == NULL || ioHeader->extraDataLen + inLen > size ){
+    if( size < ioHeader->extraDataLen + inLen ) size = ioHeader->extraDataLen + inLen;
+    data = realloc( ioHeader->extraDataPtr, size + 1 );
+    require_action( data, exit, err = kNoMemoryErr );
+    ioHeader->extraDataPtr = data;
+  }
+  require_action( ioHeader->extraDataLen + inLen <= size, exit, err = kSizeErr );
+  memcpy( ioHeader->extraDataPtr + ioHeader->extraDataLen, inData, inLen );
+  ioHeader->extraDataLen += inLen;
+  ioHeader->extraDataPtr[ ioHeader->extraDataLen ] = 0;
+  // HTTPHeaderClear takes anything beyond contentLength for the start of the next message
+  if( ioHeader->extraDataLen > ioHeader->contentLength ) ioHeader->contentLength = ioHeader->extraDataLen;
+
+exit:
+  return err;
+}
+
+static OSStatus _HTTPClientReadData( HTTPClient_t *client, HTTPHeader_t *ioHeader, uint32_t inBasePos, uint32_t *ioPos,
+                                     uint64_t inLen, bool inFallback )
+{
+  OSStatus err = kNoErr;
+  size_t len;
+
+  while( inLen > 0 ){
+    if( client->bufStart == client->bufEnd ){
+      err = _HTTPClientFill( client );
+      require_noerr_quiet( err, exit );
+    }
+    len = client->bufEnd - client->bufStart;
+    if( len > inLen ) len = (size_t)inLen;
+
+    err = _HTTPClientDeliver( ioHeader, inBasePos, *ioPos, client->buf + client->bufStart, len, inFallback );
+    require_noerr( err, exit );
+    client->bufStart += len;
+    *ioPos += len;
+    inLen -= len;
+  }
+
+exit:
+  return err;
+}
+
+static OSStatus _HTTPClientReadChunkedData( HTTPClient_t *client, HTTPHeader_t *ioHeader, uint32_t inBasePos, uint32_t *ioPos,
+                                            bool inFallback )
+{
+  OSStatus err;
+  const char *line;
+  size_t lineLen, i;
+  uint32_t chunkLen;
+  int digit;
+
+  for( ;; ){
+    err = _HTTPClientReadLine( client, &line, &lineLen );
+    require_noerr_quiet( err, exit );
+
+    // Chunk size in hex, any chunk extension after it is ignored
+    chunkLen = 0;
+    for( i = 0; i < lineLen; i++ ){
+      if(      line[i] >= '0' && line[i] <= '9' ) digit = line[i] - '0';
+      else if( line[i] >= 'a' && line[i] <= 'f' ) digit = line[i] - 'a' + 10;
+      else if( line[i] >= 'A' && line[i] <= 'F' ) digit = line[i] - 'A' + 10;
+      else break;
+      require_action( chunkLen < 0x08000000, exit, err = kMalformedErr );
+      chunkLen = ( chunkLen << 4 ) | digit;
+    }
+    require_action( i > 0, exit, err = kMalformedErr );
+    if( chunkLen == 0 ) break;
+
+    err = _HTTPClientReadData( client, ioHeader, inBasePos, ioPos, chunkLen, inFallback );
+    require_noerr_quiet( err, exit );
+    err = _HTTPClientReadLine( client, &line, &lineLen );
+    require_noerr_quiet( err, exit );
+    require_action( lineLen == 0, exit, err = kMalformedErr );
+  }
+
+  // Trailer fields up to an empty line
+  do{
+    err = _HTTPClientReadLine( client, &line, &lineLen );
+    require_noerr_quiet( err, exit );
+  }while( lineLen > 0 );
+
+  // HTTPHeaderClear expects the length of what extraDataPtr holds
+  ioHeader->contentLength = *ioPos;
+
+exit:
+  return err;
+}
+
+// Skips the interim 1xx responses
+static OSStatus _HTTPClientReadResponseHeader( HTTPClient_t *client, HTTPHeader_t *ioHeader )
+{
+  OSStatus err = kParamErr;
+
+  require( client, exit );
+  require( ioHeader, exit );
+  err = kConnectionErr;
+  require_quiet( client->fd >= 0 && client->inFlight > 0, exit );
+
+  do{
+    HTTPHeaderClear( ioHeader );
+    ioHeader->len = 0;
+    ioHeader->isCallbackSupported = false;
+    err = _HTTPClientReadHeader( client, ioHeader );
+    require_noerr_quiet( err, exit );
+  }while( ioHeader->statusCode >= 100 && ioHeader->statusCode < 200 );
+
+exit:
+  if( err != kNoErr && client && client->inFlight > 0 ) _HTTPClientDisconnect( client, true );
+  return err;
+}
+
+static OSStatus _HTTPClientReadResponseBody( HTTPClient_t *client, HTTPHeader_t *ioHeader, uint32_t inBasePos, bool inFallback,
+                                             uint32_t *outLen )
+{
+  OSStatus err = kNoErr;
+  bool isHead = client->headMask & 0x1;
+
+  *outLen = 0;
+  if( isHead || ioHeader->statusCode == 204 || ioHeader->statusCode == 304 ){
+    // No body, whatever the length fields say
+  }else if( ioHeader->chunkedData ){
+    err = _HTTPClientReadChunkedData( client, ioHeader, inBasePos, outLen, inFallback );
+  }else if( ioHeader->contentLength > 0 || ioHeader->persistent ){
+    err = _HTTPClientReadData( client, ioHeader, inBasePos, outLen, ioHeader->contentLength, inFallback );
+  }else{
+    // Neither a length nor chunks, the body ends when the server closes the connection
+    err = _HTTPClientReadData( client, ioHeader, inBasePos, outLen, (uint64_t)-1, inFallback );
+    if( err == kConnectionErr ){
+      ioHeader->contentLength = *outLen;
+      err = kNoErr;
+    }
+  }
+  require_noerr_quiet( err, exit );
+
+  client->inFlight--;
+  client->headMask >>= 1;
+  client->lastActive = mico_get_time();
+  if( ioHeader->persistent == false )
+    _HTTPClientDisconnect( client, false );
+
+exit:
+  if( err != kNoErr ) _HTTPClientDisconnect( client, true );
+  return err;
+}
+
+OSStatus HTTPClientReadResponse( HTTPClient_t *client, HTTPHeader_t *ioHeader )
+{
+  OSStatus err;
+  uint32_t len;
+
+  err = _HTTPClientReadResponseHeader( client, ioHeader );
+  require_noerr_quiet( err, exit );
+  err = _HTTPClientReadResponseBody( client, ioHeader, 0, true, &len );
+  require_noerr_quiet( err, exit );
+
+exit:
+  return err;
+}
+
+static const char * _HTTPClientParseUInt( const char *inPtr, const char *inEnd, uint32_t *outValue )
+{
+  const char *start = inPtr;
+
+  *outValue = 0;
+  while( inPtr < inEnd && *inPtr >= '0' && *inPtr <= '9' )
+    *outValue = ( *outValue * 10 ) + ( *inPtr++ - '0' );
+  return ( inPtr > start ) ? inPtr : NULL;
+}
+
+// "bytes first-last/total", total is 0 when the server does not know it
+static OSStatus _HTTPClientGetContentRange( HTTPHeader_t *inHeader, uint32_t *outFirst, uint32_t *outLast, uint32_t *outTotal )
+{
+  OSStatus err;
+  const char *value, *end;
+  size_t valueLen;
+
+  err = HTTPHeaderGetField( inHeader, "Content-Range", &value, &valueLen );
+  require_noerr_quiet( err, exit );
+  end = value + valueLen;
+
+  err = kMalformedErr;
+  require( valueLen > 6 && strnicmp( value, "bytes ", 6 ) == 0, exit );
+  value = _HTTPClientParseUInt( value + 6, end, outFirst );
+  require( value && value < end && *value == '-', exit );
+  value = _HTTPClientParseUInt( value + 1, end, outLast );
+  require( value && value < end && *value == '/', exit );
+  value++;
+  if( value < end && *value == '*' ) *outTotal = 0;
+  else require( _HTTPClientParseUInt( value, end, outTotal ), exit );
+  require( *outFirst <= *outLast, exit );
+  err = kNoErr;
+
+exit:
+  return err;
+}
+
+OSStatus HTTPClientDownload( HTTPClient_t *client, const char *path, uint32_t offset, uint32_t length,
+                             HTTPHeader_t *ioHeader )
+{
+  OSStatus err = kParamErr;
+  char rangeField[ 48 ];
+  uint32_t next = offset;                         // First byte not asked for yet
+  uint32_t done = offset;                         // First byte not received yet
+  uint32_t end = length ? offset + length : 0;    // 0 while the size of the file is unknown
+  uint32_t first, last, total, received;
+  int retries = 0;
+
+  require( client, exit );
+  require( path, exit );
+  require( ioHeader && ioHeader->onReceivedDataCallback, exit );
+
+  while( end == 0 || done < end ){
+    // Keep the pipeline full, one request at a time until the size is known
+    err = kNoErr;
+    while( client->inFlight < kHTTPClientMaxPipeline && ( end ? next < end : client->inFlight == 0 ) ){
+      last = next + kHTTPClientRangeLen - 1;
+      if( end && last >= end ) last = end - 1;
+      snprintf( rangeField, sizeof(rangeField), "Range: bytes=%u-%u\r\n", (unsigned int)next, (unsigned int)last );
+      err = HTTPClientSendRequest( client, "GET", path, rangeField, NULL, 0 );
+      if( err != kNoErr ) break;
+      next = last + 1;
+    }
+
+    received = 0;
+    if( err == kNoErr ) err = _HTTPClientReadResponseHeader( client, ioHeader );
+    if( err == kNoErr ){
+      if( ioHeader->statusCode == kStatusPartialContent ){
+        err = _HTTPClientGetContentRange( ioHeader, &first, &last, &total );
+        require_noerr_action( err, exit, HTTPClientClose( client ) );
+        require_action( first == done, exit, HTTPClientClose( client ); err = kResponseErr );
+        if( end == 0 ){
+          require_action( total, exit, HTTPClientClose( client ); err = kResponseErr );
+          end = total;
+        }
+        err = _HTTPClientReadResponseBody( client, ioHeader, done, false, &received );
+      }else if( ioHeader->statusCode == kStatusOK && done == 0 ){
+        // Range is not supported, the whole file comes in this response and
+        // the other requests in flight would only bring it again
+        err = _HTTPClientReadResponseBody( client, ioHeader, 0, false, &received );
+        HTTPClientClose( client );
+        require_noerr( err, exit );
+        break;
+      }else{
+        http_client_log( "Download of %s at %u failed, status %d", path, (unsigned int)done, ioHeader->statusCode );
+        HTTPClientClose( client );
+        err = ( ioHeader->statusCode == kStatusNotFound ) ? kNotFoundErr : kResponseErr;
+        goto exit;
+      }
+    }
+    done += received;
+
+    if( err == kConnectionErr || err == kTimeoutErr ){
+      // The requests still in flight are lost, ask again from where the data stopped
+      if( received ) retries = 0;
+      require_quiet( ++retries <= kHTTPClientMaxRetries, exit );
+      http_client_log( "Connection lost at %u, retry %d", (unsigned int)done, retries );
+      next = done;
+      continue;
+    }
+    require_noerr( err, exit );
+    retries = 0;
+  }
+  err = kNoErr;
+
+exit:
+  return err;
+}
+
@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file    HTTPClientUtils.h
+  * @author  William Xu
+  * @version V1.0.0
+  * @date    18-Oct-2026
+  * @brief   This header contains function prototypes of a HTTP/1.1 client that
+  *          keeps its connection to the server between requests.
+  ******************************************************************************
+  * @attention
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, MXCHIP Inc. SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 MXCHIP Inc.</center></h2>
+  ******************************************************************************
+  */
+
+#ifndef __HTTPClientUtils_h__
+#define __HTTPClientUtils_h__
+
+#include "Common.h"
+#include "HTTPUtils.h"
+#include "MICOConnectionManager.h"
+
+/* One HTTPClient_t talks to one host:port from one thread. The connection is kept
+   open as long as the server allows it (the persistent flag of the last response)
+   and up to kHTTPClientMaxPipeline requests can be sent before their responses are
+   read. Responses come back in the order the requests were sent. */
+
+#define kHTTPClientBufferLen        (1024)
+#define kHTTPClientRequestMaxLen    (320)
+#define kHTTPClientMaxPipeline      (4)
+#define kHTTPClientReadTimeout      (10*1000)   //ms, for every read of a response
+#define kHTTPClientIdleTimeout      (60*1000)   //ms, an idle connection older than this is not reused
+#define kHTTPClientRangeLen         (8*1024)    //bytes asked for in each request of HTTPClientDownload
+#define kHTTPClientMaxRetries       (3)         //reconnects in a row without new data
+#define kHTTPClientMaxBodyLen       (16*1024)   //bytes of a body kept in extraDataPtr
+
+typedef struct _HTTPClient_t {
+  mico_connection_t   conn;
+  int                 fd;
+  uint32_t            lastActive;               //ms
+  uint8_t             inFlight;                 //Requests sent whose response is not read yet
+  uint8_t             headMask;                 //Bit n set when the n-th request in flight is a HEAD
+  size_t              bufStart;
+  size_t              bufEnd;
+  uint8_t             buf[ kHTTPClientBufferLen ];  //Received and not consumed yet, may hold the next response
+} HTTPClient_t;
+
+
+OSStatus HTTPClientInit( HTTPClient_t *client, const char *host, uint16_t port );
+
+/* Connects when needed and sends "method path HTTP/1.1" with Host and Connection:
+   keep-alive. extraFields are more header lines, each one ending with CRLF, or NULL.
+   A Content-Length is added when bodyLen is not 0 */
+OSStatus HTTPClientSendRequest( HTTPClient_t *client, const char *method, const char *path,
+                                const char *extraFields, const uint8_t *body, size_t bodyLen );
+
+/* Reads the response of the oldest request in flight into ioHeader, which is cleared
+   first. The body goes to the onReceivedDataCallback of ioHeader. Like
+   SocketReadHTTPHeader, a body the callback refuses from the start is kept in
+   extraDataPtr instead, null terminated, and one longer than kHTTPClientMaxBodyLen
+   fails with kSizeErr. The connection is closed after a response
+   that is not persistent, requests still in flight then fail with kConnectionErr
+   and have to be sent again */
+OSStatus HTTPClientReadResponse( HTTPClient_t *client, HTTPHeader_t *ioHeader );
+
+/* Number of requests sent whose response is not read yet */
+int HTTPClientPending( HTTPClient_t *client );
+
+/* Gets path from offset with pipelined Range requests of kHTTPClientRangeLen bytes.
+   length 0 reads up to the end of the file. Every piece is given to the
+   onReceivedDataCallback of ioHeader with its offset in the file. A lost connection
+   is opened again and the download goes on where it stopped */
+OSStatus HTTPClientDownload( HTTPClient_t *client, const char *path, uint32_t offset, uint32_t length,
+                             HTTPHeader_t *ioHeader );
+
+/* Closes the connection, requests in flight are dropped */
+void HTTPClientClose( HTTPClient_t *client );
+
+#endif // __HTTPClientUtils_h__
+
@@ -23,6 +23,7 @@
 #include "MICO.h"
 #include "StringUtils.h"
 #include "HTTPUtils.h"
+#include "SocketUtils.h"
 #include "MicoPlatform.h"
 #include "platform.h"
 
@@ -370,6 +371,103 @@ exit:
 //  Parses an HTTP header. This assumes the "buf" and "len" fields are set. The other fields are set by this function.
 //===========================================================================================================================
 
+// Case-insensitive FNV-1a of a header field name, folded to 16 bits.
+static uint16_t HTTPHeaderHashName( const char *inName, size_t inLen )
+{
+  uint32_t            hash = 2166136261U;
+  char                c;
+  
+  while( inLen-- > 0 )
+  {
+    c = *inName++;
+    if( ( c >= 'A' ) && ( c <= 'Z' ) ) c += 'a' - 'A';
+    hash = ( hash ^ (uint8_t) c ) * 16777619U;
+  }
+  return (uint16_t)( hash ^ ( hash >> 16 ) );
+}
+
+// Walks the header lines once, same rules as HTTPGetHeaderField, and records where each field is.
+static void HTTPHeaderIndexFields( HTTPHeader_t *ioHeader, const char *src, const char *end )
+{
+  HTTPHeaderField_t * field;
+  const char *        linePtr;
+  const char *        lineEnd;
+  const char *        nameEnd;
+  const char *        valuePtr;
+  const char *        valueEnd;
+  char                c;
+  
+  // The start line parse leaves src on the LF of its CRLF.
+  if( ( src < end ) && ( *src == '\n' ) ) ++src;
+  
+  for( ;; )
+  {
+    linePtr = src;
+    while( ( src < end ) && ( ( c = *src ) != '\r' ) && ( c != '\n' ) ) ++src;
+    if( src >= end ) break;
+    lineEnd = src;
+    if( ( src < end ) && ( *src == '\r' ) ) ++src;
+    if( ( src < end ) && ( *src == '\n' ) ) ++src;
+    if( lineEnd == linePtr ) break; // Blank line, end of the header.
+    
+    nameEnd = linePtr;
+    while( ( nameEnd < lineEnd ) && ( *nameEnd != ':' ) ) ++nameEnd;
+    if( nameEnd >= lineEnd ) continue;
+    
+    valuePtr = nameEnd + 1;
+    valueEnd = lineEnd;
+    while( ( valuePtr < valueEnd ) && ( ( ( c = *valuePtr ) == ' ' ) || ( c == '\t' ) ) ) ++valuePtr;
+    
+    // If the next line is a continuation line then keep parsing until we get to the true end.
+    while( ( src < end ) && ( ( ( c = *src ) == ' ' ) || ( c == '\t' ) ) )
+    {
+      ++src;
+      while( ( src < end ) && ( ( c = *src ) != '\r' ) && ( c != '\n' ) ) ++src;
+      valueEnd = src;
+      if( ( src < end ) && ( *src == '\r' ) ) ++src;
+      if( ( src < end ) && ( *src == '\n' ) ) ++src;
+    }
+    
+    if( ioHeader->fieldCount >= kHTTPHeaderFieldMax )
+    {
+      ioHeader->fieldsOverflow = true;
+      break;
+    }
+    field = &ioHeader->fields[ ioHeader->fieldCount++ ];
+    field->nameOffset  = (uint16_t)( linePtr - ioHeader->buf );
+    field->nameLen     = (uint16_t)( nameEnd - linePtr );
+    field->nameHash    = HTTPHeaderHashName( linePtr, field->nameLen );
+    field->valueOffset = (uint16_t)( valuePtr - ioHeader->buf );
+    field->valueLen    = (uint16_t)( valueEnd - valuePtr );
+  }
+}
+
+OSStatus HTTPHeaderGetField( HTTPHeader_t *inHeader, const char *inName, const char **outValuePtr, size_t *outValueLen )
+{
+  const HTTPHeaderField_t * field;
+  size_t              nameLen;
+  uint16_t            hash;
+  uint8_t             i;
+  
+  if( inHeader->fieldsOverflow )
+    return HTTPGetHeaderField( inHeader->buf, inHeader->len, inName, NULL, NULL, outValuePtr, outValueLen, NULL );
+  
+  nameLen = strlen( inName );
+  hash = HTTPHeaderHashName( inName, nameLen );
+  for( i = 0; i < inHeader->fieldCount; i++ )
+  {
+    field = &inHeader->fields[ i ];
+    if( ( field->nameHash != hash ) || ( field->nameLen != nameLen ) ||
+        ( strnicmp( &inHeader->buf[ field->nameOffset ], inName, nameLen ) != 0 ) )
+      continue;
+    
+    if( outValuePtr )   *outValuePtr    = &inHeader->buf[ field->valueOffset ];
+    if( outValueLen )   *outValueLen    = field->valueLen;
+    return kNoErr;
+  }
+  return kNotFoundErr;
+}
+
 OSStatus HTTPHeaderParse( HTTPHeader_t *ioHeader )
 {
   OSStatus            err;
@@ -398,6 +496,8 @@ OSStatus HTTPHeaderParse( HTTPHeader_t *ioHeader )
   ioHeader->channelID         = 0;
   ioHeader->contentLength     = 0;
   ioHeader->persistent        = false;
+  ioHeader->fieldCount        = 0;
+  ioHeader->fieldsOverflow    = false;
   
   // Check for a 4-byte interleaved binary data header (see RFC 2326 section 10.12). It has the following format:
   //
@@ -482,17 +582,31 @@ OSStatus HTTPHeaderParse( HTTPHeader_t *ioHeader )
   // There should at least be a blank line after the start line so make sure there's more data.
   require_action( ptr < end, exit, err = kMalformedErr );
   
+  // Index the header fields, later lookups go to the index instead of scanning buf again.
+  HTTPHeaderIndexFields( ioHeader, ptr, end );
+  
   // Determine persistence. Note: HTTP 1.0 defaults to non-persistent if a Connection header field is not present.
-  err = HTTPGetHeaderField( ioHeader->buf, ioHeader->len, "Connection", NULL, NULL, &value, &valueSize, NULL );
+  err = HTTPHeaderGetField( ioHeader, "Connection", &value, &valueSize );
   if( err )   ioHeader->persistent = (Boolean)( strnicmpx( ioHeader->protocolPtr, ioHeader->protocolLen, "HTTP/1.0" ) != 0 );
   else        ioHeader->persistent = (Boolean)( strnicmpx( value, valueSize, "close" ) != 0 );
 
-  err = HTTPGetHeaderField( ioHeader->buf, ioHeader->len, "Transfer-Encoding", NULL, NULL, &value, &valueSize, NULL );
+  err = HTTPHeaderGetField( ioHeader, "Transfer-Encoding", &value, &valueSize );
   if( err )   ioHeader->chunkedData = false;
   else        ioHeader->chunkedData = (Boolean)( strnicmpx( value, valueSize, kTransferrEncodingType_CHUNKED ) == 0 );
   
   // Content-Length is such a common field that we get it here during general parsing.
-  HTTPScanFHeaderValue( ioHeader->buf, ioHeader->len, "Content-Length", "%llu", &ioHeader->contentLength );
+  // It must be digits only, a value that is empty or does not fit is refused rather than truncated.
+  if( HTTPHeaderGetField( ioHeader, "Content-Length", &value, &valueSize ) == kNoErr )
+  {
+    for( ptr = value; ( ptr < value + valueSize ) && ( ( c = *ptr ) >= '0' ) && ( c <= '9' ); ++ptr )
+    {
+      require_action( ioHeader->contentLength <= ( UINT64_MAX - (uint64_t)( c - '0' ) ) / 10, exit, err = kMalformedErr );
+      ioHeader->contentLength = ( ioHeader->contentLength * 10 ) + ( c - '0' );
+    }
+    require_action( ptr > value, exit, err = kMalformedErr );
+    while( ( ptr < value + valueSize ) && ( ( *ptr == ' ' ) || ( *ptr == '\t' ) ) ) ++ptr;
+    require_action( ptr == value + valueSize, exit, err = kMalformedErr );
+  }
 
   err = kNoErr;
   
@@ -746,56 +860,189 @@ void HTTPHeaderClear( HTTPHeader_t *inHeader )
   }
 
   inHeader->isCallbackSupported = false;
+  inHeader->fieldCount = 0;
+  inHeader->fieldsOverflow = false;
 
 }
 
-OSStatus CreateSimpleHTTPOKMessage( uint8_t **outMessage, size_t *outMessageSize )
+/* Status lines and header fragments are constants, a response header is
+ * put together with memcpy and never goes through printf */
+typedef struct _HTTPStatusLine_t {
+  int           status;
+  const char    *reason;
+  const char    *line;
+  size_t        lineLen;
+} HTTPStatusLine_t;
+
+#define HTTP_STATUS_LINE( CODE, REASON ) \
+  { CODE, REASON, "HTTP/1.1 " #CODE " " REASON kCRLFNewLine, sizeof( "HTTP/1.1 " #CODE " " REASON kCRLFNewLine ) - 1 }
+
+static const HTTPStatusLine_t kHTTPStatusLines[] =
+{
+  HTTP_STATUS_LINE( 200, "OK" ),
+  HTTP_STATUS_LINE( 204, "No Content" ),
+  HTTP_STATUS_LINE( 206, "Multi0Status" ),
+  HTTP_STATUS_LINE( 400, "Bad Request" ),
+  HTTP_STATUS_LINE( 404, "Not Found" ),
+  HTTP_STATUS_LINE( 405, "Not Allowed" ),
+  HTTP_STATUS_LINE( 403, "Forbidden" ),
+  HTTP_STATUS_LINE( 470, "Authentication Error" ),
+  HTTP_STATUS_LINE( 500, "Internal Server Error" ),
+};
+
+#define kHTTPStatusLineCount        ( sizeof( kHTTPStatusLines ) / sizeof( kHTTPStatusLines[0] ) )
+
+#define kHTTPVersionPrefix          "HTTP/1.1 "
+#define kHTTPUnknownStatusSuffix    " OK" kCRLFNewLine
+#define kHTTPContentTypeField       "Content-Type: "
+#define kHTTPContentLengthField     kCRLFNewLine "Content-Length: "
+#define kHTTPChunkedField           kCRLFNewLine "Transfer-Encoding: " kTransferrEncodingType_CHUNKED
+
+/* Longest header without the content type: an unknown status never beats the
+ * longest status line, a 10 digit length is as long as the chunked field */
+#define kHTTPResponseHeaderFixedLen ( 36 + sizeof( kHTTPContentTypeField ) + sizeof( kHTTPContentLengthField ) + 10 + sizeof( kCRLFLineEnding ) )
+
+#define HTTPAppendConst( PTR, STR ) do { memcpy( PTR, STR, sizeof( STR ) - 1 ); PTR += sizeof( STR ) - 1; } while( 0 )
+
+static const char kHTTPDigitPairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const HTTPStatusLine_t * HTTPFindStatusLine( int status )
+{
+  size_t i;
+  
+  for( i = 0; i < kHTTPStatusLineCount; i++ )
+    if( kHTTPStatusLines[i].status == status ) return &kHTTPStatusLines[i];
+  return NULL;
+}
+
+// Decimal digits of inValue, two at a time from a table, no terminating null
+static size_t HTTPUIntToString( char *outBuf, uint32_t inValue )
+{
+  char digits[10];
+  char *p = digits + sizeof( digits );
+  size_t len;
+  
+  while( inValue >= 100 ){
+    p -= 2;
+    memcpy( p, &kHTTPDigitPairs[ ( inValue % 100 ) * 2 ], 2 );
+    inValue /= 100;
+  }
+  if( inValue >= 10 ){
+    p -= 2;
+    memcpy( p, &kHTTPDigitPairs[ inValue * 2 ], 2 );
+  }
+  else
+    *--p = (char)( '0' + inValue );
+  
+  len = digits + sizeof( digits ) - p;
+  memcpy( outBuf, p, len );
+  return len;
+}
+
+size_t HTTPResponseHeaderWrite( char *outBuf, size_t inBufLen, int status, const char *contentType, size_t inDataLen, bool inChunked )
+{
+  const HTTPStatusLine_t *statusLine = HTTPFindStatusLine( status );
+  size_t typeLen = contentType ? strlen( contentType ) : 0;
+  char *p = outBuf;
+  
+  // Room for the longest header up front, nothing below checks the length again
+  require_quiet( outBuf, exit );
+  require_quiet( inBufLen >= kHTTPResponseHeaderFixedLen + typeLen, exit );
+  
+  if( statusLine ){
+    memcpy( p, statusLine->line, statusLine->lineLen );
+    p += statusLine->lineLen;
+  }
+  else{
+    HTTPAppendConst( p, kHTTPVersionPrefix );
+    p += HTTPUIntToString( p, (uint32_t)status );
+    HTTPAppendConst( p, kHTTPUnknownStatusSuffix );
+  }
+  
+  if( contentType ){
+    HTTPAppendConst( p, kHTTPContentTypeField );
+    memcpy( p, contentType, typeLen );
+    p += typeLen;
+    if( inChunked )
+      HTTPAppendConst( p, kHTTPChunkedField );
+    else{
+      HTTPAppendConst( p, kHTTPContentLengthField );
+      p += HTTPUIntToString( p, (uint32_t)inDataLen );
+    }
+    HTTPAppendConst( p, kCRLFLineEnding );
+  }
+  else
+    HTTPAppendConst( p, kCRLFNewLine );
+  
+exit:
+  return p - outBuf;
+}
+
+OSStatus SocketSendHTTPResponse( int inSock, int status, const char *contentType, const uint8_t *inData, size_t inDataLen )
+{
+  OSStatus err = kParamErr;
+  char header[kHTTPResponseHeaderMaxLen];
+  socket_iovec_t iov[2];
+  
+  require( inData || inDataLen == 0, exit );
+  
+  // Header from the stack and the body where it already is, one send each
+  iov[0].base = header;
+  iov[0].len = HTTPResponseHeaderWrite( header, sizeof(header), status, inDataLen ? contentType : NULL, inDataLen, false );
+  require_action( iov[0].len, exit, err = kSizeErr );
+  iov[1].base = inData;
+  iov[1].len = inDataLen;
+  
+  err = SocketSendv( inSock, iov, 2 );
+  require_noerr( err, exit );
+  
+exit:
+  return err;
+}
+
+// The Create functions return a malloced copy for older callers, a null terminated header in front of the data
+static OSStatus HTTPCreateResponse( int status, const char *contentType, const uint8_t *inData, size_t inDataLen, bool inChunked, uint8_t **outMessage, size_t *outMessageSize )
 {
   OSStatus err = kNoMemoryErr;
-  *outMessage = malloc( 200 );
-  require( *outMessage, exit );
+  char header[kHTTPResponseHeaderMaxLen];
+  size_t headerLen;
+  
+  headerLen = HTTPResponseHeaderWrite( header, sizeof(header), status, contentType, inDataLen, inChunked );
+  require_action( headerLen, exit, err = kSizeErr );
   
-  sprintf( (char*)*outMessage,
-          "%s %s %s%s",
-          "HTTP/1.1", "200", "OK", kCRLFLineEnding );
-  *outMessageSize = strlen( (char*)*outMessage );
+  *outMessage = malloc( headerLen + ( inData ? inDataLen : 0 ) + 1 );
+  require( *outMessage, exit );
+  memcpy( *outMessage, header, headerLen );
+  (*outMessage)[headerLen] = 0;
+  *outMessageSize = headerLen;
   
+  if( inData ){
+    memcpy( *outMessage + headerLen, inData, inDataLen );
+    *outMessageSize += inDataLen;
+  }
   err = kNoErr;
   
 exit:
   return err;
 }
 
-
+OSStatus CreateSimpleHTTPOKMessage( uint8_t **outMessage, size_t *outMessageSize )
+{
+  return HTTPCreateResponse( kStatusOK, NULL, NULL, 0, false, outMessage, outMessageSize );
+}
 
 OSStatus CreateSimpleHTTPMessage( const char *contentType, uint8_t *inData, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize )
 {
-  uint8_t *endOfHTTPHeader;  
   OSStatus err = kParamErr;
   
-  
   require( contentType, exit );
   require( inData, exit );
   require( inDataLen, exit );
   
-  
-  err = kNoMemoryErr;
-  *outMessage = malloc( inDataLen + 200 );
-  require( *outMessage, exit );
-  
-  // Create HTTP Response
-  snprintf( (char*)*outMessage, 200, 
-           "%s %d %s%s%s %s%s%s %d%s",
-           "HTTP/1.1", 200, "OK", kCRLFNewLine, 
-           "Content-Type:", contentType, kCRLFNewLine,
-           "Content-Length:", (int)inDataLen, kCRLFLineEnding );
-  
-  // outMessageSize will be the length of the HTTP Header plus the data length
-  *outMessageSize = strlen( (char*)*outMessage ) + inDataLen;
-  
-  endOfHTTPHeader = *outMessage + strlen( (char*)*outMessage );
-  memcpy( endOfHTTPHeader, inData, inDataLen ); 
-  err = kNoErr;
+  err = HTTPCreateResponse( kStatusOK, contentType, inData, inDataLen, false, outMessage, outMessageSize );
   
 exit:
   return err;
@@ -808,78 +1055,56 @@ OSStatus CreateSimpleHTTPMessageNoCopy( const char *contentType, size_t inDataLe
   require( contentType, exit );
   require( inDataLen, exit );
   
-  err = kNoMemoryErr;
-  *outMessage = malloc( 200 );
-  require( *outMessage, exit );
-  
-  // Create HTTP Response
-  snprintf( (char*)*outMessage, 200, 
-           "%s %s %s%s%s %s%s%s %d%s",
-           "HTTP/1.1", "200", "OK", kCRLFNewLine, 
-           "Content-Type:", contentType, kCRLFNewLine,
-           "Content-Length:", (int)inDataLen, kCRLFLineEnding );
-  
-  // outMessageSize will be the length of the HTTP Header plus the data length
-  *outMessageSize = strlen( (char*)*outMessage );
-  err = kNoErr;
+  err = HTTPCreateResponse( kStatusOK, contentType, NULL, inDataLen, false, outMessage, outMessageSize );
   
 exit:
   return err;
 }
 
-char * getStatusString(int status)
+OSStatus CreateSimpleHTTPChunkedMessageNoCopy( const char *contentType, uint8_t **outMessage, size_t *outMessageSize )
 {
-  if(status == kStatusOK)
-    return "OK";
-  else if(status == kStatusNoConetnt)
-    return "No Content";
-  else if(status == kStatusPartialContent)
-    return "Multi0Status";
-  else if(status == kStatusBadRequest)
-    return "Bad Request";
-  else if(status == kStatusNotFound)
-    return "Not Found";
-  else if(status == kStatusMethodNotAllowed)
-    return "Not Allowed";
-  else if(status == kStatusForbidden) 
-    return "Forbidden";
-  else if(status == kStatusAuthenticationErr)
-    return "Authentication Error";
-  else if(status == kStatusInternalServerErr)
-    return "Internal Server Error";
-  else
-    return "OK";
+  OSStatus err = kParamErr;
+  
+  require( contentType, exit );
+  
+  // The body follows in chunks sent by SocketSendHTTPChunk
+  err = HTTPCreateResponse( kStatusOK, contentType, NULL, 0, true, outMessage, outMessageSize );
+  
+exit:
+  return err;
 }
 
-OSStatus CreateHTTPRespondMessageNoCopy( int status, const char *contentType, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize )
+OSStatus SocketSendHTTPChunk( int inSock, const uint8_t *inData, size_t inDataLen )
 {
-  OSStatus err = kParamErr;
-  char *statusString = getStatusString(status);
-    
-  err = kNoMemoryErr;
-  *outMessage = malloc( 200 );
-  require( *outMessage, exit );
+  OSStatus err = kNoErr;
+  char chunkHeader[12];
   
-  // Create HTTP Response
-  if(inDataLen)
-    snprintf( (char*)*outMessage, 200, 
-            "%s %d %s%s%s %s%s%s %d%s",
-            "HTTP/1.1", status, statusString, kCRLFNewLine, 
-            "Content-Type:", contentType, kCRLFNewLine,
-            "Content-Length:", (int)inDataLen, kCRLFLineEnding );
-  else
-    snprintf( (char*)*outMessage, 200, 
-        "%s %d %s%s",
-        "HTTP/1.1", status, statusString, kCRLFLineEnding);
+  // An empty chunk ends the body
+  snprintf( chunkHeader, sizeof(chunkHeader), "%x%s", (unsigned int)inDataLen, inDataLen ? kCRLFNewLine : kCRLFLineEnding );
+  err = SocketSend( inSock, (uint8_t *)chunkHeader, strlen( chunkHeader ) );
+  require_noerr( err, exit );
+  require_quiet( inDataLen, exit );
   
-  // outMessageSize will be the length of the HTTP Header plus the data length
-  *outMessageSize = strlen( (char*)*outMessage );
-  err = kNoErr;
+  err = SocketSend( inSock, inData, inDataLen );
+  require_noerr( err, exit );
+  err = SocketSend( inSock, (uint8_t *)kCRLFNewLine, strlen( kCRLFNewLine ) );
+  require_noerr( err, exit );
   
 exit:
   return err;
 }
 
+char * getStatusString(int status)
+{
+  const HTTPStatusLine_t *statusLine = HTTPFindStatusLine( status );
+  
+  return statusLine ? (char *)statusLine->reason : "OK";
+}
+
+OSStatus CreateHTTPRespondMessageNoCopy( int status, const char *contentType, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize )
+{
+  return HTTPCreateResponse( status, inDataLen ? contentType : NULL, NULL, inDataLen, false, outMessage, outMessageSize );
+}
 
 OSStatus CreateHTTPMessage( const char *methold, const char *url, const char *contentType, uint8_t *inData, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize )
 {
@@ -85,6 +85,18 @@
 
 #define OTA_Data_Length_per_read        1024
 
+#define kHTTPHeaderFieldMax             16
+
+// Header field found by HTTPHeaderParse, offsets are from the start of buf.
+typedef struct _HTTPHeaderField_t
+{
+    uint16_t            nameHash;
+    uint16_t            nameLen;
+    uint16_t            nameOffset;
+    uint16_t            valueOffset;
+    uint16_t            valueLen;
+} HTTPHeaderField_t;
+
 
 typedef struct _HTTPHeader_t
 {
@@ -111,6 +123,10 @@ typedef struct _HTTPHeader_t
 
     int                 firstErr;           //! First error that occurred or kNoErr.
 
+    HTTPHeaderField_t   fields[ kHTTPHeaderFieldMax ]; //! Header fields indexed by HTTPHeaderParse.
+    uint8_t             fieldCount;         //! Number of entries in fields.
+    bool                fieldsOverflow;     //! More fields than fit in fields, lookups fall back to a scan of buf.
+
     bool                dataEndedbyClose;
     bool                chunkedData;        //! true=Application should read the next chunked data.
     char *              chunkedDataBufferPtr;     //! Ptr for any extra data beyond the header, it is alloced when http header is received.
@@ -145,6 +161,9 @@ int SocketReadHTTPBody( int inSock, HTTPHeader_t *inHeader );
 
 int HTTPHeaderParse( HTTPHeader_t *ioHeader );
 
+/* Value of a header field indexed by HTTPHeaderParse, without scanning buf again */
+int HTTPHeaderGetField( HTTPHeader_t *inHeader, const char *inName, const char **outValuePtr, size_t *outValueLen );
+
 int HTTPHeaderMatchMethod( HTTPHeader_t *inHeader, const char *method );
 
 int HTTPHeaderMatchURL( HTTPHeader_t *inHeader, const char *url );
@@ -167,11 +186,26 @@ HTTPHeader_t * HTTPHeaderCreateWithCallback( onReceivedDataCallback , onClearCal
 
 void HTTPHeaderClear( HTTPHeader_t *inHeader );
 
+/* Big enough for any status with a content type of up to 40 characters */
+#define kHTTPResponseHeaderMaxLen       128
+
+/* Writes a response header into outBuf without allocating, returns its length, or 0
+   when outBuf is too small. Content-Type plus Content-Length (or Transfer-Encoding:
+   chunked when inChunked) are only written when contentType is not NULL */
+size_t HTTPResponseHeaderWrite( char *outBuf, size_t inBufLen, int status, const char *contentType, size_t inDataLen, bool inChunked );
+
+/* Sends a response built on the stack followed by inData, the body is not copied */
+OSStatus SocketSendHTTPResponse( int inSock, int status, const char *contentType, const uint8_t *inData, size_t inDataLen );
+
 int CreateSimpleHTTPOKMessage( uint8_t **outMessage, size_t *outMessageSize );
 
 OSStatus CreateSimpleHTTPMessage      ( const char *contentType, uint8_t *inData, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize );
 OSStatus CreateSimpleHTTPMessageNoCopy( const char *contentType, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize );
 
+/* Response header for a body sent with SocketSendHTTPChunk, end it with a zero length chunk */
+OSStatus CreateSimpleHTTPChunkedMessageNoCopy( const char *contentType, uint8_t **outMessage, size_t *outMessageSize );
+OSStatus SocketSendHTTPChunk( int inSock, const uint8_t *inData, size_t inDataLen );
+
 OSStatus CreateHTTPRespondMessageNoCopy( int status, const char *contentType, size_t inDataLen, uint8_t **outMessage, size_t *outMessageSize );
 
 
@@ -21,6 +21,34 @@
 */ 
 
 #include "MDNSUtils.h"
+#include "MicoPlatform.h"
+
+#define MDNS_PACKET_SIZE                   512
+#define MDNS_NAME_TABLE_SIZE               12
+#define MDNS_SERVICE_TTL                   1500
+#define MDNS_HOST_TTL                      300
+#define MDNS_MAX_SERVICES                  4
+
+/* RFC 6762 timing: shared answers are delayed 20-120ms so answers to several
+   queries can be merged, 400-500ms if the querier has more known answers to
+   send (TC bit). A record is multicast at most once per second. */
+#define MDNS_SHARED_DELAY_MIN              20
+#define MDNS_SHARED_DELAY_RANGE            100
+#define MDNS_TRUNCATED_DELAY_MIN           400
+#define MDNS_TRUNCATED_DELAY_RANGE         100
+#define MDNS_RECORD_RATE_LIMIT             1000
+
+/* Records this responder owns, a bit in an answer mask each */
+#define MDNS_RECORD_SERVICES               0   // _services._dns-sd._udp PTR -> service names
+#define MDNS_RECORD_HOST_A                 1   // host name A -> IP address
+#define MDNS_RECORD_PTR(b)                 (2 + 3*(b))
+#define MDNS_RECORD_SRV(b)                 (3 + 3*(b))
+#define MDNS_RECORD_TXT(b)                 (4 + 3*(b))
+#define MDNS_RECORD_NUMBER                 (2 + 3*MDNS_MAX_SERVICES)
+#define MDNS_RECORD_BIT(r)                 (1UL << (r))
+#define MDNS_SHARED_RECORDS(b)             (MDNS_RECORD_BIT(MDNS_RECORD_SERVICES) | MDNS_RECORD_BIT(MDNS_RECORD_PTR(b)))
+#define MDNS_SERVICE_RECORDS(b)            (MDNS_RECORD_BIT(MDNS_RECORD_PTR(b)) | MDNS_RECORD_BIT(MDNS_RECORD_SRV(b)) | \
+                                            MDNS_RECORD_BIT(MDNS_RECORD_TXT(b)) | MDNS_RECORD_BIT(MDNS_RECORD_HOST_A))
 
 static int mDNS_fd = -1;
 
@@ -32,8 +60,39 @@ typedef struct
   char* txt_att;
   uint16_t	port;
   char	instance_name_suffix[4]; // This variable should only be modified by the DNS-SD library
+  char* instance_full_name;      // instance_name.service_name
+  /* Prebuilt PTR, SRV, A and TXT response, TXT is the last record so it can be rewritten alone */
+  uint8_t* response;
+  uint16_t response_length;
+  uint16_t instance_offset;
+  uint16_t a_rdata_offset;
+  uint16_t txt_offset;
+  uint16_t ttl_offset[4];
 } dns_sd_service_record_t;
 
+typedef struct
+{
+  const char* suffix;
+  uint16_t    offset;
+} dns_name_table_entry_t;
+
+/* Message iterator with the names already written, used for name compression */
+typedef struct
+{
+  dns_message_iterator_t  iter;
+  dns_name_table_entry_t  names[MDNS_NAME_TABLE_SIZE];
+  uint8_t                 name_count;
+  uint16_t                ttl_offset;   // TTL position of the last record written
+} dns_message_builder_t;
+
+/* Answers collected from incoming queries and not sent yet */
+typedef struct
+{
+  uint32_t answers;
+  uint32_t additionals;
+  uint32_t deadline;
+} mdns_pending_response_t;
+
 static WiFi_Interface _interface;
 
 
@@ -66,21 +125,37 @@ static int _bonjour_announce = 0;
 static dns_sd_service_record_t*   available_services	= NULL;
 static uint8_t	available_service_count;
 
+/* Prebuilt service enumeration and host address responses */
+static uint8_t*   services_response = NULL;
+static uint16_t   services_response_length = 0;
+static uint8_t*   host_response = NULL;
+static uint16_t   host_response_length = 0;
+static uint16_t   host_a_rdata_offset = 0;
+static uint32_t   response_ip = 0;
+
+/* Responses that are not one of the prebuilt packets are assembled here */
+static uint8_t*   assembled_response = NULL;
+
+static mdns_pending_response_t  pending_response;
+static uint32_t   record_sent_time[MDNS_RECORD_NUMBER];
+
 static int dns_get_next_question( dns_message_iterator_t* iter, dns_question_t* q, dns_name_t* name );
+static int dns_get_next_record( dns_message_iterator_t* iter, dns_record_t* r, dns_name_t* name );
 static int dns_compare_name_to_string( dns_name_t* name, const char* string, const char* fun, const int line );
-static int dns_create_message( dns_message_iterator_t* message, uint16_t size );
 static void dns_write_header( dns_message_iterator_t* iter, uint16_t id, uint16_t flags, uint16_t question_count, uint16_t answer_count, uint16_t authorative_count );
-static void dns_write_record( dns_message_iterator_t* iter, const char* name, uint16_t record_class, uint16_t record_type, uint32_t ttl, uint8_t* rdata );
-static void mdns_send_message(int fd, dns_message_iterator_t* message );
-static void dns_free_message( dns_message_iterator_t* message );
-static void mdns_process_query(int fd, dns_name_t* name, dns_question_t* question, dns_message_iterator_t* source );
-static void dns_write_record( dns_message_iterator_t* iter, const char* name, uint16_t record_class, uint16_t record_type, uint32_t ttl, uint8_t* rdata );
+static void mdns_send_packet(int fd, uint8_t* packet, uint16_t length, uint16_t id );
+static void mdns_send_answers(int fd, uint32_t answers, uint32_t additionals, uint16_t id );
 static void dns_write_uint16( dns_message_iterator_t* iter, uint16_t data );
 static void dns_write_uint32( dns_message_iterator_t* iter, uint32_t data );
 static void dns_write_bytes( dns_message_iterator_t* iter, uint8_t* data, uint16_t length );
 static uint16_t dns_read_uint16( dns_message_iterator_t* iter );
+static uint32_t dns_read_uint32( dns_message_iterator_t* iter );
 static void dns_skip_name( dns_message_iterator_t* iter );
-static void dns_write_name( dns_message_iterator_t* iter, const char* src );
+static void dns_write_string( dns_message_iterator_t* iter, const char* src );
+static uint32_t mdns_check_ip( void );
+static void mdns_build_responses( uint32_t ip );
+static void mdns_build_service_txt( dns_sd_service_record_t* service );
+static void mdns_free_responses( void );
 
 static mico_mutex_t bonjour_mutex = NULL;
 static mico_thread_t mfi_bonjour_thread_handler;
@@ -104,112 +179,210 @@ static char *__strdup(char *src)
   return dst;
 }
 
-void process_dns_questions(int fd, dns_message_iterator_t* iter )
+static uint32_t mdns_random_delay( uint32_t min, uint32_t range )
+{
+  uint32_t random = 0;
+  MicoRandomNumberRead( &random, sizeof(random) );
+  return min + random % range;
+}
+
+/* Collect the records that answer the questions in a query */
+static void mdns_process_questions( dns_message_iterator_t* iter, uint32_t* answers, uint32_t* additionals )
 {
   dns_name_t name;
   dns_question_t question;
-  dns_message_iterator_t response;
-  IPStatusTypedef para;
-  int a = 0;
-  int question_processed;
-  uint32_t myip;
+  int a = 0, b = 0;
+  bool type_any;
   
-  micoWlanGetIPStatus(&para, _interface);
-  myip = htonl(inet_addr(para.ip));
-  if(myip == 0) {
-    _debug_out("UDP multicast test: IP error.\r\n");
-    return;
-  }
-  
-  memset( &response, 0, sizeof(dns_message_iterator_t) );
-  
-  for ( a = 0; a < htons(iter->header->question_count); ++a )
+  for ( a = 0; a < ntohs(iter->header->question_count); ++a )
   {
     if (iter->iter > iter->end)
       break;
     if(dns_get_next_question( iter, &question, &name )==0)
       break;
-    question_processed = 0;
-    switch ( question.question_type ){
-    case RR_TYPE_PTR:
-      if ( available_services != NULL ){
-        // Check if its a query for all available services  
-        if ( dns_compare_name_to_string( &name, MFi_SERVICE_QUERY_NAME, __FUNCTION__, __LINE__ ) ){
-          int b = 0;
-          _debug_out("UDP multicast test: Recv a SERVICE QUERY request.\r\n");
-          if(dns_create_message( &response, 512 )) {
-            dns_write_header(&response, iter->header->id, 0x8400, 0, available_service_count, 0 );          
-            for ( b = 0; b < available_service_count; ++b ){
-              dns_write_record( &response, MFi_SERVICE_QUERY_NAME, RR_CLASS_IN, RR_TYPE_PTR, 1500, (uint8_t*) available_services[b].service_name );
-            }
-            mdns_send_message(fd, &response );
-            dns_free_message( &response );
-            question_processed = 1;
-          }
-        }
-        // else check if its one of our records
-        else {
-          int b = 0;
-          for ( b = 0; b < available_service_count; ++b ){
-            //printf("UDP multicast test: Recv a SERVICE Detail request: %s.\r\n", name);
-            if ( dns_compare_name_to_string( &name, available_services[b].service_name, __FUNCTION__, __LINE__ )){
-              // Send the PTR, TXT, SRV and A records
-              if(dns_create_message( &response, 512 )){
-                dns_write_header( &response, iter->header->id, 0x8400, 0, 4, 0 );
-                //dns_write_record( &response, MFi_SERVICE_QUERY_NAME, RR_CLASS_IN, RR_TYPE_PTR, 1500, (u8*) available_services[b].service_name );
-                dns_write_record( &response, available_services[b].service_name, RR_CLASS_IN, RR_TYPE_PTR, 1500, (uint8_t*) available_services[b].instance_name );
-                dns_write_record( &response, available_services[b].instance_name, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_TXT, 1500, (uint8_t*) available_services[b].txt_att );
-                dns_write_record( &response, available_services[b].instance_name, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_SRV, 1500, (uint8_t*) &available_services[b]);
-                dns_write_record( &response, available_services[b].hostname, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_A, 1500, (uint8_t*) &myip);
-                mdns_send_message(fd, &response );
-                dns_free_message( &response );
-                question_processed = 1;
-              }
-              else{
-                _debug_out("UDP multicast test: Send error.\r\n");
-              }
-            }
-          }
+    type_any = ( question.question_type == RR_QTYPE_ANY );
+
+    if ( question.question_type == RR_TYPE_PTR || type_any ){
+      // Check if its a query for all available services  
+      if ( dns_compare_name_to_string( &name, MFi_SERVICE_QUERY_NAME, __FUNCTION__, __LINE__ ) ){
+        _debug_out("UDP multicast test: Recv a SERVICE QUERY request.\r\n");
+        *answers |= MDNS_RECORD_BIT(MDNS_RECORD_SERVICES);
+        continue;
+      }
+      // else check if its one of our records, SRV, TXT and A are sent along with the PTR
+      for ( b = 0; b < available_service_count; ++b ){
+        if ( dns_compare_name_to_string( &name, available_services[b].service_name, __FUNCTION__, __LINE__ )){
+          *answers |= MDNS_RECORD_BIT(MDNS_RECORD_PTR(b));
+          *additionals |= MDNS_SERVICE_RECORDS(b);
         }
       }
-      break;
     }
-    if (!question_processed ){
-      _debug_out("UDP multicast test: Recv a mDNS request.\r\n");
-      mdns_process_query(fd, &name, &question, iter);
+
+    if ( question.question_type == RR_TYPE_A || type_any ){
+      if ( dns_compare_name_to_string( &name, available_services->hostname, __FUNCTION__, __LINE__) ){
+        _debug_out("UDP multicast test: Recv RR_TYPE_A.\r\n");
+        *answers |= MDNS_RECORD_BIT(MDNS_RECORD_HOST_A);
+      }
+    }
+
+    for ( b = 0; b < available_service_count; ++b ){
+      if ( available_services[b].instance_full_name == NULL ||
+           !dns_compare_name_to_string( &name, available_services[b].instance_full_name, __FUNCTION__, __LINE__ ) )
+        continue;
+      if ( question.question_type == RR_TYPE_SRV || type_any ){
+        *answers |= MDNS_RECORD_BIT(MDNS_RECORD_SRV(b));
+        *additionals |= MDNS_RECORD_BIT(MDNS_RECORD_HOST_A);
+      }
+      if ( question.question_type == RR_TYPE_TXT || type_any )
+        *answers |= MDNS_RECORD_BIT(MDNS_RECORD_TXT(b));
     }
   }
 }
 
-static void mdns_process_query(int fd, dns_name_t* name, 
-                               dns_question_t* question, dns_message_iterator_t* source )
+/* A known SRV or TXT answer only matches when its rdata is the one this responder would send */
+static bool mdns_known_rdata_matches( dns_record_t* record, dns_sd_service_record_t* service )
 {
-  dns_message_iterator_t response;
-  IPStatusTypedef para;
-  uint32_t myip;
+  dns_name_t target;
+  uint8_t* rdata = record->rdata.iter;
+  uint16_t length;
   
-  micoWlanGetIPStatus(&para, _interface);
-  myip = htonl(inet_addr(para.ip));
+  if ( record->record_type == RR_TYPE_SRV ){
+    if ( record->rd_length < 7 || rdata[0] || rdata[1] || rdata[2] || rdata[3] ||
+         ( ( rdata[4] << 8 ) | rdata[5] ) != service->port )
+      return false;
+    target.start_of_name   = rdata + 6;
+    target.start_of_packet = (uint8_t*) record->rdata.header;
+    return dns_compare_name_to_string( &target, service->hostname, __FUNCTION__, __LINE__ );
+  }
   
-  memset( &response, 0, sizeof(dns_message_iterator_t) );
+  /* The TXT rdata is the last record of the prebuilt response, after name, type, class, TTL and length */
+  if ( service->response == NULL || service->response_length < service->txt_offset + 12 )
+    return false;
+  length = ( service->response[service->txt_offset + 10] << 8 ) | service->response[service->txt_offset + 11];
+  return record->rd_length == length && memcmp( rdata, service->response + service->txt_offset + 12, length ) == 0;
+}
+
+/* Known-answer suppression: a record the querier already holds with at least half of its TTL is not sent */
+static uint32_t mdns_process_known_answers( dns_message_iterator_t* iter )
+{
+  dns_name_t name;
+  dns_name_t rdata_name;
+  dns_record_t record;
+  uint32_t known = 0;
+  int a = 0, b = 0;
   
-  switch ( question->question_type )
+  for ( a = 0; a < ntohs(iter->header->answer_count); ++a )
   {
-  case RR_QTYPE_ANY:
-  case RR_TYPE_A:
-    if ( dns_compare_name_to_string( name, available_services->hostname, __FUNCTION__, __LINE__) ){				
-      _debug_out("UDP multicast test: Recv RR_TYPE_A.\r\n");
-      if(dns_create_message( &response, 256 )){
-        dns_write_header( &response, source->header->id, 0x8400, 0, 1, 0 );
-        dns_write_record( &response, available_services->hostname, RR_CLASS_IN | RR_CACHE_FLUSH, RR_TYPE_A, 300, (uint8_t *)&myip);
-        mdns_send_message(fd, &response );
-        dns_free_message( &response );
-        return;
+    if (iter->iter > iter->end)
+      break;
+    if ( dns_get_next_record( iter, &record, &name ) == 0 )
+      break;
+    rdata_name.start_of_name   = record.rdata.iter;
+    rdata_name.start_of_packet = (uint8_t*) iter->header;
+    if ( ( record.record_class & ~RR_CACHE_FLUSH ) != RR_CLASS_IN )
+      continue;
+    
+    switch ( record.record_type ){
+    case RR_TYPE_PTR:
+      if ( record.ttl < MDNS_SERVICE_TTL/2 )
+        break;
+      if ( dns_compare_name_to_string( &name, MFi_SERVICE_QUERY_NAME, __FUNCTION__, __LINE__ ) ){
+        if ( available_service_count == 1 && dns_compare_name_to_string( &rdata_name, available_services->service_name, __FUNCTION__, __LINE__ ) )
+          known |= MDNS_RECORD_BIT(MDNS_RECORD_SERVICES);
+        break;
+      }
+      for ( b = 0; b < available_service_count; ++b ){
+        if ( available_services[b].instance_full_name != NULL &&
+             dns_compare_name_to_string( &name, available_services[b].service_name, __FUNCTION__, __LINE__ ) &&
+             dns_compare_name_to_string( &rdata_name, available_services[b].instance_full_name, __FUNCTION__, __LINE__ ) )
+          known |= MDNS_RECORD_BIT(MDNS_RECORD_PTR(b));
       }
-    }    
-  default:
-    _debug_out("UDP multicast test: Request not support type: %d.---------------------\r\n", question->question_type);
+      break;
+    case RR_TYPE_A:
+      if ( record.ttl >= MDNS_HOST_TTL/2 && record.rd_length == 4 && memcmp( record.rdata.iter, &response_ip, 4 ) == 0 &&
+           dns_compare_name_to_string( &name, available_services->hostname, __FUNCTION__, __LINE__ ) )
+        known |= MDNS_RECORD_BIT(MDNS_RECORD_HOST_A);
+      break;
+    case RR_TYPE_SRV:
+    case RR_TYPE_TXT:
+      // A stale record, e.g. a TXT from before an update, does not suppress the current one
+      if ( record.ttl < MDNS_SERVICE_TTL/2 )
+        break;
+      for ( b = 0; b < available_service_count; ++b ){
+        if ( available_services[b].instance_full_name != NULL &&
+             dns_compare_name_to_string( &name, available_services[b].instance_full_name, __FUNCTION__, __LINE__ ) &&
+             mdns_known_rdata_matches( &record, &available_services[b] ) )
+          known |= MDNS_RECORD_BIT( record.record_type == RR_TYPE_SRV ? MDNS_RECORD_SRV(b) : MDNS_RECORD_TXT(b) );
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return known;
+}
+
+void process_dns_questions(int fd, dns_message_iterator_t* iter )
+{
+  uint32_t answers = 0, additionals = 0, known;
+  uint32_t delay, shared_mask = 0;
+  int b;
+  bool truncated;
+  
+  if(mdns_check_ip() == 0) {
+    _debug_out("UDP multicast test: IP error.\r\n");
+    return;
+  }
+  if ( available_services == NULL )
+    return;
+  
+  mdns_process_questions( iter, &answers, &additionals );
+  known = mdns_process_known_answers( iter );
+  truncated = ( ntohs(iter->header->flags) & DNS_MESSAGE_TRUNCATION ) ? true : false;
+
+  /* Known answers may come after the questions in following packets, drop them from what is waiting too */
+  pending_response.answers &= ~known;
+  answers &= ~known;
+  additionals &= ~(known | answers);
+  if ( answers == 0 && truncated == false )
+    return;
+
+  for ( b = 0; b < available_service_count; ++b )
+    shared_mask |= MDNS_SHARED_RECORDS(b);
+
+  /* Unique records are answered at once, shared records wait so answers can be merged */
+  if ( ( answers & shared_mask ) == 0 && truncated == false ){
+    mdns_send_answers( fd, answers, additionals, iter->header->id );
+    return;
   }
+
+  if ( truncated )
+    delay = mdns_random_delay( MDNS_TRUNCATED_DELAY_MIN, MDNS_TRUNCATED_DELAY_RANGE );
+  else
+    delay = mdns_random_delay( MDNS_SHARED_DELAY_MIN, MDNS_SHARED_DELAY_RANGE );
+
+  if ( pending_response.answers == 0 || (int32_t)( mico_get_time() + delay - pending_response.deadline ) > 0 )
+    pending_response.deadline = mico_get_time() + delay;
+  pending_response.answers |= answers;
+  pending_response.additionals |= additionals;
+}
+
+/* Send the merged answers once their random delay has elapsed, returns the time to wait before the next call */
+static uint32_t mdns_send_pending_answers( int fd )
+{
+  int32_t remaining;
+  
+  if ( pending_response.answers == 0 )
+    return 0xFFFFFFFF;
+  
+  remaining = (int32_t)( pending_response.deadline - mico_get_time() );
+  if ( remaining > 0 )
+    return remaining;
+  
+  mdns_send_answers( fd, pending_response.answers, pending_response.additionals & ~pending_response.answers, 0x0 );
+  pending_response.answers = 0;
+  pending_response.additionals = 0;
+  return 0xFFFFFFFF;
 }
 
 
@@ -219,7 +392,7 @@ static int dns_get_next_question( dns_message_iterator_t* iter, dns_question_t*
   name->start_of_name   = (uint8_t*) iter->iter;
   name->start_of_packet = (uint8_t*) iter->header;
   dns_skip_name( iter );
-  if (iter->iter > iter->end)
+  if (iter->iter + 4 > iter->end)
     return 0;
   
   // Read the type and class
@@ -228,6 +401,30 @@ static int dns_get_next_question( dns_message_iterator_t* iter, dns_question_t*
   return 1;
 }
 
+static int dns_get_next_record( dns_message_iterator_t* iter, dns_record_t* r, dns_name_t* name )
+{
+  // Set the name pointers and then skip it
+  name->start_of_name   = (uint8_t*) iter->iter;
+  name->start_of_packet = (uint8_t*) iter->header;
+  dns_skip_name( iter );
+  if (iter->iter + 10 > iter->end)
+    return 0;
+  
+  // Read the type, class, TTL and rdata length
+  r->record_type  = dns_read_uint16( iter );
+  r->record_class = dns_read_uint16( iter );
+  r->ttl          = dns_read_uint32( iter );
+  r->rd_length    = dns_read_uint16( iter );
+  if (iter->iter + r->rd_length > iter->end)
+    return 0;
+
+  r->rdata.header = iter->header;
+  r->rdata.iter   = iter->iter;
+  r->rdata.end    = iter->iter + r->rd_length;
+  iter->iter += r->rd_length;
+  return 1;
+}
+
 static int dns_compare_name_to_string( dns_name_t* name, const char* string, const char* fun, int line )
 {
   uint8_t section_length;
@@ -235,7 +432,6 @@ static int dns_compare_name_to_string( dns_name_t* name, const char* string, con
   int result   = 1;
   uint8_t* buffer 	  = name->start_of_name;
   _debug_out("UDP multicast test: CMP called by %s@%d.\r\n", fun, line );
-  char *temp;
   
   while ( !finished )
   {
@@ -251,11 +447,6 @@ static int dns_compare_name_to_string( dns_name_t* name, const char* string, con
     
     // Compare section
     section_length = *( buffer++ );
-    temp = malloc(section_length+1);
-    temp[section_length] = 0;
-    memcpy(temp, buffer, section_length );
-    _debug_out("UDP multicast test: Recv a name: %s.\r\n", temp);
-    free(temp);
     if ( strncmp( (char*) buffer, string, section_length ) )
     {
       result	 = 0;
@@ -279,37 +470,19 @@ static int dns_compare_name_to_string( dns_name_t* name, const char* string, con
   return result;
 }
 
-static int dns_create_message( dns_message_iterator_t* message, uint16_t size )
-{
-  message->header = (dns_message_header_t*) malloc( size );
-  if ( message->header == NULL )
-  {
-    return 0;
-  }
-  
-  message->iter = (uint8_t *) message->header + sizeof(dns_message_header_t);
-  return 1;
-}
-
-static void dns_free_message( dns_message_iterator_t* message )
-{
-  free(message->header);
-  message->header = NULL;
-}
-
 static void dns_write_string( dns_message_iterator_t* iter, const char* src )
 {
   uint8_t* segment_length_pointer;
   uint8_t  segment_length;
   
-  while ( *src != 0 && *src != 0xC0)
+  while ( *src != 0 )
   {
     /* Remember where we need to store the segment length and reset the counter*/
     segment_length_pointer = iter->iter++;
     segment_length = 0;
     
     /* Copy bytes until '.' or end of string*/
-    while ( *src != '.' && *src != 0 && *src != 0xC0)
+    while ( *src != '.' && *src != 0 )
     {
       if (*src == '/')
         src++; // skip '/'
@@ -329,13 +502,85 @@ static void dns_write_string( dns_message_iterator_t* iter, const char* src )
     
   }
   
-  if (*src == 0xC0) { // compress name
-    *iter->iter++ = *src++;
-    *iter->iter++ = *src++;
-  } else {
-    /* Add the ending null */
-    *iter->iter++ = 0;
+  /* Add the ending null */
+  *iter->iter++ = 0;
+}
+
+/* Write a domain name, the longest suffix already in the message is replaced by a pointer */
+static void dns_write_compressed_name( dns_message_builder_t* builder, const char* src )
+{
+  dns_message_iterator_t* iter = &builder->iter;
+  uint8_t* segment_length_pointer;
+  uint16_t offset;
+  int a;
+  
+  while ( *src != 0 )
+  {
+    for ( a = 0; a < builder->name_count; ++a )
+    {
+      if ( strcmp( builder->names[a].suffix, src ) == 0 )
+      {
+        dns_write_uint16( iter, 0xC000 | builder->names[a].offset );
+        return;
+      }
+    }
+    
+    offset = iter->iter - (uint8_t*) iter->header;
+    if ( builder->name_count < MDNS_NAME_TABLE_SIZE && offset < 0x3FFF )
+    {
+      builder->names[builder->name_count].suffix = src;
+      builder->names[builder->name_count].offset = offset;
+      builder->name_count++;
+    }
+    
+    segment_length_pointer = iter->iter++;
+    while ( *src != '.' && *src != 0 )
+    {
+      if (*src == '/')
+        src++; // skip '/'
+      *iter->iter++ = *src++;
+    }
+    *segment_length_pointer = iter->iter - segment_length_pointer - 1;
+    
+    if ( *src == '.' )
+    {
+      ++src;
+    }
   }
+  
+  *iter->iter++ = 0;
+}
+
+static void dns_init_builder( dns_message_builder_t* builder, uint8_t* buffer, uint16_t answer_count )
+{
+  memset( builder, 0, sizeof(dns_message_builder_t) );
+  builder->iter.header = (dns_message_header_t*) buffer;
+  builder->iter.iter   = buffer + sizeof(dns_message_header_t);
+  builder->iter.end    = buffer + MDNS_PACKET_SIZE;
+  dns_write_header( &builder->iter, 0x0, 0x8400, 0, answer_count, 0 );
+}
+
+/* Write type, class and TTL after the record name, returns where the rdata length goes */
+static uint8_t* dns_write_record_fields( dns_message_iterator_t* iter, uint16_t record_class, uint16_t record_type, uint32_t ttl, uint16_t* ttl_offset )
+{
+  uint8_t* rd_length;
+  
+  dns_write_uint16( iter, record_type );
+  dns_write_uint16( iter, record_class );
+  if ( ttl_offset )
+    *ttl_offset = iter->iter - (uint8_t*) iter->header;
+  dns_write_uint32( iter, ttl );
+  
+  rd_length = iter->iter;
+  iter->iter += 2;
+  return rd_length;
+}
+
+static void dns_end_record( dns_message_iterator_t* iter, uint8_t* rd_length )
+{
+  uint16_t length = iter->iter - rd_length - 2;
+  rd_length[0] = length >> 8;
+  rd_length[1] = length & 0xFF;
 }
 
 
@@ -350,65 +595,172 @@ static void dns_write_header( dns_message_iterator_t* iter, uint16_t id, uint16_
 }
 
 
-static void dns_write_record( dns_message_iterator_t* iter, const char* name, uint16_t record_class, uint16_t record_type, uint32_t ttl, uint8_t* rdata )
+static bool dns_builder_has_room( dns_message_builder_t* builder, uint32_t size )
+{
+  return ( builder->iter.end - builder->iter.iter ) >= (int32_t) size;
+}
+
+static uint16_t dns_builder_find_name( dns_message_builder_t* builder, const char* name )
+{
+  int a;
+  
+  for ( a = 0; a < builder->name_count; ++a )
+  {
+    if ( strcmp( builder->names[a].suffix, name ) == 0 )
+      return builder->names[a].offset;
+  }
+  return 0;
+}
+
+/* Write one of the records this responder owns, returns the number of resource records written */
+static int mdns_write_record( dns_message_builder_t* builder, int record )
 {
+  dns_message_iterator_t* iter = &builder->iter;
+  dns_sd_service_record_t* service;
   uint8_t* rd_length;
-  uint8_t* temp_ptr;
+  int b, count = 0;
   
-  /* Write the name, type, class, TTL*/
-  dns_write_name	( iter, name );
-  dns_write_uint16( iter, record_type );
-  dns_write_uint16( iter, record_class );
-  dns_write_uint32( iter, ttl );
+  if ( record == MDNS_RECORD_SERVICES ){
+    for ( b = 0; b < available_service_count; ++b ){
+      if ( !dns_builder_has_room( builder, strlen(MFi_SERVICE_QUERY_NAME) + strlen(available_services[b].service_name) + 16 ) )
+        break;
+      dns_write_compressed_name( builder, MFi_SERVICE_QUERY_NAME );
+      rd_length = dns_write_record_fields( iter, RR_CLASS_IN, RR_TYPE_PTR, MDNS_SERVICE_TTL, &builder->ttl_offset );
+      dns_write_compressed_name( builder, available_services[b].service_name );
+      dns_end_record( iter, rd_length );
+      count++;
+    }
+    return count;
+  }
   
-  /* Keep track of where we store the rdata length*/
-  rd_length	= iter->iter;
-  iter->iter += 2;
-  temp_ptr	= iter->iter;
+  if ( record == MDNS_RECORD_HOST_A ){
+    if ( !dns_builder_has_room( builder, strlen(available_services->hostname) + 18 ) )
+      return 0;
+    dns_write_compressed_name( builder, available_services->hostname );
+    rd_length = dns_write_record_fields( iter, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_A, MDNS_HOST_TTL, &builder->ttl_offset );
+    dns_write_bytes( iter, (uint8_t*) &response_ip, 4 );
+    dns_end_record( iter, rd_length );
+    return 1;
+  }
   
-  switch ( record_type )
-  {
-  case RR_TYPE_A:
-    dns_write_bytes( iter, rdata, 4 );
-    break;
-    
-  case RR_TYPE_PTR:
-  case RR_TYPE_TXT:
-    dns_write_name( iter, (const char*) rdata );
-    break;
-    
-  case RR_TYPE_SRV:
+  b = ( record - MDNS_RECORD_PTR(0) ) / 3;
+  if ( b >= available_service_count )
+    return 0;
+  service = &available_services[b];
+  if ( service->instance_full_name == NULL )
+    return 0;
+  
+  if ( record == MDNS_RECORD_PTR(b) ){
+    if ( !dns_builder_has_room( builder, strlen(service->service_name) + strlen(service->instance_full_name) + 16 ) )
+      return 0;
+    dns_write_compressed_name( builder, service->service_name );
+    rd_length = dns_write_record_fields( iter, RR_CLASS_IN, RR_TYPE_PTR, MDNS_SERVICE_TTL, &builder->ttl_offset );
+    dns_write_compressed_name( builder, service->instance_full_name );
+  }
+  else if ( record == MDNS_RECORD_SRV(b) ){
+    if ( !dns_builder_has_room( builder, strlen(service->instance_full_name) + strlen(service->hostname) + 22 ) )
+      return 0;
+    dns_write_compressed_name( builder, service->instance_full_name );
+    rd_length = dns_write_record_fields( iter, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_SRV, MDNS_SERVICE_TTL, &builder->ttl_offset );
     /* Set priority and weight to 0*/
     dns_write_uint16( iter, 0 );
     dns_write_uint16( iter, 0 );
-    
-    /* Write the port*/
-    dns_write_uint16( iter, ( (dns_sd_service_record_t*) rdata )->port );
-    
-    /* Write the hostname*/
-    dns_write_string( iter, ( (dns_sd_service_record_t*) rdata )->hostname );
-    break;
-  default:
-    break;
+    dns_write_uint16( iter, service->port );
+    dns_write_compressed_name( builder, service->hostname );
   }
-  // Write the rdata length
-  rd_length[0] = ( iter->iter - temp_ptr ) >> 8;
-  rd_length[1] = ( iter->iter - temp_ptr ) & 0xFF;
+  else {
+    if ( !dns_builder_has_room( builder, strlen(service->instance_full_name) + ( service->txt_att ? strlen(service->txt_att) : 0 ) + 16 ) )
+      return 0;
+    dns_write_compressed_name( builder, service->instance_full_name );
+    rd_length = dns_write_record_fields( iter, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_TXT, MDNS_SERVICE_TTL, &builder->ttl_offset );
+    if ( service->txt_att != NULL )
+      dns_write_string( iter, service->txt_att );
+    else
+      *iter->iter++ = 0;
+  }
+  dns_end_record( iter, rd_length );
+  return 1;
 }
 
-static void mdns_send_message(int fd, dns_message_iterator_t* message )
+/* Send a prebuilt response with the id of the query it answers */
+static void mdns_send_packet(int fd, uint8_t* packet, uint16_t length, uint16_t id )
 {
   struct sockaddr_t addr;
   if(_suspend_MFi_bonjour == true)
     return;
   
+  ((dns_message_header_t*) packet)->id = id;
   addr.s_ip = inet_addr("224.0.0.251");
   addr.s_port = 5353;
   _debug_out("UDP multicast test: Send a mDNS respond!+++++++++++++++++++++++++++\r\n");
-  sendto(fd, message->header, message->iter - (uint8_t*)message->header, 0, &addr, sizeof(addr));
-  addr.s_ip = inet_addr("255.255.255.255");
-  addr.s_port = 5353;
-  sendto(fd, message->header, message->iter - (uint8_t*)message->header, 0, &addr, sizeof(addr));
+  sendto(fd, packet, length, 0, &addr, sizeof(addr));
+}
+
+static void mdns_mark_records_sent( uint32_t records )
+{
+  uint32_t now = mico_get_time();
+  int r;
+  
+  for ( r = 0; r < MDNS_RECORD_NUMBER; ++r ){
+    if ( records & MDNS_RECORD_BIT(r) )
+      record_sent_time[r] = ( now == 0 ) ? 1 : now;
+  }
+}
+
+/* Multicast a set of records in one message, a prebuilt packet is used when one matches */
+static void mdns_send_answers(int fd, uint32_t answers, uint32_t additionals, uint16_t id )
+{
+  dns_message_builder_t builder;
+  uint32_t now = mico_get_time();
+  uint16_t answer_count = 0, additional_count = 0;
+  int r, b;
+  
+  /* Do not multicast a record again within a second */
+  for ( r = 0; r < MDNS_RECORD_NUMBER; ++r ){
+    if ( record_sent_time[r] != 0 && now - record_sent_time[r] < MDNS_RECORD_RATE_LIMIT ){
+      answers &= ~MDNS_RECORD_BIT(r);
+      additionals &= ~MDNS_RECORD_BIT(r);
+    }
+  }
+  additionals &= ~answers;
+  if ( answers == 0 )
+    return;
+  
+  if ( additionals == 0 && answers == MDNS_RECORD_BIT(MDNS_RECORD_SERVICES) && services_response ){
+    mdns_send_packet( fd, services_response, services_response_length, id );
+    goto exit;
+  }
+  if ( additionals == 0 && answers == MDNS_RECORD_BIT(MDNS_RECORD_HOST_A) && host_response ){
+    mdns_send_packet( fd, host_response, host_response_length, id );
+    goto exit;
+  }
+  for ( b = 0; b < available_service_count; ++b ){
+    if ( ( answers & MDNS_RECORD_BIT(MDNS_RECORD_PTR(b)) ) && ( answers | additionals ) == MDNS_SERVICE_RECORDS(b) && available_services[b].response ){
+      mdns_send_packet( fd, available_services[b].response, available_services[b].response_length, id );
+      goto exit;
+    }
+  }
+  
+  if ( assembled_response == NULL )
+    assembled_response = malloc( MDNS_PACKET_SIZE );
+  if ( assembled_response == NULL )
+    return;
+  
+  dns_init_builder( &builder, assembled_response, 0 );
+  for ( r = 0; r < MDNS_RECORD_NUMBER; ++r ){
+    if ( answers & MDNS_RECORD_BIT(r) )
+      answer_count += mdns_write_record( &builder, r );
+  }
+  for ( r = 0; r < MDNS_RECORD_NUMBER; ++r ){
+    if ( additionals & MDNS_RECORD_BIT(r) )
+      additional_count += mdns_write_record( &builder, r );
+  }
+  builder.iter.header->answer_count = htons( answer_count );
+  builder.iter.header->additional_record_count = htons( additional_count );
+  mdns_send_packet( fd, assembled_response, builder.iter.iter - assembled_response, id );
+  
+exit:
+  mdns_mark_records_sent( answers | additionals );
 }
 
 static void dns_write_uint16( dns_message_iterator_t* iter, uint16_t data )
@@ -446,6 +798,13 @@ static uint16_t dns_read_uint16( dns_message_iterator_t* iter )
   return temp;
 }
 
+static uint32_t dns_read_uint32( dns_message_iterator_t* iter )
+{
+  uint32_t temp = (uint32_t) dns_read_uint16( iter ) << 16;
+  temp += dns_read_uint16( iter );
+  return temp;
+}
+
 static void dns_skip_name( dns_message_iterator_t* iter )
 {
   while ( *iter->iter != 0 )
@@ -467,16 +826,138 @@ static void dns_skip_name( dns_message_iterator_t* iter )
   ++iter->iter;
 }
 
-static void dns_write_name( dns_message_iterator_t* iter, const char* src )
+/* Rewrite the TXT record at the end of a prebuilt service response */
+static void mdns_build_service_txt( dns_sd_service_record_t* service )
+{
+  dns_message_iterator_t iter;
+  uint8_t* rd_length;
+  
+  iter.header = (dns_message_header_t*) service->response;
+  iter.iter   = service->response + service->txt_offset;
+  iter.end    = service->response + MDNS_PACKET_SIZE;
+  
+  if ( service->txt_att != NULL && service->txt_offset + 12 + strlen( service->txt_att ) + 2 > MDNS_PACKET_SIZE )
+  {
+    mdns_utils_log("TXT record is too long: %d", (int)strlen( service->txt_att ));
+    iter.header->answer_count = htons(3);
+    service->response_length = service->txt_offset;
+    return;
+  }
+  
+  dns_write_uint16( &iter, 0xC000 | service->instance_offset );
+  rd_length = dns_write_record_fields( &iter, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_TXT, MDNS_SERVICE_TTL, &service->ttl_offset[3] );
+  if ( service->txt_att != NULL )
+    dns_write_string( &iter, service->txt_att );
+  else
+    *iter.iter++ = 0;
+  dns_end_record( &iter, rd_length );
+  
+  iter.header->answer_count = htons(4);
+  service->response_length = iter.iter - service->response;
+}
+
+static void mdns_build_service_response( int b )
+{
+  dns_sd_service_record_t* service = &available_services[b];
+  dns_message_builder_t builder;
+  
+  if ( service->instance_full_name == NULL )
+    return;
+  if ( service->response == NULL )
+    service->response = malloc( MDNS_PACKET_SIZE );
+  if ( service->response == NULL )
+    return;
+  
+  dns_init_builder( &builder, service->response, 4 );
+  
+  /* PTR: service name -> instance name */
+  mdns_write_record( &builder, MDNS_RECORD_PTR(b) );
+  service->ttl_offset[0] = builder.ttl_offset;
+  service->instance_offset = dns_builder_find_name( &builder, service->instance_full_name );
+  
+  /* SRV: instance name -> host name and port */
+  mdns_write_record( &builder, MDNS_RECORD_SRV(b) );
+  service->ttl_offset[1] = builder.ttl_offset;
+  
+  /* A: host name -> IP address */
+  mdns_write_record( &builder, MDNS_RECORD_HOST_A );
+  service->ttl_offset[2] = builder.ttl_offset;
+  service->a_rdata_offset = builder.iter.iter - service->response - 4;
+  
+  /* TXT: instance name -> TXT record */
+  service->txt_offset = builder.iter.iter - service->response;
+  mdns_build_service_txt( service );
+}
+
+static void mdns_build_responses( uint32_t ip )
 {
-  dns_write_string( iter, src );
+  dns_message_builder_t builder;
+  int b;
+  
+  response_ip = ip;
+  
+  if ( services_response == NULL )
+    services_response = malloc( MDNS_PACKET_SIZE );
+  if ( services_response != NULL ) {
+    dns_init_builder( &builder, services_response, 0 );
+    builder.iter.header->answer_count = htons( mdns_write_record( &builder, MDNS_RECORD_SERVICES ) );
+    services_response_length = builder.iter.iter - services_response;
+  }
+  
+  if ( host_response == NULL )
+    host_response = malloc( MDNS_PACKET_SIZE );
+  if ( host_response != NULL ) {
+    dns_init_builder( &builder, host_response, 0 );
+    builder.iter.header->answer_count = htons( mdns_write_record( &builder, MDNS_RECORD_HOST_A ) );
+    host_a_rdata_offset = builder.iter.iter - host_response - 4;
+    host_response_length = builder.iter.iter - host_response;
+  }
+  
+  for ( b = 0; b < available_service_count; ++b )
+    mdns_build_service_response( b );
+}
+
+static void mdns_free_responses( void )
+{
+  int b;
+  
+  for ( b = 0; b < available_service_count; ++b ){
+    if(available_services[b].response)  free(available_services[b].response);
+    available_services[b].response = NULL;
+  }
+  if(services_response)  free(services_response);
+  services_response = NULL;
+  if(host_response)  free(host_response);
+  host_response = NULL;
+}
+
+/* Patch the address in the prebuilt responses when the interface IP has changed */
+static uint32_t mdns_check_ip( void )
+{
+  IPStatusTypedef para;
+  uint32_t myip;
+  int b;
+  
+  micoWlanGetIPStatus(&para, _interface);
+  myip = htonl(inet_addr(para.ip));
+  
+  if ( myip != response_ip ) {
+    response_ip = myip;
+    if ( host_response )
+      memcpy( host_response + host_a_rdata_offset, &myip, 4 );
+    for ( b = 0; b < available_service_count; ++b ){
+      if ( available_services[b].response )
+        memcpy( available_services[b].response + available_services[b].a_rdata_offset, &myip, 4 );
+    }
+  }
+  return myip;
 }
 
 
 void bonjour_service_init(bonjour_init_t init)
 {
-  int len;
   IPStatusTypedef para;
+  int len;
 
   _interface = init.interface;
 
@@ -487,12 +968,16 @@ void bonjour_service_init(bonjour_init_t init)
   mico_rtos_lock_mutex( &bonjour_mutex );
   if(available_services) {
     //suspend_bonjour_service(ENABLE);
+    mdns_free_responses();
     if(available_services->service_name)  free(available_services->service_name);
     if(available_services->hostname)  free(available_services->hostname);
     if(available_services->instance_name)  free(available_services->instance_name);
+    if(available_services->instance_full_name)  free(available_services->instance_full_name);
     if(available_services->txt_att)  free(available_services->txt_att);
     free(available_services);
   }
+  memset( &pending_response, 0x0, sizeof(mdns_pending_response_t) );
+  memset( record_sent_time, 0x0, sizeof(record_sent_time) );
 
   micoWlanGetIPStatus(&para, _interface);
 
@@ -504,16 +989,20 @@ void bonjour_service_init(bonjour_init_t init)
 
   available_services->hostname = (char*)__strdup(init.host_name);
 
-  len = strlen(init.instance_name);
-  available_services->instance_name = (char*)malloc(len+3);//// 0xc00c+\0
-  memcpy(available_services->instance_name, init.instance_name, len);
-  available_services->instance_name[len]= 0xc0;
-  available_services->instance_name[len+1]= 0x0c;
-  available_services->instance_name[len+2]= 0;
+  available_services->instance_name = (char*)__strdup(init.instance_name);
+
+  if(available_services->instance_name && available_services->service_name){
+    len = strlen(available_services->instance_name) + strlen(available_services->service_name) + 2;
+    available_services->instance_full_name = (char*)malloc(len);
+    if(available_services->instance_full_name)
+      snprintf(available_services->instance_full_name, len, "%s.%s", available_services->instance_name, available_services->service_name);
+  }
   
   available_services->txt_att = (char*)__strdup(init.txt_record);
 
   available_services->port = init.service_port;
+
+  mdns_build_responses( htonl(inet_addr(para.ip)) );
   mico_rtos_unlock_mutex( &bonjour_mutex );
 }
 
@@ -524,6 +1013,8 @@ void bonjour_update_txt_record(char *txt_record)
   if(available_services->txt_att)  free(available_services->txt_att);
   
   available_services->txt_att = (char*)__strdup(txt_record);
+  if(available_services->response)
+    mdns_build_service_txt( available_services );
 
   _bonjour_announce = 1;
   mico_rtos_unlock_mutex( &bonjour_mutex );
@@ -535,6 +1026,9 @@ void mfi_mdns_handler(int fd, uint8_t* pkt, int pkt_len)
 
   dns_message_iterator_t iter;
   
+  if ( pkt_len < (int) sizeof(dns_message_header_t) )
+    return;
+  
   iter.header = (dns_message_header_t*) pkt;
   iter.iter   = (uint8_t*) iter.header + sizeof(dns_message_header_t);
   iter.end = pkt+pkt_len;
@@ -551,58 +1045,45 @@ void mfi_mdns_handler(int fd, uint8_t* pkt, int pkt_len)
 
 void mfi_bonjour_send(int fd)
 {
-  dns_message_iterator_t response;
-  uint32_t myip;
-  IPStatusTypedef para;
-  micoWlanGetIPStatus(&para, _interface);
-  myip = htonl(inet_addr(para.ip));
-  if(myip == 0) return;
   int b = 0;
-    
-  if(dns_create_message( &response, 512 )) {
-    dns_write_header(&response, 0x0, 0x8400, 0, available_service_count, 0 );          
-    for ( b = 0; b < available_service_count; ++b ){
-      dns_write_record( &response, MFi_SERVICE_QUERY_NAME, RR_CLASS_IN, RR_TYPE_PTR, 1500, (uint8_t*) available_services[b].service_name );
-    }
-    mdns_send_message(fd, &response );
-    dns_free_message( &response );
-  }
+  
+  if(mdns_check_ip() == 0) return;
+  
+  if(services_response)
+    mdns_send_packet(fd, services_response, services_response_length, 0x0 );
+  mdns_mark_records_sent( MDNS_RECORD_BIT(MDNS_RECORD_SERVICES) );
 
   for ( b = 0; b < available_service_count; ++b ){
-      if(dns_create_message( &response, 512 )){
-        dns_write_header( &response, 0x0, 0x8400, 0, 4, 0 );
-        dns_write_record( &response, available_services[b].service_name, RR_CLASS_IN, RR_TYPE_PTR, 1500, (uint8_t*) available_services[b].instance_name );
-        dns_write_record( &response, available_services[b].instance_name, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_TXT, 1500, (uint8_t*) available_services[b].txt_att );
-        dns_write_record( &response, available_services[b].instance_name, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_SRV, 1500, (uint8_t*) &available_services[b]);
-        dns_write_record( &response, available_services[b].hostname, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_A, 1500, (uint8_t*) &myip);
-        mdns_send_message(fd, &response );
-        dns_free_message( &response );
-      }
+    if(available_services[b].response)
+      mdns_send_packet(fd, available_services[b].response, available_services[b].response_length, 0x0 );
+    mdns_mark_records_sent( MDNS_SERVICE_RECORDS(b) );
   }
 }
 
 
 void mfi_bonjour_remove_record(int fd)
 {
-  dns_message_iterator_t response;
-  uint32_t myip;
-  IPStatusTypedef para;
-  micoWlanGetIPStatus(&para, _interface);
-  myip = htonl(inet_addr(para.ip));
-  int b = 0;
+  dns_sd_service_record_t* service;
+  uint8_t ttl[4][4];
+  int b = 0, r, records;
 
+  mdns_check_ip();
+
+  /* Send the prebuilt response with all TTLs set to zero (goodbye), then restore them */
   for ( b = 0; b < available_service_count; ++b ){
-    if(dns_create_message( &response, 512 )){
-      dns_write_header( &response, 0x0, 0x8400, 0, 4, 0 );
-      dns_write_record( &response, available_services[b].service_name, RR_CLASS_IN, RR_TYPE_PTR, 0, (uint8_t*) available_services[b].instance_name );
-      dns_write_record( &response, available_services[b].instance_name, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_TXT, 0, (uint8_t*) available_services[b].txt_att );
-      dns_write_record( &response, available_services[b].instance_name, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_SRV, 0, (uint8_t*) &available_services[b]);
-      dns_write_record( &response, available_services[b].hostname, RR_CACHE_FLUSH|RR_CLASS_IN, RR_TYPE_A, 0, (uint8_t*) &myip);
-      mdns_send_message(fd, &response );
-      mico_thread_msleep(20);
-      mdns_send_message(fd, &response );
-      dns_free_message( &response );
+    service = &available_services[b];
+    if(service->response == NULL)
+      continue;
+    records = ntohs(((dns_message_header_t*) service->response)->answer_count);
+    for ( r = 0; r < records; ++r ){
+      memcpy( ttl[r], service->response + service->ttl_offset[r], 4 );
+      memset( service->response + service->ttl_offset[r], 0x0, 4 );
     }
+    mdns_send_packet(fd, service->response, service->response_length, 0x0 );
+    mico_thread_msleep(20);
+    mdns_send_packet(fd, service->response, service->response_length, 0x0 );
+    for ( r = 0; r < records; ++r )
+      memcpy( service->response + service->ttl_offset[r], ttl[r], 4 );
   }
 }
 
@@ -634,14 +1115,12 @@ void _bonjour_thread(void *arg)
   struct sockaddr_t addr;
   socklen_t addrLen;
   uint32_t opt;
+  uint32_t wait_ms = 0xFFFFFFFF;
   (void)arg;
   OSStatus err;
   
   buf = malloc(1500);
   
-  t.tv_sec = 1;
-  t.tv_usec = 0;
-  
   mDNS_fd = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
   require_action(IsValidSocket( mDNS_fd ), exit, err = kNoResourcesErr );
   opt = 0xE00000FB; //"224.0.0.251"
@@ -667,6 +1146,15 @@ void _bonjour_thread(void *arg)
       mico_rtos_unlock_mutex( &bonjour_mutex );
     }
 
+    /*Wake up in time for delayed answers */
+    if ( wait_ms < 1000 ) {
+      t.tv_sec = 0;
+      t.tv_usec = wait_ms * 1000;
+    } else {
+      t.tv_sec = 1;
+      t.tv_usec = 0;
+    }
+
     /*Check status on erery sockets on bonjour query */
     FD_ZERO(&readfds);
     FD_SET(mDNS_fd, &readfds);
@@ -679,6 +1167,10 @@ void _bonjour_thread(void *arg)
       mfi_mdns_handler(mDNS_fd, (uint8_t *)buf, con);
       mico_rtos_unlock_mutex( &bonjour_mutex );
     }
+
+    mico_rtos_lock_mutex( &bonjour_mutex );
+    wait_ms = mdns_send_pending_answers(mDNS_fd);
+    mico_rtos_unlock_mutex( &bonjour_mutex );
   }
 exit:
   mdns_utils_log("Exit: mDNS thread exit with err = %d", err);
@@ -687,4 +1179,3 @@ exit:
 }
 
 
-
@@ -223,6 +223,207 @@ static void _SHA1_Compress( SHA_CTX_compat *ctx, const uint8_t *inPtr )
     ctx->state[ 4 ] = ctx->state[ 4 ] + e;
 }
 
+//===========================================================================================================================
+//  SHA-256 internals
+//===========================================================================================================================
+
+#define SHA256_BLOCK_SIZE   64
+
+static const uint32_t       kSHA256K[ 64 ] = 
+{
+    UINT32_C( 0x428a2f98 ), UINT32_C( 0x71374491 ), UINT32_C( 0xb5c0fbcf ), UINT32_C( 0xe9b5dba5 ),
+    UINT32_C( 0x3956c25b ), UINT32_C( 0x59f111f1 ), UINT32_C( 0x923f82a4 ), UINT32_C( 0xab1c5ed5 ),
+    UINT32_C( 0xd807aa98 ), UINT32_C( 0x12835b01 ), UINT32_C( 0x243185be ), UINT32_C( 0x550c7dc3 ),
+    UINT32_C( 0x72be5d74 ), UINT32_C( 0x80deb1fe ), UINT32_C( 0x9bdc06a7 ), UINT32_C( 0xc19bf174 ),
+    UINT32_C( 0xe49b69c1 ), UINT32_C( 0xefbe4786 ), UINT32_C( 0x0fc19dc6 ), UINT32_C( 0x240ca1cc ),
+    UINT32_C( 0x2de92c6f ), UINT32_C( 0x4a7484aa ), UINT32_C( 0x5cb0a9dc ), UINT32_C( 0x76f988da ),
+    UINT32_C( 0x983e5152 ), UINT32_C( 0xa831c66d ), UINT32_C( 0xb00327c8 ), UINT32_C( 0xbf597fc7 ),
+    UINT32_C( 0xc6e00bf3 ), UINT32_C( 0xd5a79147 ), UINT32_C( 0x06ca6351 ), UINT32_C( 0x14292967 ),
+    UINT32_C( 0x27b70a85 ), UINT32_C( 0x2e1b2138 ), UINT32_C( 0x4d2c6dfc ), UINT32_C( 0x53380d13 ),
+    UINT32_C( 0x650a7354 ), UINT32_C( 0x766a0abb ), UINT32_C( 0x81c2c92e ), UINT32_C( 0x92722c85 ),
+    UINT32_C( 0xa2bfe8a1 ), UINT32_C( 0xa81a664b ), UINT32_C( 0xc24b8b70 ), UINT32_C( 0xc76c51a3 ),
+    UINT32_C( 0xd192e819 ), UINT32_C( 0xd6990624 ), UINT32_C( 0xf40e3585 ), UINT32_C( 0x106aa070 ),
+    UINT32_C( 0x19a4c116 ), UINT32_C( 0x1e376c08 ), UINT32_C( 0x2748774c ), UINT32_C( 0x34b0bcb5 ),
+    UINT32_C( 0x391c0cb3 ), UINT32_C( 0x4ed8aa4a ), UINT32_C( 0x5b9cca4f ), UINT32_C( 0x682e6ff3 ),
+    UINT32_C( 0x748f82ee ), UINT32_C( 0x78a5636f ), UINT32_C( 0x84c87814 ), UINT32_C( 0x8cc70208 ),
+    UINT32_C( 0x90befffa ), UINT32_C( 0xa4506ceb ), UINT32_C( 0xbef9a3f7 ), UINT32_C( 0xc67178f2 )
+};
+
+static void _SHA256_Compress( SHA256_CTX_compat *ctx, const uint8_t *inPtr );
+
+//===========================================================================================================================
+//  SHA256_Init_compat
+//===========================================================================================================================
+
+int SHA256_Init_compat( SHA256_CTX_compat *ctx )
+{
+    ctx->length = 0;
+    ctx->state[ 0 ] = UINT32_C( 0x6a09e667 );
+    ctx->state[ 1 ] = UINT32_C( 0xbb67ae85 );
+    ctx->state[ 2 ] = UINT32_C( 0x3c6ef372 );
+    ctx->state[ 3 ] = UINT32_C( 0xa54ff53a );
+    ctx->state[ 4 ] = UINT32_C( 0x510e527f );
+    ctx->state[ 5 ] = UINT32_C( 0x9b05688c );
+    ctx->state[ 6 ] = UINT32_C( 0x1f83d9ab );
+    ctx->state[ 7 ] = UINT32_C( 0x5be0cd19 );
+    ctx->curlen = 0;
+    return( 0 );
+}
+
+//===========================================================================================================================
+//  SHA256_Update_compat
+//===========================================================================================================================
+
+int SHA256_Update_compat( SHA256_CTX_compat *ctx, const void *inData, size_t inLen )
+{
+    const uint8_t *     src = (const uint8_t *) inData;
+    size_t              n;
+    
+    while( inLen > 0 )
+    {
+        if( ( ctx->curlen == 0 ) && ( inLen >= SHA256_BLOCK_SIZE ) )
+        {
+            _SHA256_Compress( ctx, src );
+            ctx->length += ( SHA256_BLOCK_SIZE * 8 );
+            src         += SHA256_BLOCK_SIZE;
+            inLen       -= SHA256_BLOCK_SIZE;
+        }
+        else
+        {
+            n = Min( inLen, SHA256_BLOCK_SIZE - ctx->curlen );
+            memcpy( ctx->buf + ctx->curlen, src, n );
+            ctx->curlen += n;
+            src         += n;
+            inLen       -= n;
+            if( ctx->curlen == SHA256_BLOCK_SIZE )
+            {
+                _SHA256_Compress( ctx, ctx->buf );
+                ctx->length += ( SHA256_BLOCK_SIZE * 8 );
+                ctx->curlen = 0;
+            }
+        }
+    }
+    return( 0 );
+}
+
+//===========================================================================================================================
+//  SHA256_Final_compat
+//===========================================================================================================================
+
+int SHA256_Final_compat( unsigned char *outDigest, SHA256_CTX_compat *ctx )
+{
+    int     i;
+    
+    ctx->length += ctx->curlen * 8;
+    ctx->buf[ ctx->curlen++ ] = 0x80;
+    
+    // If length > 56 bytes, append zeros then compress. Then fall back to padding zeros and length encoding like normal.
+    if( ctx->curlen > 56 )
+    {
+        while( ctx->curlen < 64 ) ctx->buf[ ctx->curlen++ ] = 0;
+        _SHA256_Compress( ctx, ctx->buf );
+        ctx->curlen = 0;
+    }
+    
+    // Pad up to 56 bytes of zeros.
+    while( ctx->curlen < 56 ) ctx->buf[ ctx->curlen++ ] = 0;
+    
+    // Store length.
+    WriteBig64( ctx->buf + 56, ctx->length );
+    _SHA256_Compress( ctx, ctx->buf );
+    
+    // Copy output.
+    for( i = 0; i < 8; ++i )
+    {
+        WriteBig32( outDigest + ( 4 * i ), ctx->state[ i ] );
+    }
+    memset( ctx, 0, sizeof( *ctx ) ); // Zero sensitive info.
+    return( 0 );
+}
+
+//===========================================================================================================================
+//  SHA256_compat
+//===========================================================================================================================
+
+unsigned char * SHA256_compat( const void *inData, size_t inLen, unsigned char *outDigest )
+{
+    SHA256_CTX_compat       ctx;
+    
+    SHA256_Init_compat( &ctx );
+    SHA256_Update_compat( &ctx, inData, inLen );
+    SHA256_Final_compat( outDigest, &ctx );
+    return( outDigest );
+}
+
+//===========================================================================================================================
+//  _SHA256_Compress
+//
+//  Unrolled 8 rounds at a time with the working variables renamed instead of shifted, so a..h can stay in registers.
+//  Expanding the whole schedule up front measured faster than a 16 word ring on the host.
+//===========================================================================================================================
+
+#define SHA256_Ch( x, y, z )        ( z ^ ( x & ( y ^ z ) ) )
+#define SHA256_Maj( x, y, z )       ( ( ( x | y ) & z ) | ( x & y ) )
+#define SHA256_Sigma0( x )          ( ROTR32( x,  2 ) ^ ROTR32( x, 13 ) ^ ROTR32( x, 22 ) )
+#define SHA256_Sigma1( x )          ( ROTR32( x,  6 ) ^ ROTR32( x, 11 ) ^ ROTR32( x, 25 ) )
+#define SHA256_Gamma0( x )          ( ROTR32( x,  7 ) ^ ROTR32( x, 18 ) ^ ( ( x ) >>  3 ) )
+#define SHA256_Gamma1( x )          ( ROTR32( x, 17 ) ^ ROTR32( x, 19 ) ^ ( ( x ) >> 10 ) )
+#define SHA256_RND( a, b, c, d, e, f, g, h, i ) \
+    t0 = h + SHA256_Sigma1( e ) + SHA256_Ch( e, f, g ) + kSHA256K[ i ] + W[ i ]; \
+    t1 = SHA256_Sigma0( a ) + SHA256_Maj( a, b, c ); \
+    d += t0; \
+    h  = t0 + t1;
+
+static void _SHA256_Compress( SHA256_CTX_compat *ctx, const uint8_t *inPtr )
+{
+    uint32_t        a, b, c, d, e, f, g, h, W[ 64 ], t0, t1;
+    int             i;
+    
+    // Copy the 512-bit block into W[0..15]
+    for( i = 0; i < 16; ++i )
+    {
+        W[ i ] = ReadBig32( inPtr );
+        inPtr += 4;
+    }
+    
+    // Fill W[16..63]
+    for( i = 16; i < 64; ++i )
+    {
+        W[ i ] = SHA256_Gamma1( W[ i-2 ] ) + W[ i-7 ] + SHA256_Gamma0( W[ i-15 ] ) + W[ i-16 ];
+    }
+    
+    a = ctx->state[ 0 ];
+    b = ctx->state[ 1 ];
+    c = ctx->state[ 2 ];
+    d = ctx->state[ 3 ];
+    e = ctx->state[ 4 ];
+    f = ctx->state[ 5 ];
+    g = ctx->state[ 6 ];
+    h = ctx->state[ 7 ];
+    
+    // Compress
+    for( i = 0; i < 64; i += 8 )
+    {
+        SHA256_RND( a, b, c, d, e, f, g, h, i+0 )
+        SHA256_RND( h, a, b, c, d, e, f, g, i+1 )
+        SHA256_RND( g, h, a, b, c, d, e, f, i+2 )
+        SHA256_RND( f, g, h, a, b, c, d, e, i+3 )
+        SHA256_RND( e, f, g, h, a, b, c, d, i+4 )
+        SHA256_RND( d, e, f, g, h, a, b, c, i+5 )
+        SHA256_RND( c, d, e, f, g, h, a, b, i+6 )
+        SHA256_RND( b, c, d, e, f, g, h, a, i+7 )
+    }
+    
+    ctx->state[ 0 ] += a;
+    ctx->state[ 1 ] += b;
+    ctx->state[ 2 ] += c;
+    ctx->state[ 3 ] += d;
+    ctx->state[ 4 ] += e;
+    ctx->state[ 5 ] += f;
+    ctx->state[ 6 ] += g;
+    ctx->state[ 7 ] += h;
+}
+
 //===========================================================================================================================
 //  SHA-512 internals
 //===========================================================================================================================
@@ -684,4 +885,102 @@ static void _SHA3_Block( SHA3_CTX_compat *ctx, const uint8_t *in )
     ctx->state[24] = s24;
 }
 
+//===========================================================================================================================
+//  Hash_Init
+//===========================================================================================================================
+
+OSStatus Hash_Init( HashContext *inContext, HashType inType )
+{
+    OSStatus        err = kNoErr;
+    
+    switch( inType )
+    {
+        case kHashType_MD5:     InitMd5( &inContext->u.md5 );                break;
+        case kHashType_SHA1:    SHA1_Init_compat( &inContext->u.sha1 );      break;
+        case kHashType_SHA256:  SHA256_Init_compat( &inContext->u.sha256 );  break;
+        case kHashType_SHA512:  SHA512_Init_compat( &inContext->u.sha512 );  break;
+        case kHashType_SHA3:    SHA3_Init_compat( &inContext->u.sha3 );      break;
+        default: err = kParamErr; goto exit;
+    }
+    inContext->type = inType;
+    
+exit:
+    return( err );
+}
+
+//===========================================================================================================================
+//  Hash_Update
+//===========================================================================================================================
+
+OSStatus Hash_Update( HashContext *inContext, const void *inData, size_t inLen )
+{
+    OSStatus        err = kNoErr;
+    
+    switch( inContext->type )
+    {
+        case kHashType_MD5:     Md5Update( &inContext->u.md5, (unsigned char *) inData, (int) inLen );  break;
+        case kHashType_SHA1:    SHA1_Update_compat( &inContext->u.sha1, inData, inLen );               break;
+        case kHashType_SHA256:  SHA256_Update_compat( &inContext->u.sha256, inData, inLen );           break;
+        case kHashType_SHA512:  SHA512_Update_compat( &inContext->u.sha512, inData, inLen );           break;
+        case kHashType_SHA3:    SHA3_Update_compat( &inContext->u.sha3, inData, inLen );               break;
+        default: err = kParamErr; break;
+    }
+    return( err );
+}
+
+//===========================================================================================================================
+//  Hash_Final
+//===========================================================================================================================
+
+OSStatus Hash_Final( HashContext *inContext, uint8_t *outDigest )
+{
+    OSStatus        err = kNoErr;
+    
+    switch( inContext->type )
+    {
+        case kHashType_MD5:     Md5Final( &inContext->u.md5, outDigest );                break;
+        case kHashType_SHA1:    SHA1_Final_compat( outDigest, &inContext->u.sha1 );     break;
+        case kHashType_SHA256:  SHA256_Final_compat( outDigest, &inContext->u.sha256 ); break;
+        case kHashType_SHA512:  SHA512_Final_compat( outDigest, &inContext->u.sha512 ); break;
+        case kHashType_SHA3:    SHA3_Final_compat( outDigest, &inContext->u.sha3 );     break;
+        default: err = kParamErr; break;
+    }
+    memset( inContext, 0, sizeof( *inContext ) ); // Zero sensitive info.
+    return( err );
+}
+
+//===========================================================================================================================
+//  Hash_DigestLength
+//===========================================================================================================================
 
+size_t Hash_DigestLength( HashType inType )
+{
+    switch( inType )
+    {
+        case kHashType_MD5:     return( 16 );
+        case kHashType_SHA1:    return( 20 );
+        case kHashType_SHA256:  return( 32 );
+        case kHashType_SHA512:  return( 64 );
+        case kHashType_SHA3:    return( SHA3_DIGEST_LENGTH );
+        default: break;
+    }
+    return( 0 );
+}
+
+//===========================================================================================================================
+//  Hash_Data
+//===========================================================================================================================
+
+OSStatus Hash_Data( HashType inType, const void *inData, size_t inLen, uint8_t *outDigest )
+{
+    OSStatus        err;
+    HashContext     ctx;
+    
+    err = Hash_Init( &ctx, inType );
+    require_noerr( err, exit );
+    Hash_Update( &ctx, inData, inLen );
+    err = Hash_Final( &ctx, outDigest );
+    
+exit:
+    return( err );
+}
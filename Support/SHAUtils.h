@@ -24,6 +24,7 @@
 #define __SHAUtils_h_
 
 #include "Common.h"
+#include "MicoAlgorithm.h"
 
 
 //===========================================================================================================================
@@ -44,6 +45,24 @@ int SHA1_Update_compat( SHA_CTX_compat *ctx, const void *inData, size_t inLen );
 int SHA1_Final_compat( unsigned char *outDigest, SHA_CTX_compat *ctx );
 unsigned char * SHA1_compat( const void *inData, size_t inLen, unsigned char *outDigest );
 
+//===========================================================================================================================
+//  SHA-256
+//===========================================================================================================================
+
+typedef struct
+{
+    uint64_t        length;
+    uint32_t        state[ 8 ];
+    uint32_t        curlen;
+    uint8_t         buf[ 64 ];
+    
+}   SHA256_CTX_compat;
+
+int SHA256_Init_compat( SHA256_CTX_compat *ctx );
+int SHA256_Update_compat( SHA256_CTX_compat *ctx, const void *inData, size_t inLen );
+int SHA256_Final_compat( unsigned char *outDigest, SHA256_CTX_compat *ctx );
+unsigned char * SHA256_compat( const void *inData, size_t inLen, unsigned char *outDigest );
+
 //===========================================================================================================================
 //  SHA-512
 //===========================================================================================================================
@@ -85,6 +104,46 @@ int SHA3_Update_compat( SHA3_CTX_compat *ctx, const void *inData, size_t inLen )
 int SHA3_Final_compat( unsigned char *outDigest, SHA3_CTX_compat *ctx );
 uint8_t *   SHA3_compat( const void *inData, size_t inLen, uint8_t outDigest[ 64 ] );
 
+//===========================================================================================================================
+//  Hash
+//
+//  One streaming API over the digests above and the MD5 of the MICO library, so callers don't have to pick an
+//  implementation themselves. Each type maps to the fastest implementation in the tree for it.
+//===========================================================================================================================
+
+typedef enum
+{
+    kHashType_MD5       = 0,
+    kHashType_SHA1      = 1,
+    kHashType_SHA256    = 2,
+    kHashType_SHA512    = 3,
+    kHashType_SHA3      = 4
+    
+}   HashType;
+
+#define kHashMaxDigestLength        64
+
+typedef struct
+{
+    HashType                type;
+    union
+    {
+        md5_context         md5;
+        SHA_CTX_compat      sha1;
+        SHA256_CTX_compat   sha256;
+        SHA512_CTX_compat   sha512;
+        SHA3_CTX_compat     sha3;
+        
+    }   u;
+    
+}   HashContext;
+
+OSStatus    Hash_Init( HashContext *inContext, HashType inType );
+OSStatus    Hash_Update( HashContext *inContext, const void *inData, size_t inLen );
+OSStatus    Hash_Final( HashContext *inContext, uint8_t *outDigest );
+size_t      Hash_DigestLength( HashType inType );
+OSStatus    Hash_Data( HashType inType, const void *inData, size_t inLen, uint8_t *outDigest );
+
 #endif // __SHAUtils_h_
 
 
@@ -72,6 +72,24 @@ exit:
     return err;
 }
 
+OSStatus SocketSendv( int fd, const socket_iovec_t *iov, int iovcnt )
+{
+    OSStatus err = kParamErr;
+
+    require( iov, exit );
+    err = kNoErr;
+
+    for( ; iovcnt > 0; iov++, iovcnt-- )
+    {
+        if( iov->len == 0 ) continue;
+        err = SocketSend( fd, (const uint8_t *)iov->base, iov->len );
+        require_noerr( err, exit );
+    }
+
+exit:
+    return err;
+}
+
 void SocketClose(int* fd)
 {
     int tempFd = *fd;
@@ -24,8 +24,16 @@
 
 #include "Common.h"
 
+typedef struct _socket_iovec_t {
+  const void    *base;
+  size_t        len;
+} socket_iovec_t;
+
 OSStatus SocketSend( int fd, const uint8_t *inBuf, size_t inBufLen );
 
+/* Send several buffers in order as one stream, empty ones are skipped */
+OSStatus SocketSendv( int fd, const socket_iovec_t *iov, int iovcnt );
+
 void SocketClose(int* fd);
 
 void SocketCloseForOSEvent(int* fd);
@@ -184,7 +184,9 @@ typedef int32_t         OSStatus;
 
 
 //MXCHIP added for module
+#ifndef EWOULDBLOCK
 #define EWOULDBLOCK 35      /* Operation would block */
+#endif
 
 
 // ==== C TYPE SAFE MACROS ====
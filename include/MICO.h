@@ -45,7 +45,7 @@
 
 #include "Debug.h"
 #include "Common.h" 
-#include "MicoRTOS.h"
+#include "MICORTOS.h"
 #include "MicoWlan.h"
 #include "MicoSocket.h"
 #include "MicoAlgorithm.h"
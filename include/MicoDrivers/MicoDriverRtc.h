@@ -105,6 +105,19 @@ OSStatus MicoRtcGetTime(mico_rtc_time_t* time);
  */
 OSStatus MicoRtcSetTime(mico_rtc_time_t* time);
 
+/**
+ * This function will trim the MCU RTC for the error of its oscillator, the NTP
+ * client calls it with the drift it measures against the network time
+ *
+ * @param drift_ppb   : how much faster than real time the RTC runs, in parts per
+ *                      billion, negative when it runs slower. 0 removes the trim.
+ *
+ * @return    kNoErr          : on success.
+ * @return    kUnsupportedErr : if the RTC can not be trimmed
+ * @return    kGeneralErr     : if an error occurred with any step
+ */
+OSStatus MicoRtcSetDrift(int32_t drift_ppb);
+
 /** @} */
 /** @} */
 
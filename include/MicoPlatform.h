@@ -34,7 +34,7 @@
 
 #pragma once
 
-#include "common.h"
+#include "Common.h"
 
 #include "MicoDefaults.h"
 #include "platform.h" /* This file is unique for each platform */
@@ -57,17 +57,17 @@ typedef platform_spi_slave_data_buffer_t        mico_spi_slave_data_buffer_t;
 
 
 
-#include "MicoDrivers/MICODriverI2c.h"
-#include "MicoDrivers/MICODriverSpi.h"
-#include "MicoDrivers/MICODriverUART.h"
-#include "MicoDrivers/MICODriverGpio.h"
-#include "MicoDrivers/MICODriverPwm.h"
-#include "MicoDrivers/MICODriverRtc.h"
-#include "MicoDrivers/MICODriverWdg.h"
-#include "MicoDrivers/MICODriverAdc.h"
-#include "MicoDrivers/MICODriverRng.h"
-#include "MicoDrivers/MICODriverFlash.h"
-#include "MicoDrivers/MICODriverMFiAuth.h"
+#include "MicoDrivers/MicoDriverI2c.h"
+#include "MicoDrivers/MicoDriverSpi.h"
+#include "MicoDrivers/MicoDriverUart.h"
+#include "MicoDrivers/MicoDriverGpio.h"
+#include "MicoDrivers/MicoDriverPwm.h"
+#include "MicoDrivers/MicoDriverRtc.h"
+#include "MicoDrivers/MicoDriverWdg.h"
+#include "MicoDrivers/MicoDriverAdc.h"
+#include "MicoDrivers/MicoDriverRng.h"
+#include "MicoDrivers/MicoDriverFlash.h"
+#include "MicoDrivers/MicoDriverMFiAuth.h"
 
 #define mico_mcu_powersave_config MicoMcuPowerSaveConfig
 